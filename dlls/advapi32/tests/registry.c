@@ -1576,6 +1576,7 @@ static BOOL set_privileges(LPCSTR privilege, BOOL set)
 static void test_reg_save_key(void)
 {
     DWORD ret;
+    HKEY hkey;
 
     if (!set_privileges(SE_BACKUP_NAME, TRUE) ||
         !set_privileges(SE_RESTORE_NAME, FALSE))
@@ -1584,9 +1585,17 @@ static void test_reg_save_key(void)
         return;
     }
 
+    /* key names starting with a dash must survive the round trip */
+    ret = RegCreateKeyA(hkey_main, "-foo", &hkey);
+    ok(ret == ERROR_SUCCESS, "expected ERROR_SUCCESS, got %d\n", ret);
+    RegCloseKey(hkey);
+
     ret = RegSaveKeyA(hkey_main, "saved_key", NULL);
     ok(ret == ERROR_SUCCESS, "expected ERROR_SUCCESS, got %d\n", ret);
 
+    ret = RegDeleteKeyA(hkey_main, "-foo");
+    ok(ret == ERROR_SUCCESS, "expected ERROR_SUCCESS, got %d\n", ret);
+
     set_privileges(SE_BACKUP_NAME, FALSE);
 }
 
@@ -1611,6 +1620,11 @@ static void test_reg_load_key(void)
     ok(ret == ERROR_SUCCESS, "expected ERROR_SUCCESS, got %d\n", ret);
 
     RegCloseKey(hkHandle);
+
+    ret = RegOpenKeyA(HKEY_LOCAL_MACHINE, "Test\\-foo", &hkHandle);
+    ok(ret == ERROR_SUCCESS, "expected ERROR_SUCCESS, got %d\n", ret);
+
+    RegCloseKey(hkHandle);
 }
 
 static void test_reg_unload_key(void)
@@ -496,6 +496,14 @@ struct d3d_query *unsafe_impl_from_ID3D10Query(ID3D10Query *iface) DECLSPEC_HIDD
 struct d3d_query *unsafe_impl_from_ID3D11Asynchronous(ID3D11Asynchronous *iface) DECLSPEC_HIDDEN;
 
 /* ID3D11DeviceContext - immediate context */
+/* What a device context translates its calls into: the wined3d device for
+ * the immediate context, or a wined3d deferred context. */
+struct d3d11_context_target
+{
+    struct wined3d_device *device;
+    struct wined3d_deferred_context *deferred;
+};
+
 struct d3d11_immediate_context
 {
     ID3D11DeviceContext1 ID3D11DeviceContext1_iface;
@@ -503,8 +511,33 @@ struct d3d11_immediate_context
     LONG refcount;
 
     struct wined3d_private_store private_store;
+    struct d3d11_context_target target;
+};
+
+/* ID3D11DeviceContext - deferred context */
+struct d3d11_deferred_context
+{
+    ID3D11DeviceContext1 ID3D11DeviceContext1_iface;
+    LONG refcount;
+
+    struct wined3d_private_store private_store;
+    struct d3d11_context_target target;
+    struct d3d_device *device;
 };
 
+/* ID3D11CommandList */
+struct d3d11_command_list
+{
+    ID3D11CommandList ID3D11CommandList_iface;
+    LONG refcount;
+
+    struct wined3d_private_store private_store;
+    struct wined3d_command_list *wined3d_list;
+    ID3D11Device2 *device;
+};
+
+struct d3d11_command_list *unsafe_impl_from_ID3D11CommandList(ID3D11CommandList *iface) DECLSPEC_HIDDEN;
+
 /* ID3D11Device, ID3D10Device1 */
 struct d3d_device
 {
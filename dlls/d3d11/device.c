@@ -32,1770 +32,1809 @@ static const struct wined3d_parent_ops d3d_null_wined3d_parent_ops =
     d3d_null_wined3d_object_destroyed,
 };
 
-/* ID3D11DeviceContext - immediate context methods */
+/* ID3D11DeviceContext - translation shared by immediate and deferred contexts
+ *
+ * These take the wined3d object the context records into. For the immediate
+ * context that's the wined3d device, and callers need to hold the wined3d
+ * mutex. A deferred context is only ever used by a single thread, and all
+ * the state it touches is its own, so those don't need the mutex. */
 
-static inline struct d3d11_immediate_context *impl_from_ID3D11DeviceContext1(ID3D11DeviceContext1 *iface)
+static void d3d11_target_set_shader(const struct d3d11_context_target *target,
+        enum wined3d_shader_type type, struct wined3d_shader *shader)
 {
-    return CONTAINING_RECORD(iface, struct d3d11_immediate_context, ID3D11DeviceContext1_iface);
+    if (target->deferred)
+    {
+        wined3d_deferred_context_set_shader(target->deferred, type, shader);
+        return;
+    }
+
+    switch (type)
+    {
+        case WINED3D_SHADER_TYPE_VERTEX:
+            wined3d_device_set_vertex_shader(target->device, shader);
+            break;
+        case WINED3D_SHADER_TYPE_HULL:
+            wined3d_device_set_hull_shader(target->device, shader);
+            break;
+        case WINED3D_SHADER_TYPE_DOMAIN:
+            wined3d_device_set_domain_shader(target->device, shader);
+            break;
+        case WINED3D_SHADER_TYPE_GEOMETRY:
+            wined3d_device_set_geometry_shader(target->device, shader);
+            break;
+        case WINED3D_SHADER_TYPE_PIXEL:
+            wined3d_device_set_pixel_shader(target->device, shader);
+            break;
+        case WINED3D_SHADER_TYPE_COMPUTE:
+            wined3d_device_set_compute_shader(target->device, shader);
+            break;
+        default:
+            ERR("Invalid shader type %#x.\n", type);
+            break;
+    }
 }
 
-static inline struct d3d_device *device_from_immediate_ID3D11DeviceContext1(ID3D11DeviceContext1 *iface)
+static void d3d11_target_set_constant_buffer(const struct d3d11_context_target *target,
+        enum wined3d_shader_type type, unsigned int idx, struct wined3d_buffer *buffer)
 {
-    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
-    return CONTAINING_RECORD(context, struct d3d_device, immediate_context);
+    if (target->deferred)
+        wined3d_deferred_context_set_constant_buffer(target->deferred, type, idx, buffer);
+    else
+        wined3d_device_set_constant_buffer(target->device, type, idx, buffer);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_QueryInterface(ID3D11DeviceContext1 *iface,
-        REFIID iid, void **out)
+static void d3d11_target_set_shader_resource_view(const struct d3d11_context_target *target,
+        enum wined3d_shader_type type, unsigned int idx, struct wined3d_shader_resource_view *view)
 {
-    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
-
-    TRACE("iface %p, iid %s, out %p.\n", iface, debugstr_guid(iid), out);
-
-    if (IsEqualGUID(iid, &IID_ID3D11DeviceContext1)
-            || IsEqualGUID(iid, &IID_ID3D11DeviceContext)
-            || IsEqualGUID(iid, &IID_ID3D11DeviceChild)
-            || IsEqualGUID(iid, &IID_IUnknown))
+    if (target->deferred)
     {
-        *out = &context->ID3D11DeviceContext1_iface;
+        wined3d_deferred_context_set_shader_resource_view(target->deferred, type, idx, view);
+        return;
     }
-    else if (IsEqualGUID(iid, &IID_ID3D11Multithread))
-    {
-        *out = &context->ID3D11Multithread_iface;
+
+    switch (type)
+    {
+        case WINED3D_SHADER_TYPE_VERTEX:
+            wined3d_device_set_vs_resource_view(target->device, idx, view);
+            break;
+        case WINED3D_SHADER_TYPE_HULL:
+            wined3d_device_set_hs_resource_view(target->device, idx, view);
+            break;
+        case WINED3D_SHADER_TYPE_DOMAIN:
+            wined3d_device_set_ds_resource_view(target->device, idx, view);
+            break;
+        case WINED3D_SHADER_TYPE_GEOMETRY:
+            wined3d_device_set_gs_resource_view(target->device, idx, view);
+            break;
+        case WINED3D_SHADER_TYPE_PIXEL:
+            wined3d_device_set_ps_resource_view(target->device, idx, view);
+            break;
+        case WINED3D_SHADER_TYPE_COMPUTE:
+            wined3d_device_set_cs_resource_view(target->device, idx, view);
+            break;
+        default:
+            ERR("Invalid shader type %#x.\n", type);
+            break;
     }
-    else
+}
+
+static void d3d11_target_set_sampler(const struct d3d11_context_target *target,
+        enum wined3d_shader_type type, unsigned int idx, struct wined3d_sampler *sampler)
+{
+    if (target->deferred)
     {
-        WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(iid));
-        *out = NULL;
-        return E_NOINTERFACE;
+        wined3d_deferred_context_set_sampler(target->deferred, type, idx, sampler);
+        return;
     }
 
-    ID3D11DeviceContext1_AddRef(iface);
-    return S_OK;
+    switch (type)
+    {
+        case WINED3D_SHADER_TYPE_VERTEX:
+            wined3d_device_set_vs_sampler(target->device, idx, sampler);
+            break;
+        case WINED3D_SHADER_TYPE_HULL:
+            wined3d_device_set_hs_sampler(target->device, idx, sampler);
+            break;
+        case WINED3D_SHADER_TYPE_DOMAIN:
+            wined3d_device_set_ds_sampler(target->device, idx, sampler);
+            break;
+        case WINED3D_SHADER_TYPE_GEOMETRY:
+            wined3d_device_set_gs_sampler(target->device, idx, sampler);
+            break;
+        case WINED3D_SHADER_TYPE_PIXEL:
+            wined3d_device_set_ps_sampler(target->device, idx, sampler);
+            break;
+        case WINED3D_SHADER_TYPE_COMPUTE:
+            wined3d_device_set_cs_sampler(target->device, idx, sampler);
+            break;
+        default:
+            ERR("Invalid shader type %#x.\n", type);
+            break;
+    }
 }
 
-static ULONG STDMETHODCALLTYPE d3d11_immediate_context_AddRef(ID3D11DeviceContext1 *iface)
+static void d3d11_target_set_vertex_declaration(const struct d3d11_context_target *target,
+        struct wined3d_vertex_declaration *declaration)
 {
-    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    ULONG refcount = InterlockedIncrement(&context->refcount);
+    if (target->deferred)
+        wined3d_deferred_context_set_vertex_declaration(target->deferred, declaration);
+    else
+        wined3d_device_set_vertex_declaration(target->device, declaration);
+}
 
-    TRACE("%p increasing refcount to %u.\n", context, refcount);
+static void d3d11_target_set_stream_source(const struct d3d11_context_target *target,
+        unsigned int idx, struct wined3d_buffer *buffer, unsigned int offset, unsigned int stride)
+{
+    if (target->deferred)
+        wined3d_deferred_context_set_stream_source(target->deferred, idx, buffer, offset, stride);
+    else
+        wined3d_device_set_stream_source(target->device, idx, buffer, offset, stride);
+}
 
-    if (refcount == 1)
-    {
-        ID3D11Device2_AddRef(&device->ID3D11Device2_iface);
-    }
+static void d3d11_target_set_index_buffer(const struct d3d11_context_target *target,
+        struct wined3d_buffer *buffer, enum wined3d_format_id format_id, unsigned int offset)
+{
+    if (target->deferred)
+        wined3d_deferred_context_set_index_buffer(target->deferred, buffer, format_id, offset);
+    else
+        wined3d_device_set_index_buffer(target->device, buffer, format_id, offset);
+}
 
-    return refcount;
+static void d3d11_target_set_primitive_type(const struct d3d11_context_target *target,
+        enum wined3d_primitive_type primitive_type, unsigned int patch_vertex_count)
+{
+    if (target->deferred)
+        wined3d_deferred_context_set_primitive_type(target->deferred, primitive_type, patch_vertex_count);
+    else
+        wined3d_device_set_primitive_type(target->device, primitive_type, patch_vertex_count);
 }
 
-static ULONG STDMETHODCALLTYPE d3d11_immediate_context_Release(ID3D11DeviceContext1 *iface)
+static void d3d11_target_set_rendertarget_view(const struct d3d11_context_target *target,
+        unsigned int idx, struct wined3d_rendertarget_view *view)
 {
-    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    ULONG refcount = InterlockedDecrement(&context->refcount);
+    if (target->deferred)
+        wined3d_deferred_context_set_rendertarget_view(target->deferred, idx, view);
+    else
+        wined3d_device_set_rendertarget_view(target->device, idx, view, FALSE);
+}
 
-    TRACE("%p decreasing refcount to %u.\n", context, refcount);
+static void d3d11_target_set_depth_stencil_view(const struct d3d11_context_target *target,
+        struct wined3d_rendertarget_view *view)
+{
+    if (target->deferred)
+        wined3d_deferred_context_set_depth_stencil_view(target->deferred, view);
+    else
+        wined3d_device_set_depth_stencil_view(target->device, view);
+}
 
-    if (!refcount)
-    {
-        ID3D11Device2_Release(&device->ID3D11Device2_iface);
-    }
+static void d3d11_target_set_blend_state(const struct d3d11_context_target *target,
+        struct wined3d_blend_state *blend_state, const struct wined3d_color *blend_factor)
+{
+    if (target->deferred)
+        wined3d_deferred_context_set_blend_state(target->deferred, blend_state, blend_factor);
+    else
+        wined3d_device_set_blend_state(target->device, blend_state, blend_factor);
+}
 
-    return refcount;
+static void d3d11_target_set_rasterizer_state(const struct d3d11_context_target *target,
+        struct wined3d_rasterizer_state *rasterizer_state)
+{
+    if (target->deferred)
+        wined3d_deferred_context_set_rasterizer_state(target->deferred, rasterizer_state);
+    else
+        wined3d_device_set_rasterizer_state(target->device, rasterizer_state);
 }
 
-static void d3d11_immediate_context_get_constant_buffers(ID3D11DeviceContext1 *iface,
-        enum wined3d_shader_type type, UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+static void d3d11_target_set_render_state(const struct d3d11_context_target *target,
+        enum wined3d_render_state state, DWORD value)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    if (target->deferred)
+        wined3d_deferred_context_set_render_state(target->deferred, state, value);
+    else
+        wined3d_device_set_render_state(target->device, state, value);
+}
 
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
+static void d3d11_target_draw(const struct d3d11_context_target *target, int base_vertex_idx,
+        unsigned int start_idx, unsigned int index_count, unsigned int start_instance,
+        unsigned int instance_count, BOOL indexed)
+{
+    if (target->deferred)
     {
-        struct wined3d_buffer *wined3d_buffer;
-        struct d3d_buffer *buffer_impl;
+        wined3d_deferred_context_draw(target->deferred, base_vertex_idx, start_idx, index_count,
+                start_instance, instance_count, indexed);
+    }
+    else if (indexed)
+    {
+        wined3d_device_set_base_vertex_index(target->device, base_vertex_idx);
+        if (instance_count)
+            wined3d_device_draw_indexed_primitive_instanced(target->device, start_idx, index_count,
+                    start_instance, instance_count);
+        else
+            wined3d_device_draw_indexed_primitive(target->device, start_idx, index_count);
+    }
+    else
+    {
+        if (instance_count)
+            wined3d_device_draw_primitive_instanced(target->device, start_idx, index_count,
+                    start_instance, instance_count);
+        else
+            wined3d_device_draw_primitive(target->device, start_idx, index_count);
+    }
+}
 
-        if (!(wined3d_buffer = wined3d_device_get_constant_buffer(device->wined3d_device,
-                type, start_slot + i)))
-        {
-            buffers[i] = NULL;
-            continue;
-        }
+static void d3d11_target_dispatch(const struct d3d11_context_target *target,
+        unsigned int group_count_x, unsigned int group_count_y, unsigned int group_count_z)
+{
+    if (target->deferred)
+        wined3d_deferred_context_dispatch(target->deferred, group_count_x, group_count_y, group_count_z);
+    else
+        wined3d_device_dispatch_compute(target->device, group_count_x, group_count_y, group_count_z);
+}
 
-        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
-        buffers[i] = &buffer_impl->ID3D11Buffer_iface;
-        ID3D11Buffer_AddRef(buffers[i]);
-    }
-    wined3d_mutex_unlock();
+static HRESULT d3d11_target_clear_rendertarget_view(const struct d3d11_context_target *target,
+        struct wined3d_rendertarget_view *view, DWORD flags, const struct wined3d_color *color,
+        float depth, DWORD stencil)
+{
+    if (target->deferred)
+        return wined3d_deferred_context_clear_rendertarget_view(target->deferred, view, NULL,
+                flags, color, depth, stencil);
+    return wined3d_device_clear_rendertarget_view(target->device, view, NULL, flags, color, depth, stencil);
 }
 
-static void d3d11_immediate_context_set_constant_buffers(ID3D11DeviceContext1 *iface,
+static void d3d11_context_set_constant_buffers(const struct d3d11_context_target *target,
         enum wined3d_shader_type type, UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
     unsigned int i;
 
-    wined3d_mutex_lock();
     for (i = 0; i < buffer_count; ++i)
     {
         struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
 
-        wined3d_device_set_constant_buffer(device->wined3d_device, type, start_slot + i,
-                buffer ? buffer->wined3d_buffer : NULL);
+        d3d11_target_set_constant_buffer(target, type, start_slot + i, buffer ? buffer->wined3d_buffer : NULL);
     }
-    wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GetDevice(ID3D11DeviceContext1 *iface, ID3D11Device **device)
+static void d3d11_context_set_shader_resources(const struct d3d11_context_target *target,
+        enum wined3d_shader_type type, UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
 {
-    struct d3d_device *device_object = device_from_immediate_ID3D11DeviceContext1(iface);
+    unsigned int i;
 
-    TRACE("iface %p, device %p.\n", iface, device);
+    for (i = 0; i < view_count; ++i)
+    {
+        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
 
-    *device = (ID3D11Device *)&device_object->ID3D11Device2_iface;
-    ID3D11Device_AddRef(*device);
+        d3d11_target_set_shader_resource_view(target, type, start_slot + i, view ? view->wined3d_view : NULL);
+    }
 }
 
-static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_GetPrivateData(ID3D11DeviceContext1 *iface, REFGUID guid,
-        UINT *data_size, void *data)
+static void d3d11_context_set_samplers(const struct d3d11_context_target *target,
+        enum wined3d_shader_type type, UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
 {
-    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
+    unsigned int i;
 
-    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
 
-    return d3d_get_private_data(&context->private_store, guid, data_size, data);
+        d3d11_target_set_sampler(target, type, start_slot + i, sampler ? sampler->wined3d_sampler : NULL);
+    }
 }
 
-static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_SetPrivateData(ID3D11DeviceContext1 *iface, REFGUID guid,
-        UINT data_size, const void *data)
+static void d3d11_context_set_shader(const struct d3d11_context_target *target, enum wined3d_shader_type type,
+        struct wined3d_shader *shader, ID3D11ClassInstance *const *class_instances)
 {
-    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
-
-    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+    if (class_instances)
+        FIXME("Dynamic linking is not implemented yet.\n");
 
-    return d3d_set_private_data(&context->private_store, guid, data_size, data);
+    d3d11_target_set_shader(target, type, shader);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_SetPrivateDataInterface(ID3D11DeviceContext1 *iface,
-        REFGUID guid, const IUnknown *data)
+static void d3d11_context_set_vertex_buffers(const struct d3d11_context_target *target, UINT start_slot,
+        UINT buffer_count, ID3D11Buffer *const *buffers, const UINT *strides, const UINT *offsets)
 {
-    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
+    unsigned int i;
 
-    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
 
-    return d3d_set_private_data_interface(&context->private_store, guid, data);
+        d3d11_target_set_stream_source(target, start_slot + i,
+                buffer ? buffer->wined3d_buffer : NULL, offsets[i], strides[i]);
+    }
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetConstantBuffers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+static void d3d11_context_set_primitive_topology(const struct d3d11_context_target *target,
+        D3D11_PRIMITIVE_TOPOLOGY topology)
 {
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
+    enum wined3d_primitive_type primitive_type;
+    unsigned int patch_vertex_count;
 
-    d3d11_immediate_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_VERTEX, start_slot,
-            buffer_count, buffers);
+    wined3d_primitive_type_from_d3d11_primitive_topology(topology, &primitive_type, &patch_vertex_count);
+
+    d3d11_target_set_primitive_type(target, primitive_type, patch_vertex_count);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetShaderResources(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+static void d3d11_context_set_render_targets(const struct d3d11_context_target *target,
+        UINT render_target_view_count, ID3D11RenderTargetView *const *render_target_views,
+        ID3D11DepthStencilView *depth_stencil_view)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct d3d_depthstencil_view *dsv;
     unsigned int i;
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
-            iface, start_slot, view_count, views);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
+    for (i = 0; i < render_target_view_count; ++i)
     {
-        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
-
-        wined3d_device_set_ps_resource_view(device->wined3d_device, start_slot + i,
-                view ? view->wined3d_view : NULL);
+        struct d3d_rendertarget_view *rtv = unsafe_impl_from_ID3D11RenderTargetView(render_target_views[i]);
+        d3d11_target_set_rendertarget_view(target, i, rtv ? rtv->wined3d_view : NULL);
+    }
+    for (; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
+    {
+        d3d11_target_set_rendertarget_view(target, i, NULL);
     }
-    wined3d_mutex_unlock();
-}
-
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetShader(ID3D11DeviceContext1 *iface,
-        ID3D11PixelShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
-{
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_pixel_shader *ps = unsafe_impl_from_ID3D11PixelShader(shader);
-
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
-            iface, shader, class_instances, class_instance_count);
-
-    if (class_instances)
-        FIXME("Dynamic linking is not implemented yet.\n");
 
-    wined3d_mutex_lock();
-    wined3d_device_set_pixel_shader(device->wined3d_device, ps ? ps->wined3d_shader : NULL);
-    wined3d_mutex_unlock();
+    dsv = unsafe_impl_from_ID3D11DepthStencilView(depth_stencil_view);
+    d3d11_target_set_depth_stencil_view(target, dsv ? dsv->wined3d_view : NULL);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetSamplers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+static void d3d11_context_set_blend_state(const struct d3d11_context_target *target,
+        ID3D11BlendState *blend_state, const float blend_factor[4], UINT sample_mask)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    static const float default_blend_factor[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    struct d3d_blend_state *blend_state_impl;
+    const D3D11_BLEND_DESC *desc;
 
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
+    if (!blend_factor)
+        blend_factor = default_blend_factor;
 
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
+    d3d11_target_set_render_state(target, WINED3D_RS_MULTISAMPLEMASK, sample_mask);
+    if (!(blend_state_impl = unsafe_impl_from_ID3D11BlendState(blend_state)))
     {
-        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
+        d3d11_target_set_blend_state(target, NULL, (const struct wined3d_color *)blend_factor);
+        d3d11_target_set_render_state(target, WINED3D_RS_ALPHABLENDENABLE, FALSE);
+        d3d11_target_set_render_state(target, WINED3D_RS_COLORWRITEENABLE, D3D11_COLOR_WRITE_ENABLE_ALL);
+        d3d11_target_set_render_state(target, WINED3D_RS_COLORWRITEENABLE1, D3D11_COLOR_WRITE_ENABLE_ALL);
+        d3d11_target_set_render_state(target, WINED3D_RS_COLORWRITEENABLE2, D3D11_COLOR_WRITE_ENABLE_ALL);
+        d3d11_target_set_render_state(target, WINED3D_RS_COLORWRITEENABLE3, D3D11_COLOR_WRITE_ENABLE_ALL);
+        return;
+    }
 
-        wined3d_device_set_ps_sampler(device->wined3d_device, start_slot + i,
-                sampler ? sampler->wined3d_sampler : NULL);
+    d3d11_target_set_blend_state(target, blend_state_impl->wined3d_state,
+            (const struct wined3d_color *)blend_factor);
+    desc = &blend_state_impl->desc;
+    d3d11_target_set_render_state(target, WINED3D_RS_ALPHABLENDENABLE, desc->RenderTarget[0].BlendEnable);
+    if (desc->RenderTarget[0].BlendEnable)
+    {
+        const D3D11_RENDER_TARGET_BLEND_DESC *d = &desc->RenderTarget[0];
+
+        d3d11_target_set_render_state(target, WINED3D_RS_SRCBLEND, d->SrcBlend);
+        d3d11_target_set_render_state(target, WINED3D_RS_DESTBLEND, d->DestBlend);
+        d3d11_target_set_render_state(target, WINED3D_RS_BLENDOP, d->BlendOp);
+        d3d11_target_set_render_state(target, WINED3D_RS_SEPARATEALPHABLENDENABLE, TRUE);
+        d3d11_target_set_render_state(target, WINED3D_RS_SRCBLENDALPHA, d->SrcBlendAlpha);
+        d3d11_target_set_render_state(target, WINED3D_RS_DESTBLENDALPHA, d->DestBlendAlpha);
+        d3d11_target_set_render_state(target, WINED3D_RS_BLENDOPALPHA, d->BlendOpAlpha);
     }
-    wined3d_mutex_unlock();
+    d3d11_target_set_render_state(target, WINED3D_RS_COLORWRITEENABLE, desc->RenderTarget[0].RenderTargetWriteMask);
+    d3d11_target_set_render_state(target, WINED3D_RS_COLORWRITEENABLE1, desc->RenderTarget[1].RenderTargetWriteMask);
+    d3d11_target_set_render_state(target, WINED3D_RS_COLORWRITEENABLE2, desc->RenderTarget[2].RenderTargetWriteMask);
+    d3d11_target_set_render_state(target, WINED3D_RS_COLORWRITEENABLE3, desc->RenderTarget[3].RenderTargetWriteMask);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetShader(ID3D11DeviceContext1 *iface,
-        ID3D11VertexShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+static void d3d11_context_set_depth_stencil_state(const struct d3d11_context_target *target,
+        struct d3d_depthstencil_state *state, UINT stencil_ref)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_vertex_shader *vs = unsafe_impl_from_ID3D11VertexShader(shader);
+    const D3D11_DEPTH_STENCILOP_DESC *front, *back;
+    const D3D11_DEPTH_STENCIL_DESC *desc;
 
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
-            iface, shader, class_instances, class_instance_count);
+    if (!state)
+    {
+        d3d11_target_set_render_state(target, WINED3D_RS_ZENABLE, TRUE);
+        d3d11_target_set_render_state(target, WINED3D_RS_ZWRITEENABLE, D3D11_DEPTH_WRITE_MASK_ALL);
+        d3d11_target_set_render_state(target, WINED3D_RS_ZFUNC, WINED3D_CMP_LESS);
+        d3d11_target_set_render_state(target, WINED3D_RS_STENCILENABLE, FALSE);
+        return;
+    }
 
-    if (class_instances)
-        FIXME("Dynamic linking is not implemented yet.\n");
+    desc = &state->desc;
 
-    wined3d_mutex_lock();
-    wined3d_device_set_vertex_shader(device->wined3d_device, vs ? vs->wined3d_shader : NULL);
-    wined3d_mutex_unlock();
-}
+    front = &desc->FrontFace;
+    back = &desc->BackFace;
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DrawIndexed(ID3D11DeviceContext1 *iface,
-        UINT index_count, UINT start_index_location, INT base_vertex_location)
-{
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    d3d11_target_set_render_state(target, WINED3D_RS_ZENABLE, desc->DepthEnable);
+    if (desc->DepthEnable)
+    {
+        d3d11_target_set_render_state(target, WINED3D_RS_ZWRITEENABLE, desc->DepthWriteMask);
+        d3d11_target_set_render_state(target, WINED3D_RS_ZFUNC, desc->DepthFunc);
+    }
 
-    TRACE("iface %p, index_count %u, start_index_location %u, base_vertex_location %d.\n",
-            iface, index_count, start_index_location, base_vertex_location);
+    d3d11_target_set_render_state(target, WINED3D_RS_STENCILENABLE, desc->StencilEnable);
+    if (desc->StencilEnable)
+    {
+        d3d11_target_set_render_state(target, WINED3D_RS_STENCILMASK, desc->StencilReadMask);
+        d3d11_target_set_render_state(target, WINED3D_RS_STENCILWRITEMASK, desc->StencilWriteMask);
+        d3d11_target_set_render_state(target, WINED3D_RS_STENCILREF, stencil_ref);
 
-    wined3d_mutex_lock();
-    wined3d_device_set_base_vertex_index(device->wined3d_device, base_vertex_location);
-    wined3d_device_draw_indexed_primitive(device->wined3d_device, start_index_location, index_count);
-    wined3d_mutex_unlock();
+        d3d11_target_set_render_state(target, WINED3D_RS_STENCILFAIL, front->StencilFailOp);
+        d3d11_target_set_render_state(target, WINED3D_RS_STENCILZFAIL, front->StencilDepthFailOp);
+        d3d11_target_set_render_state(target, WINED3D_RS_STENCILPASS, front->StencilPassOp);
+        d3d11_target_set_render_state(target, WINED3D_RS_STENCILFUNC, front->StencilFunc);
+        if (front->StencilFailOp != back->StencilFailOp
+                || front->StencilDepthFailOp != back->StencilDepthFailOp
+                || front->StencilPassOp != back->StencilPassOp
+                || front->StencilFunc != back->StencilFunc)
+        {
+            d3d11_target_set_render_state(target, WINED3D_RS_TWOSIDEDSTENCILMODE, TRUE);
+            d3d11_target_set_render_state(target, WINED3D_RS_BACK_STENCILFAIL, back->StencilFailOp);
+            d3d11_target_set_render_state(target, WINED3D_RS_BACK_STENCILZFAIL, back->StencilDepthFailOp);
+            d3d11_target_set_render_state(target, WINED3D_RS_BACK_STENCILPASS, back->StencilPassOp);
+            d3d11_target_set_render_state(target, WINED3D_RS_BACK_STENCILFUNC, back->StencilFunc);
+        }
+        else
+        {
+            d3d11_target_set_render_state(target, WINED3D_RS_TWOSIDEDSTENCILMODE, FALSE);
+        }
+    }
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_Draw(ID3D11DeviceContext1 *iface,
-        UINT vertex_count, UINT start_vertex_location)
+static void d3d11_context_set_rasterizer_state(const struct d3d11_context_target *target,
+        ID3D11RasterizerState *rasterizer_state)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct d3d_rasterizer_state *rasterizer_state_impl;
+    const D3D11_RASTERIZER_DESC *desc;
+    union
+    {
+        DWORD d;
+        float f;
+    } scale_bias, const_bias;
 
-    TRACE("iface %p, vertex_count %u, start_vertex_location %u.\n",
-            iface, vertex_count, start_vertex_location);
+    if (!(rasterizer_state_impl = unsafe_impl_from_ID3D11RasterizerState(rasterizer_state)))
+    {
+        d3d11_target_set_rasterizer_state(target, NULL);
+        d3d11_target_set_render_state(target, WINED3D_RS_FILLMODE, WINED3D_FILL_SOLID);
+        d3d11_target_set_render_state(target, WINED3D_RS_CULLMODE, WINED3D_CULL_BACK);
+        d3d11_target_set_render_state(target, WINED3D_RS_SLOPESCALEDEPTHBIAS, 0);
+        d3d11_target_set_render_state(target, WINED3D_RS_DEPTHBIAS, 0);
+        d3d11_target_set_render_state(target, WINED3D_RS_SCISSORTESTENABLE, FALSE);
+        d3d11_target_set_render_state(target, WINED3D_RS_MULTISAMPLEANTIALIAS, FALSE);
+        d3d11_target_set_render_state(target, WINED3D_RS_ANTIALIASEDLINEENABLE, FALSE);
+        return;
+    }
 
-    wined3d_mutex_lock();
-    wined3d_device_draw_primitive(device->wined3d_device, start_vertex_location, vertex_count);
-    wined3d_mutex_unlock();
+    d3d11_target_set_rasterizer_state(target, rasterizer_state_impl->wined3d_state);
+
+    desc = &rasterizer_state_impl->desc;
+    d3d11_target_set_render_state(target, WINED3D_RS_FILLMODE, desc->FillMode);
+    d3d11_target_set_render_state(target, WINED3D_RS_CULLMODE, desc->CullMode);
+    scale_bias.f = desc->SlopeScaledDepthBias;
+    const_bias.f = desc->DepthBias;
+    d3d11_target_set_render_state(target, WINED3D_RS_SLOPESCALEDEPTHBIAS, scale_bias.d);
+    d3d11_target_set_render_state(target, WINED3D_RS_DEPTHBIAS, const_bias.d);
+    d3d11_target_set_render_state(target, WINED3D_RS_SCISSORTESTENABLE, desc->ScissorEnable);
+    d3d11_target_set_render_state(target, WINED3D_RS_MULTISAMPLEANTIALIAS, desc->MultisampleEnable);
+    d3d11_target_set_render_state(target, WINED3D_RS_ANTIALIASEDLINEENABLE, desc->AntialiasedLineEnable);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_Map(ID3D11DeviceContext1 *iface, ID3D11Resource *resource,
-        UINT subresource_idx, D3D11_MAP map_type, UINT map_flags, D3D11_MAPPED_SUBRESOURCE *mapped_subresource)
+static void d3d11_context_set_viewports(const struct d3d11_context_target *target,
+        UINT viewport_count, const D3D11_VIEWPORT *viewports)
 {
-    struct wined3d_resource *wined3d_resource;
-    struct wined3d_map_desc map_desc;
-    HRESULT hr;
-
-    TRACE("iface %p, resource %p, subresource_idx %u, map_type %u, map_flags %#x, mapped_subresource %p.\n",
-            iface, resource, subresource_idx, map_type, map_flags, mapped_subresource);
-
-    if (map_flags)
-        FIXME("Ignoring map_flags %#x.\n", map_flags);
-
-    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
+    struct wined3d_viewport wined3d_vp[WINED3D_MAX_VIEWPORTS];
+    unsigned int i;
 
-    wined3d_mutex_lock();
-    hr = wined3d_resource_map(wined3d_resource, subresource_idx,
-            &map_desc, NULL, wined3d_map_flags_from_d3d11_map_type(map_type));
-    wined3d_mutex_unlock();
+    if (viewport_count > ARRAY_SIZE(wined3d_vp))
+        return;
 
-    mapped_subresource->pData = map_desc.data;
-    mapped_subresource->RowPitch = map_desc.row_pitch;
-    mapped_subresource->DepthPitch = map_desc.slice_pitch;
+    for (i = 0; i < viewport_count; ++i)
+    {
+        wined3d_vp[i].x = viewports[i].TopLeftX;
+        wined3d_vp[i].y = viewports[i].TopLeftY;
+        wined3d_vp[i].width = viewports[i].Width;
+        wined3d_vp[i].height = viewports[i].Height;
+        wined3d_vp[i].min_z = viewports[i].MinDepth;
+        wined3d_vp[i].max_z = viewports[i].MaxDepth;
+    }
 
-    return hr;
+    if (target->deferred)
+        wined3d_deferred_context_set_viewports(target->deferred, viewport_count, wined3d_vp);
+    else
+        wined3d_device_set_viewports(target->device, viewport_count, wined3d_vp);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_Unmap(ID3D11DeviceContext1 *iface, ID3D11Resource *resource,
-        UINT subresource_idx)
+static void d3d11_context_set_scissor_rects(const struct d3d11_context_target *target,
+        UINT rect_count, const D3D11_RECT *rects)
 {
-    struct wined3d_resource *wined3d_resource;
-
-    TRACE("iface %p, resource %p, subresource_idx %u.\n", iface, resource, subresource_idx);
-
-    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
+    if (rect_count > WINED3D_MAX_VIEWPORTS)
+        return;
 
-    wined3d_mutex_lock();
-    wined3d_resource_unmap(wined3d_resource, subresource_idx);
-    wined3d_mutex_unlock();
+    if (target->deferred)
+        wined3d_deferred_context_set_scissor_rects(target->deferred, rect_count, rects);
+    else
+        wined3d_device_set_scissor_rects(target->device, rect_count, rects);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetConstantBuffers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+static void d3d11_context_issue_query(const struct d3d11_context_target *target,
+        ID3D11Asynchronous *asynchronous, DWORD flags)
 {
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
+    struct d3d_query *query = unsafe_impl_from_ID3D11Asynchronous(asynchronous);
+    HRESULT hr;
 
-    d3d11_immediate_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_PIXEL, start_slot,
-            buffer_count, buffers);
+    if (target->deferred)
+        wined3d_deferred_context_issue_query(target->deferred, query->wined3d_query, flags);
+    else if (FAILED(hr = wined3d_query_issue(query->wined3d_query, flags)))
+        ERR("Failed to issue query, hr %#x.\n", hr);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IASetInputLayout(ID3D11DeviceContext1 *iface,
-        ID3D11InputLayout *input_layout)
+static void d3d11_context_set_predication(const struct d3d11_context_target *target,
+        ID3D11Predicate *predicate, BOOL value)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_input_layout *layout = unsafe_impl_from_ID3D11InputLayout(input_layout);
-
-    TRACE("iface %p, input_layout %p.\n", iface, input_layout);
+    struct d3d_query *query = unsafe_impl_from_ID3D11Query((ID3D11Query *)predicate);
+    struct wined3d_query *wined3d_query = query ? query->wined3d_query : NULL;
 
-    wined3d_mutex_lock();
-    wined3d_device_set_vertex_declaration(device->wined3d_device, layout ? layout->wined3d_decl : NULL);
-    wined3d_mutex_unlock();
+    if (target->deferred)
+        wined3d_deferred_context_set_predication(target->deferred, wined3d_query, value);
+    else
+        wined3d_device_set_predication(target->device, wined3d_query, value);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IASetVertexBuffers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers, const UINT *strides, const UINT *offsets)
+static void d3d11_context_set_stream_output_targets(const struct d3d11_context_target *target,
+        UINT buffer_count, ID3D11Buffer *const *buffers, const UINT *offsets)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p.\n",
-            iface, start_slot, buffer_count, buffers, strides, offsets);
+    struct wined3d_buffer *wined3d_buffer;
+    unsigned int count, offset, i;
 
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
+    count = min(buffer_count, D3D11_SO_BUFFER_SLOT_COUNT);
+    for (i = 0; i < D3D11_SO_BUFFER_SLOT_COUNT; ++i)
     {
-        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+        struct d3d_buffer *buffer = i < count ? unsafe_impl_from_ID3D11Buffer(buffers[i]) : NULL;
 
-        wined3d_device_set_stream_source(device->wined3d_device, start_slot + i,
-                buffer ? buffer->wined3d_buffer : NULL, offsets[i], strides[i]);
+        wined3d_buffer = buffer ? buffer->wined3d_buffer : NULL;
+        offset = i < count && offsets ? offsets[i] : 0;
+        if (target->deferred)
+            wined3d_deferred_context_set_stream_output(target->deferred, i, wined3d_buffer, offset);
+        else
+            wined3d_device_set_stream_output(target->device, i, wined3d_buffer, offset);
     }
-    wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IASetIndexBuffer(ID3D11DeviceContext1 *iface,
-        ID3D11Buffer *buffer, DXGI_FORMAT format, UINT offset)
+static void d3d11_context_draw_indirect(const struct d3d11_context_target *target,
+        ID3D11Buffer *buffer, UINT offset, BOOL indexed)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
     struct d3d_buffer *buffer_impl = unsafe_impl_from_ID3D11Buffer(buffer);
 
-    TRACE("iface %p, buffer %p, format %s, offset %u.\n",
-            iface, buffer, debug_dxgi_format(format), offset);
-
-    wined3d_mutex_lock();
-    wined3d_device_set_index_buffer(device->wined3d_device,
-            buffer_impl ? buffer_impl->wined3d_buffer : NULL,
-            wined3dformat_from_dxgi_format(format), offset);
-    wined3d_mutex_unlock();
+    if (target->deferred)
+        wined3d_deferred_context_draw_indirect(target->deferred, buffer_impl->wined3d_buffer, offset, indexed);
+    else if (indexed)
+        wined3d_device_draw_indexed_primitive_instanced_indirect(target->device,
+                buffer_impl->wined3d_buffer, offset);
+    else
+        wined3d_device_draw_primitive_instanced_indirect(target->device, buffer_impl->wined3d_buffer, offset);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DrawIndexedInstanced(ID3D11DeviceContext1 *iface,
-        UINT instance_index_count, UINT instance_count, UINT start_index_location, INT base_vertex_location,
-        UINT start_instance_location)
+static void d3d11_context_dispatch_indirect(const struct d3d11_context_target *target,
+        ID3D11Buffer *buffer, UINT offset)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-
-    TRACE("iface %p, instance_index_count %u, instance_count %u, start_index_location %u, "
-            "base_vertex_location %d, start_instance_location %u.\n",
-            iface, instance_index_count, instance_count, start_index_location,
-            base_vertex_location, start_instance_location);
+    struct d3d_buffer *buffer_impl = unsafe_impl_from_ID3D11Buffer(buffer);
 
-    wined3d_mutex_lock();
-    wined3d_device_set_base_vertex_index(device->wined3d_device, base_vertex_location);
-    wined3d_device_draw_indexed_primitive_instanced(device->wined3d_device, start_index_location,
-            instance_index_count, start_instance_location, instance_count);
-    wined3d_mutex_unlock();
+    if (target->deferred)
+        wined3d_deferred_context_dispatch_indirect(target->deferred, buffer_impl->wined3d_buffer, offset);
+    else
+        wined3d_device_dispatch_compute_indirect(target->device, buffer_impl->wined3d_buffer, offset);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DrawInstanced(ID3D11DeviceContext1 *iface,
-        UINT instance_vertex_count, UINT instance_count, UINT start_vertex_location, UINT start_instance_location)
+static void d3d11_context_copy_subresource_region(const struct d3d11_context_target *target,
+        ID3D11Resource *dst_resource, UINT dst_subresource_idx, UINT dst_x, UINT dst_y, UINT dst_z,
+        ID3D11Resource *src_resource, UINT src_subresource_idx, const D3D11_BOX *src_box, UINT flags)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct wined3d_resource *wined3d_dst_resource, *wined3d_src_resource;
+    struct wined3d_box wined3d_src_box;
 
-    TRACE("iface %p, instance_vertex_count %u, instance_count %u, start_vertex_location %u, "
-            "start_instance_location %u.\n",
-            iface, instance_vertex_count, instance_count, start_vertex_location,
-            start_instance_location);
+    if (src_box)
+        wined3d_box_set(&wined3d_src_box, src_box->left, src_box->top,
+                src_box->right, src_box->bottom, src_box->front, src_box->back);
 
-    wined3d_mutex_lock();
-    wined3d_device_draw_primitive_instanced(device->wined3d_device, start_vertex_location,
-            instance_vertex_count, start_instance_location, instance_count);
-    wined3d_mutex_unlock();
+    wined3d_dst_resource = wined3d_resource_from_d3d11_resource(dst_resource);
+    wined3d_src_resource = wined3d_resource_from_d3d11_resource(src_resource);
+    if (target->deferred)
+        wined3d_deferred_context_copy_sub_resource_region(target->deferred, wined3d_dst_resource,
+                dst_subresource_idx, dst_x, dst_y, dst_z, wined3d_src_resource, src_subresource_idx,
+                src_box ? &wined3d_src_box : NULL, flags);
+    else
+        wined3d_device_copy_sub_resource_region(target->device, wined3d_dst_resource,
+                dst_subresource_idx, dst_x, dst_y, dst_z, wined3d_src_resource, src_subresource_idx,
+                src_box ? &wined3d_src_box : NULL, flags);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetConstantBuffers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+static void d3d11_context_copy_resource(const struct d3d11_context_target *target,
+        ID3D11Resource *dst_resource, ID3D11Resource *src_resource)
 {
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
+    struct wined3d_resource *wined3d_dst_resource, *wined3d_src_resource;
 
-    d3d11_immediate_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_GEOMETRY, start_slot,
-            buffer_count, buffers);
+    wined3d_dst_resource = wined3d_resource_from_d3d11_resource(dst_resource);
+    wined3d_src_resource = wined3d_resource_from_d3d11_resource(src_resource);
+    if (target->deferred)
+        wined3d_deferred_context_copy_resource(target->deferred, wined3d_dst_resource, wined3d_src_resource);
+    else
+        wined3d_device_copy_resource(target->device, wined3d_dst_resource, wined3d_src_resource);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetShader(ID3D11DeviceContext1 *iface,
-        ID3D11GeometryShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+static void d3d11_context_copy_structure_count(const struct d3d11_context_target *target,
+        ID3D11Buffer *dst_buffer, UINT dst_offset, ID3D11UnorderedAccessView *src_view)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_geometry_shader *gs = unsafe_impl_from_ID3D11GeometryShader(shader);
-
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
-            iface, shader, class_instances, class_instance_count);
-
-    if (class_instances)
-        FIXME("Dynamic linking is not implemented yet.\n");
+    struct d3d11_unordered_access_view *uav = unsafe_impl_from_ID3D11UnorderedAccessView(src_view);
+    struct d3d_buffer *buffer_impl = unsafe_impl_from_ID3D11Buffer(dst_buffer);
 
-    wined3d_mutex_lock();
-    wined3d_device_set_geometry_shader(device->wined3d_device, gs ? gs->wined3d_shader : NULL);
-    wined3d_mutex_unlock();
+    if (target->deferred)
+        wined3d_deferred_context_copy_uav_counter(target->deferred,
+                buffer_impl->wined3d_buffer, dst_offset, uav->wined3d_view);
+    else
+        wined3d_device_copy_uav_counter(target->device,
+                buffer_impl->wined3d_buffer, dst_offset, uav->wined3d_view);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IASetPrimitiveTopology(ID3D11DeviceContext1 *iface,
-        D3D11_PRIMITIVE_TOPOLOGY topology)
+static void d3d11_context_clear_unordered_access_view_uint(const struct d3d11_context_target *target,
+        ID3D11UnorderedAccessView *unordered_access_view, const UINT values[4])
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    enum wined3d_primitive_type primitive_type;
-    unsigned int patch_vertex_count;
+    struct d3d11_unordered_access_view *view = unsafe_impl_from_ID3D11UnorderedAccessView(unordered_access_view);
 
-    TRACE("iface %p, topology %#x.\n", iface, topology);
+    if (target->deferred)
+        wined3d_deferred_context_clear_unordered_access_view_uint(target->deferred,
+                view->wined3d_view, (const struct wined3d_uvec4 *)values);
+    else
+        wined3d_device_clear_unordered_access_view_uint(target->device,
+                view->wined3d_view, (const struct wined3d_uvec4 *)values);
+}
 
-    wined3d_primitive_type_from_d3d11_primitive_topology(topology, &primitive_type, &patch_vertex_count);
+static void d3d11_context_generate_mips(const struct d3d11_context_target *target,
+        ID3D11ShaderResourceView *view)
+{
+    struct d3d_shader_resource_view *srv = unsafe_impl_from_ID3D11ShaderResourceView(view);
 
-    wined3d_mutex_lock();
-    wined3d_device_set_primitive_type(device->wined3d_device, primitive_type, patch_vertex_count);
-    wined3d_mutex_unlock();
+    if (target->deferred)
+        wined3d_deferred_context_generate_mipmaps(target->deferred, srv->wined3d_view);
+    else
+        wined3d_shader_resource_view_generate_mipmaps(srv->wined3d_view);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetShaderResources(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+static void d3d11_context_update_subresource(const struct d3d11_context_target *target,
+        ID3D11Resource *resource, UINT subresource_idx, const D3D11_BOX *box,
+        const void *data, UINT row_pitch, UINT depth_pitch, UINT flags)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    struct wined3d_resource *wined3d_resource;
+    struct wined3d_box wined3d_box;
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+    if (box)
+        wined3d_box_set(&wined3d_box, box->left, box->top, box->right, box->bottom, box->front, box->back);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
+    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
+    if (target->deferred)
     {
-        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
-
-        wined3d_device_set_vs_resource_view(device->wined3d_device, start_slot + i,
-                view ? view->wined3d_view : NULL);
+        if (flags)
+            FIXME("Ignoring flags %#x.\n", flags);
+        wined3d_deferred_context_update_sub_resource(target->deferred, wined3d_resource,
+                subresource_idx, box ? &wined3d_box : NULL, data, row_pitch, depth_pitch);
+    }
+    else
+    {
+        wined3d_device_update_sub_resource(target->device, wined3d_resource,
+                subresource_idx, box ? &wined3d_box : NULL, data, row_pitch, depth_pitch, flags);
     }
-    wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetSamplers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+static void d3d11_context_clear_render_target_view(const struct d3d11_context_target *target,
+        ID3D11RenderTargetView *render_target_view, const float color_rgba[4])
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
-
-        wined3d_device_set_vs_sampler(device->wined3d_device, start_slot + i,
-                sampler ? sampler->wined3d_sampler : NULL);
-    }
-    wined3d_mutex_unlock();
-}
-
-static void STDMETHODCALLTYPE d3d11_immediate_context_Begin(ID3D11DeviceContext1 *iface,
-        ID3D11Asynchronous *asynchronous)
-{
-    struct d3d_query *query = unsafe_impl_from_ID3D11Asynchronous(asynchronous);
+    struct d3d_rendertarget_view *view = unsafe_impl_from_ID3D11RenderTargetView(render_target_view);
+    const struct wined3d_color color = {color_rgba[0], color_rgba[1], color_rgba[2], color_rgba[3]};
     HRESULT hr;
 
-    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+    if (!view)
+        return;
 
-    wined3d_mutex_lock();
-    if (FAILED(hr = wined3d_query_issue(query->wined3d_query, WINED3DISSUE_BEGIN)))
-        ERR("Failed to issue query, hr %#x.\n", hr);
-    wined3d_mutex_unlock();
+    if (FAILED(hr = d3d11_target_clear_rendertarget_view(target, view->wined3d_view,
+            WINED3DCLEAR_TARGET, &color, 0.0f, 0)))
+        ERR("Failed to clear view, hr %#x.\n", hr);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_End(ID3D11DeviceContext1 *iface,
-        ID3D11Asynchronous *asynchronous)
+static void d3d11_context_clear_depth_stencil_view(const struct d3d11_context_target *target,
+        ID3D11DepthStencilView *depth_stencil_view, UINT flags, FLOAT depth, UINT8 stencil)
 {
-    struct d3d_query *query = unsafe_impl_from_ID3D11Asynchronous(asynchronous);
+    struct d3d_depthstencil_view *view = unsafe_impl_from_ID3D11DepthStencilView(depth_stencil_view);
+    DWORD wined3d_flags;
     HRESULT hr;
 
-    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+    if (!view)
+        return;
 
-    wined3d_mutex_lock();
-    if (FAILED(hr = wined3d_query_issue(query->wined3d_query, WINED3DISSUE_END)))
-        ERR("Failed to issue query, hr %#x.\n", hr);
-    wined3d_mutex_unlock();
+    wined3d_flags = wined3d_clear_flags_from_d3d11_clear_flags(flags);
+
+    if (FAILED(hr = d3d11_target_clear_rendertarget_view(target, view->wined3d_view,
+            wined3d_flags, NULL, depth, stencil)))
+        ERR("Failed to clear view, hr %#x.\n", hr);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_GetData(ID3D11DeviceContext1 *iface,
-        ID3D11Asynchronous *asynchronous, void *data, UINT data_size, UINT data_flags)
+/* Reset the state both kinds of contexts track. */
+static void d3d11_context_clear_state(const struct d3d11_context_target *target)
 {
-    struct d3d_query *query = unsafe_impl_from_ID3D11Asynchronous(asynchronous);
-    unsigned int wined3d_flags;
-    HRESULT hr;
-
-    TRACE("iface %p, asynchronous %p, data %p, data_size %u, data_flags %#x.\n",
-            iface, asynchronous, data, data_size, data_flags);
-
-    if (!data && data_size)
-        return E_INVALIDARG;
-
-    wined3d_flags = wined3d_getdata_flags_from_d3d11_async_getdata_flags(data_flags);
+    static const float blend_factor[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    unsigned int i, j;
 
-    wined3d_mutex_lock();
-    if (!data_size || wined3d_query_get_data_size(query->wined3d_query) == data_size)
+    for (i = 0; i < WINED3D_SHADER_TYPE_COUNT; ++i)
     {
-        hr = wined3d_query_get_data(query->wined3d_query, data, data_size, wined3d_flags);
-        if (hr == WINED3DERR_INVALIDCALL)
-            hr = DXGI_ERROR_INVALID_CALL;
+        d3d11_target_set_shader(target, i, NULL);
+        for (j = 0; j < D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT; ++j)
+            d3d11_target_set_sampler(target, i, j, NULL);
+        for (j = 0; j < D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT; ++j)
+            d3d11_target_set_shader_resource_view(target, i, j, NULL);
+        for (j = 0; j < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; ++j)
+            d3d11_target_set_constant_buffer(target, i, j, NULL);
     }
-    else
+    for (i = 0; i < D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; ++i)
     {
-        WARN("Invalid data size %u.\n", data_size);
-        hr = E_INVALIDARG;
+        d3d11_target_set_stream_source(target, i, NULL, 0, 0);
     }
-    wined3d_mutex_unlock();
-
-    return hr;
+    d3d11_target_set_index_buffer(target, NULL, WINED3DFMT_UNKNOWN, 0);
+    d3d11_target_set_vertex_declaration(target, NULL);
+    d3d11_target_set_primitive_type(target, WINED3D_PT_UNDEFINED, 0);
+    d3d11_context_set_render_targets(target, 0, NULL, NULL);
+    d3d11_context_set_depth_stencil_state(target, NULL, 0);
+    d3d11_context_set_blend_state(target, NULL, blend_factor, D3D11_DEFAULT_SAMPLE_MASK);
+    d3d11_context_set_viewports(target, 0, NULL);
+    d3d11_context_set_scissor_rects(target, 0, NULL);
+    d3d11_context_set_rasterizer_state(target, NULL);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_SetPredication(ID3D11DeviceContext1 *iface,
-        ID3D11Predicate *predicate, BOOL value)
-{
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_query *query;
-
-    TRACE("iface %p, predicate %p, value %#x.\n", iface, predicate, value);
+/* ID3D11DeviceContext - immediate context methods */
 
-    query = unsafe_impl_from_ID3D11Query((ID3D11Query *)predicate);
+static inline struct d3d11_immediate_context *impl_from_ID3D11DeviceContext1(ID3D11DeviceContext1 *iface)
+{
+    return CONTAINING_RECORD(iface, struct d3d11_immediate_context, ID3D11DeviceContext1_iface);
+}
 
-    wined3d_mutex_lock();
-    wined3d_device_set_predication(device->wined3d_device, query ? query->wined3d_query : NULL, value);
-    wined3d_mutex_unlock();
+static inline struct d3d_device *device_from_immediate_ID3D11DeviceContext1(ID3D11DeviceContext1 *iface)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
+    return CONTAINING_RECORD(context, struct d3d_device, immediate_context);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetShaderResources(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_QueryInterface(ID3D11DeviceContext1 *iface,
+        REFIID iid, void **out)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+    TRACE("iface %p, iid %s, out %p.\n", iface, debugstr_guid(iid), out);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
+    if (IsEqualGUID(iid, &IID_ID3D11DeviceContext1)
+            || IsEqualGUID(iid, &IID_ID3D11DeviceContext)
+            || IsEqualGUID(iid, &IID_ID3D11DeviceChild)
+            || IsEqualGUID(iid, &IID_IUnknown))
     {
-        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
-
-        wined3d_device_set_gs_resource_view(device->wined3d_device, start_slot + i,
-                view ? view->wined3d_view : NULL);
+        *out = &context->ID3D11DeviceContext1_iface;
     }
-    wined3d_mutex_unlock();
+    else if (IsEqualGUID(iid, &IID_ID3D11Multithread))
+    {
+        *out = &context->ID3D11Multithread_iface;
+    }
+    else
+    {
+        WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(iid));
+        *out = NULL;
+        return E_NOINTERFACE;
+    }
+
+    ID3D11DeviceContext1_AddRef(iface);
+    return S_OK;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetSamplers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+static ULONG STDMETHODCALLTYPE d3d11_immediate_context_AddRef(ID3D11DeviceContext1 *iface)
 {
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    ULONG refcount = InterlockedIncrement(&context->refcount);
 
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
+    TRACE("%p increasing refcount to %u.\n", context, refcount);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
+    if (refcount == 1)
     {
-        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
-
-        wined3d_device_set_gs_sampler(device->wined3d_device, start_slot + i,
-                sampler ? sampler->wined3d_sampler : NULL);
+        ID3D11Device2_AddRef(&device->ID3D11Device2_iface);
     }
-    wined3d_mutex_unlock();
+
+    return refcount;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetRenderTargets(ID3D11DeviceContext1 *iface,
-        UINT render_target_view_count, ID3D11RenderTargetView *const *render_target_views,
-        ID3D11DepthStencilView *depth_stencil_view)
+static ULONG STDMETHODCALLTYPE d3d11_immediate_context_Release(ID3D11DeviceContext1 *iface)
 {
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_depthstencil_view *dsv;
-    unsigned int i;
+    ULONG refcount = InterlockedDecrement(&context->refcount);
 
-    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p.\n",
-            iface, render_target_view_count, render_target_views, depth_stencil_view);
+    TRACE("%p decreasing refcount to %u.\n", context, refcount);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < render_target_view_count; ++i)
-    {
-        struct d3d_rendertarget_view *rtv = unsafe_impl_from_ID3D11RenderTargetView(render_target_views[i]);
-        wined3d_device_set_rendertarget_view(device->wined3d_device, i, rtv ? rtv->wined3d_view : NULL, FALSE);
-    }
-    for (; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
+    if (!refcount)
     {
-        wined3d_device_set_rendertarget_view(device->wined3d_device, i, NULL, FALSE);
+        ID3D11Device2_Release(&device->ID3D11Device2_iface);
     }
 
-    dsv = unsafe_impl_from_ID3D11DepthStencilView(depth_stencil_view);
-    wined3d_device_set_depth_stencil_view(device->wined3d_device, dsv ? dsv->wined3d_view : NULL);
-    wined3d_mutex_unlock();
+    return refcount;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetRenderTargetsAndUnorderedAccessViews(
-        ID3D11DeviceContext1 *iface, UINT render_target_view_count,
-        ID3D11RenderTargetView *const *render_target_views, ID3D11DepthStencilView *depth_stencil_view,
-        UINT unordered_access_view_start_slot, UINT unordered_access_view_count,
-        ID3D11UnorderedAccessView *const *unordered_access_views, const UINT *initial_counts)
+static void d3d11_immediate_context_get_constant_buffers(ID3D11DeviceContext1 *iface,
+        enum wined3d_shader_type type, UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
     unsigned int i;
 
-    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
-            "unordered_access_view_start_slot %u, unordered_access_view_count %u, unordered_access_views %p, "
-            "initial_counts %p.\n",
-            iface, render_target_view_count, render_target_views, depth_stencil_view,
-            unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views,
-            initial_counts);
-
-    if (render_target_view_count != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL)
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
     {
-        d3d11_immediate_context_OMSetRenderTargets(iface, render_target_view_count, render_target_views,
-                depth_stencil_view);
-    }
+        struct wined3d_buffer *wined3d_buffer;
+        struct d3d_buffer *buffer_impl;
 
-    if (unordered_access_view_count != D3D11_KEEP_UNORDERED_ACCESS_VIEWS)
-    {
-        wined3d_mutex_lock();
-        for (i = 0; i < unordered_access_view_start_slot; ++i)
+        if (!(wined3d_buffer = wined3d_device_get_constant_buffer(device->wined3d_device,
+                type, start_slot + i)))
         {
-            wined3d_device_set_unordered_access_view(device->wined3d_device, i, NULL, ~0u);
+            buffers[i] = NULL;
+            continue;
         }
-        for (i = 0; i < unordered_access_view_count; ++i)
-        {
-            struct d3d11_unordered_access_view *view
-                    = unsafe_impl_from_ID3D11UnorderedAccessView(unordered_access_views[i]);
 
-            wined3d_device_set_unordered_access_view(device->wined3d_device,
-                    unordered_access_view_start_slot + i,
-                    view ? view->wined3d_view : NULL, initial_counts ? initial_counts[i] : ~0u);
-        }
-        for (; unordered_access_view_start_slot + i < D3D11_PS_CS_UAV_REGISTER_COUNT; ++i)
-        {
-            wined3d_device_set_unordered_access_view(device->wined3d_device,
-                    unordered_access_view_start_slot + i, NULL, ~0u);
-        }
-        wined3d_mutex_unlock();
+        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
+        buffers[i] = &buffer_impl->ID3D11Buffer_iface;
+        ID3D11Buffer_AddRef(buffers[i]);
     }
+    wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetBlendState(ID3D11DeviceContext1 *iface,
-        ID3D11BlendState *blend_state, const float blend_factor[4], UINT sample_mask)
+static void d3d11_immediate_context_set_constant_buffers(ID3D11DeviceContext1 *iface,
+        enum wined3d_shader_type type, UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    static const float default_blend_factor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-    struct d3d_blend_state *blend_state_impl;
-    const D3D11_BLEND_DESC *desc;
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    TRACE("iface %p, blend_state %p, blend_factor %s, sample_mask 0x%08x.\n",
-            iface, blend_state, debug_float4(blend_factor), sample_mask);
+    wined3d_mutex_lock();
+    d3d11_context_set_constant_buffers(&context->target, type, start_slot, buffer_count, buffers);
+    wined3d_mutex_unlock();
+}
 
-    if (!blend_factor)
-        blend_factor = default_blend_factor;
+static void d3d11_immediate_context_set_shader_resources(ID3D11DeviceContext1 *iface,
+        enum wined3d_shader_type type, UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
     wined3d_mutex_lock();
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_MULTISAMPLEMASK, sample_mask);
-    if (!(blend_state_impl = unsafe_impl_from_ID3D11BlendState(blend_state)))
-    {
-        wined3d_device_set_blend_state(device->wined3d_device, NULL,
-                (const struct wined3d_color *)blend_factor);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ALPHABLENDENABLE, FALSE);
-        wined3d_device_set_render_state(device->wined3d_device,
-                WINED3D_RS_COLORWRITEENABLE, D3D11_COLOR_WRITE_ENABLE_ALL);
-        wined3d_device_set_render_state(device->wined3d_device,
-                WINED3D_RS_COLORWRITEENABLE1, D3D11_COLOR_WRITE_ENABLE_ALL);
-        wined3d_device_set_render_state(device->wined3d_device,
-                WINED3D_RS_COLORWRITEENABLE2, D3D11_COLOR_WRITE_ENABLE_ALL);
-        wined3d_device_set_render_state(device->wined3d_device,
-                WINED3D_RS_COLORWRITEENABLE3, D3D11_COLOR_WRITE_ENABLE_ALL);
-        wined3d_mutex_unlock();
-        return;
-    }
+    d3d11_context_set_shader_resources(&context->target, type, start_slot, view_count, views);
+    wined3d_mutex_unlock();
+}
 
-    wined3d_device_set_blend_state(device->wined3d_device, blend_state_impl->wined3d_state,
-            (const struct wined3d_color *)blend_factor);
-    desc = &blend_state_impl->desc;
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ALPHABLENDENABLE,
-            desc->RenderTarget[0].BlendEnable);
-    if (desc->RenderTarget[0].BlendEnable)
-    {
-        const D3D11_RENDER_TARGET_BLEND_DESC *d = &desc->RenderTarget[0];
+static void d3d11_immediate_context_set_samplers(ID3D11DeviceContext1 *iface,
+        enum wined3d_shader_type type, UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SRCBLEND, d->SrcBlend);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_DESTBLEND, d->DestBlend);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BLENDOP, d->BlendOp);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SEPARATEALPHABLENDENABLE, TRUE);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SRCBLENDALPHA, d->SrcBlendAlpha);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_DESTBLENDALPHA, d->DestBlendAlpha);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BLENDOPALPHA, d->BlendOpAlpha);
-    }
-    wined3d_device_set_render_state(device->wined3d_device,
-            WINED3D_RS_COLORWRITEENABLE, desc->RenderTarget[0].RenderTargetWriteMask);
-    wined3d_device_set_render_state(device->wined3d_device,
-            WINED3D_RS_COLORWRITEENABLE1, desc->RenderTarget[1].RenderTargetWriteMask);
-    wined3d_device_set_render_state(device->wined3d_device,
-            WINED3D_RS_COLORWRITEENABLE2, desc->RenderTarget[2].RenderTargetWriteMask);
-    wined3d_device_set_render_state(device->wined3d_device,
-            WINED3D_RS_COLORWRITEENABLE3, desc->RenderTarget[3].RenderTargetWriteMask);
+    wined3d_mutex_lock();
+    d3d11_context_set_samplers(&context->target, type, start_slot, sampler_count, samplers);
     wined3d_mutex_unlock();
 }
 
-static void set_default_depth_stencil_state(struct wined3d_device *wined3d_device)
+static void d3d11_immediate_context_set_shader(ID3D11DeviceContext1 *iface, enum wined3d_shader_type type,
+        struct wined3d_shader *shader, ID3D11ClassInstance *const *class_instances)
 {
-    wined3d_device_set_render_state(wined3d_device, WINED3D_RS_ZENABLE, TRUE);
-    wined3d_device_set_render_state(wined3d_device, WINED3D_RS_ZWRITEENABLE, D3D11_DEPTH_WRITE_MASK_ALL);
-    wined3d_device_set_render_state(wined3d_device, WINED3D_RS_ZFUNC, WINED3D_CMP_LESS);
-    wined3d_device_set_render_state(wined3d_device, WINED3D_RS_STENCILENABLE, FALSE);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    wined3d_mutex_lock();
+    d3d11_context_set_shader(&context->target, type, shader, class_instances);
+    wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetDepthStencilState(ID3D11DeviceContext1 *iface,
-        ID3D11DepthStencilState *depth_stencil_state, UINT stencil_ref)
+static void STDMETHODCALLTYPE d3d11_immediate_context_GetDevice(ID3D11DeviceContext1 *iface, ID3D11Device **device)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    const D3D11_DEPTH_STENCILOP_DESC *front, *back;
-    const D3D11_DEPTH_STENCIL_DESC *desc;
-
-    TRACE("iface %p, depth_stencil_state %p, stencil_ref %u.\n",
-            iface, depth_stencil_state, stencil_ref);
-
-    wined3d_mutex_lock();
-    device->stencil_ref = stencil_ref;
-    if (!(device->depth_stencil_state = unsafe_impl_from_ID3D11DepthStencilState(depth_stencil_state)))
-    {
-        set_default_depth_stencil_state(device->wined3d_device);
-        wined3d_mutex_unlock();
-        return;
-    }
+    struct d3d_device *device_object = device_from_immediate_ID3D11DeviceContext1(iface);
 
-    desc = &device->depth_stencil_state->desc;
+    TRACE("iface %p, device %p.\n", iface, device);
 
-    front = &desc->FrontFace;
-    back = &desc->BackFace;
+    *device = (ID3D11Device *)&device_object->ID3D11Device2_iface;
+    ID3D11Device_AddRef(*device);
+}
 
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ZENABLE, desc->DepthEnable);
-    if (desc->DepthEnable)
-    {
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ZWRITEENABLE, desc->DepthWriteMask);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ZFUNC, desc->DepthFunc);
-    }
+static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_GetPrivateData(ID3D11DeviceContext1 *iface, REFGUID guid,
+        UINT *data_size, void *data)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILENABLE, desc->StencilEnable);
-    if (desc->StencilEnable)
-    {
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILMASK, desc->StencilReadMask);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILWRITEMASK, desc->StencilWriteMask);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILREF, stencil_ref);
+    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
 
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILFAIL, front->StencilFailOp);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILZFAIL, front->StencilDepthFailOp);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILPASS, front->StencilPassOp);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILFUNC, front->StencilFunc);
-        if (front->StencilFailOp != back->StencilFailOp
-                || front->StencilDepthFailOp != back->StencilDepthFailOp
-                || front->StencilPassOp != back->StencilPassOp
-                || front->StencilFunc != back->StencilFunc)
-        {
-            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_TWOSIDEDSTENCILMODE, TRUE);
-            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BACK_STENCILFAIL, back->StencilFailOp);
-            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BACK_STENCILZFAIL,
-                    back->StencilDepthFailOp);
-            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BACK_STENCILPASS, back->StencilPassOp);
-            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BACK_STENCILFUNC, back->StencilFunc);
-        }
-        else
-        {
-            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_TWOSIDEDSTENCILMODE, FALSE);
-        }
-    }
-    wined3d_mutex_unlock();
+    return d3d_get_private_data(&context->private_store, guid, data_size, data);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_SOSetTargets(ID3D11DeviceContext1 *iface, UINT buffer_count,
-        ID3D11Buffer *const *buffers, const UINT *offsets)
+static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_SetPrivateData(ID3D11DeviceContext1 *iface, REFGUID guid,
+        UINT data_size, const void *data)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int count, i;
-
-    TRACE("iface %p, buffer_count %u, buffers %p, offsets %p.\n", iface, buffer_count, buffers, offsets);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    count = min(buffer_count, D3D11_SO_BUFFER_SLOT_COUNT);
-    wined3d_mutex_lock();
-    for (i = 0; i < count; ++i)
-    {
-        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
 
-        wined3d_device_set_stream_output(device->wined3d_device, i,
-                buffer ? buffer->wined3d_buffer : NULL, offsets ? offsets[i] : 0);
-    }
-    for (; i < D3D11_SO_BUFFER_SLOT_COUNT; ++i)
-    {
-        wined3d_device_set_stream_output(device->wined3d_device, i, NULL, 0);
-    }
-    wined3d_mutex_unlock();
+    return d3d_set_private_data(&context->private_store, guid, data_size, data);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DrawAuto(ID3D11DeviceContext1 *iface)
+static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_SetPrivateDataInterface(ID3D11DeviceContext1 *iface,
+        REFGUID guid, const IUnknown *data)
 {
-    FIXME("iface %p stub!\n", iface);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
+
+    return d3d_set_private_data_interface(&context->private_store, guid, data);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DrawIndexedInstancedIndirect(ID3D11DeviceContext1 *iface,
-        ID3D11Buffer *buffer, UINT offset)
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_buffer *d3d_buffer;
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
 
-    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+    d3d11_immediate_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_VERTEX, start_slot,
+            buffer_count, buffers);
+}
 
-    d3d_buffer = unsafe_impl_from_ID3D11Buffer(buffer);
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
 
-    wined3d_mutex_lock();
-    wined3d_device_draw_indexed_primitive_instanced_indirect(device->wined3d_device,
-            d3d_buffer->wined3d_buffer, offset);
-    wined3d_mutex_unlock();
+    d3d11_immediate_context_set_shader_resources(iface, WINED3D_SHADER_TYPE_PIXEL, start_slot,
+            view_count, views);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DrawInstancedIndirect(ID3D11DeviceContext1 *iface,
-        ID3D11Buffer *buffer, UINT offset)
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11PixelShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_buffer *d3d_buffer;
+    struct d3d_pixel_shader *ps = unsafe_impl_from_ID3D11PixelShader(shader);
 
-    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    d3d11_immediate_context_set_shader(iface, WINED3D_SHADER_TYPE_PIXEL,
+            ps ? ps->wined3d_shader : NULL, class_instances);
+}
 
-    d3d_buffer = unsafe_impl_from_ID3D11Buffer(buffer);
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
 
-    wined3d_mutex_lock();
-    wined3d_device_draw_primitive_instanced_indirect(device->wined3d_device,
-            d3d_buffer->wined3d_buffer, offset);
-    wined3d_mutex_unlock();
+    d3d11_immediate_context_set_samplers(iface, WINED3D_SHADER_TYPE_PIXEL, start_slot,
+            sampler_count, samplers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_Dispatch(ID3D11DeviceContext1 *iface,
-        UINT thread_group_count_x, UINT thread_group_count_y, UINT thread_group_count_z)
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11VertexShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct d3d_vertex_shader *vs = unsafe_impl_from_ID3D11VertexShader(shader);
 
-    TRACE("iface %p, thread_group_count_x %u, thread_group_count_y %u, thread_group_count_z %u.\n",
-            iface, thread_group_count_x, thread_group_count_y, thread_group_count_z);
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
 
-    wined3d_mutex_lock();
-    wined3d_device_dispatch_compute(device->wined3d_device,
-            thread_group_count_x, thread_group_count_y, thread_group_count_z);
-    wined3d_mutex_unlock();
+    d3d11_immediate_context_set_shader(iface, WINED3D_SHADER_TYPE_VERTEX,
+            vs ? vs->wined3d_shader : NULL, class_instances);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DispatchIndirect(ID3D11DeviceContext1 *iface,
-        ID3D11Buffer *buffer, UINT offset)
+static void STDMETHODCALLTYPE d3d11_immediate_context_DrawIndexed(ID3D11DeviceContext1 *iface,
+        UINT index_count, UINT start_index_location, INT base_vertex_location)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_buffer *buffer_impl;
-
-    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    buffer_impl = unsafe_impl_from_ID3D11Buffer(buffer);
+    TRACE("iface %p, index_count %u, start_index_location %u, base_vertex_location %d.\n",
+            iface, index_count, start_index_location, base_vertex_location);
 
     wined3d_mutex_lock();
-    wined3d_device_dispatch_compute_indirect(device->wined3d_device,
-            buffer_impl->wined3d_buffer, offset);
+    d3d11_target_draw(&context->target, base_vertex_location, start_index_location, index_count, 0, 0, TRUE);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_RSSetState(ID3D11DeviceContext1 *iface,
-        ID3D11RasterizerState *rasterizer_state)
+static void STDMETHODCALLTYPE d3d11_immediate_context_Draw(ID3D11DeviceContext1 *iface,
+        UINT vertex_count, UINT start_vertex_location)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_rasterizer_state *rasterizer_state_impl;
-    const D3D11_RASTERIZER_DESC *desc;
-    union
-    {
-        DWORD d;
-        float f;
-    } scale_bias, const_bias;
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    TRACE("iface %p, rasterizer_state %p.\n", iface, rasterizer_state);
+    TRACE("iface %p, vertex_count %u, start_vertex_location %u.\n",
+            iface, vertex_count, start_vertex_location);
 
     wined3d_mutex_lock();
-    if (!(rasterizer_state_impl = unsafe_impl_from_ID3D11RasterizerState(rasterizer_state)))
-    {
-        wined3d_device_set_rasterizer_state(device->wined3d_device, NULL);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_FILLMODE, WINED3D_FILL_SOLID);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_CULLMODE, WINED3D_CULL_BACK);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SLOPESCALEDEPTHBIAS, 0);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_DEPTHBIAS, 0);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SCISSORTESTENABLE, FALSE);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_MULTISAMPLEANTIALIAS, FALSE);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ANTIALIASEDLINEENABLE, FALSE);
-        wined3d_mutex_unlock();
-        return;
-    }
-
-    wined3d_device_set_rasterizer_state(device->wined3d_device, rasterizer_state_impl->wined3d_state);
-
-    desc = &rasterizer_state_impl->desc;
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_FILLMODE, desc->FillMode);
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_CULLMODE, desc->CullMode);
-    scale_bias.f = desc->SlopeScaledDepthBias;
-    const_bias.f = desc->DepthBias;
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SLOPESCALEDEPTHBIAS, scale_bias.d);
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_DEPTHBIAS, const_bias.d);
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SCISSORTESTENABLE, desc->ScissorEnable);
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_MULTISAMPLEANTIALIAS, desc->MultisampleEnable);
-    wined3d_device_set_render_state(device->wined3d_device,
-            WINED3D_RS_ANTIALIASEDLINEENABLE, desc->AntialiasedLineEnable);
+    d3d11_target_draw(&context->target, 0, start_vertex_location, vertex_count, 0, 0, FALSE);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_RSSetViewports(ID3D11DeviceContext1 *iface,
-        UINT viewport_count, const D3D11_VIEWPORT *viewports)
+static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_Map(ID3D11DeviceContext1 *iface, ID3D11Resource *resource,
+        UINT subresource_idx, D3D11_MAP map_type, UINT map_flags, D3D11_MAPPED_SUBRESOURCE *mapped_subresource)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct wined3d_viewport wined3d_vp[WINED3D_MAX_VIEWPORTS];
-    unsigned int i;
+    struct wined3d_resource *wined3d_resource;
+    struct wined3d_map_desc map_desc;
+    HRESULT hr;
 
-    TRACE("iface %p, viewport_count %u, viewports %p.\n", iface, viewport_count, viewports);
+    TRACE("iface %p, resource %p, subresource_idx %u, map_type %u, map_flags %#x, mapped_subresource %p.\n",
+            iface, resource, subresource_idx, map_type, map_flags, mapped_subresource);
 
-    if (viewport_count > ARRAY_SIZE(wined3d_vp))
-        return;
+    if (map_flags)
+        FIXME("Ignoring map_flags %#x.\n", map_flags);
 
-    for (i = 0; i < viewport_count; ++i)
-    {
-        wined3d_vp[i].x = viewports[i].TopLeftX;
-        wined3d_vp[i].y = viewports[i].TopLeftY;
-        wined3d_vp[i].width = viewports[i].Width;
-        wined3d_vp[i].height = viewports[i].Height;
-        wined3d_vp[i].min_z = viewports[i].MinDepth;
-        wined3d_vp[i].max_z = viewports[i].MaxDepth;
-    }
+    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
 
     wined3d_mutex_lock();
-    wined3d_device_set_viewports(device->wined3d_device, viewport_count, wined3d_vp);
+    hr = wined3d_resource_map(wined3d_resource, subresource_idx,
+            &map_desc, NULL, wined3d_map_flags_from_d3d11_map_type(map_type));
     wined3d_mutex_unlock();
+
+    mapped_subresource->pData = map_desc.data;
+    mapped_subresource->RowPitch = map_desc.row_pitch;
+    mapped_subresource->DepthPitch = map_desc.slice_pitch;
+
+    return hr;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_RSSetScissorRects(ID3D11DeviceContext1 *iface,
-        UINT rect_count, const D3D11_RECT *rects)
+static void STDMETHODCALLTYPE d3d11_immediate_context_Unmap(ID3D11DeviceContext1 *iface, ID3D11Resource *resource,
+        UINT subresource_idx)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct wined3d_resource *wined3d_resource;
 
-    TRACE("iface %p, rect_count %u, rects %p.\n", iface, rect_count, rects);
+    TRACE("iface %p, resource %p, subresource_idx %u.\n", iface, resource, subresource_idx);
 
-    if (rect_count > WINED3D_MAX_VIEWPORTS)
-        return;
+    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
 
     wined3d_mutex_lock();
-    wined3d_device_set_scissor_rects(device->wined3d_device, rect_count, rects);
+    wined3d_resource_unmap(wined3d_resource, subresource_idx);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CopySubresourceRegion(ID3D11DeviceContext1 *iface,
-        ID3D11Resource *dst_resource, UINT dst_subresource_idx, UINT dst_x, UINT dst_y, UINT dst_z,
-        ID3D11Resource *src_resource, UINT src_subresource_idx, const D3D11_BOX *src_box)
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct wined3d_resource *wined3d_dst_resource, *wined3d_src_resource;
-    struct wined3d_box wined3d_src_box;
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
 
-    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
-            "src_resource %p, src_subresource_idx %u, src_box %p.\n",
-            iface, dst_resource, dst_subresource_idx, dst_x, dst_y, dst_z,
-            src_resource, src_subresource_idx, src_box);
+    d3d11_immediate_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_PIXEL, start_slot,
+            buffer_count, buffers);
+}
 
-    if (src_box)
-        wined3d_box_set(&wined3d_src_box, src_box->left, src_box->top,
-                src_box->right, src_box->bottom, src_box->front, src_box->back);
+static void STDMETHODCALLTYPE d3d11_immediate_context_IASetInputLayout(ID3D11DeviceContext1 *iface,
+        ID3D11InputLayout *input_layout)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct d3d_input_layout *layout = unsafe_impl_from_ID3D11InputLayout(input_layout);
+
+    TRACE("iface %p, input_layout %p.\n", iface, input_layout);
 
-    wined3d_dst_resource = wined3d_resource_from_d3d11_resource(dst_resource);
-    wined3d_src_resource = wined3d_resource_from_d3d11_resource(src_resource);
     wined3d_mutex_lock();
-    wined3d_device_copy_sub_resource_region(device->wined3d_device, wined3d_dst_resource, dst_subresource_idx,
-            dst_x, dst_y, dst_z, wined3d_src_resource, src_subresource_idx, src_box ? &wined3d_src_box : NULL, 0);
+    d3d11_target_set_vertex_declaration(&context->target, layout ? layout->wined3d_decl : NULL);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CopyResource(ID3D11DeviceContext1 *iface,
-        ID3D11Resource *dst_resource, ID3D11Resource *src_resource)
+static void STDMETHODCALLTYPE d3d11_immediate_context_IASetVertexBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers, const UINT *strides, const UINT *offsets)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct wined3d_resource *wined3d_dst_resource, *wined3d_src_resource;
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    TRACE("iface %p, dst_resource %p, src_resource %p.\n", iface, dst_resource, src_resource);
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p.\n",
+            iface, start_slot, buffer_count, buffers, strides, offsets);
 
-    wined3d_dst_resource = wined3d_resource_from_d3d11_resource(dst_resource);
-    wined3d_src_resource = wined3d_resource_from_d3d11_resource(src_resource);
     wined3d_mutex_lock();
-    wined3d_device_copy_resource(device->wined3d_device, wined3d_dst_resource, wined3d_src_resource);
+    d3d11_context_set_vertex_buffers(&context->target, start_slot, buffer_count, buffers, strides, offsets);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_UpdateSubresource(ID3D11DeviceContext1 *iface,
-        ID3D11Resource *resource, UINT subresource_idx, const D3D11_BOX *box,
-        const void *data, UINT row_pitch, UINT depth_pitch)
+static void STDMETHODCALLTYPE d3d11_immediate_context_IASetIndexBuffer(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *buffer, DXGI_FORMAT format, UINT offset)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct wined3d_resource *wined3d_resource;
-    struct wined3d_box wined3d_box;
-
-    TRACE("iface %p, resource %p, subresource_idx %u, box %p, data %p, row_pitch %u, depth_pitch %u.\n",
-            iface, resource, subresource_idx, box, data, row_pitch, depth_pitch);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
+    struct d3d_buffer *buffer_impl = unsafe_impl_from_ID3D11Buffer(buffer);
 
-    if (box)
-        wined3d_box_set(&wined3d_box, box->left, box->top, box->right, box->bottom, box->front, box->back);
+    TRACE("iface %p, buffer %p, format %s, offset %u.\n",
+            iface, buffer, debug_dxgi_format(format), offset);
 
-    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
     wined3d_mutex_lock();
-    wined3d_device_update_sub_resource(device->wined3d_device, wined3d_resource,
-            subresource_idx, box ? &wined3d_box : NULL, data, row_pitch, depth_pitch, 0);
+    d3d11_target_set_index_buffer(&context->target, buffer_impl ? buffer_impl->wined3d_buffer : NULL,
+            wined3dformat_from_dxgi_format(format), offset);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CopyStructureCount(ID3D11DeviceContext1 *iface,
-        ID3D11Buffer *dst_buffer, UINT dst_offset, ID3D11UnorderedAccessView *src_view)
+static void STDMETHODCALLTYPE d3d11_immediate_context_DrawIndexedInstanced(ID3D11DeviceContext1 *iface,
+        UINT instance_index_count, UINT instance_count, UINT start_index_location, INT base_vertex_location,
+        UINT start_instance_location)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d11_unordered_access_view *uav;
-    struct d3d_buffer *buffer_impl;
-
-    TRACE("iface %p, dst_buffer %p, dst_offset %u, src_view %p.\n",
-            iface, dst_buffer, dst_offset, src_view);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    buffer_impl = unsafe_impl_from_ID3D11Buffer(dst_buffer);
-    uav = unsafe_impl_from_ID3D11UnorderedAccessView(src_view);
+    TRACE("iface %p, instance_index_count %u, instance_count %u, start_index_location %u, "
+            "base_vertex_location %d, start_instance_location %u.\n",
+            iface, instance_index_count, instance_count, start_index_location,
+            base_vertex_location, start_instance_location);
 
     wined3d_mutex_lock();
-    wined3d_device_copy_uav_counter(device->wined3d_device,
-            buffer_impl->wined3d_buffer, dst_offset, uav->wined3d_view);
+    d3d11_target_draw(&context->target, base_vertex_location, start_index_location,
+            instance_index_count, start_instance_location, instance_count, TRUE);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ClearRenderTargetView(ID3D11DeviceContext1 *iface,
-        ID3D11RenderTargetView *render_target_view, const float color_rgba[4])
+static void STDMETHODCALLTYPE d3d11_immediate_context_DrawInstanced(ID3D11DeviceContext1 *iface,
+        UINT instance_vertex_count, UINT instance_count, UINT start_vertex_location, UINT start_instance_location)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_rendertarget_view *view = unsafe_impl_from_ID3D11RenderTargetView(render_target_view);
-    const struct wined3d_color color = {color_rgba[0], color_rgba[1], color_rgba[2], color_rgba[3]};
-    HRESULT hr;
-
-    TRACE("iface %p, render_target_view %p, color_rgba %s.\n",
-            iface, render_target_view, debug_float4(color_rgba));
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    if (!view)
-        return;
+    TRACE("iface %p, instance_vertex_count %u, instance_count %u, start_vertex_location %u, "
+            "start_instance_location %u.\n",
+            iface, instance_vertex_count, instance_count, start_vertex_location,
+            start_instance_location);
 
     wined3d_mutex_lock();
-    if (FAILED(hr = wined3d_device_clear_rendertarget_view(device->wined3d_device, view->wined3d_view, NULL,
-            WINED3DCLEAR_TARGET, &color, 0.0f, 0)))
-        ERR("Failed to clear view, hr %#x.\n", hr);
+    d3d11_target_draw(&context->target, 0, start_vertex_location,
+            instance_vertex_count, start_instance_location, instance_count, FALSE);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ClearUnorderedAccessViewUint(ID3D11DeviceContext1 *iface,
-        ID3D11UnorderedAccessView *unordered_access_view, const UINT values[4])
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d11_unordered_access_view *view;
-
-    TRACE("iface %p, unordered_access_view %p, values {%u, %u, %u, %u}.\n",
-            iface, unordered_access_view, values[0], values[1], values[2], values[3]);
-
-    view = unsafe_impl_from_ID3D11UnorderedAccessView(unordered_access_view);
-    wined3d_mutex_lock();
-    wined3d_device_clear_unordered_access_view_uint(device->wined3d_device,
-            view->wined3d_view, (const struct wined3d_uvec4 *)values);
-    wined3d_mutex_unlock();
-}
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ClearUnorderedAccessViewFloat(ID3D11DeviceContext1 *iface,
-        ID3D11UnorderedAccessView *unordered_access_view, const float values[4])
-{
-    FIXME("iface %p, unordered_access_view %p, values %s stub!\n",
-            iface, unordered_access_view, debug_float4(values));
+    d3d11_immediate_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_GEOMETRY, start_slot,
+            buffer_count, buffers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ClearDepthStencilView(ID3D11DeviceContext1 *iface,
-        ID3D11DepthStencilView *depth_stencil_view, UINT flags, FLOAT depth, UINT8 stencil)
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11GeometryShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_depthstencil_view *view = unsafe_impl_from_ID3D11DepthStencilView(depth_stencil_view);
-    DWORD wined3d_flags;
-    HRESULT hr;
-
-    TRACE("iface %p, depth_stencil_view %p, flags %#x, depth %.8e, stencil %u.\n",
-            iface, depth_stencil_view, flags, depth, stencil);
-
-    if (!view)
-        return;
+    struct d3d_geometry_shader *gs = unsafe_impl_from_ID3D11GeometryShader(shader);
 
-    wined3d_flags = wined3d_clear_flags_from_d3d11_clear_flags(flags);
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
 
-    wined3d_mutex_lock();
-    if (FAILED(hr = wined3d_device_clear_rendertarget_view(device->wined3d_device, view->wined3d_view, NULL,
-            wined3d_flags, NULL, depth, stencil)))
-        ERR("Failed to clear view, hr %#x.\n", hr);
-    wined3d_mutex_unlock();
+    d3d11_immediate_context_set_shader(iface, WINED3D_SHADER_TYPE_GEOMETRY,
+            gs ? gs->wined3d_shader : NULL, class_instances);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GenerateMips(ID3D11DeviceContext1 *iface,
-        ID3D11ShaderResourceView *view)
+static void STDMETHODCALLTYPE d3d11_immediate_context_IASetPrimitiveTopology(ID3D11DeviceContext1 *iface,
+        D3D11_PRIMITIVE_TOPOLOGY topology)
 {
-    struct d3d_shader_resource_view *srv = unsafe_impl_from_ID3D11ShaderResourceView(view);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    TRACE("iface %p, view %p.\n", iface, view);
+    TRACE("iface %p, topology %#x.\n", iface, topology);
 
     wined3d_mutex_lock();
-    wined3d_shader_resource_view_generate_mipmaps(srv->wined3d_view);
+    d3d11_context_set_primitive_topology(&context->target, topology);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_SetResourceMinLOD(ID3D11DeviceContext1 *iface,
-        ID3D11Resource *resource, FLOAT min_lod)
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
 {
-    FIXME("iface %p, resource %p, min_lod %f stub!\n", iface, resource, min_lod);
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    d3d11_immediate_context_set_shader_resources(iface, WINED3D_SHADER_TYPE_VERTEX, start_slot,
+            view_count, views);
 }
 
-static FLOAT STDMETHODCALLTYPE d3d11_immediate_context_GetResourceMinLOD(ID3D11DeviceContext1 *iface,
-        ID3D11Resource *resource)
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
 {
-    FIXME("iface %p, resource %p stub!\n", iface, resource);
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
 
-    return 0.0f;
+    d3d11_immediate_context_set_samplers(iface, WINED3D_SHADER_TYPE_VERTEX, start_slot,
+            sampler_count, samplers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ResolveSubresource(ID3D11DeviceContext1 *iface,
-        ID3D11Resource *dst_resource, UINT dst_subresource_idx,
-        ID3D11Resource *src_resource, UINT src_subresource_idx,
-        DXGI_FORMAT format)
+static void STDMETHODCALLTYPE d3d11_immediate_context_Begin(ID3D11DeviceContext1 *iface,
+        ID3D11Asynchronous *asynchronous)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct wined3d_resource *wined3d_dst_resource, *wined3d_src_resource;
-    enum wined3d_format_id wined3d_format;
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, "
-            "src_resource %p, src_subresource_idx %u, format %s.\n",
-            iface, dst_resource, dst_subresource_idx,
-            src_resource, src_subresource_idx, debug_dxgi_format(format));
+    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
 
-    wined3d_dst_resource = wined3d_resource_from_d3d11_resource(dst_resource);
-    wined3d_src_resource = wined3d_resource_from_d3d11_resource(src_resource);
-    wined3d_format = wined3dformat_from_dxgi_format(format);
     wined3d_mutex_lock();
-    wined3d_device_resolve_sub_resource(device->wined3d_device,
-            wined3d_dst_resource, dst_subresource_idx,
-            wined3d_src_resource, src_subresource_idx, wined3d_format);
+    d3d11_context_issue_query(&context->target, asynchronous, WINED3DISSUE_BEGIN);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ExecuteCommandList(ID3D11DeviceContext1 *iface,
-        ID3D11CommandList *command_list, BOOL restore_state)
+static void STDMETHODCALLTYPE d3d11_immediate_context_End(ID3D11DeviceContext1 *iface,
+        ID3D11Asynchronous *asynchronous)
 {
-    FIXME("iface %p, command_list %p, restore_state %#x stub!\n", iface, command_list, restore_state);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+
+    wined3d_mutex_lock();
+    d3d11_context_issue_query(&context->target, asynchronous, WINED3DISSUE_END);
+    wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetShaderResources(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_GetData(ID3D11DeviceContext1 *iface,
+        ID3D11Asynchronous *asynchronous, void *data, UINT data_size, UINT data_flags)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    struct d3d_query *query = unsafe_impl_from_ID3D11Asynchronous(asynchronous);
+    unsigned int wined3d_flags;
+    HRESULT hr;
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
-            iface, start_slot, view_count, views);
+    TRACE("iface %p, asynchronous %p, data %p, data_size %u, data_flags %#x.\n",
+            iface, asynchronous, data, data_size, data_flags);
+
+    if (!data && data_size)
+        return E_INVALIDARG;
+
+    wined3d_flags = wined3d_getdata_flags_from_d3d11_async_getdata_flags(data_flags);
 
     wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
+    if (!data_size || wined3d_query_get_data_size(query->wined3d_query) == data_size)
     {
-        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
-
-        wined3d_device_set_hs_resource_view(device->wined3d_device, start_slot + i,
-                view ? view->wined3d_view : NULL);
+        hr = wined3d_query_get_data(query->wined3d_query, data, data_size, wined3d_flags);
+        if (hr == WINED3DERR_INVALIDCALL)
+            hr = DXGI_ERROR_INVALID_CALL;
+    }
+    else
+    {
+        WARN("Invalid data size %u.\n", data_size);
+        hr = E_INVALIDARG;
     }
     wined3d_mutex_unlock();
+
+    return hr;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetShader(ID3D11DeviceContext1 *iface,
-        ID3D11HullShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+static void STDMETHODCALLTYPE d3d11_immediate_context_SetPredication(ID3D11DeviceContext1 *iface,
+        ID3D11Predicate *predicate, BOOL value)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d11_hull_shader *hs = unsafe_impl_from_ID3D11HullShader(shader);
-
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
-            iface, shader, class_instances, class_instance_count);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    if (class_instances)
-        FIXME("Dynamic linking is not implemented yet.\n");
+    TRACE("iface %p, predicate %p, value %#x.\n", iface, predicate, value);
 
     wined3d_mutex_lock();
-    wined3d_device_set_hull_shader(device->wined3d_device, hs ? hs->wined3d_shader : NULL);
+    d3d11_context_set_predication(&context->target, predicate, value);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetSamplers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
 
-        wined3d_device_set_hs_sampler(device->wined3d_device, start_slot + i,
-                sampler ? sampler->wined3d_sampler : NULL);
-    }
-    wined3d_mutex_unlock();
+    d3d11_immediate_context_set_shader_resources(iface, WINED3D_SHADER_TYPE_GEOMETRY, start_slot,
+            view_count, views);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetConstantBuffers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
 {
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
 
-    d3d11_immediate_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_HULL, start_slot,
-            buffer_count, buffers);
+    d3d11_immediate_context_set_samplers(iface, WINED3D_SHADER_TYPE_GEOMETRY, start_slot,
+            sampler_count, samplers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetShaderResources(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetRenderTargets(ID3D11DeviceContext1 *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView *const *render_target_views,
+        ID3D11DepthStencilView *depth_stencil_view)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
-            iface, start_slot, view_count, views);
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view);
 
     wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
-
-        wined3d_device_set_ds_resource_view(device->wined3d_device, start_slot + i,
-                view ? view->wined3d_view : NULL);
-    }
+    d3d11_context_set_render_targets(&context->target, render_target_view_count, render_target_views,
+            depth_stencil_view);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetShader(ID3D11DeviceContext1 *iface,
-        ID3D11DomainShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetRenderTargetsAndUnorderedAccessViews(
+        ID3D11DeviceContext1 *iface, UINT render_target_view_count,
+        ID3D11RenderTargetView *const *render_target_views, ID3D11DepthStencilView *depth_stencil_view,
+        UINT unordered_access_view_start_slot, UINT unordered_access_view_count,
+        ID3D11UnorderedAccessView *const *unordered_access_views, const UINT *initial_counts)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d11_domain_shader *ds = unsafe_impl_from_ID3D11DomainShader(shader);
+    unsigned int i;
 
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
-            iface, shader, class_instances, class_instance_count);
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
+            "unordered_access_view_start_slot %u, unordered_access_view_count %u, unordered_access_views %p, "
+            "initial_counts %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view,
+            unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views,
+            initial_counts);
 
-    if (class_instances)
-        FIXME("Dynamic linking is not implemented yet.\n");
+    if (render_target_view_count != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL)
+    {
+        d3d11_immediate_context_OMSetRenderTargets(iface, render_target_view_count, render_target_views,
+                depth_stencil_view);
+    }
+
+    if (unordered_access_view_count != D3D11_KEEP_UNORDERED_ACCESS_VIEWS)
+    {
+        wined3d_mutex_lock();
+        for (i = 0; i < unordered_access_view_start_slot; ++i)
+        {
+            wined3d_device_set_unordered_access_view(device->wined3d_device, i, NULL, ~0u);
+        }
+        for (i = 0; i < unordered_access_view_count; ++i)
+        {
+            struct d3d11_unordered_access_view *view
+                    = unsafe_impl_from_ID3D11UnorderedAccessView(unordered_access_views[i]);
+
+            wined3d_device_set_unordered_access_view(device->wined3d_device,
+                    unordered_access_view_start_slot + i,
+                    view ? view->wined3d_view : NULL, initial_counts ? initial_counts[i] : ~0u);
+        }
+        for (; unordered_access_view_start_slot + i < D3D11_PS_CS_UAV_REGISTER_COUNT; ++i)
+        {
+            wined3d_device_set_unordered_access_view(device->wined3d_device,
+                    unordered_access_view_start_slot + i, NULL, ~0u);
+        }
+        wined3d_mutex_unlock();
+    }
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetBlendState(ID3D11DeviceContext1 *iface,
+        ID3D11BlendState *blend_state, const float blend_factor[4], UINT sample_mask)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, blend_state %p, blend_factor %s, sample_mask 0x%08x.\n",
+            iface, blend_state, debug_float4(blend_factor), sample_mask);
 
     wined3d_mutex_lock();
-    wined3d_device_set_domain_shader(device->wined3d_device, ds ? ds->wined3d_shader : NULL);
+    d3d11_context_set_blend_state(&context->target, blend_state, blend_factor, sample_mask);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetSamplers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetDepthStencilState(ID3D11DeviceContext1 *iface,
+        ID3D11DepthStencilState *depth_stencil_state, UINT stencil_ref)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
 
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
+    TRACE("iface %p, depth_stencil_state %p, stencil_ref %u.\n",
+            iface, depth_stencil_state, stencil_ref);
 
     wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
-
-        wined3d_device_set_ds_sampler(device->wined3d_device, start_slot + i,
-                sampler ? sampler->wined3d_sampler : NULL);
-    }
+    device->stencil_ref = stencil_ref;
+    device->depth_stencil_state = unsafe_impl_from_ID3D11DepthStencilState(depth_stencil_state);
+    d3d11_context_set_depth_stencil_state(&device->immediate_context.target, device->depth_stencil_state, stencil_ref);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetConstantBuffers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+static void STDMETHODCALLTYPE d3d11_immediate_context_SOSetTargets(ID3D11DeviceContext1 *iface, UINT buffer_count,
+        ID3D11Buffer *const *buffers, const UINT *offsets)
 {
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    d3d11_immediate_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_DOMAIN, start_slot,
-            buffer_count, buffers);
+    TRACE("iface %p, buffer_count %u, buffers %p, offsets %p.\n", iface, buffer_count, buffers, offsets);
+
+    wined3d_mutex_lock();
+    d3d11_context_set_stream_output_targets(&context->target, buffer_count, buffers, offsets);
+    wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetShaderResources(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+static void STDMETHODCALLTYPE d3d11_immediate_context_DrawAuto(ID3D11DeviceContext1 *iface)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    FIXME("iface %p stub!\n", iface);
+}
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
-            iface, start_slot, view_count, views);
+static void STDMETHODCALLTYPE d3d11_immediate_context_DrawIndexedInstancedIndirect(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *buffer, UINT offset)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
 
-        wined3d_device_set_cs_resource_view(device->wined3d_device, start_slot + i,
-                view ? view->wined3d_view : NULL);
-    }
+    wined3d_mutex_lock();
+    d3d11_context_draw_indirect(&context->target, buffer, offset, TRUE);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetUnorderedAccessViews(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT view_count, ID3D11UnorderedAccessView *const *views, const UINT *initial_counts)
+static void STDMETHODCALLTYPE d3d11_immediate_context_DrawInstancedIndirect(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *buffer, UINT offset)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p, initial_counts %p.\n",
-            iface, start_slot, view_count, views, initial_counts);
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
 
     wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct d3d11_unordered_access_view *view = unsafe_impl_from_ID3D11UnorderedAccessView(views[i]);
-
-        wined3d_device_set_cs_uav(device->wined3d_device, start_slot + i,
-                view ? view->wined3d_view : NULL, initial_counts ? initial_counts[i] : ~0u);
-    }
+    d3d11_context_draw_indirect(&context->target, buffer, offset, FALSE);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetShader(ID3D11DeviceContext1 *iface,
-        ID3D11ComputeShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+static void STDMETHODCALLTYPE d3d11_immediate_context_Dispatch(ID3D11DeviceContext1 *iface,
+        UINT thread_group_count_x, UINT thread_group_count_y, UINT thread_group_count_z)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d11_compute_shader *cs = unsafe_impl_from_ID3D11ComputeShader(shader);
-
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
-            iface, shader, class_instances, class_instance_count);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    if (class_instances)
-        FIXME("Dynamic linking is not implemented yet.\n");
+    TRACE("iface %p, thread_group_count_x %u, thread_group_count_y %u, thread_group_count_z %u.\n",
+            iface, thread_group_count_x, thread_group_count_y, thread_group_count_z);
 
     wined3d_mutex_lock();
-    wined3d_device_set_compute_shader(device->wined3d_device, cs ? cs->wined3d_shader : NULL);
+    d3d11_target_dispatch(&context->target, thread_group_count_x, thread_group_count_y, thread_group_count_z);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetSamplers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+static void STDMETHODCALLTYPE d3d11_immediate_context_DispatchIndirect(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *buffer, UINT offset)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
 
     wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
-
-        wined3d_device_set_cs_sampler(device->wined3d_device, start_slot + i,
-                sampler ? sampler->wined3d_sampler : NULL);
-    }
+    d3d11_context_dispatch_indirect(&context->target, buffer, offset);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetConstantBuffers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+static void STDMETHODCALLTYPE d3d11_immediate_context_RSSetState(ID3D11DeviceContext1 *iface,
+        ID3D11RasterizerState *rasterizer_state)
 {
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    d3d11_immediate_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_COMPUTE, start_slot,
-            buffer_count, buffers);
+    TRACE("iface %p, rasterizer_state %p.\n", iface, rasterizer_state);
+
+    wined3d_mutex_lock();
+    d3d11_context_set_rasterizer_state(&context->target, rasterizer_state);
+    wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetConstantBuffers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+static void STDMETHODCALLTYPE d3d11_immediate_context_RSSetViewports(ID3D11DeviceContext1 *iface,
+        UINT viewport_count, const D3D11_VIEWPORT *viewports)
 {
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    d3d11_immediate_context_get_constant_buffers(iface, WINED3D_SHADER_TYPE_VERTEX, start_slot,
-            buffer_count, buffers);
+    TRACE("iface %p, viewport_count %u, viewports %p.\n", iface, viewport_count, viewports);
+
+    wined3d_mutex_lock();
+    d3d11_context_set_viewports(&context->target, viewport_count, viewports);
+    wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetShaderResources(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+static void STDMETHODCALLTYPE d3d11_immediate_context_RSSetScissorRects(ID3D11DeviceContext1 *iface,
+        UINT rect_count, const D3D11_RECT *rects)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
-            iface, start_slot, view_count, views);
+    TRACE("iface %p, rect_count %u, rects %p.\n", iface, rect_count, rects);
 
     wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct wined3d_shader_resource_view *wined3d_view;
-        struct d3d_shader_resource_view *view_impl;
-
-        if (!(wined3d_view = wined3d_device_get_ps_resource_view(device->wined3d_device, start_slot + i)))
-        {
-            views[i] = NULL;
-            continue;
-        }
-
-        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
-        views[i] = &view_impl->ID3D11ShaderResourceView_iface;
-        ID3D11ShaderResourceView_AddRef(views[i]);
-    }
+    d3d11_context_set_scissor_rects(&context->target, rect_count, rects);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetShader(ID3D11DeviceContext1 *iface,
-        ID3D11PixelShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+static void STDMETHODCALLTYPE d3d11_immediate_context_CopySubresourceRegion(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *dst_resource, UINT dst_subresource_idx, UINT dst_x, UINT dst_y, UINT dst_z,
+        ID3D11Resource *src_resource, UINT src_subresource_idx, const D3D11_BOX *src_box)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct wined3d_shader *wined3d_shader;
-    struct d3d_pixel_shader *shader_impl;
-
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
-            iface, shader, class_instances, class_instance_count);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    if (class_instances || class_instance_count)
-        FIXME("Dynamic linking not implemented yet.\n");
-    if (class_instance_count)
-        *class_instance_count = 0;
+    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
+            "src_resource %p, src_subresource_idx %u, src_box %p.\n",
+            iface, dst_resource, dst_subresource_idx, dst_x, dst_y, dst_z,
+            src_resource, src_subresource_idx, src_box);
 
     wined3d_mutex_lock();
-    if (!(wined3d_shader = wined3d_device_get_pixel_shader(device->wined3d_device)))
-    {
-        wined3d_mutex_unlock();
-        *shader = NULL;
-        return;
-    }
-
-    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    d3d11_context_copy_subresource_region(&context->target, dst_resource, dst_subresource_idx,
+            dst_x, dst_y, dst_z, src_resource, src_subresource_idx, src_box, 0);
     wined3d_mutex_unlock();
-    *shader = &shader_impl->ID3D11PixelShader_iface;
-    ID3D11PixelShader_AddRef(*shader);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetSamplers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+static void STDMETHODCALLTYPE d3d11_immediate_context_CopyResource(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *dst_resource, ID3D11Resource *src_resource)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
+    TRACE("iface %p, dst_resource %p, src_resource %p.\n", iface, dst_resource, src_resource);
 
     wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct wined3d_sampler *wined3d_sampler;
-        struct d3d_sampler_state *sampler_impl;
-
-        if (!(wined3d_sampler = wined3d_device_get_ps_sampler(device->wined3d_device, start_slot + i)))
-        {
-            samplers[i] = NULL;
-            continue;
-        }
-
-        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
-        samplers[i] = &sampler_impl->ID3D11SamplerState_iface;
-        ID3D11SamplerState_AddRef(samplers[i]);
-    }
+    d3d11_context_copy_resource(&context->target, dst_resource, src_resource);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetShader(ID3D11DeviceContext1 *iface,
-        ID3D11VertexShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+static void STDMETHODCALLTYPE d3d11_immediate_context_UpdateSubresource(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *resource, UINT subresource_idx, const D3D11_BOX *box,
+        const void *data, UINT row_pitch, UINT depth_pitch)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_vertex_shader *shader_impl;
-    struct wined3d_shader *wined3d_shader;
-
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
-            iface, shader, class_instances, class_instance_count);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    if (class_instances || class_instance_count)
-        FIXME("Dynamic linking not implemented yet.\n");
-    if (class_instance_count)
-        *class_instance_count = 0;
+    TRACE("iface %p, resource %p, subresource_idx %u, box %p, data %p, row_pitch %u, depth_pitch %u.\n",
+            iface, resource, subresource_idx, box, data, row_pitch, depth_pitch);
 
     wined3d_mutex_lock();
-    if (!(wined3d_shader = wined3d_device_get_vertex_shader(device->wined3d_device)))
-    {
-        wined3d_mutex_unlock();
-        *shader = NULL;
-        return;
-    }
-
-    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    d3d11_context_update_subresource(&context->target, resource, subresource_idx, box,
+            data, row_pitch, depth_pitch, 0);
     wined3d_mutex_unlock();
-    *shader = &shader_impl->ID3D11VertexShader_iface;
-    ID3D11VertexShader_AddRef(*shader);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetConstantBuffers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+static void STDMETHODCALLTYPE d3d11_immediate_context_CopyStructureCount(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *dst_buffer, UINT dst_offset, ID3D11UnorderedAccessView *src_view)
 {
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    d3d11_immediate_context_get_constant_buffers(iface, WINED3D_SHADER_TYPE_PIXEL, start_slot,
-            buffer_count, buffers);
+    TRACE("iface %p, dst_buffer %p, dst_offset %u, src_view %p.\n",
+            iface, dst_buffer, dst_offset, src_view);
+
+    wined3d_mutex_lock();
+    d3d11_context_copy_structure_count(&context->target, dst_buffer, dst_offset, src_view);
+    wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetInputLayout(ID3D11DeviceContext1 *iface,
-        ID3D11InputLayout **input_layout)
+static void STDMETHODCALLTYPE d3d11_immediate_context_ClearRenderTargetView(ID3D11DeviceContext1 *iface,
+        ID3D11RenderTargetView *render_target_view, const float color_rgba[4])
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct wined3d_vertex_declaration *wined3d_declaration;
-    struct d3d_input_layout *input_layout_impl;
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    TRACE("iface %p, input_layout %p.\n", iface, input_layout);
+    TRACE("iface %p, render_target_view %p, color_rgba %s.\n",
+            iface, render_target_view, debug_float4(color_rgba));
 
     wined3d_mutex_lock();
-    if (!(wined3d_declaration = wined3d_device_get_vertex_declaration(device->wined3d_device)))
-    {
-        wined3d_mutex_unlock();
-        *input_layout = NULL;
-        return;
-    }
-
-    input_layout_impl = wined3d_vertex_declaration_get_parent(wined3d_declaration);
+    d3d11_context_clear_render_target_view(&context->target, render_target_view, color_rgba);
     wined3d_mutex_unlock();
-    *input_layout = &input_layout_impl->ID3D11InputLayout_iface;
-    ID3D11InputLayout_AddRef(*input_layout);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetVertexBuffers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *strides, UINT *offsets)
+static void STDMETHODCALLTYPE d3d11_immediate_context_ClearUnorderedAccessViewUint(ID3D11DeviceContext1 *iface,
+        ID3D11UnorderedAccessView *unordered_access_view, const UINT values[4])
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p.\n",
-            iface, start_slot, buffer_count, buffers, strides, offsets);
+    TRACE("iface %p, unordered_access_view %p, values {%u, %u, %u, %u}.\n",
+            iface, unordered_access_view, values[0], values[1], values[2], values[3]);
 
     wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
-    {
-        struct wined3d_buffer *wined3d_buffer = NULL;
-        struct d3d_buffer *buffer_impl;
+    d3d11_context_clear_unordered_access_view_uint(&context->target, unordered_access_view, values);
+    wined3d_mutex_unlock();
+}
 
-        if (FAILED(wined3d_device_get_stream_source(device->wined3d_device, start_slot + i,
-                &wined3d_buffer, &offsets[i], &strides[i])))
-        {
-            FIXME("Failed to get vertex buffer %u.\n", start_slot + i);
-            if (strides)
-                strides[i] = 0;
-            if (offsets)
-                offsets[i] = 0;
-        }
+static void STDMETHODCALLTYPE d3d11_immediate_context_ClearUnorderedAccessViewFloat(ID3D11DeviceContext1 *iface,
+        ID3D11UnorderedAccessView *unordered_access_view, const float values[4])
+{
+    FIXME("iface %p, unordered_access_view %p, values %s stub!\n",
+            iface, unordered_access_view, debug_float4(values));
+}
 
-        if (!wined3d_buffer)
-        {
-            buffers[i] = NULL;
-            continue;
-        }
+static void STDMETHODCALLTYPE d3d11_immediate_context_ClearDepthStencilView(ID3D11DeviceContext1 *iface,
+        ID3D11DepthStencilView *depth_stencil_view, UINT flags, FLOAT depth, UINT8 stencil)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
-        ID3D11Buffer_AddRef(buffers[i] = &buffer_impl->ID3D11Buffer_iface);
-    }
+    TRACE("iface %p, depth_stencil_view %p, flags %#x, depth %.8e, stencil %u.\n",
+            iface, depth_stencil_view, flags, depth, stencil);
+
+    wined3d_mutex_lock();
+    d3d11_context_clear_depth_stencil_view(&context->target, depth_stencil_view, flags, depth, stencil);
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetIndexBuffer(ID3D11DeviceContext1 *iface,
-        ID3D11Buffer **buffer, DXGI_FORMAT *format, UINT *offset)
+static void STDMETHODCALLTYPE d3d11_immediate_context_GenerateMips(ID3D11DeviceContext1 *iface,
+        ID3D11ShaderResourceView *view)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    enum wined3d_format_id wined3d_format;
-    struct wined3d_buffer *wined3d_buffer;
-    struct d3d_buffer *buffer_impl;
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
 
-    TRACE("iface %p, buffer %p, format %p, offset %p.\n", iface, buffer, format, offset);
+    TRACE("iface %p, view %p.\n", iface, view);
 
     wined3d_mutex_lock();
-    wined3d_buffer = wined3d_device_get_index_buffer(device->wined3d_device, &wined3d_format, offset);
-    *format = dxgi_format_from_wined3dformat(wined3d_format);
-    if (!wined3d_buffer)
-    {
-        wined3d_mutex_unlock();
-        *buffer = NULL;
-        return;
-    }
-
-    buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
+    d3d11_context_generate_mips(&context->target, view);
     wined3d_mutex_unlock();
-    ID3D11Buffer_AddRef(*buffer = &buffer_impl->ID3D11Buffer_iface);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetConstantBuffers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+static void STDMETHODCALLTYPE d3d11_immediate_context_SetResourceMinLOD(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *resource, FLOAT min_lod)
 {
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
+    FIXME("iface %p, resource %p, min_lod %f stub!\n", iface, resource, min_lod);
+}
 
-    d3d11_immediate_context_get_constant_buffers(iface, WINED3D_SHADER_TYPE_GEOMETRY, start_slot,
-            buffer_count, buffers);
+static FLOAT STDMETHODCALLTYPE d3d11_immediate_context_GetResourceMinLOD(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *resource)
+{
+    FIXME("iface %p, resource %p stub!\n", iface, resource);
+
+    return 0.0f;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetShader(ID3D11DeviceContext1 *iface,
-        ID3D11GeometryShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+static void STDMETHODCALLTYPE d3d11_immediate_context_ResolveSubresource(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *dst_resource, UINT dst_subresource_idx,
+        ID3D11Resource *src_resource, UINT src_subresource_idx,
+        DXGI_FORMAT format)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_geometry_shader *shader_impl;
-    struct wined3d_shader *wined3d_shader;
-
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
-            iface, shader, class_instances, class_instance_count);
+    struct wined3d_resource *wined3d_dst_resource, *wined3d_src_resource;
+    enum wined3d_format_id wined3d_format;
 
-    if (class_instances || class_instance_count)
-        FIXME("Dynamic linking not implemented yet.\n");
-    if (class_instance_count)
-        *class_instance_count = 0;
+    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, "
+            "src_resource %p, src_subresource_idx %u, format %s.\n",
+            iface, dst_resource, dst_subresource_idx,
+            src_resource, src_subresource_idx, debug_dxgi_format(format));
 
+    wined3d_dst_resource = wined3d_resource_from_d3d11_resource(dst_resource);
+    wined3d_src_resource = wined3d_resource_from_d3d11_resource(src_resource);
+    wined3d_format = wined3dformat_from_dxgi_format(format);
     wined3d_mutex_lock();
-    if (!(wined3d_shader = wined3d_device_get_geometry_shader(device->wined3d_device)))
-    {
-        wined3d_mutex_unlock();
-        *shader = NULL;
-        return;
-    }
-
-    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    wined3d_device_resolve_sub_resource(device->wined3d_device,
+            wined3d_dst_resource, dst_subresource_idx,
+            wined3d_src_resource, src_subresource_idx, wined3d_format);
     wined3d_mutex_unlock();
-    *shader = &shader_impl->ID3D11GeometryShader_iface;
-    ID3D11GeometryShader_AddRef(*shader);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetPrimitiveTopology(ID3D11DeviceContext1 *iface,
-        D3D11_PRIMITIVE_TOPOLOGY *topology)
+static void STDMETHODCALLTYPE d3d11_immediate_context_ExecuteCommandList(ID3D11DeviceContext1 *iface,
+        ID3D11CommandList *command_list, BOOL restore_state)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    enum wined3d_primitive_type primitive_type;
-    unsigned int patch_vertex_count;
+    struct d3d11_command_list *list = unsafe_impl_from_ID3D11CommandList(command_list);
 
-    TRACE("iface %p, topology %p.\n", iface, topology);
+    TRACE("iface %p, command_list %p, restore_state %#x.\n", iface, command_list, restore_state);
+
+    if (!list)
+        return;
 
     wined3d_mutex_lock();
-    wined3d_device_get_primitive_type(device->wined3d_device, &primitive_type, &patch_vertex_count);
+    wined3d_device_execute_command_list(device->wined3d_device, list->wined3d_list);
+    if (!restore_state)
+        ID3D11DeviceContext1_ClearState(iface);
     wined3d_mutex_unlock();
-
-    d3d11_primitive_topology_from_wined3d_primitive_type(primitive_type, patch_vertex_count, topology);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetShaderResources(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+    d3d11_immediate_context_set_shader_resources(iface, WINED3D_SHADER_TYPE_HULL, start_slot,
+            view_count, views);
+}
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct wined3d_shader_resource_view *wined3d_view;
-        struct d3d_shader_resource_view *view_impl;
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11HullShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d11_hull_shader *hs = unsafe_impl_from_ID3D11HullShader(shader);
 
-        if (!(wined3d_view = wined3d_device_get_vs_resource_view(device->wined3d_device, start_slot + i)))
-        {
-            views[i] = NULL;
-            continue;
-        }
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
 
-        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
-        views[i] = &view_impl->ID3D11ShaderResourceView_iface;
-        ID3D11ShaderResourceView_AddRef(views[i]);
-    }
-    wined3d_mutex_unlock();
+    d3d11_immediate_context_set_shader(iface, WINED3D_SHADER_TYPE_HULL,
+            hs ? hs->wined3d_shader : NULL, class_instances);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetSamplers(ID3D11DeviceContext1 *iface,
-        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
-
     TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
             iface, start_slot, sampler_count, samplers);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct wined3d_sampler *wined3d_sampler;
-        struct d3d_sampler_state *sampler_impl;
+    d3d11_immediate_context_set_samplers(iface, WINED3D_SHADER_TYPE_HULL, start_slot,
+            sampler_count, samplers);
+}
 
-        if (!(wined3d_sampler = wined3d_device_get_vs_sampler(device->wined3d_device, start_slot + i)))
-        {
-            samplers[i] = NULL;
-            continue;
-        }
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
 
-        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
-        samplers[i] = &sampler_impl->ID3D11SamplerState_iface;
-        ID3D11SamplerState_AddRef(samplers[i]);
-    }
-    wined3d_mutex_unlock();
+    d3d11_immediate_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_HULL, start_slot,
+            buffer_count, buffers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GetPredication(ID3D11DeviceContext1 *iface,
-        ID3D11Predicate **predicate, BOOL *value)
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    d3d11_immediate_context_set_shader_resources(iface, WINED3D_SHADER_TYPE_DOMAIN, start_slot,
+            view_count, views);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11DomainShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d11_domain_shader *ds = unsafe_impl_from_ID3D11DomainShader(shader);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    d3d11_immediate_context_set_shader(iface, WINED3D_SHADER_TYPE_DOMAIN,
+            ds ? ds->wined3d_shader : NULL, class_instances);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    d3d11_immediate_context_set_samplers(iface, WINED3D_SHADER_TYPE_DOMAIN, start_slot,
+            sampler_count, samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    d3d11_immediate_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_DOMAIN, start_slot,
+            buffer_count, buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    d3d11_immediate_context_set_shader_resources(iface, WINED3D_SHADER_TYPE_COMPUTE, start_slot,
+            view_count, views);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetUnorderedAccessViews(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11UnorderedAccessView *const *views, const UINT *initial_counts)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct wined3d_query *wined3d_predicate;
-    struct d3d_query *predicate_impl;
+    unsigned int i;
 
-    TRACE("iface %p, predicate %p, value %p.\n", iface, predicate, value);
+    TRACE("iface %p, start_slot %u, view_count %u, views %p, initial_counts %p.\n",
+            iface, start_slot, view_count, views, initial_counts);
 
     wined3d_mutex_lock();
-    if (!(wined3d_predicate = wined3d_device_get_predication(device->wined3d_device, value)))
+    for (i = 0; i < view_count; ++i)
     {
-        wined3d_mutex_unlock();
-        *predicate = NULL;
-        return;
-    }
+        struct d3d11_unordered_access_view *view = unsafe_impl_from_ID3D11UnorderedAccessView(views[i]);
 
-    predicate_impl = wined3d_query_get_parent(wined3d_predicate);
+        wined3d_device_set_cs_uav(device->wined3d_device, start_slot + i,
+                view ? view->wined3d_view : NULL, initial_counts ? initial_counts[i] : ~0u);
+    }
     wined3d_mutex_unlock();
-    *predicate = (ID3D11Predicate *)&predicate_impl->ID3D11Query_iface;
-    ID3D11Predicate_AddRef(*predicate);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetShaderResources(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11ComputeShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d11_compute_shader *cs = unsafe_impl_from_ID3D11ComputeShader(shader);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    d3d11_immediate_context_set_shader(iface, WINED3D_SHADER_TYPE_COMPUTE,
+            cs ? cs->wined3d_shader : NULL, class_instances);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    d3d11_immediate_context_set_samplers(iface, WINED3D_SHADER_TYPE_COMPUTE, start_slot,
+            sampler_count, samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    d3d11_immediate_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_COMPUTE, start_slot,
+            buffer_count, buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    d3d11_immediate_context_get_constant_buffers(iface, WINED3D_SHADER_TYPE_VERTEX, start_slot,
+            buffer_count, buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetShaderResources(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
     unsigned int i;
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
 
     wined3d_mutex_lock();
     for (i = 0; i < view_count; ++i)
@@ -1803,7 +1842,7 @@ static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetShaderResources(ID3D1
         struct wined3d_shader_resource_view *wined3d_view;
         struct d3d_shader_resource_view *view_impl;
 
-        if (!(wined3d_view = wined3d_device_get_gs_resource_view(device->wined3d_device, start_slot + i)))
+        if (!(wined3d_view = wined3d_device_get_ps_resource_view(device->wined3d_device, start_slot + i)))
         {
             views[i] = NULL;
             continue;
@@ -1816,7 +1855,36 @@ static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetShaderResources(ID3D1
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetSamplers(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11PixelShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct wined3d_shader *wined3d_shader;
+    struct d3d_pixel_shader *shader_impl;
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances || class_instance_count)
+        FIXME("Dynamic linking not implemented yet.\n");
+    if (class_instance_count)
+        *class_instance_count = 0;
+
+    wined3d_mutex_lock();
+    if (!(wined3d_shader = wined3d_device_get_pixel_shader(device->wined3d_device)))
+    {
+        wined3d_mutex_unlock();
+        *shader = NULL;
+        return;
+    }
+
+    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    wined3d_mutex_unlock();
+    *shader = &shader_impl->ID3D11PixelShader_iface;
+    ID3D11PixelShader_AddRef(*shader);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetSamplers(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
@@ -1828,10 +1896,10 @@ static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetSamplers(ID3D11Device
     wined3d_mutex_lock();
     for (i = 0; i < sampler_count; ++i)
     {
-        struct d3d_sampler_state *sampler_impl;
         struct wined3d_sampler *wined3d_sampler;
+        struct d3d_sampler_state *sampler_impl;
 
-        if (!(wined3d_sampler = wined3d_device_get_gs_sampler(device->wined3d_device, start_slot + i)))
+        if (!(wined3d_sampler = wined3d_device_get_ps_sampler(device->wined3d_device, start_slot + i)))
         {
             samplers[i] = NULL;
             continue;
@@ -1844,249 +1912,186 @@ static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetSamplers(ID3D11Device
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetRenderTargets(ID3D11DeviceContext1 *iface,
-        UINT render_target_view_count, ID3D11RenderTargetView **render_target_views,
-        ID3D11DepthStencilView **depth_stencil_view)
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11VertexShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct wined3d_rendertarget_view *wined3d_view;
+    struct d3d_vertex_shader *shader_impl;
+    struct wined3d_shader *wined3d_shader;
 
-    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p.\n",
-            iface, render_target_view_count, render_target_views, depth_stencil_view);
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances || class_instance_count)
+        FIXME("Dynamic linking not implemented yet.\n");
+    if (class_instance_count)
+        *class_instance_count = 0;
 
     wined3d_mutex_lock();
-    if (render_target_views)
+    if (!(wined3d_shader = wined3d_device_get_vertex_shader(device->wined3d_device)))
     {
-        struct d3d_rendertarget_view *view_impl;
-        unsigned int i;
-
-        for (i = 0; i < render_target_view_count; ++i)
-        {
-            if (!(wined3d_view = wined3d_device_get_rendertarget_view(device->wined3d_device, i))
-                    || !(view_impl = wined3d_rendertarget_view_get_parent(wined3d_view)))
-            {
-                render_target_views[i] = NULL;
-                continue;
-            }
-
-            render_target_views[i] = &view_impl->ID3D11RenderTargetView_iface;
-            ID3D11RenderTargetView_AddRef(render_target_views[i]);
-        }
+        wined3d_mutex_unlock();
+        *shader = NULL;
+        return;
     }
 
-    if (depth_stencil_view)
-    {
-        struct d3d_depthstencil_view *view_impl;
-
-        if (!(wined3d_view = wined3d_device_get_depth_stencil_view(device->wined3d_device))
-                || !(view_impl = wined3d_rendertarget_view_get_parent(wined3d_view)))
-        {
-            *depth_stencil_view = NULL;
-        }
-        else
-        {
-            *depth_stencil_view = &view_impl->ID3D11DepthStencilView_iface;
-            ID3D11DepthStencilView_AddRef(*depth_stencil_view);
-        }
-    }
+    shader_impl = wined3d_shader_get_parent(wined3d_shader);
     wined3d_mutex_unlock();
+    *shader = &shader_impl->ID3D11VertexShader_iface;
+    ID3D11VertexShader_AddRef(*shader);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetRenderTargetsAndUnorderedAccessViews(
-        ID3D11DeviceContext1 *iface,
-        UINT render_target_view_count, ID3D11RenderTargetView **render_target_views,
-        ID3D11DepthStencilView **depth_stencil_view,
-        UINT unordered_access_view_start_slot, UINT unordered_access_view_count,
-        ID3D11UnorderedAccessView **unordered_access_views)
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct wined3d_unordered_access_view *wined3d_view;
-    struct d3d11_unordered_access_view *view_impl;
-    unsigned int i;
-
-    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
-            "unordered_access_view_start_slot %u, unordered_access_view_count %u, "
-            "unordered_access_views %p.\n",
-            iface, render_target_view_count, render_target_views, depth_stencil_view,
-            unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views);
-
-    if (render_target_views || depth_stencil_view)
-        d3d11_immediate_context_OMGetRenderTargets(iface, render_target_view_count,
-                render_target_views, depth_stencil_view);
-
-    if (unordered_access_views)
-    {
-        wined3d_mutex_lock();
-        for (i = 0; i < unordered_access_view_count; ++i)
-        {
-            if (!(wined3d_view = wined3d_device_get_unordered_access_view(device->wined3d_device,
-                    unordered_access_view_start_slot + i)))
-            {
-                unordered_access_views[i] = NULL;
-                continue;
-            }
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
 
-            view_impl = wined3d_unordered_access_view_get_parent(wined3d_view);
-            unordered_access_views[i] = &view_impl->ID3D11UnorderedAccessView_iface;
-            ID3D11UnorderedAccessView_AddRef(unordered_access_views[i]);
-        }
-        wined3d_mutex_unlock();
-    }
+    d3d11_immediate_context_get_constant_buffers(iface, WINED3D_SHADER_TYPE_PIXEL, start_slot,
+            buffer_count, buffers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetBlendState(ID3D11DeviceContext1 *iface,
-        ID3D11BlendState **blend_state, FLOAT blend_factor[4], UINT *sample_mask)
+static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetInputLayout(ID3D11DeviceContext1 *iface,
+        ID3D11InputLayout **input_layout)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct wined3d_blend_state *wined3d_state;
-    struct d3d_blend_state *blend_state_impl;
+    struct wined3d_vertex_declaration *wined3d_declaration;
+    struct d3d_input_layout *input_layout_impl;
 
-    TRACE("iface %p, blend_state %p, blend_factor %p, sample_mask %p.\n",
-            iface, blend_state, blend_factor, sample_mask);
+    TRACE("iface %p, input_layout %p.\n", iface, input_layout);
 
     wined3d_mutex_lock();
-    if ((wined3d_state = wined3d_device_get_blend_state(device->wined3d_device,
-            (struct wined3d_color *)blend_factor)))
-    {
-        blend_state_impl = wined3d_blend_state_get_parent(wined3d_state);
-        ID3D11BlendState_AddRef(*blend_state = &blend_state_impl->ID3D11BlendState_iface);
-    }
-    else
+    if (!(wined3d_declaration = wined3d_device_get_vertex_declaration(device->wined3d_device)))
     {
-        *blend_state = NULL;
+        wined3d_mutex_unlock();
+        *input_layout = NULL;
+        return;
     }
-    *sample_mask = wined3d_device_get_render_state(device->wined3d_device, WINED3D_RS_MULTISAMPLEMASK);
-    wined3d_mutex_unlock();
-}
-
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetDepthStencilState(ID3D11DeviceContext1 *iface,
-        ID3D11DepthStencilState **depth_stencil_state, UINT *stencil_ref)
-{
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-
-    TRACE("iface %p, depth_stencil_state %p, stencil_ref %p.\n",
-            iface, depth_stencil_state, stencil_ref);
 
-    if ((*depth_stencil_state = device->depth_stencil_state
-            ? &device->depth_stencil_state->ID3D11DepthStencilState_iface : NULL))
-        ID3D11DepthStencilState_AddRef(*depth_stencil_state);
-    *stencil_ref = device->stencil_ref;
+    input_layout_impl = wined3d_vertex_declaration_get_parent(wined3d_declaration);
+    wined3d_mutex_unlock();
+    *input_layout = &input_layout_impl->ID3D11InputLayout_iface;
+    ID3D11InputLayout_AddRef(*input_layout);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_SOGetTargets(ID3D11DeviceContext1 *iface,
-        UINT buffer_count, ID3D11Buffer **buffers)
+static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetVertexBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *strides, UINT *offsets)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
     unsigned int i;
 
-    TRACE("iface %p, buffer_count %u, buffers %p.\n", iface, buffer_count, buffers);
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p.\n",
+            iface, start_slot, buffer_count, buffers, strides, offsets);
 
     wined3d_mutex_lock();
     for (i = 0; i < buffer_count; ++i)
     {
-        struct wined3d_buffer *wined3d_buffer;
+        struct wined3d_buffer *wined3d_buffer = NULL;
         struct d3d_buffer *buffer_impl;
 
-        if (!(wined3d_buffer = wined3d_device_get_stream_output(device->wined3d_device, i, NULL)))
+        if (FAILED(wined3d_device_get_stream_source(device->wined3d_device, start_slot + i,
+                &wined3d_buffer, &offsets[i], &strides[i])))
+        {
+            FIXME("Failed to get vertex buffer %u.\n", start_slot + i);
+            if (strides)
+                strides[i] = 0;
+            if (offsets)
+                offsets[i] = 0;
+        }
+
+        if (!wined3d_buffer)
         {
             buffers[i] = NULL;
             continue;
         }
 
         buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
-        buffers[i] = &buffer_impl->ID3D11Buffer_iface;
-        ID3D11Buffer_AddRef(buffers[i]);
+        ID3D11Buffer_AddRef(buffers[i] = &buffer_impl->ID3D11Buffer_iface);
     }
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_RSGetState(ID3D11DeviceContext1 *iface,
-        ID3D11RasterizerState **rasterizer_state)
+static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetIndexBuffer(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer **buffer, DXGI_FORMAT *format, UINT *offset)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d_rasterizer_state *rasterizer_state_impl;
-    struct wined3d_rasterizer_state *wined3d_state;
+    enum wined3d_format_id wined3d_format;
+    struct wined3d_buffer *wined3d_buffer;
+    struct d3d_buffer *buffer_impl;
 
-    TRACE("iface %p, rasterizer_state %p.\n", iface, rasterizer_state);
+    TRACE("iface %p, buffer %p, format %p, offset %p.\n", iface, buffer, format, offset);
 
     wined3d_mutex_lock();
-    if ((wined3d_state = wined3d_device_get_rasterizer_state(device->wined3d_device)))
-    {
-        rasterizer_state_impl = wined3d_rasterizer_state_get_parent(wined3d_state);
-        ID3D11RasterizerState_AddRef(*rasterizer_state = &rasterizer_state_impl->ID3D11RasterizerState_iface);
-    }
-    else
+    wined3d_buffer = wined3d_device_get_index_buffer(device->wined3d_device, &wined3d_format, offset);
+    *format = dxgi_format_from_wined3dformat(wined3d_format);
+    if (!wined3d_buffer)
     {
-        *rasterizer_state = NULL;
+        wined3d_mutex_unlock();
+        *buffer = NULL;
+        return;
     }
+
+    buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
     wined3d_mutex_unlock();
+    ID3D11Buffer_AddRef(*buffer = &buffer_impl->ID3D11Buffer_iface);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_RSGetViewports(ID3D11DeviceContext1 *iface,
-        UINT *viewport_count, D3D11_VIEWPORT *viewports)
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    d3d11_immediate_context_get_constant_buffers(iface, WINED3D_SHADER_TYPE_GEOMETRY, start_slot,
+            buffer_count, buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11GeometryShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct wined3d_viewport wined3d_vp[WINED3D_MAX_VIEWPORTS];
-    unsigned int actual_count = ARRAY_SIZE(wined3d_vp), i;
+    struct d3d_geometry_shader *shader_impl;
+    struct wined3d_shader *wined3d_shader;
 
-    TRACE("iface %p, viewport_count %p, viewports %p.\n", iface, viewport_count, viewports);
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
 
-    if (!viewport_count)
-        return;
+    if (class_instances || class_instance_count)
+        FIXME("Dynamic linking not implemented yet.\n");
+    if (class_instance_count)
+        *class_instance_count = 0;
 
     wined3d_mutex_lock();
-    wined3d_device_get_viewports(device->wined3d_device, &actual_count, viewports ? wined3d_vp : NULL);
-    wined3d_mutex_unlock();
-
-    if (!viewports)
+    if (!(wined3d_shader = wined3d_device_get_geometry_shader(device->wined3d_device)))
     {
-        *viewport_count = actual_count;
+        wined3d_mutex_unlock();
+        *shader = NULL;
         return;
     }
 
-    if (*viewport_count > actual_count)
-        memset(&viewports[actual_count], 0, (*viewport_count - actual_count) * sizeof(*viewports));
-
-    *viewport_count = min(actual_count, *viewport_count);
-    for (i = 0; i < *viewport_count; ++i)
-    {
-        viewports[i].TopLeftX = wined3d_vp[i].x;
-        viewports[i].TopLeftY = wined3d_vp[i].y;
-        viewports[i].Width = wined3d_vp[i].width;
-        viewports[i].Height = wined3d_vp[i].height;
-        viewports[i].MinDepth = wined3d_vp[i].min_z;
-        viewports[i].MaxDepth = wined3d_vp[i].max_z;
-    }
+    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    wined3d_mutex_unlock();
+    *shader = &shader_impl->ID3D11GeometryShader_iface;
+    ID3D11GeometryShader_AddRef(*shader);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_RSGetScissorRects(ID3D11DeviceContext1 *iface,
-        UINT *rect_count, D3D11_RECT *rects)
+static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetPrimitiveTopology(ID3D11DeviceContext1 *iface,
+        D3D11_PRIMITIVE_TOPOLOGY *topology)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int actual_count;
-
-    TRACE("iface %p, rect_count %p, rects %p.\n", iface, rect_count, rects);
-
-    if (!rect_count)
-        return;
+    enum wined3d_primitive_type primitive_type;
+    unsigned int patch_vertex_count;
 
-    actual_count = *rect_count;
+    TRACE("iface %p, topology %p.\n", iface, topology);
 
     wined3d_mutex_lock();
-    wined3d_device_get_scissor_rects(device->wined3d_device, &actual_count, rects);
+    wined3d_device_get_primitive_type(device->wined3d_device, &primitive_type, &patch_vertex_count);
     wined3d_mutex_unlock();
 
-    if (!rects)
-    {
-        *rect_count = actual_count;
-        return;
-    }
-
-    if (*rect_count > actual_count)
-        memset(&rects[actual_count], 0, (*rect_count - actual_count) * sizeof(*rects));
+    d3d11_primitive_topology_from_wined3d_primitive_type(primitive_type, patch_vertex_count, topology);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetShaderResources(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetShaderResources(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
@@ -2100,47 +2105,98 @@ static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetShaderResources(ID3D1
         struct wined3d_shader_resource_view *wined3d_view;
         struct d3d_shader_resource_view *view_impl;
 
-        if (!(wined3d_view = wined3d_device_get_hs_resource_view(device->wined3d_device, start_slot + i)))
+        if (!(wined3d_view = wined3d_device_get_vs_resource_view(device->wined3d_device, start_slot + i)))
         {
             views[i] = NULL;
             continue;
         }
 
         view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
-        ID3D11ShaderResourceView_AddRef(views[i] = &view_impl->ID3D11ShaderResourceView_iface);
+        views[i] = &view_impl->ID3D11ShaderResourceView_iface;
+        ID3D11ShaderResourceView_AddRef(views[i]);
     }
     wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetShader(ID3D11DeviceContext1 *iface,
-        ID3D11HullShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d11_hull_shader *shader_impl;
-    struct wined3d_shader *wined3d_shader;
+    unsigned int i;
 
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
-            iface, shader, class_instances, class_instance_count);
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
 
-    if (class_instances || class_instance_count)
-        FIXME("Dynamic linking not implemented yet.\n");
-    if (class_instance_count)
-        *class_instance_count = 0;
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct wined3d_sampler *wined3d_sampler;
+        struct d3d_sampler_state *sampler_impl;
+
+        if (!(wined3d_sampler = wined3d_device_get_vs_sampler(device->wined3d_device, start_slot + i)))
+        {
+            samplers[i] = NULL;
+            continue;
+        }
+
+        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
+        samplers[i] = &sampler_impl->ID3D11SamplerState_iface;
+        ID3D11SamplerState_AddRef(samplers[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GetPredication(ID3D11DeviceContext1 *iface,
+        ID3D11Predicate **predicate, BOOL *value)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct wined3d_query *wined3d_predicate;
+    struct d3d_query *predicate_impl;
+
+    TRACE("iface %p, predicate %p, value %p.\n", iface, predicate, value);
 
     wined3d_mutex_lock();
-    if (!(wined3d_shader = wined3d_device_get_hull_shader(device->wined3d_device)))
+    if (!(wined3d_predicate = wined3d_device_get_predication(device->wined3d_device, value)))
     {
         wined3d_mutex_unlock();
-        *shader = NULL;
+        *predicate = NULL;
         return;
     }
 
-    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    predicate_impl = wined3d_query_get_parent(wined3d_predicate);
     wined3d_mutex_unlock();
-    ID3D11HullShader_AddRef(*shader = &shader_impl->ID3D11HullShader_iface);
+    *predicate = (ID3D11Predicate *)&predicate_impl->ID3D11Query_iface;
+    ID3D11Predicate_AddRef(*predicate);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetSamplers(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct wined3d_shader_resource_view *wined3d_view;
+        struct d3d_shader_resource_view *view_impl;
+
+        if (!(wined3d_view = wined3d_device_get_gs_resource_view(device->wined3d_device, start_slot + i)))
+        {
+            views[i] = NULL;
+            continue;
+        }
+
+        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
+        views[i] = &view_impl->ID3D11ShaderResourceView_iface;
+        ID3D11ShaderResourceView_AddRef(views[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetSamplers(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
 {
     struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
@@ -2152,394 +2208,2450 @@ static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetSamplers(ID3D11Device
     wined3d_mutex_lock();
     for (i = 0; i < sampler_count; ++i)
     {
-        struct wined3d_sampler *wined3d_sampler;
         struct d3d_sampler_state *sampler_impl;
+        struct wined3d_sampler *wined3d_sampler;
+
+        if (!(wined3d_sampler = wined3d_device_get_gs_sampler(device->wined3d_device, start_slot + i)))
+        {
+            samplers[i] = NULL;
+            continue;
+        }
+
+        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
+        samplers[i] = &sampler_impl->ID3D11SamplerState_iface;
+        ID3D11SamplerState_AddRef(samplers[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetRenderTargets(ID3D11DeviceContext1 *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView **render_target_views,
+        ID3D11DepthStencilView **depth_stencil_view)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct wined3d_rendertarget_view *wined3d_view;
+
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view);
+
+    wined3d_mutex_lock();
+    if (render_target_views)
+    {
+        struct d3d_rendertarget_view *view_impl;
+        unsigned int i;
+
+        for (i = 0; i < render_target_view_count; ++i)
+        {
+            if (!(wined3d_view = wined3d_device_get_rendertarget_view(device->wined3d_device, i))
+                    || !(view_impl = wined3d_rendertarget_view_get_parent(wined3d_view)))
+            {
+                render_target_views[i] = NULL;
+                continue;
+            }
+
+            render_target_views[i] = &view_impl->ID3D11RenderTargetView_iface;
+            ID3D11RenderTargetView_AddRef(render_target_views[i]);
+        }
+    }
+
+    if (depth_stencil_view)
+    {
+        struct d3d_depthstencil_view *view_impl;
+
+        if (!(wined3d_view = wined3d_device_get_depth_stencil_view(device->wined3d_device))
+                || !(view_impl = wined3d_rendertarget_view_get_parent(wined3d_view)))
+        {
+            *depth_stencil_view = NULL;
+        }
+        else
+        {
+            *depth_stencil_view = &view_impl->ID3D11DepthStencilView_iface;
+            ID3D11DepthStencilView_AddRef(*depth_stencil_view);
+        }
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetRenderTargetsAndUnorderedAccessViews(
+        ID3D11DeviceContext1 *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView **render_target_views,
+        ID3D11DepthStencilView **depth_stencil_view,
+        UINT unordered_access_view_start_slot, UINT unordered_access_view_count,
+        ID3D11UnorderedAccessView **unordered_access_views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct wined3d_unordered_access_view *wined3d_view;
+    struct d3d11_unordered_access_view *view_impl;
+    unsigned int i;
+
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
+            "unordered_access_view_start_slot %u, unordered_access_view_count %u, "
+            "unordered_access_views %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view,
+            unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views);
+
+    if (render_target_views || depth_stencil_view)
+        d3d11_immediate_context_OMGetRenderTargets(iface, render_target_view_count,
+                render_target_views, depth_stencil_view);
+
+    if (unordered_access_views)
+    {
+        wined3d_mutex_lock();
+        for (i = 0; i < unordered_access_view_count; ++i)
+        {
+            if (!(wined3d_view = wined3d_device_get_unordered_access_view(device->wined3d_device,
+                    unordered_access_view_start_slot + i)))
+            {
+                unordered_access_views[i] = NULL;
+                continue;
+            }
+
+            view_impl = wined3d_unordered_access_view_get_parent(wined3d_view);
+            unordered_access_views[i] = &view_impl->ID3D11UnorderedAccessView_iface;
+            ID3D11UnorderedAccessView_AddRef(unordered_access_views[i]);
+        }
+        wined3d_mutex_unlock();
+    }
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetBlendState(ID3D11DeviceContext1 *iface,
+        ID3D11BlendState **blend_state, FLOAT blend_factor[4], UINT *sample_mask)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct wined3d_blend_state *wined3d_state;
+    struct d3d_blend_state *blend_state_impl;
+
+    TRACE("iface %p, blend_state %p, blend_factor %p, sample_mask %p.\n",
+            iface, blend_state, blend_factor, sample_mask);
+
+    wined3d_mutex_lock();
+    if ((wined3d_state = wined3d_device_get_blend_state(device->wined3d_device,
+            (struct wined3d_color *)blend_factor)))
+    {
+        blend_state_impl = wined3d_blend_state_get_parent(wined3d_state);
+        ID3D11BlendState_AddRef(*blend_state = &blend_state_impl->ID3D11BlendState_iface);
+    }
+    else
+    {
+        *blend_state = NULL;
+    }
+    *sample_mask = wined3d_device_get_render_state(device->wined3d_device, WINED3D_RS_MULTISAMPLEMASK);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetDepthStencilState(ID3D11DeviceContext1 *iface,
+        ID3D11DepthStencilState **depth_stencil_state, UINT *stencil_ref)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, depth_stencil_state %p, stencil_ref %p.\n",
+            iface, depth_stencil_state, stencil_ref);
+
+    if ((*depth_stencil_state = device->depth_stencil_state
+            ? &device->depth_stencil_state->ID3D11DepthStencilState_iface : NULL))
+        ID3D11DepthStencilState_AddRef(*depth_stencil_state);
+    *stencil_ref = device->stencil_ref;
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_SOGetTargets(ID3D11DeviceContext1 *iface,
+        UINT buffer_count, ID3D11Buffer **buffers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    unsigned int i;
+
+    TRACE("iface %p, buffer_count %u, buffers %p.\n", iface, buffer_count, buffers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct wined3d_buffer *wined3d_buffer;
+        struct d3d_buffer *buffer_impl;
+
+        if (!(wined3d_buffer = wined3d_device_get_stream_output(device->wined3d_device, i, NULL)))
+        {
+            buffers[i] = NULL;
+            continue;
+        }
+
+        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
+        buffers[i] = &buffer_impl->ID3D11Buffer_iface;
+        ID3D11Buffer_AddRef(buffers[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_RSGetState(ID3D11DeviceContext1 *iface,
+        ID3D11RasterizerState **rasterizer_state)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct d3d_rasterizer_state *rasterizer_state_impl;
+    struct wined3d_rasterizer_state *wined3d_state;
+
+    TRACE("iface %p, rasterizer_state %p.\n", iface, rasterizer_state);
+
+    wined3d_mutex_lock();
+    if ((wined3d_state = wined3d_device_get_rasterizer_state(device->wined3d_device)))
+    {
+        rasterizer_state_impl = wined3d_rasterizer_state_get_parent(wined3d_state);
+        ID3D11RasterizerState_AddRef(*rasterizer_state = &rasterizer_state_impl->ID3D11RasterizerState_iface);
+    }
+    else
+    {
+        *rasterizer_state = NULL;
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_RSGetViewports(ID3D11DeviceContext1 *iface,
+        UINT *viewport_count, D3D11_VIEWPORT *viewports)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct wined3d_viewport wined3d_vp[WINED3D_MAX_VIEWPORTS];
+    unsigned int actual_count = ARRAY_SIZE(wined3d_vp), i;
+
+    TRACE("iface %p, viewport_count %p, viewports %p.\n", iface, viewport_count, viewports);
+
+    if (!viewport_count)
+        return;
+
+    wined3d_mutex_lock();
+    wined3d_device_get_viewports(device->wined3d_device, &actual_count, viewports ? wined3d_vp : NULL);
+    wined3d_mutex_unlock();
+
+    if (!viewports)
+    {
+        *viewport_count = actual_count;
+        return;
+    }
+
+    if (*viewport_count > actual_count)
+        memset(&viewports[actual_count], 0, (*viewport_count - actual_count) * sizeof(*viewports));
+
+    *viewport_count = min(actual_count, *viewport_count);
+    for (i = 0; i < *viewport_count; ++i)
+    {
+        viewports[i].TopLeftX = wined3d_vp[i].x;
+        viewports[i].TopLeftY = wined3d_vp[i].y;
+        viewports[i].Width = wined3d_vp[i].width;
+        viewports[i].Height = wined3d_vp[i].height;
+        viewports[i].MinDepth = wined3d_vp[i].min_z;
+        viewports[i].MaxDepth = wined3d_vp[i].max_z;
+    }
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_RSGetScissorRects(ID3D11DeviceContext1 *iface,
+        UINT *rect_count, D3D11_RECT *rects)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    unsigned int actual_count;
+
+    TRACE("iface %p, rect_count %p, rects %p.\n", iface, rect_count, rects);
+
+    if (!rect_count)
+        return;
+
+    actual_count = *rect_count;
+
+    wined3d_mutex_lock();
+    wined3d_device_get_scissor_rects(device->wined3d_device, &actual_count, rects);
+    wined3d_mutex_unlock();
+
+    if (!rects)
+    {
+        *rect_count = actual_count;
+        return;
+    }
+
+    if (*rect_count > actual_count)
+        memset(&rects[actual_count], 0, (*rect_count - actual_count) * sizeof(*rects));
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct wined3d_shader_resource_view *wined3d_view;
+        struct d3d_shader_resource_view *view_impl;
+
+        if (!(wined3d_view = wined3d_device_get_hs_resource_view(device->wined3d_device, start_slot + i)))
+        {
+            views[i] = NULL;
+            continue;
+        }
+
+        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
+        ID3D11ShaderResourceView_AddRef(views[i] = &view_impl->ID3D11ShaderResourceView_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11HullShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct d3d11_hull_shader *shader_impl;
+    struct wined3d_shader *wined3d_shader;
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances || class_instance_count)
+        FIXME("Dynamic linking not implemented yet.\n");
+    if (class_instance_count)
+        *class_instance_count = 0;
+
+    wined3d_mutex_lock();
+    if (!(wined3d_shader = wined3d_device_get_hull_shader(device->wined3d_device)))
+    {
+        wined3d_mutex_unlock();
+        *shader = NULL;
+        return;
+    }
+
+    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    wined3d_mutex_unlock();
+    ID3D11HullShader_AddRef(*shader = &shader_impl->ID3D11HullShader_iface);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct wined3d_sampler *wined3d_sampler;
+        struct d3d_sampler_state *sampler_impl;
+
+        if (!(wined3d_sampler = wined3d_device_get_hs_sampler(device->wined3d_device, start_slot + i)))
+        {
+            samplers[i] = NULL;
+            continue;
+        }
+
+        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
+        ID3D11SamplerState_AddRef(samplers[i] = &sampler_impl->ID3D11SamplerState_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    d3d11_immediate_context_get_constant_buffers(iface, WINED3D_SHADER_TYPE_HULL, start_slot,
+            buffer_count, buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct wined3d_shader_resource_view *wined3d_view;
+        struct d3d_shader_resource_view *view_impl;
+
+        if (!(wined3d_view = wined3d_device_get_ds_resource_view(device->wined3d_device, start_slot + i)))
+        {
+            views[i] = NULL;
+            continue;
+        }
+
+        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
+        ID3D11ShaderResourceView_AddRef(views[i] = &view_impl->ID3D11ShaderResourceView_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11DomainShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct d3d11_domain_shader *shader_impl;
+    struct wined3d_shader *wined3d_shader;
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances || class_instance_count)
+        FIXME("Dynamic linking not implemented yet.\n");
+    if (class_instance_count)
+        *class_instance_count = 0;
+
+    wined3d_mutex_lock();
+    if (!(wined3d_shader = wined3d_device_get_domain_shader(device->wined3d_device)))
+    {
+        wined3d_mutex_unlock();
+        *shader = NULL;
+        return;
+    }
+
+    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    wined3d_mutex_unlock();
+    ID3D11DomainShader_AddRef(*shader = &shader_impl->ID3D11DomainShader_iface);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct wined3d_sampler *wined3d_sampler;
+        struct d3d_sampler_state *sampler_impl;
+
+        if (!(wined3d_sampler = wined3d_device_get_ds_sampler(device->wined3d_device, start_slot + i)))
+        {
+            samplers[i] = NULL;
+            continue;
+        }
+
+        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
+        ID3D11SamplerState_AddRef(samplers[i] = &sampler_impl->ID3D11SamplerState_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    d3d11_immediate_context_get_constant_buffers(iface, WINED3D_SHADER_TYPE_DOMAIN, start_slot,
+            buffer_count, buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct wined3d_shader_resource_view *wined3d_view;
+        struct d3d_shader_resource_view *view_impl;
+
+        if (!(wined3d_view = wined3d_device_get_cs_resource_view(device->wined3d_device, start_slot + i)))
+        {
+            views[i] = NULL;
+            continue;
+        }
+
+        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
+        ID3D11ShaderResourceView_AddRef(views[i] = &view_impl->ID3D11ShaderResourceView_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetUnorderedAccessViews(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11UnorderedAccessView **views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct wined3d_unordered_access_view *wined3d_view;
+        struct d3d11_unordered_access_view *view_impl;
+
+        if (!(wined3d_view = wined3d_device_get_cs_uav(device->wined3d_device, start_slot + i)))
+        {
+            views[i] = NULL;
+            continue;
+        }
+
+        view_impl = wined3d_unordered_access_view_get_parent(wined3d_view);
+        ID3D11UnorderedAccessView_AddRef(views[i] = &view_impl->ID3D11UnorderedAccessView_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11ComputeShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    struct d3d11_compute_shader *shader_impl;
+    struct wined3d_shader *wined3d_shader;
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances || class_instance_count)
+        FIXME("Dynamic linking not implemented yet.\n");
+    if (class_instance_count)
+        *class_instance_count = 0;
+
+    wined3d_mutex_lock();
+    if (!(wined3d_shader = wined3d_device_get_compute_shader(device->wined3d_device)))
+    {
+        wined3d_mutex_unlock();
+        *shader = NULL;
+        return;
+    }
+
+    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    wined3d_mutex_unlock();
+    ID3D11ComputeShader_AddRef(*shader = &shader_impl->ID3D11ComputeShader_iface);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct wined3d_sampler *wined3d_sampler;
+        struct d3d_sampler_state *sampler_impl;
+
+        if (!(wined3d_sampler = wined3d_device_get_cs_sampler(device->wined3d_device, start_slot + i)))
+        {
+            samplers[i] = NULL;
+            continue;
+        }
+
+        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
+        ID3D11SamplerState_AddRef(samplers[i] = &sampler_impl->ID3D11SamplerState_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    d3d11_immediate_context_get_constant_buffers(iface, WINED3D_SHADER_TYPE_COMPUTE, start_slot,
+            buffer_count, buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_ClearState(ID3D11DeviceContext1 *iface)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
+    unsigned int i;
+
+    TRACE("iface %p.\n", iface);
+
+    wined3d_mutex_lock();
+    d3d11_context_clear_state(&device->immediate_context.target);
+    device->depth_stencil_state = NULL;
+    device->stencil_ref = 0;
+    for (i = 0; i < D3D11_PS_CS_UAV_REGISTER_COUNT; ++i)
+    {
+        wined3d_device_set_unordered_access_view(device->wined3d_device, i, NULL, ~0u);
+        wined3d_device_set_cs_uav(device->wined3d_device, i, NULL, ~0u);
+    }
+    for (i = 0; i < D3D11_SO_BUFFER_SLOT_COUNT; ++i)
+    {
+        wined3d_device_set_stream_output(device->wined3d_device, i, NULL, 0);
+    }
+    wined3d_device_set_predication(device->wined3d_device, NULL, FALSE);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_Flush(ID3D11DeviceContext1 *iface)
+{
+    FIXME("iface %p stub!\n", iface);
+}
+
+static D3D11_DEVICE_CONTEXT_TYPE STDMETHODCALLTYPE d3d11_immediate_context_GetType(ID3D11DeviceContext1 *iface)
+{
+    TRACE("iface %p.\n", iface);
+
+    return D3D11_DEVICE_CONTEXT_IMMEDIATE;
+}
+
+static UINT STDMETHODCALLTYPE d3d11_immediate_context_GetContextFlags(ID3D11DeviceContext1 *iface)
+{
+    FIXME("iface %p stub!\n", iface);
+
+    return 0;
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_FinishCommandList(ID3D11DeviceContext1 *iface,
+        BOOL restore, ID3D11CommandList **command_list)
+{
+    FIXME("iface %p, restore %#x, command_list %p stub!\n", iface, restore, command_list);
+
+    return E_NOTIMPL;
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CopySubresourceRegion1(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *dst_resource, UINT dst_subresource_idx, UINT dst_x, UINT dst_y, UINT dst_z,
+        ID3D11Resource *src_resource, UINT src_subresource_idx, const D3D11_BOX *src_box, UINT flags)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
+            "src_resource %p, src_subresource_idx %u, src_box %p, flags %#x.\n",
+            iface, dst_resource, dst_subresource_idx, dst_x, dst_y, dst_z,
+            src_resource, src_subresource_idx, src_box, flags);
+
+    wined3d_mutex_lock();
+    d3d11_context_copy_subresource_region(&context->target, dst_resource, dst_subresource_idx,
+            dst_x, dst_y, dst_z, src_resource, src_subresource_idx, src_box, flags);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_UpdateSubresource1(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *resource, UINT subresource_idx, const D3D11_BOX *box, const void *data,
+        UINT row_pitch, UINT depth_pitch, UINT flags)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, resource %p, subresource_idx %u, box %p, data %p, row_pitch %u, depth_pitch %u, flags %#x.\n",
+            iface, resource, subresource_idx, box, data, row_pitch, depth_pitch, flags);
+
+    wined3d_mutex_lock();
+    d3d11_context_update_subresource(&context->target, resource, subresource_idx, box,
+            data, row_pitch, depth_pitch, flags);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DiscardResource(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *resource)
+{
+    FIXME("iface %p, resource %p stub!\n", iface, resource);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DiscardView(ID3D11DeviceContext1 *iface, ID3D11View *view)
+{
+    FIXME("iface %p, view %p stub!\n", iface, view);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
+        const UINT *num_constants)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
+        const UINT *num_constants)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
+        const UINT *num_constants)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
+        const UINT *num_constants)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
+        const UINT *num_constants)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
+        const UINT *num_constants)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+            iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_SwapDeviceContextState(ID3D11DeviceContext1 *iface,
+        ID3DDeviceContextState *state, ID3DDeviceContextState **prev_state)
+{
+    FIXME("iface %p, state %p, prev_state %p stub!\n", iface, state, prev_state);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_ClearView(ID3D11DeviceContext1 *iface, ID3D11View *view,
+        const FLOAT color[4], const D3D11_RECT *rect, UINT num_rects)
+{
+    FIXME("iface %p, view %p, color %p, rect %p, num_rects %u stub!\n", iface, view, color, rect, num_rects);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DiscardView1(ID3D11DeviceContext1 *iface, ID3D11View *view,
+        const D3D11_RECT *rects, UINT num_rects)
+{
+    FIXME("iface %p, view %p, rects %p, num_rects %u stub!\n", iface, view, rects, num_rects);
+}
+
+static const struct ID3D11DeviceContext1Vtbl d3d11_immediate_context_vtbl =
+{
+    /* IUnknown methods */
+    d3d11_immediate_context_QueryInterface,
+    d3d11_immediate_context_AddRef,
+    d3d11_immediate_context_Release,
+    /* ID3D11DeviceChild methods */
+    d3d11_immediate_context_GetDevice,
+    d3d11_immediate_context_GetPrivateData,
+    d3d11_immediate_context_SetPrivateData,
+    d3d11_immediate_context_SetPrivateDataInterface,
+    /* ID3D11DeviceContext methods */
+    d3d11_immediate_context_VSSetConstantBuffers,
+    d3d11_immediate_context_PSSetShaderResources,
+    d3d11_immediate_context_PSSetShader,
+    d3d11_immediate_context_PSSetSamplers,
+    d3d11_immediate_context_VSSetShader,
+    d3d11_immediate_context_DrawIndexed,
+    d3d11_immediate_context_Draw,
+    d3d11_immediate_context_Map,
+    d3d11_immediate_context_Unmap,
+    d3d11_immediate_context_PSSetConstantBuffers,
+    d3d11_immediate_context_IASetInputLayout,
+    d3d11_immediate_context_IASetVertexBuffers,
+    d3d11_immediate_context_IASetIndexBuffer,
+    d3d11_immediate_context_DrawIndexedInstanced,
+    d3d11_immediate_context_DrawInstanced,
+    d3d11_immediate_context_GSSetConstantBuffers,
+    d3d11_immediate_context_GSSetShader,
+    d3d11_immediate_context_IASetPrimitiveTopology,
+    d3d11_immediate_context_VSSetShaderResources,
+    d3d11_immediate_context_VSSetSamplers,
+    d3d11_immediate_context_Begin,
+    d3d11_immediate_context_End,
+    d3d11_immediate_context_GetData,
+    d3d11_immediate_context_SetPredication,
+    d3d11_immediate_context_GSSetShaderResources,
+    d3d11_immediate_context_GSSetSamplers,
+    d3d11_immediate_context_OMSetRenderTargets,
+    d3d11_immediate_context_OMSetRenderTargetsAndUnorderedAccessViews,
+    d3d11_immediate_context_OMSetBlendState,
+    d3d11_immediate_context_OMSetDepthStencilState,
+    d3d11_immediate_context_SOSetTargets,
+    d3d11_immediate_context_DrawAuto,
+    d3d11_immediate_context_DrawIndexedInstancedIndirect,
+    d3d11_immediate_context_DrawInstancedIndirect,
+    d3d11_immediate_context_Dispatch,
+    d3d11_immediate_context_DispatchIndirect,
+    d3d11_immediate_context_RSSetState,
+    d3d11_immediate_context_RSSetViewports,
+    d3d11_immediate_context_RSSetScissorRects,
+    d3d11_immediate_context_CopySubresourceRegion,
+    d3d11_immediate_context_CopyResource,
+    d3d11_immediate_context_UpdateSubresource,
+    d3d11_immediate_context_CopyStructureCount,
+    d3d11_immediate_context_ClearRenderTargetView,
+    d3d11_immediate_context_ClearUnorderedAccessViewUint,
+    d3d11_immediate_context_ClearUnorderedAccessViewFloat,
+    d3d11_immediate_context_ClearDepthStencilView,
+    d3d11_immediate_context_GenerateMips,
+    d3d11_immediate_context_SetResourceMinLOD,
+    d3d11_immediate_context_GetResourceMinLOD,
+    d3d11_immediate_context_ResolveSubresource,
+    d3d11_immediate_context_ExecuteCommandList,
+    d3d11_immediate_context_HSSetShaderResources,
+    d3d11_immediate_context_HSSetShader,
+    d3d11_immediate_context_HSSetSamplers,
+    d3d11_immediate_context_HSSetConstantBuffers,
+    d3d11_immediate_context_DSSetShaderResources,
+    d3d11_immediate_context_DSSetShader,
+    d3d11_immediate_context_DSSetSamplers,
+    d3d11_immediate_context_DSSetConstantBuffers,
+    d3d11_immediate_context_CSSetShaderResources,
+    d3d11_immediate_context_CSSetUnorderedAccessViews,
+    d3d11_immediate_context_CSSetShader,
+    d3d11_immediate_context_CSSetSamplers,
+    d3d11_immediate_context_CSSetConstantBuffers,
+    d3d11_immediate_context_VSGetConstantBuffers,
+    d3d11_immediate_context_PSGetShaderResources,
+    d3d11_immediate_context_PSGetShader,
+    d3d11_immediate_context_PSGetSamplers,
+    d3d11_immediate_context_VSGetShader,
+    d3d11_immediate_context_PSGetConstantBuffers,
+    d3d11_immediate_context_IAGetInputLayout,
+    d3d11_immediate_context_IAGetVertexBuffers,
+    d3d11_immediate_context_IAGetIndexBuffer,
+    d3d11_immediate_context_GSGetConstantBuffers,
+    d3d11_immediate_context_GSGetShader,
+    d3d11_immediate_context_IAGetPrimitiveTopology,
+    d3d11_immediate_context_VSGetShaderResources,
+    d3d11_immediate_context_VSGetSamplers,
+    d3d11_immediate_context_GetPredication,
+    d3d11_immediate_context_GSGetShaderResources,
+    d3d11_immediate_context_GSGetSamplers,
+    d3d11_immediate_context_OMGetRenderTargets,
+    d3d11_immediate_context_OMGetRenderTargetsAndUnorderedAccessViews,
+    d3d11_immediate_context_OMGetBlendState,
+    d3d11_immediate_context_OMGetDepthStencilState,
+    d3d11_immediate_context_SOGetTargets,
+    d3d11_immediate_context_RSGetState,
+    d3d11_immediate_context_RSGetViewports,
+    d3d11_immediate_context_RSGetScissorRects,
+    d3d11_immediate_context_HSGetShaderResources,
+    d3d11_immediate_context_HSGetShader,
+    d3d11_immediate_context_HSGetSamplers,
+    d3d11_immediate_context_HSGetConstantBuffers,
+    d3d11_immediate_context_DSGetShaderResources,
+    d3d11_immediate_context_DSGetShader,
+    d3d11_immediate_context_DSGetSamplers,
+    d3d11_immediate_context_DSGetConstantBuffers,
+    d3d11_immediate_context_CSGetShaderResources,
+    d3d11_immediate_context_CSGetUnorderedAccessViews,
+    d3d11_immediate_context_CSGetShader,
+    d3d11_immediate_context_CSGetSamplers,
+    d3d11_immediate_context_CSGetConstantBuffers,
+    d3d11_immediate_context_ClearState,
+    d3d11_immediate_context_Flush,
+    d3d11_immediate_context_GetType,
+    d3d11_immediate_context_GetContextFlags,
+    d3d11_immediate_context_FinishCommandList,
+    /* ID3D11DeviceContext1 methods */
+    d3d11_immediate_context_CopySubresourceRegion1,
+    d3d11_immediate_context_UpdateSubresource1,
+    d3d11_immediate_context_DiscardResource,
+    d3d11_immediate_context_DiscardView,
+    d3d11_immediate_context_VSSetConstantBuffers1,
+    d3d11_immediate_context_HSSetConstantBuffers1,
+    d3d11_immediate_context_DSSetConstantBuffers1,
+    d3d11_immediate_context_GSSetConstantBuffers1,
+    d3d11_immediate_context_PSSetConstantBuffers1,
+    d3d11_immediate_context_CSSetConstantBuffers1,
+    d3d11_immediate_context_VSGetConstantBuffers1,
+    d3d11_immediate_context_HSGetConstantBuffers1,
+    d3d11_immediate_context_DSGetConstantBuffers1,
+    d3d11_immediate_context_GSGetConstantBuffers1,
+    d3d11_immediate_context_PSGetConstantBuffers1,
+    d3d11_immediate_context_CSGetConstantBuffers1,
+    d3d11_immediate_context_SwapDeviceContextState,
+    d3d11_immediate_context_ClearView,
+    d3d11_immediate_context_DiscardView1,
+};
+
+/* ID3D11Multithread methods */
+
+static inline struct d3d11_immediate_context *impl_from_ID3D11Multithread(ID3D11Multithread *iface)
+{
+    return CONTAINING_RECORD(iface, struct d3d11_immediate_context, ID3D11Multithread_iface);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_multithread_QueryInterface(ID3D11Multithread *iface,
+        REFIID iid, void **out)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11Multithread(iface);
+
+    TRACE("iface %p, iid %s, out %p.\n", iface, debugstr_guid(iid), out);
+
+    return d3d11_immediate_context_QueryInterface(&context->ID3D11DeviceContext1_iface, iid, out);
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_multithread_AddRef(ID3D11Multithread *iface)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11Multithread(iface);
+
+    TRACE("iface %p.\n", iface);
+
+    return d3d11_immediate_context_AddRef(&context->ID3D11DeviceContext1_iface);
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_multithread_Release(ID3D11Multithread *iface)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11Multithread(iface);
+
+    TRACE("iface %p.\n", iface);
+
+    return d3d11_immediate_context_Release(&context->ID3D11DeviceContext1_iface);
+}
+
+static void STDMETHODCALLTYPE d3d11_multithread_Enter(ID3D11Multithread *iface)
+{
+    TRACE("iface %p.\n", iface);
+
+    wined3d_mutex_lock();
+}
+
+static void STDMETHODCALLTYPE d3d11_multithread_Leave(ID3D11Multithread *iface)
+{
+    TRACE("iface %p.\n", iface);
+
+    wined3d_mutex_unlock();
+}
+
+static BOOL STDMETHODCALLTYPE d3d11_multithread_SetMultithreadProtected(
+        ID3D11Multithread *iface, BOOL enable)
+{
+    FIXME("iface %p, enable %#x stub!\n", iface, enable);
+
+    return TRUE;
+}
+
+static BOOL STDMETHODCALLTYPE d3d11_multithread_GetMultithreadProtected(ID3D11Multithread *iface)
+{
+    FIXME("iface %p stub!\n", iface);
+
+    return TRUE;
+}
+
+static const struct ID3D11MultithreadVtbl d3d11_multithread_vtbl =
+{
+    d3d11_multithread_QueryInterface,
+    d3d11_multithread_AddRef,
+    d3d11_multithread_Release,
+    d3d11_multithread_Enter,
+    d3d11_multithread_Leave,
+    d3d11_multithread_SetMultithreadProtected,
+    d3d11_multithread_GetMultithreadProtected,
+};
+
+static void d3d11_immediate_context_init(struct d3d11_immediate_context *context, struct d3d_device *device)
+{
+    context->ID3D11DeviceContext1_iface.lpVtbl = &d3d11_immediate_context_vtbl;
+    context->ID3D11Multithread_iface.lpVtbl = &d3d11_multithread_vtbl;
+    context->refcount = 1;
+
+    ID3D11Device2_AddRef(&device->ID3D11Device2_iface);
+
+    wined3d_private_store_init(&context->private_store);
+}
+
+static void d3d11_immediate_context_destroy(struct d3d11_immediate_context *context)
+{
+    wined3d_private_store_cleanup(&context->private_store);
+}
+
+/* ID3D11CommandList methods */
+
+static inline struct d3d11_command_list *impl_from_ID3D11CommandList(ID3D11CommandList *iface)
+{
+    return CONTAINING_RECORD(iface, struct d3d11_command_list, ID3D11CommandList_iface);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_QueryInterface(ID3D11CommandList *iface,
+        REFIID iid, void **out)
+{
+    TRACE("iface %p, iid %s, out %p.\n", iface, debugstr_guid(iid), out);
+
+    if (IsEqualGUID(iid, &IID_ID3D11CommandList)
+            || IsEqualGUID(iid, &IID_ID3D11DeviceChild)
+            || IsEqualGUID(iid, &IID_IUnknown))
+    {
+        ID3D11CommandList_AddRef(iface);
+        *out = iface;
+        return S_OK;
+    }
+
+    WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(iid));
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_command_list_AddRef(ID3D11CommandList *iface)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+    ULONG refcount = InterlockedIncrement(&list->refcount);
+
+    TRACE("%p increasing refcount to %u.\n", list, refcount);
+
+    return refcount;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_command_list_Release(ID3D11CommandList *iface)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+    ULONG refcount = InterlockedDecrement(&list->refcount);
+
+    TRACE("%p decreasing refcount to %u.\n", list, refcount);
+
+    if (!refcount)
+    {
+        wined3d_mutex_lock();
+        wined3d_command_list_decref(list->wined3d_list);
+        wined3d_mutex_unlock();
+        wined3d_private_store_cleanup(&list->private_store);
+        ID3D11Device2_Release(list->device);
+        heap_free(list);
+    }
+
+    return refcount;
+}
+
+static void STDMETHODCALLTYPE d3d11_command_list_GetDevice(ID3D11CommandList *iface, ID3D11Device **device)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, device %p.\n", iface, device);
+
+    *device = (ID3D11Device *)list->device;
+    ID3D11Device_AddRef(*device);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_GetPrivateData(ID3D11CommandList *iface, REFGUID guid,
+        UINT *data_size, void *data)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_get_private_data(&list->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_SetPrivateData(ID3D11CommandList *iface, REFGUID guid,
+        UINT data_size, const void *data)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_set_private_data(&list->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_SetPrivateDataInterface(ID3D11CommandList *iface,
+        REFGUID guid, const IUnknown *data)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
+
+    return d3d_set_private_data_interface(&list->private_store, guid, data);
+}
+
+static UINT STDMETHODCALLTYPE d3d11_command_list_GetContextFlags(ID3D11CommandList *iface)
+{
+    TRACE("iface %p.\n", iface);
+
+    return 0;
+}
+
+static const struct ID3D11CommandListVtbl d3d11_command_list_vtbl =
+{
+    /* IUnknown methods */
+    d3d11_command_list_QueryInterface,
+    d3d11_command_list_AddRef,
+    d3d11_command_list_Release,
+    /* ID3D11DeviceChild methods */
+    d3d11_command_list_GetDevice,
+    d3d11_command_list_GetPrivateData,
+    d3d11_command_list_SetPrivateData,
+    d3d11_command_list_SetPrivateDataInterface,
+    /* ID3D11CommandList methods */
+    d3d11_command_list_GetContextFlags,
+};
+
+struct d3d11_command_list *unsafe_impl_from_ID3D11CommandList(ID3D11CommandList *iface)
+{
+    if (!iface)
+        return NULL;
+    assert(iface->lpVtbl == &d3d11_command_list_vtbl);
+    return impl_from_ID3D11CommandList(iface);
+}
+
+/* ID3D11DeviceContext - deferred context methods */
+
+static inline struct d3d11_deferred_context *impl_from_deferred_ID3D11DeviceContext1(ID3D11DeviceContext1 *iface)
+{
+    return CONTAINING_RECORD(iface, struct d3d11_deferred_context, ID3D11DeviceContext1_iface);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_QueryInterface(ID3D11DeviceContext1 *iface,
+        REFIID iid, void **out)
+{
+    TRACE("iface %p, iid %s, out %p.\n", iface, debugstr_guid(iid), out);
+
+    if (IsEqualGUID(iid, &IID_ID3D11DeviceContext1)
+            || IsEqualGUID(iid, &IID_ID3D11DeviceContext)
+            || IsEqualGUID(iid, &IID_ID3D11DeviceChild)
+            || IsEqualGUID(iid, &IID_IUnknown))
+    {
+        ID3D11DeviceContext1_AddRef(iface);
+        *out = iface;
+        return S_OK;
+    }
+
+    WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(iid));
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_deferred_context_AddRef(ID3D11DeviceContext1 *iface)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+    ULONG refcount = InterlockedIncrement(&context->refcount);
+
+    TRACE("%p increasing refcount to %u.\n", context, refcount);
+
+    return refcount;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_deferred_context_Release(ID3D11DeviceContext1 *iface)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+    ULONG refcount = InterlockedDecrement(&context->refcount);
+
+    TRACE("%p decreasing refcount to %u.\n", context, refcount);
+
+    if (!refcount)
+    {
+        wined3d_mutex_lock();
+        wined3d_deferred_context_destroy(context->target.deferred);
+        wined3d_mutex_unlock();
+        wined3d_private_store_cleanup(&context->private_store);
+        ID3D11Device2_Release(&context->device->ID3D11Device2_iface);
+        heap_free(context);
+    }
+
+    return refcount;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GetDevice(ID3D11DeviceContext1 *iface, ID3D11Device **device)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, device %p.\n", iface, device);
+
+    *device = (ID3D11Device *)&context->device->ID3D11Device2_iface;
+    ID3D11Device_AddRef(*device);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_GetPrivateData(ID3D11DeviceContext1 *iface, REFGUID guid,
+        UINT *data_size, void *data)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_get_private_data(&context->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_SetPrivateData(ID3D11DeviceContext1 *iface, REFGUID guid,
+        UINT data_size, const void *data)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_set_private_data(&context->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_SetPrivateDataInterface(ID3D11DeviceContext1 *iface,
+        REFGUID guid, const IUnknown *data)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
+
+    return d3d_set_private_data_interface(&context->private_store, guid, data);
+}
+
+static void d3d11_deferred_context_set_constant_buffers(ID3D11DeviceContext1 *iface,
+        enum wined3d_shader_type type, UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    d3d11_context_set_constant_buffers(&context->target, type, start_slot, buffer_count, buffers);
+}
+
+static void d3d11_deferred_context_set_shader_resources(ID3D11DeviceContext1 *iface,
+        enum wined3d_shader_type type, UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    d3d11_context_set_shader_resources(&context->target, type, start_slot, view_count, views);
+}
+
+static void d3d11_deferred_context_set_samplers(ID3D11DeviceContext1 *iface,
+        enum wined3d_shader_type type, UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    d3d11_context_set_samplers(&context->target, type, start_slot, sampler_count, samplers);
+}
+
+static void d3d11_deferred_context_set_shader(ID3D11DeviceContext1 *iface, enum wined3d_shader_type type,
+        struct wined3d_shader *shader, ID3D11ClassInstance *const *class_instances)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    d3d11_context_set_shader(&context->target, type, shader, class_instances);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    d3d11_deferred_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_VERTEX, start_slot,
+            buffer_count, buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    d3d11_deferred_context_set_shader_resources(iface, WINED3D_SHADER_TYPE_PIXEL, start_slot,
+            view_count, views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11PixelShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d_pixel_shader *ps = unsafe_impl_from_ID3D11PixelShader(shader);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    d3d11_deferred_context_set_shader(iface, WINED3D_SHADER_TYPE_PIXEL,
+            ps ? ps->wined3d_shader : NULL, class_instances);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    d3d11_deferred_context_set_samplers(iface, WINED3D_SHADER_TYPE_PIXEL, start_slot,
+            sampler_count, samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11VertexShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d_vertex_shader *vs = unsafe_impl_from_ID3D11VertexShader(shader);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    d3d11_deferred_context_set_shader(iface, WINED3D_SHADER_TYPE_VERTEX,
+            vs ? vs->wined3d_shader : NULL, class_instances);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawIndexed(ID3D11DeviceContext1 *iface,
+        UINT index_count, UINT start_index_location, INT base_vertex_location)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, index_count %u, start_index_location %u, base_vertex_location %d.\n",
+            iface, index_count, start_index_location, base_vertex_location);
+
+    d3d11_target_draw(&context->target, base_vertex_location, start_index_location, index_count, 0, 0, TRUE);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Draw(ID3D11DeviceContext1 *iface,
+        UINT vertex_count, UINT start_vertex_location)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, vertex_count %u, start_vertex_location %u.\n",
+            iface, vertex_count, start_vertex_location);
+
+    d3d11_target_draw(&context->target, 0, start_vertex_location, vertex_count, 0, 0, FALSE);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_Map(ID3D11DeviceContext1 *iface, ID3D11Resource *resource,
+        UINT subresource_idx, D3D11_MAP map_type, UINT map_flags, D3D11_MAPPED_SUBRESOURCE *mapped_subresource)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+    struct wined3d_resource *wined3d_resource;
+    struct wined3d_map_desc map_desc;
+    HRESULT hr;
+
+    TRACE("iface %p, resource %p, subresource_idx %u, map_type %u, map_flags %#x, mapped_subresource %p.\n",
+            iface, resource, subresource_idx, map_type, map_flags, mapped_subresource);
+
+    if (map_type != D3D11_MAP_WRITE_DISCARD && map_type != D3D11_MAP_WRITE_NO_OVERWRITE)
+    {
+        WARN("Invalid map type %#x on a deferred context.\n", map_type);
+        memset(mapped_subresource, 0, sizeof(*mapped_subresource));
+        return E_INVALIDARG;
+    }
+
+    if (map_flags)
+        FIXME("Ignoring map_flags %#x.\n", map_flags);
+
+    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
+
+    if (FAILED(hr = wined3d_deferred_context_map(context->target.deferred, wined3d_resource, subresource_idx,
+            &map_desc, wined3d_map_flags_from_d3d11_map_type(map_type))))
+    {
+        memset(mapped_subresource, 0, sizeof(*mapped_subresource));
+        return hr;
+    }
+
+    mapped_subresource->pData = map_desc.data;
+    mapped_subresource->RowPitch = map_desc.row_pitch;
+    mapped_subresource->DepthPitch = map_desc.slice_pitch;
+
+    return S_OK;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Unmap(ID3D11DeviceContext1 *iface, ID3D11Resource *resource,
+        UINT subresource_idx)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+    struct wined3d_resource *wined3d_resource;
+
+    TRACE("iface %p, resource %p, subresource_idx %u.\n", iface, resource, subresource_idx);
+
+    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
+
+    wined3d_deferred_context_unmap(context->target.deferred, wined3d_resource, subresource_idx);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    d3d11_deferred_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_PIXEL, start_slot,
+            buffer_count, buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetInputLayout(ID3D11DeviceContext1 *iface,
+        ID3D11InputLayout *input_layout)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+    struct d3d_input_layout *layout = unsafe_impl_from_ID3D11InputLayout(input_layout);
+
+    TRACE("iface %p, input_layout %p.\n", iface, input_layout);
+
+    d3d11_target_set_vertex_declaration(&context->target, layout ? layout->wined3d_decl : NULL);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetVertexBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers, const UINT *strides, const UINT *offsets)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p.\n",
+            iface, start_slot, buffer_count, buffers, strides, offsets);
+
+    d3d11_context_set_vertex_buffers(&context->target, start_slot, buffer_count, buffers, strides, offsets);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetIndexBuffer(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *buffer, DXGI_FORMAT format, UINT offset)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+    struct d3d_buffer *buffer_impl = unsafe_impl_from_ID3D11Buffer(buffer);
+
+    TRACE("iface %p, buffer %p, format %s, offset %u.\n",
+            iface, buffer, debug_dxgi_format(format), offset);
+
+    d3d11_target_set_index_buffer(&context->target, buffer_impl ? buffer_impl->wined3d_buffer : NULL,
+            wined3dformat_from_dxgi_format(format), offset);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawIndexedInstanced(ID3D11DeviceContext1 *iface,
+        UINT instance_index_count, UINT instance_count, UINT start_index_location, INT base_vertex_location,
+        UINT start_instance_location)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, instance_index_count %u, instance_count %u, start_index_location %u, "
+            "base_vertex_location %d, start_instance_location %u.\n",
+            iface, instance_index_count, instance_count, start_index_location,
+            base_vertex_location, start_instance_location);
+
+    d3d11_target_draw(&context->target, base_vertex_location, start_index_location,
+            instance_index_count, start_instance_location, instance_count, TRUE);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawInstanced(ID3D11DeviceContext1 *iface,
+        UINT instance_vertex_count, UINT instance_count, UINT start_vertex_location, UINT start_instance_location)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, instance_vertex_count %u, instance_count %u, start_vertex_location %u, "
+            "start_instance_location %u.\n",
+            iface, instance_vertex_count, instance_count, start_vertex_location,
+            start_instance_location);
+
+    d3d11_target_draw(&context->target, 0, start_vertex_location,
+            instance_vertex_count, start_instance_location, instance_count, FALSE);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    d3d11_deferred_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_GEOMETRY, start_slot,
+            buffer_count, buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11GeometryShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d_geometry_shader *gs = unsafe_impl_from_ID3D11GeometryShader(shader);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    d3d11_deferred_context_set_shader(iface, WINED3D_SHADER_TYPE_GEOMETRY,
+            gs ? gs->wined3d_shader : NULL, class_instances);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetPrimitiveTopology(ID3D11DeviceContext1 *iface,
+        D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, topology %#x.\n", iface, topology);
+
+    d3d11_context_set_primitive_topology(&context->target, topology);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    d3d11_deferred_context_set_shader_resources(iface, WINED3D_SHADER_TYPE_VERTEX, start_slot,
+            view_count, views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    d3d11_deferred_context_set_samplers(iface, WINED3D_SHADER_TYPE_VERTEX, start_slot,
+            sampler_count, samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Begin(ID3D11DeviceContext1 *iface,
+        ID3D11Asynchronous *asynchronous)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+
+    d3d11_context_issue_query(&context->target, asynchronous, WINED3DISSUE_BEGIN);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_End(ID3D11DeviceContext1 *iface,
+        ID3D11Asynchronous *asynchronous)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+
+    d3d11_context_issue_query(&context->target, asynchronous, WINED3DISSUE_END);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_GetData(ID3D11DeviceContext1 *iface,
+        ID3D11Asynchronous *asynchronous, void *data, UINT data_size, UINT data_flags)
+{
+    FIXME("iface %p, asynchronous %p, data %p, data_size %u, data_flags %#x stub!\n",
+            iface, asynchronous, data, data_size, data_flags);
+
+    return E_NOTIMPL;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_SetPredication(ID3D11DeviceContext1 *iface,
+        ID3D11Predicate *predicate, BOOL value)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, predicate %p, value %#x.\n", iface, predicate, value);
+
+    d3d11_context_set_predication(&context->target, predicate, value);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    d3d11_deferred_context_set_shader_resources(iface, WINED3D_SHADER_TYPE_GEOMETRY, start_slot,
+            view_count, views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    d3d11_deferred_context_set_samplers(iface, WINED3D_SHADER_TYPE_GEOMETRY, start_slot,
+            sampler_count, samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetRenderTargets(ID3D11DeviceContext1 *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView *const *render_target_views,
+        ID3D11DepthStencilView *depth_stencil_view)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view);
+
+    d3d11_context_set_render_targets(&context->target, render_target_view_count, render_target_views,
+            depth_stencil_view);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetRenderTargetsAndUnorderedAccessViews(
+        ID3D11DeviceContext1 *iface, UINT render_target_view_count,
+        ID3D11RenderTargetView *const *render_target_views, ID3D11DepthStencilView *depth_stencil_view,
+        UINT unordered_access_view_start_slot, UINT unordered_access_view_count,
+        ID3D11UnorderedAccessView *const *unordered_access_views, const UINT *initial_counts)
+{
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
+            "unordered_access_view_start_slot %u, unordered_access_view_count %u, unordered_access_views %p, "
+            "initial_counts %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view,
+            unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views,
+            initial_counts);
+
+    if (render_target_view_count != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL)
+    {
+        d3d11_deferred_context_OMSetRenderTargets(iface, render_target_view_count, render_target_views,
+                depth_stencil_view);
+    }
+
+    if (unordered_access_view_count != D3D11_KEEP_UNORDERED_ACCESS_VIEWS)
+        FIXME("Unordered access views are not supported on deferred contexts.\n");
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetBlendState(ID3D11DeviceContext1 *iface,
+        ID3D11BlendState *blend_state, const float blend_factor[4], UINT sample_mask)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, blend_state %p, blend_factor %s, sample_mask 0x%08x.\n",
+            iface, blend_state, debug_float4(blend_factor), sample_mask);
+
+    d3d11_context_set_blend_state(&context->target, blend_state, blend_factor, sample_mask);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetDepthStencilState(ID3D11DeviceContext1 *iface,
+        ID3D11DepthStencilState *depth_stencil_state, UINT stencil_ref)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, depth_stencil_state %p, stencil_ref %u.\n",
+            iface, depth_stencil_state, stencil_ref);
+
+    d3d11_context_set_depth_stencil_state(&context->target,
+            unsafe_impl_from_ID3D11DepthStencilState(depth_stencil_state), stencil_ref);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_SOSetTargets(ID3D11DeviceContext1 *iface, UINT buffer_count,
+        ID3D11Buffer *const *buffers, const UINT *offsets)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, buffer_count %u, buffers %p, offsets %p.\n", iface, buffer_count, buffers, offsets);
+
+    d3d11_context_set_stream_output_targets(&context->target, buffer_count, buffers, offsets);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawAuto(ID3D11DeviceContext1 *iface)
+{
+    FIXME("iface %p stub!\n", iface);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawIndexedInstancedIndirect(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *buffer, UINT offset)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+
+    d3d11_context_draw_indirect(&context->target, buffer, offset, TRUE);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawInstancedIndirect(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *buffer, UINT offset)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+
+    d3d11_context_draw_indirect(&context->target, buffer, offset, FALSE);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Dispatch(ID3D11DeviceContext1 *iface,
+        UINT thread_group_count_x, UINT thread_group_count_y, UINT thread_group_count_z)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, thread_group_count_x %u, thread_group_count_y %u, thread_group_count_z %u.\n",
+            iface, thread_group_count_x, thread_group_count_y, thread_group_count_z);
+
+    d3d11_target_dispatch(&context->target, thread_group_count_x, thread_group_count_y, thread_group_count_z);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DispatchIndirect(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *buffer, UINT offset)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+
+    d3d11_context_dispatch_indirect(&context->target, buffer, offset);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSSetState(ID3D11DeviceContext1 *iface,
+        ID3D11RasterizerState *rasterizer_state)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, rasterizer_state %p.\n", iface, rasterizer_state);
+
+    d3d11_context_set_rasterizer_state(&context->target, rasterizer_state);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSSetViewports(ID3D11DeviceContext1 *iface,
+        UINT viewport_count, const D3D11_VIEWPORT *viewports)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, viewport_count %u, viewports %p.\n", iface, viewport_count, viewports);
+
+    d3d11_context_set_viewports(&context->target, viewport_count, viewports);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSSetScissorRects(ID3D11DeviceContext1 *iface,
+        UINT rect_count, const D3D11_RECT *rects)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, rect_count %u, rects %p.\n", iface, rect_count, rects);
+
+    d3d11_context_set_scissor_rects(&context->target, rect_count, rects);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CopySubresourceRegion(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *dst_resource, UINT dst_subresource_idx, UINT dst_x, UINT dst_y, UINT dst_z,
+        ID3D11Resource *src_resource, UINT src_subresource_idx, const D3D11_BOX *src_box)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
+            "src_resource %p, src_subresource_idx %u, src_box %p.\n",
+            iface, dst_resource, dst_subresource_idx, dst_x, dst_y, dst_z,
+            src_resource, src_subresource_idx, src_box);
+
+    d3d11_context_copy_subresource_region(&context->target, dst_resource, dst_subresource_idx,
+            dst_x, dst_y, dst_z, src_resource, src_subresource_idx, src_box, 0);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CopyResource(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *dst_resource, ID3D11Resource *src_resource)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, dst_resource %p, src_resource %p.\n", iface, dst_resource, src_resource);
+
+    d3d11_context_copy_resource(&context->target, dst_resource, src_resource);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_UpdateSubresource(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *resource, UINT subresource_idx, const D3D11_BOX *box,
+        const void *data, UINT row_pitch, UINT depth_pitch)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, resource %p, subresource_idx %u, box %p, data %p, row_pitch %u, depth_pitch %u.\n",
+            iface, resource, subresource_idx, box, data, row_pitch, depth_pitch);
+
+    d3d11_context_update_subresource(&context->target, resource, subresource_idx, box,
+            data, row_pitch, depth_pitch, 0);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CopyStructureCount(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer *dst_buffer, UINT dst_offset, ID3D11UnorderedAccessView *src_view)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, dst_buffer %p, dst_offset %u, src_view %p.\n",
+            iface, dst_buffer, dst_offset, src_view);
+
+    d3d11_context_copy_structure_count(&context->target, dst_buffer, dst_offset, src_view);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearRenderTargetView(ID3D11DeviceContext1 *iface,
+        ID3D11RenderTargetView *render_target_view, const float color_rgba[4])
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, render_target_view %p, color_rgba %s.\n",
+            iface, render_target_view, debug_float4(color_rgba));
+
+    d3d11_context_clear_render_target_view(&context->target, render_target_view, color_rgba);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearUnorderedAccessViewUint(ID3D11DeviceContext1 *iface,
+        ID3D11UnorderedAccessView *unordered_access_view, const UINT values[4])
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, unordered_access_view %p, values {%u, %u, %u, %u}.\n",
+            iface, unordered_access_view, values[0], values[1], values[2], values[3]);
+
+    d3d11_context_clear_unordered_access_view_uint(&context->target, unordered_access_view, values);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearUnorderedAccessViewFloat(ID3D11DeviceContext1 *iface,
+        ID3D11UnorderedAccessView *unordered_access_view, const float values[4])
+{
+    FIXME("iface %p, unordered_access_view %p, values %s stub!\n",
+            iface, unordered_access_view, debug_float4(values));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearDepthStencilView(ID3D11DeviceContext1 *iface,
+        ID3D11DepthStencilView *depth_stencil_view, UINT flags, FLOAT depth, UINT8 stencil)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, depth_stencil_view %p, flags %#x, depth %.8e, stencil %u.\n",
+            iface, depth_stencil_view, flags, depth, stencil);
+
+    d3d11_context_clear_depth_stencil_view(&context->target, depth_stencil_view, flags, depth, stencil);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GenerateMips(ID3D11DeviceContext1 *iface,
+        ID3D11ShaderResourceView *view)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+
+    TRACE("iface %p, view %p.\n", iface, view);
+
+    d3d11_context_generate_mips(&context->target, view);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_SetResourceMinLOD(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *resource, FLOAT min_lod)
+{
+    FIXME("iface %p, resource %p, min_lod %f stub!\n", iface, resource, min_lod);
+}
+
+static FLOAT STDMETHODCALLTYPE d3d11_deferred_context_GetResourceMinLOD(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *resource)
+{
+    FIXME("iface %p, resource %p stub!\n", iface, resource);
+
+    return 0.0f;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ResolveSubresource(ID3D11DeviceContext1 *iface,
+        ID3D11Resource *dst_resource, UINT dst_subresource_idx,
+        ID3D11Resource *src_resource, UINT src_subresource_idx,
+        DXGI_FORMAT format)
+{
+    FIXME("iface %p, dst_resource %p, dst_subresource_idx %u, "
+            "src_resource %p, src_subresource_idx %u, format %s stub!\n",
+            iface, dst_resource, dst_subresource_idx,
+            src_resource, src_subresource_idx, debug_dxgi_format(format));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ExecuteCommandList(ID3D11DeviceContext1 *iface,
+        ID3D11CommandList *command_list, BOOL restore_state)
+{
+    FIXME("iface %p, command_list %p, restore_state %#x stub!\n", iface, command_list, restore_state);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    d3d11_deferred_context_set_shader_resources(iface, WINED3D_SHADER_TYPE_HULL, start_slot,
+            view_count, views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11HullShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d11_hull_shader *hs = unsafe_impl_from_ID3D11HullShader(shader);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    d3d11_deferred_context_set_shader(iface, WINED3D_SHADER_TYPE_HULL,
+            hs ? hs->wined3d_shader : NULL, class_instances);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    d3d11_deferred_context_set_samplers(iface, WINED3D_SHADER_TYPE_HULL, start_slot,
+            sampler_count, samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    d3d11_deferred_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_HULL, start_slot,
+            buffer_count, buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    d3d11_deferred_context_set_shader_resources(iface, WINED3D_SHADER_TYPE_DOMAIN, start_slot,
+            view_count, views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11DomainShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d11_domain_shader *ds = unsafe_impl_from_ID3D11DomainShader(shader);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    d3d11_deferred_context_set_shader(iface, WINED3D_SHADER_TYPE_DOMAIN,
+            ds ? ds->wined3d_shader : NULL, class_instances);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    d3d11_deferred_context_set_samplers(iface, WINED3D_SHADER_TYPE_DOMAIN, start_slot,
+            sampler_count, samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    d3d11_deferred_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_DOMAIN, start_slot,
+            buffer_count, buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    d3d11_deferred_context_set_shader_resources(iface, WINED3D_SHADER_TYPE_COMPUTE, start_slot,
+            view_count, views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetUnorderedAccessViews(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11UnorderedAccessView *const *views, const UINT *initial_counts)
+{
+    FIXME("iface %p, start_slot %u, view_count %u, views %p, initial_counts %p stub!\n",
+            iface, start_slot, view_count, views, initial_counts);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetShader(ID3D11DeviceContext1 *iface,
+        ID3D11ComputeShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d11_compute_shader *cs = unsafe_impl_from_ID3D11ComputeShader(shader);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    d3d11_deferred_context_set_shader(iface, WINED3D_SHADER_TYPE_COMPUTE,
+            cs ? cs->wined3d_shader : NULL, class_instances);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    d3d11_deferred_context_set_samplers(iface, WINED3D_SHADER_TYPE_COMPUTE, start_slot,
+            sampler_count, samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    d3d11_deferred_context_set_constant_buffers(iface, WINED3D_SHADER_TYPE_COMPUTE, start_slot,
+            buffer_count, buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p semi-stub!\n",
+            iface, start_slot, buffer_count, buffers);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    FIXME("iface %p, start_slot %u, view_count %u, views %p semi-stub!\n",
+            iface, start_slot, view_count, views);
+
+    memset(views, 0, view_count * sizeof(*views));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11PixelShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    FIXME("iface %p, shader %p, class_instances %p, class_instance_count %p semi-stub!\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instance_count)
+        *class_instance_count = 0;
+    *shader = NULL;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    FIXME("iface %p, start_slot %u, sampler_count %u, samplers %p semi-stub!\n",
+            iface, start_slot, sampler_count, samplers);
+
+    memset(samplers, 0, sampler_count * sizeof(*samplers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11VertexShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    FIXME("iface %p, shader %p, class_instances %p, class_instance_count %p semi-stub!\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instance_count)
+        *class_instance_count = 0;
+    *shader = NULL;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p semi-stub!\n",
+            iface, start_slot, buffer_count, buffers);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetInputLayout(ID3D11DeviceContext1 *iface,
+        ID3D11InputLayout **input_layout)
+{
+    FIXME("iface %p, input_layout %p semi-stub!\n", iface, input_layout);
+
+    *input_layout = NULL;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetVertexBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *strides, UINT *offsets)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p semi-stub!\n",
+            iface, start_slot, buffer_count, buffers, strides, offsets);
+
+    if (buffers)
+        memset(buffers, 0, buffer_count * sizeof(*buffers));
+    if (strides)
+        memset(strides, 0, buffer_count * sizeof(*strides));
+    if (offsets)
+        memset(offsets, 0, buffer_count * sizeof(*offsets));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetIndexBuffer(ID3D11DeviceContext1 *iface,
+        ID3D11Buffer **buffer, DXGI_FORMAT *format, UINT *offset)
+{
+    FIXME("iface %p, buffer %p, format %p, offset %p semi-stub!\n", iface, buffer, format, offset);
+
+    *buffer = NULL;
+    *format = DXGI_FORMAT_UNKNOWN;
+    *offset = 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p semi-stub!\n",
+            iface, start_slot, buffer_count, buffers);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11GeometryShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    FIXME("iface %p, shader %p, class_instances %p, class_instance_count %p semi-stub!\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instance_count)
+        *class_instance_count = 0;
+    *shader = NULL;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetPrimitiveTopology(ID3D11DeviceContext1 *iface,
+        D3D11_PRIMITIVE_TOPOLOGY *topology)
+{
+    FIXME("iface %p, topology %p semi-stub!\n", iface, topology);
+
+    *topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    FIXME("iface %p, start_slot %u, view_count %u, views %p semi-stub!\n", iface, start_slot, view_count, views);
+
+    memset(views, 0, view_count * sizeof(*views));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    FIXME("iface %p, start_slot %u, sampler_count %u, samplers %p semi-stub!\n",
+            iface, start_slot, sampler_count, samplers);
+
+    memset(samplers, 0, sampler_count * sizeof(*samplers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GetPredication(ID3D11DeviceContext1 *iface,
+        ID3D11Predicate **predicate, BOOL *value)
+{
+    FIXME("iface %p, predicate %p, value %p semi-stub!\n", iface, predicate, value);
+
+    *predicate = NULL;
+    if (value)
+        *value = FALSE;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    FIXME("iface %p, start_slot %u, view_count %u, views %p semi-stub!\n", iface, start_slot, view_count, views);
+
+    memset(views, 0, view_count * sizeof(*views));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    FIXME("iface %p, start_slot %u, sampler_count %u, samplers %p semi-stub!\n",
+            iface, start_slot, sampler_count, samplers);
+
+    memset(samplers, 0, sampler_count * sizeof(*samplers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetRenderTargets(ID3D11DeviceContext1 *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView **render_target_views,
+        ID3D11DepthStencilView **depth_stencil_view)
+{
+    FIXME("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p semi-stub!\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view);
+
+    if (render_target_views)
+        memset(render_target_views, 0, render_target_view_count * sizeof(*render_target_views));
+    if (depth_stencil_view)
+        *depth_stencil_view = NULL;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetRenderTargetsAndUnorderedAccessViews(
+        ID3D11DeviceContext1 *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView **render_target_views,
+        ID3D11DepthStencilView **depth_stencil_view,
+        UINT unordered_access_view_start_slot, UINT unordered_access_view_count,
+        ID3D11UnorderedAccessView **unordered_access_views)
+{
+    FIXME("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
+            "unordered_access_view_start_slot %u, unordered_access_view_count %u, "
+            "unordered_access_views %p semi-stub!\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view,
+            unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views);
+
+    if (render_target_views)
+        memset(render_target_views, 0, render_target_view_count * sizeof(*render_target_views));
+    if (depth_stencil_view)
+        *depth_stencil_view = NULL;
+    if (unordered_access_views)
+        memset(unordered_access_views, 0, unordered_access_view_count * sizeof(*unordered_access_views));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetBlendState(ID3D11DeviceContext1 *iface,
+        ID3D11BlendState **blend_state, FLOAT blend_factor[4], UINT *sample_mask)
+{
+    FIXME("iface %p, blend_state %p, blend_factor %p, sample_mask %p semi-stub!\n",
+            iface, blend_state, blend_factor, sample_mask);
+
+    *blend_state = NULL;
+    blend_factor[0] = blend_factor[1] = blend_factor[2] = blend_factor[3] = 1.0f;
+    *sample_mask = D3D11_DEFAULT_SAMPLE_MASK;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetDepthStencilState(ID3D11DeviceContext1 *iface,
+        ID3D11DepthStencilState **depth_stencil_state, UINT *stencil_ref)
+{
+    FIXME("iface %p, depth_stencil_state %p, stencil_ref %p semi-stub!\n",
+            iface, depth_stencil_state, stencil_ref);
+
+    *depth_stencil_state = NULL;
+    *stencil_ref = 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_SOGetTargets(ID3D11DeviceContext1 *iface,
+        UINT buffer_count, ID3D11Buffer **buffers)
+{
+    FIXME("iface %p, buffer_count %u, buffers %p semi-stub!\n", iface, buffer_count, buffers);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSGetState(ID3D11DeviceContext1 *iface,
+        ID3D11RasterizerState **rasterizer_state)
+{
+    FIXME("iface %p, rasterizer_state %p semi-stub!\n", iface, rasterizer_state);
+
+    *rasterizer_state = NULL;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSGetViewports(ID3D11DeviceContext1 *iface,
+        UINT *viewport_count, D3D11_VIEWPORT *viewports)
+{
+    FIXME("iface %p, viewport_count %p, viewports %p semi-stub!\n", iface, viewport_count, viewports);
+
+    if (!viewport_count)
+        return;
+    if (viewports)
+        memset(viewports, 0, *viewport_count * sizeof(*viewports));
+    *viewport_count = 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSGetScissorRects(ID3D11DeviceContext1 *iface,
+        UINT *rect_count, D3D11_RECT *rects)
+{
+    FIXME("iface %p, rect_count %p, rects %p semi-stub!\n", iface, rect_count, rects);
+
+    if (!rect_count)
+        return;
+    if (rects)
+        memset(rects, 0, *rect_count * sizeof(*rects));
+    *rect_count = 0;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetShaderResources(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    FIXME("iface %p, start_slot %u, view_count %u, views %p semi-stub!\n", iface, start_slot, view_count, views);
+
+    memset(views, 0, view_count * sizeof(*views));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetShader(ID3D11DeviceContext1 *iface,
+        ID3D11HullShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    FIXME("iface %p, shader %p, class_instances %p, class_instance_count %p semi-stub!\n",
+            iface, shader, class_instances, class_instance_count);
 
-        if (!(wined3d_sampler = wined3d_device_get_hs_sampler(device->wined3d_device, start_slot + i)))
-        {
-            samplers[i] = NULL;
-            continue;
-        }
+    if (class_instance_count)
+        *class_instance_count = 0;
+    *shader = NULL;
+}
 
-        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
-        ID3D11SamplerState_AddRef(samplers[i] = &sampler_impl->ID3D11SamplerState_iface);
-    }
-    wined3d_mutex_unlock();
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetSamplers(ID3D11DeviceContext1 *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    FIXME("iface %p, start_slot %u, sampler_count %u, samplers %p semi-stub!\n",
+            iface, start_slot, sampler_count, samplers);
+
+    memset(samplers, 0, sampler_count * sizeof(*samplers));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetConstantBuffers(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
 {
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p semi-stub!\n",
             iface, start_slot, buffer_count, buffers);
 
-    d3d11_immediate_context_get_constant_buffers(iface, WINED3D_SHADER_TYPE_HULL, start_slot,
-            buffer_count, buffers);
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetShaderResources(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetShaderResources(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+    FIXME("iface %p, start_slot %u, view_count %u, views %p semi-stub!\n",
             iface, start_slot, view_count, views);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct wined3d_shader_resource_view *wined3d_view;
-        struct d3d_shader_resource_view *view_impl;
-
-        if (!(wined3d_view = wined3d_device_get_ds_resource_view(device->wined3d_device, start_slot + i)))
-        {
-            views[i] = NULL;
-            continue;
-        }
-
-        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
-        ID3D11ShaderResourceView_AddRef(views[i] = &view_impl->ID3D11ShaderResourceView_iface);
-    }
-    wined3d_mutex_unlock();
+    memset(views, 0, view_count * sizeof(*views));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetShader(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetShader(ID3D11DeviceContext1 *iface,
         ID3D11DomainShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d11_domain_shader *shader_impl;
-    struct wined3d_shader *wined3d_shader;
-
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+    FIXME("iface %p, shader %p, class_instances %p, class_instance_count %p semi-stub!\n",
             iface, shader, class_instances, class_instance_count);
 
-    if (class_instances || class_instance_count)
-        FIXME("Dynamic linking not implemented yet.\n");
     if (class_instance_count)
         *class_instance_count = 0;
-
-    wined3d_mutex_lock();
-    if (!(wined3d_shader = wined3d_device_get_domain_shader(device->wined3d_device)))
-    {
-        wined3d_mutex_unlock();
-        *shader = NULL;
-        return;
-    }
-
-    shader_impl = wined3d_shader_get_parent(wined3d_shader);
-    wined3d_mutex_unlock();
-    ID3D11DomainShader_AddRef(*shader = &shader_impl->ID3D11DomainShader_iface);
+    *shader = NULL;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetSamplers(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetSamplers(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+    FIXME("iface %p, start_slot %u, sampler_count %u, samplers %p semi-stub!\n",
             iface, start_slot, sampler_count, samplers);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct wined3d_sampler *wined3d_sampler;
-        struct d3d_sampler_state *sampler_impl;
-
-        if (!(wined3d_sampler = wined3d_device_get_ds_sampler(device->wined3d_device, start_slot + i)))
-        {
-            samplers[i] = NULL;
-            continue;
-        }
-
-        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
-        ID3D11SamplerState_AddRef(samplers[i] = &sampler_impl->ID3D11SamplerState_iface);
-    }
-    wined3d_mutex_unlock();
+    memset(samplers, 0, sampler_count * sizeof(*samplers));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetConstantBuffers(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
 {
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p semi-stub!\n",
             iface, start_slot, buffer_count, buffers);
 
-    d3d11_immediate_context_get_constant_buffers(iface, WINED3D_SHADER_TYPE_DOMAIN, start_slot,
-            buffer_count, buffers);
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetShaderResources(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetShaderResources(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct wined3d_shader_resource_view *wined3d_view;
-        struct d3d_shader_resource_view *view_impl;
-
-        if (!(wined3d_view = wined3d_device_get_cs_resource_view(device->wined3d_device, start_slot + i)))
-        {
-            views[i] = NULL;
-            continue;
-        }
+    FIXME("iface %p, start_slot %u, view_count %u, views %p semi-stub!\n", iface, start_slot, view_count, views);
 
-        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
-        ID3D11ShaderResourceView_AddRef(views[i] = &view_impl->ID3D11ShaderResourceView_iface);
-    }
-    wined3d_mutex_unlock();
+    memset(views, 0, view_count * sizeof(*views));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetUnorderedAccessViews(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetUnorderedAccessViews(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT view_count, ID3D11UnorderedAccessView **views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
+    FIXME("iface %p, start_slot %u, view_count %u, views %p semi-stub!\n", iface, start_slot, view_count, views);
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct wined3d_unordered_access_view *wined3d_view;
-        struct d3d11_unordered_access_view *view_impl;
-
-        if (!(wined3d_view = wined3d_device_get_cs_uav(device->wined3d_device, start_slot + i)))
-        {
-            views[i] = NULL;
-            continue;
-        }
-
-        view_impl = wined3d_unordered_access_view_get_parent(wined3d_view);
-        ID3D11UnorderedAccessView_AddRef(views[i] = &view_impl->ID3D11UnorderedAccessView_iface);
-    }
-    wined3d_mutex_unlock();
+    memset(views, 0, view_count * sizeof(*views));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetShader(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetShader(ID3D11DeviceContext1 *iface,
         ID3D11ComputeShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct d3d11_compute_shader *shader_impl;
-    struct wined3d_shader *wined3d_shader;
-
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+    FIXME("iface %p, shader %p, class_instances %p, class_instance_count %p semi-stub!\n",
             iface, shader, class_instances, class_instance_count);
 
-    if (class_instances || class_instance_count)
-        FIXME("Dynamic linking not implemented yet.\n");
     if (class_instance_count)
         *class_instance_count = 0;
-
-    wined3d_mutex_lock();
-    if (!(wined3d_shader = wined3d_device_get_compute_shader(device->wined3d_device)))
-    {
-        wined3d_mutex_unlock();
-        *shader = NULL;
-        return;
-    }
-
-    shader_impl = wined3d_shader_get_parent(wined3d_shader);
-    wined3d_mutex_unlock();
-    ID3D11ComputeShader_AddRef(*shader = &shader_impl->ID3D11ComputeShader_iface);
+    *shader = NULL;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetSamplers(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetSamplers(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+    FIXME("iface %p, start_slot %u, sampler_count %u, samplers %p semi-stub!\n",
             iface, start_slot, sampler_count, samplers);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct wined3d_sampler *wined3d_sampler;
-        struct d3d_sampler_state *sampler_impl;
-
-        if (!(wined3d_sampler = wined3d_device_get_cs_sampler(device->wined3d_device, start_slot + i)))
-        {
-            samplers[i] = NULL;
-            continue;
-        }
-
-        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
-        ID3D11SamplerState_AddRef(samplers[i] = &sampler_impl->ID3D11SamplerState_iface);
-    }
-    wined3d_mutex_unlock();
+    memset(samplers, 0, sampler_count * sizeof(*samplers));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetConstantBuffers(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetConstantBuffers(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
 {
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p semi-stub!\n",
             iface, start_slot, buffer_count, buffers);
 
-    d3d11_immediate_context_get_constant_buffers(iface, WINED3D_SHADER_TYPE_COMPUTE, start_slot,
-            buffer_count, buffers);
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ClearState(ID3D11DeviceContext1 *iface)
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearState(ID3D11DeviceContext1 *iface)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    static const float blend_factor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-    unsigned int i, j;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
 
     TRACE("iface %p.\n", iface);
 
-    wined3d_mutex_lock();
-    wined3d_device_set_vertex_shader(device->wined3d_device, NULL);
-    wined3d_device_set_hull_shader(device->wined3d_device, NULL);
-    wined3d_device_set_domain_shader(device->wined3d_device, NULL);
-    wined3d_device_set_geometry_shader(device->wined3d_device, NULL);
-    wined3d_device_set_pixel_shader(device->wined3d_device, NULL);
-    wined3d_device_set_compute_shader(device->wined3d_device, NULL);
-    for (i = 0; i < D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT; ++i)
-    {
-        wined3d_device_set_vs_sampler(device->wined3d_device, i, NULL);
-        wined3d_device_set_hs_sampler(device->wined3d_device, i, NULL);
-        wined3d_device_set_ds_sampler(device->wined3d_device, i, NULL);
-        wined3d_device_set_gs_sampler(device->wined3d_device, i, NULL);
-        wined3d_device_set_ps_sampler(device->wined3d_device, i, NULL);
-        wined3d_device_set_cs_sampler(device->wined3d_device, i, NULL);
-    }
-    for (i = 0; i < D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT; ++i)
-    {
-        wined3d_device_set_vs_resource_view(device->wined3d_device, i, NULL);
-        wined3d_device_set_hs_resource_view(device->wined3d_device, i, NULL);
-        wined3d_device_set_ds_resource_view(device->wined3d_device, i, NULL);
-        wined3d_device_set_gs_resource_view(device->wined3d_device, i, NULL);
-        wined3d_device_set_ps_resource_view(device->wined3d_device, i, NULL);
-        wined3d_device_set_cs_resource_view(device->wined3d_device, i, NULL);
-    }
-    for (i = 0; i < WINED3D_SHADER_TYPE_COUNT; ++i)
-    {
-        for (j = 0; j < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; ++j)
-            wined3d_device_set_constant_buffer(device->wined3d_device, i, j, NULL);
-    }
-    for (i = 0; i < D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; ++i)
-    {
-        wined3d_device_set_stream_source(device->wined3d_device, i, NULL, 0, 0);
-    }
-    wined3d_device_set_index_buffer(device->wined3d_device, NULL, WINED3DFMT_UNKNOWN, 0);
-    wined3d_device_set_vertex_declaration(device->wined3d_device, NULL);
-    wined3d_device_set_primitive_type(device->wined3d_device, WINED3D_PT_UNDEFINED, 0);
-    for (i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
-    {
-        wined3d_device_set_rendertarget_view(device->wined3d_device, i, NULL, FALSE);
-    }
-    wined3d_device_set_depth_stencil_view(device->wined3d_device, NULL);
-    for (i = 0; i < D3D11_PS_CS_UAV_REGISTER_COUNT; ++i)
-    {
-        wined3d_device_set_unordered_access_view(device->wined3d_device, i, NULL, ~0u);
-        wined3d_device_set_cs_uav(device->wined3d_device, i, NULL, ~0u);
-    }
-    ID3D11DeviceContext1_OMSetDepthStencilState(iface, NULL, 0);
-    ID3D11DeviceContext1_OMSetBlendState(iface, NULL, blend_factor, D3D11_DEFAULT_SAMPLE_MASK);
-    ID3D11DeviceContext1_RSSetViewports(iface, 0, NULL);
-    ID3D11DeviceContext1_RSSetScissorRects(iface, 0, NULL);
-    ID3D11DeviceContext1_RSSetState(iface, NULL);
-    for (i = 0; i < D3D11_SO_BUFFER_SLOT_COUNT; ++i)
-    {
-        wined3d_device_set_stream_output(device->wined3d_device, i, NULL, 0);
-    }
-    wined3d_device_set_predication(device->wined3d_device, NULL, FALSE);
-    wined3d_mutex_unlock();
+    d3d11_context_clear_state(&context->target);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_Flush(ID3D11DeviceContext1 *iface)
+static void STDMETHODCALLTYPE d3d11_deferred_context_Flush(ID3D11DeviceContext1 *iface)
 {
-    FIXME("iface %p stub!\n", iface);
+    TRACE("iface %p.\n", iface);
 }
 
-static D3D11_DEVICE_CONTEXT_TYPE STDMETHODCALLTYPE d3d11_immediate_context_GetType(ID3D11DeviceContext1 *iface)
+static D3D11_DEVICE_CONTEXT_TYPE STDMETHODCALLTYPE d3d11_deferred_context_GetType(ID3D11DeviceContext1 *iface)
 {
     TRACE("iface %p.\n", iface);
 
-    return D3D11_DEVICE_CONTEXT_IMMEDIATE;
+    return D3D11_DEVICE_CONTEXT_DEFERRED;
 }
 
-static UINT STDMETHODCALLTYPE d3d11_immediate_context_GetContextFlags(ID3D11DeviceContext1 *iface)
+static UINT STDMETHODCALLTYPE d3d11_deferred_context_GetContextFlags(ID3D11DeviceContext1 *iface)
 {
-    FIXME("iface %p stub!\n", iface);
+    TRACE("iface %p.\n", iface);
 
     return 0;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_FinishCommandList(ID3D11DeviceContext1 *iface,
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_FinishCommandList(ID3D11DeviceContext1 *iface,
         BOOL restore, ID3D11CommandList **command_list)
 {
-    FIXME("iface %p, restore %#x, command_list %p stub!\n", iface, restore, command_list);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
+    struct d3d11_command_list *object;
+    HRESULT hr;
 
-    return E_NOTIMPL;
+    TRACE("iface %p, restore %#x, command_list %p.\n", iface, restore, command_list);
+
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+        return E_OUTOFMEMORY;
+
+    if (FAILED(hr = wined3d_deferred_context_record_command_list(context->target.deferred,
+            restore, &object->wined3d_list)))
+    {
+        WARN("Failed to record command list, hr %#x.\n", hr);
+        heap_free(object);
+        return hr;
+    }
+
+    object->ID3D11CommandList_iface.lpVtbl = &d3d11_command_list_vtbl;
+    object->refcount = 1;
+    wined3d_private_store_init(&object->private_store);
+    object->device = &context->device->ID3D11Device2_iface;
+    ID3D11Device2_AddRef(object->device);
+
+    TRACE("Created command list %p.\n", object);
+    *command_list = &object->ID3D11CommandList_iface;
+
+    return S_OK;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CopySubresourceRegion1(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CopySubresourceRegion1(ID3D11DeviceContext1 *iface,
         ID3D11Resource *dst_resource, UINT dst_subresource_idx, UINT dst_x, UINT dst_y, UINT dst_z,
         ID3D11Resource *src_resource, UINT src_subresource_idx, const D3D11_BOX *src_box, UINT flags)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct wined3d_resource *wined3d_dst_resource, *wined3d_src_resource;
-    struct wined3d_box wined3d_src_box;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
 
     TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
             "src_resource %p, src_subresource_idx %u, src_box %p, flags %#x.\n",
             iface, dst_resource, dst_subresource_idx, dst_x, dst_y, dst_z,
             src_resource, src_subresource_idx, src_box, flags);
 
-    if (src_box)
-        wined3d_box_set(&wined3d_src_box, src_box->left, src_box->top,
-                src_box->right, src_box->bottom, src_box->front, src_box->back);
-
-    wined3d_dst_resource = wined3d_resource_from_d3d11_resource(dst_resource);
-    wined3d_src_resource = wined3d_resource_from_d3d11_resource(src_resource);
-    wined3d_mutex_lock();
-    wined3d_device_copy_sub_resource_region(device->wined3d_device, wined3d_dst_resource, dst_subresource_idx,
-            dst_x, dst_y, dst_z, wined3d_src_resource, src_subresource_idx, src_box ? &wined3d_src_box : NULL, flags);
-    wined3d_mutex_unlock();
+    d3d11_context_copy_subresource_region(&context->target, dst_resource, dst_subresource_idx,
+            dst_x, dst_y, dst_z, src_resource, src_subresource_idx, src_box, flags);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_UpdateSubresource1(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_UpdateSubresource1(ID3D11DeviceContext1 *iface,
         ID3D11Resource *resource, UINT subresource_idx, const D3D11_BOX *box, const void *data,
         UINT row_pitch, UINT depth_pitch, UINT flags)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext1(iface);
-    struct wined3d_resource *wined3d_resource;
-    struct wined3d_box wined3d_box;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext1(iface);
 
     TRACE("iface %p, resource %p, subresource_idx %u, box %p, data %p, row_pitch %u, depth_pitch %u, flags %#x.\n",
             iface, resource, subresource_idx, box, data, row_pitch, depth_pitch, flags);
 
-    if (box)
-        wined3d_box_set(&wined3d_box, box->left, box->top, box->right, box->bottom,
-                box->front, box->back);
-
-    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
-    wined3d_mutex_lock();
-    wined3d_device_update_sub_resource(device->wined3d_device, wined3d_resource, subresource_idx,
-            box ? &wined3d_box : NULL, data, row_pitch, depth_pitch, flags);
-    wined3d_mutex_unlock();
+    d3d11_context_update_subresource(&context->target, resource, subresource_idx, box,
+            data, row_pitch, depth_pitch, flags);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DiscardResource(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DiscardResource(ID3D11DeviceContext1 *iface,
         ID3D11Resource *resource)
 {
     FIXME("iface %p, resource %p stub!\n", iface, resource);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DiscardView(ID3D11DeviceContext1 *iface, ID3D11View *view)
+static void STDMETHODCALLTYPE d3d11_deferred_context_DiscardView(ID3D11DeviceContext1 *iface, ID3D11View *view)
 {
     FIXME("iface %p, view %p stub!\n", iface, view);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
         const UINT *num_constants)
 {
@@ -2547,7 +4659,7 @@ static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetConstantBuffers1(ID3D
             iface, start_slot, buffer_count, buffers, first_constant, num_constants);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
         const UINT *num_constants)
 {
@@ -2555,7 +4667,7 @@ static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetConstantBuffers1(ID3D
             iface, start_slot, buffer_count, buffers, first_constant, num_constants);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
         const UINT *num_constants)
 {
@@ -2563,7 +4675,7 @@ static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetConstantBuffers1(ID3D
             iface, start_slot, buffer_count, buffers, first_constant, num_constants);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
         const UINT *num_constants)
 {
@@ -2571,7 +4683,7 @@ static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetConstantBuffers1(ID3D
             iface, start_slot, buffer_count, buffers, first_constant, num_constants);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
         const UINT *num_constants)
 {
@@ -2579,7 +4691,7 @@ static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetConstantBuffers1(ID3D
             iface, start_slot, buffer_count, buffers, first_constant, num_constants);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetConstantBuffers1(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer * const *buffers, const UINT *first_constant,
         const UINT *num_constants)
 {
@@ -2587,297 +4699,272 @@ static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetConstantBuffers1(ID3D
             iface, start_slot, buffer_count, buffers, first_constant, num_constants);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
 {
-    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p semi-stub!\n",
             iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+    if (first_constant)
+        memset(first_constant, 0, buffer_count * sizeof(*first_constant));
+    if (num_constants)
+        memset(num_constants, 0, buffer_count * sizeof(*num_constants));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
 {
-    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p semi-stub!\n",
             iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+    if (first_constant)
+        memset(first_constant, 0, buffer_count * sizeof(*first_constant));
+    if (num_constants)
+        memset(num_constants, 0, buffer_count * sizeof(*num_constants));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
 {
-    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p semi-stub!\n",
             iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+    if (first_constant)
+        memset(first_constant, 0, buffer_count * sizeof(*first_constant));
+    if (num_constants)
+        memset(num_constants, 0, buffer_count * sizeof(*num_constants));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
 {
-    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p semi-stub!\n",
             iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+    if (first_constant)
+        memset(first_constant, 0, buffer_count * sizeof(*first_constant));
+    if (num_constants)
+        memset(num_constants, 0, buffer_count * sizeof(*num_constants));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
 {
-    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p semi-stub!\n",
             iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+    if (first_constant)
+        memset(first_constant, 0, buffer_count * sizeof(*first_constant));
+    if (num_constants)
+        memset(num_constants, 0, buffer_count * sizeof(*num_constants));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetConstantBuffers1(ID3D11DeviceContext1 *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *first_constant, UINT *num_constants)
 {
-    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p stub!\n",
+    FIXME("iface %p, start_slot %u, buffer_count %u, buffers %p, first_constant %p, num_constants %p semi-stub!\n",
             iface, start_slot, buffer_count, buffers, first_constant, num_constants);
+
+    memset(buffers, 0, buffer_count * sizeof(*buffers));
+    if (first_constant)
+        memset(first_constant, 0, buffer_count * sizeof(*first_constant));
+    if (num_constants)
+        memset(num_constants, 0, buffer_count * sizeof(*num_constants));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_SwapDeviceContextState(ID3D11DeviceContext1 *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_SwapDeviceContextState(ID3D11DeviceContext1 *iface,
         ID3DDeviceContextState *state, ID3DDeviceContextState **prev_state)
 {
     FIXME("iface %p, state %p, prev_state %p stub!\n", iface, state, prev_state);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ClearView(ID3D11DeviceContext1 *iface, ID3D11View *view,
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearView(ID3D11DeviceContext1 *iface, ID3D11View *view,
         const FLOAT color[4], const D3D11_RECT *rect, UINT num_rects)
 {
     FIXME("iface %p, view %p, color %p, rect %p, num_rects %u stub!\n", iface, view, color, rect, num_rects);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DiscardView1(ID3D11DeviceContext1 *iface, ID3D11View *view,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DiscardView1(ID3D11DeviceContext1 *iface, ID3D11View *view,
         const D3D11_RECT *rects, UINT num_rects)
 {
     FIXME("iface %p, view %p, rects %p, num_rects %u stub!\n", iface, view, rects, num_rects);
 }
 
-static const struct ID3D11DeviceContext1Vtbl d3d11_immediate_context_vtbl =
+static const struct ID3D11DeviceContext1Vtbl d3d11_deferred_context_vtbl =
 {
     /* IUnknown methods */
-    d3d11_immediate_context_QueryInterface,
-    d3d11_immediate_context_AddRef,
-    d3d11_immediate_context_Release,
+    d3d11_deferred_context_QueryInterface,
+    d3d11_deferred_context_AddRef,
+    d3d11_deferred_context_Release,
     /* ID3D11DeviceChild methods */
-    d3d11_immediate_context_GetDevice,
-    d3d11_immediate_context_GetPrivateData,
-    d3d11_immediate_context_SetPrivateData,
-    d3d11_immediate_context_SetPrivateDataInterface,
+    d3d11_deferred_context_GetDevice,
+    d3d11_deferred_context_GetPrivateData,
+    d3d11_deferred_context_SetPrivateData,
+    d3d11_deferred_context_SetPrivateDataInterface,
     /* ID3D11DeviceContext methods */
-    d3d11_immediate_context_VSSetConstantBuffers,
-    d3d11_immediate_context_PSSetShaderResources,
-    d3d11_immediate_context_PSSetShader,
-    d3d11_immediate_context_PSSetSamplers,
-    d3d11_immediate_context_VSSetShader,
-    d3d11_immediate_context_DrawIndexed,
-    d3d11_immediate_context_Draw,
-    d3d11_immediate_context_Map,
-    d3d11_immediate_context_Unmap,
-    d3d11_immediate_context_PSSetConstantBuffers,
-    d3d11_immediate_context_IASetInputLayout,
-    d3d11_immediate_context_IASetVertexBuffers,
-    d3d11_immediate_context_IASetIndexBuffer,
-    d3d11_immediate_context_DrawIndexedInstanced,
-    d3d11_immediate_context_DrawInstanced,
-    d3d11_immediate_context_GSSetConstantBuffers,
-    d3d11_immediate_context_GSSetShader,
-    d3d11_immediate_context_IASetPrimitiveTopology,
-    d3d11_immediate_context_VSSetShaderResources,
-    d3d11_immediate_context_VSSetSamplers,
-    d3d11_immediate_context_Begin,
-    d3d11_immediate_context_End,
-    d3d11_immediate_context_GetData,
-    d3d11_immediate_context_SetPredication,
-    d3d11_immediate_context_GSSetShaderResources,
-    d3d11_immediate_context_GSSetSamplers,
-    d3d11_immediate_context_OMSetRenderTargets,
-    d3d11_immediate_context_OMSetRenderTargetsAndUnorderedAccessViews,
-    d3d11_immediate_context_OMSetBlendState,
-    d3d11_immediate_context_OMSetDepthStencilState,
-    d3d11_immediate_context_SOSetTargets,
-    d3d11_immediate_context_DrawAuto,
-    d3d11_immediate_context_DrawIndexedInstancedIndirect,
-    d3d11_immediate_context_DrawInstancedIndirect,
-    d3d11_immediate_context_Dispatch,
-    d3d11_immediate_context_DispatchIndirect,
-    d3d11_immediate_context_RSSetState,
-    d3d11_immediate_context_RSSetViewports,
-    d3d11_immediate_context_RSSetScissorRects,
-    d3d11_immediate_context_CopySubresourceRegion,
-    d3d11_immediate_context_CopyResource,
-    d3d11_immediate_context_UpdateSubresource,
-    d3d11_immediate_context_CopyStructureCount,
-    d3d11_immediate_context_ClearRenderTargetView,
-    d3d11_immediate_context_ClearUnorderedAccessViewUint,
-    d3d11_immediate_context_ClearUnorderedAccessViewFloat,
-    d3d11_immediate_context_ClearDepthStencilView,
-    d3d11_immediate_context_GenerateMips,
-    d3d11_immediate_context_SetResourceMinLOD,
-    d3d11_immediate_context_GetResourceMinLOD,
-    d3d11_immediate_context_ResolveSubresource,
-    d3d11_immediate_context_ExecuteCommandList,
-    d3d11_immediate_context_HSSetShaderResources,
-    d3d11_immediate_context_HSSetShader,
-    d3d11_immediate_context_HSSetSamplers,
-    d3d11_immediate_context_HSSetConstantBuffers,
-    d3d11_immediate_context_DSSetShaderResources,
-    d3d11_immediate_context_DSSetShader,
-    d3d11_immediate_context_DSSetSamplers,
-    d3d11_immediate_context_DSSetConstantBuffers,
-    d3d11_immediate_context_CSSetShaderResources,
-    d3d11_immediate_context_CSSetUnorderedAccessViews,
-    d3d11_immediate_context_CSSetShader,
-    d3d11_immediate_context_CSSetSamplers,
-    d3d11_immediate_context_CSSetConstantBuffers,
-    d3d11_immediate_context_VSGetConstantBuffers,
-    d3d11_immediate_context_PSGetShaderResources,
-    d3d11_immediate_context_PSGetShader,
-    d3d11_immediate_context_PSGetSamplers,
-    d3d11_immediate_context_VSGetShader,
-    d3d11_immediate_context_PSGetConstantBuffers,
-    d3d11_immediate_context_IAGetInputLayout,
-    d3d11_immediate_context_IAGetVertexBuffers,
-    d3d11_immediate_context_IAGetIndexBuffer,
-    d3d11_immediate_context_GSGetConstantBuffers,
-    d3d11_immediate_context_GSGetShader,
-    d3d11_immediate_context_IAGetPrimitiveTopology,
-    d3d11_immediate_context_VSGetShaderResources,
-    d3d11_immediate_context_VSGetSamplers,
-    d3d11_immediate_context_GetPredication,
-    d3d11_immediate_context_GSGetShaderResources,
-    d3d11_immediate_context_GSGetSamplers,
-    d3d11_immediate_context_OMGetRenderTargets,
-    d3d11_immediate_context_OMGetRenderTargetsAndUnorderedAccessViews,
-    d3d11_immediate_context_OMGetBlendState,
-    d3d11_immediate_context_OMGetDepthStencilState,
-    d3d11_immediate_context_SOGetTargets,
-    d3d11_immediate_context_RSGetState,
-    d3d11_immediate_context_RSGetViewports,
-    d3d11_immediate_context_RSGetScissorRects,
-    d3d11_immediate_context_HSGetShaderResources,
-    d3d11_immediate_context_HSGetShader,
-    d3d11_immediate_context_HSGetSamplers,
-    d3d11_immediate_context_HSGetConstantBuffers,
-    d3d11_immediate_context_DSGetShaderResources,
-    d3d11_immediate_context_DSGetShader,
-    d3d11_immediate_context_DSGetSamplers,
-    d3d11_immediate_context_DSGetConstantBuffers,
-    d3d11_immediate_context_CSGetShaderResources,
-    d3d11_immediate_context_CSGetUnorderedAccessViews,
-    d3d11_immediate_context_CSGetShader,
-    d3d11_immediate_context_CSGetSamplers,
-    d3d11_immediate_context_CSGetConstantBuffers,
-    d3d11_immediate_context_ClearState,
-    d3d11_immediate_context_Flush,
-    d3d11_immediate_context_GetType,
-    d3d11_immediate_context_GetContextFlags,
-    d3d11_immediate_context_FinishCommandList,
+    d3d11_deferred_context_VSSetConstantBuffers,
+    d3d11_deferred_context_PSSetShaderResources,
+    d3d11_deferred_context_PSSetShader,
+    d3d11_deferred_context_PSSetSamplers,
+    d3d11_deferred_context_VSSetShader,
+    d3d11_deferred_context_DrawIndexed,
+    d3d11_deferred_context_Draw,
+    d3d11_deferred_context_Map,
+    d3d11_deferred_context_Unmap,
+    d3d11_deferred_context_PSSetConstantBuffers,
+    d3d11_deferred_context_IASetInputLayout,
+    d3d11_deferred_context_IASetVertexBuffers,
+    d3d11_deferred_context_IASetIndexBuffer,
+    d3d11_deferred_context_DrawIndexedInstanced,
+    d3d11_deferred_context_DrawInstanced,
+    d3d11_deferred_context_GSSetConstantBuffers,
+    d3d11_deferred_context_GSSetShader,
+    d3d11_deferred_context_IASetPrimitiveTopology,
+    d3d11_deferred_context_VSSetShaderResources,
+    d3d11_deferred_context_VSSetSamplers,
+    d3d11_deferred_context_Begin,
+    d3d11_deferred_context_End,
+    d3d11_deferred_context_GetData,
+    d3d11_deferred_context_SetPredication,
+    d3d11_deferred_context_GSSetShaderResources,
+    d3d11_deferred_context_GSSetSamplers,
+    d3d11_deferred_context_OMSetRenderTargets,
+    d3d11_deferred_context_OMSetRenderTargetsAndUnorderedAccessViews,
+    d3d11_deferred_context_OMSetBlendState,
+    d3d11_deferred_context_OMSetDepthStencilState,
+    d3d11_deferred_context_SOSetTargets,
+    d3d11_deferred_context_DrawAuto,
+    d3d11_deferred_context_DrawIndexedInstancedIndirect,
+    d3d11_deferred_context_DrawInstancedIndirect,
+    d3d11_deferred_context_Dispatch,
+    d3d11_deferred_context_DispatchIndirect,
+    d3d11_deferred_context_RSSetState,
+    d3d11_deferred_context_RSSetViewports,
+    d3d11_deferred_context_RSSetScissorRects,
+    d3d11_deferred_context_CopySubresourceRegion,
+    d3d11_deferred_context_CopyResource,
+    d3d11_deferred_context_UpdateSubresource,
+    d3d11_deferred_context_CopyStructureCount,
+    d3d11_deferred_context_ClearRenderTargetView,
+    d3d11_deferred_context_ClearUnorderedAccessViewUint,
+    d3d11_deferred_context_ClearUnorderedAccessViewFloat,
+    d3d11_deferred_context_ClearDepthStencilView,
+    d3d11_deferred_context_GenerateMips,
+    d3d11_deferred_context_SetResourceMinLOD,
+    d3d11_deferred_context_GetResourceMinLOD,
+    d3d11_deferred_context_ResolveSubresource,
+    d3d11_deferred_context_ExecuteCommandList,
+    d3d11_deferred_context_HSSetShaderResources,
+    d3d11_deferred_context_HSSetShader,
+    d3d11_deferred_context_HSSetSamplers,
+    d3d11_deferred_context_HSSetConstantBuffers,
+    d3d11_deferred_context_DSSetShaderResources,
+    d3d11_deferred_context_DSSetShader,
+    d3d11_deferred_context_DSSetSamplers,
+    d3d11_deferred_context_DSSetConstantBuffers,
+    d3d11_deferred_context_CSSetShaderResources,
+    d3d11_deferred_context_CSSetUnorderedAccessViews,
+    d3d11_deferred_context_CSSetShader,
+    d3d11_deferred_context_CSSetSamplers,
+    d3d11_deferred_context_CSSetConstantBuffers,
+    d3d11_deferred_context_VSGetConstantBuffers,
+    d3d11_deferred_context_PSGetShaderResources,
+    d3d11_deferred_context_PSGetShader,
+    d3d11_deferred_context_PSGetSamplers,
+    d3d11_deferred_context_VSGetShader,
+    d3d11_deferred_context_PSGetConstantBuffers,
+    d3d11_deferred_context_IAGetInputLayout,
+    d3d11_deferred_context_IAGetVertexBuffers,
+    d3d11_deferred_context_IAGetIndexBuffer,
+    d3d11_deferred_context_GSGetConstantBuffers,
+    d3d11_deferred_context_GSGetShader,
+    d3d11_deferred_context_IAGetPrimitiveTopology,
+    d3d11_deferred_context_VSGetShaderResources,
+    d3d11_deferred_context_VSGetSamplers,
+    d3d11_deferred_context_GetPredication,
+    d3d11_deferred_context_GSGetShaderResources,
+    d3d11_deferred_context_GSGetSamplers,
+    d3d11_deferred_context_OMGetRenderTargets,
+    d3d11_deferred_context_OMGetRenderTargetsAndUnorderedAccessViews,
+    d3d11_deferred_context_OMGetBlendState,
+    d3d11_deferred_context_OMGetDepthStencilState,
+    d3d11_deferred_context_SOGetTargets,
+    d3d11_deferred_context_RSGetState,
+    d3d11_deferred_context_RSGetViewports,
+    d3d11_deferred_context_RSGetScissorRects,
+    d3d11_deferred_context_HSGetShaderResources,
+    d3d11_deferred_context_HSGetShader,
+    d3d11_deferred_context_HSGetSamplers,
+    d3d11_deferred_context_HSGetConstantBuffers,
+    d3d11_deferred_context_DSGetShaderResources,
+    d3d11_deferred_context_DSGetShader,
+    d3d11_deferred_context_DSGetSamplers,
+    d3d11_deferred_context_DSGetConstantBuffers,
+    d3d11_deferred_context_CSGetShaderResources,
+    d3d11_deferred_context_CSGetUnorderedAccessViews,
+    d3d11_deferred_context_CSGetShader,
+    d3d11_deferred_context_CSGetSamplers,
+    d3d11_deferred_context_CSGetConstantBuffers,
+    d3d11_deferred_context_ClearState,
+    d3d11_deferred_context_Flush,
+    d3d11_deferred_context_GetType,
+    d3d11_deferred_context_GetContextFlags,
+    d3d11_deferred_context_FinishCommandList,
     /* ID3D11DeviceContext1 methods */
-    d3d11_immediate_context_CopySubresourceRegion1,
-    d3d11_immediate_context_UpdateSubresource1,
-    d3d11_immediate_context_DiscardResource,
-    d3d11_immediate_context_DiscardView,
-    d3d11_immediate_context_VSSetConstantBuffers1,
-    d3d11_immediate_context_HSSetConstantBuffers1,
-    d3d11_immediate_context_DSSetConstantBuffers1,
-    d3d11_immediate_context_GSSetConstantBuffers1,
-    d3d11_immediate_context_PSSetConstantBuffers1,
-    d3d11_immediate_context_CSSetConstantBuffers1,
-    d3d11_immediate_context_VSGetConstantBuffers1,
-    d3d11_immediate_context_HSGetConstantBuffers1,
-    d3d11_immediate_context_DSGetConstantBuffers1,
-    d3d11_immediate_context_GSGetConstantBuffers1,
-    d3d11_immediate_context_PSGetConstantBuffers1,
-    d3d11_immediate_context_CSGetConstantBuffers1,
-    d3d11_immediate_context_SwapDeviceContextState,
-    d3d11_immediate_context_ClearView,
-    d3d11_immediate_context_DiscardView1,
+    d3d11_deferred_context_CopySubresourceRegion1,
+    d3d11_deferred_context_UpdateSubresource1,
+    d3d11_deferred_context_DiscardResource,
+    d3d11_deferred_context_DiscardView,
+    d3d11_deferred_context_VSSetConstantBuffers1,
+    d3d11_deferred_context_HSSetConstantBuffers1,
+    d3d11_deferred_context_DSSetConstantBuffers1,
+    d3d11_deferred_context_GSSetConstantBuffers1,
+    d3d11_deferred_context_PSSetConstantBuffers1,
+    d3d11_deferred_context_CSSetConstantBuffers1,
+    d3d11_deferred_context_VSGetConstantBuffers1,
+    d3d11_deferred_context_HSGetConstantBuffers1,
+    d3d11_deferred_context_DSGetConstantBuffers1,
+    d3d11_deferred_context_GSGetConstantBuffers1,
+    d3d11_deferred_context_PSGetConstantBuffers1,
+    d3d11_deferred_context_CSGetConstantBuffers1,
+    d3d11_deferred_context_SwapDeviceContextState,
+    d3d11_deferred_context_ClearView,
+    d3d11_deferred_context_DiscardView1,
 };
 
-/* ID3D11Multithread methods */
-
-static inline struct d3d11_immediate_context *impl_from_ID3D11Multithread(ID3D11Multithread *iface)
-{
-    return CONTAINING_RECORD(iface, struct d3d11_immediate_context, ID3D11Multithread_iface);
-}
-
-static HRESULT STDMETHODCALLTYPE d3d11_multithread_QueryInterface(ID3D11Multithread *iface,
-        REFIID iid, void **out)
-{
-    struct d3d11_immediate_context *context = impl_from_ID3D11Multithread(iface);
-
-    TRACE("iface %p, iid %s, out %p.\n", iface, debugstr_guid(iid), out);
-
-    return d3d11_immediate_context_QueryInterface(&context->ID3D11DeviceContext1_iface, iid, out);
-}
-
-static ULONG STDMETHODCALLTYPE d3d11_multithread_AddRef(ID3D11Multithread *iface)
-{
-    struct d3d11_immediate_context *context = impl_from_ID3D11Multithread(iface);
-
-    TRACE("iface %p.\n", iface);
-
-    return d3d11_immediate_context_AddRef(&context->ID3D11DeviceContext1_iface);
-}
-
-static ULONG STDMETHODCALLTYPE d3d11_multithread_Release(ID3D11Multithread *iface)
+static HRESULT d3d11_deferred_context_create(struct d3d_device *device, struct d3d11_deferred_context **context)
 {
-    struct d3d11_immediate_context *context = impl_from_ID3D11Multithread(iface);
-
-    TRACE("iface %p.\n", iface);
-
-    return d3d11_immediate_context_Release(&context->ID3D11DeviceContext1_iface);
-}
+    struct d3d11_deferred_context *object;
+    HRESULT hr;
 
-static void STDMETHODCALLTYPE d3d11_multithread_Enter(ID3D11Multithread *iface)
-{
-    TRACE("iface %p.\n", iface);
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+        return E_OUTOFMEMORY;
 
     wined3d_mutex_lock();
-}
-
-static void STDMETHODCALLTYPE d3d11_multithread_Leave(ID3D11Multithread *iface)
-{
-    TRACE("iface %p.\n", iface);
-
+    hr = wined3d_deferred_context_create(device->wined3d_device, &object->target.deferred);
     wined3d_mutex_unlock();
-}
-
-static BOOL STDMETHODCALLTYPE d3d11_multithread_SetMultithreadProtected(
-        ID3D11Multithread *iface, BOOL enable)
-{
-    FIXME("iface %p, enable %#x stub!\n", iface, enable);
-
-    return TRUE;
-}
-
-static BOOL STDMETHODCALLTYPE d3d11_multithread_GetMultithreadProtected(ID3D11Multithread *iface)
-{
-    FIXME("iface %p stub!\n", iface);
-
-    return TRUE;
-}
-
-static const struct ID3D11MultithreadVtbl d3d11_multithread_vtbl =
-{
-    d3d11_multithread_QueryInterface,
-    d3d11_multithread_AddRef,
-    d3d11_multithread_Release,
-    d3d11_multithread_Enter,
-    d3d11_multithread_Leave,
-    d3d11_multithread_SetMultithreadProtected,
-    d3d11_multithread_GetMultithreadProtected,
-};
-
-static void d3d11_immediate_context_init(struct d3d11_immediate_context *context, struct d3d_device *device)
-{
-    context->ID3D11DeviceContext1_iface.lpVtbl = &d3d11_immediate_context_vtbl;
-    context->ID3D11Multithread_iface.lpVtbl = &d3d11_multithread_vtbl;
-    context->refcount = 1;
+    if (FAILED(hr))
+    {
+        WARN("Failed to create wined3d deferred context, hr %#x.\n", hr);
+        heap_free(object);
+        return hr;
+    }
 
+    object->ID3D11DeviceContext1_iface.lpVtbl = &d3d11_deferred_context_vtbl;
+    object->refcount = 1;
+    wined3d_private_store_init(&object->private_store);
+    object->device = device;
     ID3D11Device2_AddRef(&device->ID3D11Device2_iface);
 
-    wined3d_private_store_init(&context->private_store);
-}
+    TRACE("Created deferred context %p.\n", object);
+    *context = object;
 
-static void d3d11_immediate_context_destroy(struct d3d11_immediate_context *context)
-{
-    wined3d_private_store_cleanup(&context->private_store);
+    return S_OK;
 }
 
 /* ID3D11Device methods */
@@ -3359,9 +5446,21 @@ static HRESULT STDMETHODCALLTYPE d3d11_device_CreateCounter(ID3D11Device2 *iface
 static HRESULT STDMETHODCALLTYPE d3d11_device_CreateDeferredContext(ID3D11Device2 *iface, UINT flags,
         ID3D11DeviceContext **context)
 {
-    FIXME("iface %p, flags %#x, context %p stub!\n", iface, flags, context);
+    struct d3d_device *device = impl_from_ID3D11Device2(iface);
+    struct d3d11_deferred_context *object;
+    HRESULT hr;
 
-    return E_NOTIMPL;
+    TRACE("iface %p, flags %#x, context %p.\n", iface, flags, context);
+
+    if (flags)
+        FIXME("Ignoring flags %#x.\n", flags);
+
+    if (FAILED(hr = d3d11_deferred_context_create(device, &object)))
+        return hr;
+
+    *context = (ID3D11DeviceContext *)&object->ID3D11DeviceContext1_iface;
+
+    return S_OK;
 }
 
 static HRESULT STDMETHODCALLTYPE d3d11_device_OpenSharedResource(ID3D11Device2 *iface, HANDLE resource, REFIID iid,
@@ -3771,9 +5870,9 @@ static void STDMETHODCALLTYPE d3d11_device_GetImmediateContext1(ID3D11Device2 *i
 static HRESULT STDMETHODCALLTYPE d3d11_device_CreateDeferredContext1(ID3D11Device2 *iface, UINT flags,
         ID3D11DeviceContext1 **context)
 {
-    FIXME("iface %p, flags %#x, context %p stub!\n", iface, flags, context);
+    TRACE("iface %p, flags %#x, context %p.\n", iface, flags, context);
 
-    return E_NOTIMPL;
+    return d3d11_device_CreateDeferredContext(iface, flags, (ID3D11DeviceContext **)context);
 }
 
 static HRESULT STDMETHODCALLTYPE d3d11_device_CreateBlendState1(ID3D11Device2 *iface,
@@ -6137,10 +8236,11 @@ static void CDECL device_parent_wined3d_device_created(struct wined3d_device_par
 
     wined3d_device_incref(wined3d_device);
     device->wined3d_device = wined3d_device;
+    device->immediate_context.target.device = wined3d_device;
 
     device->feature_level = wined3d_device_get_feature_level(wined3d_device);
 
-    set_default_depth_stencil_state(wined3d_device);
+    d3d11_context_set_depth_stencil_state(&device->immediate_context.target, NULL, 0);
 }
 
 static void CDECL device_parent_mode_changed(struct wined3d_device_parent *device_parent)
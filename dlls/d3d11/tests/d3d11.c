@@ -2231,6 +2231,8 @@ static void test_create_deferred_context(void)
 
     hr = ID3D11Device_CreateDeferredContext(device, 0, &context);
     todo_wine ok(hr == DXGI_ERROR_INVALID_CALL, "Failed to create deferred context, hr %#x.\n", hr);
+    if (SUCCEEDED(hr))
+        ID3D11DeviceContext_Release(context);
 
     refcount = ID3D11Device_Release(device);
     ok(!refcount, "Device has %u references left.\n", refcount);
@@ -2243,7 +2245,7 @@ static void test_create_deferred_context(void)
 
     expected_refcount = get_refcount(device) + 1;
     hr = ID3D11Device_CreateDeferredContext(device, 0, &context);
-    todo_wine ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
+    ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
     if (FAILED(hr))
         goto done;
     refcount = get_refcount(device);
@@ -2264,6 +2266,255 @@ done:
     ok(!refcount, "Device has %u references left.\n", refcount);
 }
 
+static void test_deferred_context_command_list(void)
+{
+    static const float red[] = {1.0f, 0.0f, 0.0f, 1.0f};
+    static const float green[] = {0.0f, 1.0f, 0.0f, 1.0f};
+    static const struct vec4 blue = {0.0f, 0.0f, 1.0f, 1.0f};
+    static const struct vec4 yellow = {1.0f, 1.0f, 0.0f, 1.0f};
+    struct d3d11_test_context test_context;
+    ID3D11RasterizerState *rasterizer_state;
+    ID3D11CommandList *command_list;
+    D3D11_TEXTURE2D_DESC texture_desc;
+    ID3D11DeviceContext *context;
+    unsigned int stride, offset;
+    ID3D11Texture2D *texture;
+    ID3D11Buffer *buffer;
+    D3D11_VIEWPORT vp;
+    ID3D11Device *device;
+    ULONG refcount;
+    HRESULT hr;
+
+    if (!init_test_context(&test_context, NULL))
+        return;
+
+    device = test_context.device;
+
+    hr = ID3D11Device_CreateDeferredContext(device, 0, &context);
+    ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
+    ok(ID3D11DeviceContext_GetType(context) == D3D11_DEVICE_CONTEXT_DEFERRED,
+            "Got unexpected context type %#x.\n", ID3D11DeviceContext_GetType(context));
+
+    rasterizer_state = (ID3D11RasterizerState *)0xdeadbeef;
+    ID3D11DeviceContext_RSGetState(context, &rasterizer_state);
+    ok(!rasterizer_state, "Got unexpected rasterizer state %p.\n", rasterizer_state);
+    buffer = (ID3D11Buffer *)0xdeadbeef;
+    ID3D11DeviceContext_VSGetConstantBuffers(context, 0, 1, &buffer);
+    ok(!buffer, "Got unexpected buffer %p.\n", buffer);
+
+    ID3D11DeviceContext_ClearRenderTargetView(context, test_context.backbuffer_rtv, green);
+    hr = ID3D11DeviceContext_FinishCommandList(context, FALSE, &command_list);
+    ok(hr == S_OK, "Failed to finish command list, hr %#x.\n", hr);
+
+    /* Nothing happens until the command list is executed. */
+    ID3D11DeviceContext_ClearRenderTargetView(test_context.immediate_context, test_context.backbuffer_rtv, red);
+    check_texture_color(test_context.backbuffer, 0xff0000ff, 1);
+    ID3D11DeviceContext_ExecuteCommandList(test_context.immediate_context, command_list, TRUE);
+    check_texture_color(test_context.backbuffer, 0xff00ff00, 1);
+
+    /* Command lists can be executed multiple times. */
+    ID3D11DeviceContext_ClearRenderTargetView(test_context.immediate_context, test_context.backbuffer_rtv, red);
+    ID3D11DeviceContext_ExecuteCommandList(test_context.immediate_context, command_list, TRUE);
+    check_texture_color(test_context.backbuffer, 0xff00ff00, 1);
+    ID3D11CommandList_Release(command_list);
+
+    /* The immediate context state is restored. */
+    draw_color_quad(&test_context, &blue);
+    check_texture_color(test_context.backbuffer, 0xffff0000, 1);
+
+    /* Command lists start from the default state, and updates are ordered
+     * with the draws recorded in the same list. */
+    ID3D11DeviceContext_IASetInputLayout(context, test_context.input_layout);
+    ID3D11DeviceContext_IASetPrimitiveTopology(context, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+    stride = sizeof(struct vec3);
+    offset = 0;
+    ID3D11DeviceContext_IASetVertexBuffers(context, 0, 1, &test_context.vb, &stride, &offset);
+    ID3D11DeviceContext_VSSetShader(context, test_context.vs, NULL, 0);
+    ID3D11DeviceContext_PSSetShader(context, test_context.ps, NULL, 0);
+    ID3D11DeviceContext_PSSetConstantBuffers(context, 0, 1, &test_context.ps_cb);
+    ID3D11DeviceContext_OMSetRenderTargets(context, 1, &test_context.backbuffer_rtv, NULL);
+    vp.TopLeftX = 0.0f;
+    vp.TopLeftY = 0.0f;
+    vp.Width = 640.0f;
+    vp.Height = 480.0f;
+    vp.MinDepth = 0.0f;
+    vp.MaxDepth = 1.0f;
+    ID3D11DeviceContext_RSSetViewports(context, 1, &vp);
+    ID3D11DeviceContext_UpdateSubresource(context, (ID3D11Resource *)test_context.ps_cb, 0, NULL, &yellow, 0, 0);
+    ID3D11DeviceContext_Draw(context, 4, 0);
+    hr = ID3D11DeviceContext_FinishCommandList(context, FALSE, &command_list);
+    ok(hr == S_OK, "Failed to finish command list, hr %#x.\n", hr);
+
+    ID3D11DeviceContext_ClearRenderTargetView(test_context.immediate_context, test_context.backbuffer_rtv, red);
+    ID3D11DeviceContext_ExecuteCommandList(test_context.immediate_context, command_list, TRUE);
+    check_texture_color(test_context.backbuffer, 0xff00ffff, 1);
+    refcount = ID3D11CommandList_Release(command_list);
+    ok(!refcount, "Got unexpected refcount %u.\n", refcount);
+
+    /* Copies read the source when the command list is executed. */
+    ID3D11Texture2D_GetDesc(test_context.backbuffer, &texture_desc);
+    texture_desc.BindFlags = 0;
+    hr = ID3D11Device_CreateTexture2D(device, &texture_desc, NULL, &texture);
+    ok(hr == S_OK, "Failed to create texture, hr %#x.\n", hr);
+    ID3D11DeviceContext_CopyResource(context, (ID3D11Resource *)texture, (ID3D11Resource *)test_context.backbuffer);
+    hr = ID3D11DeviceContext_FinishCommandList(context, FALSE, &command_list);
+    ok(hr == S_OK, "Failed to finish command list, hr %#x.\n", hr);
+    ID3D11DeviceContext_ClearRenderTargetView(test_context.immediate_context, test_context.backbuffer_rtv, green);
+    ID3D11DeviceContext_ExecuteCommandList(test_context.immediate_context, command_list, TRUE);
+    check_texture_color(texture, 0xff00ff00, 1);
+    ID3D11CommandList_Release(command_list);
+    ID3D11Texture2D_Release(texture);
+
+    /* FinishCommandList() with restore FALSE resets the deferred context. */
+    hr = ID3D11DeviceContext_FinishCommandList(context, FALSE, &command_list);
+    ok(hr == S_OK, "Failed to finish command list, hr %#x.\n", hr);
+    ID3D11DeviceContext_ClearRenderTargetView(test_context.immediate_context, test_context.backbuffer_rtv, red);
+    ID3D11DeviceContext_ExecuteCommandList(test_context.immediate_context, command_list, TRUE);
+    check_texture_color(test_context.backbuffer, 0xff0000ff, 1);
+    ID3D11CommandList_Release(command_list);
+
+    refcount = ID3D11DeviceContext_Release(context);
+    ok(!refcount, "Got unexpected refcount %u.\n", refcount);
+    release_test_context(&test_context);
+}
+
+struct deferred_recording_thread
+{
+    struct d3d11_test_context *test_context;
+    ID3D11DeviceContext *context;
+    ID3D11CommandList *command_list;
+    unsigned int draw_count;
+};
+
+static DWORD WINAPI deferred_recording_thread_func(void *data)
+{
+    struct deferred_recording_thread *thread = data;
+    struct d3d11_test_context *test_context = thread->test_context;
+    ID3D11DeviceContext *context = thread->context;
+    unsigned int i, stride, offset;
+    D3D11_VIEWPORT vp;
+
+    ID3D11DeviceContext_IASetInputLayout(context, test_context->input_layout);
+    ID3D11DeviceContext_IASetPrimitiveTopology(context, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+    stride = sizeof(struct vec3);
+    offset = 0;
+    ID3D11DeviceContext_IASetVertexBuffers(context, 0, 1, &test_context->vb, &stride, &offset);
+    ID3D11DeviceContext_VSSetShader(context, test_context->vs, NULL, 0);
+    ID3D11DeviceContext_PSSetShader(context, test_context->ps, NULL, 0);
+    ID3D11DeviceContext_PSSetConstantBuffers(context, 0, 1, &test_context->ps_cb);
+    ID3D11DeviceContext_OMSetRenderTargets(context, 1, &test_context->backbuffer_rtv, NULL);
+    vp.TopLeftX = 0.0f;
+    vp.TopLeftY = 0.0f;
+    vp.Width = 640.0f;
+    vp.Height = 480.0f;
+    vp.MinDepth = 0.0f;
+    vp.MaxDepth = 1.0f;
+    ID3D11DeviceContext_RSSetViewports(context, 1, &vp);
+
+    /* Keep the CPU side of the draws busy: state changes that don't
+     * actually change anything, and a draw in between. */
+    for (i = 0; i < thread->draw_count; ++i)
+    {
+        ID3D11DeviceContext_RSSetState(context, NULL);
+        ID3D11DeviceContext_OMSetBlendState(context, NULL, NULL, D3D11_DEFAULT_SAMPLE_MASK);
+        ID3D11DeviceContext_OMSetDepthStencilState(context, NULL, 0);
+        ID3D11DeviceContext_Draw(context, 4, 0);
+    }
+
+    return ID3D11DeviceContext_FinishCommandList(context, FALSE, &thread->command_list);
+}
+
+static DWORD record_deferred_command_lists(struct d3d11_test_context *test_context,
+        struct deferred_recording_thread *threads, unsigned int thread_count, unsigned int draw_count)
+{
+    HANDLE handles[MAXIMUM_WAIT_OBJECTS];
+    DWORD start, ret;
+    unsigned int i;
+
+    for (i = 0; i < thread_count; ++i)
+    {
+        threads[i].test_context = test_context;
+        threads[i].draw_count = draw_count / thread_count;
+        threads[i].command_list = NULL;
+    }
+
+    start = GetTickCount();
+    for (i = 0; i < thread_count; ++i)
+    {
+        handles[i] = CreateThread(NULL, 0, deferred_recording_thread_func, &threads[i], 0, NULL);
+        ok(!!handles[i], "Failed to create thread %u.\n", i);
+    }
+    WaitForMultipleObjects(thread_count, handles, TRUE, INFINITE);
+    ret = GetTickCount() - start;
+
+    for (i = 0; i < thread_count; ++i)
+    {
+        DWORD exit_code;
+
+        GetExitCodeThread(handles[i], &exit_code);
+        ok(exit_code == S_OK, "Thread %u failed to record command list, hr %#x.\n", i, exit_code);
+        CloseHandle(handles[i]);
+    }
+
+    return ret;
+}
+
+static void test_deferred_context_multithreaded_recording(void)
+{
+    static const float red[] = {1.0f, 0.0f, 0.0f, 1.0f};
+    static const struct vec4 green = {0.0f, 1.0f, 0.0f, 1.0f};
+    struct deferred_recording_thread threads[8];
+    unsigned int i, thread_count, draw_count;
+    struct d3d11_test_context test_context;
+    DWORD single_time, multi_time, start;
+    SYSTEM_INFO si;
+    HRESULT hr;
+
+    if (!init_test_context(&test_context, NULL))
+        return;
+
+    GetSystemInfo(&si);
+    thread_count = min(max(si.dwNumberOfProcessors, 2), ARRAY_SIZE(threads));
+    draw_count = winetest_interactive ? 400000 : 400;
+
+    draw_color_quad(&test_context, &green);
+
+    for (i = 0; i < thread_count; ++i)
+    {
+        hr = ID3D11Device_CreateDeferredContext(test_context.device, 0, &threads[i].context);
+        ok(hr == S_OK, "Failed to create deferred context %u, hr %#x.\n", i, hr);
+    }
+
+    single_time = record_deferred_command_lists(&test_context, threads, 1, draw_count);
+    ID3D11DeviceContext_ClearRenderTargetView(test_context.immediate_context, test_context.backbuffer_rtv, red);
+    start = GetTickCount();
+    ID3D11DeviceContext_ExecuteCommandList(test_context.immediate_context, threads[0].command_list, TRUE);
+    check_texture_color(test_context.backbuffer, 0xff00ff00, 1);
+    if (winetest_interactive)
+        trace("Recorded %u draws on 1 thread in %u ms, executed in %u ms.\n",
+                draw_count, single_time, GetTickCount() - start);
+    ID3D11CommandList_Release(threads[0].command_list);
+
+    multi_time = record_deferred_command_lists(&test_context, threads, thread_count, draw_count);
+    ID3D11DeviceContext_ClearRenderTargetView(test_context.immediate_context, test_context.backbuffer_rtv, red);
+    start = GetTickCount();
+    for (i = 0; i < thread_count; ++i)
+    {
+        ID3D11DeviceContext_ExecuteCommandList(test_context.immediate_context, threads[i].command_list, TRUE);
+    }
+    check_texture_color(test_context.backbuffer, 0xff00ff00, 1);
+    if (winetest_interactive)
+        trace("Recorded %u draws on %u threads in %u ms, executed in %u ms.\n",
+                draw_count, thread_count, multi_time, GetTickCount() - start);
+
+    for (i = 0; i < thread_count; ++i)
+    {
+        ID3D11CommandList_Release(threads[i].command_list);
+        ID3D11DeviceContext_Release(threads[i].context);
+    }
+    release_test_context(&test_context);
+}
+
 static void test_create_texture1d(void)
 {
     ULONG refcount, expected_refcount;
@@ -29316,6 +29567,8 @@ START_TEST(d3d11)
     queue_for_each_feature_level(test_device_interfaces);
     queue_test(test_get_immediate_context);
     queue_test(test_create_deferred_context);
+    queue_test(test_deferred_context_command_list);
+    queue_test(test_deferred_context_multithreaded_recording);
     queue_test(test_create_texture1d);
     queue_test(test_texture1d_interfaces);
     queue_test(test_create_texture2d);
@@ -13362,6 +13362,109 @@ static void test_vertex_buffer_read_write(void)
     DestroyWindow(window);
 }
 
+static void test_draw_primitive_up_throughput(void)
+{
+    unsigned int i, j, frame_count, draw_count;
+    struct device_desc device_desc;
+    IDirect3DSurface9 *backbuffer;
+    D3DLOCKED_RECT locked_rect;
+    IDirect3DDevice9 *device;
+    DWORD start, time, color;
+    struct vec3 tri[3];
+    IDirect3D9 *d3d;
+    ULONG refcount;
+    HWND window;
+    HRESULT hr;
+
+    window = create_window();
+    d3d = Direct3DCreate9(D3D_SDK_VERSION);
+    ok(!!d3d, "Failed to create a D3D object.\n");
+    device_desc.device_window = window;
+    device_desc.width = 640;
+    device_desc.height = 480;
+    device_desc.flags = CREATE_DEVICE_LOCKABLE_BACKBUFFER;
+    if (!(device = create_device(d3d, window, &device_desc)))
+    {
+        skip("Failed to create a D3D device, skipping tests.\n");
+        IDirect3D9_Release(d3d);
+        DestroyWindow(window);
+        return;
+    }
+
+    hr = IDirect3DDevice9_SetFVF(device, D3DFVF_XYZ);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetRenderState(device, D3DRS_LIGHTING, FALSE);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetRenderState(device, D3DRS_ZENABLE, D3DZB_FALSE);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+
+    /* Many small immediate mode draws, as issued by older games. Every draw
+     * streams its vertices through the device's dynamic vertex buffer. */
+    frame_count = winetest_interactive ? 100 : 2;
+    draw_count = 10000;
+    start = GetTickCount();
+    for (i = 0; i < frame_count; ++i)
+    {
+        /* The last frame is presented after checking its contents below. */
+        if (i)
+        {
+            hr = IDirect3DDevice9_Present(device, NULL, NULL, NULL, NULL);
+            ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+        }
+        hr = IDirect3DDevice9_Clear(device, 0, NULL, D3DCLEAR_TARGET, 0xff000000, 0.0f, 0);
+        ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+        hr = IDirect3DDevice9_BeginScene(device);
+        ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+        for (j = 0; j < draw_count; ++j)
+        {
+            tri[0].x = -1.0f + (j % 100) / 50.0f;
+            tri[0].y = -1.0f + (j / 100) / 50.0f;
+            tri[0].z = 0.5f;
+            tri[1] = tri[0];
+            tri[1].y += 0.02f;
+            tri[2] = tri[0];
+            tri[2].x += 0.02f;
+            hr = IDirect3DDevice9_DrawPrimitiveUP(device, D3DPT_TRIANGLELIST, 1, tri, sizeof(*tri));
+            if (FAILED(hr))
+                break;
+        }
+        ok(hr == D3D_OK, "Got unexpected hr %#x, frame %u, draw %u.\n", hr, i, j);
+        hr = IDirect3DDevice9_EndScene(device);
+        ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    }
+    if (winetest_interactive)
+    {
+        time = GetTickCount() - start;
+        trace("%u frames of %u DrawPrimitiveUP() calls took %u ms, %.2f ms per frame.\n",
+                frame_count, draw_count, time, (float)time / frame_count);
+    }
+
+    /* Every draw covers the lower left half of its own 6.4x4.8 pixel cell, so
+     * the vertices of the streamed draws have to end up in the right place.
+     * The cell at (320, 240) is drawn by draw 5050. */
+    hr = IDirect3DDevice9_GetBackBuffer(device, 0, 0, D3DBACKBUFFER_TYPE_MONO, &backbuffer);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    hr = IDirect3DSurface9_LockRect(backbuffer, &locked_rect, NULL, D3DLOCK_READONLY);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    color = ((DWORD *)((BYTE *)locked_rect.pBits + 238 * locked_rect.Pitch))[321] & 0x00ffffff;
+    ok(color == 0x00ffffff, "Got unexpected color 0x%08x.\n", color);
+    color = ((DWORD *)((BYTE *)locked_rect.pBits + 235 * locked_rect.Pitch))[325] & 0x00ffffff;
+    ok(color == 0x00000000, "Got unexpected color 0x%08x.\n", color);
+    color = ((DWORD *)((BYTE *)locked_rect.pBits + 478 * locked_rect.Pitch))[1] & 0x00ffffff;
+    ok(color == 0x00ffffff, "Got unexpected color 0x%08x.\n", color);
+    hr = IDirect3DSurface9_UnlockRect(backbuffer);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    IDirect3DSurface9_Release(backbuffer);
+
+    hr = IDirect3DDevice9_Present(device, NULL, NULL, NULL, NULL);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+
+    refcount = IDirect3DDevice9_Release(device);
+    ok(!refcount, "Device has %u references left.\n", refcount);
+    IDirect3D9_Release(d3d);
+    DestroyWindow(window);
+}
+
 static void test_get_display_mode(void)
 {
     IDirect3DSwapChain9 *swapchain;
@@ -13564,6 +13667,7 @@ START_TEST(device)
     test_resource_access();
     test_multiply_transform();
     test_vertex_buffer_read_write();
+    test_draw_primitive_up_throughput();
     test_get_display_mode();
 
     UnregisterClassA("d3d9_test_wc", GetModuleHandleA(NULL));
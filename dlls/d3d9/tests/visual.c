@@ -25562,6 +25562,249 @@ static void test_sysmem_draw(void)
     DestroyWindow(window);
 }
 
+struct shader_cache_entry
+{
+    char name[32];
+    BY_HANDLE_FILE_INFORMATION info;
+    UINT64 driver_hash;
+};
+
+static BOOL get_shader_cache_entry(const char *dir, struct shader_cache_entry *entry)
+{
+    char filename[MAX_PATH];
+    DWORD header[4], size;
+    HANDLE file;
+    BOOL ret;
+
+    sprintf(filename, "%s\\%s", dir, entry->name);
+    if ((file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, 0, NULL)) == INVALID_HANDLE_VALUE)
+        return FALSE;
+    ret = GetFileInformationByHandle(file, &entry->info)
+            && ReadFile(file, header, sizeof(header), &size, NULL) && size == sizeof(header);
+    CloseHandle(file);
+    if (ret)
+        entry->driver_hash = ((UINT64)header[3] << 32) | header[2];
+    return ret;
+}
+
+static unsigned int get_shader_cache_entries(const char *dir, struct shader_cache_entry *entries,
+        unsigned int max_count, const struct shader_cache_entry *exclude, unsigned int exclude_count)
+{
+    char pattern[MAX_PATH];
+    WIN32_FIND_DATAA data;
+    unsigned int count = 0, i;
+    HANDLE find;
+
+    sprintf(pattern, "%s\\*.bin", dir);
+    if ((find = FindFirstFileA(pattern, &data)) == INVALID_HANDLE_VALUE)
+        return 0;
+    do
+    {
+        for (i = 0; i < exclude_count; ++i)
+        {
+            if (!strcmp(exclude[i].name, data.cFileName))
+                break;
+        }
+        if (i < exclude_count || count == max_count || strlen(data.cFileName) >= sizeof(entries->name))
+            continue;
+        strcpy(entries[count].name, data.cFileName);
+        if (get_shader_cache_entry(dir, &entries[count]))
+            ++count;
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+
+    return count;
+}
+
+static void set_shader_cache_entry_time(const char *dir, const struct shader_cache_entry *entry, const FILETIME *time)
+{
+    char filename[MAX_PATH];
+    HANDLE file;
+
+    sprintf(filename, "%s\\%s", dir, entry->name);
+    file = CreateFileA(filename, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failed to open %s, error %u.\n", filename, GetLastError());
+    ok(SetFileTime(file, NULL, NULL, time), "Failed to set file time, error %u.\n", GetLastError());
+    CloseHandle(file);
+}
+
+static void draw_shader_cache_quad_(unsigned int line, IDirect3D9 *d3d, HWND window,
+        const DWORD *shader_code, D3DCOLOR expected)
+{
+    static const struct vec3 quad[] =
+    {
+        {-1.0f, -1.0f, 0.0f},
+        {-1.0f,  1.0f, 0.0f},
+        { 1.0f, -1.0f, 0.0f},
+        { 1.0f,  1.0f, 0.0f},
+    };
+    IDirect3DPixelShader9 *shader;
+    IDirect3DDevice9 *device;
+    D3DCOLOR color;
+    ULONG refcount;
+    HRESULT hr;
+
+    device = create_device(d3d, window, window, TRUE);
+    ok_(__FILE__, line)(!!device, "Failed to create a D3D device.\n");
+    if (!device)
+        return;
+
+    hr = IDirect3DDevice9_CreatePixelShader(device, shader_code, &shader);
+    ok_(__FILE__, line)(hr == D3D_OK, "Failed to create pixel shader, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetPixelShader(device, shader);
+    ok_(__FILE__, line)(hr == D3D_OK, "Failed to set pixel shader, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetFVF(device, D3DFVF_XYZ);
+    ok_(__FILE__, line)(hr == D3D_OK, "Failed to set FVF, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetRenderState(device, D3DRS_LIGHTING, FALSE);
+    ok_(__FILE__, line)(hr == D3D_OK, "Failed to disable lighting, hr %#x.\n", hr);
+
+    hr = IDirect3DDevice9_Clear(device, 0, NULL, D3DCLEAR_TARGET, 0xffffffff, 1.0f, 0);
+    ok_(__FILE__, line)(hr == D3D_OK, "Failed to clear, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_BeginScene(device);
+    ok_(__FILE__, line)(hr == D3D_OK, "Failed to begin scene, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_DrawPrimitiveUP(device, D3DPT_TRIANGLESTRIP, 2, quad, sizeof(*quad));
+    ok_(__FILE__, line)(hr == D3D_OK, "Failed to draw, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_EndScene(device);
+    ok_(__FILE__, line)(hr == D3D_OK, "Failed to end scene, hr %#x.\n", hr);
+
+    color = getPixelColor(device, 320, 240);
+    ok_(__FILE__, line)(color_match(color, expected, 1), "Got unexpected color 0x%08x, expected 0x%08x.\n",
+            color, expected);
+
+    IDirect3DPixelShader9_Release(shader);
+    refcount = IDirect3DDevice9_Release(device);
+    ok_(__FILE__, line)(!refcount, "Device has %u references left.\n", refcount);
+}
+#define draw_shader_cache_quad(a, b, c, d) draw_shader_cache_quad_(__LINE__, a, b, c, d)
+
+static void test_shader_cache(void)
+{
+    static const FILETIME old_time = {0x256d4000, 0x01bf53eb}; /* 2000-01-01 */
+    struct shader_cache_entry before[256], entries[8], entry;
+    char dir[MAX_PATH], filename[MAX_PATH];
+    IDirect3DDevice9 *device;
+    unsigned int count, i;
+    UINT64 driver_hash;
+    D3DCOLOR expected;
+    IDirect3D9 *d3d;
+    DWORD size, len;
+    D3DCAPS9 caps;
+    HANDLE file;
+    HWND window;
+    BYTE red;
+
+    DWORD shader_code[] =
+    {
+        0xffff0200,                                                             /* ps_2_0                      */
+        0x05000051, 0xa00f0000, 0x00000000, 0x3f000000, 0x3e800000, 0x3f800000, /* def c0, ?, 0.5, 0.25, 1.0  */
+        0x02000001, 0x800f0800, 0xa0e40000,                                     /* mov oC0, c0                 */
+        0x0000ffff                                                              /* end                         */
+    };
+
+    window = create_window();
+    d3d = Direct3DCreate9(D3D_SDK_VERSION);
+    ok(!!d3d, "Failed to create a D3D object.\n");
+    if (!(device = create_device(d3d, window, window, TRUE)))
+    {
+        skip("Failed to create a D3D device, skipping tests.\n");
+        goto done;
+    }
+    IDirect3DDevice9_GetDeviceCaps(device, &caps);
+    IDirect3DDevice9_Release(device);
+    if (caps.PixelShaderVersion < D3DPS_VERSION(2, 0))
+    {
+        skip("No ps_2_0 support, skipping shader cache tests.\n");
+        goto done;
+    }
+
+    len = GetEnvironmentVariableA("LOCALAPPDATA", dir, sizeof(dir));
+    if (!len || len >= sizeof(dir) - 32)
+    {
+        skip("No local application data directory, skipping shader cache tests.\n");
+        goto done;
+    }
+    strcat(dir, "\\wined3d\\shader_cache");
+
+    /* Use a constant which differs between runs, so that the first draw is
+     * guaranteed to miss the cache. */
+    red = 0x40 + (GetTickCount() & 0x7f);
+    *(float *)&shader_code[3] = red / 255.0f;
+    expected = (red << 16) | 0x008040;
+
+    count = get_shader_cache_entries(dir, before, ARRAY_SIZE(before), NULL, 0);
+    draw_shader_cache_quad(d3d, window, shader_code, expected);
+    if (GetFileAttributesA(dir) == INVALID_FILE_ATTRIBUTES)
+    {
+        skip("No shader cache, skipping tests.\n");
+        goto done;
+    }
+    count = get_shader_cache_entries(dir, entries, ARRAY_SIZE(entries), before, count);
+    ok(count, "Expected a new shader cache entry.\n");
+    if (!count)
+        goto done;
+
+    /* Miss: deleted entries are relinked and written back. */
+    for (i = 0; i < count; ++i)
+    {
+        sprintf(filename, "%s\\%s", dir, entries[i].name);
+        ok(DeleteFileA(filename), "Failed to delete %s, error %u.\n", filename, GetLastError());
+    }
+    draw_shader_cache_quad(d3d, window, shader_code, expected);
+    for (i = 0; i < count; ++i)
+    {
+        entry = entries[i];
+        ok(get_shader_cache_entry(dir, &entry), "Entry %s was not recreated.\n", entry.name);
+        ok(entry.driver_hash == entries[i].driver_hash, "Entry %s has a different driver key.\n", entry.name);
+        entries[i] = entry;
+    }
+
+    /* Hit: the entry is loaded in place, and its write time is refreshed for
+     * LRU eviction. */
+    for (i = 0; i < count; ++i)
+        set_shader_cache_entry_time(dir, &entries[i], &old_time);
+    draw_shader_cache_quad(d3d, window, shader_code, expected);
+    for (i = 0; i < count; ++i)
+    {
+        entry = entries[i];
+        ok(get_shader_cache_entry(dir, &entry), "Entry %s disappeared.\n", entry.name);
+        ok(entry.info.nFileIndexLow == entries[i].info.nFileIndexLow
+                && entry.info.nFileIndexHigh == entries[i].info.nFileIndexHigh,
+                "Entry %s was rewritten.\n", entry.name);
+        ok(CompareFileTime(&entry.info.ftLastWriteTime, &old_time) > 0,
+                "Entry %s was not touched.\n", entry.name);
+        entries[i] = entry;
+    }
+
+    /* Stale driver key: the entry is rejected, relinked and replaced. */
+    for (i = 0; i < count; ++i)
+    {
+        sprintf(filename, "%s\\%s", dir, entries[i].name);
+        file = CreateFileA(filename, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+        ok(file != INVALID_HANDLE_VALUE, "Failed to open %s, error %u.\n", filename, GetLastError());
+        driver_hash = ~entries[i].driver_hash;
+        SetFilePointer(file, 8, NULL, FILE_BEGIN);
+        ok(WriteFile(file, &driver_hash, sizeof(driver_hash), &size, NULL) && size == sizeof(driver_hash),
+                "Failed to write %s, error %u.\n", filename, GetLastError());
+        CloseHandle(file);
+    }
+    draw_shader_cache_quad(d3d, window, shader_code, expected);
+    for (i = 0; i < count; ++i)
+    {
+        entry = entries[i];
+        ok(get_shader_cache_entry(dir, &entry), "Entry %s was not recreated.\n", entry.name);
+        ok(entry.driver_hash == entries[i].driver_hash, "Stale entry %s was not replaced.\n", entry.name);
+        ok(entry.info.nFileIndexLow != entries[i].info.nFileIndexLow
+                || entry.info.nFileIndexHigh != entries[i].info.nFileIndexHigh,
+                "Stale entry %s was not rewritten.\n", entry.name);
+    }
+
+done:
+    IDirect3D9_Release(d3d);
+    DestroyWindow(window);
+}
+
 START_TEST(visual)
 {
     D3DADAPTER_IDENTIFIER9 identifier;
@@ -25703,4 +25946,5 @@ START_TEST(visual)
     test_map_synchronisation();
     test_color_vertex();
     test_sysmem_draw();
+    test_shader_cache();
 }
@@ -28,6 +28,7 @@
 #include "winbase.h"
 #include "winreg.h"
 #include "winternl.h"
+#include "psapi.h"
 #include "wine/test.h"
 
 #define MAGIC_DEAD 0xdeadbeef
@@ -41,6 +42,7 @@
 static BOOL (WINAPI *pHeapQueryInformation)(HANDLE, HEAP_INFORMATION_CLASS, PVOID, SIZE_T, PSIZE_T);
 static BOOL (WINAPI *pGetPhysicallyInstalledSystemMemory)(ULONGLONG *);
 static ULONG (WINAPI *pRtlGetNtGlobalFlags)(void);
+static BOOL (WINAPI *pK32GetProcessMemoryInfo)(HANDLE, PPROCESS_MEMORY_COUNTERS, DWORD);
 
 struct heap_layout
 {
@@ -892,6 +894,167 @@ static void test_HeapQueryInformation(void)
     ok(info == 0 || info == 1 || info == 2, "expected 0, 1 or 2, got %u\n", info);
 }
 
+static void test_low_fragmentation_heap(void)
+{
+    ULONG info;
+    HANDLE heap;
+    char *ptr, *ptr2;
+    SIZE_T size;
+    BOOL ret;
+    int i;
+
+    heap = HeapCreate( 0, 0, 0 );
+    ok( heap != NULL, "HeapCreate failed %u\n", GetLastError() );
+
+    ptr = HeapAlloc( heap, 0, 100 );
+    ok( ptr != NULL, "HeapAlloc failed\n" );
+
+    info = 2;
+    ret = HeapSetInformation( heap, HeapCompatibilityInformation, &info, sizeof(info) );
+    ok( ret, "HeapSetInformation failed %u\n", GetLastError() );
+    info = 0xdeadbeef;
+    ret = HeapQueryInformation( heap, HeapCompatibilityInformation, &info, sizeof(info), NULL );
+    ok( ret, "HeapQueryInformation failed %u\n", GetLastError() );
+    ok( info == 2, "expected 2, got %u\n", info );
+
+    info = 1;
+    SetLastError( 0xdeadbeef );
+    ret = HeapSetInformation( heap, HeapCompatibilityInformation, &info, sizeof(info) );
+    ok( !ret, "HeapSetInformation succeeded\n" );
+
+    /* blocks allocated before enabling the LFH stay valid */
+    size = HeapSize( heap, 0, ptr );
+    ok( size == 100, "wrong size %lu\n", size );
+    ret = HeapFree( heap, 0, ptr );
+    ok( ret, "HeapFree failed\n" );
+
+    for (i = 0; i < 20; i++)
+    {
+        SIZE_T alloc_size = (SIZE_T)1 << i;
+
+        ptr = HeapAlloc( heap, HEAP_ZERO_MEMORY, alloc_size );
+        ok( ptr != NULL, "HeapAlloc failed for size %lu\n", alloc_size );
+        ok( !((ULONG_PTR)ptr & (2 * sizeof(void *) - 1)), "wrong alignment %p\n", ptr );
+        ok( !ptr[alloc_size - 1], "memory not zeroed for size %lu\n", alloc_size );
+        size = HeapSize( heap, 0, ptr );
+        ok( size == alloc_size, "wrong size %lu/%lu\n", size, alloc_size );
+        ok( HeapValidate( heap, 0, ptr ), "HeapValidate failed for size %lu\n", alloc_size );
+        memset( ptr, 0x55, alloc_size );
+
+        ptr2 = HeapReAlloc( heap, HEAP_ZERO_MEMORY, ptr, alloc_size + 1 );
+        ok( ptr2 != NULL, "HeapReAlloc failed for size %lu\n", alloc_size );
+        ok( ptr2[0] == 0x55 && ptr2[alloc_size - 1] == 0x55, "data not preserved for size %lu\n", alloc_size );
+        ok( !ptr2[alloc_size], "memory not zeroed for size %lu\n", alloc_size );
+        size = HeapSize( heap, 0, ptr2 );
+        ok( size == alloc_size + 1, "wrong size %lu/%lu\n", size, alloc_size + 1 );
+
+        ptr = HeapReAlloc( heap, 0, ptr2, 1 );
+        ok( ptr != NULL, "HeapReAlloc failed for size %lu\n", alloc_size );
+        ok( ptr[0] == 0x55, "data not preserved for size %lu\n", alloc_size );
+        ret = HeapFree( heap, 0, ptr );
+        ok( ret, "HeapFree failed for size %lu\n", alloc_size );
+    }
+
+    ret = HeapDestroy( heap );
+    ok( ret, "HeapDestroy failed\n" );
+
+    /* the LFH cannot be enabled on non growable heaps */
+    heap = HeapCreate( 0, 0x10000, 0x10000 );
+    ok( heap != NULL, "HeapCreate failed %u\n", GetLastError() );
+    info = 2;
+    SetLastError( 0xdeadbeef );
+    ret = HeapSetInformation( heap, HeapCompatibilityInformation, &info, sizeof(info) );
+    ok( !ret, "HeapSetInformation succeeded\n" );
+    HeapDestroy( heap );
+}
+
+struct heap_bench
+{
+    HANDLE heap;
+    HANDLE start;
+    LONG   count;
+    DWORD  seed;
+};
+
+static DWORD WINAPI heap_bench_thread( void *arg )
+{
+    struct heap_bench *bench = arg;
+    void *blocks[256] = { NULL };
+    DWORD seed = InterlockedIncrement( (LONG *)&bench->seed );
+    LONG i, index;
+    SIZE_T size;
+
+    WaitForSingleObject( bench->start, INFINITE );
+    for (i = 0; i < bench->count; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        index = (seed >> 8) % ARRAY_SIZE(blocks);
+        /* mostly small blocks, with an occasional larger one */
+        if ((seed >> 24) < 0xf0) size = 8 + (seed >> 16) % 248;
+        else size = 256 + (seed >> 12) % 0x3f00;
+        HeapFree( bench->heap, 0, blocks[index] );
+        blocks[index] = HeapAlloc( bench->heap, 0, size );
+    }
+    for (i = 0; i < ARRAY_SIZE(blocks); i++) HeapFree( bench->heap, 0, blocks[i] );
+    return 0;
+}
+
+static void test_heap_performance( ULONG compat )
+{
+    static const unsigned int max_threads = 64;
+    LARGE_INTEGER freq, start, end;
+    PROCESS_MEMORY_COUNTERS counters;
+    struct heap_bench bench;
+    HANDLE threads[64];
+    unsigned int i, nb_threads;
+    double elapsed;
+
+    if (!pK32GetProcessMemoryInfo)
+        pK32GetProcessMemoryInfo = (void *)GetProcAddress( GetModuleHandleA("kernel32.dll"), "K32GetProcessMemoryInfo" );
+    QueryPerformanceFrequency( &freq );
+
+    for (nb_threads = 1; nb_threads <= max_threads; nb_threads *= 2)
+    {
+        bench.heap = HeapCreate( 0, 0, 0 );
+        ok( bench.heap != NULL, "HeapCreate failed %u\n", GetLastError() );
+        if (compat && !HeapSetInformation( bench.heap, HeapCompatibilityInformation, &compat, sizeof(compat) ))
+        {
+            skip( "failed to set heap compatibility %u, error %u\n", compat, GetLastError() );
+            HeapDestroy( bench.heap );
+            return;
+        }
+        bench.start = CreateEventA( NULL, TRUE, FALSE, NULL );
+        bench.count = winetest_interactive ? 4000000 / nb_threads : 1000;
+        bench.seed = 0;
+
+        for (i = 0; i < nb_threads; i++)
+        {
+            threads[i] = CreateThread( NULL, 0, heap_bench_thread, &bench, 0, NULL );
+            ok( threads[i] != NULL, "CreateThread failed %u\n", GetLastError() );
+        }
+        QueryPerformanceCounter( &start );
+        SetEvent( bench.start );
+        WaitForMultipleObjects( nb_threads, threads, TRUE, INFINITE );
+        QueryPerformanceCounter( &end );
+        ok( HeapValidate( bench.heap, 0, NULL ), "compat %u, %u threads: heap is corrupted\n", compat, nb_threads );
+
+        if (winetest_interactive)
+        {
+            elapsed = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+            memset( &counters, 0, sizeof(counters) );
+            if (pK32GetProcessMemoryInfo)
+                pK32GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof(counters) );
+            trace( "compat %u, %2u threads: %.0f ops/s, working set %u KB, peak %u KB\n",
+                   compat, nb_threads, 2.0 * bench.count * nb_threads / elapsed,
+                   (ULONG)(counters.WorkingSetSize / 1024), (ULONG)(counters.PeakWorkingSetSize / 1024) );
+        }
+
+        for (i = 0; i < nb_threads; i++) CloseHandle( threads[i] );
+        CloseHandle( bench.start );
+        HeapDestroy( bench.heap );
+    }
+}
+
 static void test_heap_checks( DWORD flags )
 {
     BYTE old, *p, *p2;
@@ -1246,6 +1409,9 @@ START_TEST(heap)
 
     test_HeapQueryInformation();
     test_GetPhysicallyInstalledSystemMemory();
+    test_low_fragmentation_heap();
+    test_heap_performance( 0 );
+    test_heap_performance( 2 );
 
     if (pRtlGetNtGlobalFlags)
     {
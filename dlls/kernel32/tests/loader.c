@@ -3858,6 +3858,51 @@ static void test_dll_file( const char *name )
 #undef OK_FIELD
 }
 
+static void test_export_lookup_performance( const char *name )
+{
+    HMODULE module = GetModuleHandleA( name );
+    const IMAGE_EXPORT_DIRECTORY *exports;
+    const DWORD *names, *functions;
+    const WORD *ordinals;
+    LARGE_INTEGER freq, start, end;
+    unsigned int i, round, found = 0;
+    ULONG size;
+    void *proc;
+
+    exports = pRtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_EXPORT, &size );
+    ok( exports != NULL, "%s: no exports\n", name );
+    if (!exports) return;
+    names = (const DWORD *)((const char *)module + exports->AddressOfNames);
+    ordinals = (const WORD *)((const char *)module + exports->AddressOfNameOrdinals);
+    functions = (const DWORD *)((const char *)module + exports->AddressOfFunctions);
+
+    for (i = 0; i < exports->NumberOfNames; i++)
+    {
+        const char *export = (const char *)module + names[i];
+        DWORD rva = functions[ordinals[i]];
+
+        proc = GetProcAddress( module, export );
+        if (proc) found++;
+        /* forwarded exports point inside the export directory */
+        if (rva >= (const char *)exports - (const char *)module &&
+            rva < (const char *)exports - (const char *)module + size) continue;
+        ok( proc == (const char *)module + rva, "%s: wrong address %p / %p for %s\n",
+            name, proc, (const char *)module + rva, export );
+    }
+    ok( !GetProcAddress( module, "__wine_no_such_export" ), "%s: found a missing export\n", name );
+
+    if (!winetest_interactive) return;
+
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &start );
+    for (round = 0; round < 100; round++)
+        for (i = 0; i < exports->NumberOfNames; i++)
+            GetProcAddress( module, (const char *)module + names[i] );
+    QueryPerformanceCounter( &end );
+    trace( "%s: %u names, %u found, %.0f lookups/s\n", name, exports->NumberOfNames, found,
+           100.0 * exports->NumberOfNames / ((double)(end.QuadPart - start.QuadPart) / freq.QuadPart) );
+}
+
 START_TEST(loader)
 {
     int argc;
@@ -3929,6 +3974,8 @@ START_TEST(loader)
     test_dll_file( "kernel32.dll" );
     test_dll_file( "advapi32.dll" );
     test_dll_file( "user32.dll" );
+    test_export_lookup_performance( "ntdll.dll" );
+    test_export_lookup_performance( "kernel32.dll" );
     /* loader test must be last, it can corrupt the internal loader state on Windows */
     test_Loader();
 }
@@ -2675,6 +2675,74 @@ static void test_crit_section(void)
     ok(cs.DebugInfo == NULL, "Unexpected debug info pointer %p.\n", cs.DebugInfo);
 }
 
+struct crit_section_bench
+{
+    CRITICAL_SECTION cs;
+    HANDLE           start;
+    unsigned int     count;
+    LONG             value;
+};
+
+static volatile unsigned int crit_section_bench_dummy;
+
+static DWORD WINAPI crit_section_bench_thread( void *arg )
+{
+    struct crit_section_bench *bench = arg;
+    unsigned int i, j;
+
+    WaitForSingleObject( bench->start, INFINITE );
+    for (i = 0; i < bench->count; i++)
+    {
+        EnterCriticalSection( &bench->cs );
+        for (j = 0; j < 16; j++) bench->value++;
+        LeaveCriticalSection( &bench->cs );
+        for (j = 0; j < 16; j++) crit_section_bench_dummy = j;
+    }
+    return 0;
+}
+
+static void test_crit_section_performance(void)
+{
+    static const unsigned int max_threads = 16;
+    LARGE_INTEGER freq, start, end;
+    struct crit_section_bench bench;
+    HANDLE threads[16];
+    unsigned int i, nb_threads;
+    double elapsed;
+
+    QueryPerformanceFrequency( &freq );
+
+    for (nb_threads = 1; nb_threads <= max_threads; nb_threads *= 2)
+    {
+        InitializeCriticalSection( &bench.cs );
+        bench.start = CreateEventA( NULL, TRUE, FALSE, NULL );
+        bench.count = winetest_interactive ? 4000000 / nb_threads : 1000;
+        bench.value = 0;
+
+        for (i = 0; i < nb_threads; i++)
+        {
+            threads[i] = CreateThread( NULL, 0, crit_section_bench_thread, &bench, 0, NULL );
+            ok( threads[i] != NULL, "CreateThread failed %u\n", GetLastError() );
+        }
+        QueryPerformanceCounter( &start );
+        SetEvent( bench.start );
+        WaitForMultipleObjects( nb_threads, threads, TRUE, INFINITE );
+        QueryPerformanceCounter( &end );
+
+        ok( bench.value == 16 * bench.count * nb_threads, "got %d, expected %u\n",
+            bench.value, 16 * bench.count * nb_threads );
+        if (winetest_interactive)
+        {
+            elapsed = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+            trace( "%2u threads: %.0f acquires/s\n", nb_threads, bench.count * nb_threads / elapsed );
+        }
+
+        for (i = 0; i < nb_threads; i++) CloseHandle( threads[i] );
+        CloseHandle( bench.start );
+        DeleteCriticalSection( &bench.cs );
+    }
+}
+
 START_TEST(sync)
 {
     char **argv;
@@ -2735,4 +2803,5 @@ START_TEST(sync)
     test_alertable_wait();
     test_apc_deadlock();
     test_crit_section();
+    test_crit_section_performance();
 }
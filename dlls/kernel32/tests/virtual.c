@@ -4381,6 +4381,91 @@ static void test_shared_memory_ro(BOOL is_child, DWORD child_access)
     CloseHandle(mapping);
 }
 
+struct virtual_bench
+{
+    HANDLE start;
+    LONG   count;
+    LONG   seed;
+};
+
+static DWORD WINAPI virtual_bench_thread( void *arg )
+{
+    struct virtual_bench *bench = arg;
+    void *blocks[256] = { NULL };
+    DWORD seed = InterlockedIncrement( &bench->seed ), old_prot;
+    MEMORY_BASIC_INFORMATION info;
+    SIZE_T size;
+    LONG i, index;
+
+    WaitForSingleObject( bench->start, INFINITE );
+    for (i = 0; i < bench->count; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        index = (seed >> 8) % ARRAY_SIZE(blocks);
+        size = (1 + (seed >> 16) % 64) * 0x1000;
+        if (blocks[index])
+        {
+            VirtualQuery( blocks[index], &info, sizeof(info) );
+            ok( info.AllocationBase == blocks[index] && info.Protect == PAGE_READONLY,
+                "%p: got base %p, protection %#x\n", blocks[index], info.AllocationBase, info.Protect );
+            VirtualFree( blocks[index], 0, MEM_RELEASE );
+        }
+        blocks[index] = VirtualAlloc( NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+        ok( blocks[index] != NULL, "VirtualAlloc failed %u\n", GetLastError() );
+        if (!blocks[index]) break;
+        VirtualProtect( blocks[index], 0x1000, PAGE_READONLY, &old_prot );
+    }
+    for (i = 0; i < ARRAY_SIZE(blocks); i++)
+        if (blocks[i]) VirtualFree( blocks[i], 0, MEM_RELEASE );
+    return 0;
+}
+
+static void test_virtual_performance(void)
+{
+    static const unsigned int max_threads = 16;
+    LARGE_INTEGER freq, start, end;
+    struct virtual_bench bench;
+    HANDLE threads[16];
+    void *views[4096];
+    unsigned int i, nb_threads;
+    double elapsed;
+
+    /* populate the address space with many views, to make lookups more expensive */
+    for (i = 0; i < ARRAY_SIZE(views); i++)
+        views[i] = VirtualAlloc( NULL, 0x1000, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+
+    QueryPerformanceFrequency( &freq );
+    for (nb_threads = 1; nb_threads <= max_threads; nb_threads *= 2)
+    {
+        bench.start = CreateEventA( NULL, TRUE, FALSE, NULL );
+        bench.count = winetest_interactive ? 200000 / nb_threads : 500;
+        bench.seed = 0;
+
+        for (i = 0; i < nb_threads; i++)
+        {
+            threads[i] = CreateThread( NULL, 0, virtual_bench_thread, &bench, 0, NULL );
+            ok( threads[i] != NULL, "CreateThread failed %u\n", GetLastError() );
+        }
+        QueryPerformanceCounter( &start );
+        SetEvent( bench.start );
+        WaitForMultipleObjects( nb_threads, threads, TRUE, INFINITE );
+        QueryPerformanceCounter( &end );
+
+        if (winetest_interactive)
+        {
+            elapsed = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+            /* each iteration does a query, a free, an alloc and a protect, except for the first ones */
+            trace( "%2u threads: %.0f calls/s\n", nb_threads, 4.0 * bench.count * nb_threads / elapsed );
+        }
+
+        for (i = 0; i < nb_threads; i++) CloseHandle( threads[i] );
+        CloseHandle( bench.start );
+    }
+
+    for (i = 0; i < ARRAY_SIZE(views); i++)
+        if (views[i]) VirtualFree( views[i], 0, MEM_RELEASE );
+}
+
 START_TEST(virtual)
 {
     int argc;
@@ -4460,6 +4545,7 @@ START_TEST(virtual)
     test_IsBadWritePtr();
     test_IsBadCodePtr();
     test_write_watch();
+    test_virtual_performance();
 #if defined(__i386__) || defined(__x86_64__)
     test_stack_commit();
 #endif
@@ -25,6 +25,8 @@
 #include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #ifdef HAVE_SYS_SYSCALL_H
 #include <sys/syscall.h>
@@ -52,7 +54,7 @@ static inline LONG interlocked_dec( PLONG dest )
 
 static inline void small_pause(void)
 {
-#ifdef __i386__
+#if defined(__i386__) || defined(__x86_64__)
     __asm__ __volatile__( "rep;nop" : : : "memory" );
 #else
     __asm__ __volatile__( "" : : : "memory" );
@@ -247,6 +249,230 @@ static inline NTSTATUS wait_semaphore( RTL_CRITICAL_SECTION *crit, int timeout )
     return ret;
 }
 
+/* dynamic spinning: the low bits of SpinCount hold a running estimate of the
+ * number of spins it takes for the owner to release the section */
+#define DYNAMIC_SPIN_MASK 0x00ffffff
+#define DYNAMIC_SPIN_MIN  64
+#define DYNAMIC_SPIN_MAX  4000
+
+/***********************************************************************
+ *           spin_critical_section
+ *
+ * Spin for a while waiting for the section to be released. Returns TRUE
+ * if the section was acquired.
+ */
+static inline BOOL spin_critical_section( RTL_CRITICAL_SECTION *crit )
+{
+    ULONG_PTR spincount = crit->SpinCount;
+    ULONG count, limit, estimate = 0;
+    BOOL dynamic = (spincount & RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN) != 0;
+
+    if (dynamic)
+    {
+        estimate = spincount & DYNAMIC_SPIN_MASK;
+        limit = min( 2 * estimate + DYNAMIC_SPIN_MIN, DYNAMIC_SPIN_MAX );
+    }
+    else limit = spincount;
+
+    for (count = 0; count < limit; count++)
+    {
+        if (crit->LockCount > 0) break;  /* more than one waiter, don't bother spinning */
+        if (crit->LockCount == -1)       /* try again */
+        {
+            if (interlocked_cmpxchg( &crit->LockCount, 0, -1 ) == -1)
+            {
+                /* move the estimate 1/8th of the way towards the observed spin count;
+                 * the update is racy but only affects the heuristic */
+                if (dynamic) crit->SpinCount = RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN |
+                                               (estimate + ((LONG)count - (LONG)estimate) / 8);
+                return TRUE;
+            }
+        }
+        small_pause();
+    }
+    /* spinning didn't pay off, spin less next time */
+    if (dynamic) crit->SpinCount = RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN | (estimate - estimate / 8);
+    return FALSE;
+}
+
+
+/* contention profiler, enabled with WINE_CS_PROFILE */
+
+#define CS_PROFILE_SIZE     4096  /* must be a power of 2 */
+#define CS_PROFILE_BLOCKERS 4
+#define CS_PROFILE_DUMP_MAX 50
+#define CS_PROFILE_DELETED  ((RTL_CRITICAL_SECTION *)1)
+
+struct cs_profile
+{
+    RTL_CRITICAL_SECTION *crit;         /* section, or CS_PROFILE_DELETED */
+    void                 *owner;        /* caller that last acquired the section */
+    ULONG                 acquires;     /* number of acquisitions */
+    ULONG                 spins;        /* acquisitions that succeeded while spinning */
+    ULONG                 contentions;  /* acquisitions that had to wait */
+    LONGLONG              wait_time;    /* total wait time, in performance counter ticks */
+    LONGLONG              max_wait;     /* longest single wait */
+    struct
+    {
+        void *caller;                   /* owner call site that blocked us */
+        ULONG count;
+    } blockers[CS_PROFILE_BLOCKERS];
+    char                  name[48];     /* copy of the debug info name */
+};
+
+static struct cs_profile *cs_profile;
+
+/***********************************************************************
+ *           get_cs_profile
+ *
+ * Find the profile entry of a section, optionally creating it.
+ */
+static struct cs_profile *get_cs_profile( RTL_CRITICAL_SECTION *crit, BOOL create )
+{
+    ULONG_PTR hash = ((ULONG_PTR)crit >> 3) * 0x9e3779b1;
+    unsigned int i, pos;
+
+    for (i = 0; i < CS_PROFILE_SIZE; i++)
+    {
+        struct cs_profile *entry;
+
+        pos = (hash + i) & (CS_PROFILE_SIZE - 1);
+        entry = &cs_profile[pos];
+        if (entry->crit == crit) return entry;
+        if (entry->crit) continue;
+        if (!create) return NULL;
+        if (interlocked_cmpxchg_ptr( (void **)&entry->crit, crit, NULL )) continue;
+        if (crit_section_has_debuginfo( crit ) && crit->DebugInfo->Spare[0])
+        {
+            const char *name = (const char *)crit->DebugInfo->Spare[0];
+            memcpy( entry->name, name, min( strlen(name), sizeof(entry->name) - 1 ));
+        }
+        return entry;
+    }
+    return NULL;
+}
+
+/***********************************************************************
+ *           profile_acquire
+ *
+ * Record an acquisition. Called with the section held, which protects the entry.
+ */
+static void profile_acquire( RTL_CRITICAL_SECTION *crit, void *caller, BOOL spun )
+{
+    struct cs_profile *entry = get_cs_profile( crit, TRUE );
+
+    if (!entry) return;
+    entry->owner = caller;
+    entry->acquires++;
+    if (spun) entry->spins++;
+}
+
+/***********************************************************************
+ *           profile_contention
+ *
+ * Record a wait. Called with the section held, which protects the entry.
+ */
+static void profile_contention( RTL_CRITICAL_SECTION *crit, void *blocker, LONGLONG time )
+{
+    struct cs_profile *entry = get_cs_profile( crit, TRUE );
+    unsigned int i, min = 0;
+
+    if (!entry) return;
+    entry->contentions++;
+    entry->wait_time += time;
+    if (time > entry->max_wait) entry->max_wait = time;
+    if (!blocker) return;
+
+    for (i = 0; i < CS_PROFILE_BLOCKERS; i++)
+    {
+        if (entry->blockers[i].caller == blocker) break;
+        if (entry->blockers[i].count < entry->blockers[min].count) min = i;
+    }
+    if (i == CS_PROFILE_BLOCKERS)
+    {
+        /* replace the least frequent call site, keeping its count as an upper bound */
+        i = min;
+        entry->blockers[i].caller = blocker;
+    }
+    entry->blockers[i].count++;
+}
+
+static int cs_profile_compare( const void *a, const void *b )
+{
+    const struct cs_profile *p1 = *(const struct cs_profile * const *)a;
+    const struct cs_profile *p2 = *(const struct cs_profile * const *)b;
+
+    if (p1->wait_time != p2->wait_time) return p1->wait_time > p2->wait_time ? -1 : 1;
+    if (p1->contentions != p2->contentions) return p1->contentions > p2->contentions ? -1 : 1;
+    return 0;
+}
+
+static const char *debugstr_caller( void *caller )
+{
+    LDR_MODULE *mod;
+
+    if (!LdrFindEntryForAddress( caller, &mod ))
+        return wine_dbg_sprintf( "%p (%s+0x%lx)", caller,
+                                 debugstr_wn( mod->BaseDllName.Buffer, mod->BaseDllName.Length / sizeof(WCHAR) ),
+                                 (ULONG_PTR)caller - (ULONG_PTR)mod->BaseAddress );
+    return wine_dbg_sprintf( "%p", caller );
+}
+
+/***********************************************************************
+ *           critsection_init
+ */
+void critsection_init(void)
+{
+    const char *env = getenv( "WINE_CS_PROFILE" );
+    SIZE_T size = CS_PROFILE_SIZE * sizeof(*cs_profile);
+    void *addr = NULL;
+
+    if (!env || !atoi( env )) return;
+    if (NtAllocateVirtualMemory( NtCurrentProcess(), &addr, 0, &size, MEM_COMMIT, PAGE_READWRITE )) return;
+    cs_profile = addr;
+}
+
+/***********************************************************************
+ *           critsection_dump_profile
+ *
+ * Print the most contended sections on exit. Called with the loader lock held.
+ */
+void critsection_dump_profile(void)
+{
+    struct cs_profile **sorted;
+    LARGE_INTEGER freq, dummy;
+    unsigned int i, j, count = 0;
+
+    if (!cs_profile) return;
+    if (!(sorted = RtlAllocateHeap( GetProcessHeap(), 0, CS_PROFILE_SIZE * sizeof(*sorted) ))) return;
+
+    for (i = 0; i < CS_PROFILE_SIZE; i++)
+        if (cs_profile[i].crit && cs_profile[i].contentions) sorted[count++] = &cs_profile[i];
+    qsort( sorted, count, sizeof(*sorted), cs_profile_compare );
+
+    NtQueryPerformanceCounter( &dummy, &freq );
+    MESSAGE( "wine: critical section profile for process %04x, %u contended sections\n",
+             GetCurrentProcessId(), count );
+    for (i = 0; i < min( count, CS_PROFILE_DUMP_MAX ); i++)
+    {
+        struct cs_profile *entry = sorted[i];
+
+        MESSAGE( "%p %s: %u acquires, %u spun, %u contended, wait %u ms (max %u ms)\n",
+                 entry->crit == CS_PROFILE_DELETED ? NULL : entry->crit,
+                 entry->name[0] ? debugstr_a(entry->name) : "?",
+                 entry->acquires, entry->spins, entry->contentions,
+                 (ULONG)(entry->wait_time * 1000 / freq.QuadPart),
+                 (ULONG)(entry->max_wait * 1000 / freq.QuadPart) );
+        for (j = 0; j < CS_PROFILE_BLOCKERS; j++)
+        {
+            if (!entry->blockers[j].caller) continue;
+            MESSAGE( "    held by %s: %u times\n",
+                     debugstr_caller( entry->blockers[j].caller ), entry->blockers[j].count );
+        }
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, sorted );
+}
+
 /***********************************************************************
  *           RtlInitializeCriticalSection   (NTDLL.@)
  *
@@ -266,7 +492,7 @@ static inline NTSTATUS wait_semaphore( RTL_CRITICAL_SECTION *crit, int timeout )
  */
 NTSTATUS WINAPI RtlInitializeCriticalSection( RTL_CRITICAL_SECTION *crit )
 {
-    return RtlInitializeCriticalSectionEx( crit, 0, 0 );
+    return RtlInitializeCriticalSectionEx( crit, 0, RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN );
 }
 
 /***********************************************************************
@@ -318,7 +544,7 @@ NTSTATUS WINAPI RtlInitializeCriticalSectionAndSpinCount( RTL_CRITICAL_SECTION *
  */
 NTSTATUS WINAPI RtlInitializeCriticalSectionEx( RTL_CRITICAL_SECTION *crit, ULONG spincount, ULONG flags )
 {
-    if (flags & (RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN|RTL_CRITICAL_SECTION_FLAG_STATIC_INIT))
+    if (flags & RTL_CRITICAL_SECTION_FLAG_STATIC_INIT)
         FIXME("(%p,%u,0x%08x) semi-stub\n", crit, spincount, flags);
 
     /* FIXME: if RTL_CRITICAL_SECTION_FLAG_STATIC_INIT is given, we should use
@@ -348,8 +574,11 @@ NTSTATUS WINAPI RtlInitializeCriticalSectionEx( RTL_CRITICAL_SECTION *crit, ULON
     crit->RecursionCount = 0;
     crit->OwningThread   = 0;
     crit->LockSemaphore  = 0;
-    if (NtCurrentTeb()->Peb->NumberOfProcessors <= 1) spincount = 0;
-    crit->SpinCount = spincount & ~0x80000000;
+    if (NtCurrentTeb()->Peb->NumberOfProcessors <= 1) crit->SpinCount = 0;
+    else if (flags & RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN)
+        crit->SpinCount = RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN | min( spincount & DYNAMIC_SPIN_MASK, DYNAMIC_SPIN_MAX );
+    else
+        crit->SpinCount = spincount & ~0x80000000;
     return STATUS_SUCCESS;
 }
 
@@ -401,6 +630,11 @@ ULONG WINAPI RtlSetCriticalSectionSpinCount( RTL_CRITICAL_SECTION *crit, ULONG s
  */
 NTSTATUS WINAPI RtlDeleteCriticalSection( RTL_CRITICAL_SECTION *crit )
 {
+    if (cs_profile)
+    {
+        struct cs_profile *entry = get_cs_profile( crit, FALSE );
+        if (entry) entry->crit = CS_PROFILE_DELETED;
+    }
     crit->LockCount      = -1;
     crit->RecursionCount = 0;
     crit->OwningThread   = 0;
@@ -444,6 +678,9 @@ NTSTATUS WINAPI RtlDeleteCriticalSection( RTL_CRITICAL_SECTION *crit )
 NTSTATUS WINAPI RtlpWaitForCriticalSection( RTL_CRITICAL_SECTION *crit )
 {
     LONGLONG timeout = NtCurrentTeb()->Peb->CriticalSectionTimeout.QuadPart / -10000000;
+    struct cs_profile *entry;
+    LARGE_INTEGER start, end;
+    void *blocker = NULL;
 
     /* Don't allow blocking on a critical section during process termination */
     if (RtlDllShutdownInProgress())
@@ -453,6 +690,12 @@ NTSTATUS WINAPI RtlpWaitForCriticalSection( RTL_CRITICAL_SECTION *crit )
         return STATUS_SUCCESS;
     }
 
+    if (cs_profile)
+    {
+        if ((entry = get_cs_profile( crit, FALSE ))) blocker = entry->owner;
+        NtQueryPerformanceCounter( &start, NULL );
+    }
+
     for (;;)
     {
         EXCEPTION_RECORD rec;
@@ -494,6 +737,11 @@ NTSTATUS WINAPI RtlpWaitForCriticalSection( RTL_CRITICAL_SECTION *crit )
         RtlRaiseException( &rec );
     }
     if (crit_section_has_debuginfo( crit )) crit->DebugInfo->ContentionCount++;
+    if (cs_profile)
+    {
+        NtQueryPerformanceCounter( &end, NULL );
+        profile_contention( crit, blocker, end.QuadPart - start.QuadPart );
+    }
     return STATUS_SUCCESS;
 }
 
@@ -555,20 +803,12 @@ NTSTATUS WINAPI RtlpUnWaitCriticalSection( RTL_CRITICAL_SECTION *crit )
  */
 NTSTATUS WINAPI RtlEnterCriticalSection( RTL_CRITICAL_SECTION *crit )
 {
+    BOOL spun = FALSE;
+
     if (crit->SpinCount)
     {
-        ULONG count;
-
-        if (RtlTryEnterCriticalSection( crit )) return STATUS_SUCCESS;
-        for (count = crit->SpinCount; count > 0; count--)
-        {
-            if (crit->LockCount > 0) break;  /* more than one waiter, don't bother spinning */
-            if (crit->LockCount == -1)       /* try again */
-            {
-                if (interlocked_cmpxchg( &crit->LockCount, 0, -1 ) == -1) goto done;
-            }
-            small_pause();
-        }
+        if (RtlTryEnterCriticalSection( crit )) goto profile;
+        if ((spun = spin_critical_section( crit ))) goto done;
     }
 
     if (interlocked_inc( &crit->LockCount ))
@@ -585,6 +825,8 @@ NTSTATUS WINAPI RtlEnterCriticalSection( RTL_CRITICAL_SECTION *crit )
 done:
     crit->OwningThread   = ULongToHandle(GetCurrentThreadId());
     crit->RecursionCount = 1;
+profile:
+    if (cs_profile && crit->RecursionCount == 1) profile_acquire( crit, __builtin_return_address(0), spun );
     return STATUS_SUCCESS;
 }
 
@@ -35,6 +35,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <limits.h>
+#include <signal.h>
 #ifdef HAVE_MNTENT_H
 #include <mntent.h>
 #endif
@@ -91,6 +92,9 @@
 #ifdef HAVE_SYS_STATFS_H
 #include <sys/statfs.h>
 #endif
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
 #include <time.h>
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
@@ -2024,6 +2028,508 @@ NTSTATUS WINAPI DECLSPEC_HOTPATCH NtQueryDirectoryFile( HANDLE handle, HANDLE ev
 }
 
 
+/* cache of directory contents for case-insensitive lookups */
+
+#define DIR_CACHE_MAX_ENTRIES 64
+
+struct dir_cache
+{
+    struct list           entry;       /* entry in the LRU list */
+    struct file_identity  id;          /* directory file identity */
+    ULONGLONG             mtime;       /* directory modification time when read, in ns */
+    BOOL                  racy;        /* directory was modified too recently to trust the mtime */
+    int                   watch;       /* inotify watch descriptor, or -1 */
+    struct dir_data      *data;        /* directory contents */
+    unsigned int          hash_size;   /* size of the hash tables, a power of 2 */
+    unsigned int         *long_hash;   /* long names hash table, entries are names index + 1 */
+    unsigned int         *short_hash;  /* short names hash table */
+};
+
+static struct list dir_cache_list = LIST_INIT( dir_cache_list );
+static unsigned int dir_cache_count;
+static int dir_cache_inotify = -2;  /* -2 means not initialized yet */
+
+static RTL_CRITICAL_SECTION dir_cache_section;
+static RTL_CRITICAL_SECTION_DEBUG dir_cache_critsect_debug =
+{
+    0, 0, &dir_cache_section,
+    { &dir_cache_critsect_debug.ProcessLocksList, &dir_cache_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": dir_cache_section") }
+};
+static RTL_CRITICAL_SECTION dir_cache_section = { &dir_cache_critsect_debug, -1, 0, 0, 0, 0 };
+
+static inline ULONGLONG get_dir_mtime( const struct stat *st )
+{
+    ULONGLONG ret = (ULONGLONG)st->st_mtime * 1000000000;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    ret += st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    ret += st->st_mtimespec.tv_nsec;
+#endif
+    return ret;
+}
+
+/* case-insensitive hash of a file name, consistent with strncmpiW */
+static inline unsigned int hash_dir_cache_name( const WCHAR *name, int length )
+{
+    unsigned int hash = 0;
+    int i;
+
+    for (i = 0; i < length; i++) hash = hash * 31 + tolowerW( name[i] );
+    return hash;
+}
+
+static void free_dir_cache( struct dir_cache *cache )
+{
+#ifdef HAVE_SYS_INOTIFY_H
+    if (cache->watch != -1) inotify_rm_watch( dir_cache_inotify, cache->watch );
+#endif
+    list_remove( &cache->entry );
+    dir_cache_count--;
+    free_dir_data( cache->data );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->long_hash );
+    RtlFreeHeap( GetProcessHeap(), 0, cache );
+}
+
+/* drop the cached directories that have been modified; helper for get_dir_cache */
+static void process_dir_cache_events(void)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+    char buffer[4096] DECLSPEC_ALIGN(8);
+    struct dir_cache *cache, *next;
+    struct inotify_event *event;
+    int size, ofs;
+
+    if (dir_cache_inotify < 0) return;
+
+    while ((size = read( dir_cache_inotify, buffer, sizeof(buffer) )) > 0)
+    {
+        for (ofs = 0; ofs + sizeof(*event) <= size; ofs += sizeof(*event) + event->len)
+        {
+            event = (struct inotify_event *)(buffer + ofs);
+            LIST_FOR_EACH_ENTRY_SAFE( cache, next, &dir_cache_list, struct dir_cache, entry )
+            {
+                if (!(event->mask & IN_Q_OVERFLOW) && cache->watch != event->wd) continue;
+                TRACE( "dropping %x.%x\n", (int)cache->id.dev, (int)cache->id.ino );
+                free_dir_cache( cache );
+            }
+        }
+    }
+#endif
+}
+
+static void add_dir_cache_watch( struct dir_cache *cache, const char *unix_name )
+{
+    cache->watch = -1;
+#ifdef HAVE_SYS_INOTIFY_H
+    if (dir_cache_inotify == -2)
+    {
+        if ((dir_cache_inotify = inotify_init()) != -1)
+        {
+            fcntl( dir_cache_inotify, F_SETFD, FD_CLOEXEC );
+            fcntl( dir_cache_inotify, F_SETFL, O_NONBLOCK );
+        }
+    }
+    if (dir_cache_inotify == -1) return;
+    cache->watch = inotify_add_watch( dir_cache_inotify, unix_name,
+                                      IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                      IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR );
+#endif
+}
+
+/* build the hash tables of a cached directory */
+static BOOL init_dir_cache_hash( struct dir_cache *cache )
+{
+    unsigned int i, pos, mask, size = 16;
+
+    while (size < 2 * cache->data->count) size *= 2;
+    if (!(cache->long_hash = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                              2 * size * sizeof(*cache->long_hash) )))
+        return FALSE;
+    cache->short_hash = cache->long_hash + size;
+    cache->hash_size = size;
+    mask = size - 1;
+
+    /* entries are inserted in directory order, so lookups find the first match */
+    for (i = 0; i < cache->data->count; i++)
+    {
+        const struct dir_data_names *names = &cache->data->names[i];
+
+        pos = hash_dir_cache_name( names->long_name, strlenW( names->long_name ) ) & mask;
+        while (cache->long_hash[pos]) pos = (pos + 1) & mask;
+        cache->long_hash[pos] = i + 1;
+
+        if (!names->short_name[0]) continue;
+        pos = hash_dir_cache_name( names->short_name, strlenW( names->short_name ) ) & mask;
+        while (cache->short_hash[pos]) pos = (pos + 1) & mask;
+        cache->short_hash[pos] = i + 1;
+    }
+    return TRUE;
+}
+
+/* read the contents of a directory into a new cache entry */
+static struct dir_cache *create_dir_cache( const char *unix_name, const struct stat *st )
+{
+    struct dir_cache *cache;
+    struct dirent *de;
+    struct stat dir_st;
+    DIR *dir;
+    BOOL ret = FALSE;
+
+    if (!(cache = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cache) ))) return NULL;
+    if (!(cache->data = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cache->data) )))
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, cache );
+        return NULL;
+    }
+    cache->id.dev = st->st_dev;
+    cache->id.ino = st->st_ino;
+    cache->mtime  = get_dir_mtime( st );
+    /* a change in the same timestamp tick would go unnoticed, so only trust
+     * the mtime if the directory hasn't been modified recently */
+    cache->racy   = st->st_mtime + 2 >= time( NULL );
+    list_add_head( &dir_cache_list, &cache->entry );
+    dir_cache_count++;
+
+    /* add the watch first so that changes made while reading are not lost */
+    add_dir_cache_watch( cache, unix_name );
+
+    if ((dir = opendir( unix_name )))
+    {
+        if (!fstat( dirfd( dir ), &dir_st ) && dir_st.st_dev == st->st_dev && dir_st.st_ino == st->st_ino)
+        {
+            ret = TRUE;
+            while (ret && (de = readdir( dir )))
+            {
+                if (!strcmp( de->d_name, "." ) || !strcmp( de->d_name, ".." )) continue;
+                ret = append_entry( cache->data, de->d_name, NULL, NULL );
+            }
+        }
+        closedir( dir );
+    }
+    if (!ret || !init_dir_cache_hash( cache ))
+    {
+        free_dir_cache( cache );
+        return NULL;
+    }
+
+    TRACE( "cached %s %x.%x, %u entries\n", debugstr_a(unix_name),
+           (int)st->st_dev, (int)st->st_ino, cache->data->count );
+
+    if (dir_cache_count > DIR_CACHE_MAX_ENTRIES)
+        free_dir_cache( LIST_ENTRY( list_tail( &dir_cache_list ), struct dir_cache, entry ));
+    return cache;
+}
+
+/* retrieve the cached contents of a directory, reading it if necessary */
+static struct dir_cache *get_dir_cache( const char *unix_name, const struct stat *st )
+{
+    struct dir_cache *cache;
+
+    process_dir_cache_events();
+
+    LIST_FOR_EACH_ENTRY( cache, &dir_cache_list, struct dir_cache, entry )
+    {
+        if (cache->id.dev != st->st_dev || cache->id.ino != st->st_ino) continue;
+        if (cache->mtime != get_dir_mtime( st ) || (cache->racy && cache->watch == -1))
+        {
+            free_dir_cache( cache );
+            break;
+        }
+        list_remove( &cache->entry );
+        list_add_head( &dir_cache_list, &cache->entry );
+        return cache;
+    }
+    return create_dir_cache( unix_name, st );
+}
+
+/* look up a name in one of the hash tables, returning the names index or -1 */
+static int find_dir_cache_name( const struct dir_cache *cache, const unsigned int *table,
+                                const WCHAR *name, int length, BOOL short_name )
+{
+    unsigned int pos, mask = cache->hash_size - 1;
+
+    for (pos = hash_dir_cache_name( name, length ) & mask; table[pos]; pos = (pos + 1) & mask)
+    {
+        const struct dir_data_names *names = &cache->data->names[table[pos] - 1];
+        const WCHAR *str = short_name ? names->short_name : names->long_name;
+
+        if (strlenW( str ) == length && !strncmpiW( str, name, length )) return table[pos] - 1;
+    }
+    return -1;
+}
+
+/* prefix-wide index of case-insensitive lookups, shared by all processes through a file mapping */
+
+#define NAME_INDEX_MAGIC   0x58444e49  /* "INDX" */
+#define NAME_INDEX_VERSION 2
+#define NAME_INDEX_ENTRIES 65536       /* must be a power of 2 */
+#define NAME_INDEX_POOL    (4 * 1024 * 1024)
+#define NAME_INDEX_PROBES  32
+
+enum name_index_state
+{
+    NAME_INDEX_FREE,
+    NAME_INDEX_BUSY,                   /* being filled by the process whose pid is in the upper bits */
+    NAME_INDEX_USED,
+    NAME_INDEX_DEAD                    /* stale, can be reused */
+};
+
+#define NAME_INDEX_STATE_MASK 3
+#define NAME_INDEX_PID_SHIFT  2
+
+struct name_index_entry
+{
+    LONG         state;                /* enum name_index_state, plus the owner pid when busy */
+    LONG         generation;           /* pool generation of the name */
+    unsigned int hash;                 /* hash of the directory identity and case-folded name */
+    ULONGLONG    dev;                  /* directory device */
+    ULONGLONG    ino;                  /* directory inode */
+    unsigned int name_ofs;             /* offset of the Unix name in the pool */
+    unsigned int name_len;             /* length of the Unix name */
+};
+
+struct name_index
+{
+    LONG                    magic;
+    unsigned int            version;
+    unsigned int            entries;
+    unsigned int            pool_size;
+    LONG                    pool_used;
+    LONG                    generation;  /* incremented when the pool is recycled */
+    struct name_index_entry entry[NAME_INDEX_ENTRIES];
+    char                    pool[NAME_INDEX_POOL];
+};
+
+static struct name_index *name_index;
+static BOOL name_index_initialized;
+
+/* map the index file of the prefix, if enabled; called with dir_cache_section held */
+static void init_name_index(void)
+{
+    static const char index_name[] = "/.name_index";
+    const char *env = getenv( "WINE_NAME_INDEX" ), *config_dir = wine_get_config_dir();
+    struct name_index *index;
+    struct stat st;
+    LARGE_INTEGER map_size;
+    HANDLE file, mapping;
+    SIZE_T size = 0;
+    void *ptr = NULL;
+    NTSTATUS status;
+    char *path;
+    int fd;
+
+    name_index_initialized = TRUE;
+    if (!env || !atoi( env )) return;
+
+    if (!(path = RtlAllocateHeap( GetProcessHeap(), 0, strlen( config_dir ) + sizeof(index_name) ))) return;
+    strcpy( path, config_dir );
+    strcat( path, index_name );
+    fd = open( path, O_RDWR | O_CREAT, 0600 );
+    RtlFreeHeap( GetProcessHeap(), 0, path );
+    if (fd == -1) return;
+
+    if (fstat( fd, &st ) == -1 ||
+        (st.st_size < sizeof(*index) && ftruncate( fd, sizeof(*index) ) == -1))
+    {
+        close( fd );
+        return;
+    }
+    status = wine_server_fd_to_handle( fd, GENERIC_READ | GENERIC_WRITE | SYNCHRONIZE, 0, &file );
+    close( fd );
+    if (status) return;
+
+    map_size.QuadPart = sizeof(*index);
+    status = NtCreateSection( &mapping, STANDARD_RIGHTS_REQUIRED | SECTION_QUERY | SECTION_MAP_READ |
+                              SECTION_MAP_WRITE, NULL, &map_size, PAGE_READWRITE, SEC_COMMIT, file );
+    NtClose( file );
+    if (status) return;
+    status = NtMapViewOfSection( mapping, NtCurrentProcess(), &ptr, 0, 0, NULL, &size,
+                                 ViewShare, 0, PAGE_READWRITE );
+    NtClose( mapping );
+    if (status) return;
+
+    index = ptr;
+    if (!index->magic)
+    {
+        /* concurrent initializations store the same values */
+        index->version   = NAME_INDEX_VERSION;
+        index->entries   = NAME_INDEX_ENTRIES;
+        index->pool_size = NAME_INDEX_POOL;
+        interlocked_cmpxchg( &index->magic, NAME_INDEX_MAGIC, 0 );
+    }
+    if (index->magic != NAME_INDEX_MAGIC || index->version != NAME_INDEX_VERSION ||
+        index->entries != NAME_INDEX_ENTRIES || index->pool_size != NAME_INDEX_POOL)
+    {
+        WARN( "ignoring incompatible name index in %s\n", debugstr_a(config_dir) );
+        NtUnmapViewOfSection( NtCurrentProcess(), ptr );
+        return;
+    }
+    TRACE( "using name index at %p, %u bytes of names\n", index, index->pool_used );
+    name_index = index;
+}
+
+static inline unsigned int get_name_index_hash( const struct stat *st, const WCHAR *name, int length )
+{
+    unsigned int hash = hash_dir_cache_name( name, length );
+
+    hash = hash * 31 + (unsigned int)st->st_ino;
+    hash = hash * 31 + (unsigned int)st->st_dev;
+    return hash;
+}
+
+/***********************************************************************
+ *           find_name_index
+ *
+ * Look up a file in the shared name index; helper for find_file_in_dir_cache.
+ * Entries are only hints written by other processes, so a match is checked
+ * against the name and the file system before being used.
+ */
+static BOOL find_name_index( char *unix_name, int pos, const struct stat *st, const WCHAR *name, int length )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN];
+    unsigned int i, hash, ofs, len;
+    struct stat file_st;
+
+    if (!name_index_initialized) init_name_index();
+    if (!name_index) return FALSE;
+
+    hash = get_name_index_hash( st, name, length );
+    for (i = 0; i < NAME_INDEX_PROBES; i++)
+    {
+        struct name_index_entry *entry = &name_index->entry[(hash + i) & (NAME_INDEX_ENTRIES - 1)];
+
+        if (entry->state == NAME_INDEX_FREE) break;
+        if (entry->state != NAME_INDEX_USED || entry->hash != hash) continue;
+        if (entry->generation != name_index->generation) continue;
+        if (entry->dev != st->st_dev || entry->ino != st->st_ino) continue;
+        ofs = entry->name_ofs;
+        len = entry->name_len;
+        if (len > MAX_DIR_ENTRY_LEN || ofs > NAME_INDEX_POOL - len) continue;
+
+        memcpy( unix_name + pos, name_index->pool + ofs, len );
+        unix_name[pos + len] = 0;
+        if (ntdll_umbstowcs( 0, unix_name + pos, len, buffer, MAX_DIR_ENTRY_LEN ) != length ||
+            strncmpiW( buffer, name, length ))
+            continue;
+
+        unix_name[pos - 1] = '/';
+        if (!stat( unix_name, &file_st )) return TRUE;
+
+        /* the file is gone, drop the stale entry */
+        unix_name[pos - 1] = 0;
+        interlocked_cmpxchg( &entry->state, NAME_INDEX_DEAD, NAME_INDEX_USED );
+    }
+    return FALSE;
+}
+
+/* try to claim an entry for writing; entries left busy by a dead process are recovered */
+static BOOL claim_name_index_entry( struct name_index_entry *entry, LONG busy, LONG generation )
+{
+    LONG state = entry->state;
+    int pid;
+
+    switch (state & NAME_INDEX_STATE_MASK)
+    {
+    case NAME_INDEX_FREE:
+    case NAME_INDEX_DEAD:
+        break;
+    case NAME_INDEX_USED:
+        /* names from a previous generation point to recycled pool space */
+        if (entry->generation == generation) return FALSE;
+        break;
+    case NAME_INDEX_BUSY:
+        pid = (ULONG)state >> NAME_INDEX_PID_SHIFT;
+        if (pid == getpid() || !kill( pid, 0 ) || errno != ESRCH) return FALSE;
+        WARN( "recovering entry %p left busy by dead process %d\n", entry, pid );
+        break;
+    }
+    return interlocked_cmpxchg( &entry->state, busy, state ) == state;
+}
+
+/* add the result of a lookup to the shared name index */
+static void add_name_index( const struct stat *st, const WCHAR *long_name, const char *unix_name )
+{
+    unsigned int i, hash, len = strlen( unix_name );
+    LONG ofs, busy, generation;
+
+    if (!name_index || len > MAX_DIR_ENTRY_LEN) return;
+
+    busy = NAME_INDEX_BUSY | (getpid() << NAME_INDEX_PID_SHIFT);
+    generation = name_index->generation;
+    hash = get_name_index_hash( st, long_name, strlenW( long_name ) );
+    for (i = 0; i < NAME_INDEX_PROBES; i++)
+    {
+        struct name_index_entry *entry = &name_index->entry[(hash + i) & (NAME_INDEX_ENTRIES - 1)];
+
+        if (!claim_name_index_entry( entry, busy, generation )) continue;
+
+        ofs = interlocked_xchg_add( &name_index->pool_used, len );
+        if (ofs < 0 || ofs > NAME_INDEX_POOL - len)
+        {
+            /* the pool is full: start a new generation, which invalidates all the
+             * current names; only the first process to notice resets the pool */
+            if (interlocked_cmpxchg( &name_index->generation, generation + 1, generation ) == generation)
+            {
+                TRACE( "name index pool full, starting generation %u\n", generation + 1 );
+                interlocked_xchg( &name_index->pool_used, 0 );
+            }
+            interlocked_xchg( &entry->state, NAME_INDEX_DEAD );
+            return;
+        }
+        memcpy( name_index->pool + ofs, unix_name, len );
+        entry->generation = generation;
+        entry->hash       = hash;
+        entry->dev        = st->st_dev;
+        entry->ino        = st->st_ino;
+        entry->name_ofs   = ofs;
+        entry->name_len   = len;
+        interlocked_xchg( &entry->state, NAME_INDEX_USED );
+        return;
+    }
+}
+
+/***********************************************************************
+ *           find_file_in_dir_cache
+ *
+ * Find a file in the cached contents of the directory unix_name; helper for find_file_in_dir.
+ * Returns STATUS_NOT_IMPLEMENTED if the directory cannot be cached.
+ */
+static NTSTATUS find_file_in_dir_cache( char *unix_name, int pos, const WCHAR *name, int length,
+                                        BOOLEAN is_name_8_dot_3 )
+{
+    struct dir_cache *cache;
+    struct stat st;
+    NTSTATUS status = STATUS_NOT_IMPLEMENTED;
+    int idx, short_idx;
+
+    if (stat( unix_name, &st ) == -1 || !S_ISDIR( st.st_mode )) return status;
+
+    RtlEnterCriticalSection( &dir_cache_section );
+    if (find_name_index( unix_name, pos, &st, name, length )) status = STATUS_SUCCESS;
+    else if ((cache = get_dir_cache( unix_name, &st )))
+    {
+        idx = find_dir_cache_name( cache, cache->long_hash, name, length, FALSE );
+        if (idx != -1)
+            add_name_index( &st, cache->data->names[idx].long_name, cache->data->names[idx].unix_name );
+        if (is_name_8_dot_3)
+        {
+            short_idx = find_dir_cache_name( cache, cache->short_hash, name, length, TRUE );
+            if (short_idx != -1 && (idx == -1 || short_idx < idx)) idx = short_idx;
+        }
+        if (idx != -1)
+        {
+            unix_name[pos - 1] = '/';
+            strcpy( unix_name + pos, cache->data->names[idx].unix_name );
+            status = STATUS_SUCCESS;
+        }
+        else status = STATUS_OBJECT_PATH_NOT_FOUND;
+    }
+    RtlLeaveCriticalSection( &dir_cache_section );
+    return status;
+}
+
+
 /***********************************************************************
  *           find_file_in_dir
  *
@@ -2134,6 +2640,13 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
     }
 #endif /* VFAT_IOCTL_READDIR_BOTH */
 
+    switch (find_file_in_dir_cache( unix_name, pos, name, length, is_name_8_dot_3 ))
+    {
+    case STATUS_SUCCESS: goto success;
+    case STATUS_OBJECT_PATH_NOT_FOUND: goto not_found;
+    default: break;
+    }
+
     if (!(dir = opendir( unix_name )))
     {
         if (errno == ENOENT) return STATUS_OBJECT_PATH_NOT_FOUND;
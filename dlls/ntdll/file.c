@@ -416,6 +416,8 @@ static async_data_t server_async( HANDLE handle, struct async_fileio *user, HAND
                                   PIO_APC_ROUTINE apc, void *apc_context, IO_STATUS_BLOCK *io )
 {
     async_data_t async;
+
+    fast_sync_demote_handle( event );  /* the server will signal it */
     async.handle      = wine_server_obj_handle( handle );
     async.user        = wine_server_client_ptr( user );
     async.iosb        = wine_server_client_ptr( io );
@@ -859,6 +861,14 @@ NTSTATUS WINAPI NtReadFile(HANDLE hFile, HANDLE hEvent,
 
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
         {
+            if (async_read && !apc && length &&
+                uring_submit_io( hFile, unix_handle, FALSE, hEvent, io_status, cvalue,
+                                 buffer, length, offset->QuadPart ) == STATUS_PENDING)
+            {
+                if (needs_close) close( unix_handle );
+                return STATUS_PENDING;
+            }
+
             /* async I/O doesn't make sense on regular files */
             while ((result = virtual_locked_pread( unix_handle, buffer, length, offset->QuadPart )) == -1)
             {
@@ -1264,6 +1274,14 @@ NTSTATUS WINAPI NtWriteFile(HANDLE hFile, HANDLE hEvent,
                 goto done;
             }
 
+            if (async_write && !apc && length &&
+                uring_submit_io( hFile, unix_handle, TRUE, hEvent, io_status, cvalue,
+                                 (void *)buffer, length, off ) == STATUS_PENDING)
+            {
+                if (needs_close) close( unix_handle );
+                return STATUS_PENDING;
+            }
+
             /* async I/O doesn't make sense on regular files */
             while ((result = pwrite( unix_handle, buffer, length, off )) == -1)
             {
@@ -2642,6 +2660,7 @@ NTSTATUS WINAPI NtSetInformationFile(HANDLE handle, PIO_STATUS_BLOCK io,
                 io->u.Status  = wine_server_call( req );
             }
             SERVER_END_REQ;
+            if (!io->u.Status) uring_set_completion_port( handle, TRUE );
         } else
             io->u.Status = STATUS_INVALID_PARAMETER_3;
         break;
@@ -3542,6 +3561,10 @@ NTSTATUS WINAPI NtCancelIoFileEx( HANDLE hFile, PIO_STATUS_BLOCK iosb, PIO_STATU
     }
     SERVER_END_REQ;
 
+    /* operations submitted through io_uring are not known to the server */
+    if (uring_cancel_io( hFile, iosb, FALSE ) && io_status->u.Status == STATUS_NOT_FOUND)
+        io_status->u.Status = STATUS_SUCCESS;
+
     return io_status->u.Status;
 }
 
@@ -3563,6 +3586,10 @@ NTSTATUS WINAPI NtCancelIoFile( HANDLE hFile, PIO_STATUS_BLOCK io_status )
     }
     SERVER_END_REQ;
 
+    /* operations submitted through io_uring are not known to the server */
+    if (uring_cancel_io( hFile, NULL, TRUE ) && io_status->u.Status == STATUS_NOT_FOUND)
+        io_status->u.Status = STATUS_SUCCESS;
+
     return io_status->u.Status;
 }
 
@@ -133,6 +133,7 @@ typedef union
 } FREE_LIST_ENTRY;
 
 struct tagHEAP;
+struct lfh_heap;
 
 typedef struct tagSUBHEAP
 {
@@ -164,6 +165,7 @@ typedef struct tagHEAP
     ARENA_INUSE    **pending_free;  /* Ring buffer for pending free requests */
     RTL_CRITICAL_SECTION critSection; /* Critical section for serialization */
     FREE_LIST_ENTRY *freeList;      /* Free lists */
+    struct lfh_heap *lfh;           /* Low fragmentation heap front end, if enabled */
 } HEAP;
 
 #define HEAP_MAGIC       ((DWORD)('H' | ('E'<<8) | ('A'<<16) | ('P'<<24)))
@@ -870,6 +872,354 @@ static BOOL validate_large_arena( HEAP *heap, const ARENA_LARGE *arena, BOOL qui
 }
 
 
+/***********************************************************************
+ * Low fragmentation heap front end
+ *
+ * Small blocks are carved from groups of blocks of the same size class,
+ * each group being a separate LFH_GROUP_SIZE-aligned virtual memory block.
+ * Free blocks are kept on lock-free lists, one per size class and affinity
+ * slot, so that allocations and frees only take the heap lock to create a
+ * new group. Groups are never released before the heap is destroyed, so
+ * that the lists can be popped safely. A map of the groups address ranges
+ * allows recognizing LFH blocks without touching arbitrary pointers.
+ */
+
+#define LFH_GROUP_SIZE     0x10000
+#define LFH_MAX_DATA_SIZE  0x4000
+#define LFH_NB_SLOTS       8
+#define LFH_NB_CLASSES     (16 + 4 * 6)  /* 16-byte steps up to 256, then 4 classes per power of 2 */
+
+typedef struct
+{
+    DWORD  data_size;  /* size of user data */
+    DWORD  unused;
+    DWORD  offset;     /* offset of the block in its group, in place of the arena size */
+    DWORD  magic;      /* in place of the arena magic */
+} ARENA_LFH;
+
+C_ASSERT( sizeof(ARENA_LFH) % ALIGNMENT == 0 );
+
+#define ARENA_LFH_MAGIC       0x48464c
+#define ARENA_LFH_FREE_MAGIC  0x46464c
+
+struct lfh_group
+{
+    DWORD             magic;       /* LFH_GROUP_MAGIC */
+    unsigned int      class;       /* size class of the blocks */
+    HEAP             *heap;        /* heap owning the group */
+    struct list       entry;       /* entry in heap groups list */
+    SIZE_T            block_size;  /* size of the blocks, including the arena */
+    SIZE_T            first;       /* offset of the first block */
+};
+
+#define LFH_GROUP_MAGIC  ((DWORD)('L' | ('F'<<8) | ('H'<<16) | ('G'<<24)))
+
+struct lfh_slot
+{
+    SLIST_HEADER      list;        /* free blocks */
+    char              pad[64 - sizeof(SLIST_HEADER)];  /* avoid false sharing between slots */
+};
+
+struct lfh_heap
+{
+    struct lfh_slot   slots[LFH_NB_CLASSES][LFH_NB_SLOTS];
+    struct list       groups;      /* groups list, protected by the heap lock */
+};
+
+/* map of the LFH groups, one byte per LFH_GROUP_SIZE region, in chunks of 65536 regions */
+#ifdef _WIN64
+static BYTE *lfh_region_map[1 << 15];
+#else
+static BYTE *lfh_region_map[1];
+#endif
+
+static inline unsigned int get_lfh_class( SIZE_T size )
+{
+    unsigned int log;
+
+    if (size <= 256) return size ? (size - 1) / 16 : 0;
+    size--;
+    for (log = 8; size >> (log + 1); log++);
+    return 16 + (log - 8) * 4 + ((size >> (log - 2)) & 3);
+}
+
+static inline SIZE_T get_lfh_class_size( unsigned int class )
+{
+    if (class < 16) return (class + 1) * 16;
+    class -= 16;
+    return (SIZE_T)(5 + class % 4) << (8 + class / 4 - 2);
+}
+
+static inline unsigned int get_lfh_slot(void)
+{
+    return (HandleToULong( NtCurrentTeb()->ClientId.UniqueThread ) >> 2) % LFH_NB_SLOTS;
+}
+
+static BYTE *get_lfh_region_map( ULONG_PTR region, BOOL create )
+{
+    ULONG_PTR index = region >> 16;
+    SIZE_T size = 0x10000;
+    void *map = NULL;
+
+    if (index >= ARRAY_SIZE(lfh_region_map)) return NULL;
+    if (lfh_region_map[index] || !create) return lfh_region_map[index];
+
+    if (NtAllocateVirtualMemory( NtCurrentProcess(), &map, 0, &size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE ))
+        return NULL;
+    if (interlocked_cmpxchg_ptr( (void **)&lfh_region_map[index], map, NULL ))
+    {
+        size = 0;
+        NtFreeVirtualMemory( NtCurrentProcess(), &map, &size, MEM_RELEASE );
+    }
+    return lfh_region_map[index];
+}
+
+/* return the LFH group containing a pointer, if any */
+static inline struct lfh_group *get_lfh_group( const void *ptr )
+{
+    ULONG_PTR region = (ULONG_PTR)ptr / LFH_GROUP_SIZE;
+    BYTE *map = get_lfh_region_map( region, FALSE );
+
+    if (!map || !map[region & 0xffff]) return NULL;
+    return (struct lfh_group *)(region * LFH_GROUP_SIZE);
+}
+
+/* return the arena of an LFH block, or NULL if the pointer isn't a valid block of the heap */
+static ARENA_LFH *get_lfh_arena( HEAP *heap, const struct lfh_group *group, const void *ptr )
+{
+    ARENA_LFH *arena = (ARENA_LFH *)ptr - 1;
+    SIZE_T offset = (const char *)arena - (const char *)group;
+
+    if (group->magic != LFH_GROUP_MAGIC || group->heap != heap)
+    {
+        WARN( "Heap %p: pointer %p belongs to heap %p\n", heap, ptr, group->heap );
+        return NULL;
+    }
+    if (offset < group->first || offset > LFH_GROUP_SIZE - group->block_size ||
+        (offset - group->first) % group->block_size || arena->offset != offset)
+    {
+        WARN( "Heap %p: invalid LFH block pointer %p\n", heap, ptr );
+        return NULL;
+    }
+    return arena;
+}
+
+/* allocate a new group of blocks, return the first one and put the others in the given slot */
+static void *lfh_grow( HEAP *heap, unsigned int class, unsigned int slot )
+{
+    SIZE_T offset, block_size = sizeof(ARENA_LFH) + get_lfh_class_size( class ), size = LFH_GROUP_SIZE;
+    struct lfh_group *group = NULL;
+    SLIST_ENTRY *first = NULL, *last = NULL, *entry;
+    ULONG count = 0;
+    ARENA_LFH *arena;
+    BYTE *map;
+
+    if (NtAllocateVirtualMemory( NtCurrentProcess(), (void **)&group, 0, &size,
+                                 MEM_RESERVE | MEM_COMMIT, get_protection_type( heap->flags )))
+        return NULL;
+    if (!(map = get_lfh_region_map( (ULONG_PTR)group / LFH_GROUP_SIZE, TRUE )))
+    {
+        size = 0;
+        NtFreeVirtualMemory( NtCurrentProcess(), (void **)&group, &size, MEM_RELEASE );
+        return NULL;
+    }
+
+    group->magic      = LFH_GROUP_MAGIC;
+    group->class      = class;
+    group->heap       = heap;
+    group->block_size = block_size;
+    group->first      = (sizeof(*group) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+    for (offset = group->first; offset <= LFH_GROUP_SIZE - block_size; offset += block_size)
+    {
+        arena = (ARENA_LFH *)((char *)group + offset);
+        arena->offset = offset;
+        arena->magic = ARENA_LFH_FREE_MAGIC;
+        if (offset == group->first) continue;  /* returned to the caller */
+        entry = (SLIST_ENTRY *)(arena + 1);
+        if (last) last->Next = entry;
+        else first = entry;
+        last = entry;
+        count++;
+    }
+
+    RtlEnterCriticalSection( &heap->critSection );
+    list_add_tail( &heap->lfh->groups, &group->entry );
+    RtlLeaveCriticalSection( &heap->critSection );
+    map[((ULONG_PTR)group / LFH_GROUP_SIZE) & 0xffff] = 1;
+
+    if (count) RtlInterlockedPushListSListEx( &heap->lfh->slots[class][slot].list, first, last, count );
+    TRACE( "heap %p: new group %p for class %u (%lu bytes)\n", heap, group, class, block_size );
+    return (char *)group + group->first + sizeof(ARENA_LFH);
+}
+
+static void *lfh_allocate( HEAP *heap, ULONG flags, SIZE_T size )
+{
+    struct lfh_heap *lfh = heap->lfh;
+    unsigned int i, class = get_lfh_class( size ), slot = get_lfh_slot();
+    ARENA_LFH *arena;
+    void *ptr = NULL;
+
+    /* try the slot of the current thread first, then steal from the other ones */
+    for (i = 0; i < LFH_NB_SLOTS && !ptr; i++)
+        ptr = RtlInterlockedPopEntrySList( &lfh->slots[class][(slot + i) % LFH_NB_SLOTS].list );
+    if (!ptr && !(ptr = lfh_grow( heap, class, slot ))) return NULL;
+
+    arena = (ARENA_LFH *)ptr - 1;
+    arena->data_size = size;
+    arena->magic = ARENA_LFH_MAGIC;
+    if (flags & HEAP_ZERO_MEMORY) memset( ptr, 0, size );
+    return ptr;
+}
+
+static BOOL lfh_free( HEAP *heap, const struct lfh_group *group, void *ptr )
+{
+    ARENA_LFH *arena;
+
+    if (!(arena = get_lfh_arena( heap, group, ptr ))) return FALSE;
+    if (interlocked_cmpxchg( (int *)&arena->magic, ARENA_LFH_FREE_MAGIC, ARENA_LFH_MAGIC ) != ARENA_LFH_MAGIC)
+    {
+        WARN( "Heap %p: block %p used after free\n", heap, ptr );
+        return FALSE;
+    }
+    RtlInterlockedPushEntrySList( &heap->lfh->slots[group->class][get_lfh_slot()].list, ptr );
+    return TRUE;
+}
+
+static void *lfh_reallocate( HEAP *heap, const struct lfh_group *group, ULONG flags, void *ptr, SIZE_T size )
+{
+    ARENA_LFH *arena = get_lfh_arena( heap, group, ptr );
+    SIZE_T old_size;
+    void *ret;
+
+    if (!arena || arena->magic != ARENA_LFH_MAGIC)
+    {
+        RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_PARAMETER );
+        return NULL;
+    }
+
+    old_size = arena->data_size;
+    if (size <= LFH_MAX_DATA_SIZE && get_lfh_class( size ) == group->class)
+    {
+        if (size > old_size && (flags & HEAP_ZERO_MEMORY)) memset( (char *)ptr + old_size, 0, size - old_size );
+        arena->data_size = size;
+        return ptr;
+    }
+
+    if ((flags & HEAP_REALLOC_IN_PLACE_ONLY) ||
+        !(ret = RtlAllocateHeap( heap, flags & (HEAP_GENERATE_EXCEPTIONS | HEAP_NO_SERIALIZE), size )))
+    {
+        if (flags & HEAP_GENERATE_EXCEPTIONS) RtlRaiseStatus( STATUS_NO_MEMORY );
+        RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_NO_MEMORY );
+        return NULL;
+    }
+    memcpy( ret, ptr, min( size, old_size ));
+    if (size > old_size && (flags & HEAP_ZERO_MEMORY)) memset( (char *)ret + old_size, 0, size - old_size );
+    lfh_free( heap, group, ptr );
+    return ret;
+}
+
+/* fill a heap walk entry with the LFH block at ptr, or with the first block of the next
+ * group if ptr is past the last block of its group; the heap lock must be held so that
+ * the groups list doesn't change, but blocks may still be allocated or freed concurrently */
+static NTSTATUS lfh_walk( HEAP *heap, const struct lfh_group *group, char *ptr,
+                          unsigned int region_index, PROCESS_HEAP_ENTRY *entry )
+{
+    ARENA_LFH *arena;
+    struct list *next;
+
+    if (ptr > (char *)group + LFH_GROUP_SIZE - group->block_size)
+    {
+        if (!(next = list_next( &heap->lfh->groups, &group->entry ))) return STATUS_NO_MORE_ENTRIES;
+        group = LIST_ENTRY( next, struct lfh_group, entry );
+        ptr = (char *)group + group->first;
+    }
+
+    arena = (ARENA_LFH *)ptr;
+    entry->lpData = arena + 1;
+    entry->cbOverhead = sizeof(*arena);
+    if (arena->magic == ARENA_LFH_MAGIC)
+    {
+        entry->cbData = arena->data_size;
+        entry->wFlags = PROCESS_HEAP_ENTRY_BUSY;
+    }
+    else
+    {
+        entry->cbData = group->block_size - sizeof(*arena);
+        entry->wFlags = 0;
+    }
+
+    /* each group is a region, following the subheaps */
+    for (next = &heap->lfh->groups; (next = list_next( &heap->lfh->groups, next )) != &group->entry;)
+        region_index++;
+    entry->iRegionIndex = region_index;
+    if (ptr == (char *)group + group->first)
+    {
+        entry->wFlags |= PROCESS_HEAP_REGION;
+        entry->u.Region.dwCommittedSize = LFH_GROUP_SIZE;
+        entry->u.Region.dwUnCommittedSize = 0;
+        entry->u.Region.lpFirstBlock = (char *)group + group->first;
+        entry->u.Region.lpLastBlock = (char *)group + LFH_GROUP_SIZE;
+    }
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS enable_lfh( HEAP *heap )
+{
+    static const DWORD debug_flags = HEAP_NO_SERIALIZE | HEAP_TAIL_CHECKING_ENABLED | HEAP_FREE_CHECKING_ENABLED |
+                                     HEAP_PAGE_ALLOCS | HEAP_VALIDATE | HEAP_VALIDATE_ALL | HEAP_VALIDATE_PARAMS;
+    struct lfh_heap *lfh = NULL;
+    SIZE_T size = sizeof(*lfh);
+    unsigned int i, j;
+
+    if (heap->lfh) return STATUS_SUCCESS;
+    if (!(heap->flags & HEAP_GROWABLE) || (heap->flags & debug_flags) || RUNNING_ON_VALGRIND)
+        return STATUS_UNSUCCESSFUL;
+
+    if (NtAllocateVirtualMemory( NtCurrentProcess(), (void **)&lfh, 0, &size,
+                                 MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE ))
+        return STATUS_NO_MEMORY;
+    for (i = 0; i < LFH_NB_CLASSES; i++)
+        for (j = 0; j < LFH_NB_SLOTS; j++) RtlInitializeSListHead( &lfh->slots[i][j].list );
+    list_init( &lfh->groups );
+
+    RtlEnterCriticalSection( &heap->critSection );
+    if (!heap->lfh)
+    {
+        heap->lfh = lfh;
+        lfh = NULL;
+    }
+    RtlLeaveCriticalSection( &heap->critSection );
+
+    if (lfh)
+    {
+        size = 0;
+        NtFreeVirtualMemory( NtCurrentProcess(), (void **)&lfh, &size, MEM_RELEASE );
+    }
+    TRACE( "enabled LFH for heap %p\n", heap );
+    return STATUS_SUCCESS;
+}
+
+static void destroy_lfh( HEAP *heap )
+{
+    struct lfh_group *group, *next;
+    SIZE_T size;
+    void *addr;
+
+    LIST_FOR_EACH_ENTRY_SAFE( group, next, &heap->lfh->groups, struct lfh_group, entry )
+    {
+        get_lfh_region_map( (ULONG_PTR)group / LFH_GROUP_SIZE, FALSE )[((ULONG_PTR)group / LFH_GROUP_SIZE) & 0xffff] = 0;
+        size = 0;
+        addr = group;
+        NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
+    }
+    size = 0;
+    addr = heap->lfh;
+    NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
+    heap->lfh = NULL;
+}
+
+
 /***********************************************************************
  *           HEAP_CreateSubHeap
  */
@@ -925,6 +1275,7 @@ static SUBHEAP *HEAP_CreateSubHeap( HEAP *heap, LPVOID address, DWORD flags,
         heap->flags         = flags;
         heap->magic         = HEAP_MAGIC;
         heap->grow_size     = max( HEAP_DEF_SIZE, totalSize );
+        heap->lfh           = NULL;
         list_init( &heap->subheap_list );
         list_init( &heap->large_list );
 
@@ -1615,6 +1966,7 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
     heapPtr->critSection.DebugInfo->Spare[0] = 0;
     RtlDeleteCriticalSection( &heapPtr->critSection );
 
+    if (heapPtr->lfh) destroy_lfh( heapPtr );
     LIST_FOR_EACH_ENTRY_SAFE( arena, arena_next, &heapPtr->large_list, ARENA_LARGE, entry )
     {
         list_remove( &arena->entry );
@@ -1683,6 +2035,17 @@ void * WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_
     }
     if (rounded_size < HEAP_MIN_DATA_SIZE) rounded_size = HEAP_MIN_DATA_SIZE;
 
+    if (heapPtr->lfh && size <= LFH_MAX_DATA_SIZE)
+    {
+        void *ret = lfh_allocate( heapPtr, flags, size );
+        if (ret)
+        {
+            TRACE("(%p,%08x,%08lx): returning %p\n", heap, flags, size, ret );
+            return ret;
+        }
+        /* fall back to the standard heap */
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     if (rounded_size >= HEAP_MIN_LARGE_BLOCK_SIZE && (flags & HEAP_GROWABLE))
@@ -1752,6 +2115,7 @@ BOOLEAN WINAPI DECLSPEC_HOTPATCH RtlFreeHeap( HANDLE heap, ULONG flags, void *pt
     ARENA_INUSE *pInUse;
     SUBHEAP *subheap;
     HEAP *heapPtr;
+    struct lfh_group *group;
 
     /* Validate the parameters */
 
@@ -1764,6 +2128,18 @@ BOOLEAN WINAPI DECLSPEC_HOTPATCH RtlFreeHeap( HANDLE heap, ULONG flags, void *pt
         return FALSE;
     }
 
+    if ((group = get_lfh_group( ptr )))
+    {
+        if (lfh_free( heapPtr, group, ptr ))
+        {
+            TRACE("(%p,%08x,%p): returning TRUE\n", heap, flags, ptr );
+            return TRUE;
+        }
+        RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_PARAMETER );
+        TRACE("(%p,%08x,%p): returning FALSE\n", heap, flags, ptr );
+        return FALSE;
+    }
+
     flags &= HEAP_NO_SERIALIZE;
     flags |= heapPtr->flags;
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
@@ -1813,6 +2189,7 @@ PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size
     HEAP *heapPtr;
     SUBHEAP *subheap;
     SIZE_T oldBlockSize, oldActualSize, rounded_size;
+    struct lfh_group *group;
     void *ret;
 
     if (!ptr) return NULL;
@@ -1827,6 +2204,14 @@ PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size
     flags &= HEAP_GENERATE_EXCEPTIONS | HEAP_NO_SERIALIZE | HEAP_ZERO_MEMORY |
              HEAP_REALLOC_IN_PLACE_ONLY;
     flags |= heapPtr->flags;
+
+    if ((group = get_lfh_group( ptr )))
+    {
+        ret = lfh_reallocate( heapPtr, group, flags, ptr, size );
+        TRACE("(%p,%08x,%p,%08lx): returning %p\n", heap, flags, ptr, size, ret );
+        return ret;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     rounded_size = ROUND_SIZE(size) + HEAP_TAIL_EXTRA_SIZE(flags);
@@ -2026,7 +2411,9 @@ SIZE_T WINAPI RtlSizeHeap( HANDLE heap, ULONG flags, const void *ptr )
 {
     SIZE_T ret;
     const ARENA_INUSE *pArena;
+    const ARENA_LFH *lfh_arena;
     SUBHEAP *subheap;
+    struct lfh_group *group;
     HEAP *heapPtr = HEAP_GetPtr( heap );
 
     if (!heapPtr)
@@ -2034,6 +2421,18 @@ SIZE_T WINAPI RtlSizeHeap( HANDLE heap, ULONG flags, const void *ptr )
         RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_HANDLE );
         return ~0UL;
     }
+    if ((group = get_lfh_group( ptr )))
+    {
+        if ((lfh_arena = get_lfh_arena( heapPtr, group, ptr )) && lfh_arena->magic == ARENA_LFH_MAGIC)
+            ret = lfh_arena->data_size;
+        else
+        {
+            RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_PARAMETER );
+            ret = ~0UL;
+        }
+        TRACE("(%p,%08x,%p): returning %08lx\n", heap, flags, ptr, ret );
+        return ret;
+    }
     flags &= HEAP_NO_SERIALIZE;
     flags |= heapPtr->flags;
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
@@ -2077,7 +2476,12 @@ SIZE_T WINAPI RtlSizeHeap( HANDLE heap, ULONG flags, const void *ptr )
 BOOLEAN WINAPI RtlValidateHeap( HANDLE heap, ULONG flags, LPCVOID ptr )
 {
     HEAP *heapPtr = HEAP_GetPtr( heap );
+    struct lfh_group *group;
+    const ARENA_LFH *arena;
+
     if (!heapPtr) return FALSE;
+    if (ptr && (group = get_lfh_group( ptr )))
+        return (arena = get_lfh_arena( heapPtr, group, ptr )) && arena->magic == ARENA_LFH_MAGIC;
     return HEAP_IsRealArena( heapPtr, flags, ptr, QUIET );
 }
 
@@ -2094,6 +2498,7 @@ NTSTATUS WINAPI RtlWalkHeap( HANDLE heap, PVOID entry_ptr )
     LPPROCESS_HEAP_ENTRY entry = entry_ptr; /* FIXME */
     HEAP *heapPtr = HEAP_GetPtr(heap);
     SUBHEAP *sub, *currentheap = NULL;
+    struct lfh_group *group;
     NTSTATUS ret;
     char *ptr;
     int region_index = 0;
@@ -2104,6 +2509,15 @@ NTSTATUS WINAPI RtlWalkHeap( HANDLE heap, PVOID entry_ptr )
 
     /* FIXME: enumerate large blocks too */
 
+    /* the LFH groups are walked after the subheaps */
+    if (entry->lpData && heapPtr->lfh && (group = get_lfh_group( entry->lpData )) && group->heap == heapPtr)
+    {
+        LIST_FOR_EACH_ENTRY( sub, &heapPtr->subheap_list, SUBHEAP, entry ) region_index++;
+        ptr = (char *)entry->lpData - sizeof(ARENA_LFH) + group->block_size;
+        ret = lfh_walk( heapPtr, group, ptr, region_index, entry );
+        goto HW_end;
+    }
+
     /* set ptr to the next arena to be examined */
 
     if (!entry->lpData) /* first call (init) ? */
@@ -2150,7 +2564,14 @@ NTSTATUS WINAPI RtlWalkHeap( HANDLE heap, PVOID entry_ptr )
         {   /* proceed with next subheap */
             struct list *next = list_next( &heapPtr->subheap_list, &currentheap->entry );
             if (!next)
-            {  /* successfully finished */
+            {
+                if (heapPtr->lfh && (next = list_head( &heapPtr->lfh->groups )))
+                {
+                    group = LIST_ENTRY( next, struct lfh_group, entry );
+                    ret = lfh_walk( heapPtr, group, (char *)group + group->first, region_index + 1, entry );
+                    goto HW_end;
+                }
+                /* successfully finished */
                 TRACE("end reached.\n");
                 ret = STATUS_NO_MORE_ENTRIES;
                 goto HW_end;
@@ -2246,6 +2667,8 @@ ULONG WINAPI RtlGetProcessHeaps( ULONG count, HANDLE *heaps )
 NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class,
                                          PVOID info, SIZE_T size_in, PSIZE_T size_out)
 {
+    HEAP *heapPtr;
+
     switch (info_class)
     {
     case HeapCompatibilityInformation:
@@ -2254,7 +2677,8 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
         if (size_in < sizeof(ULONG))
             return STATUS_BUFFER_TOO_SMALL;
 
-        *(ULONG *)info = 0; /* standard heap */
+        heapPtr = HEAP_GetPtr( heap );
+        *(ULONG *)info = heapPtr && heapPtr->lfh ? 2 : 0; /* low fragmentation or standard heap */
         return STATUS_SUCCESS;
 
     default:
@@ -2268,6 +2692,28 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
  */
 NTSTATUS WINAPI RtlSetHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class, PVOID info, SIZE_T size)
 {
-    FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
-    return STATUS_SUCCESS;
+    HEAP *heapPtr;
+
+    TRACE("%p %d %p %ld\n", heap, info_class, info, size);
+
+    switch (info_class)
+    {
+    case HeapCompatibilityInformation:
+        if (size < sizeof(ULONG)) return STATUS_BUFFER_TOO_SMALL;
+        if (!(heapPtr = HEAP_GetPtr( heap ))) return STATUS_INVALID_HANDLE;
+
+        switch (*(ULONG *)info)
+        {
+        case 0:  /* standard heap, the LFH cannot be disabled once enabled */
+            return heapPtr->lfh ? STATUS_UNSUCCESSFUL : STATUS_SUCCESS;
+        case 2:  /* low fragmentation heap */
+            return enable_lfh( heapPtr );
+        default:
+            return STATUS_UNSUCCESSFUL;
+        }
+
+    default:
+        FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
+        return STATUS_SUCCESS;
+    }
 }
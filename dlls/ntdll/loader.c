@@ -102,6 +102,9 @@ typedef struct _wine_modref
     int                   alloc_deps;
     int                   nDeps;
     struct _wine_modref **deps;
+    DWORD                *export_hash;       /* hash table of the exported names, built on first use */
+    DWORD                 export_hash_mask;
+    LONGLONG              attach_time;       /* time spent in the attach notification, when traced */
 } WINE_MODREF;
 
 /* info about the current builtin dll load */
@@ -660,6 +663,52 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
 }
 
 
+/*************************************************************************
+ *		hash_export_name
+ */
+static inline DWORD hash_export_name( const char *name )
+{
+    DWORD hash = 2166136261u;
+
+    while (*name) hash = (hash ^ (unsigned char)*name++) * 16777619;
+    return hash;
+}
+
+
+/*************************************************************************
+ *		get_export_hash
+ *
+ * Return the hash table of the exported names of a module, building it on
+ * first use. Entries are indices in the names array plus one.
+ * The loader_section must be locked while calling this function.
+ */
+static const DWORD *get_export_hash( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports, DWORD *mask )
+{
+    const DWORD *names = get_rva( module, exports->AddressOfNames );
+    WINE_MODREF *wm;
+    DWORD i, pos, size = 16;
+
+    if (exports->NumberOfNames < 32) return NULL;  /* not worth it */
+    if (!(wm = get_modref( module ))) return NULL;
+
+    if (!wm->export_hash)
+    {
+        while (size < 2 * exports->NumberOfNames) size *= 2;
+        if (!(wm->export_hash = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, size * sizeof(DWORD) )))
+            return NULL;
+        wm->export_hash_mask = size - 1;
+        for (i = 0; i < exports->NumberOfNames; i++)
+        {
+            pos = hash_export_name( get_rva( module, names[i] )) & wm->export_hash_mask;
+            while (wm->export_hash[pos]) pos = (pos + 1) & wm->export_hash_mask;
+            wm->export_hash[pos] = i + 1;
+        }
+    }
+    *mask = wm->export_hash_mask;
+    return wm->export_hash;
+}
+
+
 /*************************************************************************
  *		find_named_export
  *
@@ -672,6 +721,8 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
     const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
     const DWORD *names = get_rva( module, exports->AddressOfNames );
     int min = 0, max = exports->NumberOfNames - 1;
+    const DWORD *hash;
+    DWORD pos, mask;
 
     /* first check the hint */
     if (hint >= 0 && hint <= max)
@@ -681,6 +732,18 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
             return find_ordinal_export( module, exports, exp_size, ordinals[hint], load_path );
     }
 
+    /* then look it up in the hash table */
+    if ((hash = get_export_hash( module, exports, &mask )))
+    {
+        for (pos = hash_export_name( name ) & mask; hash[pos]; pos = (pos + 1) & mask)
+        {
+            char *ename = get_rva( module, names[hash[pos] - 1] );
+            if (!strcmp( ename, name ))
+                return find_ordinal_export( module, exports, exp_size, ordinals[hash[pos] - 1], load_path );
+        }
+        return NULL;
+    }
+
     /* then do a binary search */
     while (min <= max)
     {
@@ -1298,6 +1361,59 @@ static NTSTATUS MODULE_InitDLL( WINE_MODREF *wm, UINT reason, LPVOID lpReserved
 }
 
 
+/* format a performance counter interval in milliseconds */
+static const char *debugstr_attach_time( LONGLONG time )
+{
+    LARGE_INTEGER counter, freq;
+    ULONGLONG us;
+
+    NtQueryPerformanceCounter( &counter, &freq );
+    us = time * 1000000 / freq.QuadPart;
+    return wine_dbg_sprintf( "%u.%03u", (ULONG)(us / 1000), (ULONG)(us % 1000) );
+}
+
+
+/*************************************************************************
+ *		trace_attach_path
+ *
+ * Report the time spent in the attach notifications of the modules, and the
+ * longest chain of notifications through the dependency graph, i.e. the time
+ * attaching would take if independent modules were initialized concurrently.
+ * The loader_section must be locked while calling this function.
+ */
+static void trace_attach_path(void)
+{
+    PLIST_ENTRY mark, entry;
+    LONGLONG total = 0, critical = 0, *path;
+    unsigned int i, j, k, count = 0;
+    WINE_MODREF **mods;
+
+    mark = &NtCurrentTeb()->Peb->LdrData->InInitializationOrderModuleList;
+    for (entry = mark->Flink; entry != mark; entry = entry->Flink) count++;
+    if (!(mods = RtlAllocateHeap( GetProcessHeap(), 0, count * (sizeof(*mods) + sizeof(*path)) ))) return;
+    path = (LONGLONG *)(mods + count);
+
+    /* dependencies come before their users in initialization order, except in cycles */
+    for (i = 0, entry = mark->Flink; entry != mark; entry = entry->Flink, i++)
+    {
+        LDR_MODULE *mod = CONTAINING_RECORD(entry, LDR_MODULE, InInitializationOrderModuleList);
+        WINE_MODREF *wm = CONTAINING_RECORD(mod, WINE_MODREF, ldr);
+        LONGLONG deps = 0;
+
+        mods[i] = wm;
+        for (j = 0; j < wm->nDeps; j++)
+            for (k = 0; k < i; k++)
+                if (mods[k] == wm->deps[j] && path[k] > deps) deps = path[k];
+        path[i] = deps + wm->attach_time;
+        total += wm->attach_time;
+        if (path[i] > critical) critical = path[i];
+    }
+    TRACE_(loaddll)( "Attached %u modules: %s ms in entry points, critical path %s ms\n",
+                     count, debugstr_attach_time( total ), debugstr_attach_time( critical ));
+    RtlFreeHeap( GetProcessHeap(), 0, mods );
+}
+
+
 /*************************************************************************
  *		process_attach
  *
@@ -1332,6 +1448,7 @@ static NTSTATUS MODULE_InitDLL( WINE_MODREF *wm, UINT reason, LPVOID lpReserved
 static NTSTATUS process_attach( WINE_MODREF *wm, LPVOID lpReserved )
 {
     NTSTATUS status = STATUS_SUCCESS;
+    LARGE_INTEGER start, entry_start, end;
     ULONG_PTR cookie;
     int i;
 
@@ -1343,6 +1460,7 @@ static NTSTATUS process_attach( WINE_MODREF *wm, LPVOID lpReserved )
         return status;
 
     TRACE("(%s,%p) - START\n", debugstr_w(wm->ldr.BaseDllName.Buffer), lpReserved );
+    if (TRACE_ON(loaddll)) NtQueryPerformanceCounter( &start, NULL );
 
     /* Tag current MODREF to prevent recursive loop */
     wm->ldr.Flags |= LDR_LOAD_IN_PROGRESS;
@@ -1367,7 +1485,17 @@ static NTSTATUS process_attach( WINE_MODREF *wm, LPVOID lpReserved )
         current_modref = wm;
 
         call_ldr_notifications( LDR_DLL_NOTIFICATION_REASON_LOADED, &wm->ldr );
+        if (TRACE_ON(loaddll)) NtQueryPerformanceCounter( &entry_start, NULL );
         status = MODULE_InitDLL( wm, DLL_PROCESS_ATTACH, lpReserved );
+        if (TRACE_ON(loaddll))
+        {
+            NtQueryPerformanceCounter( &end, NULL );
+            wm->attach_time = end.QuadPart - entry_start.QuadPart;
+            TRACE_(loaddll)( "Attached %s in %s ms, %s ms in entry point\n",
+                             debugstr_w(wm->ldr.FullDllName.Buffer),
+                             debugstr_attach_time( end.QuadPart - start.QuadPart ),
+                             debugstr_attach_time( wm->attach_time ));
+        }
         if (status == STATUS_SUCCESS)
         {
             wm->ldr.Flags |= LDR_PROCESS_ATTACHED;
@@ -3261,6 +3389,7 @@ void WINAPI LdrShutdownProcess(void)
     TRACE("()\n");
     process_detaching = TRUE;
     process_detach();
+    critsection_dump_profile();
 }
 
 
@@ -3356,6 +3485,7 @@ static void free_modref( WINE_MODREF *wm )
     if (cached_modref == wm) cached_modref = NULL;
     RtlFreeUnicodeString( &wm->ldr.FullDllName );
     RtlFreeHeap( GetProcessHeap(), 0, wm->deps );
+    RtlFreeHeap( GetProcessHeap(), 0, wm->export_hash );
     RtlFreeHeap( GetProcessHeap(), 0, wm );
 }
 
@@ -3555,6 +3685,7 @@ void WINAPI LdrInitializeThunk( CONTEXT *context, void **entry, ULONG_PTR unknow
             NtTerminateProcess( GetCurrentProcess(), status );
         }
         attach_implicitly_loaded_dlls( context );
+        if (TRACE_ON(loaddll)) trace_attach_path();
         virtual_release_address_space();
     }
     else
@@ -3763,6 +3894,7 @@ void __wine_process_init(void)
     void * (CDECL *init_func)(void);
 
     thread_init();
+    critsection_init();
 
     /* retrieve current umask */
     FILE_umask = umask(0777);
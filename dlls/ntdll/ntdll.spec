@@ -1505,6 +1505,7 @@
 @ cdecl wine_server_release_fd(long long)
 @ cdecl wine_server_send_fd(long)
 @ cdecl __wine_make_process_system()
+@ cdecl __wine_fast_sync_demote(long)
 
 # Debugging
 @ cdecl -norelay __wine_dbg_get_channel_flags(ptr)
@@ -81,6 +81,8 @@ extern void virtual_init(void) DECLSPEC_HIDDEN;
 extern void virtual_init_threading(void) DECLSPEC_HIDDEN;
 extern void fill_cpu_info(void) DECLSPEC_HIDDEN;
 extern void heap_set_debug_flags( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void critsection_init(void) DECLSPEC_HIDDEN;
+extern void critsection_dump_profile(void) DECLSPEC_HIDDEN;
 extern void init_user_process_params( SIZE_T data_size ) DECLSPEC_HIDDEN;
 extern void update_user_process_params( const UNICODE_STRING *image ) DECLSPEC_HIDDEN;
 
@@ -104,10 +106,40 @@ extern int server_remove_fd_from_cache( HANDLE handle ) DECLSPEC_HIDDEN;
 extern int server_get_unix_fd( HANDLE handle, unsigned int access, int *unix_fd,
                                int *needs_close, enum server_fd_type *type, unsigned int *options ) DECLSPEC_HIDDEN;
 extern int server_pipe( int fd[2] ) DECLSPEC_HIDDEN;
+extern void server_exit_thread_shm(void) DECLSPEC_HIDDEN;
+
+/* batched server requests */
+#define SERVER_BATCH_MAX 24
+
+struct server_batch
+{
+    unsigned int                 count;                    /* number of requests */
+    unsigned int                 flags[SERVER_BATCH_MAX];  /* BATCH_* flags of the requests */
+    struct __server_request_info reqs[SERVER_BATCH_MAX];   /* requests, replaced by the replies */
+};
+
+extern void *server_batch_add( struct server_batch *batch, enum request type, unsigned int flags ) DECLSPEC_HIDDEN;
+extern unsigned int server_batch_call( struct server_batch *batch ) DECLSPEC_HIDDEN;
+
+/* io_uring file I/O */
+extern NTSTATUS uring_submit_io( HANDLE handle, int fd, BOOL write, HANDLE event, IO_STATUS_BLOCK *iosb,
+                                 ULONG_PTR cvalue, void *buffer, ULONG length, ULONGLONG offset ) DECLSPEC_HIDDEN;
+extern unsigned int uring_cancel_io( HANDLE handle, IO_STATUS_BLOCK *iosb, BOOL only_thread ) DECLSPEC_HIDDEN;
+extern void uring_set_completion_port( HANDLE handle, BOOL set ) DECLSPEC_HIDDEN;
+
+#define SERVER_BATCH_REQ(batch,type,flags) \
+    ((struct type##_request *)server_batch_add( (batch), REQ_##type, (flags) ))
+#define SERVER_BATCH_REPLY(batch,index,type) \
+    ((const struct type##_reply *)&(batch)->reqs[index].u.reply.type##_reply)
 extern NTSTATUS alloc_object_attributes( const OBJECT_ATTRIBUTES *attr, struct object_attributes **ret,
                                          data_size_t *ret_len ) DECLSPEC_HIDDEN;
 extern NTSTATUS validate_open_object_attributes( const OBJECT_ATTRIBUTES *attr ) DECLSPEC_HIDDEN;
 extern int wait_select_reply( void *cookie ) DECLSPEC_HIDDEN;
+extern void fast_sync_demote_handle( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void fast_sync_close_handle( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void fast_sync_dup_handle( HANDLE source, HANDLE dest, ACCESS_MASK access, ULONG options,
+                                  BOOL close_source ) DECLSPEC_HIDDEN;
+extern void fast_sync_thread_exit(void) DECLSPEC_HIDDEN;
 extern BOOL invoke_apc( const apc_call_t *call, apc_result_t *result ) DECLSPEC_HIDDEN;
 
 /* module handling */
@@ -193,6 +225,11 @@ extern void virtual_fill_image_information( const pe_image_info_t *pe_info,
                                             SECTION_IMAGE_INFORMATION *info ) DECLSPEC_HIDDEN;
 extern struct _KUSER_SHARED_DATA *user_shared_data DECLSPEC_HIDDEN;
 
+/* registry */
+extern NTSTATUS reg_query_key_value( HANDLE root, const UNICODE_STRING *key, const UNICODE_STRING *value,
+                                     KEY_VALUE_PARTIAL_INFORMATION *info, DWORD length,
+                                     DWORD *result_len ) DECLSPEC_HIDDEN;
+
 /* completion */
 extern NTSTATUS NTDLL_AddCompletion( HANDLE hFile, ULONG_PTR CompletionValue,
                                      NTSTATUS CompletionStatus, ULONG Information, BOOL async) DECLSPEC_HIDDEN;
@@ -236,6 +273,8 @@ struct ntdll_thread_data
     int                request_fd;    /* fd for sending server requests */
     int                reply_fd;      /* fd for receiving server replies */
     int                wait_fd[2];    /* fd for sleeping server requests */
+    int                doorbell_fd;   /* fd for signaling requests in request_shm */
+    struct request_shm *request_shm;  /* shared memory for server requests */
     BOOL               wow64_redir;   /* Wow64 filesystem redirection flag */
     pthread_t          pthread_id;    /* pthread thread id */
 };
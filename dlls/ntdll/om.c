@@ -235,6 +235,9 @@ NTSTATUS WINAPI NtSetInformationObject(IN HANDLE handle,
 
             if (len < sizeof(*p)) return STATUS_INVALID_BUFFER_SIZE;
 
+            /* the object could escape through inheritance, or outlive the close of its fast state */
+            if (p->InheritHandle || p->ProtectFromClose) fast_sync_demote_handle( handle );
+
             SERVER_START_REQ( set_handle_info )
             {
                 req->handle = wine_server_obj_handle( handle );
@@ -352,6 +355,10 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source,
                                    ACCESS_MASK access, ULONG attributes, ULONG options )
 {
     NTSTATUS ret;
+    BOOL local = (source_process == NtCurrentProcess() && dest_process == NtCurrentProcess());
+
+    if (!local) fast_sync_demote_handle( source );
+
     SERVER_START_REQ( dup_handle )
     {
         req->src_process = wine_server_obj_handle( source_process );
@@ -368,7 +375,10 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source,
             {
                 int fd = server_remove_fd_from_cache( source );
                 if (fd != -1) close( fd );
+                uring_set_completion_port( source, FALSE );
             }
+            if (local) fast_sync_dup_handle( source, dest ? *dest : 0, access, options, reply->closed );
+            else if (reply->closed && reply->self) fast_sync_close_handle( source );
         }
     }
     SERVER_END_REQ;
@@ -387,6 +397,9 @@ NTSTATUS close_handle( HANDLE handle )
     NTSTATUS ret;
     int fd = server_remove_fd_from_cache( handle );
 
+    fast_sync_close_handle( handle );
+    uring_set_completion_port( handle, FALSE );
+
     SERVER_START_REQ( close_handle )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -592,6 +592,49 @@ NTSTATUS WINAPI DECLSPEC_HOTPATCH NtQueryValueKey( HANDLE handle, const UNICODE_
     return ret;
 }
 
+/******************************************************************************
+ * reg_query_key_value
+ *
+ * Open a subkey, query one of its values and close it again, in a single server round trip.
+ */
+NTSTATUS reg_query_key_value( HANDLE root, const UNICODE_STRING *key, const UNICODE_STRING *value,
+                              KEY_VALUE_PARTIAL_INFORMATION *info, DWORD length, DWORD *result_len )
+{
+    static const unsigned int fixed_size = FIELD_OFFSET(KEY_VALUE_PARTIAL_INFORMATION, Data);
+    const struct get_key_value_reply *reply;
+    struct open_key_request *open_req;
+    struct get_key_value_request *value_req;
+    struct server_batch batch;
+    NTSTATUS ret;
+
+    if (value->Length > MAX_VALUE_LENGTH) return STATUS_OBJECT_NAME_NOT_FOUND;
+
+    batch.count = 0;
+    open_req = SERVER_BATCH_REQ( &batch, open_key, 0 );
+    open_req->parent = wine_server_obj_handle( root );
+    open_req->access = KEY_QUERY_VALUE;
+    wine_server_add_data( open_req, key->Buffer, key->Length );
+
+    value_req = SERVER_BATCH_REQ( &batch, get_key_value, BATCH_PREV_HANDLE | BATCH_IGNORE_ERROR );
+    wine_server_add_data( value_req, value->Buffer, value->Length );
+    if (length > fixed_size) wine_server_set_reply( value_req, info->Data, length - fixed_size );
+
+    SERVER_BATCH_REQ( &batch, close_handle, BATCH_PREV_HANDLE );
+
+    if ((ret = server_batch_call( &batch ))) return ret;
+
+    reply = SERVER_BATCH_REPLY( &batch, 1, get_key_value );
+    if (!(ret = batch.reqs[1].u.reply.reply_header.error))
+    {
+        copy_key_value_info( KeyValuePartialInformation, info, length, reply->type,
+                             value->Length, reply->total );
+        *result_len = fixed_size + reply->total;
+        if (length < fixed_size) ret = STATUS_BUFFER_TOO_SMALL;
+        else if (length < *result_len) ret = STATUS_BUFFER_OVERFLOW;
+    }
+    return ret;
+}
+
 /******************************************************************************
  * RtlpNtQueryValueKey [NTDLL.@]
  *
@@ -727,6 +770,8 @@ NTSTATUS WINAPI NtNotifyChangeMultipleKeys(
             return ret;
     }
 
+    fast_sync_demote_handle( Event );  /* the server will signal it */
+
     SERVER_START_REQ( set_registry_notification )
     {
         req->hkey    = wine_server_obj_handle( KeyHandle );
@@ -1549,11 +1594,9 @@ NTSTATUS WINAPI NtQueryLicenseValue( const UNICODE_STRING *name, ULONG *result_t
                                                 'W','i','n','e','\\','L','i','c','e','n','s','e',
                                                 'I','n','f','o','r','m','a','t','i','o','n',0};
     KEY_VALUE_PARTIAL_INFORMATION *info;
-    NTSTATUS status = STATUS_OBJECT_NAME_NOT_FOUND;
+    NTSTATUS status;
     DWORD info_length, count;
-    OBJECT_ATTRIBUTES attr;
     UNICODE_STRING keyW;
-    HANDLE hkey;
 
     if (!name || !name->Buffer || !name->Length || !result_len)
         return STATUS_INVALID_PARAMETER;
@@ -1562,32 +1605,21 @@ NTSTATUS WINAPI NtQueryLicenseValue( const UNICODE_STRING *name, ULONG *result_t
     info = RtlAllocateHeap( GetProcessHeap(), 0, info_length );
     if (!info) return STATUS_NO_MEMORY;
 
-    attr.Length = sizeof(attr);
-    attr.RootDirectory = 0;
-    attr.ObjectName = &keyW;
-    attr.Attributes = 0;
-    attr.SecurityDescriptor = NULL;
-    attr.SecurityQualityOfService = NULL;
     RtlInitUnicodeString( &keyW, LicenseInformationW );
 
     /* @@ Wine registry key: HKLM\Software\Wine\LicenseInformation */
-    if (!NtOpenKey( &hkey, KEY_READ, &attr ))
+    status = reg_query_key_value( 0, &keyW, name, info, info_length, &count );
+    if (!status || status == STATUS_BUFFER_OVERFLOW)
     {
-        status = NtQueryValueKey( hkey, name, KeyValuePartialInformation,
-                                  info, info_length, &count );
-        if (!status || status == STATUS_BUFFER_OVERFLOW)
-        {
-            if (result_type)
-                *result_type = info->Type;
+        if (result_type)
+            *result_type = info->Type;
 
-            *result_len = info->DataLength;
+        *result_len = info->DataLength;
 
-            if (status == STATUS_BUFFER_OVERFLOW)
-                status = STATUS_BUFFER_TOO_SMALL;
-            else
-                memcpy( data, info->Data, info->DataLength );
-        }
-        NtClose( hkey );
+        if (status == STATUS_BUFFER_OVERFLOW)
+            status = STATUS_BUFFER_TOO_SMALL;
+        else
+            memcpy( data, info->Data, info->DataLength );
     }
 
     if (status == STATUS_OBJECT_NAME_NOT_FOUND)
@@ -54,6 +54,9 @@
 #ifdef HAVE_SYS_PRCTL_H
 # include <sys/prctl.h>
 #endif
+#ifdef HAVE_POLL_H
+# include <poll.h>
+#endif
 #ifdef HAVE_SYS_STAT_H
 # include <sys/stat.h>
 #endif
@@ -80,6 +83,7 @@
 #include "wine/library.h"
 #include "wine/server.h"
 #include "wine/debug.h"
+#include "wine/exception.h"
 #include "ntdll_misc.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(server);
@@ -277,14 +281,221 @@ static inline unsigned int wait_reply( struct __server_request_info *req )
 }
 
 
+#if defined(__linux__) && defined(__NR_futex) && defined(__NR_memfd_create) && defined(__NR_eventfd2)
+
+#define REQUEST_SHM_SIZE      0x10000
+#define REQUEST_SHM_DATA_SIZE (REQUEST_SHM_SIZE - FIELD_OFFSET( struct request_shm, data ))
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC       0x0001
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS       1033
+#endif
+#ifndef F_SEAL_SHRINK
+#define F_SEAL_SHRINK     0x0002
+#endif
+#ifndef F_SEAL_GROW
+#define F_SEAL_GROW       0x0004
+#endif
+
+static inline void small_pause(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __asm__ __volatile__( "rep;nop" : : : "memory" );
+#else
+    __asm__ __volatile__( "" : : : "memory" );
+#endif
+}
+
+/***********************************************************************
+ *           copy_request_data
+ *
+ * Copy the request variable data to the shared memory.
+ */
+static unsigned int copy_request_data( char *ptr, const struct __server_request_info *req )
+{
+    unsigned int i, ret = STATUS_SUCCESS;
+
+    __TRY
+    {
+        for (i = 0; i < req->data_count; i++)
+        {
+            memcpy( ptr, req->data[i].ptr, req->data[i].size );
+            ptr += req->data[i].size;
+        }
+    }
+    __EXCEPT_PAGE_FAULT
+    {
+        ret = STATUS_ACCESS_VIOLATION;  /* same as a write() failing with EFAULT */
+    }
+    __ENDTRY
+    return ret;
+}
+
+
+/***********************************************************************
+ *           check_server_alive
+ *
+ * The reply pipe is not used while requests go through the shared memory,
+ * so any event on it means that the server closed it.
+ */
+static void check_server_alive(void)
+{
+    struct pollfd pfd;
+
+    pfd.fd = ntdll_get_thread_data()->reply_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll( &pfd, 1, 0 ) == 1) abort_thread(0);
+}
+
+
+/***********************************************************************
+ *           shm_call
+ *
+ * Perform a server call through the thread shared memory.
+ */
+static unsigned int shm_call( struct request_shm *shm, struct __server_request_info *req )
+{
+    static const struct timespec timeout = { 1, 0 };
+    volatile unsigned int *reply_seq = &shm->reply_seq;
+    unsigned __int64 one = 1;
+    unsigned int seq, spin, ret;
+
+    if ((ret = copy_request_data( shm->data, req ))) return ret;
+    memcpy( &shm->header, &req->u.req, sizeof(req->u.req) );
+    seq = shm->seq + 1;
+    interlocked_xchg( (int *)&shm->seq, seq );
+    if (write( ntdll_get_thread_data()->doorbell_fd, &one, sizeof(one) ) != sizeof(one))
+        server_protocol_perror( "doorbell" );
+
+    /* the server usually answers quickly, avoid sleeping if possible */
+    for (spin = 0; spin < 200 && *reply_seq != seq; spin++) small_pause();
+
+    while (*reply_seq != seq)
+    {
+        if (syscall( __NR_futex, reply_seq, 0 /* FUTEX_WAIT */, seq - 1, &timeout, 0, 0 ) == -1 &&
+            errno == ETIMEDOUT)
+            check_server_alive();
+    }
+
+    memcpy( &req->u.reply, &shm->header, sizeof(req->u.reply) );
+    if (req->u.reply.reply_header.reply_size)
+        memcpy( req->reply_data, shm->data, req->u.reply.reply_header.reply_size );
+    return req->u.reply.reply_header.error;
+}
+
+
+/***********************************************************************
+ *           server_init_thread_shm
+ *
+ * Set up the shared memory used to pass the thread requests, if enabled.
+ */
+static void server_init_thread_shm(void)
+{
+    static int enabled = -1;
+    struct request_shm *shm;
+    int shm_fd, doorbell_fd;
+    unsigned int ret;
+
+    if (enabled == -1)
+    {
+        const char *env = getenv( "WINE_REQUEST_SHM" );
+        enabled = env && atoi( env );
+    }
+    if (!enabled) return;
+
+    /* the server maps the memory too, make sure that its size can't change under it */
+    if ((shm_fd = syscall( __NR_memfd_create, "wine-request", MFD_CLOEXEC | MFD_ALLOW_SEALING )) == -1) return;
+    if (ftruncate( shm_fd, REQUEST_SHM_SIZE ) == -1 ||
+        fcntl( shm_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW ) == -1 ||
+        (shm = mmap( NULL, REQUEST_SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0 )) == MAP_FAILED)
+    {
+        close( shm_fd );
+        return;
+    }
+    if ((doorbell_fd = syscall( __NR_eventfd2, 0, O_CLOEXEC )) == -1)
+    {
+        munmap( shm, REQUEST_SHM_SIZE );
+        close( shm_fd );
+        return;
+    }
+    shm->size = REQUEST_SHM_DATA_SIZE;
+
+    wine_server_send_fd( shm_fd );
+    wine_server_send_fd( doorbell_fd );
+    SERVER_START_REQ( init_request_shm )
+    {
+        req->shm_fd      = shm_fd;
+        req->doorbell_fd = doorbell_fd;
+        req->size        = REQUEST_SHM_SIZE;
+        ret = wine_server_call( req );
+    }
+    SERVER_END_REQ;
+    close( shm_fd );
+
+    if (ret)
+    {
+        munmap( shm, REQUEST_SHM_SIZE );
+        close( doorbell_fd );
+        return;
+    }
+    ntdll_get_thread_data()->request_shm = shm;
+    ntdll_get_thread_data()->doorbell_fd = doorbell_fd;
+}
+
+
+/***********************************************************************
+ *           server_exit_thread_shm
+ */
+void server_exit_thread_shm(void)
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    struct request_shm *shm = thread_data->request_shm;
+
+    if (!shm) return;
+    thread_data->request_shm = NULL;
+    munmap( shm, REQUEST_SHM_SIZE );
+    close( thread_data->doorbell_fd );
+}
+
+#else  /* __linux__ */
+
+#define REQUEST_SHM_DATA_SIZE 0
+
+static unsigned int shm_call( struct request_shm *shm, struct __server_request_info *req )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+static void server_init_thread_shm(void)
+{
+}
+
+void server_exit_thread_shm(void)
+{
+}
+
+#endif  /* __linux__ */
+
+
 /***********************************************************************
  *           server_call_unlocked
  */
 unsigned int server_call_unlocked( void *req_ptr )
 {
     struct __server_request_info * const req = req_ptr;
+    struct request_shm *shm = ntdll_get_thread_data()->request_shm;
     unsigned int ret;
 
+    if (shm && req->u.req.request_header.request_size <= REQUEST_SHM_DATA_SIZE &&
+        req->u.req.request_header.reply_size <= REQUEST_SHM_DATA_SIZE)
+        return shm_call( shm, req );
+
     if ((ret = send_request( req ))) return ret;
     return wait_reply( req );
 }
@@ -324,6 +535,107 @@ unsigned int wine_server_call( void *req_ptr )
 }
 
 
+/***********************************************************************
+ *           server_batch_add
+ *
+ * Add a request to a batch; it is filled like a SERVER_START_REQ request.
+ */
+void *server_batch_add( struct server_batch *batch, enum request type, unsigned int flags )
+{
+    struct __server_request_info *req;
+
+    assert( batch->count < SERVER_BATCH_MAX );
+    req = &batch->reqs[batch->count];
+    batch->flags[batch->count++] = flags;
+    memset( &req->u.req, 0, sizeof(req->u.req) );
+    req->u.req.request_header.req = type;
+    req->data_count = 0;
+    req->reply_data = NULL;
+    return req;
+}
+
+
+/***********************************************************************
+ *           server_batch_call
+ *
+ * Send all the requests of a batch in a single server round trip. The replies are stored
+ * in the requests like wine_server_call does; requests that were not executed because
+ * an earlier one failed get STATUS_REQUEST_ABORTED. Returns the status of the batch or
+ * of the request that stopped it.
+ */
+unsigned int server_batch_call( struct server_batch *batch )
+{
+    data_size_t req_size = 0, reply_max = 0, size = 0;
+    unsigned int i, j, done = 0, ret;
+    char *buffer, *ptr, *end;
+
+    for (i = 0; i < batch->count; i++)
+    {
+        const struct request_header *header = &batch->reqs[i].u.req.request_header;
+        req_size += sizeof(struct batch_header) + sizeof(union generic_request) + ((header->request_size + 7) & ~7);
+        reply_max += sizeof(struct batch_header) + sizeof(union generic_reply) + ((header->reply_size + 7) & ~7);
+    }
+
+    /* the same buffer is used for the requests and the replies */
+    if (!(buffer = RtlAllocateHeap( GetProcessHeap(), 0, max( req_size, reply_max ))))
+        return STATUS_NO_MEMORY;
+
+    for (i = 0, ptr = buffer; i < batch->count; i++)
+    {
+        const struct __server_request_info *req = &batch->reqs[i];
+        struct batch_header *header = (struct batch_header *)ptr;
+        data_size_t data_size = req->u.req.request_header.request_size;
+
+        header->size  = sizeof(*header) + sizeof(req->u.req) + ((data_size + 7) & ~7);
+        header->flags = batch->flags[i];
+        memcpy( header + 1, &req->u.req, sizeof(req->u.req) );
+        ptr += sizeof(*header) + sizeof(req->u.req);
+        for (j = 0; j < req->data_count; j++)
+        {
+            memcpy( ptr, req->data[j].ptr, req->data[j].size );
+            ptr += req->data[j].size;
+        }
+        memset( ptr, 0, ((data_size + 7) & ~7) - data_size );
+        ptr += ((data_size + 7) & ~7) - data_size;
+    }
+
+    SERVER_START_REQ( batch )
+    {
+        wine_server_add_data( req, buffer, req_size );
+        wine_server_set_reply( req, buffer, reply_max );
+        ret = wine_server_call( req );
+        done = reply->done;
+        size = wine_server_reply_size( reply );
+    }
+    SERVER_END_REQ;
+
+    for (i = 0, ptr = buffer, end = buffer + size; i < batch->count; i++)
+    {
+        struct __server_request_info *req = &batch->reqs[i];
+        const struct batch_header *header = (const struct batch_header *)ptr;
+
+        if (i < done && end - ptr >= sizeof(*header) + sizeof(req->u.reply))
+        {
+            memcpy( &req->u.reply, header + 1, sizeof(req->u.reply) );
+            if (req->u.reply.reply_header.reply_size)
+                memcpy( req->reply_data, (const char *)(header + 1) + sizeof(req->u.reply),
+                        req->u.reply.reply_header.reply_size );
+            if (!ret && req->u.reply.reply_header.error && !(batch->flags[i] & BATCH_IGNORE_ERROR))
+                ret = req->u.reply.reply_header.error;
+            ptr += header->size;
+        }
+        else
+        {
+            memset( &req->u.reply, 0, sizeof(req->u.reply) );
+            req->u.reply.reply_header.error = STATUS_REQUEST_ABORTED;
+        }
+    }
+
+    RtlFreeHeap( GetProcessHeap(), 0, buffer );
+    return ret;
+}
+
+
 /***********************************************************************
  *           server_enter_uninterrupted_section
  */
@@ -835,6 +1147,18 @@ static inline unsigned int handle_to_index( HANDLE handle, unsigned int *entry )
     return idx % FD_CACHE_BLOCK_SIZE;
 }
 
+/* lookups run concurrently with the locked updates; on 64-bit an aligned load is
+ * already atomic, so avoid a locked cmpxchg that would bounce the cache line
+ * between all the threads using the same handle */
+static inline LONG64 read_fd_cache_entry( union fd_cache_entry *entry )
+{
+#ifdef _WIN64
+    return *(volatile LONG64 *)&entry->data;
+#else
+    return interlocked_cmpxchg64( &entry->data, 0, 0 );
+#endif
+}
+
 
 /***********************************************************************
  *           add_fd_to_cache
@@ -883,11 +1207,13 @@ static inline NTSTATUS get_cached_fd( HANDLE handle, int *fd, enum server_fd_typ
                                       unsigned int *access, unsigned int *options )
 {
     unsigned int entry, idx = handle_to_index( handle, &entry );
-    union fd_cache_entry cache;
+    union fd_cache_entry *block, cache;
 
-    if (entry >= FD_CACHE_ENTRIES || !fd_cache[entry]) return STATUS_INVALID_HANDLE;
+    if (entry >= FD_CACHE_ENTRIES) return STATUS_INVALID_HANDLE;
+    /* blocks are never freed, and are zeroed before being published */
+    if (!(block = *(union fd_cache_entry * volatile *)&fd_cache[entry])) return STATUS_INVALID_HANDLE;
 
-    cache.data = interlocked_cmpxchg64( &fd_cache[entry][idx].data, 0, 0 );
+    cache.data = read_fd_cache_entry( &block[idx] );
     if (!cache.data) return STATUS_INVALID_HANDLE;
 
     /* if fd type is invalid, fd stores an error value */
@@ -1533,6 +1859,7 @@ size_t server_init_thread( void *entry_point, BOOL *suspend )
                 fatal_error( "WINEARCH set to win64 but '%s' is a 32-bit installation.\n",
                              wine_get_config_dir() );
         }
+        server_init_thread_shm();
         return info_size;
     case STATUS_INVALID_IMAGE_WIN_64:
         fatal_error( "'%s' is a 32-bit installation, it cannot support 64-bit applications.\n",
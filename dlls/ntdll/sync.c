@@ -34,6 +34,9 @@
 #ifdef HAVE_SYS_TIME_H
 # include <sys/time.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
 #ifdef HAVE_POLL_H
 #include <poll.h>
 #endif
@@ -57,6 +60,7 @@
 #define NONAMELESSUNION
 #include "windef.h"
 #include "winternl.h"
+#include "wine/library.h"
 #include "wine/server.h"
 #include "wine/debug.h"
 #include "ntdll_misc.h"
@@ -132,6 +136,817 @@ static void timespec_from_timeout( struct timespec *timespec, const LARGE_INTEGE
 }
 #endif
 
+
+/*
+ *	Fast synchronization objects
+ *
+ * When WINE_FAST_SYNC is set, unnamed and non-inheritable events, semaphores
+ * and mutexes keep their state in the client and are waited on with futexes,
+ * so that waiting and signaling don't need a server round trip. The server
+ * object is still created so that the handle works with all the generic
+ * handle functions, but its state is only brought up to date once the object
+ * is used in a way the client can't handle by itself (alertable waits, waits
+ * mixing fast and server objects, handles passed to the server or to another
+ * process). From then on the object is "demoted" and the server state is the
+ * only one that is used.
+ */
+
+enum fast_sync_type
+{
+    FAST_SYNC_EVENT = 1,
+    FAST_SYNC_SEMAPHORE,
+    FAST_SYNC_MUTEX
+};
+
+enum fast_sync_demotion
+{
+    FAST_SYNC_ACTIVE,       /* state is tracked by the client */
+    FAST_SYNC_DEMOTING,     /* state is being transferred to the server */
+    FAST_SYNC_DEMOTED       /* state is tracked by the server */
+};
+
+struct fast_sync
+{
+    int               type;      /* object type */
+    int               refcount;  /* one reference per handle, plus the ones held by waiters */
+    int               users;     /* number of threads currently accessing the state */
+    int               demoted;   /* demotion state */
+    int               seq;       /* futex word, incremented every time the object is signaled */
+    int               state;     /* event: signaled, semaphore: count, mutex: recursion count */
+    int               max;       /* event: manual reset, semaphore: maximum count */
+    int               owner;     /* mutex: owner thread id */
+    int               abandoned; /* mutex: abandoned by its owner */
+    struct fast_sync *next;      /* next object in the free list */
+};
+
+#ifdef __linux__
+
+#define FAST_SYNC_BLOCK_SIZE  (65536 / sizeof(struct fast_sync *))
+#define FAST_SYNC_ENTRIES     128
+#define FAST_SYNC_ALLOC_COUNT 256
+
+static struct fast_sync **fast_sync_table[FAST_SYNC_ENTRIES];
+static struct fast_sync *fast_sync_free_list;
+static int fast_sync_mutexes;  /* number of fast mutexes, to avoid scanning the table on thread exit */
+static int multi_waiters;      /* number of threads waiting on more than one object */
+static int multi_seq;          /* futex word for multiple object waits */
+
+static RTL_CRITICAL_SECTION fast_sync_section;
+static RTL_CRITICAL_SECTION_DEBUG fast_sync_critsect_debug =
+{
+    0, 0, &fast_sync_section,
+    { &fast_sync_critsect_debug.ProcessLocksList, &fast_sync_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": fast_sync_section") }
+};
+static RTL_CRITICAL_SECTION fast_sync_section = { &fast_sync_critsect_debug, -1, 0, 0, 0, 0 };
+
+static inline int use_fast_sync(void)
+{
+    static int enabled = -1;
+
+    if (enabled == -1)
+    {
+        const char *env = getenv( "WINE_FAST_SYNC" );
+        enabled = env && atoi( env ) && use_futexes();
+        if (enabled) TRACE( "using fast synchronization objects\n" );
+    }
+    return enabled;
+}
+
+static inline int current_tid(void)
+{
+    return HandleToULong( NtCurrentTeb()->ClientId.UniqueThread );
+}
+
+static inline struct fast_sync **fast_sync_slot( HANDLE handle, BOOL alloc )
+{
+    unsigned int idx = (wine_server_obj_handle( handle ) >> 2) - 1;
+    unsigned int entry = idx / FAST_SYNC_BLOCK_SIZE;
+
+    if (entry >= FAST_SYNC_ENTRIES) return NULL;
+    if (!fast_sync_table[entry])
+    {
+        void *ptr;
+
+        if (!alloc) return NULL;
+        ptr = wine_anon_mmap( NULL, FAST_SYNC_BLOCK_SIZE * sizeof(struct fast_sync *),
+                              PROT_READ | PROT_WRITE, 0 );
+        if (ptr == MAP_FAILED) return NULL;
+        if (interlocked_cmpxchg_ptr( (void **)&fast_sync_table[entry], ptr, NULL ))
+            munmap( ptr, FAST_SYNC_BLOCK_SIZE * sizeof(struct fast_sync *) );
+    }
+    return &fast_sync_table[entry][idx % FAST_SYNC_BLOCK_SIZE];
+}
+
+/* objects are never returned to the system, so that a stale pointer read
+ * from the table always points to valid memory */
+static struct fast_sync *alloc_fast_sync( int type, int state, int max )
+{
+    struct fast_sync *obj;
+
+    RtlEnterCriticalSection( &fast_sync_section );
+    if (!fast_sync_free_list)
+    {
+        struct fast_sync *block;
+        unsigned int i;
+
+        if (!(block = RtlAllocateHeap( GetProcessHeap(), 0, FAST_SYNC_ALLOC_COUNT * sizeof(*block) )))
+        {
+            RtlLeaveCriticalSection( &fast_sync_section );
+            return NULL;
+        }
+        for (i = 0; i < FAST_SYNC_ALLOC_COUNT; i++)
+        {
+            block[i].refcount = 0;
+            block[i].next = fast_sync_free_list;
+            fast_sync_free_list = &block[i];
+        }
+    }
+    obj = fast_sync_free_list;
+    fast_sync_free_list = obj->next;
+    RtlLeaveCriticalSection( &fast_sync_section );
+
+    obj->type      = type;
+    obj->users     = 0;
+    obj->demoted   = FAST_SYNC_ACTIVE;
+    obj->seq       = 0;
+    obj->state     = state;
+    obj->max       = max;
+    obj->owner     = (type == FAST_SYNC_MUTEX && state) ? current_tid() : 0;
+    obj->abandoned = 0;
+    obj->next      = NULL;
+    if (type == FAST_SYNC_MUTEX) interlocked_xchg_add( &fast_sync_mutexes, 1 );
+    interlocked_xchg( &obj->refcount, 1 );
+    return obj;
+}
+
+static void release_fast_sync( struct fast_sync *obj )
+{
+    if (interlocked_xchg_add( &obj->refcount, -1 ) > 1) return;
+
+    if (obj->type == FAST_SYNC_MUTEX) interlocked_xchg_add( &fast_sync_mutexes, -1 );
+    RtlEnterCriticalSection( &fast_sync_section );
+    obj->next = fast_sync_free_list;
+    fast_sync_free_list = obj;
+    RtlLeaveCriticalSection( &fast_sync_section );
+}
+
+/* get a reference to the fast object associated with a handle */
+static struct fast_sync *grab_fast_sync( HANDLE handle )
+{
+    struct fast_sync **slot, *obj;
+
+    if (!use_fast_sync() || !(slot = fast_sync_slot( handle, FALSE ))) return NULL;
+
+    while ((obj = interlocked_cmpxchg_ptr( (void **)slot, NULL, NULL )))
+    {
+        int ref = obj->refcount;
+
+        /* the object may have been freed and reused in the meantime */
+        if (ref && interlocked_cmpxchg( &obj->refcount, ref + 1, ref ) == ref)
+        {
+            if (*(struct fast_sync * volatile *)slot == obj) return obj;
+            release_fast_sync( obj );
+        }
+    }
+    return NULL;
+}
+
+static void set_fast_sync( HANDLE handle, struct fast_sync *obj )
+{
+    struct fast_sync **slot = fast_sync_slot( handle, TRUE );
+
+    if (!slot)
+    {
+        FIXME( "too many allocated handles, not using fast sync for %p\n", handle );
+        return;
+    }
+    interlocked_xchg_add( &obj->refcount, 1 );
+    if ((obj = interlocked_xchg_ptr( (void **)slot, obj ))) release_fast_sync( obj );
+}
+
+static void create_fast_sync( HANDLE handle, int type, int state, int max )
+{
+    struct fast_sync *obj;
+
+    if (!(obj = alloc_fast_sync( type, state, max ))) return;
+    set_fast_sync( handle, obj );
+    release_fast_sync( obj );
+}
+
+/* the fast paths don't check access rights, so the handles need all the rights they use */
+static BOOL has_fast_sync_access( int type, ACCESS_MASK access )
+{
+    ACCESS_MASK needed = SYNCHRONIZE;
+
+    if (access & (GENERIC_ALL | MAXIMUM_ALLOWED)) return TRUE;
+    if (access & GENERIC_EXECUTE) access |= SYNCHRONIZE;
+
+    switch (type)
+    {
+    case FAST_SYNC_EVENT:
+        if (access & GENERIC_READ)  access |= EVENT_QUERY_STATE;
+        if (access & GENERIC_WRITE) access |= EVENT_MODIFY_STATE;
+        needed |= EVENT_QUERY_STATE | EVENT_MODIFY_STATE;
+        break;
+    case FAST_SYNC_SEMAPHORE:
+        if (access & GENERIC_READ)  access |= SEMAPHORE_QUERY_STATE;
+        if (access & GENERIC_WRITE) access |= SEMAPHORE_MODIFY_STATE;
+        needed |= SEMAPHORE_QUERY_STATE | SEMAPHORE_MODIFY_STATE;
+        break;
+    case FAST_SYNC_MUTEX:
+        if (access & GENERIC_READ)  access |= MUTANT_QUERY_STATE;
+        needed |= MUTANT_QUERY_STATE;
+        break;
+    }
+    return (access & needed) == needed;
+}
+
+/* only anonymous objects that can't be accessed through inheritance can be fast */
+static BOOL is_fast_sync_candidate( const OBJECT_ATTRIBUTES *attr, int type, ACCESS_MASK access )
+{
+    if (!use_fast_sync() || !has_fast_sync_access( type, access )) return FALSE;
+    if (!attr) return TRUE;
+    if (attr->ObjectName && attr->ObjectName->Length) return FALSE;
+    return !attr->RootDirectory && !(attr->Attributes & OBJ_INHERIT);
+}
+
+static inline void wake_fast_sync( struct fast_sync *obj, int count )
+{
+    interlocked_xchg_add( &obj->seq, 1 );
+    futex_wake( &obj->seq, count );
+    if (*(volatile int *)&multi_waiters)
+    {
+        interlocked_xchg_add( &multi_seq, 1 );
+        futex_wake( &multi_seq, INT_MAX );
+    }
+}
+
+/* start accessing the state; fails if the object has been demoted */
+static BOOL enter_fast_sync( struct fast_sync *obj )
+{
+    interlocked_xchg_add( &obj->users, 1 );
+    if (*(volatile int *)&obj->demoted == FAST_SYNC_ACTIVE) return TRUE;
+    interlocked_xchg_add( &obj->users, -1 );
+    while (*(volatile int *)&obj->demoted != FAST_SYNC_DEMOTED) NtYieldExecution();
+    return FALSE;
+}
+
+static inline void leave_fast_sync( struct fast_sync *obj )
+{
+    interlocked_xchg_add( &obj->users, -1 );
+}
+
+/* transfer the state of the object to the server */
+static void demote_fast_sync( struct fast_sync *obj, HANDLE handle )
+{
+    NTSTATUS ret = STATUS_SUCCESS;
+
+    if (interlocked_cmpxchg( &obj->demoted, FAST_SYNC_DEMOTING, FAST_SYNC_ACTIVE ) != FAST_SYNC_ACTIVE)
+    {
+        while (*(volatile int *)&obj->demoted != FAST_SYNC_DEMOTED) NtYieldExecution();
+        return;
+    }
+    while (*(volatile int *)&obj->users) NtYieldExecution();
+
+    TRACE( "demoting %p type %u state %d\n", handle, obj->type, obj->state );
+
+    switch (obj->type)
+    {
+    case FAST_SYNC_EVENT:
+        if (!obj->state) break;  /* the server object was created non-signaled */
+        SERVER_START_REQ( set_event_state )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            req->state  = obj->state;
+            ret = wine_server_call( req );
+        }
+        SERVER_END_REQ;
+        break;
+    case FAST_SYNC_SEMAPHORE:
+        if (!obj->state) break;  /* the server object was created with a zero count */
+        SERVER_START_REQ( set_semaphore_state )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            req->count  = obj->state;
+            ret = wine_server_call( req );
+        }
+        SERVER_END_REQ;
+        break;
+    case FAST_SYNC_MUTEX:
+        if (!obj->state && !obj->abandoned) break;  /* the server object was created unowned */
+        SERVER_START_REQ( set_mutex_state )
+        {
+            req->handle    = wine_server_obj_handle( handle );
+            req->owner     = obj->state ? obj->owner : 0;
+            req->count     = obj->state;
+            req->abandoned = obj->abandoned;
+            ret = wine_server_call( req );
+        }
+        SERVER_END_REQ;
+        break;
+    }
+    if (ret) ERR( "failed to demote %p: %08x\n", handle, ret );
+
+    interlocked_xchg( &obj->demoted, FAST_SYNC_DEMOTED );
+    /* waiters will notice the demotion and restart on the server side */
+    wake_fast_sync( obj, INT_MAX );
+}
+
+/***********************************************************************
+ *           fast_sync_demote_handle
+ *
+ * Make sure the server has the current state of the object, because the
+ * handle is about to be used outside of the fast path.
+ */
+void fast_sync_demote_handle( HANDLE handle )
+{
+    struct fast_sync *obj;
+
+    if (!handle || !(obj = grab_fast_sync( handle ))) return;
+    demote_fast_sync( obj, handle );
+    release_fast_sync( obj );
+}
+
+/***********************************************************************
+ *           fast_sync_close_handle
+ */
+void fast_sync_close_handle( HANDLE handle )
+{
+    struct fast_sync **slot, *obj;
+
+    if (!use_fast_sync() || !(slot = fast_sync_slot( handle, FALSE ))) return;
+    if ((obj = interlocked_xchg_ptr( (void **)slot, NULL ))) release_fast_sync( obj );
+}
+
+/***********************************************************************
+ *           fast_sync_dup_handle
+ *
+ * Handle duplication inside the current process shares the fast object,
+ * unless the new handle has less access rights; the object then has to
+ * go through the server, which checks them.
+ */
+void fast_sync_dup_handle( HANDLE source, HANDLE dest, ACCESS_MASK access, ULONG options, BOOL close_source )
+{
+    struct fast_sync *obj;
+
+    if (!(obj = grab_fast_sync( source ))) return;
+    if (close_source) fast_sync_close_handle( source );
+    if (dest)
+    {
+        if ((options & DUPLICATE_SAME_ACCESS) || has_fast_sync_access( obj->type, access ))
+            set_fast_sync( dest, obj );
+        else
+            demote_fast_sync( obj, dest );
+    }
+    release_fast_sync( obj );
+}
+
+/***********************************************************************
+ *           fast_sync_thread_exit
+ *
+ * Abandon the fast mutexes owned by the exiting thread.
+ */
+void fast_sync_thread_exit(void)
+{
+    unsigned int entry, idx;
+    int tid;
+
+    if (!use_fast_sync() || !*(volatile int *)&fast_sync_mutexes) return;
+
+    tid = current_tid();
+    for (entry = 0; entry < FAST_SYNC_ENTRIES; entry++)
+    {
+        if (!fast_sync_table[entry]) continue;
+        for (idx = 0; idx < FAST_SYNC_BLOCK_SIZE; idx++)
+        {
+            HANDLE handle = ULongToHandle( (entry * FAST_SYNC_BLOCK_SIZE + idx + 1) << 2 );
+            struct fast_sync *obj;
+
+            if (!fast_sync_table[entry][idx] || !(obj = grab_fast_sync( handle ))) continue;
+            if (obj->type == FAST_SYNC_MUTEX && obj->owner == tid && enter_fast_sync( obj ))
+            {
+                obj->state = 0;
+                obj->abandoned = 1;
+                interlocked_xchg( &obj->owner, 0 );
+                wake_fast_sync( obj, 1 );
+                leave_fast_sync( obj );
+            }
+            release_fast_sync( obj );
+        }
+    }
+}
+
+/* try to satisfy a wait; returns -1 if not signaled, 1 if an abandoned mutex was acquired */
+static int acquire_fast_sync( struct fast_sync *obj, int tid )
+{
+    switch (obj->type)
+    {
+    case FAST_SYNC_EVENT:
+        if (obj->max) return *(volatile int *)&obj->state ? 0 : -1;
+        return interlocked_cmpxchg( &obj->state, 0, 1 ) ? 0 : -1;
+    case FAST_SYNC_SEMAPHORE:
+        return interlocked_dec_if_nonzero( &obj->state ) ? 0 : -1;
+    case FAST_SYNC_MUTEX:
+        if (obj->owner == tid)
+        {
+            obj->state++;
+            return 0;
+        }
+        if (interlocked_cmpxchg( &obj->owner, tid, 0 )) return -1;
+        obj->state = 1;
+        return interlocked_xchg( &obj->abandoned, 0 ) ? 1 : 0;
+    }
+    return -1;
+}
+
+/* undo a successful acquire_fast_sync, when a wait-all could not get all the objects */
+static void unacquire_fast_sync( struct fast_sync *obj, int abandoned )
+{
+    switch (obj->type)
+    {
+    case FAST_SYNC_EVENT:
+        if (!obj->max && !interlocked_xchg( &obj->state, 1 )) wake_fast_sync( obj, 1 );
+        break;
+    case FAST_SYNC_SEMAPHORE:
+        interlocked_xchg_add( &obj->state, 1 );
+        wake_fast_sync( obj, 1 );
+        break;
+    case FAST_SYNC_MUTEX:
+        if (--obj->state) break;
+        obj->abandoned = abandoned;
+        interlocked_xchg( &obj->owner, 0 );
+        wake_fast_sync( obj, 1 );
+        break;
+    }
+}
+
+static BOOL is_fast_sync_signaled( struct fast_sync *obj, int tid )
+{
+    int owner;
+
+    switch (obj->type)
+    {
+    case FAST_SYNC_EVENT:
+    case FAST_SYNC_SEMAPHORE:
+        return *(volatile int *)&obj->state != 0;
+    case FAST_SYNC_MUTEX:
+        owner = *(volatile int *)&obj->owner;
+        return !owner || owner == tid;
+    }
+    return FALSE;
+}
+
+/* returns FALSE if the timeout has expired */
+static BOOL get_remaining_timeout( struct timespec *ts, timeout_t end )
+{
+    LARGE_INTEGER now;
+    timeout_t diff;
+
+    NtQuerySystemTime( &now );
+    if ((diff = end - now.QuadPart) <= 0) return FALSE;
+    ts->tv_sec  = diff / TICKSPERSEC;
+    ts->tv_nsec = (diff % TICKSPERSEC) * 100;
+    return TRUE;
+}
+
+static NTSTATUS wait_fast_sync( DWORD count, struct fast_sync **objs, BOOLEAN wait_any,
+                                const LARGE_INTEGER *timeout )
+{
+    struct timespec ts, *pts = NULL;
+    timeout_t end = 0;
+    int tid = current_tid();
+    int *futex = (count == 1) ? &objs[0]->seq : &multi_seq;
+    int abandoned[MAXIMUM_WAIT_OBJECTS];
+    NTSTATUS ret = STATUS_PENDING;
+    DWORD i, j;
+
+    if (timeout && timeout->QuadPart != TIMEOUT_INFINITE)
+    {
+        LARGE_INTEGER now;
+
+        NtQuerySystemTime( &now );
+        end = timeout->QuadPart > 0 ? timeout->QuadPart : now.QuadPart - timeout->QuadPart;
+        pts = &ts;
+    }
+
+    if (count > 1) interlocked_xchg_add( &multi_waiters, 1 );
+
+    while (ret == STATUS_PENDING)
+    {
+        int seq = *(volatile int *)futex;
+
+        for (i = 0; i < count; i++) if (!enter_fast_sync( objs[i] )) break;
+        if (i < count)
+        {
+            while (i--) leave_fast_sync( objs[i] );
+            ret = STATUS_NOT_IMPLEMENTED;
+            break;
+        }
+
+        if (wait_any)
+        {
+            for (i = 0; i < count; i++)
+            {
+                int res = acquire_fast_sync( objs[i], tid );
+                if (res == -1) continue;
+                ret = (res ? STATUS_ABANDONED_WAIT_0 : STATUS_WAIT_0) + i;
+                break;
+            }
+        }
+        else
+        {
+            /* wait-all acquirers are serialized to avoid livelocks between them */
+            RtlEnterCriticalSection( &fast_sync_section );
+            for (i = 0; i < count; i++) if (!is_fast_sync_signaled( objs[i], tid )) break;
+            if (i == count)
+            {
+                ret = STATUS_WAIT_0;
+                for (i = 0; i < count; i++)
+                {
+                    if ((abandoned[i] = acquire_fast_sync( objs[i], tid )) == -1) break;
+                    if (abandoned[i] && ret == STATUS_WAIT_0) ret = STATUS_ABANDONED_WAIT_0 + i;
+                }
+                if (i < count)  /* another thread got one of them first */
+                {
+                    for (j = 0; j < i; j++) unacquire_fast_sync( objs[j], abandoned[j] );
+                    ret = STATUS_PENDING;
+                }
+            }
+            RtlLeaveCriticalSection( &fast_sync_section );
+        }
+
+        for (i = 0; i < count; i++) leave_fast_sync( objs[i] );
+        if (ret != STATUS_PENDING) break;
+
+        if (pts && !get_remaining_timeout( pts, end ))
+        {
+            ret = STATUS_TIMEOUT;
+            break;
+        }
+        if (futex_wait( futex, seq, pts ) == -1 && errno == ETIMEDOUT)
+        {
+            ret = STATUS_TIMEOUT;
+            break;
+        }
+    }
+
+    if (count > 1) interlocked_xchg_add( &multi_waiters, -1 );
+    return ret;
+}
+
+/***********************************************************************
+ *           fast_sync_wait
+ *
+ * Returns STATUS_NOT_IMPLEMENTED if the wait has to go through the server.
+ */
+static NTSTATUS fast_sync_wait( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
+                                BOOLEAN alertable, const LARGE_INTEGER *timeout )
+{
+    struct fast_sync *objs[MAXIMUM_WAIT_OBJECTS];
+    DWORD i, j, fast = 0;
+    NTSTATUS ret = STATUS_NOT_IMPLEMENTED;
+
+    if (!use_fast_sync()) return STATUS_NOT_IMPLEMENTED;
+
+    for (i = 0; i < count; i++) if ((objs[i] = grab_fast_sync( handles[i] ))) fast++;
+    if (!fast) return STATUS_NOT_IMPLEMENTED;
+
+    if (fast == count && !alertable)
+    {
+        /* let the server report duplicate objects in wait-all */
+        if (!wait_any)
+            for (i = 0; i < count && ret == STATUS_NOT_IMPLEMENTED; i++)
+                for (j = i + 1; j < count; j++)
+                    if (objs[i] == objs[j]) ret = STATUS_PENDING;
+
+        if (ret == STATUS_NOT_IMPLEMENTED) ret = wait_fast_sync( count, objs, wait_any, timeout );
+        else ret = STATUS_NOT_IMPLEMENTED;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if (!objs[i]) continue;
+        if (ret == STATUS_NOT_IMPLEMENTED) demote_fast_sync( objs[i], handles[i] );
+        release_fast_sync( objs[i] );
+    }
+    return ret;
+}
+
+static NTSTATUS fast_sync_set_event( HANDLE handle, LONG *prev_state )
+{
+    struct fast_sync *obj;
+    NTSTATUS ret = STATUS_NOT_IMPLEMENTED;
+    int prev;
+
+    if (!(obj = grab_fast_sync( handle ))) return ret;
+    if (obj->type != FAST_SYNC_EVENT) ret = STATUS_OBJECT_TYPE_MISMATCH;
+    else if (enter_fast_sync( obj ))
+    {
+        if (!(prev = interlocked_xchg( &obj->state, 1 ))) wake_fast_sync( obj, obj->max ? INT_MAX : 1 );
+        leave_fast_sync( obj );
+        if (prev_state) *prev_state = prev;
+        ret = STATUS_SUCCESS;
+    }
+    release_fast_sync( obj );
+    return ret;
+}
+
+static NTSTATUS fast_sync_reset_event( HANDLE handle, LONG *prev_state )
+{
+    struct fast_sync *obj;
+    NTSTATUS ret = STATUS_NOT_IMPLEMENTED;
+    int prev;
+
+    if (!(obj = grab_fast_sync( handle ))) return ret;
+    if (obj->type != FAST_SYNC_EVENT) ret = STATUS_OBJECT_TYPE_MISMATCH;
+    else if (enter_fast_sync( obj ))
+    {
+        prev = interlocked_xchg( &obj->state, 0 );
+        leave_fast_sync( obj );
+        if (prev_state) *prev_state = prev;
+        ret = STATUS_SUCCESS;
+    }
+    release_fast_sync( obj );
+    return ret;
+}
+
+static NTSTATUS fast_sync_query_event( HANDLE handle, EVENT_BASIC_INFORMATION *info )
+{
+    struct fast_sync *obj;
+    NTSTATUS ret = STATUS_NOT_IMPLEMENTED;
+
+    if (!(obj = grab_fast_sync( handle ))) return ret;
+    if (obj->type != FAST_SYNC_EVENT) ret = STATUS_OBJECT_TYPE_MISMATCH;
+    else if (enter_fast_sync( obj ))
+    {
+        info->EventType  = obj->max ? NotificationEvent : SynchronizationEvent;
+        info->EventState = obj->state;
+        leave_fast_sync( obj );
+        ret = STATUS_SUCCESS;
+    }
+    release_fast_sync( obj );
+    return ret;
+}
+
+static NTSTATUS fast_sync_release_semaphore( HANDLE handle, ULONG count, ULONG *previous )
+{
+    struct fast_sync *obj;
+    NTSTATUS ret = STATUS_NOT_IMPLEMENTED;
+    int prev;
+
+    if (!(obj = grab_fast_sync( handle ))) return ret;
+    if (obj->type != FAST_SYNC_SEMAPHORE) ret = STATUS_OBJECT_TYPE_MISMATCH;
+    else if (enter_fast_sync( obj ))
+    {
+        for (;;)
+        {
+            prev = *(volatile int *)&obj->state;
+            if (count > (ULONG)(obj->max - prev))
+            {
+                ret = STATUS_SEMAPHORE_LIMIT_EXCEEDED;
+                break;
+            }
+            if (interlocked_cmpxchg( &obj->state, prev + count, prev ) == prev)
+            {
+                if (count) wake_fast_sync( obj, count );
+                if (previous) *previous = prev;
+                ret = STATUS_SUCCESS;
+                break;
+            }
+        }
+        leave_fast_sync( obj );
+    }
+    release_fast_sync( obj );
+    return ret;
+}
+
+static NTSTATUS fast_sync_query_semaphore( HANDLE handle, SEMAPHORE_BASIC_INFORMATION *info )
+{
+    struct fast_sync *obj;
+    NTSTATUS ret = STATUS_NOT_IMPLEMENTED;
+
+    if (!(obj = grab_fast_sync( handle ))) return ret;
+    if (obj->type != FAST_SYNC_SEMAPHORE) ret = STATUS_OBJECT_TYPE_MISMATCH;
+    else if (enter_fast_sync( obj ))
+    {
+        info->CurrentCount = obj->state;
+        info->MaximumCount = obj->max;
+        leave_fast_sync( obj );
+        ret = STATUS_SUCCESS;
+    }
+    release_fast_sync( obj );
+    return ret;
+}
+
+static NTSTATUS fast_sync_release_mutex( HANDLE handle, LONG *prev_count )
+{
+    struct fast_sync *obj;
+    NTSTATUS ret = STATUS_NOT_IMPLEMENTED;
+
+    if (!(obj = grab_fast_sync( handle ))) return ret;
+    if (obj->type != FAST_SYNC_MUTEX) ret = STATUS_OBJECT_TYPE_MISMATCH;
+    else if (enter_fast_sync( obj ))
+    {
+        if (obj->owner != current_tid() || !obj->state) ret = STATUS_MUTANT_NOT_OWNED;
+        else
+        {
+            if (prev_count) *prev_count = 1 - obj->state;
+            if (!--obj->state)
+            {
+                interlocked_xchg( &obj->owner, 0 );
+                wake_fast_sync( obj, 1 );
+            }
+            ret = STATUS_SUCCESS;
+        }
+        leave_fast_sync( obj );
+    }
+    release_fast_sync( obj );
+    return ret;
+}
+
+static NTSTATUS fast_sync_query_mutex( HANDLE handle, MUTANT_BASIC_INFORMATION *info )
+{
+    struct fast_sync *obj;
+    NTSTATUS ret = STATUS_NOT_IMPLEMENTED;
+
+    if (!(obj = grab_fast_sync( handle ))) return ret;
+    if (obj->type != FAST_SYNC_MUTEX) ret = STATUS_OBJECT_TYPE_MISMATCH;
+    else if (enter_fast_sync( obj ))
+    {
+        int owner = obj->owner, count = owner ? obj->state : 0;
+
+        info->CurrentCount   = 1 - count;
+        info->OwnedByCaller  = (owner == current_tid());
+        info->AbandonedState = obj->abandoned;
+        leave_fast_sync( obj );
+        ret = STATUS_SUCCESS;
+    }
+    release_fast_sync( obj );
+    return ret;
+}
+
+#else  /* __linux__ */
+
+static inline BOOL is_fast_sync_candidate( const OBJECT_ATTRIBUTES *attr, int type, ACCESS_MASK access )
+{
+    return FALSE;
+}
+static inline void create_fast_sync( HANDLE handle, int type, int state, int max ) { }
+
+void fast_sync_demote_handle( HANDLE handle ) { }
+void fast_sync_close_handle( HANDLE handle ) { }
+void fast_sync_dup_handle( HANDLE source, HANDLE dest, ACCESS_MASK access, ULONG options, BOOL close_source ) { }
+void fast_sync_thread_exit(void) { }
+
+static inline NTSTATUS fast_sync_wait( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
+                                       BOOLEAN alertable, const LARGE_INTEGER *timeout )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+static inline NTSTATUS fast_sync_set_event( HANDLE handle, LONG *prev_state )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+static inline NTSTATUS fast_sync_reset_event( HANDLE handle, LONG *prev_state )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+static inline NTSTATUS fast_sync_query_event( HANDLE handle, EVENT_BASIC_INFORMATION *info )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+static inline NTSTATUS fast_sync_release_semaphore( HANDLE handle, ULONG count, ULONG *previous )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+static inline NTSTATUS fast_sync_query_semaphore( HANDLE handle, SEMAPHORE_BASIC_INFORMATION *info )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+static inline NTSTATUS fast_sync_release_mutex( HANDLE handle, LONG *prev_count )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+static inline NTSTATUS fast_sync_query_mutex( HANDLE handle, MUTANT_BASIC_INFORMATION *info )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+#endif  /* __linux__ */
+
+
+/***********************************************************************
+ *           __wine_fast_sync_demote   (NTDLL.@)
+ *
+ * Called by other dlls before passing a synchronization object handle to
+ * the server, which will then signal the server side object.
+ */
+void CDECL __wine_fast_sync_demote( HANDLE handle )
+{
+    fast_sync_demote_handle( handle );
+}
+
 /* creates a struct security_descriptor and contained information in one contiguous piece of memory */
 NTSTATUS alloc_object_attributes( const OBJECT_ATTRIBUTES *attr, struct object_attributes **ret,
                                   data_size_t *ret_len )
@@ -244,23 +1059,29 @@ NTSTATUS WINAPI NtCreateSemaphore( OUT PHANDLE SemaphoreHandle,
     NTSTATUS ret;
     data_size_t len;
     struct object_attributes *objattr;
+    BOOL fast;
 
     if (MaximumCount <= 0 || InitialCount < 0 || InitialCount > MaximumCount)
         return STATUS_INVALID_PARAMETER;
 
     if ((ret = alloc_object_attributes( attr, &objattr, &len ))) return ret;
 
+    fast = is_fast_sync_candidate( attr, FAST_SYNC_SEMAPHORE, access );
+
     SERVER_START_REQ( create_semaphore )
     {
         req->access  = access;
-        req->initial = InitialCount;
+        req->initial = fast ? 0 : InitialCount;
         req->max     = MaximumCount;
+        req->client_state = fast;
         wine_server_add_data( req, objattr, len );
         ret = wine_server_call( req );
         *SemaphoreHandle = wine_server_ptr_handle( reply->handle );
     }
     SERVER_END_REQ;
 
+    if (!ret && fast) create_fast_sync( *SemaphoreHandle, FAST_SYNC_SEMAPHORE, InitialCount, MaximumCount );
+
     RtlFreeHeap( GetProcessHeap(), 0, objattr );
     return ret;
 }
@@ -307,6 +1128,12 @@ NTSTATUS WINAPI NtQuerySemaphore( HANDLE handle, SEMAPHORE_INFORMATION_CLASS cla
 
     if (len != sizeof(SEMAPHORE_BASIC_INFORMATION)) return STATUS_INFO_LENGTH_MISMATCH;
 
+    if ((ret = fast_sync_query_semaphore( handle, out )) != STATUS_NOT_IMPLEMENTED)
+    {
+        if (!ret && ret_len) *ret_len = sizeof(SEMAPHORE_BASIC_INFORMATION);
+        return ret;
+    }
+
     SERVER_START_REQ( query_semaphore )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -328,6 +1155,10 @@ NTSTATUS WINAPI NtQuerySemaphore( HANDLE handle, SEMAPHORE_INFORMATION_CLASS cla
 NTSTATUS WINAPI NtReleaseSemaphore( HANDLE handle, ULONG count, PULONG previous )
 {
     NTSTATUS ret;
+
+    if ((ret = fast_sync_release_semaphore( handle, count, previous )) != STATUS_NOT_IMPLEMENTED)
+        return ret;
+
     SERVER_START_REQ( release_semaphore )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -355,20 +1186,27 @@ NTSTATUS WINAPI NtCreateEvent( PHANDLE EventHandle, ACCESS_MASK DesiredAccess,
     NTSTATUS ret;
     data_size_t len;
     struct object_attributes *objattr;
+    BOOL fast;
 
     if ((ret = alloc_object_attributes( attr, &objattr, &len ))) return ret;
 
+    fast = is_fast_sync_candidate( attr, FAST_SYNC_EVENT, DesiredAccess );
+
     SERVER_START_REQ( create_event )
     {
         req->access = DesiredAccess;
         req->manual_reset = (type == NotificationEvent);
-        req->initial_state = InitialState;
+        req->initial_state = fast ? FALSE : InitialState;
+        req->client_state = fast;
         wine_server_add_data( req, objattr, len );
         ret = wine_server_call( req );
         *EventHandle = wine_server_ptr_handle( reply->handle );
     }
     SERVER_END_REQ;
 
+    if (!ret && fast)
+        create_fast_sync( *EventHandle, FAST_SYNC_EVENT, InitialState != 0, type == NotificationEvent );
+
     RtlFreeHeap( GetProcessHeap(), 0, objattr );
     return ret;
 }
@@ -405,6 +1243,9 @@ NTSTATUS WINAPI NtOpenEvent( HANDLE *handle, ACCESS_MASK access, const OBJECT_AT
 NTSTATUS WINAPI NtSetEvent( HANDLE handle, LONG *prev_state )
 {
     NTSTATUS ret;
+
+    if ((ret = fast_sync_set_event( handle, prev_state )) != STATUS_NOT_IMPLEMENTED) return ret;
+
     SERVER_START_REQ( event_op )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -422,6 +1263,9 @@ NTSTATUS WINAPI NtSetEvent( HANDLE handle, LONG *prev_state )
 NTSTATUS WINAPI NtResetEvent( HANDLE handle, LONG *prev_state )
 {
     NTSTATUS ret;
+
+    if ((ret = fast_sync_reset_event( handle, prev_state )) != STATUS_NOT_IMPLEMENTED) return ret;
+
     SERVER_START_REQ( event_op )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -454,6 +1298,9 @@ NTSTATUS WINAPI NtPulseEvent( HANDLE handle, LONG *prev_state )
 {
     NTSTATUS ret;
 
+    /* waiters could miss a pulse of the client state, leave it to the server */
+    fast_sync_demote_handle( handle );
+
     SERVER_START_REQ( event_op )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -485,6 +1332,12 @@ NTSTATUS WINAPI NtQueryEvent( HANDLE handle, EVENT_INFORMATION_CLASS class,
 
     if (len != sizeof(EVENT_BASIC_INFORMATION)) return STATUS_INFO_LENGTH_MISMATCH;
 
+    if ((ret = fast_sync_query_event( handle, out )) != STATUS_NOT_IMPLEMENTED)
+    {
+        if (!ret && ret_len) *ret_len = sizeof(EVENT_BASIC_INFORMATION);
+        return ret;
+    }
+
     SERVER_START_REQ( query_event )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -516,19 +1369,25 @@ NTSTATUS WINAPI NtCreateMutant(OUT HANDLE* MutantHandle,
     NTSTATUS status;
     data_size_t len;
     struct object_attributes *objattr;
+    BOOL fast;
 
     if ((status = alloc_object_attributes( attr, &objattr, &len ))) return status;
 
+    fast = is_fast_sync_candidate( attr, FAST_SYNC_MUTEX, access );
+
     SERVER_START_REQ( create_mutex )
     {
         req->access  = access;
-        req->owned   = InitialOwner;
+        req->owned   = fast ? FALSE : InitialOwner;
+        req->client_state = fast;
         wine_server_add_data( req, objattr, len );
         status = wine_server_call( req );
         *MutantHandle = wine_server_ptr_handle( reply->handle );
     }
     SERVER_END_REQ;
 
+    if (!status && fast) create_fast_sync( *MutantHandle, FAST_SYNC_MUTEX, InitialOwner != 0, 0 );
+
     RtlFreeHeap( GetProcessHeap(), 0, objattr );
     return status;
 }
@@ -565,6 +1424,9 @@ NTSTATUS WINAPI NtReleaseMutant( IN HANDLE handle, OUT PLONG prev_count OPTIONAL
 {
     NTSTATUS    status;
 
+    if ((status = fast_sync_release_mutex( handle, prev_count )) != STATUS_NOT_IMPLEMENTED)
+        return status;
+
     SERVER_START_REQ( release_mutex )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -596,6 +1458,12 @@ NTSTATUS WINAPI NtQueryMutant( HANDLE handle, MUTANT_INFORMATION_CLASS class,
 
     if (len != sizeof(MUTANT_BASIC_INFORMATION)) return STATUS_INFO_LENGTH_MISMATCH;
 
+    if ((ret = fast_sync_query_mutex( handle, out )) != STATUS_NOT_IMPLEMENTED)
+    {
+        if (!ret && ret_len) *ret_len = sizeof(MUTANT_BASIC_INFORMATION);
+        return ret;
+    }
+
     SERVER_START_REQ( query_mutex )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -1077,9 +1945,13 @@ static NTSTATUS wait_objects( DWORD count, const HANDLE *handles,
 {
     select_op_t select_op;
     UINT i, flags = SELECT_INTERRUPTIBLE;
+    NTSTATUS ret;
 
     if (!count || count > MAXIMUM_WAIT_OBJECTS) return STATUS_INVALID_PARAMETER_1;
 
+    if ((ret = fast_sync_wait( count, handles, wait_any, alertable, timeout )) != STATUS_NOT_IMPLEMENTED)
+        return ret;
+
     if (alertable) flags |= SELECT_ALERTABLE;
     select_op.wait.op = wait_any ? SELECT_WAIT : SELECT_WAIT_ALL;
     for (i = 0; i < count; i++) select_op.wait.handles[i] = wine_server_obj_handle( handles[i] );
@@ -1118,6 +1990,10 @@ NTSTATUS WINAPI NtSignalAndWaitForSingleObject( HANDLE hSignalObject, HANDLE hWa
 
     if (!hSignalObject) return STATUS_INVALID_HANDLE;
 
+    /* the signal and the wait have to be atomic, so let the server handle it */
+    fast_sync_demote_handle( hSignalObject );
+    fast_sync_demote_handle( hWaitObject );
+
     if (alertable) flags |= SELECT_ALERTABLE;
     select_op.signal_and_wait.op = SELECT_SIGNAL_AND_WAIT;
     select_op.signal_and_wait.wait = wine_server_obj_handle( hWaitObject );
@@ -1395,31 +2271,36 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE CompletionPort, PULONG_PTR Completi
 NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE port, FILE_IO_COMPLETION_INFORMATION *info, ULONG count,
                                         ULONG *written, LARGE_INTEGER *timeout, BOOLEAN alertable )
 {
+    struct completion_msg msgs[64];
     NTSTATUS ret;
-    ULONG i = 0;
+    ULONG i = 0, j, n;
 
     TRACE("%p %p %u %p %p %u\n", port, info, count, written, timeout, alertable);
 
     for (;;)
     {
+        /* drain the queue in batches, one server round trip per batch */
         while (i < count)
         {
-            SERVER_START_REQ( remove_completion )
+            n = 0;
+            SERVER_START_REQ( remove_completions )
             {
                 req->handle = wine_server_obj_handle( port );
+                wine_server_set_reply( req, msgs, min( count - i, ARRAY_SIZE(msgs) ) * sizeof(msgs[0]) );
                 if (!(ret = wine_server_call( req )))
-                {
-                    info[i].CompletionKey             = reply->ckey;
-                    info[i].CompletionValue           = reply->cvalue;
-                    info[i].IoStatusBlock.Information = reply->information;
-                    info[i].IoStatusBlock.u.Status    = reply->status;
-                }
+                    n = wine_server_reply_size( reply ) / sizeof(msgs[0]);
             }
             SERVER_END_REQ;
 
-            if (ret != STATUS_SUCCESS) break;
+            for (j = 0; j < n; j++, i++)
+            {
+                info[i].CompletionKey             = msgs[j].ckey;
+                info[i].CompletionValue           = msgs[j].cvalue;
+                info[i].IoStatusBlock.Information = msgs[j].information;
+                info[i].IoStatusBlock.u.Status    = msgs[j].status;
+            }
 
-            ++i;
+            if (ret != STATUS_SUCCESS || n < ARRAY_SIZE(msgs)) break;
         }
 
         if (i || ret != STATUS_PENDING)
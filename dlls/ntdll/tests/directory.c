@@ -879,10 +879,175 @@ static void test_redirection(void)
     pRtlWow64EnableFsRedirectionEx( old, &cur );
 }
 
+static void test_case_insensitive_lookup_performance(void)
+{
+    unsigned int i, nb_files = winetest_interactive ? 50000 : 200;
+    unsigned int nb_lookups = winetest_interactive ? 100000 : 1000;
+    char testdir[MAX_PATH], path[MAX_PATH];
+    LARGE_INTEGER freq, start, end;
+    DWORD attrs;
+    HANDLE file;
+
+    GetTempPathA( MAX_PATH, testdir );
+    strcat( testdir, "lookup.tmp" );
+    if (!CreateDirectoryA( testdir, NULL ))
+    {
+        skip( "couldn't create %s, error %u\n", testdir, GetLastError() );
+        return;
+    }
+
+    for (i = 0; i < nb_files; i++)
+    {
+        sprintf( path, "%s\\file%05u.txt", testdir, i );
+        file = CreateFileA( path, GENERIC_WRITE, 0, NULL, CREATE_NEW, 0, NULL );
+        ok( file != INVALID_HANDLE_VALUE, "failed to create %s, error %u\n", path, GetLastError() );
+        CloseHandle( file );
+    }
+
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < nb_lookups; i++)
+    {
+        /* one lookup in four is for a missing file */
+        if (i % 4 == 3)
+        {
+            sprintf( path, "%s\\MiSsInG%05u.TxT", testdir, i % nb_files );
+            attrs = GetFileAttributesA( path );
+            ok( attrs == INVALID_FILE_ATTRIBUTES, "found %s\n", path );
+        }
+        else
+        {
+            sprintf( path, "%s\\FiLe%05u.TxT", testdir, (i * 7919) % nb_files );
+            attrs = GetFileAttributesA( path );
+            ok( attrs != INVALID_FILE_ATTRIBUTES, "failed to find %s, error %u\n", path, GetLastError() );
+        }
+    }
+    QueryPerformanceCounter( &end );
+    if (winetest_interactive)
+        trace( "%u files: %.0f lookups/s\n", nb_files,
+               nb_lookups / ((double)(end.QuadPart - start.QuadPart) / freq.QuadPart) );
+
+    /* the cached contents must follow changes to the directory */
+    sprintf( path, "%s\\NeWfIlE.txt", testdir );
+    file = CreateFileA( path, GENERIC_WRITE, 0, NULL, CREATE_NEW, 0, NULL );
+    ok( file != INVALID_HANDLE_VALUE, "failed to create %s, error %u\n", path, GetLastError() );
+    CloseHandle( file );
+    sprintf( path, "%s\\newfile.TXT", testdir );
+    ok( GetFileAttributesA( path ) != INVALID_FILE_ATTRIBUTES, "failed to find %s\n", path );
+    ok( DeleteFileA( path ), "failed to delete %s, error %u\n", path, GetLastError() );
+    ok( GetFileAttributesA( path ) == INVALID_FILE_ATTRIBUTES, "found deleted %s\n", path );
+
+    for (i = 0; i < nb_files; i++)
+    {
+        sprintf( path, "%s\\file%05u.txt", testdir, i );
+        DeleteFileA( path );
+    }
+    RemoveDirectoryA( testdir );
+}
+
+static void create_test_file( const char *path, char data )
+{
+    DWORD size;
+    HANDLE file;
+
+    file = CreateFileA( path, GENERIC_WRITE, 0, NULL, CREATE_NEW, 0, NULL );
+    ok( file != INVALID_HANDLE_VALUE, "failed to create %s, error %u\n", path, GetLastError() );
+    WriteFile( file, &data, 1, &size, NULL );
+    CloseHandle( file );
+}
+
+/* returns the first byte of the file, or 0 if it can't be opened */
+static char read_test_file( const char *path )
+{
+    char data = 0;
+    DWORD size;
+    HANDLE file;
+
+    file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL );
+    if (file == INVALID_HANDLE_VALUE) return 0;
+    if (!ReadFile( file, &data, 1, &size, NULL ) || !size) data = 0;
+    CloseHandle( file );
+    return data;
+}
+
+/* case-insensitive lookups must follow creates, renames and deletes; run both with
+ * and without WINE_NAME_INDEX, which caches the results of the lookups in the prefix */
+static void test_case_insensitive_lookup_changes(void)
+{
+    char testdir[MAX_PATH], path[MAX_PATH], path2[MAX_PATH];
+    unsigned int i;
+    BOOL ret;
+
+    GetTempPathA( MAX_PATH, testdir );
+    sprintf( testdir + strlen( testdir ), "lookup%u.tmp", GetCurrentProcessId() );
+    if (!CreateDirectoryA( testdir, NULL ))
+    {
+        skip( "couldn't create %s, error %u\n", testdir, GetLastError() );
+        return;
+    }
+
+    sprintf( path, "%s\\MixedCase.txt", testdir );
+    create_test_file( path, '1' );
+    for (i = 0; i < 2; i++)  /* the second lookup may come from the index */
+    {
+        sprintf( path, "%s\\mixedcase.TXT", testdir );
+        ok( read_test_file( path ) == '1', "%u: failed to read %s\n", i, path );
+    }
+
+    /* rename */
+    sprintf( path2, "%s\\Renamed.txt", testdir );
+    ret = MoveFileA( path, path2 );
+    ok( ret, "failed to rename %s, error %u\n", path, GetLastError() );
+    ok( GetFileAttributesA( path ) == INVALID_FILE_ATTRIBUTES, "found renamed %s\n", path );
+    sprintf( path2, "%s\\RENAMED.TXT", testdir );
+    ok( read_test_file( path2 ) == '1', "failed to read %s\n", path2 );
+
+    /* create a different file with the old name in another case */
+    sprintf( path, "%s\\MIXEDCASE.TXT", testdir );
+    create_test_file( path, '2' );
+    for (i = 0; i < 2; i++)
+    {
+        sprintf( path, "%s\\mixedcase.txt", testdir );
+        ok( read_test_file( path ) == '2', "%u: failed to read %s\n", i, path );
+    }
+
+    /* delete */
+    ok( DeleteFileA( path ), "failed to delete %s, error %u\n", path, GetLastError() );
+    sprintf( path, "%s\\MixedCase.Txt", testdir );
+    ok( GetFileAttributesA( path ) == INVALID_FILE_ATTRIBUTES, "found deleted %s\n", path );
+    ok( DeleteFileA( path2 ), "failed to delete %s, error %u\n", path2, GetLastError() );
+    ok( GetFileAttributesA( path2 ) == INVALID_FILE_ATTRIBUTES, "found deleted %s\n", path2 );
+
+    RemoveDirectoryA( testdir );
+}
+
+static void test_name_index(void)
+{
+    STARTUPINFOA si = { sizeof(si) };
+    PROCESS_INFORMATION pi;
+    char cmdline[MAX_PATH + 32];
+    char **argv;
+    BOOL ret;
+
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "\"%s\" directory name_index", argv[0] );
+    SetEnvironmentVariableA( "WINE_NAME_INDEX", "1" );
+    ret = CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi );
+    SetEnvironmentVariableA( "WINE_NAME_INDEX", NULL );
+    ok( ret, "CreateProcess failed %u\n", GetLastError() );
+    if (!ret) return;
+    winetest_wait_child_process( pi.hProcess );
+    CloseHandle( pi.hProcess );
+    CloseHandle( pi.hThread );
+}
+
 START_TEST(directory)
 {
     WCHAR sysdir[MAX_PATH];
     HMODULE hntdll = GetModuleHandleA("ntdll.dll");
+    char **argv;
+    int argc;
+
     if (!hntdll)
     {
         skip("not running on NT, skipping test\n");
@@ -903,9 +1068,21 @@ START_TEST(directory)
     pRtlWow64EnableFsRedirection = (void *)GetProcAddress(hntdll,"RtlWow64EnableFsRedirection");
     pRtlWow64EnableFsRedirectionEx = (void *)GetProcAddress(hntdll,"RtlWow64EnableFsRedirectionEx");
 
+    argc = winetest_get_mainargs( &argv );
+    if (argc >= 3 && !strcmp( argv[2], "name_index" ))
+    {
+        /* twice, so that the second run uses the names recorded by the first one */
+        test_case_insensitive_lookup_changes();
+        test_case_insensitive_lookup_changes();
+        return;
+    }
+
     GetSystemDirectoryW( sysdir, MAX_PATH );
     test_directory_sort( sysdir );
     test_NtQueryDirectoryFile();
     test_NtQueryDirectoryFile_case();
     test_redirection();
+    test_case_insensitive_lookup_performance();
+    test_case_insensitive_lookup_changes();
+    test_name_index();
 }
@@ -4831,6 +4831,397 @@ static void test_file_readonly_access(void)
     DeleteFileW(path);
 }
 
+#define IO_STRESS_THREADS 4
+#define IO_STRESS_HANDLES 64
+
+struct io_stress_params
+{
+    HANDLE *handles;
+    unsigned int id;
+    unsigned int iterations;
+    unsigned int failures;
+};
+
+static DWORD WINAPI io_stress_thread( void *arg )
+{
+    struct io_stress_params *params = arg;
+    IO_STATUS_BLOCK io;
+    LARGE_INTEGER offset;
+    char buffer[64];
+    NTSTATUS status;
+    unsigned int i;
+
+    memset( buffer, 'a' + params->id, sizeof(buffer) );
+    offset.QuadPart = params->id * sizeof(buffer);
+    for (i = 0; i < params->iterations; i++)
+    {
+        HANDLE handle = params->handles[(i * 7 + params->id) % IO_STRESS_HANDLES];
+
+        status = pNtWriteFile( handle, NULL, NULL, NULL, &io, buffer, sizeof(buffer), &offset, NULL );
+        if (status || io.Information != sizeof(buffer)) params->failures++;
+        status = pNtReadFile( handle, NULL, NULL, NULL, &io, buffer, sizeof(buffer), &offset, NULL );
+        if (status || io.Information != sizeof(buffer) || buffer[0] != 'a' + params->id) params->failures++;
+    }
+    return 0;
+}
+
+static void test_read_write_threads(void)
+{
+    struct io_stress_params params[IO_STRESS_THREADS];
+    HANDLE handles[IO_STRESS_HANDLES], threads[IO_STRESS_THREADS];
+    unsigned int i, count = winetest_interactive ? 1000000 : 500;
+    LARGE_INTEGER start, end, freq;
+    double elapsed;
+
+    for (i = 0; i < IO_STRESS_HANDLES; i++)
+    {
+        if (!(handles[i] = create_temp_file( 0 )))
+        {
+            while (i--) CloseHandle( handles[i] );
+            return;
+        }
+    }
+
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < IO_STRESS_THREADS; i++)
+    {
+        params[i].handles = handles;
+        params[i].id = i;
+        params[i].iterations = count;
+        params[i].failures = 0;
+        threads[i] = CreateThread( NULL, 0, io_stress_thread, &params[i], 0, NULL );
+        ok( threads[i] != NULL, "CreateThread failed %u\n", GetLastError() );
+    }
+    for (i = 0; i < IO_STRESS_THREADS; i++)
+    {
+        if (!threads[i]) continue;
+        WaitForSingleObject( threads[i], INFINITE );
+        CloseHandle( threads[i] );
+        ok( !params[i].failures, "thread %u: %u failed requests\n", i, params[i].failures );
+    }
+    QueryPerformanceCounter( &end );
+
+    if (winetest_interactive)
+    {
+        elapsed = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+        trace( "%u threads, %u handles: %u reads+writes in %.3f s (%.0f ops/s)\n",
+               IO_STRESS_THREADS, IO_STRESS_HANDLES, 2 * count * IO_STRESS_THREADS, elapsed,
+               elapsed > 0 ? 2.0 * count * IO_STRESS_THREADS / elapsed : 0.0 );
+    }
+
+    for (i = 0; i < IO_STRESS_HANDLES; i++) CloseHandle( handles[i] );
+}
+
+struct pipe_writer_params
+{
+    HANDLE pipe;
+    char *buffer;
+    ULONG size;
+    unsigned int count;
+};
+
+static DWORD WINAPI pipe_writer_thread( void *arg )
+{
+    struct pipe_writer_params *params = arg;
+    DWORD written;
+    unsigned int i;
+
+    for (i = 0; i < params->count; i++)
+        if (!WriteFile( params->pipe, params->buffer, params->size, &written, NULL )) break;
+    return 0;
+}
+
+static double get_elapsed( LARGE_INTEGER start )
+{
+    LARGE_INTEGER end, freq;
+
+    QueryPerformanceCounter( &end );
+    QueryPerformanceFrequency( &freq );
+    return (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+}
+
+static void test_read_throughput(void)
+{
+    static const ULONG sizes[] = { 64, 1024 * 1024 };
+    struct pipe_writer_params params;
+    IO_STATUS_BLOCK io;
+    LARGE_INTEGER offset, start;
+    HANDLE file, reader, writer, thread;
+    NTSTATUS status = STATUS_SUCCESS;
+    unsigned int i, j, count;
+    char *buffer;
+    double elapsed;
+    ULONG total;
+    DWORD written;
+
+    if (!(buffer = HeapAlloc( GetProcessHeap(), 0, sizes[ARRAY_SIZE(sizes) - 1] ))) return;
+    memset( buffer, 0x55, sizes[ARRAY_SIZE(sizes) - 1] );
+
+    for (i = 0; i < ARRAY_SIZE(sizes); i++)
+    {
+        if (sizes[i] >= 65536) count = winetest_interactive ? 1000 : 10;
+        else count = winetest_interactive ? 10000000 : 1000;
+
+        if ((file = create_temp_file( 0 )))
+        {
+            ok( WriteFile( file, buffer, sizes[i], &written, NULL ), "WriteFile failed %u\n", GetLastError() );
+            offset.QuadPart = 0;
+            QueryPerformanceCounter( &start );
+            for (j = 0; j < count; j++)
+            {
+                status = pNtReadFile( file, NULL, NULL, NULL, &io, buffer, sizes[i], &offset, NULL );
+                if (status || io.Information != sizes[i]) break;
+            }
+            elapsed = get_elapsed( start );
+            ok( j == count, "read %u failed: %#x %lu\n", j, status, io.Information );
+            if (winetest_interactive)
+                trace( "file, %u bytes: %u reads in %.3f s (%.0f reads/s, %.1f MB/s)\n", sizes[i], j, elapsed,
+                       elapsed > 0 ? j / elapsed : 0.0,
+                       elapsed > 0 ? (double)j * sizes[i] / (1024 * 1024) / elapsed : 0.0 );
+            CloseHandle( file );
+        }
+
+        if (!CreatePipe( &reader, &writer, NULL, sizes[i] ))
+        {
+            ok( 0, "CreatePipe failed %u\n", GetLastError() );
+            continue;
+        }
+        params.pipe = writer;
+        params.buffer = buffer;
+        params.size = sizes[i];
+        params.count = count;
+        QueryPerformanceCounter( &start );
+        thread = CreateThread( NULL, 0, pipe_writer_thread, &params, 0, NULL );
+        ok( thread != NULL, "CreateThread failed %u\n", GetLastError() );
+        for (j = 0; thread && j < count; j++)
+        {
+            for (total = 0; total < sizes[i]; total += io.Information)
+            {
+                status = pNtReadFile( reader, NULL, NULL, NULL, &io, buffer, sizes[i] - total, NULL, NULL );
+                if (status) break;
+            }
+            if (status) break;
+        }
+        elapsed = get_elapsed( start );
+        ok( j == count, "pipe read %u failed: %#x\n", j, status );
+        if (winetest_interactive)
+            trace( "pipe, %u bytes: %u reads in %.3f s (%.0f reads/s, %.1f MB/s)\n", sizes[i], j, elapsed,
+                   elapsed > 0 ? j / elapsed : 0.0,
+                   elapsed > 0 ? (double)j * sizes[i] / (1024 * 1024) / elapsed : 0.0 );
+        CloseHandle( writer );
+        if (thread)
+        {
+            WaitForSingleObject( thread, INFINITE );
+            CloseHandle( thread );
+        }
+        CloseHandle( reader );
+    }
+    HeapFree( GetProcessHeap(), 0, buffer );
+}
+
+static void test_overlapped_iops(void)
+{
+    static const unsigned int depths[] = { 1, 4, 16, 64, 256 };
+    static const ULONG block_size = 4096;
+    ULONG file_blocks = winetest_interactive ? 4096 : 256;
+    char path[MAX_PATH], name[MAX_PATH];
+    OVERLAPPED *ovls, *ovl;
+    LARGE_INTEGER start;
+    unsigned int i, j, count, done, submitted, nb_free, seed = 12345;
+    unsigned int free_slots[256];
+    HANDLE file, port;
+    ULONG_PTR key;
+    DWORD size;
+    double elapsed;
+    char *buffers;
+    BOOL ret;
+
+    GetTempPathA( MAX_PATH, path );
+    GetTempFileNameA( path, "foo", 0, name );
+    file = CreateFileA( name, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                        FILE_FLAG_OVERLAPPED | FILE_FLAG_DELETE_ON_CLOSE, 0 );
+    ok( file != INVALID_HANDLE_VALUE, "failed to create temp file\n" );
+    if (file == INVALID_HANDLE_VALUE) return;
+
+    buffers = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, 256 * block_size );
+    ovls = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, 256 * sizeof(*ovls) );
+    ovls[0].hEvent = CreateEventA( NULL, TRUE, FALSE, NULL );
+    for (i = 0; i < file_blocks; i++)
+    {
+        ovls[0].Offset = i * block_size;
+        ret = WriteFile( file, buffers, block_size, NULL, &ovls[0] );
+        if (!ret && GetLastError() == ERROR_IO_PENDING) ret = GetOverlappedResult( file, &ovls[0], &size, TRUE );
+        ok( ret, "WriteFile failed %u\n", GetLastError() );
+    }
+    CloseHandle( ovls[0].hEvent );
+    ovls[0].hEvent = 0;
+
+    port = CreateIoCompletionPort( file, NULL, 0xdead, 0 );
+    ok( port != NULL, "CreateIoCompletionPort failed %u\n", GetLastError() );
+
+    for (i = 0; port && i < ARRAY_SIZE(depths); i++)
+    {
+        count = winetest_interactive ? 1000000 : 1000;
+        done = submitted = 0;
+        for (nb_free = 0; nb_free < depths[i]; nb_free++) free_slots[nb_free] = nb_free;
+        QueryPerformanceCounter( &start );
+        while (done < count)
+        {
+            while (submitted < count && nb_free)
+            {
+                /* only reuse the slots whose completion was dequeued */
+                j = free_slots[--nb_free];
+                submitted++;
+                seed = seed * 1103515245 + 12345;
+                memset( &ovls[j], 0, sizeof(ovls[j]) );
+                ovls[j].Offset = ((seed >> 8) % file_blocks) * block_size;
+                if (!ReadFile( file, buffers + j * block_size, block_size, NULL, &ovls[j] ) &&
+                    GetLastError() != ERROR_IO_PENDING)
+                {
+                    ok( 0, "ReadFile failed %u\n", GetLastError() );
+                    free_slots[nb_free++] = j;
+                    count = --submitted;
+                }
+            }
+            if (done == count) break;
+            ret = GetQueuedCompletionStatus( port, &size, &key, &ovl, 10000 );
+            ok( ret, "GetQueuedCompletionStatus failed %u\n", GetLastError() );
+            if (!ret) break;
+            ok( size == block_size, "got size %u\n", size );
+            ok( ovl >= ovls && ovl < ovls + depths[i], "got unexpected overlapped %p\n", ovl );
+            free_slots[nb_free++] = ovl - ovls;
+            done++;
+        }
+        elapsed = get_elapsed( start );
+        if (winetest_interactive)
+            trace( "queue depth %u: %u reads of %u bytes in %.3f s (%.0f IOPS)\n", depths[i], done,
+                   block_size, elapsed, elapsed > 0 ? done / elapsed : 0.0 );
+        if (done < count) break;
+    }
+
+    /* the reads that were not started yet complete with STATUS_CANCELLED */
+    for (i = 0; port && i < 16; i++)
+    {
+        memset( &ovls[i], 0, sizeof(ovls[i]) );
+        ovls[i].Offset = i * block_size;
+        ret = ReadFile( file, buffers + i * block_size, block_size, NULL, &ovls[i] );
+        ok( ret || GetLastError() == ERROR_IO_PENDING, "ReadFile failed %u\n", GetLastError() );
+    }
+    if (port) CancelIoEx( file, NULL );
+    for (i = 0; port && i < 16; i++)
+    {
+        ovl = NULL;
+        ret = GetQueuedCompletionStatus( port, &size, &key, &ovl, 10000 );
+        ok( ovl != NULL, "GetQueuedCompletionStatus failed %u\n", GetLastError() );
+        if (!ovl) break;
+        if (ret) ok( size == block_size, "got size %u\n", size );
+        else ok( GetLastError() == ERROR_OPERATION_ABORTED, "got error %u\n", GetLastError() );
+    }
+
+    CloseHandle( file );
+    if (port) CloseHandle( port );
+    HeapFree( GetProcessHeap(), 0, ovls );
+    HeapFree( GetProcessHeap(), 0, buffers );
+}
+
+struct completion_poster_params
+{
+    HANDLE port;
+    ULONG_PTR key;
+    unsigned int count;
+};
+
+static DWORD WINAPI completion_poster_thread( void *arg )
+{
+    struct completion_poster_params *params = arg;
+    unsigned int i;
+
+    for (i = 0; i < params->count; i++)
+        if (pNtSetIoCompletion( params->port, params->key, i, STATUS_SUCCESS, 0 )) break;
+    return 0;
+}
+
+static void test_completion_batch_throughput(void)
+{
+    static const ULONG batches[] = { 1, 16, 256 };
+    struct completion_poster_params params[4];
+    FILE_IO_COMPLETION_INFORMATION *info;
+    HANDLE port, threads[ARRAY_SIZE(params)];
+    ULONG_PTR next[ARRAY_SIZE(params)];
+    LARGE_INTEGER timeout, start;
+    unsigned int i, j, done, count, errors;
+    NTSTATUS status;
+    double elapsed;
+    ULONG written;
+
+    if (!pNtRemoveIoCompletionEx)
+    {
+        win_skip( "NtRemoveIoCompletionEx not supported\n" );
+        return;
+    }
+
+    status = pNtCreateIoCompletion( &port, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( !status, "NtCreateIoCompletion failed: %#x\n", status );
+    if (status) return;
+    info = HeapAlloc( GetProcessHeap(), 0, batches[ARRAY_SIZE(batches) - 1] * sizeof(*info) );
+
+    /* a batch larger than a single server reply must still come back in order */
+    for (i = 0; i < 200; i++) pNtSetIoCompletion( port, 1, i, STATUS_SUCCESS, i );
+    timeout.QuadPart = 0;
+    status = pNtRemoveIoCompletionEx( port, info, 256, &written, &timeout, FALSE );
+    ok( !status, "NtRemoveIoCompletionEx failed: %#x\n", status );
+    ok( written == 200, "got %u completions\n", written );
+    for (i = errors = 0; i < written; i++)
+        if (info[i].CompletionValue != i || info[i].IoStatusBlock.Information != i) errors++;
+    ok( !errors, "%u completions out of order\n", errors );
+
+    timeout.QuadPart = -10000000 * 10;
+    for (i = 0; i < ARRAY_SIZE(batches); i++)
+    {
+        count = winetest_interactive ? 1000000 : 1000;
+        QueryPerformanceCounter( &start );
+        for (j = 0; j < ARRAY_SIZE(params); j++)
+        {
+            params[j].port = port;
+            params[j].key = j;
+            params[j].count = count;
+            next[j] = 0;
+            threads[j] = CreateThread( NULL, 0, completion_poster_thread, &params[j], 0, NULL );
+        }
+
+        done = errors = 0;
+        while (done < count * ARRAY_SIZE(params))
+        {
+            status = pNtRemoveIoCompletionEx( port, info, batches[i], &written, &timeout, FALSE );
+            ok( !status, "NtRemoveIoCompletionEx failed: %#x\n", status );
+            if (status) break;
+            for (j = 0; j < written; j++)
+            {
+                /* completions from a given thread are dequeued in the order they were posted */
+                if (info[j].CompletionKey >= ARRAY_SIZE(params) ||
+                    info[j].CompletionValue != next[info[j].CompletionKey]++) errors++;
+            }
+            done += written;
+        }
+        elapsed = get_elapsed( start );
+
+        for (j = 0; j < ARRAY_SIZE(params); j++)
+        {
+            WaitForSingleObject( threads[j], INFINITE );
+            CloseHandle( threads[j] );
+        }
+        ok( !errors, "batch %u: %u completions out of order\n", batches[i], errors );
+        if (winetest_interactive)
+            trace( "batch %u: %u completions in %.3f s (%.0f completions/s)\n", batches[i], done,
+                   elapsed, elapsed > 0 ? done / elapsed : 0.0 );
+        if (status) break;
+    }
+
+    HeapFree( GetProcessHeap(), 0, info );
+    pNtClose( port );
+}
+
 START_TEST(file)
 {
     HMODULE hkernel32 = GetModuleHandleA("kernel32.dll");
@@ -4873,6 +5264,10 @@ START_TEST(file)
     pNtFlushBuffersFile = (void *)GetProcAddress(hntdll, "NtFlushBuffersFile");
 
     test_read_write();
+    test_read_write_threads();
+    test_read_throughput();
+    test_overlapped_iops();
+    test_completion_batch_throughput();
     test_NtCreateFile();
     create_file_test();
     open_file_test();
@@ -2073,6 +2073,345 @@ static void test_mutant(void)
     NtClose( mutant );
 }
 
+struct ping_pong
+{
+    HANDLE ping;
+    HANDLE pong;
+    DWORD  count;
+};
+
+static DWORD WINAPI ping_pong_thread( void *arg )
+{
+    struct ping_pong *pp = arg;
+    DWORD i;
+
+    for (i = 0; i < pp->count; i++)
+    {
+        if (WaitForSingleObject( pp->ping, 10000 )) break;
+        SetEvent( pp->pong );
+    }
+    return i;
+}
+
+static double elapsed_ns( LARGE_INTEGER start, LARGE_INTEGER end, LARGE_INTEGER freq, DWORD count )
+{
+    return (double)(end.QuadPart - start.QuadPart) * 1000000000.0 / freq.QuadPart / count;
+}
+
+/* Latency of uncontended and contended waits on anonymous objects; run with and
+ * without WINE_FAST_SYNC=1 to compare the client and server implementations. */
+static void test_wait_latency(void)
+{
+    DWORD count = winetest_interactive ? 100000 : 1000;
+    LARGE_INTEGER freq, start, end;
+    struct ping_pong pp;
+    HANDLE event, sem, mutex, thread, handles[2];
+    DWORD i, ret;
+
+    QueryPerformanceFrequency( &freq );
+
+    event = CreateEventW( NULL, FALSE, FALSE, NULL );
+    sem = CreateSemaphoreW( NULL, 0, count, NULL );
+    mutex = CreateMutexW( NULL, FALSE, NULL );
+    ok( event && sem && mutex, "failed to create objects\n" );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        SetEvent( event );
+        ret = WaitForSingleObject( event, 0 );
+        if (ret) break;
+    }
+    QueryPerformanceCounter( &end );
+    ok( i == count, "wait %u failed %u\n", i, ret );
+    if (winetest_interactive)
+        trace( "event set+wait: %.0f ns\n", elapsed_ns( start, end, freq, count ) );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        ReleaseSemaphore( sem, 1, NULL );
+        ret = WaitForSingleObject( sem, 0 );
+        if (ret) break;
+    }
+    QueryPerformanceCounter( &end );
+    ok( i == count, "wait %u failed %u\n", i, ret );
+    if (winetest_interactive)
+        trace( "semaphore release+wait: %.0f ns\n", elapsed_ns( start, end, freq, count ) );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        ret = WaitForSingleObject( mutex, 0 );
+        if (ret) break;
+        ReleaseMutex( mutex );
+    }
+    QueryPerformanceCounter( &end );
+    ok( i == count, "wait %u failed %u\n", i, ret );
+    if (winetest_interactive)
+        trace( "mutex wait+release: %.0f ns\n", elapsed_ns( start, end, freq, count ) );
+
+    handles[0] = event;
+    handles[1] = sem;
+    ret = WaitForMultipleObjects( 2, handles, FALSE, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %u\n", ret );
+    ReleaseSemaphore( sem, 1, NULL );
+    ret = WaitForMultipleObjects( 2, handles, TRUE, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %u\n", ret );
+    SetEvent( event );
+    ret = WaitForMultipleObjects( 2, handles, TRUE, 0 );
+    ok( ret == WAIT_OBJECT_0, "got %u\n", ret );
+    ret = WaitForMultipleObjects( 2, handles, FALSE, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %u\n", ret );
+
+    /* contended: two threads passing control back and forth */
+    pp.ping = event;
+    pp.pong = CreateEventW( NULL, FALSE, FALSE, NULL );
+    pp.count = count / 4;
+    thread = CreateThread( NULL, 0, ping_pong_thread, &pp, 0, NULL );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < pp.count; i++)
+    {
+        SetEvent( pp.ping );
+        if ((ret = WaitForSingleObject( pp.pong, 10000 ))) break;
+    }
+    QueryPerformanceCounter( &end );
+    ok( i == pp.count, "wait %u failed %u\n", i, ret );
+    if (winetest_interactive)
+        trace( "event ping-pong round trip: %.0f ns\n", elapsed_ns( start, end, freq, pp.count ) );
+
+    ret = WaitForSingleObject( thread, 10000 );
+    ok( ret == WAIT_OBJECT_0, "got %u\n", ret );
+    CloseHandle( thread );
+    CloseHandle( pp.pong );
+    CloseHandle( mutex );
+    CloseHandle( sem );
+    CloseHandle( event );
+}
+
+static DWORD WINAPI mutex_owner_thread( void *arg )
+{
+    HANDLE *handles = arg;
+
+    WaitForSingleObject( handles[0], INFINITE );
+    SetEvent( handles[1] );
+    Sleep( INFINITE );
+    return 0;
+}
+
+/* behaviors the client side implementation of WINE_FAST_SYNC has to preserve */
+static void test_sync_handles(void)
+{
+    HANDLE event, dup, mutex, thread, handles[2];
+    DWORD ret;
+
+    /* a handle with reduced access must not bypass the access checks */
+    event = CreateEventW( NULL, TRUE, FALSE, NULL );
+    ret = DuplicateHandle( GetCurrentProcess(), event, GetCurrentProcess(), &dup, SYNCHRONIZE, FALSE, 0 );
+    ok( ret, "DuplicateHandle failed %u\n", GetLastError() );
+    SetLastError( 0xdeadbeef );
+    ret = SetEvent( dup );
+    ok( !ret, "SetEvent succeeded\n" );
+    ok( GetLastError() == ERROR_ACCESS_DENIED, "got error %u\n", GetLastError() );
+    ret = WaitForSingleObject( dup, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %u\n", ret );
+    SetEvent( event );
+    ret = WaitForSingleObject( dup, 0 );
+    ok( ret == WAIT_OBJECT_0, "got %u\n", ret );
+    ResetEvent( event );
+    ret = WaitForSingleObject( dup, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %u\n", ret );
+    CloseHandle( dup );
+    CloseHandle( event );
+
+    /* a mutex owned by a terminated thread is abandoned */
+    mutex = CreateMutexW( NULL, FALSE, NULL );
+    handles[0] = mutex;
+    handles[1] = CreateEventW( NULL, FALSE, FALSE, NULL );
+    thread = CreateThread( NULL, 0, mutex_owner_thread, handles, 0, NULL );
+    ret = WaitForSingleObject( handles[1], 10000 );
+    ok( ret == WAIT_OBJECT_0, "got %u\n", ret );
+    TerminateThread( thread, 0 );
+    ret = WaitForSingleObject( thread, 10000 );
+    ok( ret == WAIT_OBJECT_0, "got %u\n", ret );
+    ret = WaitForSingleObject( mutex, 10000 );
+    ok( ret == WAIT_ABANDONED_0, "got %u\n", ret );
+    ReleaseMutex( mutex );
+    CloseHandle( thread );
+    CloseHandle( handles[1] );
+    CloseHandle( mutex );
+}
+
+/* run the synchronization tests again in a child process using WINE_FAST_SYNC */
+static void test_fast_sync(void)
+{
+    STARTUPINFOA si = { sizeof(si) };
+    PROCESS_INFORMATION pi;
+    char cmdline[MAX_PATH + 32];
+    char **argv;
+    BOOL ret;
+
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "\"%s\" om fast_sync", argv[0] );
+    SetEnvironmentVariableA( "WINE_FAST_SYNC", "1" );
+    ret = CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi );
+    SetEnvironmentVariableA( "WINE_FAST_SYNC", NULL );
+    ok( ret, "CreateProcess failed %u\n", GetLastError() );
+    if (!ret) return;
+    winetest_wait_child_process( pi.hProcess );
+    CloseHandle( pi.hProcess );
+    CloseHandle( pi.hThread );
+}
+
+struct request_load
+{
+    HANDLE  start;
+    HANDLE  event;
+    HKEY    key;
+    DWORD   count;
+    DWORD   errors;
+    double *latency;
+};
+
+static DWORD WINAPI request_load_thread( void *arg )
+{
+    struct request_load *load = arg;
+    LARGE_INTEGER freq, start, end;
+    EVENT_BASIC_INFORMATION event_info;
+    OBJECT_BASIC_INFORMATION obj_info;
+    char buffer[256];
+    DWORD i, size;
+    NTSTATUS status;
+    LONG res;
+
+    QueryPerformanceFrequency( &freq );
+    WaitForSingleObject( load->start, INFINITE );
+    for (i = 0; i < load->count; i++)
+    {
+        QueryPerformanceCounter( &start );
+        switch (i % 3)
+        {
+        case 0:
+            status = pNtQueryObject( load->event, ObjectBasicInformation, &obj_info, sizeof(obj_info), NULL );
+            if (status) load->errors++;
+            break;
+        case 1:
+            status = pNtQueryEvent( load->event, EventBasicInformation, &event_info, sizeof(event_info), NULL );
+            if (status) load->errors++;
+            break;
+        case 2:
+            size = sizeof(buffer);
+            res = RegQueryValueExA( load->key, "ProductName", NULL, NULL, (BYTE *)buffer, &size );
+            if (res && res != ERROR_FILE_NOT_FOUND) load->errors++;
+            break;
+        }
+        QueryPerformanceCounter( &end );
+        load->latency[i] = elapsed_ns( start, end, freq, 1 );
+    }
+    return 0;
+}
+
+static int compare_latency( const void *a, const void *b )
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Throughput and tail latency of read-only server requests issued from many threads at once;
+ * run with and without WINESERVER_WORKERS set for the wineserver to compare. */
+static void test_server_request_load(void)
+{
+    static const DWORD nb_threads = 8;
+    DWORD count = winetest_interactive ? 50000 : 200;
+    struct request_load load[8];
+    LARGE_INTEGER freq, start, end;
+    HANDLE threads[8], start_event, event;
+    double *latency;
+    HKEY key;
+    DWORD i, ret;
+    LONG res;
+
+    res = RegOpenKeyExA( HKEY_LOCAL_MACHINE, "Software\\Microsoft\\Windows NT\\CurrentVersion", 0,
+                         KEY_QUERY_VALUE, &key );
+    ok( !res, "RegOpenKeyExA failed %d\n", res );
+    if (res) return;
+
+    /* a named event, so that queries always go to the server */
+    event = CreateEventA( NULL, TRUE, FALSE, "wine_test_server_request_load" );
+    start_event = CreateEventA( NULL, TRUE, FALSE, NULL );
+    ok( event && start_event, "failed to create events\n" );
+    latency = HeapAlloc( GetProcessHeap(), 0, nb_threads * count * sizeof(*latency) );
+
+    for (i = 0; i < nb_threads; i++)
+    {
+        load[i].start   = start_event;
+        load[i].event   = event;
+        load[i].key     = key;
+        load[i].count   = count;
+        load[i].errors  = 0;
+        load[i].latency = latency + i * count;
+        threads[i] = CreateThread( NULL, 0, request_load_thread, &load[i], 0, NULL );
+        ok( threads[i] != NULL, "CreateThread failed %u\n", GetLastError() );
+    }
+
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &start );
+    SetEvent( start_event );
+    ret = WaitForMultipleObjects( nb_threads, threads, TRUE, 60000 );
+    QueryPerformanceCounter( &end );
+    ok( ret == WAIT_OBJECT_0, "got %u\n", ret );
+
+    for (i = 0; i < nb_threads; i++)
+    {
+        ok( !load[i].errors, "thread %u: %u failed requests\n", i, load[i].errors );
+        CloseHandle( threads[i] );
+    }
+
+    if (winetest_interactive)
+    {
+        qsort( latency, nb_threads * count, sizeof(*latency), compare_latency );
+        trace( "%u threads: %.0f requests/s, median %.0f ns, p99 %.0f ns\n", nb_threads,
+               1000000000.0 / elapsed_ns( start, end, freq, nb_threads * count ),
+               latency[nb_threads * count / 2], latency[nb_threads * count * 99 / 100] );
+    }
+
+    HeapFree( GetProcessHeap(), 0, latency );
+    CloseHandle( start_event );
+    CloseHandle( event );
+    RegCloseKey( key );
+}
+
+/* Round trip time of a trivial server request; run with and without
+ * WINE_REQUEST_SHM=1 to compare the shared memory and pipe transports. */
+static void test_request_latency(void)
+{
+    DWORD count = winetest_interactive ? 1000000 : 1000;
+    LARGE_INTEGER freq, start, end;
+    EVENT_BASIC_INFORMATION info;
+    NTSTATUS status;
+    HANDLE event;
+    DWORD i;
+
+    /* a named event, so that queries always go to the server */
+    event = CreateEventA( NULL, TRUE, TRUE, "wine_test_request_latency" );
+    ok( event != NULL, "CreateEvent failed %u\n", GetLastError() );
+
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        status = pNtQueryEvent( event, EventBasicInformation, &info, sizeof(info), NULL );
+        if (status || info.EventState != 1) break;
+    }
+    QueryPerformanceCounter( &end );
+    ok( i == count, "request %u failed %x\n", i, status );
+    if (winetest_interactive)
+        trace( "%u requests: %.0f ns per request\n", count, elapsed_ns( start, end, freq, count ) );
+
+    CloseHandle( event );
+}
+
 static void test_wait_on_address(void)
 {
     DWORD ticks;
@@ -2146,10 +2485,55 @@ static void test_wait_on_address(void)
     ok(address == 0, "got %s\n", wine_dbgstr_longlong(address));
 }
 
+/* Cost of arming and cancelling many concurrent server timeouts; the server
+ * handles these requests inline, so this mostly measures its timeout queue. */
+static void test_timer_load(void)
+{
+    DWORD i, count = winetest_interactive ? 100000 : 500;
+    LARGE_INTEGER freq, start, end, due;
+    HANDLE *timers;
+    unsigned int seed = 1;
+    BOOL ret = TRUE;
+
+    timers = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, count * sizeof(*timers) );
+    for (i = 0; i < count; i++)
+    {
+        if (!(timers[i] = CreateWaitableTimerA( NULL, TRUE, NULL ))) break;
+    }
+    ok( i == count, "CreateWaitableTimer %u failed %u\n", i, GetLastError() );
+    count = i;
+
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &start );
+    for (i = 0; ret && i < count; i++)
+    {
+        /* random relative due times between 100 and 1100 seconds */
+        seed = seed * 1103515245 + 12345;
+        due.QuadPart = -(LONGLONG)(1000000000 + (seed >> 4) % 10000000000u);
+        ret = SetWaitableTimer( timers[i], &due, 0, NULL, NULL, FALSE );
+    }
+    QueryPerformanceCounter( &end );
+    ok( ret, "SetWaitableTimer %u failed %u\n", i, GetLastError() );
+    if (winetest_interactive)
+        trace( "%u timers armed: %.0f ns per timer\n", i, elapsed_ns( start, end, freq, max( i, 1 ) ));
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; ret && i < count; i++) ret = CancelWaitableTimer( timers[i] );
+    QueryPerformanceCounter( &end );
+    ok( ret, "CancelWaitableTimer %u failed %u\n", i, GetLastError() );
+    if (winetest_interactive)
+        trace( "%u timers cancelled: %.0f ns per timer\n", i, elapsed_ns( start, end, freq, max( i, 1 ) ));
+
+    for (i = 0; i < count; i++) CloseHandle( timers[i] );
+    HeapFree( GetProcessHeap(), 0, timers );
+}
+
 START_TEST(om)
 {
     HMODULE hntdll = GetModuleHandleA("ntdll.dll");
     HMODULE hkernel32 = GetModuleHandleA("kernel32.dll");
+    char **argv;
+    int argc;
 
     if (!hntdll)
     {
@@ -2206,6 +2590,16 @@ START_TEST(om)
     pRtlWakeAddressAll      =  (void *)GetProcAddress(hntdll, "RtlWakeAddressAll");
     pRtlWakeAddressSingle   =  (void *)GetProcAddress(hntdll, "RtlWakeAddressSingle");
 
+    argc = winetest_get_mainargs( &argv );
+    if (argc >= 3 && !strcmp( argv[2], "fast_sync" ))
+    {
+        test_event();
+        test_mutant();
+        test_sync_handles();
+        test_wait_latency();
+        return;
+    }
+
     test_case_sensitive();
     test_namespace_pipe();
     test_name_collisions();
@@ -2219,4 +2613,10 @@ START_TEST(om)
     test_keyed_events();
     test_null_device();
     test_wait_on_address();
+    test_sync_handles();
+    test_wait_latency();
+    test_fast_sync();
+    test_server_request_load();
+    test_request_latency();
+    test_timer_load();
 }
@@ -24,6 +24,7 @@
 
 #include "ntdll_test.h"
 #include "winternl.h"
+#include "wine/server.h"
 #include "stdio.h"
 #include "winnt.h"
 #include "winnls.h"
@@ -131,6 +132,7 @@ static NTSTATUS (WINAPI * pNtCreateKey)( PHANDLE retkey, ACCESS_MASK access, con
                              ULONG TitleIndex, const UNICODE_STRING *class, ULONG options,
                              PULONG dispos );
 static NTSTATUS (WINAPI * pNtQueryKey)(HANDLE,KEY_INFORMATION_CLASS,PVOID,ULONG,PULONG);
+static NTSTATUS (WINAPI * pNtEnumerateKey)(HANDLE,ULONG,KEY_INFORMATION_CLASS,PVOID,ULONG,PULONG);
 static NTSTATUS (WINAPI * pNtQueryLicenseValue)(const UNICODE_STRING *,ULONG *,PVOID,ULONG,ULONG *);
 static NTSTATUS (WINAPI * pNtQueryValueKey)(HANDLE,const UNICODE_STRING *,KEY_VALUE_INFORMATION_CLASS,void *,DWORD,DWORD *);
 static NTSTATUS (WINAPI * pNtSetValueKey)(HANDLE, const PUNICODE_STRING, ULONG,
@@ -184,6 +186,7 @@ static BOOL InitFunctionPtrs(void)
     NTDLL_GET_PROC(NtFlushKey)
     NTDLL_GET_PROC(NtDeleteKey)
     NTDLL_GET_PROC(NtQueryKey)
+    NTDLL_GET_PROC(NtEnumerateKey)
     NTDLL_GET_PROC(NtQueryValueKey)
     NTDLL_GET_PROC(NtQueryInformationProcess)
     NTDLL_GET_PROC(NtSetValueKey)
@@ -1030,6 +1033,190 @@ static void test_NtQueryLicenseKey(void)
     pRtlFreeUnicodeString(&name);
 }
 
+/* NtQueryLicenseValue opens a key, reads a value and closes the key again,
+ * which is a typical sequence of dependent server requests. */
+static void test_NtQueryLicenseValue_throughput(void)
+{
+    DWORD count = winetest_interactive ? 100000 : 500;
+    LARGE_INTEGER freq, start, end;
+    UNICODE_STRING name;
+    WORD buffer[32];
+    NTSTATUS status;
+    ULONG type, len;
+    DWORD i;
+
+    if (!pNtQueryLicenseValue)
+    {
+        win_skip("NtQueryLicenseValue not found, skipping tests\n");
+        return;
+    }
+
+    pRtlCreateUnicodeStringFromAsciiz(&name, "Nonexistent-License-Value");
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < count; i++)
+    {
+        status = pNtQueryLicenseValue(&name, &type, buffer, sizeof(buffer), &len);
+        if (status != STATUS_OBJECT_NAME_NOT_FOUND) break;
+    }
+    QueryPerformanceCounter(&end);
+    ok(i == count, "NtQueryLicenseValue returned %08x\n", status);
+    if (winetest_interactive)
+        trace("NtQueryLicenseValue: %.0f calls/s\n",
+              (double)count * freq.QuadPart / (end.QuadPart - start.QuadPart));
+    pRtlFreeUnicodeString(&name);
+}
+
+/* send a batch made of a single close_handle request with the specified entry size */
+static unsigned int call_batch( unsigned int (*pwine_server_call)(void *), data_size_t size, unsigned int *done )
+{
+    struct
+    {
+        struct batch_header header;
+        union generic_request req;
+    } entry;
+    struct __server_request_info info;
+    char replies[1024];
+    unsigned int status;
+
+    memset( &entry, 0, sizeof(entry) );
+    entry.header.size = size;
+    entry.req.close_handle_request.__header.req = REQ_close_handle;
+    entry.req.close_handle_request.handle = 0xdead0000;
+
+    memset( &info, 0, sizeof(info) );
+    info.u.req.request_header.req = REQ_batch;
+    info.u.req.request_header.request_size = sizeof(entry);
+    info.u.req.request_header.reply_size = sizeof(replies);
+    info.data_count = 1;
+    info.data[0].ptr = &entry;
+    info.data[0].size = sizeof(entry);
+    info.reply_data = replies;
+    status = pwine_server_call( &info );
+    *done = info.u.reply.batch_reply.done;
+    return status;
+}
+
+static void test_server_batch(void)
+{
+    unsigned int (*pwine_server_call)(void *);
+    unsigned int status, done;
+
+    if (!(pwine_server_call = (void *)GetProcAddress( hntdll, "wine_server_call" )))
+    {
+        win_skip( "Not running on Wine, skipping server batch tests\n" );
+        return;
+    }
+
+    /* the close_handle request fails, which stops the batch without failing it */
+    status = call_batch( pwine_server_call, sizeof(struct batch_header) + sizeof(union generic_request), &done );
+    ok( !status, "got %#x\n", status );
+    ok( done == 1, "got %u requests done\n", done );
+
+    /* entries too small to hold their request are rejected */
+    status = call_batch( pwine_server_call, sizeof(struct batch_header), &done );
+    ok( status == STATUS_INVALID_PARAMETER, "got %#x\n", status );
+    ok( !done, "got %u requests done\n", done );
+
+    status = call_batch( pwine_server_call, 0, &done );
+    ok( status == STATUS_INVALID_PARAMETER, "got %#x\n", status );
+    ok( !done, "got %u requests done\n", done );
+}
+
+static double elapsed_ms( LARGE_INTEGER start, LARGE_INTEGER end, LARGE_INTEGER freq )
+{
+    return (double)(end.QuadPart - start.QuadPart) * 1000 / freq.QuadPart;
+}
+
+/* scatter the names so that keys are not created in sorted order */
+static const char *key_name( DWORD i )
+{
+    static char name[16];
+    sprintf( name, "key%08x", i * 2654435761u );
+    return name;
+}
+
+/* create, enumerate and delete a large number of keys under a single parent */
+static void test_key_stress(void)
+{
+    static const WCHAR stressW[] = {'s','t','r','e','s','s',0};
+    DWORD count = winetest_interactive ? 500000 : 1000;
+    LARGE_INTEGER freq, start, create_end, enum_end, delete_end;
+    char buffer[sizeof(KEY_BASIC_INFORMATION) + 64];
+    KEY_BASIC_INFORMATION *info = (KEY_BASIC_INFORMATION *)buffer;
+    WCHAR nameW[16], prevW[16];
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING str;
+    HANDLE root, parent, key;
+    NTSTATUS status;
+    DWORD i, len;
+
+    InitializeObjectAttributes( &attr, &winetestpath, 0, 0, 0 );
+    status = pNtCreateKey( &root, KEY_ALL_ACCESS, &attr, 0, 0, 0, 0 );
+    ok( !status, "NtCreateKey failed: 0x%08x\n", status );
+
+    attr.RootDirectory = root;
+    attr.ObjectName = &str;
+    pRtlInitUnicodeString( &str, stressW );
+    status = pNtCreateKey( &parent, KEY_ALL_ACCESS, &attr, 0, 0, REG_OPTION_VOLATILE, 0 );
+    ok( !status, "NtCreateKey failed: 0x%08x\n", status );
+    attr.RootDirectory = parent;
+
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &start );
+
+    for (i = 0; i < count; i++)
+    {
+        MultiByteToWideChar( CP_ACP, 0, key_name( i ), -1, nameW, ARRAY_SIZE(nameW) );
+        pRtlInitUnicodeString( &str, nameW );
+        status = pNtCreateKey( &key, KEY_ALL_ACCESS, &attr, 0, 0, REG_OPTION_VOLATILE, 0 );
+        if (status) break;
+        pNtClose( key );
+    }
+    ok( i == count, "NtCreateKey %u failed: 0x%08x\n", i, status );
+    QueryPerformanceCounter( &create_end );
+
+    prevW[0] = 0;
+    for (i = 0; i < count; i++)
+    {
+        status = pNtEnumerateKey( parent, i, KeyBasicInformation, buffer, sizeof(buffer), &len );
+        if (status) break;
+        memcpy( nameW, info->Name, info->NameLength );
+        nameW[info->NameLength / sizeof(WCHAR)] = 0;
+        if (lstrcmpiW( prevW, nameW ) >= 0) break;
+        lstrcpyW( prevW, nameW );
+    }
+    ok( i == count, "NtEnumerateKey %u failed: 0x%08x %s\n", i, status, wine_dbgstr_w(nameW) );
+    status = pNtEnumerateKey( parent, count, KeyBasicInformation, buffer, sizeof(buffer), &len );
+    ok( status == STATUS_NO_MORE_ENTRIES, "got 0x%08x\n", status );
+    QueryPerformanceCounter( &enum_end );
+
+    for (i = 0; i < count; i++)
+    {
+        MultiByteToWideChar( CP_ACP, 0, key_name( i ), -1, nameW, ARRAY_SIZE(nameW) );
+        pRtlInitUnicodeString( &str, nameW );
+        status = pNtOpenKey( &key, KEY_ALL_ACCESS, &attr );
+        if (status) break;
+        status = pNtDeleteKey( key );
+        pNtClose( key );
+        if (status) break;
+    }
+    ok( i == count, "deleting key %u failed: 0x%08x\n", i, status );
+    QueryPerformanceCounter( &delete_end );
+
+    status = pNtEnumerateKey( parent, 0, KeyBasicInformation, buffer, sizeof(buffer), &len );
+    ok( status == STATUS_NO_MORE_ENTRIES, "got 0x%08x\n", status );
+
+    if (winetest_interactive)
+        trace( "%u keys: create %.0f ms, enumerate %.0f ms, delete %.0f ms\n", count,
+               elapsed_ms( start, create_end, freq ), elapsed_ms( create_end, enum_end, freq ),
+               elapsed_ms( enum_end, delete_end, freq ));
+
+    pNtDeleteKey( parent );
+    pNtClose( parent );
+    pNtClose( root );
+}
+
 static void test_RtlpNtQueryValueKey(void)
 {
     NTSTATUS status;
@@ -2034,6 +2221,9 @@ START_TEST(reg)
     test_NtFlushKey();
     test_NtQueryKey();
     test_NtQueryLicenseKey();
+    test_NtQueryLicenseValue_throughput();
+    test_server_batch();
+    test_key_stress();
     test_NtQueryValueKey();
     test_long_value_name();
     test_notify();
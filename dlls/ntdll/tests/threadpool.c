@@ -1906,6 +1906,82 @@ static void test_tp_multi_wait(void)
     CloseHandle(semaphore);
 }
 
+struct fork_join_info
+{
+    TP_WORK *work;
+    HANDLE   done_event;
+    LONG     total;
+    LONG     forked;
+    LONG     done;
+};
+
+static void CALLBACK fork_join_cb(TP_CALLBACK_INSTANCE *instance, void *userdata, TP_WORK *work)
+{
+    struct fork_join_info *info = userdata;
+    int i;
+
+    /* fork two children until the task budget is exhausted */
+    for (i = 0; i < 2; i++)
+    {
+        if (InterlockedIncrement(&info->forked) > info->total) break;
+        pTpPostWork(work);
+    }
+
+    if (InterlockedIncrement(&info->done) == info->total)
+        SetEvent(info->done_event);
+}
+
+static void test_tp_work_performance(void)
+{
+    TP_CALLBACK_ENVIRON environment;
+    struct fork_join_info info;
+    LARGE_INTEGER freq, start, end;
+    unsigned int threads;
+    NTSTATUS status;
+    TP_POOL *pool;
+    DWORD result;
+
+    QueryPerformanceFrequency(&freq);
+    info.done_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    ok(info.done_event != NULL, "CreateEvent failed %u\n", GetLastError());
+
+    for (threads = 1; threads <= 64; threads *= 2)
+    {
+        pool = NULL;
+        status = pTpAllocPool(&pool, NULL);
+        ok(!status, "TpAllocPool failed with status %x\n", status);
+        pTpSetPoolMaxThreads(pool, threads);
+
+        memset(&environment, 0, sizeof(environment));
+        environment.Version = 1;
+        environment.Pool = pool;
+        info.work = NULL;
+        status = pTpAllocWork(&info.work, fork_join_cb, &info, &environment);
+        ok(!status, "TpAllocWork failed with status %x\n", status);
+
+        info.total = winetest_interactive ? 1000000 : 1000;
+        info.forked = 1;
+        info.done = 0;
+
+        QueryPerformanceCounter(&start);
+        pTpPostWork(info.work);
+        result = WaitForSingleObject(info.done_event, 60000);
+        QueryPerformanceCounter(&end);
+        ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+        pTpWaitForWork(info.work, FALSE);
+        ok(info.done == info.total, "expected %u tasks, got %u\n", info.total, info.done);
+
+        if (winetest_interactive)
+            trace("%2u threads: %.0f tasks/s\n", threads,
+                  info.total * (double)freq.QuadPart / (end.QuadPart - start.QuadPart));
+
+        pTpReleaseWork(info.work);
+        pTpReleasePool(pool);
+    }
+
+    CloseHandle(info.done_event);
+}
+
 START_TEST(threadpool)
 {
     test_RtlQueueWorkItem();
@@ -1925,4 +2001,5 @@ START_TEST(threadpool)
     test_tp_window_length();
     test_tp_wait();
     test_tp_multi_wait();
+    test_tp_work_performance();
 }
@@ -230,6 +230,8 @@ void thread_init(void)
     thread_data->reply_fd   = -1;
     thread_data->wait_fd[0] = -1;
     thread_data->wait_fd[1] = -1;
+    thread_data->doorbell_fd = -1;
+    thread_data->request_shm = NULL;
 
     signal_init_thread( teb );
     virtual_init_threading();
@@ -292,6 +294,8 @@ void abort_thread( int status )
 {
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
     if (interlocked_xchg_add( &nb_threads, -1 ) <= 1) _exit( get_unix_exit_code( status ));
+    fast_sync_thread_exit();  /* the thread may have been terminated while owning fast mutexes */
+    server_exit_thread_shm();
     signal_exit_thread( status );
 }
 
@@ -305,6 +309,7 @@ void exit_thread( int status )
     close( ntdll_get_thread_data()->wait_fd[1] );
     close( ntdll_get_thread_data()->reply_fd );
     close( ntdll_get_thread_data()->request_fd );
+    server_exit_thread_shm();
     pthread_exit( UIntToPtr(status) );
 }
 
@@ -337,6 +342,7 @@ void WINAPI RtlExitUserThread( ULONG status )
 
     LdrShutdownThread();
     RtlFreeThreadActivationContextStack();
+    fast_sync_thread_exit();
 
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
 
@@ -515,6 +521,8 @@ NTSTATUS WINAPI RtlCreateUserThread( HANDLE process, SECURITY_DESCRIPTOR *descr,
     thread_data->reply_fd    = -1;
     thread_data->wait_fd[0]  = -1;
     thread_data->wait_fd[1]  = -1;
+    thread_data->doorbell_fd = -1;
+    thread_data->request_shm = NULL;
     thread_data->start_stack = (char *)teb->Tib.StackBase;
 
     pthread_attr_init( &attr );
@@ -114,6 +114,7 @@ struct timer_queue
  */
 
 #define THREADPOOL_WORKER_TIMEOUT 5000
+#define THREADPOOL_STALL_TIMEOUT 50
 #define MAXIMUM_WAITQUEUE_OBJECTS (MAXIMUM_WAIT_OBJECTS - 1)
 
 /* internal threadpool representation */
@@ -131,6 +132,14 @@ struct threadpool
     int                     min_workers;
     int                     num_workers;
     int                     num_busy_workers;
+    /* thread injection, locked via .cs. Workers beyond max_running_workers are only
+     * started when no callback started or completed for THREADPOOL_STALL_TIMEOUT ms,
+     * which usually means that the busy workers are blocked. */
+    int                     max_running_workers;
+    DWORD                   last_progress;
+    BOOL                    monitor_running;
+    BOOL                    monitor_idle;
+    RTL_CONDITION_VARIABLE  monitor_event;
 };
 
 enum threadpool_objtype
@@ -327,6 +336,7 @@ static inline struct threadpool_instance *impl_from_TP_CALLBACK_INSTANCE( TP_CAL
 }
 
 static void CALLBACK threadpool_worker_proc( void *param );
+static void CALLBACK threadpool_monitor_proc( void *param );
 static void tp_object_submit( struct threadpool_object *object, BOOL signaled );
 static void tp_object_prepare_shutdown( struct threadpool_object *object );
 static BOOL tp_object_release( struct threadpool_object *object );
@@ -1313,11 +1323,50 @@ static NTSTATUS tp_new_worker_thread( struct threadpool *pool )
         interlocked_inc( &pool->refcount );
         pool->num_workers++;
         pool->num_busy_workers++;
+        pool->last_progress = NtGetTickCount();
         NtClose( thread );
     }
     return status;
 }
 
+/***********************************************************************
+ *           tp_need_new_worker    (internal)
+ *
+ * Checks if a new worker thread should be started to process queued
+ * work. Must be called with the pool lock held.
+ */
+static BOOL tp_need_new_worker( struct threadpool *pool, BOOL may_block )
+{
+    if (pool->num_busy_workers < pool->num_workers) return FALSE;
+    if (pool->num_workers >= pool->max_workers) return FALSE;
+    if (may_block || pool->num_workers < max( pool->max_running_workers, pool->min_workers )) return TRUE;
+    return NtGetTickCount() - pool->last_progress >= THREADPOOL_STALL_TIMEOUT;
+}
+
+/***********************************************************************
+ *           tp_start_monitor    (internal)
+ *
+ * Makes sure that the monitor thread of a pool is watching for blocked
+ * workers. Must be called with the pool lock held.
+ */
+static void tp_start_monitor( struct threadpool *pool )
+{
+    HANDLE thread;
+
+    if (pool->monitor_running)
+    {
+        if (pool->monitor_idle) RtlWakeConditionVariable( &pool->monitor_event );
+        return;
+    }
+    if (!RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, NULL, 0, 0,
+                              threadpool_monitor_proc, pool, &thread, NULL ))
+    {
+        interlocked_inc( &pool->refcount );
+        pool->monitor_running = TRUE;
+        NtClose( thread );
+    }
+}
+
 /***********************************************************************
  *           tp_timerqueue_lock    (internal)
  *
@@ -1670,6 +1719,11 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
     pool->min_workers           = 0;
     pool->num_workers           = 0;
     pool->num_busy_workers      = 0;
+    pool->max_running_workers   = NtCurrentTeb()->Peb->NumberOfProcessors;
+    pool->last_progress         = NtGetTickCount();
+    pool->monitor_running       = FALSE;
+    pool->monitor_idle          = FALSE;
+    RtlInitializeConditionVariable( &pool->monitor_event );
 
     TRACE( "allocated threadpool %p\n", pool );
 
@@ -1690,6 +1744,7 @@ static void tp_threadpool_shutdown( struct threadpool *pool )
 
     pool->shutdown = TRUE;
     RtlWakeAllConditionVariable( &pool->update_event );
+    RtlWakeAllConditionVariable( &pool->monitor_event );
 }
 
 /***********************************************************************
@@ -1970,8 +2025,7 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
     RtlEnterCriticalSection( &pool->cs );
 
     /* Start new worker threads if required. */
-    if (pool->num_busy_workers >= pool->num_workers &&
-        pool->num_workers < pool->max_workers)
+    if (tp_need_new_worker( pool, object->may_run_long ))
         status = tp_new_worker_thread( pool );
 
     /* Queue work item and increment refcount. */
@@ -1983,11 +2037,14 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
     if (object->type == TP_OBJECT_TYPE_WAIT && signaled)
         object->u.wait.signaled++;
 
-    /* No new thread started - wake up one existing thread. */
+    /* No new thread started - wake up one existing thread. If all of
+     * them are busy, let the monitor check whether they are blocked. */
     if (status != STATUS_SUCCESS)
     {
         assert( pool->num_workers > 0 );
         RtlWakeConditionVariable( &pool->update_event );
+        if (pool->num_busy_workers >= pool->num_workers && pool->num_workers < pool->max_workers)
+            tp_start_monitor( pool );
     }
 
     RtlLeaveCriticalSection( &pool->cs );
@@ -2153,6 +2210,7 @@ static void CALLBACK threadpool_worker_proc( void *param )
             object->num_associated_callbacks++;
             object->num_running_callbacks++;
             pool->num_busy_workers++;
+            pool->last_progress = NtGetTickCount();
             RtlLeaveCriticalSection( &pool->cs );
 
             /* Initialize threadpool instance struct. */
@@ -2248,6 +2306,7 @@ static void CALLBACK threadpool_worker_proc( void *param )
         skip_cleanup:
             RtlEnterCriticalSection( &pool->cs );
             pool->num_busy_workers--;
+            pool->last_progress = NtGetTickCount();
 
             /* Simple callbacks are automatically shutdown after execution. */
             if (object->type == TP_OBJECT_TYPE_SIMPLE)
@@ -2295,6 +2354,49 @@ static void CALLBACK threadpool_worker_proc( void *param )
     RtlExitUserThread( 0 );
 }
 
+/***********************************************************************
+ *           threadpool_monitor_proc    (internal)
+ *
+ * Starts additional workers when work is queued but the busy workers
+ * don't make any progress, at most one every THREADPOOL_STALL_TIMEOUT ms.
+ */
+static void CALLBACK threadpool_monitor_proc( void *param )
+{
+    struct threadpool *pool = param;
+    LARGE_INTEGER timeout;
+    NTSTATUS status;
+
+    TRACE( "starting monitor thread for pool %p\n", pool );
+
+    RtlEnterCriticalSection( &pool->cs );
+    while (!pool->shutdown)
+    {
+        if (threadpool_get_next_item( pool ) && pool->num_busy_workers >= pool->num_workers)
+        {
+            if (tp_need_new_worker( pool, FALSE ) && !tp_new_worker_thread( pool ))
+                TRACE( "pool %p seems blocked, started worker %d\n", pool, pool->num_workers );
+
+            timeout.QuadPart = (ULONGLONG)THREADPOOL_STALL_TIMEOUT * -10000;
+            RtlSleepConditionVariableCS( &pool->monitor_event, &pool->cs, &timeout );
+            continue;
+        }
+
+        /* Nothing to watch, wait until a submission finds all workers busy. */
+        pool->monitor_idle = TRUE;
+        timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
+        status = RtlSleepConditionVariableCS( &pool->monitor_event, &pool->cs, &timeout );
+        pool->monitor_idle = FALSE;
+        if (status == STATUS_TIMEOUT && !threadpool_get_next_item( pool ))
+            break;
+    }
+    pool->monitor_running = FALSE;
+    RtlLeaveCriticalSection( &pool->cs );
+
+    TRACE( "terminating monitor thread for pool %p\n", pool );
+    tp_threadpool_release( pool );
+    RtlExitUserThread( 0 );
+}
+
 /***********************************************************************
  *           TpAllocCleanupGroup    (NTDLL.@)
  */
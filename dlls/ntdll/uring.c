@@ -0,0 +1,590 @@
+/*
+ * Asynchronous file I/O through io_uring
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * Overlapped reads and writes on regular files are otherwise done synchronously
+ * with pread/pwrite, followed by a server call to post the completion. With
+ * WINE_IO_URING=1 they are instead submitted to an io_uring instance; a
+ * dedicated thread reaps the completions, updates the I/O status blocks and
+ * events, and posts the completion packets to the server in batches.
+ *
+ * Only operations that don't need an APC and whose completion can be observed
+ * (through an event or a completion port) are submitted this way, since a file
+ * handle doesn't get reset and signaled around the I/O like with server asyncs.
+ *
+ * The file and event handles are duplicated when the I/O is submitted, so that
+ * the completion still reaches the right objects if the application closes its
+ * handles before the I/O finishes; the duplicates are closed in the completion
+ * batch.
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
+#ifdef HAVE_SYS_UIO_H
+# include <sys/uio.h>
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_LINUX_IO_URING_H
+# include <linux/io_uring.h>
+#endif
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winternl.h"
+#include "wine/server.h"
+#include "wine/list.h"
+#include "wine/debug.h"
+#include "ntdll_misc.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(ntdll);
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+
+#define URING_ENTRIES 256
+
+/* IORING_OP_ASYNC_CANCEL, missing from older headers */
+#define URING_OP_ASYNC_CANCEL 14
+
+/* each completion needs up to three requests: completion packet and two handle closes */
+#define URING_BATCH_IO (SERVER_BATCH_MAX / 3)
+
+struct uring_io
+{
+    struct list      entry;    /* entry in the list of in-flight operations */
+    HANDLE           handle;   /* file handle used by the caller, for cancellation */
+    HANDLE           file;     /* our duplicate of the file handle */
+    HANDLE           event;    /* our duplicate of the event to signal on completion */
+    DWORD            tid;      /* thread that submitted the operation */
+    IO_STATUS_BLOCK *iosb;     /* status block to fill on completion */
+    ULONG_PTR        cvalue;   /* completion value */
+    BOOL             write;    /* write or read operation */
+    ULONGLONG        offset;   /* file offset */
+    struct iovec     iov;      /* buffer */
+};
+
+static struct
+{
+    int                  fd;        /* io_uring fd, -1 when not available */
+    unsigned int         entries;   /* number of submission entries */
+    unsigned int         cq_entries;/* number of completion entries */
+    unsigned int         inflight;  /* submitted operations not completed yet */
+    unsigned int        *sq_head;
+    unsigned int        *sq_tail;
+    unsigned int        *sq_mask;
+    unsigned int        *sq_array;
+    struct io_uring_sqe *sqes;
+    unsigned int        *cq_head;
+    unsigned int        *cq_tail;
+    unsigned int        *cq_mask;
+    struct io_uring_cqe *cqes;
+} ring = { -1 };
+
+static struct list inflight_ios = LIST_INIT( inflight_ios );
+
+/* handles associated with a completion port; one bit per handle index */
+#define PORT_BITS_BLOCK   65536
+#define PORT_BITS_ENTRIES 16
+
+static LONG *port_bits[PORT_BITS_ENTRIES];
+
+static RTL_RUN_ONCE init_once = RTL_RUN_ONCE_INIT;
+
+static RTL_CRITICAL_SECTION uring_section;
+static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
+{
+    0, 0, &uring_section,
+    { &critsect_debug.ProcessLocksList, &critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": uring_section") }
+};
+static RTL_CRITICAL_SECTION uring_section = { &critsect_debug, -1, 0, 0, 0, 0 };
+
+/* the ring indices are shared with the kernel */
+static inline unsigned int load_acquire( const unsigned int *ptr )
+{
+    unsigned int ret = *(const volatile unsigned int *)ptr;
+    __sync_synchronize();
+    return ret;
+}
+
+static inline void store_release( unsigned int *ptr, unsigned int value )
+{
+    __sync_synchronize();
+    *(volatile unsigned int *)ptr = value;
+}
+
+static inline LONG *get_port_bits( HANDLE handle, BOOL alloc, LONG *mask )
+{
+    unsigned int idx = (wine_server_obj_handle( handle ) >> 2) - 1;
+    unsigned int entry = idx / (PORT_BITS_BLOCK * 32);
+    LONG *block;
+
+    if (entry >= PORT_BITS_ENTRIES) return NULL;
+    if (!(block = port_bits[entry]) && alloc)
+    {
+        block = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, PORT_BITS_BLOCK * sizeof(LONG) );
+        if (!block) return NULL;
+        if (interlocked_cmpxchg_ptr( (void **)&port_bits[entry], block, NULL ))
+        {
+            RtlFreeHeap( GetProcessHeap(), 0, block );
+            block = port_bits[entry];
+        }
+    }
+    if (!block) return NULL;
+    idx %= PORT_BITS_BLOCK * 32;
+    *mask = (LONG)(1u << (idx % 32));
+    return block + idx / 32;
+}
+
+static void update_port_bit( HANDLE handle, BOOL set )
+{
+    LONG *bits, mask, old;
+
+    if (!(bits = get_port_bits( handle, set, &mask ))) return;
+    do
+    {
+        old = *bits;
+        if (!!(old & mask) == set) return;
+    } while (interlocked_cmpxchg( bits, set ? old | mask : old & ~mask, old ) != old);
+}
+
+static BOOL has_completion_port( HANDLE handle )
+{
+    LONG *bits, mask;
+
+    return (bits = get_port_bits( handle, FALSE, &mask )) && (*bits & mask);
+}
+
+/* close our duplicates of the handles of an operation */
+static void close_io_handles( struct uring_io *io, struct server_batch *batch )
+{
+    struct close_handle_request *req;
+    int fd = server_remove_fd_from_cache( io->file );
+
+    if (fd != -1) close( fd );
+    req = SERVER_BATCH_REQ( batch, close_handle, BATCH_IGNORE_ERROR );
+    req->handle = wine_server_obj_handle( io->file );
+    if (!io->event) return;
+    fast_sync_close_handle( io->event );
+    req = SERVER_BATCH_REQ( batch, close_handle, BATCH_IGNORE_ERROR );
+    req->handle = wine_server_obj_handle( io->event );
+}
+
+/* duplicate the handles of an operation in a single server call */
+static NTSTATUS dup_io_handles( struct uring_io *io, HANDLE handle, HANDLE event )
+{
+    struct dup_handle_request *req;
+    struct server_batch batch;
+    unsigned int i;
+    NTSTATUS status;
+
+    batch.count = 0;
+    for (i = 0; i < (event ? 2 : 1); i++)
+    {
+        req = SERVER_BATCH_REQ( &batch, dup_handle, 0 );
+        req->src_process = wine_server_obj_handle( NtCurrentProcess() );
+        req->src_handle  = wine_server_obj_handle( i ? event : handle );
+        req->dst_process = wine_server_obj_handle( NtCurrentProcess() );
+        req->options     = DUP_HANDLE_SAME_ACCESS;
+    }
+    if ((status = server_batch_call( &batch )))
+    {
+        /* only the event failed, undo the file duplication */
+        if (event && !batch.reqs[0].u.reply.reply_header.error)
+            NtClose( wine_server_ptr_handle( SERVER_BATCH_REPLY( &batch, 0, dup_handle )->handle ));
+        return status;
+    }
+
+    io->file  = wine_server_ptr_handle( SERVER_BATCH_REPLY( &batch, 0, dup_handle )->handle );
+    io->event = 0;
+    if (event)
+    {
+        io->event = wine_server_ptr_handle( SERVER_BATCH_REPLY( &batch, 1, dup_handle )->handle );
+        fast_sync_dup_handle( event, io->event, 0, DUPLICATE_SAME_ACCESS, FALSE );
+    }
+    return STATUS_SUCCESS;
+}
+
+/* redo a read that failed because the buffer has a write watch */
+static int retry_read( struct uring_io *io )
+{
+    int fd, needs_close, ret;
+
+    if (server_get_unix_fd( io->file, FILE_READ_DATA, &fd, &needs_close, NULL, NULL )) return -EFAULT;
+    ret = virtual_locked_pread( fd, io->iov.iov_base, io->iov.iov_len, io->offset );
+    if (ret < 0) ret = -errno;
+    if (needs_close) close( fd );
+    return ret;
+}
+
+static void complete_io( struct uring_io *io, int res, struct server_batch *batch )
+{
+    struct add_fd_completion_request *req;
+    NTSTATUS status;
+    ULONG info = 0;
+
+    if (res == -EFAULT && !io->write) res = retry_read( io );
+
+    if (res >= 0)
+    {
+        info = res;
+        status = (res || io->write || !io->iov.iov_len) ? STATUS_SUCCESS : STATUS_END_OF_FILE;
+    }
+    else if (res == -EFAULT) status = io->write ? STATUS_INVALID_USER_BUFFER : STATUS_ACCESS_VIOLATION;
+    else if (res == -ECANCELED) status = STATUS_CANCELLED;
+    else
+    {
+        errno = -res;
+        status = FILE_GetNtStatus();
+    }
+
+    TRACE( "%s %p offset %s = %#x (%u)\n", io->write ? "write" : "read", io->handle,
+           wine_dbgstr_longlong( io->offset ), status, info );
+
+    io->iosb->Information = info;
+    __sync_synchronize();
+    io->iosb->Status = status;
+    if (io->event) NtSetEvent( io->event, NULL );
+
+    if (io->cvalue)
+    {
+        req = SERVER_BATCH_REQ( batch, add_fd_completion, BATCH_IGNORE_ERROR );
+        req->handle      = wine_server_obj_handle( io->file );
+        req->cvalue      = io->cvalue;
+        req->status      = status;
+        req->information = info;
+        req->async       = 1;
+    }
+    close_io_handles( io, batch );
+}
+
+/* reap the available completions and post them to the server, URING_BATCH_IO at a time */
+static void reap_completions(void)
+{
+    struct uring_io *done[URING_BATCH_IO];
+    struct server_batch batch;
+    unsigned int i, j, count, head, tail;
+
+    head = *ring.cq_head;
+    tail = load_acquire( ring.cq_tail );
+    while (head != tail)
+    {
+        batch.count = 0;
+        for (i = count = 0; i < URING_BATCH_IO && head != tail; head++, count++)
+        {
+            const struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+            struct uring_io *io = (struct uring_io *)(ULONG_PTR)cqe->user_data;
+
+            if (!io) continue;  /* cancellation request */
+            complete_io( io, cqe->res, &batch );
+            done[i++] = io;
+        }
+        store_release( ring.cq_head, head );
+        interlocked_xchg_add( (LONG *)&ring.inflight, -(LONG)count );
+
+        RtlEnterCriticalSection( &uring_section );
+        for (j = 0; j < i; j++) list_remove( &done[j]->entry );
+        RtlLeaveCriticalSection( &uring_section );
+
+        if (batch.count) server_batch_call( &batch );
+        while (i--) RtlFreeHeap( GetProcessHeap(), 0, done[i] );
+        tail = load_acquire( ring.cq_tail );
+    }
+}
+
+static void CALLBACK uring_thread( void *arg )
+{
+    LARGE_INTEGER timeout;
+    int fd, err;
+
+    for (;;)
+    {
+        if (syscall( __NR_io_uring_enter, ring.fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0 ) == -1 &&
+            errno != EINTR)
+            break;
+        reap_completions();
+    }
+
+    /* stop submitting operations to the ring, the callers fall back to synchronous I/O */
+    err = errno;
+    ERR( "io_uring_enter failed: %s, disabling io_uring\n", strerror(err) );
+    RtlEnterCriticalSection( &uring_section );
+    fd = ring.fd;
+    ring.fd = -1;
+    RtlLeaveCriticalSection( &uring_section );
+
+    /* the kernel still posts the completions of the pending operations to the ring */
+    timeout.QuadPart = -10000;  /* 1 ms */
+    for (;;)
+    {
+        reap_completions();
+        if (!*(volatile unsigned int *)&ring.inflight) break;
+        NtDelayExecution( FALSE, &timeout );
+    }
+    if (err != EBADF) close( fd );
+}
+
+static DWORD WINAPI init_uring( RTL_RUN_ONCE *once, void *param, void **context )
+{
+    struct io_uring_params params;
+    const char *env = getenv( "WINE_IO_URING" );
+    char *sq_ptr, *cq_ptr;
+    void *sqes;
+    HANDLE thread;
+    int fd;
+
+    if (!env || !atoi( env )) return TRUE;
+
+    memset( &params, 0, sizeof(params) );
+    if ((fd = syscall( __NR_io_uring_setup, URING_ENTRIES, &params )) == -1)
+    {
+        WARN( "io_uring not available: %s\n", strerror(errno) );
+        return TRUE;
+    }
+
+    sq_ptr = mmap( NULL, params.sq_off.array + params.sq_entries * sizeof(unsigned int),
+                   PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+    cq_ptr = mmap( NULL, params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe),
+                   PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+    sqes = mmap( NULL, params.sq_entries * sizeof(struct io_uring_sqe),
+                 PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+    if (sq_ptr == MAP_FAILED || cq_ptr == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        WARN( "failed to map the io_uring rings\n" );
+        close( fd );  /* the mappings keep it alive */
+        return TRUE;
+    }
+
+    ring.entries    = params.sq_entries;
+    ring.cq_entries = params.cq_entries;
+    ring.sq_head    = (unsigned int *)(sq_ptr + params.sq_off.head);
+    ring.sq_tail    = (unsigned int *)(sq_ptr + params.sq_off.tail);
+    ring.sq_mask    = (unsigned int *)(sq_ptr + params.sq_off.ring_mask);
+    ring.sq_array   = (unsigned int *)(sq_ptr + params.sq_off.array);
+    ring.sqes       = sqes;
+    ring.cq_head    = (unsigned int *)(cq_ptr + params.cq_off.head);
+    ring.cq_tail    = (unsigned int *)(cq_ptr + params.cq_off.tail);
+    ring.cq_mask    = (unsigned int *)(cq_ptr + params.cq_off.ring_mask);
+    ring.cqes       = (struct io_uring_cqe *)(cq_ptr + params.cq_off.cqes);
+    ring.fd         = fd;
+
+    if (RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, NULL, 0, 0, uring_thread, NULL, &thread, NULL ))
+    {
+        WARN( "failed to create the completion thread\n" );
+        ring.fd = -1;
+        close( fd );
+        return TRUE;
+    }
+    NtClose( thread );
+    TRACE( "using io_uring with %u entries\n", ring.entries );
+    return TRUE;
+}
+
+
+/* release an operation that was not submitted */
+static void free_io( struct uring_io *io )
+{
+    struct server_batch batch;
+
+    batch.count = 0;
+    close_io_handles( io, &batch );
+    server_batch_call( &batch );
+    RtlFreeHeap( GetProcessHeap(), 0, io );
+}
+
+static inline BOOL ring_full(void)
+{
+    return *ring.sq_tail - load_acquire( ring.sq_head ) >= ring.entries || ring.inflight >= ring.cq_entries;
+}
+
+
+/***********************************************************************
+ *           uring_submit_io
+ *
+ * Submit an overlapped read or write on a regular file. Returns STATUS_PENDING
+ * on success, or STATUS_NOT_SUPPORTED if the caller should do the I/O itself.
+ */
+NTSTATUS uring_submit_io( HANDLE handle, int fd, BOOL write, HANDLE event, IO_STATUS_BLOCK *iosb,
+                          ULONG_PTR cvalue, void *buffer, ULONG length, ULONGLONG offset )
+{
+    struct io_uring_sqe *sqe;
+    struct uring_io *io;
+    unsigned int tail, idx;
+
+    RtlRunOnceExecuteOnce( &init_once, init_uring, NULL, NULL );
+    if (ring.fd == -1 || ring_full()) return STATUS_NOT_SUPPORTED;
+    if (!event && !has_completion_port( handle )) return STATUS_NOT_SUPPORTED;
+
+    if (!(io = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*io) ))) return STATUS_NOT_SUPPORTED;
+    if (dup_io_handles( io, handle, event ))
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, io );
+        return STATUS_NOT_SUPPORTED;
+    }
+    io->handle       = handle;
+    io->tid          = GetCurrentThreadId();
+    io->iosb         = iosb;
+    io->cvalue       = cvalue;
+    io->write        = write;
+    io->offset       = offset;
+    io->iov.iov_base = buffer;
+    io->iov.iov_len  = length;
+
+    RtlEnterCriticalSection( &uring_section );
+
+    if (ring.fd == -1 || ring_full())
+    {
+        RtlLeaveCriticalSection( &uring_section );
+        free_io( io );
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    iosb->Status = STATUS_PENDING;
+    iosb->Information = 0;
+    if (event) NtResetEvent( event, NULL );
+
+    tail = *ring.sq_tail;
+    idx = tail & *ring.sq_mask;
+    sqe = &ring.sqes[idx];
+    memset( sqe, 0, sizeof(*sqe) );
+    sqe->opcode    = write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd        = fd;
+    sqe->off       = offset;
+    sqe->addr      = (ULONG_PTR)&io->iov;
+    sqe->len       = 1;
+    sqe->user_data = (ULONG_PTR)io;
+    ring.sq_array[idx] = idx;
+    list_add_tail( &inflight_ios, &io->entry );
+    store_release( ring.sq_tail, tail + 1 );
+    interlocked_xchg_add( (LONG *)&ring.inflight, 1 );
+
+    /* the kernel takes its own reference to the file, so the fd may be closed after this */
+    while (syscall( __NR_io_uring_enter, ring.fd, 1, 0, 0, NULL, 0 ) == -1)
+    {
+        if (errno == EINTR) continue;
+        /* nothing was consumed, take the entry back */
+        WARN( "io_uring_enter failed: %s\n", strerror(errno) );
+        store_release( ring.sq_tail, tail );
+        interlocked_xchg_add( (LONG *)&ring.inflight, -1 );
+        list_remove( &io->entry );
+        RtlLeaveCriticalSection( &uring_section );
+        free_io( io );
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    RtlLeaveCriticalSection( &uring_section );
+    return STATUS_PENDING;
+}
+
+
+/***********************************************************************
+ *           uring_cancel_io
+ *
+ * Request the cancellation of the pending operations on a handle, optionally
+ * restricted to a status block or to the current thread. The operations
+ * complete with STATUS_CANCELLED unless they already finished. Returns the
+ * number of cancellation requests that were submitted.
+ */
+unsigned int uring_cancel_io( HANDLE handle, IO_STATUS_BLOCK *iosb, BOOL only_thread )
+{
+    struct io_uring_sqe *sqe;
+    struct uring_io *io;
+    unsigned int start, tail, idx, count = 0;
+
+    if (ring.fd == -1) return 0;
+
+    RtlEnterCriticalSection( &uring_section );
+
+    start = tail = *ring.sq_tail;
+    if (ring.fd != -1) LIST_FOR_EACH_ENTRY( io, &inflight_ios, struct uring_io, entry )
+    {
+        if (io->handle != handle) continue;
+        if (iosb && io->iosb != iosb) continue;
+        if (only_thread && io->tid != GetCurrentThreadId()) continue;
+        if (tail - load_acquire( ring.sq_head ) >= ring.entries || ring.inflight >= ring.cq_entries) break;
+
+        idx = tail & *ring.sq_mask;
+        sqe = &ring.sqes[idx];
+        memset( sqe, 0, sizeof(*sqe) );
+        sqe->opcode = URING_OP_ASYNC_CANCEL;
+        sqe->fd     = -1;
+        sqe->addr   = (ULONG_PTR)io;
+        ring.sq_array[idx] = idx;
+        store_release( ring.sq_tail, ++tail );
+        interlocked_xchg_add( (LONG *)&ring.inflight, 1 );
+        count++;
+    }
+
+    while (count && syscall( __NR_io_uring_enter, ring.fd, count, 0, 0, NULL, 0 ) == -1)
+    {
+        if (errno == EINTR) continue;
+        WARN( "io_uring_enter failed: %s\n", strerror(errno) );
+        store_release( ring.sq_tail, start );
+        interlocked_xchg_add( (LONG *)&ring.inflight, -(LONG)count );
+        count = 0;
+    }
+
+    RtlLeaveCriticalSection( &uring_section );
+    TRACE( "%p %p %u: cancelling %u operations\n", handle, iosb, only_thread, count );
+    return count;
+}
+
+
+/***********************************************************************
+ *           uring_set_completion_port
+ *
+ * Track whether a handle is associated with a completion port.
+ */
+void uring_set_completion_port( HANDLE handle, BOOL set )
+{
+    if (set) RtlRunOnceExecuteOnce( &init_once, init_uring, NULL, NULL );
+    if (ring.fd == -1) return;
+    update_port_bit( handle, set );
+}
+
+#else  /* HAVE_LINUX_IO_URING_H */
+
+NTSTATUS uring_submit_io( HANDLE handle, int fd, BOOL write, HANDLE event, IO_STATUS_BLOCK *iosb,
+                          ULONG_PTR cvalue, void *buffer, ULONG length, ULONGLONG offset )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+unsigned int uring_cancel_io( HANDLE handle, IO_STATUS_BLOCK *iosb, BOOL only_thread )
+{
+    return 0;
+}
+
+void uring_set_completion_port( HANDLE handle, BOOL set )
+{
+}
+
+#endif  /* HAVE_LINUX_IO_URING_H */
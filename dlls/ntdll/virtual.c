@@ -110,6 +110,20 @@ static const BYTE VIRTUAL_Win32Flags[16] =
 
 static struct wine_rb_tree views_tree;
 
+/* Sorted array of the address ranges that are not covered by any view. View boundaries
+ * are rounded to the allocation granularity, so that densely packed allocations don't
+ * fragment the array. This allows find_free_area to use a binary search instead of
+ * walking the views tree. */
+struct range_entry
+{
+    void *base;
+    void *end;
+};
+
+static struct range_entry *free_ranges;      /* NULL if the array overflowed */
+static struct range_entry *free_ranges_end;
+static const size_t granularity_mask = 0xffff;
+
 static RTL_CRITICAL_SECTION csVirtual;
 static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
 {
@@ -451,12 +465,12 @@ static struct file_view *find_view_range( const void *addr, size_t size )
 
 
 /***********************************************************************
- *           find_free_area
+ *           find_free_area_walk
  *
- * Find a free area between views inside the specified range.
+ * Find a free area between views inside the specified range, by walking the views tree.
  * The csVirtual section must be held by caller.
  */
-static void *find_free_area( void *base, void *end, size_t size, size_t mask, int top_down )
+static void *find_free_area_walk( void *base, void *end, size_t size, size_t mask, int top_down )
 {
     struct wine_rb_entry *first = NULL, *ptr = views_tree.root;
     void *start;
@@ -518,6 +532,232 @@ static void *find_free_area( void *base, void *end, size_t size, size_t mask, in
 }
 
 
+/***********************************************************************
+ *           get_view_granules
+ *
+ * Get the range of allocation granules covered by a view.
+ */
+static inline void get_view_granules( const struct file_view *view, void **base, void **end )
+{
+    *base = ROUND_ADDR( view->base, granularity_mask );
+    *end = ROUND_ADDR( (char *)view->base + view->size + granularity_mask, granularity_mask );
+    if (!*end) *end = (void *)~(UINT_PTR)0;  /* view at the top of the address space */
+}
+
+
+/***********************************************************************
+ *           free_ranges_lower_bound
+ *
+ * Return the first free range ending at or after addr, or free_ranges_end if there's none.
+ */
+static struct range_entry *free_ranges_lower_bound( const void *addr )
+{
+    struct range_entry *begin = free_ranges, *end = free_ranges_end, *mid;
+
+    while (begin < end)
+    {
+        mid = begin + (end - begin) / 2;
+        if ((const char *)mid->end < (const char *)addr) begin = mid + 1;
+        else end = mid;
+    }
+    return begin;
+}
+
+
+/***********************************************************************
+ *           free_ranges_grow
+ *
+ * Make room for a new entry before the specified range.
+ */
+static BOOL free_ranges_grow( struct range_entry *range )
+{
+    if ((char *)(free_ranges_end + 1) > (char *)free_ranges + view_block_size)
+    {
+        WARN( "free ranges array is full, falling back to views walk\n" );
+        free_ranges = free_ranges_end = NULL;
+        return FALSE;
+    }
+    memmove( range + 1, range, (free_ranges_end - range) * sizeof(*range) );
+    free_ranges_end++;
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           free_ranges_remove
+ *
+ * Remove an address range from the free ranges, after a view has been created.
+ * The csVirtual section must be held by caller.
+ */
+static void free_ranges_remove( void *base, void *end )
+{
+    struct range_entry *range, *first;
+
+    if (!free_ranges) return;
+
+    range = free_ranges_lower_bound( base );
+    if (range != free_ranges_end && range->end == base) range++;
+    if (range == free_ranges_end || (char *)range->base >= (char *)end) return;
+
+    if ((char *)range->base < (char *)base && (char *)range->end > (char *)end)
+    {
+        /* split the range in two */
+        if (!free_ranges_grow( range + 1 )) return;
+        range[1].base = end;
+        range[1].end = range->end;
+        range->end = base;
+        return;
+    }
+
+    if ((char *)range->base < (char *)base)
+    {
+        range->end = base;
+        range++;
+    }
+    first = range;
+    while (range != free_ranges_end && (char *)range->end <= (char *)end) range++;
+    if (range != free_ranges_end && (char *)range->base < (char *)end) range->base = end;
+    memmove( first, range, (free_ranges_end - range) * sizeof(*range) );
+    free_ranges_end -= range - first;
+}
+
+
+/***********************************************************************
+ *           free_ranges_add
+ *
+ * Add an address range to the free ranges, after a view has been deleted.
+ * The csVirtual section must be held by caller.
+ */
+static void free_ranges_add( void *base, void *end )
+{
+    struct range_entry *range, *last;
+
+    if (!free_ranges || (char *)base >= (char *)end) return;
+
+    range = free_ranges_lower_bound( base );
+    if (range == free_ranges_end || (char *)range->base > (char *)end)
+    {
+        if (!free_ranges_grow( range )) return;
+        range->base = base;
+        range->end = end;
+        return;
+    }
+
+    /* merge with all the ranges overlapping or touching the new one */
+    if ((char *)range->base > (char *)base) range->base = base;
+    for (last = range; last + 1 != free_ranges_end && (char *)last[1].base <= (char *)end; last++) ;
+    range->end = max( (char *)end, (char *)last->end );
+    memmove( range + 1, last + 1, (free_ranges_end - last - 1) * sizeof(*range) );
+    free_ranges_end -= last - range;
+}
+
+
+/***********************************************************************
+ *           free_ranges_insert_view
+ *
+ * Update the free ranges after a view has been created.
+ * The csVirtual section must be held by caller.
+ */
+static void free_ranges_insert_view( struct file_view *view )
+{
+    void *base, *end;
+
+    get_view_granules( view, &base, &end );
+    free_ranges_remove( base, end );
+}
+
+
+/***********************************************************************
+ *           free_ranges_remove_view
+ *
+ * Update the free ranges after a view has been removed from the views tree.
+ * The granules shared with the neighbouring views stay in use.
+ * The csVirtual section must be held by caller.
+ */
+static void free_ranges_remove_view( struct file_view *view, struct wine_rb_entry *prev,
+                                     struct wine_rb_entry *next )
+{
+    void *base, *end, *neighbour_base, *neighbour_end;
+
+    get_view_granules( view, &base, &end );
+    if (prev)
+    {
+        get_view_granules( WINE_RB_ENTRY_VALUE( prev, struct file_view, entry ),
+                           &neighbour_base, &neighbour_end );
+        base = max( (char *)base, (char *)neighbour_end );
+    }
+    if (next)
+    {
+        get_view_granules( WINE_RB_ENTRY_VALUE( next, struct file_view, entry ),
+                           &neighbour_base, &neighbour_end );
+        end = min( (char *)end, (char *)neighbour_base );
+    }
+    free_ranges_add( base, end );
+}
+
+
+/***********************************************************************
+ *           find_free_range
+ *
+ * Find a free area inside the specified range using the free ranges array.
+ * The csVirtual section must be held by caller.
+ */
+static void *find_free_range( void *base, void *end, size_t size, size_t mask, int top_down )
+{
+    struct range_entry *range;
+    char *start, *range_base, *range_end;
+
+    if (top_down)
+    {
+        range = free_ranges_lower_bound( end );
+        if (range == free_ranges_end) range--;
+        for ( ; range >= free_ranges; range--)
+        {
+            if ((char *)range->end <= (char *)base) break;
+            range_base = max( (char *)range->base, (char *)base );
+            range_end = min( (char *)range->end, (char *)end );
+            if (range_end <= range_base || range_end - range_base < size) continue;
+            start = ROUND_ADDR( range_end - size, mask );
+            if (start >= range_base) return start;
+        }
+    }
+    else
+    {
+        for (range = free_ranges_lower_bound( base ); range != free_ranges_end; range++)
+        {
+            if ((char *)range->base >= (char *)end) break;
+            range_base = max( (char *)range->base, (char *)base );
+            range_end = min( (char *)range->end, (char *)end );
+            start = ROUND_ADDR( range_base + mask, mask );
+            if (start < range_base) break;  /* overflow */
+            if (start < range_end && range_end - start >= size) return start;
+        }
+    }
+    return NULL;
+}
+
+
+/***********************************************************************
+ *           find_free_area
+ *
+ * Find a free area between views inside the specified range.
+ * The csVirtual section must be held by caller.
+ */
+static void *find_free_area( void *base, void *end, size_t size, size_t mask, int top_down )
+{
+    /* the free ranges are only usable for allocations aligned to the granularity; they may
+     * miss some space in granules shared with unaligned views, but never report used space */
+    if (free_ranges && mask >= granularity_mask)
+    {
+        void *start = find_free_range( base, end, size, mask, top_down );
+
+        if (!start || !find_view_range( start, size )) return start;
+        WARN( "free range %p-%p overlaps a view\n", start, (char *)start + size );
+    }
+    return find_free_area_walk( base, end, size, mask, top_down );
+}
+
+
 /***********************************************************************
  *           add_reserved_area
  *
@@ -684,9 +924,12 @@ static struct file_view *alloc_view(void)
  */
 static void delete_view( struct file_view *view ) /* [in] View */
 {
+    struct wine_rb_entry *prev = wine_rb_prev( &view->entry ), *next = wine_rb_next( &view->entry );
+
     if (!(view->protect & VPROT_SYSTEM)) unmap_area( view->base, view->size );
     set_page_vprot( view->base, view->size, 0 );
     wine_rb_remove( &views_tree, &view->entry );
+    free_ranges_remove_view( view, prev, next );
     *(struct file_view **)view = next_free_view;
     next_free_view = view;
 }
@@ -733,6 +976,7 @@ static NTSTATUS create_view( struct file_view **view_ret, void *base, size_t siz
     set_page_vprot( base, size, vprot );
 
     wine_rb_put( &views_tree, view->base, &view->entry );
+    free_ranges_insert_view( view );
 
     *view_ret = view;
 
@@ -1817,9 +2061,9 @@ void virtual_init(void)
     /* try to find space in a reserved area for the views and pages protection table */
 #ifdef _WIN64
     pages_vprot_size = ((size_t)address_space_limit >> page_shift >> pages_vprot_shift) + 1;
-    alloc_views.size = view_block_size + pages_vprot_size * sizeof(*pages_vprot);
+    alloc_views.size = 2 * view_block_size + pages_vprot_size * sizeof(*pages_vprot);
 #else
-    alloc_views.size = view_block_size + (1U << (32 - page_shift));
+    alloc_views.size = 2 * view_block_size + (1U << (32 - page_shift));
 #endif
     if (wine_mmap_enum_reserved_areas( alloc_virtual_heap, &alloc_views, 1 ))
         wine_mmap_remove_reserved_area( alloc_views.base, alloc_views.size, 0 );
@@ -1829,9 +2073,14 @@ void virtual_init(void)
     assert( alloc_views.base != (void *)-1 );
     view_block_start = alloc_views.base;
     view_block_end = view_block_start + view_block_size / sizeof(*view_block_start);
-    pages_vprot = (void *)((char *)alloc_views.base + view_block_size);
+    free_ranges = (void *)((char *)alloc_views.base + view_block_size);
+    pages_vprot = (void *)((char *)alloc_views.base + 2 * view_block_size);
     wine_rb_init( &views_tree, compare_view );
 
+    free_ranges[0].base = (void *)0;
+    free_ranges[0].end = (void *)~(UINT_PTR)0;
+    free_ranges_end = free_ranges + 1;
+
     /* make the DOS area accessible (except the low 64K) to hide bugs in broken apps like Excel 2003 */
     size = (char *)address_space_start - (char *)0x10000;
     if (size && wine_mmap_is_in_reserved_area( (void*)0x10000, size ) == 1)
@@ -40,6 +40,10 @@ WINE_DEFAULT_DEBUG_CHANNEL(d3d);
 #define VB_MAXFULLCONVERSIONS 5       /* Number of full conversions before we stop converting */
 #define VB_RESETFULLCONVS     20      /* Reset full conversion counts after that number of draws */
 
+#define WINED3D_BUFFER_GL_STORAGE_FLAGS (GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)
+/* The amount of retired streaming buffer object memory kept around for reuse. */
+#define WINED3D_STREAMING_BO_MAX_SIZE (64 * 1024 * 1024)
+
 static void wined3d_buffer_evict_sysmem(struct wined3d_buffer *buffer)
 {
     if (buffer->flags & WINED3D_BUFFER_PIN_SYSMEM)
@@ -138,6 +142,28 @@ static void wined3d_buffer_gl_bind(struct wined3d_buffer_gl *buffer_gl, struct w
     context_bind_bo(context, buffer_gl->buffer_type_hint, buffer_gl->buffer_object);
 }
 
+static void wined3d_buffer_gl_invalidate_bind_points(struct wined3d_buffer_gl *buffer_gl)
+{
+    struct wined3d_resource *resource = &buffer_gl->b.resource;
+
+    if (!resource->bind_count)
+        return;
+
+    if (resource->bind_flags & WINED3D_BIND_VERTEX_BUFFER)
+        device_invalidate_state(resource->device, STATE_STREAMSRC);
+    if (resource->bind_flags & WINED3D_BIND_INDEX_BUFFER)
+        device_invalidate_state(resource->device, STATE_INDEXBUFFER);
+    if (resource->bind_flags & WINED3D_BIND_CONSTANT_BUFFER)
+    {
+        device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_VERTEX));
+        device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_HULL));
+        device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_DOMAIN));
+        device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_GEOMETRY));
+        device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_PIXEL));
+        device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_COMPUTE));
+    }
+}
+
 /* Context activation is done by the caller. */
 static void wined3d_buffer_gl_destroy_buffer_object(struct wined3d_buffer_gl *buffer_gl,
         struct wined3d_context *context)
@@ -153,38 +179,24 @@ static void wined3d_buffer_gl_destroy_buffer_object(struct wined3d_buffer_gl *bu
      * valid any longer. Dirtify the stream source to force a reload. This
      * happens only once per changed vertexbuffer and should occur rather
      * rarely. */
-    if (resource->bind_count)
+    wined3d_buffer_gl_invalidate_bind_points(buffer_gl);
+    if (resource->bind_count && (resource->bind_flags & WINED3D_BIND_STREAM_OUTPUT))
     {
-        if (resource->bind_flags & WINED3D_BIND_VERTEX_BUFFER)
-            device_invalidate_state(resource->device, STATE_STREAMSRC);
-        if (resource->bind_flags & WINED3D_BIND_INDEX_BUFFER)
-            device_invalidate_state(resource->device, STATE_INDEXBUFFER);
-        if (resource->bind_flags & WINED3D_BIND_CONSTANT_BUFFER)
+        device_invalidate_state(resource->device, STATE_STREAM_OUTPUT);
+        if (context->transform_feedback_active)
         {
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_VERTEX));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_HULL));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_DOMAIN));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_GEOMETRY));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_PIXEL));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_COMPUTE));
-        }
-        if (resource->bind_flags & WINED3D_BIND_STREAM_OUTPUT)
-        {
-            device_invalidate_state(resource->device, STATE_STREAM_OUTPUT);
-            if (context->transform_feedback_active)
-            {
-                /* We have to make sure that transform feedback is not active
-                 * when deleting a potentially bound transform feedback buffer.
-                 * This may happen when the device is being destroyed. */
-                WARN("Deleting buffer object for buffer %p, disabling transform feedback.\n", buffer_gl);
-                context_end_transform_feedback(context);
-            }
+            /* We have to make sure that transform feedback is not active
+             * when deleting a potentially bound transform feedback buffer.
+             * This may happen when the device is being destroyed. */
+            WARN("Deleting buffer object for buffer %p, disabling transform feedback.\n", buffer_gl);
+            context_end_transform_feedback(context);
         }
     }
 
     GL_EXTCALL(glDeleteBuffers(1, &buffer_gl->buffer_object));
     checkGLcall("glDeleteBuffers");
     buffer_gl->buffer_object = 0;
+    buffer_gl->persistent_ptr = NULL;
 
     if (buffer_gl->b.fence)
     {
@@ -194,6 +206,52 @@ static void wined3d_buffer_gl_destroy_buffer_object(struct wined3d_buffer_gl *bu
     buffer_gl->b.flags &= ~WINED3D_BUFFER_APPLESYNC;
 }
 
+/* Context activation is done by the caller. */
+static BOOL wined3d_buffer_gl_create_persistent_bo(const struct wined3d_buffer_gl *buffer_gl,
+        struct wined3d_context *context, GLsizeiptr size, GLuint *name, void **ptr)
+{
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    GLenum binding = buffer_gl->buffer_type_hint;
+    GLbitfield flags = WINED3D_BUFFER_GL_STORAGE_FLAGS;
+
+    /* Readable mappings may end up in uncached memory, which is slow to
+     * write to, so only ask for them when the application can read. */
+    if (buffer_gl->b.resource.access & WINED3D_RESOURCE_ACCESS_MAP_R)
+        flags |= GL_MAP_READ_BIT;
+
+    GL_EXTCALL(glGenBuffers(1, name));
+    context_bind_bo(context, binding, *name);
+    GL_EXTCALL(glBufferStorage(binding, size, NULL, flags | GL_DYNAMIC_STORAGE_BIT));
+    *ptr = GL_EXTCALL(glMapBufferRange(binding, 0, size, flags));
+    checkGLcall("create persistent buffer object");
+
+    if (!*ptr || ((DWORD_PTR)*ptr & (RESOURCE_ALIGNMENT - 1)))
+    {
+        WARN("Failed to map buffer object %u persistently, pointer %p.\n", *name, *ptr);
+        GL_EXTCALL(glDeleteBuffers(1, name));
+        checkGLcall("glDeleteBuffers");
+        *name = 0;
+        *ptr = NULL;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static BOOL wined3d_buffer_gl_use_persistent_bo(const struct wined3d_buffer_gl *buffer_gl,
+        const struct wined3d_gl_info *gl_info)
+{
+    const struct wined3d_resource *resource = &buffer_gl->b.resource;
+
+    /* DISCARD maps replace the buffer object, so buffers that views or
+     * transform feedback refer to by name can't be backed this way. */
+    return (resource->usage & WINED3DUSAGE_DYNAMIC)
+            && !(resource->bind_flags & ~(WINED3D_BIND_VERTEX_BUFFER
+                    | WINED3D_BIND_INDEX_BUFFER | WINED3D_BIND_CONSTANT_BUFFER))
+            && gl_info->supported[ARB_BUFFER_STORAGE] && gl_info->supported[ARB_MAP_BUFFER_RANGE]
+            && gl_info->supported[ARB_COPY_BUFFER] && gl_info->supported[ARB_SYNC];
+}
+
 /* Context activation is done by the caller. */
 static BOOL wined3d_buffer_gl_create_buffer_object(struct wined3d_buffer_gl *buffer_gl, struct wined3d_context *context)
 {
@@ -211,6 +269,16 @@ static BOOL wined3d_buffer_gl_create_buffer_object(struct wined3d_buffer_gl *buf
      */
     while (gl_info->gl_ops.gl.p_glGetError() != GL_NO_ERROR);
 
+    if (wined3d_buffer_gl_use_persistent_bo(buffer_gl, gl_info)
+            && wined3d_buffer_gl_create_persistent_bo(buffer_gl, context,
+            buffer_gl->b.resource.size, &buffer_gl->buffer_object, &buffer_gl->persistent_ptr))
+    {
+        TRACE("Using persistently mapped buffer object %u.\n", buffer_gl->buffer_object);
+        buffer_gl->buffer_object_usage = GL_STREAM_DRAW_ARB;
+        buffer_invalidate_bo_range(&buffer_gl->b, 0, 0);
+        return TRUE;
+    }
+
     /* Basically the FVF parameter passed to CreateVertexBuffer is no good.
      * The vertex declaration from the device determines how the data in the
      * buffer is interpreted. This means that on each draw call the buffer has
@@ -1004,6 +1072,119 @@ struct wined3d_resource * CDECL wined3d_buffer_get_resource(struct wined3d_buffe
     return &buffer->resource;
 }
 
+static void wined3d_streaming_bo_destroy(struct wined3d_device_gl *device_gl,
+        struct wined3d_streaming_bo *bo, const struct wined3d_gl_info *gl_info)
+{
+    list_remove(&bo->entry);
+    device_gl->streaming_bo_size -= bo->size;
+    GL_EXTCALL(glDeleteBuffers(1, &bo->name));
+    checkGLcall("glDeleteBuffers");
+    wined3d_fence_destroy(bo->fence);
+    heap_free(bo);
+}
+
+/* Context activation is done by the caller. */
+void wined3d_device_gl_destroy_streaming_bos(struct wined3d_device_gl *device_gl, struct wined3d_context *context)
+{
+    struct wined3d_streaming_bo *bo, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE(bo, next, &device_gl->streaming_bos, struct wined3d_streaming_bo, entry)
+    {
+        wined3d_streaming_bo_destroy(device_gl, bo, context->gl_info);
+    }
+}
+
+/* Replaces the persistently mapped buffer object of "buffer_gl" for a
+ * DISCARD map. The old buffer object is retired with a fence, and a retired
+ * buffer object of the same size that the GPU is done with is reused if
+ * there is one. This avoids both waiting for the GPU and relying on the
+ * driver to rename the buffer storage.
+ *
+ * Context activation is done by the caller. */
+static void wined3d_buffer_gl_discard_bo(struct wined3d_buffer_gl *buffer_gl, struct wined3d_context *context)
+{
+    struct wined3d_device *device = buffer_gl->b.resource.device;
+    struct wined3d_device_gl *device_gl = wined3d_device_gl(device);
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    BOOL readable = !!(buffer_gl->b.resource.access & WINED3D_RESOURCE_ACCESS_MAP_R);
+    GLsizeiptr size = buffer_gl->b.resource.size;
+    struct wined3d_streaming_bo *bo, *next, *retired;
+    enum wined3d_fence_result ret;
+    GLuint name;
+    void *ptr;
+    HRESULT hr;
+
+    if (!(retired = heap_alloc(sizeof(*retired))))
+    {
+        ERR("Failed to allocate streaming buffer object memory.\n");
+        gl_info->gl_ops.gl.p_glFinish();
+        return;
+    }
+    if (FAILED(hr = wined3d_fence_create(device, &retired->fence)))
+    {
+        ERR("Failed to create fence, hr %#x.\n", hr);
+        heap_free(retired);
+        gl_info->gl_ops.gl.p_glFinish();
+        return;
+    }
+    wined3d_fence_issue(retired->fence, device);
+    retired->name = buffer_gl->buffer_object;
+    retired->size = size;
+    retired->ptr = buffer_gl->persistent_ptr;
+    retired->readable = readable;
+
+    /* Fences signal in order, so there's no point in looking any further
+     * once we find one that hasn't signalled yet. */
+    name = 0;
+    LIST_FOR_EACH_ENTRY_SAFE(bo, next, &device_gl->streaming_bos, struct wined3d_streaming_bo, entry)
+    {
+        /* The fence is lost when the context it was issued in is destroyed. */
+        if ((ret = wined3d_fence_test(bo->fence, device, 0)) == WINED3D_FENCE_NOT_STARTED)
+        {
+            wined3d_streaming_bo_destroy(device_gl, bo, gl_info);
+            continue;
+        }
+        if (ret != WINED3D_FENCE_OK)
+        {
+            TRACE("Streaming buffer object %u is busy, fence result %#x.\n", bo->name, ret);
+            break;
+        }
+        if (bo->size != size || bo->readable != readable)
+            continue;
+
+        TRACE("Reusing streaming buffer object %u.\n", bo->name);
+        name = bo->name;
+        ptr = bo->ptr;
+        list_remove(&bo->entry);
+        device_gl->streaming_bo_size -= bo->size;
+        wined3d_fence_destroy(bo->fence);
+        heap_free(bo);
+        break;
+    }
+
+    if (!name && !wined3d_buffer_gl_create_persistent_bo(buffer_gl, context, size, &name, &ptr))
+    {
+        WARN("Failed to create a streaming buffer object, waiting for the GPU.\n");
+        wined3d_fence_wait(retired->fence, device);
+        wined3d_fence_destroy(retired->fence);
+        heap_free(retired);
+        return;
+    }
+
+    list_add_tail(&device_gl->streaming_bos, &retired->entry);
+    device_gl->streaming_bo_size += retired->size;
+    while (device_gl->streaming_bo_size > WINED3D_STREAMING_BO_MAX_SIZE)
+    {
+        bo = LIST_ENTRY(list_head(&device_gl->streaming_bos), struct wined3d_streaming_bo, entry);
+        wined3d_streaming_bo_destroy(device_gl, bo, gl_info);
+    }
+
+    TRACE("Replacing buffer object %u with %u.\n", buffer_gl->buffer_object, name);
+    buffer_gl->buffer_object = name;
+    buffer_gl->persistent_ptr = ptr;
+    wined3d_buffer_gl_invalidate_bind_points(buffer_gl);
+}
+
 static HRESULT wined3d_buffer_gl_map(struct wined3d_buffer_gl *buffer_gl,
         unsigned int offset, unsigned int size, BYTE **data, DWORD flags)
 {
@@ -1065,7 +1246,17 @@ static HRESULT wined3d_buffer_gl_map(struct wined3d_buffer_gl *buffer_gl,
             if ((flags & WINED3D_MAP_DISCARD) && buffer_gl->b.resource.heap_memory)
                 wined3d_buffer_evict_sysmem(&buffer_gl->b);
 
-            if (count == 1)
+            if (count == 1 && buffer_gl->persistent_ptr)
+            {
+                /* Unlike for regular maps, nothing waits for the GPU here. */
+                if (!(flags & (WINED3D_MAP_NOOVERWRITE | WINED3D_MAP_DISCARD)))
+                    gl_info->gl_ops.gl.p_glFinish();
+                else if ((flags & WINED3D_MAP_DISCARD) && !(buffer_gl->b.flags & WINED3D_BUFFER_DISCARD))
+                    wined3d_buffer_gl_discard_bo(buffer_gl, context);
+
+                buffer_gl->b.map_ptr = buffer_gl->persistent_ptr;
+            }
+            else if (count == 1)
             {
                 wined3d_buffer_gl_bind(buffer_gl, context);
 
@@ -1161,7 +1352,13 @@ static void wined3d_buffer_gl_unmap(struct wined3d_buffer_gl *buffer_gl)
         return;
     }
 
-    if (buffer_gl->b.map_ptr)
+    if (buffer_gl->b.map_ptr && buffer_gl->persistent_ptr)
+    {
+        /* The mapping is coherent, there's nothing to flush. */
+        buffer_clear_dirty_areas(&buffer_gl->b);
+        buffer_gl->b.map_ptr = NULL;
+    }
+    else if (buffer_gl->b.map_ptr)
     {
         struct wined3d_device *device = buffer_gl->b.resource.device;
         const struct wined3d_gl_info *gl_info;
@@ -21,6 +21,7 @@
 #include "wined3d_private.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 
 #define WINED3D_INITIAL_CS_SIZE 4096
 
@@ -53,6 +54,7 @@ enum wined3d_cs_op
     WINED3D_CS_OP_SET_RENDER_STATE,
     WINED3D_CS_OP_SET_TEXTURE_STATE,
     WINED3D_CS_OP_SET_SAMPLER_STATE,
+    WINED3D_CS_OP_SET_STATES,
     WINED3D_CS_OP_SET_TRANSFORM,
     WINED3D_CS_OP_SET_CLIP_PLANE,
     WINED3D_CS_OP_SET_COLOR_KEY,
@@ -73,9 +75,13 @@ enum wined3d_cs_op
     WINED3D_CS_OP_CLEAR_UNORDERED_ACCESS_VIEW,
     WINED3D_CS_OP_COPY_UAV_COUNTER,
     WINED3D_CS_OP_GENERATE_MIPMAPS,
+    WINED3D_CS_OP_EXECUTE_COMMAND_LIST,
     WINED3D_CS_OP_STOP,
 };
 
+/* The per-opcode packet counters are indexed by opcode. */
+C_ASSERT(WINED3D_CS_OP_STOP <= WINED3D_CS_MAX_OPS);
+
 struct wined3d_cs_packet
 {
     size_t size;
@@ -296,6 +302,13 @@ struct wined3d_cs_set_sampler_state
     DWORD value;
 };
 
+struct wined3d_cs_set_states
+{
+    enum wined3d_cs_op opcode;
+    unsigned int count;
+    struct wined3d_cs_state_change changes[1];
+};
+
 struct wined3d_cs_set_transform
 {
     enum wined3d_cs_op opcode;
@@ -439,6 +452,12 @@ struct wined3d_cs_generate_mipmaps
     struct wined3d_shader_resource_view *view;
 };
 
+struct wined3d_cs_execute_command_list
+{
+    enum wined3d_cs_op opcode;
+    struct wined3d_command_list *list;
+};
+
 struct wined3d_cs_stop
 {
     enum wined3d_cs_op opcode;
@@ -447,6 +466,8 @@ struct wined3d_cs_stop
 static inline void *wined3d_cs_require_space(struct wined3d_cs *cs,
         size_t size, enum wined3d_cs_queue_id queue_id)
 {
+    if (cs->state_change_count)
+        wined3d_cs_flush_state_changes(cs);
     return cs->ops->require_space(cs, size, queue_id);
 }
 
@@ -455,6 +476,11 @@ static inline void wined3d_cs_submit(struct wined3d_cs *cs, enum wined3d_cs_queu
     cs->ops->submit(cs, queue_id);
 }
 
+static inline void wined3d_cs_acquire_resource(struct wined3d_cs *cs, struct wined3d_resource *resource)
+{
+    cs->ops->acquire_resource(cs, resource);
+}
+
 static const char *debug_cs_op(enum wined3d_cs_op op)
 {
     switch (op)
@@ -487,6 +513,7 @@ static const char *debug_cs_op(enum wined3d_cs_op op)
         WINED3D_TO_STR(WINED3D_CS_OP_SET_RENDER_STATE);
         WINED3D_TO_STR(WINED3D_CS_OP_SET_TEXTURE_STATE);
         WINED3D_TO_STR(WINED3D_CS_OP_SET_SAMPLER_STATE);
+        WINED3D_TO_STR(WINED3D_CS_OP_SET_STATES);
         WINED3D_TO_STR(WINED3D_CS_OP_SET_TRANSFORM);
         WINED3D_TO_STR(WINED3D_CS_OP_SET_CLIP_PLANE);
         WINED3D_TO_STR(WINED3D_CS_OP_SET_COLOR_KEY);
@@ -507,6 +534,7 @@ static const char *debug_cs_op(enum wined3d_cs_op op)
         WINED3D_TO_STR(WINED3D_CS_OP_CLEAR_UNORDERED_ACCESS_VIEW);
         WINED3D_TO_STR(WINED3D_CS_OP_COPY_UAV_COUNTER);
         WINED3D_TO_STR(WINED3D_CS_OP_GENERATE_MIPMAPS);
+        WINED3D_TO_STR(WINED3D_CS_OP_EXECUTE_COMMAND_LIST);
         WINED3D_TO_STR(WINED3D_CS_OP_STOP);
 #undef WINED3D_TO_STR
         default:
@@ -514,6 +542,263 @@ static const char *debug_cs_op(enum wined3d_cs_op op)
     }
 }
 
+#define WINED3D_CS_PROFILER_MAX_EVENTS 0x40000u
+
+enum wined3d_cs_profiler_event_type
+{
+    WINED3D_CS_PROFILER_EVENT_SPAN,
+    WINED3D_CS_PROFILER_EVENT_COUNTER,
+};
+
+struct wined3d_cs_profiler_event
+{
+    enum wined3d_cs_profiler_event_type type;
+    const char *name;
+    const char *category;
+    DWORD tid;
+    LONGLONG start;
+    /* The duration for spans, the value for counters. */
+    LONGLONG value;
+    LONG ready;
+};
+
+/* Records a timeline of the command stream in the Chrome trace event
+ * format. The application thread and the command stream thread both add
+ * events, so slots are reserved atomically and only written out once
+ * marked ready. */
+struct wined3d_cs_profiler
+{
+    char filename[MAX_PATH];
+    LONGLONG frequency;
+    LONGLONG origin;
+    LONG enabled;
+    BOOL written;
+    unsigned int frame_count;
+
+    /* Only accessed by the application thread. */
+    LONGLONG frame_start;
+    LONGLONG emit_start;
+    LONGLONG emit_time;
+    unsigned int emit_count;
+
+    LONG event_count;
+    struct wined3d_cs_profiler_event events[WINED3D_CS_PROFILER_MAX_EVENTS];
+};
+
+static LONGLONG wined3d_cs_profiler_time(void)
+{
+    LARGE_INTEGER counter;
+
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static struct wined3d_cs_profiler *wined3d_cs_profiler_create(void)
+{
+    static LONG profiler_count;
+    struct wined3d_cs_profiler *profiler;
+    LARGE_INTEGER frequency;
+    int length;
+
+    if (!wined3d_settings.profile_file)
+        return NULL;
+
+    if (!(profiler = heap_alloc_zero(sizeof(*profiler))))
+    {
+        ERR("Failed to allocate profiler memory.\n");
+        return NULL;
+    }
+
+    /* Every device gets its own profile, so that processes, or applications
+     * creating more than one device, don't overwrite each other's. */
+    length = snprintf(profiler->filename, sizeof(profiler->filename), "%s.%u.%u.json",
+            wined3d_settings.profile_file, GetCurrentProcessId(), InterlockedIncrement(&profiler_count));
+    if (length < 0 || length >= sizeof(profiler->filename))
+    {
+        ERR("Profile file name %s is too long.\n", debugstr_a(wined3d_settings.profile_file));
+        heap_free(profiler);
+        return NULL;
+    }
+
+    QueryPerformanceFrequency(&frequency);
+    profiler->frequency = frequency.QuadPart;
+    profiler->origin = profiler->frame_start = wined3d_cs_profiler_time();
+    profiler->enabled = TRUE;
+
+    return profiler;
+}
+
+static void wined3d_cs_profiler_add_event(struct wined3d_cs_profiler *profiler,
+        enum wined3d_cs_profiler_event_type type, const char *name, const char *category,
+        LONGLONG start, LONGLONG value)
+{
+    struct wined3d_cs_profiler_event *event;
+    LONG idx;
+
+    if (!profiler->enabled)
+        return;
+
+    if ((idx = InterlockedIncrement(&profiler->event_count) - 1) >= ARRAY_SIZE(profiler->events))
+    {
+        InterlockedExchange(&profiler->enabled, FALSE);
+        return;
+    }
+
+    event = &profiler->events[idx];
+    event->type = type;
+    event->name = name;
+    event->category = category;
+    event->tid = GetCurrentThreadId();
+    event->start = start;
+    event->value = value;
+    InterlockedExchange(&event->ready, TRUE);
+}
+
+static void wined3d_cs_profiler_add_span(struct wined3d_cs_profiler *profiler,
+        const char *name, const char *category, LONGLONG start, LONGLONG end)
+{
+    wined3d_cs_profiler_add_event(profiler, WINED3D_CS_PROFILER_EVENT_SPAN, name, category, start, end - start);
+}
+
+static void wined3d_cs_profiler_add_counter(struct wined3d_cs_profiler *profiler,
+        const char *name, LONGLONG time, LONGLONG value)
+{
+    wined3d_cs_profiler_add_event(profiler, WINED3D_CS_PROFILER_EVENT_COUNTER, name, "frame", time, value);
+}
+
+static double wined3d_cs_profiler_us(const struct wined3d_cs_profiler *profiler, LONGLONG ticks)
+{
+    return ticks * 1000000.0 / profiler->frequency;
+}
+
+static BOOL wined3d_cs_profiler_write(HANDLE file, const char *buffer, size_t length)
+{
+    DWORD size;
+
+    return WriteFile(file, buffer, length, &size, NULL) && size == length;
+}
+
+static void wined3d_cs_profiler_dump(struct wined3d_cs_profiler *profiler)
+{
+    const struct wined3d_cs_profiler_event *event;
+    const char *filename = profiler->filename;
+    char buffer[4096];
+    unsigned int i, count;
+    size_t length = 0;
+    BOOL first = TRUE;
+    DWORD pid;
+    HANDLE file;
+    BOOL ret;
+
+    InterlockedExchange(&profiler->enabled, FALSE);
+    profiler->written = TRUE;
+    count = min(*(volatile LONG *)&profiler->event_count, ARRAY_SIZE(profiler->events));
+
+    if ((file = CreateFileA(filename, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        ERR("Failed to create profile file %s, error %u.\n", debugstr_a(filename), GetLastError());
+        return;
+    }
+
+    pid = GetCurrentProcessId();
+    length = sprintf(buffer, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (i = 0, ret = TRUE; i < count && ret; ++i)
+    {
+        event = &profiler->events[i];
+        if (!event->ready)
+            continue;
+
+        if (length > sizeof(buffer) - 256)
+        {
+            ret = wined3d_cs_profiler_write(file, buffer, length);
+            length = 0;
+        }
+
+        if (!first)
+            buffer[length++] = ',';
+        first = FALSE;
+
+        if (event->type == WINED3D_CS_PROFILER_EVENT_SPAN)
+            length += sprintf(&buffer[length], "\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%u,"
+                    "\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", event->name, event->category, pid, event->tid,
+                    wined3d_cs_profiler_us(profiler, event->start - profiler->origin),
+                    wined3d_cs_profiler_us(profiler, event->value));
+        else
+            length += sprintf(&buffer[length], "\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"C\",\"pid\":%u,"
+                    "\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%s}}", event->name, event->category, pid,
+                    event->tid, wined3d_cs_profiler_us(profiler, event->start - profiler->origin),
+                    wine_dbgstr_longlong(event->value));
+    }
+    length += sprintf(&buffer[length], "\n]}\n");
+    if (ret)
+        ret = wined3d_cs_profiler_write(file, buffer, length);
+    CloseHandle(file);
+
+    if (!ret)
+        ERR("Failed to write profile file %s.\n", debugstr_a(filename));
+    else
+        TRACE_(d3d_perf)("Wrote %u profiler events for %u frames to %s.\n",
+                count, profiler->frame_count, debugstr_a(filename));
+}
+
+/* Called by the application thread for every present. */
+static void wined3d_cs_profiler_end_frame(struct wined3d_cs *cs, LONGLONG present_start)
+{
+    struct wined3d_cs_profiler *profiler = cs->profiler;
+    LONGLONG time = wined3d_cs_profiler_time();
+
+    wined3d_cs_profiler_add_span(profiler, "present", "app", present_start, time);
+    wined3d_cs_profiler_add_span(profiler, "frame", "app", profiler->frame_start, time);
+    wined3d_cs_profiler_add_counter(profiler, "emitted packets", time, profiler->emit_count);
+    wined3d_cs_profiler_add_counter(profiler, "emit time (us)", time,
+            (LONGLONG)wined3d_cs_profiler_us(profiler, profiler->emit_time));
+
+    profiler->frame_start = time;
+    profiler->emit_time = 0;
+    profiler->emit_count = 0;
+
+    if (profiler->written)
+        return;
+
+    /* Write the profile once the requested number of frames was recorded, or
+     * once the event buffer is full. */
+    if (++profiler->frame_count != wined3d_settings.profile_frames && profiler->enabled)
+        return;
+
+    /* Let the command stream thread catch up, so that the frames it is still
+     * executing end up in the profile as well. */
+    wined3d_cs_finish(cs, WINED3D_CS_QUEUE_DEFAULT);
+    wined3d_cs_profiler_dump(profiler);
+}
+
+static void wined3d_cs_count_packet(struct wined3d_cs *cs, enum wined3d_cs_op opcode, size_t size)
+{
+    if (opcode < ARRAY_SIZE(cs->packet_counts))
+        ++cs->packet_counts[opcode];
+    cs->packet_bytes += size;
+}
+
+static void wined3d_cs_dump_packet_counts(struct wined3d_cs *cs)
+{
+    unsigned int i, total = 0;
+
+    if (TRACE_ON(d3d_perf))
+    {
+        for (i = 0; i < WINED3D_CS_OP_STOP; ++i)
+        {
+            if (!cs->packet_counts[i])
+                continue;
+            TRACE_(d3d_perf)("    %s: %u.\n", debug_cs_op(i), cs->packet_counts[i]);
+            total += cs->packet_counts[i];
+        }
+        TRACE_(d3d_perf)("Executed %u packets, %lu bytes since the last present.\n",
+                total, (unsigned long)cs->packet_bytes);
+    }
+
+    memset(cs->packet_counts, 0, sizeof(cs->packet_counts));
+    cs->packet_bytes = 0;
+}
+
 static void wined3d_cs_exec_nop(struct wined3d_cs *cs, const void *data)
 {
 }
@@ -535,6 +820,8 @@ static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
         wined3d_resource_release(&swapchain->back_buffers[i]->resource);
     }
 
+    wined3d_cs_dump_packet_counts(cs);
+
     InterlockedDecrement(&cs->pending_presents);
 }
 
@@ -543,9 +830,13 @@ void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *sw
         unsigned int swap_interval, DWORD flags)
 {
     struct wined3d_cs_present *op;
+    LONGLONG start = 0;
     unsigned int i;
     LONG pending;
 
+    if (cs->profiler)
+        start = wined3d_cs_profiler_time();
+
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
     op->opcode = WINED3D_CS_OP_PRESENT;
     op->dst_window_override = dst_window_override;
@@ -557,10 +848,10 @@ void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *sw
 
     pending = InterlockedIncrement(&cs->pending_presents);
 
-    wined3d_resource_acquire(&swapchain->front_buffer->resource);
+    wined3d_cs_acquire_resource(cs, &swapchain->front_buffer->resource);
     for (i = 0; i < swapchain->desc.backbuffer_count; ++i)
     {
-        wined3d_resource_acquire(&swapchain->back_buffers[i]->resource);
+        wined3d_cs_acquire_resource(cs, &swapchain->back_buffers[i]->resource);
     }
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
@@ -572,6 +863,9 @@ void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *sw
         wined3d_pause();
         pending = InterlockedCompareExchange(&cs->pending_presents, 0, 0);
     }
+
+    if (cs->profiler)
+        wined3d_cs_profiler_end_frame(cs, start);
 }
 
 static void wined3d_cs_exec_clear(struct wined3d_cs *cs, const void *data)
@@ -599,7 +893,7 @@ static void wined3d_cs_exec_clear(struct wined3d_cs *cs, const void *data)
 void wined3d_cs_emit_clear(struct wined3d_cs *cs, DWORD rect_count, const RECT *rects,
         DWORD flags, const struct wined3d_color *color, float depth, DWORD stencil)
 {
-    const struct wined3d_state *state = &cs->device->state;
+    const struct wined3d_state *state = cs->app_state;
     const struct wined3d_viewport *vp = &state->viewports[0];
     struct wined3d_rendertarget_view *view;
     struct wined3d_cs_clear *op;
@@ -625,12 +919,12 @@ void wined3d_cs_emit_clear(struct wined3d_cs *cs, DWORD rect_count, const RECT *
     for (i = 0; i < rt_count; ++i)
     {
         if ((view = state->fb->render_targets[i]))
-            wined3d_resource_acquire(view->resource);
+            wined3d_cs_acquire_resource(cs, view->resource);
     }
     if (flags & (WINED3DCLEAR_ZBUFFER | WINED3DCLEAR_STENCIL))
     {
         view = state->fb->depth_stencil;
-        wined3d_resource_acquire(view->resource);
+        wined3d_cs_acquire_resource(cs, view->resource);
     }
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
@@ -667,14 +961,15 @@ void wined3d_cs_emit_clear_rendertarget_view(struct wined3d_cs *cs, struct wined
     op->rect_count = 1;
     op->rects[0] = *rect;
 
-    wined3d_resource_acquire(view->resource);
+    wined3d_cs_acquire_resource(cs, view->resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
     if (flags & WINED3DCLEAR_SYNCHRONOUS)
         wined3d_cs_finish(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
 
-static void acquire_shader_resources(const struct wined3d_state *state, unsigned int shader_mask)
+static void acquire_shader_resources(struct wined3d_cs *cs, const struct wined3d_state *state,
+        unsigned int shader_mask)
 {
     struct wined3d_shader_sampler_map_entry *entry;
     struct wined3d_shader_resource_view *view;
@@ -692,7 +987,7 @@ static void acquire_shader_resources(const struct wined3d_state *state, unsigned
         for (j = 0; j < WINED3D_MAX_CBS; ++j)
         {
             if (state->cb[i][j])
-                wined3d_resource_acquire(&state->cb[i][j]->resource);
+                wined3d_cs_acquire_resource(cs, &state->cb[i][j]->resource);
         }
 
         for (j = 0; j < shader->reg_maps.sampler_map.count; ++j)
@@ -702,7 +997,7 @@ static void acquire_shader_resources(const struct wined3d_state *state, unsigned
             if (!(view = state->shader_resource_view[i][entry->resource_idx]))
                 continue;
 
-            wined3d_resource_acquire(view->resource);
+            wined3d_cs_acquire_resource(cs, view->resource);
         }
     }
 }
@@ -740,7 +1035,7 @@ static void release_shader_resources(const struct wined3d_state *state, unsigned
     }
 }
 
-static void acquire_unordered_access_resources(const struct wined3d_shader *shader,
+static void acquire_unordered_access_resources(struct wined3d_cs *cs, const struct wined3d_shader *shader,
         struct wined3d_unordered_access_view * const *views)
 {
     unsigned int i;
@@ -756,7 +1051,7 @@ static void acquire_unordered_access_resources(const struct wined3d_shader *shad
         if (!views[i])
             continue;
 
-        wined3d_resource_acquire(views[i]->resource);
+        wined3d_cs_acquire_resource(cs, views[i]->resource);
     }
 }
 
@@ -795,17 +1090,17 @@ static void wined3d_cs_exec_dispatch(struct wined3d_cs *cs, const void *data)
             state->unordered_access_view[WINED3D_PIPELINE_COMPUTE]);
 }
 
-static void acquire_compute_pipeline_resources(const struct wined3d_state *state)
+static void acquire_compute_pipeline_resources(struct wined3d_cs *cs, const struct wined3d_state *state)
 {
-    acquire_shader_resources(state, 1u << WINED3D_SHADER_TYPE_COMPUTE);
-    acquire_unordered_access_resources(state->shader[WINED3D_SHADER_TYPE_COMPUTE],
+    acquire_shader_resources(cs, state, 1u << WINED3D_SHADER_TYPE_COMPUTE);
+    acquire_unordered_access_resources(cs, state->shader[WINED3D_SHADER_TYPE_COMPUTE],
             state->unordered_access_view[WINED3D_PIPELINE_COMPUTE]);
 }
 
 void wined3d_cs_emit_dispatch(struct wined3d_cs *cs,
         unsigned int group_count_x, unsigned int group_count_y, unsigned int group_count_z)
 {
-    const struct wined3d_state *state = &cs->device->state;
+    const struct wined3d_state *state = cs->app_state;
     struct wined3d_cs_dispatch *op;
 
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
@@ -815,7 +1110,7 @@ void wined3d_cs_emit_dispatch(struct wined3d_cs *cs,
     op->parameters.u.direct.group_count_y = group_count_y;
     op->parameters.u.direct.group_count_z = group_count_z;
 
-    acquire_compute_pipeline_resources(state);
+    acquire_compute_pipeline_resources(cs, state);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -823,7 +1118,7 @@ void wined3d_cs_emit_dispatch(struct wined3d_cs *cs,
 void wined3d_cs_emit_dispatch_indirect(struct wined3d_cs *cs,
         struct wined3d_buffer *buffer, unsigned int offset)
 {
-    const struct wined3d_state *state = &cs->device->state;
+    const struct wined3d_state *state = cs->app_state;
     struct wined3d_cs_dispatch *op;
 
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
@@ -832,8 +1127,8 @@ void wined3d_cs_emit_dispatch_indirect(struct wined3d_cs *cs,
     op->parameters.u.indirect.buffer = buffer;
     op->parameters.u.indirect.offset = offset;
 
-    acquire_compute_pipeline_resources(state);
-    wined3d_resource_acquire(&buffer->resource);
+    acquire_compute_pipeline_resources(cs, state);
+    wined3d_cs_acquire_resource(cs, &buffer->resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -925,37 +1220,37 @@ static void wined3d_cs_exec_draw(struct wined3d_cs *cs, const void *data)
             state->unordered_access_view[WINED3D_PIPELINE_GRAPHICS]);
 }
 
-static void acquire_graphics_pipeline_resources(const struct wined3d_state *state,
+static void acquire_graphics_pipeline_resources(struct wined3d_cs *cs, const struct wined3d_state *state,
         BOOL indexed, const struct wined3d_d3d_info *d3d_info)
 {
     unsigned int i;
 
     if (indexed)
-        wined3d_resource_acquire(&state->index_buffer->resource);
+        wined3d_cs_acquire_resource(cs, &state->index_buffer->resource);
     for (i = 0; i < ARRAY_SIZE(state->streams); ++i)
     {
         if (state->streams[i].buffer)
-            wined3d_resource_acquire(&state->streams[i].buffer->resource);
+            wined3d_cs_acquire_resource(cs, &state->streams[i].buffer->resource);
     }
     for (i = 0; i < ARRAY_SIZE(state->stream_output); ++i)
     {
         if (state->stream_output[i].buffer)
-            wined3d_resource_acquire(&state->stream_output[i].buffer->resource);
+            wined3d_cs_acquire_resource(cs, &state->stream_output[i].buffer->resource);
     }
     for (i = 0; i < ARRAY_SIZE(state->textures); ++i)
     {
         if (state->textures[i])
-            wined3d_resource_acquire(&state->textures[i]->resource);
+            wined3d_cs_acquire_resource(cs, &state->textures[i]->resource);
     }
     for (i = 0; i < d3d_info->limits.max_rt_count; ++i)
     {
         if (state->fb->render_targets[i])
-            wined3d_resource_acquire(state->fb->render_targets[i]->resource);
+            wined3d_cs_acquire_resource(cs, state->fb->render_targets[i]->resource);
     }
     if (state->fb->depth_stencil)
-        wined3d_resource_acquire(state->fb->depth_stencil->resource);
-    acquire_shader_resources(state, ~(1u << WINED3D_SHADER_TYPE_COMPUTE));
-    acquire_unordered_access_resources(state->shader[WINED3D_SHADER_TYPE_PIXEL],
+        wined3d_cs_acquire_resource(cs, state->fb->depth_stencil->resource);
+    acquire_shader_resources(cs, state, ~(1u << WINED3D_SHADER_TYPE_COMPUTE));
+    acquire_unordered_access_resources(cs, state->shader[WINED3D_SHADER_TYPE_PIXEL],
             state->unordered_access_view[WINED3D_PIPELINE_GRAPHICS]);
 }
 
@@ -964,7 +1259,7 @@ void wined3d_cs_emit_draw(struct wined3d_cs *cs, GLenum primitive_type, unsigned
         unsigned int start_instance, unsigned int instance_count, BOOL indexed)
 {
     const struct wined3d_d3d_info *d3d_info = &cs->device->adapter->d3d_info;
-    const struct wined3d_state *state = &cs->device->state;
+    const struct wined3d_state *state = cs->app_state;
     struct wined3d_cs_draw *op;
 
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
@@ -979,7 +1274,7 @@ void wined3d_cs_emit_draw(struct wined3d_cs *cs, GLenum primitive_type, unsigned
     op->parameters.u.direct.instance_count = instance_count;
     op->parameters.indexed = indexed;
 
-    acquire_graphics_pipeline_resources(state, indexed, d3d_info);
+    acquire_graphics_pipeline_resources(cs, state, indexed, d3d_info);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -988,7 +1283,7 @@ void wined3d_cs_emit_draw_indirect(struct wined3d_cs *cs, GLenum primitive_type,
         struct wined3d_buffer *buffer, unsigned int offset, BOOL indexed)
 {
     const struct wined3d_d3d_info *d3d_info = &cs->device->adapter->d3d_info;
-    const struct wined3d_state *state = &cs->device->state;
+    const struct wined3d_state *state = cs->app_state;
     struct wined3d_cs_draw *op;
 
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
@@ -1000,8 +1295,8 @@ void wined3d_cs_emit_draw_indirect(struct wined3d_cs *cs, GLenum primitive_type,
     op->parameters.u.indirect.offset = offset;
     op->parameters.indexed = indexed;
 
-    acquire_graphics_pipeline_resources(state, indexed, d3d_info);
-    wined3d_resource_acquire(&buffer->resource);
+    acquire_graphics_pipeline_resources(cs, state, indexed, d3d_info);
+    wined3d_cs_acquire_resource(cs, &buffer->resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -1599,68 +1894,162 @@ void wined3d_cs_emit_set_rasterizer_state(struct wined3d_cs *cs,
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
 
-static void wined3d_cs_exec_set_render_state(struct wined3d_cs *cs, const void *data)
+static void wined3d_cs_set_render_state(struct wined3d_cs *cs, enum wined3d_render_state state, DWORD value)
 {
-    const struct wined3d_cs_set_render_state *op = data;
+    cs->state.render_states[state] = value;
+    device_invalidate_state(cs->device, STATE_RENDER(state));
+}
 
-    cs->state.render_states[op->state] = op->value;
-    device_invalidate_state(cs->device, STATE_RENDER(op->state));
+static void wined3d_cs_set_texture_state(struct wined3d_cs *cs, unsigned int stage,
+        enum wined3d_texture_stage_state state, DWORD value)
+{
+    cs->state.texture_states[stage][state] = value;
+    device_invalidate_state(cs->device, STATE_TEXTURESTAGE(stage, state));
 }
 
-void wined3d_cs_emit_set_render_state(struct wined3d_cs *cs, enum wined3d_render_state state, DWORD value)
+static void wined3d_cs_set_sampler_state(struct wined3d_cs *cs, unsigned int sampler_idx,
+        enum wined3d_sampler_state state, DWORD value)
 {
-    struct wined3d_cs_set_render_state *op;
+    cs->state.sampler_states[sampler_idx][state] = value;
+    device_invalidate_state(cs->device, STATE_SAMPLER(sampler_idx));
+}
 
-    op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
-    op->opcode = WINED3D_CS_OP_SET_RENDER_STATE;
-    op->state = state;
-    op->value = value;
+static void wined3d_cs_exec_set_render_state(struct wined3d_cs *cs, const void *data)
+{
+    const struct wined3d_cs_set_render_state *op = data;
 
-    wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+    wined3d_cs_set_render_state(cs, op->state, op->value);
 }
 
 static void wined3d_cs_exec_set_texture_state(struct wined3d_cs *cs, const void *data)
 {
     const struct wined3d_cs_set_texture_state *op = data;
 
-    cs->state.texture_states[op->stage][op->state] = op->value;
-    device_invalidate_state(cs->device, STATE_TEXTURESTAGE(op->stage, op->state));
+    wined3d_cs_set_texture_state(cs, op->stage, op->state, op->value);
 }
 
-void wined3d_cs_emit_set_texture_state(struct wined3d_cs *cs, UINT stage,
-        enum wined3d_texture_stage_state state, DWORD value)
+static void wined3d_cs_exec_set_sampler_state(struct wined3d_cs *cs, const void *data)
 {
-    struct wined3d_cs_set_texture_state *op;
+    const struct wined3d_cs_set_sampler_state *op = data;
 
-    op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
-    op->opcode = WINED3D_CS_OP_SET_TEXTURE_STATE;
-    op->stage = stage;
-    op->state = state;
-    op->value = value;
+    wined3d_cs_set_sampler_state(cs, op->sampler_idx, op->state, op->value);
+}
 
-    wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+static void wined3d_cs_exec_set_states(struct wined3d_cs *cs, const void *data)
+{
+    const struct wined3d_cs_set_states *op = data;
+    const struct wined3d_cs_state_change *change;
+    unsigned int i;
+
+    for (i = 0; i < op->count; ++i)
+    {
+        change = &op->changes[i];
+        switch (change->type)
+        {
+            case WINED3D_CS_STATE_CHANGE_RENDER:
+                wined3d_cs_set_render_state(cs, change->state, change->value);
+                break;
+
+            case WINED3D_CS_STATE_CHANGE_TEXTURE:
+                wined3d_cs_set_texture_state(cs, change->idx, change->state, change->value);
+                break;
+
+            case WINED3D_CS_STATE_CHANGE_SAMPLER:
+                wined3d_cs_set_sampler_state(cs, change->idx, change->state, change->value);
+                break;
+
+            default:
+                ERR("Invalid state change type %#x.\n", change->type);
+                break;
+        }
+    }
 }
 
-static void wined3d_cs_exec_set_sampler_state(struct wined3d_cs *cs, const void *data)
+static void wined3d_cs_emit_set_states(struct wined3d_cs *cs,
+        const struct wined3d_cs_state_change *changes, unsigned int count)
 {
-    const struct wined3d_cs_set_sampler_state *op = data;
+    struct wined3d_cs_set_states *op;
 
-    cs->state.sampler_states[op->sampler_idx][op->state] = op->value;
-    device_invalidate_state(cs->device, STATE_SAMPLER(op->sampler_idx));
+    op = cs->ops->require_space(cs, FIELD_OFFSET(struct wined3d_cs_set_states, changes[count]),
+            WINED3D_CS_QUEUE_DEFAULT);
+    op->opcode = WINED3D_CS_OP_SET_STATES;
+    op->count = count;
+    memcpy(op->changes, changes, count * sizeof(*op->changes));
+
+    cs->ops->submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
 
-void wined3d_cs_emit_set_sampler_state(struct wined3d_cs *cs, UINT sampler_idx,
-        enum wined3d_sampler_state state, DWORD value)
+static BOOL wined3d_cs_is_cs_thread(const struct wined3d_cs *cs)
 {
-    struct wined3d_cs_set_sampler_state *op;
+    return cs->thread && cs->thread_id == GetCurrentThreadId();
+}
 
-    op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
-    op->opcode = WINED3D_CS_OP_SET_SAMPLER_STATE;
-    op->sampler_idx = sampler_idx;
-    op->state = state;
-    op->value = value;
+void wined3d_cs_flush_state_changes(struct wined3d_cs *cs)
+{
+    unsigned int count;
 
-    wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+    /* The pending state changes belong to the application thread, packets
+     * emitted by the command stream thread itself don't flush them. */
+    if (wined3d_cs_is_cs_thread(cs) || !(count = cs->state_change_count))
+        return;
+
+    /* The single-threaded submit path executes the packet immediately, and
+     * may end up emitting state changes of its own. */
+    cs->state_change_count = 0;
+    wined3d_cs_emit_set_states(cs, cs->state_changes, count);
+}
+
+static void wined3d_cs_add_state_change(struct wined3d_cs *cs, enum wined3d_cs_state_change_type type,
+        unsigned int idx, unsigned int state, DWORD value)
+{
+    struct wined3d_cs_state_change *change;
+    unsigned int i;
+
+    if (wined3d_cs_is_cs_thread(cs))
+    {
+        struct wined3d_cs_state_change c = {type, idx, state, value};
+
+        wined3d_cs_emit_set_states(cs, &c, 1);
+        return;
+    }
+
+    /* A later change to the same state supersedes an earlier one, nothing
+     * can observe the state in between. */
+    for (i = 0; i < cs->state_change_count; ++i)
+    {
+        change = &cs->state_changes[i];
+        if (change->type == type && change->idx == idx && change->state == state)
+        {
+            change->value = value;
+            return;
+        }
+    }
+
+    if (cs->state_change_count == ARRAY_SIZE(cs->state_changes))
+        wined3d_cs_flush_state_changes(cs);
+
+    change = &cs->state_changes[cs->state_change_count++];
+    change->type = type;
+    change->idx = idx;
+    change->state = state;
+    change->value = value;
+}
+
+void wined3d_cs_emit_set_render_state(struct wined3d_cs *cs, enum wined3d_render_state state, DWORD value)
+{
+    wined3d_cs_add_state_change(cs, WINED3D_CS_STATE_CHANGE_RENDER, 0, state, value);
+}
+
+void wined3d_cs_emit_set_texture_state(struct wined3d_cs *cs, UINT stage,
+        enum wined3d_texture_stage_state state, DWORD value)
+{
+    wined3d_cs_add_state_change(cs, WINED3D_CS_STATE_CHANGE_TEXTURE, stage, state, value);
+}
+
+void wined3d_cs_emit_set_sampler_state(struct wined3d_cs *cs, UINT sampler_idx,
+        enum wined3d_sampler_state state, DWORD value)
+{
+    wined3d_cs_add_state_change(cs, WINED3D_CS_STATE_CHANGE_SAMPLER, sampler_idx, state, value);
 }
 
 static void wined3d_cs_exec_set_transform(struct wined3d_cs *cs, const void *data)
@@ -2077,7 +2466,7 @@ void wined3d_cs_emit_preload_resource(struct wined3d_cs *cs, struct wined3d_reso
     op->opcode = WINED3D_CS_OP_PRELOAD_RESOURCE;
     op->resource = resource;
 
-    wined3d_resource_acquire(resource);
+    wined3d_cs_acquire_resource(cs, resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -2099,7 +2488,7 @@ void wined3d_cs_emit_unload_resource(struct wined3d_cs *cs, struct wined3d_resou
     op->opcode = WINED3D_CS_OP_UNLOAD_RESOURCE;
     op->resource = resource;
 
-    wined3d_resource_acquire(resource);
+    wined3d_cs_acquire_resource(cs, resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -2117,12 +2506,16 @@ HRESULT wined3d_cs_map(struct wined3d_cs *cs, struct wined3d_resource *resource,
         struct wined3d_map_desc *map_desc, const struct wined3d_box *box, unsigned int flags)
 {
     struct wined3d_cs_map *op;
+    LONGLONG start = 0;
     HRESULT hr;
 
     /* Mapping resources from the worker thread isn't an issue by itself, but
      * increasing the map count would be visible to applications. */
     wined3d_not_from_cs(cs);
 
+    if (cs->profiler)
+        start = wined3d_cs_profiler_time();
+
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_MAP);
     op->opcode = WINED3D_CS_OP_MAP;
     op->resource = resource;
@@ -2135,6 +2528,10 @@ HRESULT wined3d_cs_map(struct wined3d_cs *cs, struct wined3d_resource *resource,
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_MAP);
     wined3d_cs_finish(cs, WINED3D_CS_QUEUE_MAP);
 
+    if (cs->profiler)
+        wined3d_cs_profiler_add_span(cs->profiler, resource->type == WINED3D_RTYPE_BUFFER
+                ? "map buffer" : "map texture", "app", start, wined3d_cs_profiler_time());
+
     return hr;
 }
 
@@ -2287,9 +2684,9 @@ void wined3d_cs_emit_blt_sub_resource(struct wined3d_cs *cs, struct wined3d_reso
         memset(&op->fx, 0, sizeof(op->fx));
     op->filter = filter;
 
-    wined3d_resource_acquire(dst_resource);
+    wined3d_cs_acquire_resource(cs, dst_resource);
     if (src_resource)
-        wined3d_resource_acquire(src_resource);
+        wined3d_cs_acquire_resource(cs, src_resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
     if (flags & WINED3D_BLT_SYNCHRONOUS)
@@ -2370,7 +2767,7 @@ void wined3d_cs_emit_update_sub_resource(struct wined3d_cs *cs, struct wined3d_r
     op->data.slice_pitch = slice_pitch;
     op->data.data = data;
 
-    wined3d_resource_acquire(resource);
+    wined3d_cs_acquire_resource(cs, resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_MAP);
     /* The data pointer may go away, so we need to wait until it is read.
@@ -2409,7 +2806,7 @@ void wined3d_cs_emit_add_dirty_texture_region(struct wined3d_cs *cs,
     op->texture = texture;
     op->layer = layer;
 
-    wined3d_resource_acquire(&texture->resource);
+    wined3d_cs_acquire_resource(cs, &texture->resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -2437,7 +2834,7 @@ void wined3d_cs_emit_clear_unordered_access_view_uint(struct wined3d_cs *cs,
     op->view = view;
     op->clear_value = *clear_value;
 
-    wined3d_resource_acquire(view->resource);
+    wined3d_cs_acquire_resource(cs, view->resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -2466,7 +2863,7 @@ void wined3d_cs_emit_copy_uav_counter(struct wined3d_cs *cs, struct wined3d_buff
     op->offset = offset;
     op->view = uav;
 
-    wined3d_resource_acquire(&dst_buffer->resource);
+    wined3d_cs_acquire_resource(cs, &dst_buffer->resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -2488,7 +2885,7 @@ void wined3d_cs_emit_generate_mipmaps(struct wined3d_cs *cs, struct wined3d_shad
     op->opcode = WINED3D_CS_OP_GENERATE_MIPMAPS;
     op->view = view;
 
-    wined3d_resource_acquire(view->resource);
+    wined3d_cs_acquire_resource(cs, view->resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -2504,6 +2901,8 @@ static void wined3d_cs_emit_stop(struct wined3d_cs *cs)
     wined3d_cs_finish(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
 
+static void wined3d_cs_exec_execute_command_list(struct wined3d_cs *cs, const void *data);
+
 static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void *data) =
 {
     /* WINED3D_CS_OP_NOP                         */ wined3d_cs_exec_nop,
@@ -2533,6 +2932,7 @@ static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void
     /* WINED3D_CS_OP_SET_RENDER_STATE            */ wined3d_cs_exec_set_render_state,
     /* WINED3D_CS_OP_SET_TEXTURE_STATE           */ wined3d_cs_exec_set_texture_state,
     /* WINED3D_CS_OP_SET_SAMPLER_STATE           */ wined3d_cs_exec_set_sampler_state,
+    /* WINED3D_CS_OP_SET_STATES                  */ wined3d_cs_exec_set_states,
     /* WINED3D_CS_OP_SET_TRANSFORM               */ wined3d_cs_exec_set_transform,
     /* WINED3D_CS_OP_SET_CLIP_PLANE              */ wined3d_cs_exec_set_clip_plane,
     /* WINED3D_CS_OP_SET_COLOR_KEY               */ wined3d_cs_exec_set_color_key,
@@ -2553,6 +2953,7 @@ static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void
     /* WINED3D_CS_OP_CLEAR_UNORDERED_ACCESS_VIEW */ wined3d_cs_exec_clear_unordered_access_view,
     /* WINED3D_CS_OP_COPY_UAV_COUNTER            */ wined3d_cs_exec_copy_uav_counter,
     /* WINED3D_CS_OP_GENERATE_MIPMAPS            */ wined3d_cs_exec_generate_mipmaps,
+    /* WINED3D_CS_OP_EXECUTE_COMMAND_LIST        */ wined3d_cs_exec_execute_command_list,
 };
 
 static void *wined3d_cs_st_require_space(struct wined3d_cs *cs, size_t size, enum wined3d_cs_queue_id queue_id)
@@ -2592,9 +2993,22 @@ static void wined3d_cs_st_submit(struct wined3d_cs *cs, enum wined3d_cs_queue_id
 
     opcode = *(const enum wined3d_cs_op *)&data[start];
     if (opcode >= WINED3D_CS_OP_STOP)
+    {
         ERR("Invalid opcode %#x.\n", opcode);
+    }
+    else if (cs->profiler)
+    {
+        LONGLONG time = wined3d_cs_profiler_time();
+
+        wined3d_cs_count_packet(cs, opcode, cs->start - start);
+        wined3d_cs_op_handlers[opcode](cs, &data[start]);
+        wined3d_cs_profiler_add_span(cs->profiler, debug_cs_op(opcode), "cs", time, wined3d_cs_profiler_time());
+    }
     else
+    {
+        wined3d_cs_count_packet(cs, opcode, cs->start - start);
         wined3d_cs_op_handlers[opcode](cs, &data[start]);
+    }
 
     if (cs->data == data)
         cs->start = cs->end = start;
@@ -2606,12 +3020,18 @@ static void wined3d_cs_st_finish(struct wined3d_cs *cs, enum wined3d_cs_queue_id
 {
 }
 
+static void wined3d_cs_st_acquire_resource(struct wined3d_cs *cs, struct wined3d_resource *resource)
+{
+    wined3d_resource_acquire(resource);
+}
+
 static const struct wined3d_cs_ops wined3d_cs_st_ops =
 {
     wined3d_cs_st_require_space,
     wined3d_cs_st_submit,
     wined3d_cs_st_finish,
     wined3d_cs_st_push_constants,
+    wined3d_cs_st_acquire_resource,
 };
 
 static BOOL wined3d_cs_queue_is_empty(const struct wined3d_cs *cs, const struct wined3d_cs_queue *queue)
@@ -2635,10 +3055,19 @@ static void wined3d_cs_queue_submit(struct wined3d_cs_queue *queue, struct wined
 
 static void wined3d_cs_mt_submit(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id)
 {
+    struct wined3d_cs_profiler *profiler;
+
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_submit(cs, queue_id);
 
     wined3d_cs_queue_submit(&cs->queue[queue_id], cs);
+
+    /* This includes time spent waiting for queue space. */
+    if ((profiler = cs->profiler))
+    {
+        profiler->emit_time += wined3d_cs_profiler_time() - profiler->emit_start;
+        ++profiler->emit_count;
+    }
 }
 
 static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size_t size, struct wined3d_cs *cs)
@@ -2646,6 +3075,7 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
     size_t queue_size = ARRAY_SIZE(queue->data);
     size_t header_size, packet_size, remaining;
     struct wined3d_cs_packet *packet;
+    LONGLONG wait_start = 0;
 
     header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
     size = (size + header_size - 1) & ~(header_size - 1);
@@ -2693,10 +3123,16 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
         if (new_pos < tail && new_pos)
             break;
 
+        if (cs->profiler && !wait_start)
+            wait_start = wined3d_cs_profiler_time();
+
         TRACE("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
                 head, tail, (unsigned long)packet_size);
     }
 
+    if (wait_start)
+        wined3d_cs_profiler_add_span(cs->profiler, "queue wait", "app", wait_start, wined3d_cs_profiler_time());
+
     packet = (struct wined3d_cs_packet *)&queue->data[queue->head];
     packet->size = size;
     return packet->data;
@@ -2707,14 +3143,28 @@ static void *wined3d_cs_mt_require_space(struct wined3d_cs *cs, size_t size, enu
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_require_space(cs, size, queue_id);
 
+    if (cs->profiler)
+        cs->profiler->emit_start = wined3d_cs_profiler_time();
+
     return wined3d_cs_queue_require_space(&cs->queue[queue_id], size, cs);
 }
 
 static void wined3d_cs_mt_finish(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id)
 {
+    LONGLONG start;
+
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_finish(cs, queue_id);
 
+    if (cs->profiler && cs->queue[queue_id].head != *(volatile LONG *)&cs->queue[queue_id].tail)
+    {
+        start = wined3d_cs_profiler_time();
+        while (cs->queue[queue_id].head != *(volatile LONG *)&cs->queue[queue_id].tail)
+            wined3d_pause();
+        wined3d_cs_profiler_add_span(cs->profiler, "finish", "app", start, wined3d_cs_profiler_time());
+        return;
+    }
+
     while (cs->queue[queue_id].head != *(volatile LONG *)&cs->queue[queue_id].tail)
         wined3d_pause();
 }
@@ -2725,6 +3175,7 @@ static const struct wined3d_cs_ops wined3d_cs_mt_ops =
     wined3d_cs_mt_submit,
     wined3d_cs_mt_finish,
     wined3d_cs_mt_push_constants,
+    wined3d_cs_st_acquire_resource,
 };
 
 static void poll_queries(struct wined3d_cs *cs)
@@ -2767,6 +3218,7 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
     struct wined3d_cs_queue *queue;
     unsigned int spin_count = 0;
     struct wined3d_cs *cs = ctx;
+    LONGLONG idle_start = 0, time;
     enum wined3d_cs_op opcode;
     HMODULE wined3d_module;
     unsigned int poll = 0;
@@ -2794,13 +3246,34 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
             queue = &cs->queue[WINED3D_CS_QUEUE_DEFAULT];
             if (wined3d_cs_queue_is_empty(cs, queue))
             {
+                if (cs->profiler && !idle_start)
+                    idle_start = wined3d_cs_profiler_time();
                 if (++spin_count >= WINED3D_CS_SPIN_COUNT && list_empty(&cs->query_poll_list))
-                    wined3d_cs_wait_event(cs);
+                {
+                    if (idle_start)
+                    {
+                        time = wined3d_cs_profiler_time();
+                        wined3d_cs_profiler_add_span(cs->profiler, "spin", "cs", idle_start, time);
+                        wined3d_cs_wait_event(cs);
+                        idle_start = wined3d_cs_profiler_time();
+                        wined3d_cs_profiler_add_span(cs->profiler, "wait", "cs", time, idle_start);
+                    }
+                    else
+                    {
+                        wined3d_cs_wait_event(cs);
+                    }
+                }
                 continue;
             }
         }
         spin_count = 0;
 
+        if (idle_start)
+        {
+            wined3d_cs_profiler_add_span(cs->profiler, "spin", "cs", idle_start, wined3d_cs_profiler_time());
+            idle_start = 0;
+        }
+
         tail = queue->tail;
         packet = (struct wined3d_cs_packet *)&queue->data[tail];
         if (packet->size)
@@ -2815,7 +3288,18 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
                 break;
             }
 
-            wined3d_cs_op_handlers[opcode](cs, packet->data);
+            wined3d_cs_count_packet(cs, opcode, FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]));
+            if (cs->profiler)
+            {
+                time = wined3d_cs_profiler_time();
+                wined3d_cs_op_handlers[opcode](cs, packet->data);
+                wined3d_cs_profiler_add_span(cs->profiler, debug_cs_op(opcode), "cs",
+                        time, wined3d_cs_profiler_time());
+            }
+            else
+            {
+                wined3d_cs_op_handlers[opcode](cs, packet->data);
+            }
             TRACE("%s executed.\n", debug_cs_op(opcode));
         }
 
@@ -2840,9 +3324,14 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
 
     cs->ops = &wined3d_cs_st_ops;
     cs->device = device;
+    cs->app_state = &device->state;
+    cs->profiler = wined3d_cs_profiler_create();
 
     state_init(&cs->state, &cs->fb, d3d_info, WINED3D_STATE_NO_REF | WINED3D_STATE_INIT_DEFAULT);
 
+    if (!(cs->saved_state = heap_alloc(sizeof(*cs->saved_state))))
+        goto fail;
+
     cs->data_size = WINED3D_INITIAL_CS_SIZE;
     if (!(cs->data = heap_alloc(cs->data_size)))
         goto fail;
@@ -2852,9 +3341,17 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
     {
         cs->ops = &wined3d_cs_mt_ops;
 
+        if (!(cs->queue = heap_alloc_zero(WINED3D_CS_QUEUE_COUNT * sizeof(*cs->queue))))
+        {
+            ERR("Failed to allocate command stream queues.\n");
+            heap_free(cs->data);
+            goto fail;
+        }
+
         if (!(cs->event = CreateEventW(NULL, FALSE, FALSE, NULL)))
         {
             ERR("Failed to create command stream event.\n");
+            heap_free(cs->queue);
             heap_free(cs->data);
             goto fail;
         }
@@ -2864,6 +3361,7 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
         {
             ERR("Failed to get wined3d module handle.\n");
             CloseHandle(cs->event);
+            heap_free(cs->queue);
             heap_free(cs->data);
             goto fail;
         }
@@ -2873,6 +3371,7 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
             ERR("Failed to create wined3d command stream thread.\n");
             FreeLibrary(cs->wined3d_module);
             CloseHandle(cs->event);
+            heap_free(cs->queue);
             heap_free(cs->data);
             goto fail;
         }
@@ -2882,6 +3381,8 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
 
 fail:
     state_cleanup(&cs->state);
+    heap_free(cs->saved_state);
+    heap_free(cs->profiler);
     heap_free(cs);
     return NULL;
 }
@@ -2896,7 +3397,1340 @@ void wined3d_cs_destroy(struct wined3d_cs *cs)
             ERR("Closing event failed.\n");
     }
 
+    if (cs->profiler)
+    {
+        if (!cs->profiler->written)
+            wined3d_cs_profiler_dump(cs->profiler);
+        heap_free(cs->profiler);
+    }
+
     state_cleanup(&cs->state);
+    heap_free(cs->saved_state);
+    heap_free(cs->queue);
     heap_free(cs->data);
     heap_free(cs);
 }
+
+#define WINED3D_COMMAND_LIST_CHUNK_SIZE 0x10000
+
+struct wined3d_command_list_chunk
+{
+    struct wined3d_command_list_chunk *next;
+    size_t size, used;
+    BYTE data[1];
+};
+
+enum wined3d_command_list_object_type
+{
+    WINED3D_COMMAND_LIST_OBJECT_BLEND_STATE,
+    WINED3D_COMMAND_LIST_OBJECT_BUFFER,
+    WINED3D_COMMAND_LIST_OBJECT_QUERY,
+    WINED3D_COMMAND_LIST_OBJECT_RASTERIZER_STATE,
+    WINED3D_COMMAND_LIST_OBJECT_RENDERTARGET_VIEW,
+    WINED3D_COMMAND_LIST_OBJECT_SAMPLER,
+    WINED3D_COMMAND_LIST_OBJECT_SHADER,
+    WINED3D_COMMAND_LIST_OBJECT_SHADER_RESOURCE_VIEW,
+    WINED3D_COMMAND_LIST_OBJECT_TEXTURE,
+    WINED3D_COMMAND_LIST_OBJECT_UNORDERED_ACCESS_VIEW,
+    WINED3D_COMMAND_LIST_OBJECT_VERTEX_DECLARATION,
+};
+
+struct wined3d_command_list_object
+{
+    enum wined3d_command_list_object_type type;
+    void *object;
+};
+
+/* Everything a recorded packet stream depends on. The packets are stored in
+ * fixed chunks, since packets may point into themselves. */
+struct wined3d_command_list_data
+{
+    struct wined3d_command_list_chunk *head, *tail;
+
+    /* Resources acquired by the recorded emitters. These are acquired again
+     * each time the list is executed, and released by the packet handlers. */
+    struct wined3d_resource **resources;
+    SIZE_T resources_size;
+    SIZE_T resource_count;
+
+    struct wined3d_command_list_object *objects;
+    SIZE_T objects_size;
+    SIZE_T object_count;
+
+    void **uploads;
+    SIZE_T uploads_size;
+    SIZE_T upload_count;
+
+    /* Queries ended by the recording. Their main counter is advanced each
+     * time the list is executed, like wined3d_query_issue() does. */
+    struct wined3d_query **queries;
+    SIZE_T queries_size;
+    SIZE_T query_count;
+};
+
+struct wined3d_command_list
+{
+    LONG refcount;
+    struct wined3d_device *device;
+    struct wined3d_command_list_data data;
+};
+
+/* A sub-resource mapped on a deferred context. The memory is part of the
+ * recording's upload data, and is uploaded to the resource on unmap. */
+struct wined3d_deferred_map
+{
+    struct wined3d_resource *resource;
+    unsigned int sub_resource_idx;
+    struct wined3d_map_desc map_desc;
+    BOOL mapped;
+};
+
+struct wined3d_deferred_context
+{
+    struct wined3d_cs cs;
+    struct wined3d_command_list_data data;
+    DWORD changed_render_states[(WINEHIGHEST_RENDER_STATE >> 5) + 1];
+
+    struct wined3d_deferred_map *maps;
+    SIZE_T maps_size;
+    SIZE_T map_count;
+};
+
+static inline struct wined3d_deferred_context *wined3d_deferred_context_from_cs(struct wined3d_cs *cs)
+{
+    return CONTAINING_RECORD(cs, struct wined3d_deferred_context, cs);
+}
+
+static void wined3d_command_list_object_incref(const struct wined3d_command_list_object *object)
+{
+    switch (object->type)
+    {
+        case WINED3D_COMMAND_LIST_OBJECT_BLEND_STATE:
+            wined3d_blend_state_incref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_BUFFER:
+            wined3d_buffer_incref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_QUERY:
+            wined3d_query_incref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_RASTERIZER_STATE:
+            wined3d_rasterizer_state_incref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_RENDERTARGET_VIEW:
+            wined3d_rendertarget_view_incref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_SAMPLER:
+            wined3d_sampler_incref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_SHADER:
+            wined3d_shader_incref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_SHADER_RESOURCE_VIEW:
+            wined3d_shader_resource_view_incref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_TEXTURE:
+            wined3d_texture_incref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_UNORDERED_ACCESS_VIEW:
+            wined3d_unordered_access_view_incref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_VERTEX_DECLARATION:
+            wined3d_vertex_declaration_incref(object->object);
+            break;
+    }
+}
+
+static void wined3d_command_list_object_decref(const struct wined3d_command_list_object *object)
+{
+    switch (object->type)
+    {
+        case WINED3D_COMMAND_LIST_OBJECT_BLEND_STATE:
+            wined3d_blend_state_decref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_BUFFER:
+            wined3d_buffer_decref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_QUERY:
+            wined3d_query_decref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_RASTERIZER_STATE:
+            wined3d_rasterizer_state_decref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_RENDERTARGET_VIEW:
+            wined3d_rendertarget_view_decref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_SAMPLER:
+            wined3d_sampler_decref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_SHADER:
+            wined3d_shader_decref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_SHADER_RESOURCE_VIEW:
+            wined3d_shader_resource_view_decref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_TEXTURE:
+            wined3d_texture_decref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_UNORDERED_ACCESS_VIEW:
+            wined3d_unordered_access_view_decref(object->object);
+            break;
+        case WINED3D_COMMAND_LIST_OBJECT_VERTEX_DECLARATION:
+            wined3d_vertex_declaration_decref(object->object);
+            break;
+    }
+}
+
+static void wined3d_command_list_data_release_objects(struct wined3d_command_list_data *data)
+{
+    SIZE_T i;
+
+    for (i = 0; i < data->object_count; ++i)
+    {
+        wined3d_command_list_object_decref(&data->objects[i]);
+    }
+    data->object_count = 0;
+}
+
+static void wined3d_command_list_data_cleanup(struct wined3d_command_list_data *data)
+{
+    struct wined3d_command_list_chunk *chunk, *next;
+    SIZE_T i;
+
+    for (chunk = data->head; chunk; chunk = next)
+    {
+        next = chunk->next;
+        heap_free(chunk);
+    }
+    for (i = 0; i < data->upload_count; ++i)
+    {
+        heap_free(data->uploads[i]);
+    }
+    heap_free(data->uploads);
+    heap_free(data->queries);
+    heap_free(data->objects);
+    heap_free(data->resources);
+}
+
+static void wined3d_cs_invalidate_all_states(struct wined3d_cs *cs)
+{
+    const struct wined3d_d3d_info *d3d_info = &cs->device->adapter->d3d_info;
+    struct wined3d_device *device = cs->device;
+    unsigned int i;
+
+    for (i = 0; i <= STATE_HIGHEST; ++i)
+    {
+        if (STATE_IS_COMPUTE(i) || device->state_table[i].representative)
+            device_invalidate_state(device, i);
+    }
+    for (i = 0; i < device->context_count; ++i)
+    {
+        device->contexts[i]->constant_update_mask = ~0u;
+    }
+    device->shader_backend->shader_update_float_vertex_constants(device, 0, d3d_info->limits.vs_uniform_count);
+    device->shader_backend->shader_update_float_pixel_constants(device, 0, d3d_info->limits.ps_uniform_count);
+}
+
+static void wined3d_cs_exec_execute_command_list(struct wined3d_cs *cs, const void *data)
+{
+    const struct wined3d_cs_execute_command_list *op = data;
+    const struct wined3d_d3d_info *d3d_info = &cs->device->adapter->d3d_info;
+    struct wined3d_state *saved_state = cs->saved_state;
+    const struct wined3d_command_list_chunk *chunk;
+    const struct wined3d_cs_packet *packet;
+    enum wined3d_cs_op opcode;
+    unsigned int i;
+    size_t offset;
+
+    /* Command lists always start from the default state, and leave the
+     * state of the command stream they're executed on untouched. */
+    *saved_state = cs->state;
+    for (i = 0; i < LIGHTMAP_SIZE; ++i)
+    {
+        list_init(&saved_state->light_state.light_map[i]);
+        list_move_tail(&saved_state->light_state.light_map[i], &cs->state.light_state.light_map[i]);
+    }
+    cs->saved_fb = cs->fb;
+
+    memset(&cs->fb, 0, sizeof(cs->fb));
+    memset(&cs->state, 0, sizeof(cs->state));
+    state_init(&cs->state, &cs->fb, d3d_info, WINED3D_STATE_NO_REF | WINED3D_STATE_INIT_DEFAULT);
+    wined3d_cs_invalidate_all_states(cs);
+
+    for (chunk = op->list->data.head; chunk; chunk = chunk->next)
+    {
+        for (offset = 0; offset < chunk->used; offset += FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]))
+        {
+            packet = (const struct wined3d_cs_packet *)&chunk->data[offset];
+            opcode = *(const enum wined3d_cs_op *)packet->data;
+
+            TRACE("Executing recorded %s.\n", debug_cs_op(opcode));
+            wined3d_cs_count_packet(cs, opcode, FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]));
+            wined3d_cs_op_handlers[opcode](cs, packet->data);
+        }
+    }
+
+    state_cleanup(&cs->state);
+    cs->state = *saved_state;
+    for (i = 0; i < LIGHTMAP_SIZE; ++i)
+    {
+        list_init(&cs->state.light_state.light_map[i]);
+        list_move_tail(&cs->state.light_state.light_map[i], &saved_state->light_state.light_map[i]);
+    }
+    cs->fb = cs->saved_fb;
+    wined3d_cs_invalidate_all_states(cs);
+}
+
+void wined3d_cs_emit_execute_command_list(struct wined3d_cs *cs, struct wined3d_command_list *list)
+{
+    struct wined3d_cs_execute_command_list *op;
+    SIZE_T i;
+
+    op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
+    op->opcode = WINED3D_CS_OP_EXECUTE_COMMAND_LIST;
+    op->list = list;
+
+    for (i = 0; i < list->data.resource_count; ++i)
+    {
+        wined3d_cs_acquire_resource(cs, list->data.resources[i]);
+    }
+    for (i = 0; i < list->data.query_count; ++i)
+    {
+        ++list->data.queries[i]->counter_main;
+        list->data.queries[i]->state = QUERY_SIGNALLED;
+    }
+
+    wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+    cs->queries_flushed = FALSE;
+}
+
+static void *wined3d_deferred_context_require_space(struct wined3d_cs *cs,
+        size_t size, enum wined3d_cs_queue_id queue_id)
+{
+    struct wined3d_deferred_context *context = wined3d_deferred_context_from_cs(cs);
+    struct wined3d_command_list_chunk *chunk = context->data.tail;
+    size_t header_size, packet_size, chunk_size;
+    struct wined3d_cs_packet *packet;
+
+    header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
+    size = (size + header_size - 1) & ~(header_size - 1);
+    packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[size]);
+
+    if (!chunk || chunk->size - chunk->used < packet_size)
+    {
+        chunk_size = max(packet_size, WINED3D_COMMAND_LIST_CHUNK_SIZE);
+        if (!(chunk = heap_alloc(FIELD_OFFSET(struct wined3d_command_list_chunk, data[chunk_size]))))
+        {
+            ERR("Failed to allocate command list chunk.\n");
+            return NULL;
+        }
+        chunk->next = NULL;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+
+        if (context->data.tail)
+            context->data.tail->next = chunk;
+        else
+            context->data.head = chunk;
+        context->data.tail = chunk;
+    }
+
+    packet = (struct wined3d_cs_packet *)&chunk->data[chunk->used];
+    packet->size = size;
+    chunk->used += packet_size;
+
+    return packet->data;
+}
+
+static void wined3d_deferred_context_submit(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id)
+{
+}
+
+static void wined3d_deferred_context_finish(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id)
+{
+}
+
+static void wined3d_deferred_context_acquire_resource(struct wined3d_cs *cs, struct wined3d_resource *resource)
+{
+    struct wined3d_command_list_data *data = &wined3d_deferred_context_from_cs(cs)->data;
+
+    if (!wined3d_array_reserve((void **)&data->resources, &data->resources_size,
+            data->resource_count + 1, sizeof(*data->resources)))
+    {
+        ERR("Failed to record resource %p.\n", resource);
+        return;
+    }
+
+    data->resources[data->resource_count++] = resource;
+}
+
+static const struct wined3d_cs_ops wined3d_deferred_context_ops =
+{
+    wined3d_deferred_context_require_space,
+    wined3d_deferred_context_submit,
+    wined3d_deferred_context_finish,
+    wined3d_cs_mt_push_constants,
+    wined3d_deferred_context_acquire_resource,
+};
+
+static void wined3d_deferred_context_add_object(struct wined3d_deferred_context *context,
+        enum wined3d_command_list_object_type type, void *object)
+{
+    struct wined3d_command_list_data *data = &context->data;
+    struct wined3d_command_list_object *entry;
+
+    if (!object)
+        return;
+
+    if (!wined3d_array_reserve((void **)&data->objects, &data->objects_size,
+            data->object_count + 1, sizeof(*data->objects)))
+    {
+        ERR("Failed to record object %p.\n", object);
+        return;
+    }
+
+    entry = &data->objects[data->object_count++];
+    entry->type = type;
+    entry->object = object;
+    wined3d_command_list_object_incref(entry);
+}
+
+static void wined3d_deferred_context_add_resource(struct wined3d_deferred_context *context,
+        struct wined3d_resource *resource)
+{
+    if (resource->type == WINED3D_RTYPE_BUFFER)
+        wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_BUFFER,
+                buffer_from_resource(resource));
+    else
+        wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_TEXTURE,
+                texture_from_resource(resource));
+}
+
+/* Emit the current state of the context into its (empty) packet stream, so
+ * that a command list recorded from here on starts from that state. */
+static void wined3d_deferred_context_emit_state(struct wined3d_deferred_context *context)
+{
+    const struct wined3d_d3d_info *d3d_info = &context->cs.device->adapter->d3d_info;
+    struct wined3d_state *state = &context->cs.state;
+    struct wined3d_cs *cs = &context->cs;
+    unsigned int i, j;
+
+    for (i = 0; i < WINED3D_SHADER_TYPE_COUNT; ++i)
+    {
+        if (state->shader[i])
+        {
+            wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_SHADER, state->shader[i]);
+            wined3d_cs_emit_set_shader(cs, i, state->shader[i]);
+        }
+        for (j = 0; j < MAX_CONSTANT_BUFFERS; ++j)
+        {
+            if (!state->cb[i][j])
+                continue;
+            wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_BUFFER, state->cb[i][j]);
+            wined3d_cs_emit_set_constant_buffer(cs, i, j, state->cb[i][j]);
+        }
+        for (j = 0; j < MAX_SHADER_RESOURCE_VIEWS; ++j)
+        {
+            if (!state->shader_resource_view[i][j])
+                continue;
+            wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_SHADER_RESOURCE_VIEW,
+                    state->shader_resource_view[i][j]);
+            wined3d_cs_emit_set_shader_resource_view(cs, i, j, state->shader_resource_view[i][j]);
+        }
+        for (j = 0; j < MAX_SAMPLER_OBJECTS; ++j)
+        {
+            if (!state->sampler[i][j])
+                continue;
+            wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_SAMPLER, state->sampler[i][j]);
+            wined3d_cs_emit_set_sampler(cs, i, j, state->sampler[i][j]);
+        }
+    }
+
+    if (state->vertex_declaration)
+    {
+        wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_VERTEX_DECLARATION,
+                state->vertex_declaration);
+        wined3d_cs_emit_set_vertex_declaration(cs, state->vertex_declaration);
+    }
+    for (i = 0; i < ARRAY_SIZE(state->streams); ++i)
+    {
+        struct wined3d_stream_state *stream = &state->streams[i];
+
+        if (!stream->buffer && !stream->offset && !stream->stride)
+            continue;
+        wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_BUFFER, stream->buffer);
+        wined3d_cs_emit_set_stream_source(cs, i, stream->buffer, stream->offset, stream->stride);
+    }
+    if (state->index_buffer)
+    {
+        wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_BUFFER, state->index_buffer);
+        wined3d_cs_emit_set_index_buffer(cs, state->index_buffer, state->index_format, state->index_offset);
+    }
+
+    for (i = 0; i < d3d_info->limits.max_rt_count; ++i)
+    {
+        if (!cs->fb.render_targets[i])
+            continue;
+        wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_RENDERTARGET_VIEW,
+                cs->fb.render_targets[i]);
+        wined3d_cs_emit_set_rendertarget_view(cs, i, cs->fb.render_targets[i]);
+    }
+    if (cs->fb.depth_stencil)
+    {
+        wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_RENDERTARGET_VIEW,
+                cs->fb.depth_stencil);
+        wined3d_cs_emit_set_depth_stencil_view(cs, cs->fb.depth_stencil);
+    }
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_BLEND_STATE, state->blend_state);
+    wined3d_cs_emit_set_blend_state(cs, state->blend_state, &state->blend_factor);
+    if (state->rasterizer_state)
+    {
+        wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_RASTERIZER_STATE,
+                state->rasterizer_state);
+        wined3d_cs_emit_set_rasterizer_state(cs, state->rasterizer_state);
+    }
+    for (i = 0; i < WINED3D_MAX_STREAM_OUTPUT_BUFFERS; ++i)
+    {
+        if (!state->stream_output[i].buffer)
+            continue;
+        wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_BUFFER,
+                state->stream_output[i].buffer);
+        wined3d_cs_emit_set_stream_output(cs, i, state->stream_output[i].buffer, state->stream_output[i].offset);
+    }
+    if (state->predicate)
+    {
+        wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_QUERY, state->predicate);
+        wined3d_cs_emit_set_predication(cs, state->predicate, state->predicate_value);
+    }
+    for (i = 0; i <= WINEHIGHEST_RENDER_STATE; ++i)
+    {
+        if (context->changed_render_states[i >> 5] & (1u << (i & 0x1f)))
+            wined3d_cs_emit_set_render_state(cs, i, state->render_states[i]);
+    }
+    wined3d_cs_emit_set_viewports(cs, state->viewport_count, state->viewports);
+    wined3d_cs_emit_set_scissor_rects(cs, state->scissor_rect_count, state->scissor_rects);
+}
+
+static void wined3d_deferred_context_reset_state(struct wined3d_deferred_context *context)
+{
+    const struct wined3d_d3d_info *d3d_info = &context->cs.device->adapter->d3d_info;
+
+    state_cleanup(&context->cs.state);
+    memset(&context->cs.fb, 0, sizeof(context->cs.fb));
+    memset(&context->cs.state, 0, sizeof(context->cs.state));
+    state_init(&context->cs.state, &context->cs.fb, d3d_info, WINED3D_STATE_NO_REF | WINED3D_STATE_INIT_DEFAULT);
+    memset(context->changed_render_states, 0, sizeof(context->changed_render_states));
+}
+
+HRESULT CDECL wined3d_deferred_context_create(struct wined3d_device *device,
+        struct wined3d_deferred_context **context)
+{
+    struct wined3d_deferred_context *object;
+
+    TRACE("device %p, context %p.\n", device, context);
+
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+        return E_OUTOFMEMORY;
+
+    object->cs.ops = &wined3d_deferred_context_ops;
+    object->cs.device = device;
+    object->cs.app_state = &object->cs.state;
+    state_init(&object->cs.state, &object->cs.fb, &device->adapter->d3d_info,
+            WINED3D_STATE_NO_REF | WINED3D_STATE_INIT_DEFAULT);
+
+    TRACE("Created deferred context %p.\n", object);
+    *context = object;
+
+    return WINED3D_OK;
+}
+
+void CDECL wined3d_deferred_context_destroy(struct wined3d_deferred_context *context)
+{
+    TRACE("context %p.\n", context);
+
+    wined3d_command_list_data_release_objects(&context->data);
+    wined3d_command_list_data_cleanup(&context->data);
+    state_cleanup(&context->cs.state);
+    heap_free(context->maps);
+    heap_free(context);
+}
+
+void CDECL wined3d_deferred_context_set_shader(struct wined3d_deferred_context *context,
+        enum wined3d_shader_type type, struct wined3d_shader *shader)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, type %#x, shader %p.\n", context, type, shader);
+
+    if (state->shader[type] == shader)
+        return;
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_SHADER, shader);
+    state->shader[type] = shader;
+    wined3d_cs_emit_set_shader(&context->cs, type, shader);
+}
+
+void CDECL wined3d_deferred_context_set_constant_buffer(struct wined3d_deferred_context *context,
+        enum wined3d_shader_type type, unsigned int idx, struct wined3d_buffer *buffer)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, type %#x, idx %u, buffer %p.\n", context, type, idx, buffer);
+
+    if (idx >= MAX_CONSTANT_BUFFERS)
+    {
+        WARN("Invalid constant buffer index %u.\n", idx);
+        return;
+    }
+
+    if (state->cb[type][idx] == buffer)
+        return;
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_BUFFER, buffer);
+    state->cb[type][idx] = buffer;
+    wined3d_cs_emit_set_constant_buffer(&context->cs, type, idx, buffer);
+}
+
+void CDECL wined3d_deferred_context_set_shader_resource_view(struct wined3d_deferred_context *context,
+        enum wined3d_shader_type type, unsigned int idx, struct wined3d_shader_resource_view *view)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, type %#x, idx %u, view %p.\n", context, type, idx, view);
+
+    if (idx >= MAX_SHADER_RESOURCE_VIEWS)
+    {
+        WARN("Invalid view index %u.\n", idx);
+        return;
+    }
+
+    if (state->shader_resource_view[type][idx] == view)
+        return;
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_SHADER_RESOURCE_VIEW, view);
+    state->shader_resource_view[type][idx] = view;
+    wined3d_cs_emit_set_shader_resource_view(&context->cs, type, idx, view);
+}
+
+void CDECL wined3d_deferred_context_set_sampler(struct wined3d_deferred_context *context,
+        enum wined3d_shader_type type, unsigned int idx, struct wined3d_sampler *sampler)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, type %#x, idx %u, sampler %p.\n", context, type, idx, sampler);
+
+    if (idx >= MAX_SAMPLER_OBJECTS)
+    {
+        WARN("Invalid sampler index %u.\n", idx);
+        return;
+    }
+
+    if (state->sampler[type][idx] == sampler)
+        return;
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_SAMPLER, sampler);
+    state->sampler[type][idx] = sampler;
+    wined3d_cs_emit_set_sampler(&context->cs, type, idx, sampler);
+}
+
+void CDECL wined3d_deferred_context_set_vertex_declaration(struct wined3d_deferred_context *context,
+        struct wined3d_vertex_declaration *declaration)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, declaration %p.\n", context, declaration);
+
+    if (state->vertex_declaration == declaration)
+        return;
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_VERTEX_DECLARATION, declaration);
+    state->vertex_declaration = declaration;
+    wined3d_cs_emit_set_vertex_declaration(&context->cs, declaration);
+}
+
+HRESULT CDECL wined3d_deferred_context_set_stream_source(struct wined3d_deferred_context *context,
+        unsigned int stream_idx, struct wined3d_buffer *buffer, unsigned int offset, unsigned int stride)
+{
+    struct wined3d_stream_state *stream;
+
+    TRACE("context %p, stream_idx %u, buffer %p, offset %u, stride %u.\n",
+            context, stream_idx, buffer, offset, stride);
+
+    if (stream_idx >= WINED3D_MAX_STREAMS)
+    {
+        WARN("Stream index %u out of range.\n", stream_idx);
+        return WINED3DERR_INVALIDCALL;
+    }
+    else if (offset & 0x3)
+    {
+        WARN("Offset %u is not 4 byte aligned.\n", offset);
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    stream = &context->cs.state.streams[stream_idx];
+    if (stream->buffer == buffer && stream->offset == offset && stream->stride == stride)
+        return WINED3D_OK;
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_BUFFER, buffer);
+    stream->buffer = buffer;
+    stream->offset = offset;
+    stream->stride = stride;
+    wined3d_cs_emit_set_stream_source(&context->cs, stream_idx, buffer, offset, stride);
+
+    return WINED3D_OK;
+}
+
+void CDECL wined3d_deferred_context_set_index_buffer(struct wined3d_deferred_context *context,
+        struct wined3d_buffer *buffer, enum wined3d_format_id format_id, unsigned int offset)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, buffer %p, format %s, offset %u.\n",
+            context, buffer, debug_d3dformat(format_id), offset);
+
+    if (state->index_buffer == buffer && state->index_format == format_id && state->index_offset == offset)
+        return;
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_BUFFER, buffer);
+    state->index_buffer = buffer;
+    state->index_format = format_id;
+    state->index_offset = offset;
+    wined3d_cs_emit_set_index_buffer(&context->cs, buffer, format_id, offset);
+}
+
+void CDECL wined3d_deferred_context_set_primitive_type(struct wined3d_deferred_context *context,
+        enum wined3d_primitive_type primitive_type, unsigned int patch_vertex_count)
+{
+    TRACE("context %p, primitive_type %s, patch_vertex_count %u.\n",
+            context, debug_d3dprimitivetype(primitive_type), patch_vertex_count);
+
+    context->cs.state.gl_primitive_type = gl_primitive_type_from_d3d(primitive_type);
+    context->cs.state.gl_patch_vertices = patch_vertex_count;
+}
+
+HRESULT CDECL wined3d_deferred_context_set_rendertarget_view(struct wined3d_deferred_context *context,
+        unsigned int view_idx, struct wined3d_rendertarget_view *view)
+{
+    const struct wined3d_d3d_info *d3d_info = &context->cs.device->adapter->d3d_info;
+
+    TRACE("context %p, view_idx %u, view %p.\n", context, view_idx, view);
+
+    if (view_idx >= d3d_info->limits.max_rt_count)
+    {
+        WARN("Only %u render targets are supported.\n", d3d_info->limits.max_rt_count);
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    if (view && !(view->resource->bind_flags & WINED3D_BIND_RENDER_TARGET))
+    {
+        WARN("View resource %p doesn't have render target bind flags.\n", view->resource);
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    if (context->cs.fb.render_targets[view_idx] == view)
+        return WINED3D_OK;
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_RENDERTARGET_VIEW, view);
+    context->cs.fb.render_targets[view_idx] = view;
+    wined3d_cs_emit_set_rendertarget_view(&context->cs, view_idx, view);
+
+    return WINED3D_OK;
+}
+
+HRESULT CDECL wined3d_deferred_context_set_depth_stencil_view(struct wined3d_deferred_context *context,
+        struct wined3d_rendertarget_view *view)
+{
+    TRACE("context %p, view %p.\n", context, view);
+
+    if (view && !(view->resource->bind_flags & WINED3D_BIND_DEPTH_STENCIL))
+    {
+        WARN("View resource %p has incompatible %s bind flags.\n",
+                view->resource, wined3d_debug_bind_flags(view->resource->bind_flags));
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    if (context->cs.fb.depth_stencil == view)
+        return WINED3D_OK;
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_RENDERTARGET_VIEW, view);
+    context->cs.fb.depth_stencil = view;
+    wined3d_cs_emit_set_depth_stencil_view(&context->cs, view);
+
+    return WINED3D_OK;
+}
+
+void CDECL wined3d_deferred_context_set_blend_state(struct wined3d_deferred_context *context,
+        struct wined3d_blend_state *blend_state, const struct wined3d_color *blend_factor)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, blend_state %p, blend_factor %s.\n", context, blend_state, debug_color(blend_factor));
+
+    if (state->blend_state == blend_state && !memcmp(blend_factor, &state->blend_factor, sizeof(*blend_factor)))
+        return;
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_BLEND_STATE, blend_state);
+    state->blend_state = blend_state;
+    state->blend_factor = *blend_factor;
+    wined3d_cs_emit_set_blend_state(&context->cs, blend_state, blend_factor);
+}
+
+void CDECL wined3d_deferred_context_set_rasterizer_state(struct wined3d_deferred_context *context,
+        struct wined3d_rasterizer_state *rasterizer_state)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, rasterizer_state %p.\n", context, rasterizer_state);
+
+    if (state->rasterizer_state == rasterizer_state)
+        return;
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_RASTERIZER_STATE, rasterizer_state);
+    state->rasterizer_state = rasterizer_state;
+    wined3d_cs_emit_set_rasterizer_state(&context->cs, rasterizer_state);
+}
+
+void CDECL wined3d_deferred_context_set_render_state(struct wined3d_deferred_context *context,
+        enum wined3d_render_state state, DWORD value)
+{
+    TRACE("context %p, state %s (%#x), value %#x.\n", context, debug_d3drenderstate(state), state, value);
+
+    if (state > WINEHIGHEST_RENDER_STATE)
+    {
+        WARN("Unhandled render state %#x.\n", state);
+        return;
+    }
+
+    context->changed_render_states[state >> 5] |= 1u << (state & 0x1f);
+    if (context->cs.state.render_states[state] == value)
+        return;
+
+    context->cs.state.render_states[state] = value;
+    wined3d_cs_emit_set_render_state(&context->cs, state, value);
+}
+
+void CDECL wined3d_deferred_context_set_viewports(struct wined3d_deferred_context *context,
+        unsigned int viewport_count, const struct wined3d_viewport *viewports)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, viewport_count %u, viewports %p.\n", context, viewport_count, viewports);
+
+    if (viewport_count > WINED3D_MAX_VIEWPORTS)
+    {
+        WARN("Invalid viewport count %u.\n", viewport_count);
+        return;
+    }
+
+    if (viewport_count)
+        memcpy(state->viewports, viewports, viewport_count * sizeof(*viewports));
+    else
+        memset(state->viewports, 0, sizeof(state->viewports));
+    state->viewport_count = viewport_count;
+
+    wined3d_cs_emit_set_viewports(&context->cs, viewport_count, viewports);
+}
+
+void CDECL wined3d_deferred_context_set_scissor_rects(struct wined3d_deferred_context *context,
+        unsigned int rect_count, const RECT *rects)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, rect_count %u, rects %p.\n", context, rect_count, rects);
+
+    if (rect_count > WINED3D_MAX_VIEWPORTS)
+    {
+        WARN("Invalid scissor rect count %u.\n", rect_count);
+        return;
+    }
+
+    if (state->scissor_rect_count == rect_count
+            && !memcmp(state->scissor_rects, rects, rect_count * sizeof(*rects)))
+        return;
+
+    if (rect_count)
+        memcpy(state->scissor_rects, rects, rect_count * sizeof(*rects));
+    else
+        memset(state->scissor_rects, 0, sizeof(state->scissor_rects));
+    state->scissor_rect_count = rect_count;
+
+    wined3d_cs_emit_set_scissor_rects(&context->cs, rect_count, rects);
+}
+
+void CDECL wined3d_deferred_context_set_stream_output(struct wined3d_deferred_context *context,
+        unsigned int idx, struct wined3d_buffer *buffer, unsigned int offset)
+{
+    struct wined3d_stream_output *stream;
+
+    TRACE("context %p, idx %u, buffer %p, offset %u.\n", context, idx, buffer, offset);
+
+    if (idx >= WINED3D_MAX_STREAM_OUTPUT_BUFFERS)
+    {
+        WARN("Invalid stream output %u.\n", idx);
+        return;
+    }
+
+    stream = &context->cs.state.stream_output[idx];
+    if (stream->buffer == buffer && stream->offset == offset)
+        return;
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_BUFFER, buffer);
+    stream->buffer = buffer;
+    stream->offset = offset;
+    wined3d_cs_emit_set_stream_output(&context->cs, idx, buffer, offset);
+}
+
+void CDECL wined3d_deferred_context_set_predication(struct wined3d_deferred_context *context,
+        struct wined3d_query *predicate, BOOL value)
+{
+    struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, predicate %p, value %#x.\n", context, predicate, value);
+
+    if (predicate)
+        FIXME("Predicated rendering not implemented.\n");
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_QUERY, predicate);
+    state->predicate = predicate;
+    state->predicate_value = value;
+    wined3d_cs_emit_set_predication(&context->cs, predicate, value);
+}
+
+void CDECL wined3d_deferred_context_draw(struct wined3d_deferred_context *context, int base_vertex_idx,
+        unsigned int start_idx, unsigned int index_count, unsigned int start_instance, unsigned int instance_count,
+        BOOL indexed)
+{
+    const struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, base_vertex_idx %d, start_idx %u, index_count %u, start_instance %u, "
+            "instance_count %u, indexed %#x.\n",
+            context, base_vertex_idx, start_idx, index_count, start_instance, instance_count, indexed);
+
+    if (indexed && !state->index_buffer)
+    {
+        WARN("Indexed draw without an index buffer.\n");
+        return;
+    }
+
+    wined3d_cs_emit_draw(&context->cs, state->gl_primitive_type, state->gl_patch_vertices,
+            base_vertex_idx, start_idx, index_count, start_instance, instance_count, indexed);
+}
+
+void CDECL wined3d_deferred_context_draw_indirect(struct wined3d_deferred_context *context,
+        struct wined3d_buffer *buffer, unsigned int offset, BOOL indexed)
+{
+    const struct wined3d_state *state = &context->cs.state;
+
+    TRACE("context %p, buffer %p, offset %u, indexed %#x.\n", context, buffer, offset, indexed);
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_BUFFER, buffer);
+    wined3d_cs_emit_draw_indirect(&context->cs, state->gl_primitive_type, state->gl_patch_vertices,
+            buffer, offset, indexed);
+}
+
+void CDECL wined3d_deferred_context_dispatch(struct wined3d_deferred_context *context,
+        unsigned int group_count_x, unsigned int group_count_y, unsigned int group_count_z)
+{
+    TRACE("context %p, group_count_x %u, group_count_y %u, group_count_z %u.\n",
+            context, group_count_x, group_count_y, group_count_z);
+
+    wined3d_cs_emit_dispatch(&context->cs, group_count_x, group_count_y, group_count_z);
+}
+
+void CDECL wined3d_deferred_context_dispatch_indirect(struct wined3d_deferred_context *context,
+        struct wined3d_buffer *buffer, unsigned int offset)
+{
+    TRACE("context %p, buffer %p, offset %u.\n", context, buffer, offset);
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_BUFFER, buffer);
+    wined3d_cs_emit_dispatch_indirect(&context->cs, buffer, offset);
+}
+
+HRESULT CDECL wined3d_deferred_context_clear_rendertarget_view(struct wined3d_deferred_context *context,
+        struct wined3d_rendertarget_view *view, const RECT *rect, DWORD flags,
+        const struct wined3d_color *color, float depth, DWORD stencil)
+{
+    struct wined3d_resource *resource;
+    RECT r;
+
+    TRACE("context %p, view %p, rect %s, flags %#x, color %s, depth %.8e, stencil %u.\n",
+            context, view, wine_dbgstr_rect(rect), flags, debug_color(color), depth, stencil);
+
+    if (!(flags &= ~WINED3DCLEAR_SYNCHRONOUS))
+        return WINED3D_OK;
+
+    resource = view->resource;
+    if (resource->type == WINED3D_RTYPE_BUFFER)
+    {
+        FIXME("Not implemented for %s resources.\n", debug_d3dresourcetype(resource->type));
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    if (view->layer_count != max(1, resource->depth >> view->desc.u.texture.level_idx))
+    {
+        FIXME("Layered clears not implemented.\n");
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    if (!rect)
+    {
+        SetRect(&r, 0, 0, view->width, view->height);
+        rect = &r;
+    }
+    else
+    {
+        struct wined3d_box b = {rect->left, rect->top, rect->right, rect->bottom, 0, 1};
+        struct wined3d_texture *texture = texture_from_resource(view->resource);
+        HRESULT hr;
+
+        if (FAILED(hr = wined3d_texture_check_box_dimensions(texture,
+                view->sub_resource_idx % texture->level_count, &b)))
+            return hr;
+    }
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_RENDERTARGET_VIEW, view);
+    wined3d_cs_emit_clear_rendertarget_view(&context->cs, view, rect, flags, color, depth, stencil);
+
+    return WINED3D_OK;
+}
+
+void CDECL wined3d_deferred_context_clear_unordered_access_view_uint(struct wined3d_deferred_context *context,
+        struct wined3d_unordered_access_view *view, const struct wined3d_uvec4 *clear_value)
+{
+    TRACE("context %p, view %p, clear_value %s.\n", context, view, debug_uvec4(clear_value));
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_UNORDERED_ACCESS_VIEW, view);
+    wined3d_cs_emit_clear_unordered_access_view_uint(&context->cs, view, clear_value);
+}
+
+void CDECL wined3d_deferred_context_update_sub_resource(struct wined3d_deferred_context *context,
+        struct wined3d_resource *resource, unsigned int sub_resource_idx, const struct wined3d_box *box,
+        const void *data, unsigned int row_pitch, unsigned int depth_pitch)
+{
+    struct wined3d_command_list_data *list_data = &context->data;
+    unsigned int row_size, slice_size;
+    struct wined3d_box b;
+    size_t size;
+    void *copy;
+
+    TRACE("context %p, resource %p, sub_resource_idx %u, box %s, data %p, row_pitch %u, depth_pitch %u.\n",
+            context, resource, sub_resource_idx, debug_box(box), data, row_pitch, depth_pitch);
+
+    if (!device_get_sub_resource_update_box(resource, sub_resource_idx, box, &b))
+        return;
+
+    /* The application may reuse the data as soon as we return, so unlike
+     * wined3d_device_update_sub_resource() we need to copy it. */
+    if (resource->type == WINED3D_RTYPE_BUFFER)
+    {
+        size = b.right - b.left;
+    }
+    else
+    {
+        wined3d_format_calculate_pitch(resource->format, 1, b.right - b.left, b.bottom - b.top,
+                &row_size, &slice_size);
+        size = (size_t)(b.back - b.front - 1) * depth_pitch
+                + (size_t)(slice_size / row_size - 1) * row_pitch + row_size;
+    }
+
+    if (!wined3d_array_reserve((void **)&list_data->uploads, &list_data->uploads_size,
+            list_data->upload_count + 1, sizeof(*list_data->uploads))
+            || !(copy = heap_alloc(size)))
+    {
+        ERR("Failed to allocate upload data.\n");
+        return;
+    }
+    memcpy(copy, data, size);
+    list_data->uploads[list_data->upload_count++] = copy;
+
+    wined3d_deferred_context_add_resource(context, resource);
+    wined3d_cs_emit_update_sub_resource(&context->cs, resource, sub_resource_idx, &b, copy, row_pitch, depth_pitch);
+}
+
+void CDECL wined3d_deferred_context_copy_resource(struct wined3d_deferred_context *context,
+        struct wined3d_resource *dst_resource, struct wined3d_resource *src_resource)
+{
+    TRACE("context %p, dst_resource %p, src_resource %p.\n", context, dst_resource, src_resource);
+
+    wined3d_deferred_context_add_resource(context, dst_resource);
+    wined3d_deferred_context_add_resource(context, src_resource);
+    device_copy_resource(&context->cs, dst_resource, src_resource);
+}
+
+HRESULT CDECL wined3d_deferred_context_copy_sub_resource_region(struct wined3d_deferred_context *context,
+        struct wined3d_resource *dst_resource, unsigned int dst_sub_resource_idx, unsigned int dst_x,
+        unsigned int dst_y, unsigned int dst_z, struct wined3d_resource *src_resource,
+        unsigned int src_sub_resource_idx, const struct wined3d_box *src_box, unsigned int flags)
+{
+    TRACE("context %p, dst_resource %p, dst_sub_resource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
+            "src_resource %p, src_sub_resource_idx %u, src_box %s, flags %#x.\n",
+            context, dst_resource, dst_sub_resource_idx, dst_x, dst_y, dst_z,
+            src_resource, src_sub_resource_idx, debug_box(src_box), flags);
+
+    wined3d_deferred_context_add_resource(context, dst_resource);
+    wined3d_deferred_context_add_resource(context, src_resource);
+    return device_copy_sub_resource_region(&context->cs, dst_resource, dst_sub_resource_idx,
+            dst_x, dst_y, dst_z, src_resource, src_sub_resource_idx, src_box, flags);
+}
+
+void CDECL wined3d_deferred_context_copy_uav_counter(struct wined3d_deferred_context *context,
+        struct wined3d_buffer *dst_buffer, unsigned int offset, struct wined3d_unordered_access_view *uav)
+{
+    TRACE("context %p, dst_buffer %p, offset %u, uav %p.\n", context, dst_buffer, offset, uav);
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_BUFFER, dst_buffer);
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_UNORDERED_ACCESS_VIEW, uav);
+    wined3d_cs_emit_copy_uav_counter(&context->cs, dst_buffer, offset, uav);
+}
+
+void CDECL wined3d_deferred_context_generate_mipmaps(struct wined3d_deferred_context *context,
+        struct wined3d_shader_resource_view *view)
+{
+    struct wined3d_texture *texture;
+
+    TRACE("context %p, view %p.\n", context, view);
+
+    if (view->resource->type == WINED3D_RTYPE_BUFFER)
+    {
+        WARN("Called on buffer resource %p.\n", view->resource);
+        return;
+    }
+
+    texture = texture_from_resource(view->resource);
+    if (!(texture->flags & WINED3D_TEXTURE_GENERATE_MIPMAPS))
+    {
+        WARN("Texture without the WINED3D_TEXTURE_GENERATE_MIPMAPS flag, ignoring.\n");
+        return;
+    }
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_SHADER_RESOURCE_VIEW, view);
+    wined3d_cs_emit_generate_mipmaps(&context->cs, view);
+}
+
+void CDECL wined3d_deferred_context_issue_query(struct wined3d_deferred_context *context,
+        struct wined3d_query *query, DWORD flags)
+{
+    struct wined3d_command_list_data *data = &context->data;
+
+    TRACE("context %p, query %p, flags %#x.\n", context, query, flags);
+
+    if ((flags & WINED3DISSUE_END) && !wined3d_array_reserve((void **)&data->queries, &data->queries_size,
+            data->query_count + 1, sizeof(*data->queries)))
+    {
+        ERR("Failed to record query %p.\n", query);
+        return;
+    }
+
+    wined3d_deferred_context_add_object(context, WINED3D_COMMAND_LIST_OBJECT_QUERY, query);
+    if (flags & WINED3DISSUE_END)
+        data->queries[data->query_count++] = query;
+    wined3d_cs_emit_query_issue(&context->cs, query, flags);
+}
+
+static struct wined3d_deferred_map *wined3d_deferred_context_find_map(struct wined3d_deferred_context *context,
+        struct wined3d_resource *resource, unsigned int sub_resource_idx)
+{
+    SIZE_T i;
+
+    for (i = 0; i < context->map_count; ++i)
+    {
+        if (context->maps[i].resource == resource && context->maps[i].sub_resource_idx == sub_resource_idx)
+            return &context->maps[i];
+    }
+
+    return NULL;
+}
+
+HRESULT CDECL wined3d_deferred_context_map(struct wined3d_deferred_context *context,
+        struct wined3d_resource *resource, unsigned int sub_resource_idx,
+        struct wined3d_map_desc *map_desc, DWORD flags)
+{
+    struct wined3d_command_list_data *list_data = &context->data;
+    unsigned int row_pitch, slice_pitch, level;
+    struct wined3d_deferred_map *map;
+    struct wined3d_texture *texture;
+    size_t size;
+    void *data;
+
+    TRACE("context %p, resource %p, sub_resource_idx %u, map_desc %p, flags %#x.\n",
+            context, resource, sub_resource_idx, map_desc, flags);
+
+    if (!(flags & WINED3D_MAP_WRITE) || (flags & WINED3D_MAP_READ)
+            || !(flags & (WINED3D_MAP_DISCARD | WINED3D_MAP_NOOVERWRITE)))
+    {
+        WARN("Invalid map flags %#x.\n", flags);
+        return E_INVALIDARG;
+    }
+
+    if (!(resource->access & WINED3D_RESOURCE_ACCESS_MAP_W))
+    {
+        WARN("Resource does not have MAP_W access.\n");
+        return E_INVALIDARG;
+    }
+
+    map = wined3d_deferred_context_find_map(context, resource, sub_resource_idx);
+    if (map && map->mapped)
+    {
+        WARN("Sub-resource is already mapped.\n");
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    /* Earlier packets in the recording reference the memory of a previous
+     * map, but with WINED3D_MAP_NOOVERWRITE the application promises not to
+     * touch anything those use, so we can hand out the same memory. */
+    if (!(flags & WINED3D_MAP_DISCARD))
+    {
+        if (!map)
+        {
+            WARN("WINED3D_MAP_NOOVERWRITE without a previous WINED3D_MAP_DISCARD.\n");
+            return E_INVALIDARG;
+        }
+
+        map->mapped = TRUE;
+        *map_desc = map->map_desc;
+        return WINED3D_OK;
+    }
+
+    if (resource->type == WINED3D_RTYPE_BUFFER)
+    {
+        if (sub_resource_idx)
+        {
+            WARN("Invalid sub_resource_idx %u.\n", sub_resource_idx);
+            return E_INVALIDARG;
+        }
+
+        row_pitch = slice_pitch = resource->size;
+        size = resource->size;
+    }
+    else
+    {
+        texture = texture_from_resource(resource);
+        if (sub_resource_idx >= texture->level_count * texture->layer_count)
+        {
+            WARN("Invalid sub_resource_idx %u.\n", sub_resource_idx);
+            return E_INVALIDARG;
+        }
+
+        level = sub_resource_idx % texture->level_count;
+        wined3d_texture_get_pitch(texture, level, &row_pitch, &slice_pitch);
+        size = (size_t)slice_pitch * wined3d_texture_get_level_depth(texture, level);
+    }
+
+    if (!map && !wined3d_array_reserve((void **)&context->maps, &context->maps_size,
+            context->map_count + 1, sizeof(*context->maps)))
+        return E_OUTOFMEMORY;
+
+    if (!wined3d_array_reserve((void **)&list_data->uploads, &list_data->uploads_size,
+            list_data->upload_count + 1, sizeof(*list_data->uploads))
+            || !(data = heap_alloc(size)))
+    {
+        ERR("Failed to allocate map data.\n");
+        return E_OUTOFMEMORY;
+    }
+    list_data->uploads[list_data->upload_count++] = data;
+
+    if (!map)
+    {
+        map = &context->maps[context->map_count++];
+        map->resource = resource;
+        map->sub_resource_idx = sub_resource_idx;
+    }
+
+    map->map_desc.data = data;
+    map->map_desc.row_pitch = row_pitch;
+    map->map_desc.slice_pitch = slice_pitch;
+    map->mapped = TRUE;
+    *map_desc = map->map_desc;
+
+    return WINED3D_OK;
+}
+
+HRESULT CDECL wined3d_deferred_context_unmap(struct wined3d_deferred_context *context,
+        struct wined3d_resource *resource, unsigned int sub_resource_idx)
+{
+    struct wined3d_deferred_map *map;
+    struct wined3d_box box;
+
+    TRACE("context %p, resource %p, sub_resource_idx %u.\n", context, resource, sub_resource_idx);
+
+    if (!(map = wined3d_deferred_context_find_map(context, resource, sub_resource_idx)) || !map->mapped)
+    {
+        WARN("Sub-resource is not mapped.\n");
+        return WINED3DERR_INVALIDCALL;
+    }
+    map->mapped = FALSE;
+
+    if (!device_get_sub_resource_update_box(resource, sub_resource_idx, NULL, &box))
+        return WINED3DERR_INVALIDCALL;
+
+    wined3d_deferred_context_add_resource(context, resource);
+    wined3d_cs_emit_update_sub_resource(&context->cs, resource, sub_resource_idx, &box,
+            map->map_desc.data, map->map_desc.row_pitch, map->map_desc.slice_pitch);
+
+    return WINED3D_OK;
+}
+
+HRESULT CDECL wined3d_deferred_context_record_command_list(struct wined3d_deferred_context *context,
+        BOOL restore, struct wined3d_command_list **list)
+{
+    struct wined3d_command_list *object;
+
+    TRACE("context %p, restore %#x, list %p.\n", context, restore, list);
+
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+        return E_OUTOFMEMORY;
+
+    wined3d_cs_flush_state_changes(&context->cs);
+
+    object->refcount = 1;
+    object->device = context->cs.device;
+    object->data = context->data;
+    memset(&context->data, 0, sizeof(context->data));
+    /* The mapped memory now belongs to the command list. */
+    context->map_count = 0;
+
+    if (restore)
+        wined3d_deferred_context_emit_state(context);
+    else
+        wined3d_deferred_context_reset_state(context);
+
+    TRACE("Created command list %p.\n", object);
+    *list = object;
+
+    return WINED3D_OK;
+}
+
+ULONG CDECL wined3d_command_list_incref(struct wined3d_command_list *list)
+{
+    ULONG refcount = InterlockedIncrement(&list->refcount);
+
+    TRACE("%p increasing refcount to %u.\n", list, refcount);
+
+    return refcount;
+}
+
+static void wined3d_command_list_destroy_object(void *object)
+{
+    struct wined3d_command_list *list = object;
+
+    wined3d_command_list_data_cleanup(&list->data);
+    heap_free(list);
+}
+
+ULONG CDECL wined3d_command_list_decref(struct wined3d_command_list *list)
+{
+    ULONG refcount = InterlockedDecrement(&list->refcount);
+
+    TRACE("%p decreasing refcount to %u.\n", list, refcount);
+
+    if (!refcount)
+    {
+        /* Any execution of the list is queued before the destruction of the
+         * objects it references, as well as before the list itself. */
+        wined3d_command_list_data_release_objects(&list->data);
+        wined3d_cs_destroy_object(list->device->cs, wined3d_command_list_destroy_object, list);
+    }
+
+    return refcount;
+}
@@ -1067,6 +1067,7 @@ void wined3d_device_delete_opengl_contexts_cs(void *object)
     device->shader_backend->shader_free_private(device, context);
     destroy_dummy_textures(device, context);
     destroy_default_samplers(device, context);
+    wined3d_device_gl_destroy_streaming_bos(wined3d_device_gl(device), context);
     context_release(context);
 
     while (device->context_count)
@@ -1836,6 +1837,12 @@ void CDECL wined3d_device_set_material(struct wined3d_device *device, const stru
         return;
     }
 
+    if (!memcmp(&device->state.material, material, sizeof(*material)))
+    {
+        TRACE("Application is setting the old material over, nothing to do.\n");
+        return;
+    }
+
     device->state.material = *material;
     wined3d_cs_emit_set_material(device->cs, material);
 }
@@ -1944,6 +1951,13 @@ void CDECL wined3d_device_set_viewports(struct wined3d_device *device, unsigned
         return;
     }
 
+    if (device->state.viewport_count == viewport_count
+            && !memcmp(device->state.viewports, viewports, viewport_count * sizeof(*viewports)))
+    {
+        TRACE("Application is setting the old viewports over, nothing to do.\n");
+        return;
+    }
+
     if (viewport_count)
         memcpy(device->state.viewports, viewports, viewport_count * sizeof(*viewports));
     else
@@ -4579,15 +4593,15 @@ void CDECL wined3d_device_copy_uav_counter(struct wined3d_device *device,
     wined3d_cs_emit_copy_uav_counter(device->cs, dst_buffer, offset, uav);
 }
 
-void CDECL wined3d_device_copy_resource(struct wined3d_device *device,
+/* Shared by wined3d_device_copy_resource() and the deferred context
+ * equivalent, which only differ in the command stream they emit to. */
+void device_copy_resource(struct wined3d_cs *cs,
         struct wined3d_resource *dst_resource, struct wined3d_resource *src_resource)
 {
     struct wined3d_texture *dst_texture, *src_texture;
     struct wined3d_box box;
     unsigned int i, j;
 
-    TRACE("device %p, dst_resource %p, src_resource %p.\n", device, dst_resource, src_resource);
-
     if (src_resource == dst_resource)
     {
         WARN("Source and destination are the same resource.\n");
@@ -4624,7 +4638,7 @@ void CDECL wined3d_device_copy_resource(struct wined3d_device *device,
     if (dst_resource->type == WINED3D_RTYPE_BUFFER)
     {
         wined3d_box_set(&box, 0, 0, src_resource->size, 1, 0, 1);
-        wined3d_cs_emit_blt_sub_resource(device->cs, dst_resource, 0, &box,
+        wined3d_cs_emit_blt_sub_resource(cs, dst_resource, 0, &box,
                 src_resource, 0, &box, WINED3D_BLT_RAW, NULL, WINED3D_TEXF_POINT);
         return;
     }
@@ -4651,24 +4665,27 @@ void CDECL wined3d_device_copy_resource(struct wined3d_device *device,
         {
             unsigned int idx = j * dst_texture->level_count + i;
 
-            wined3d_cs_emit_blt_sub_resource(device->cs, dst_resource, idx, &box,
+            wined3d_cs_emit_blt_sub_resource(cs, dst_resource, idx, &box,
                     src_resource, idx, &box, WINED3D_BLT_RAW, NULL, WINED3D_TEXF_POINT);
         }
     }
 }
 
-HRESULT CDECL wined3d_device_copy_sub_resource_region(struct wined3d_device *device,
+void CDECL wined3d_device_copy_resource(struct wined3d_device *device,
+        struct wined3d_resource *dst_resource, struct wined3d_resource *src_resource)
+{
+    TRACE("device %p, dst_resource %p, src_resource %p.\n", device, dst_resource, src_resource);
+
+    device_copy_resource(device->cs, dst_resource, src_resource);
+}
+
+HRESULT device_copy_sub_resource_region(struct wined3d_cs *cs,
         struct wined3d_resource *dst_resource, unsigned int dst_sub_resource_idx, unsigned int dst_x,
         unsigned int dst_y, unsigned int dst_z, struct wined3d_resource *src_resource,
         unsigned int src_sub_resource_idx, const struct wined3d_box *src_box, unsigned int flags)
 {
     struct wined3d_box dst_box, b;
 
-    TRACE("device %p, dst_resource %p, dst_sub_resource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
-            "src_resource %p, src_sub_resource_idx %u, src_box %s, flags %#x.\n",
-            device, dst_resource, dst_sub_resource_idx, dst_x, dst_y, dst_z,
-            src_resource, src_sub_resource_idx, debug_box(src_box), flags);
-
     if (flags)
         FIXME("Ignoring flags %#x.\n", flags);
 
@@ -4797,30 +4814,35 @@ HRESULT CDECL wined3d_device_copy_sub_resource_region(struct wined3d_device *dev
         }
     }
 
-    wined3d_cs_emit_blt_sub_resource(device->cs, dst_resource, dst_sub_resource_idx, &dst_box,
+    wined3d_cs_emit_blt_sub_resource(cs, dst_resource, dst_sub_resource_idx, &dst_box,
             src_resource, src_sub_resource_idx, src_box, WINED3D_BLT_RAW, NULL, WINED3D_TEXF_POINT);
 
     return WINED3D_OK;
 }
 
-void CDECL wined3d_device_update_sub_resource(struct wined3d_device *device, struct wined3d_resource *resource,
-        unsigned int sub_resource_idx, const struct wined3d_box *box, const void *data, unsigned int row_pitch,
-        unsigned int depth_pitch, unsigned int flags)
+HRESULT CDECL wined3d_device_copy_sub_resource_region(struct wined3d_device *device,
+        struct wined3d_resource *dst_resource, unsigned int dst_sub_resource_idx, unsigned int dst_x,
+        unsigned int dst_y, unsigned int dst_z, struct wined3d_resource *src_resource,
+        unsigned int src_sub_resource_idx, const struct wined3d_box *src_box, unsigned int flags)
 {
-    unsigned int width, height, depth;
-    struct wined3d_box b;
+    TRACE("device %p, dst_resource %p, dst_sub_resource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
+            "src_resource %p, src_sub_resource_idx %u, src_box %s, flags %#x.\n",
+            device, dst_resource, dst_sub_resource_idx, dst_x, dst_y, dst_z,
+            src_resource, src_sub_resource_idx, debug_box(src_box), flags);
 
-    TRACE("device %p, resource %p, sub_resource_idx %u, box %s, data %p, row_pitch %u, depth_pitch %u, "
-            "flags %#x.\n",
-            device, resource, sub_resource_idx, debug_box(box), data, row_pitch, depth_pitch, flags);
+    return device_copy_sub_resource_region(device->cs, dst_resource, dst_sub_resource_idx,
+            dst_x, dst_y, dst_z, src_resource, src_sub_resource_idx, src_box, flags);
+}
 
-    if (flags)
-        FIXME("Ignoring flags %#x.\n", flags);
+BOOL device_get_sub_resource_update_box(struct wined3d_resource *resource, unsigned int sub_resource_idx,
+        const struct wined3d_box *box, struct wined3d_box *update_box)
+{
+    unsigned int width, height, depth;
 
     if (!(resource->access & WINED3D_RESOURCE_ACCESS_GPU))
     {
         WARN("Resource %p is not GPU accessible.\n", resource);
-        return;
+        return FALSE;
     }
 
     if (resource->type == WINED3D_RTYPE_BUFFER)
@@ -4828,7 +4850,7 @@ void CDECL wined3d_device_update_sub_resource(struct wined3d_device *device, str
         if (sub_resource_idx > 0)
         {
             WARN("Invalid sub_resource_idx %u.\n", sub_resource_idx);
-            return;
+            return FALSE;
         }
 
         width = resource->size;
@@ -4843,7 +4865,7 @@ void CDECL wined3d_device_update_sub_resource(struct wined3d_device *device, str
         if (sub_resource_idx >= texture->level_count * texture->layer_count)
         {
             WARN("Invalid sub_resource_idx %u.\n", sub_resource_idx);
-            return;
+            return FALSE;
         }
 
         level = sub_resource_idx % texture->level_count;
@@ -4854,20 +4876,41 @@ void CDECL wined3d_device_update_sub_resource(struct wined3d_device *device, str
 
     if (!box)
     {
-        wined3d_box_set(&b, 0, 0, width, height, 0, depth);
-        box = &b;
+        wined3d_box_set(update_box, 0, 0, width, height, 0, depth);
+        return TRUE;
     }
-    else if (box->left >= box->right || box->right > width
+
+    if (box->left >= box->right || box->right > width
             || box->top >= box->bottom || box->bottom > height
             || box->front >= box->back || box->back > depth)
     {
         WARN("Invalid box %s specified.\n", debug_box(box));
-        return;
+        return FALSE;
     }
 
+    *update_box = *box;
+    return TRUE;
+}
+
+void CDECL wined3d_device_update_sub_resource(struct wined3d_device *device, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx, const struct wined3d_box *box, const void *data, unsigned int row_pitch,
+        unsigned int depth_pitch, unsigned int flags)
+{
+    struct wined3d_box b;
+
+    TRACE("device %p, resource %p, sub_resource_idx %u, box %s, data %p, row_pitch %u, depth_pitch %u, "
+            "flags %#x.\n",
+            device, resource, sub_resource_idx, debug_box(box), data, row_pitch, depth_pitch, flags);
+
+    if (flags)
+        FIXME("Ignoring flags %#x.\n", flags);
+
+    if (!device_get_sub_resource_update_box(resource, sub_resource_idx, box, &b))
+        return;
+
     wined3d_resource_wait_idle(resource);
 
-    wined3d_cs_emit_update_sub_resource(device->cs, resource, sub_resource_idx, box, data, row_pitch, depth_pitch);
+    wined3d_cs_emit_update_sub_resource(device->cs, resource, sub_resource_idx, &b, data, row_pitch, depth_pitch);
 }
 
 void CDECL wined3d_device_resolve_sub_resource(struct wined3d_device *device,
@@ -5295,6 +5338,14 @@ BOOL CDECL wined3d_device_show_cursor(struct wined3d_device *device, BOOL show)
     return oldVisible;
 }
 
+void CDECL wined3d_device_execute_command_list(struct wined3d_device *device,
+        struct wined3d_command_list *list)
+{
+    TRACE("device %p, list %p.\n", device, list);
+
+    wined3d_cs_emit_execute_command_list(device->cs, list);
+}
+
 void CDECL wined3d_device_evict_managed_resources(struct wined3d_device *device)
 {
     struct wined3d_resource *resource, *cursor;
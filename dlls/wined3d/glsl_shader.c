@@ -42,6 +42,7 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d_shader);
 WINE_DECLARE_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 WINE_DECLARE_DEBUG_CHANNEL(winediag);
 
 #define WINED3D_GLSL_SAMPLE_PROJECTED   0x01
@@ -128,6 +129,48 @@ struct constant_heap
 };
 
 /* GLSL shader private data */
+#define WINED3D_GLSL_CACHE_MAGIC    0x42504c47 /* "GLPB" */
+#define WINED3D_GLSL_CACHE_VERSION  1
+
+struct glsl_program_cache_header
+{
+    DWORD magic;
+    DWORD version;
+    UINT64 driver_hash;
+    UINT64 key;
+    GLenum format;
+    DWORD size;
+};
+
+/* On-disk cache of linked program binaries, keyed by the GLSL source of the
+ * attached shaders and the driver identity. The cache is limited to
+ * "shader_cache_size" MiB; entries are touched when loaded and the least
+ * recently used ones are evicted when the limit is exceeded. */
+struct glsl_program_cache
+{
+    BOOL initialised;
+    BOOL enabled;
+    char path[MAX_PATH];
+    UINT64 driver_hash;
+    ULONGLONG size;
+    ULONGLONG max_size;
+    LONGLONG frequency;
+
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int evictions;
+    LONGLONG load_time;
+    LONGLONG link_time;
+    LONGLONG last_stats;
+};
+
+struct glsl_program_cache_entry
+{
+    char name[24];
+    FILETIME time;
+    ULONGLONG size;
+};
+
 struct shader_glsl_priv
 {
     struct wined3d_string_buffer shader_buffer;
@@ -144,6 +187,8 @@ struct shader_glsl_priv
     struct wine_rb_tree ffp_fragment_shaders;
     BOOL ffp_proj_control;
     BOOL legacy_lighting;
+
+    struct glsl_program_cache program_cache;
 };
 
 struct glsl_vs_program
@@ -632,6 +677,365 @@ void shader_glsl_validate_link(const struct wined3d_gl_info *gl_info, GLuint pro
     print_glsl_info_log(gl_info, program, TRUE);
 }
 
+static UINT64 glsl_program_cache_hash(UINT64 hash, const void *data, SIZE_T size)
+{
+    const BYTE *ptr = data;
+
+    /* FNV-1a */
+    while (size--)
+    {
+        hash ^= *ptr++;
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+static int glsl_program_cache_hash_compare(const void *a, const void *b)
+{
+    const UINT64 *h1 = a, *h2 = b;
+
+    return *h1 < *h2 ? -1 : *h1 > *h2;
+}
+
+static int glsl_program_cache_entry_compare(const void *a, const void *b)
+{
+    const struct glsl_program_cache_entry *e1 = a, *e2 = b;
+
+    return CompareFileTime(&e1->time, &e2->time);
+}
+
+/* Recomputes the size of the cache directory, which may be shared with other
+ * processes, and evicts the least recently used entries until the cache is
+ * back under three quarters of its size limit. */
+static void shader_glsl_trim_program_cache(struct glsl_program_cache *cache)
+{
+    struct glsl_program_cache_entry *entries = NULL;
+    SIZE_T count = 0, capacity = 0, i;
+    char filename[MAX_PATH];
+    WIN32_FIND_DATAA data;
+    ULONGLONG size = 0;
+    HANDLE find;
+
+    sprintf(filename, "%s\\*.bin", cache->path);
+    if ((find = FindFirstFileA(filename, &data)) == INVALID_HANDLE_VALUE)
+    {
+        cache->size = 0;
+        return;
+    }
+    do
+    {
+        if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || strlen(data.cFileName) >= sizeof(entries->name))
+            continue;
+        if (!wined3d_array_reserve((void **)&entries, &capacity, count + 1, sizeof(*entries)))
+            break;
+        strcpy(entries[count].name, data.cFileName);
+        entries[count].time = data.ftLastWriteTime;
+        entries[count].size = ((ULONGLONG)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+        size += entries[count++].size;
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+
+    if (size > cache->max_size)
+    {
+        qsort(entries, count, sizeof(*entries), glsl_program_cache_entry_compare);
+        for (i = 0; i < count && size > cache->max_size / 4 * 3; ++i)
+        {
+            sprintf(filename, "%s\\%s", cache->path, entries[i].name);
+            if (!DeleteFileA(filename))
+                continue;
+            size -= entries[i].size;
+            ++cache->evictions;
+        }
+        TRACE_(d3d_perf)("Evicted %u program cache entries, cache size is now %s bytes.\n",
+                (unsigned int)i, wine_dbgstr_longlong(size));
+    }
+    heap_free(entries);
+
+    cache->size = size;
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_init_program_cache(const struct wined3d_gl_info *gl_info, struct glsl_program_cache *cache)
+{
+    static const GLenum driver_strings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION_ARB};
+    GLint format_count = 0;
+    LARGE_INTEGER freq;
+    unsigned int i;
+    const char *str;
+    DWORD len;
+
+    cache->initialised = TRUE;
+
+    if (!wined3d_settings.shader_cache || !wined3d_settings.shader_cache_size
+            || !gl_info->supported[ARB_GET_PROGRAM_BINARY])
+        return;
+
+    gl_info->gl_ops.gl.p_glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    if (!format_count)
+    {
+        WARN_(d3d_perf)("The driver doesn't support any program binary formats, not caching programs.\n");
+        return;
+    }
+
+    if (wined3d_settings.shader_cache_path)
+    {
+        if (strlen(wined3d_settings.shader_cache_path) >= sizeof(cache->path) - 32)
+            return;
+        strcpy(cache->path, wined3d_settings.shader_cache_path);
+    }
+    else
+    {
+        len = GetEnvironmentVariableA("LOCALAPPDATA", cache->path, sizeof(cache->path));
+        if (!len || len >= sizeof(cache->path) - 64)
+            return;
+        strcat(cache->path, "\\wined3d");
+        CreateDirectoryA(cache->path, NULL);
+        strcat(cache->path, "\\shader_cache");
+    }
+    if (!CreateDirectoryA(cache->path, NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        WARN("Failed to create shader cache directory %s, error %u.\n",
+                debugstr_a(cache->path), GetLastError());
+        return;
+    }
+
+    cache->driver_hash = 0xcbf29ce484222325;
+    for (i = 0; i < ARRAY_SIZE(driver_strings); ++i)
+    {
+        if ((str = (const char *)gl_info->gl_ops.gl.p_glGetString(driver_strings[i])))
+            cache->driver_hash = glsl_program_cache_hash(cache->driver_hash, str, strlen(str) + 1);
+    }
+    checkGLcall("query driver identity");
+
+    cache->max_size = (ULONGLONG)wined3d_settings.shader_cache_size << 20;
+    shader_glsl_trim_program_cache(cache);
+
+    QueryPerformanceFrequency(&freq);
+    cache->frequency = freq.QuadPart;
+    cache->enabled = TRUE;
+
+    TRACE("Caching GLSL programs in %s, %s of %s bytes used.\n", debugstr_a(cache->path),
+            wine_dbgstr_longlong(cache->size), wine_dbgstr_longlong(cache->max_size));
+}
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_get_program_cache_key(const struct wined3d_gl_info *gl_info,
+        const struct glsl_program_cache *cache, GLuint program_id, UINT64 *key)
+{
+    UINT64 hashes[WINED3D_SHADER_TYPE_COUNT + 1];
+    GLuint shaders[ARRAY_SIZE(hashes)];
+    GLint i, count, length, size = 0;
+    char *source = NULL, *tmp;
+    GLint type;
+
+    GL_EXTCALL(glGetProgramiv(program_id, GL_ATTACHED_SHADERS, &count));
+    if (!count || count > ARRAY_SIZE(shaders))
+        return FALSE;
+    GL_EXTCALL(glGetAttachedShaders(program_id, count, NULL, shaders));
+
+    for (i = 0; i < count; ++i)
+    {
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type));
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_SOURCE_LENGTH, &length));
+        if (length > size)
+        {
+            if (!(tmp = heap_realloc(source, length)))
+            {
+                heap_free(source);
+                return FALSE;
+            }
+            source = tmp;
+            size = length;
+        }
+        if (length)
+            GL_EXTCALL(glGetShaderSource(shaders[i], length, &length, source));
+
+        hashes[i] = glsl_program_cache_hash(cache->driver_hash, &type, sizeof(type));
+        hashes[i] = glsl_program_cache_hash(hashes[i], source, length);
+    }
+    checkGLcall("get program sources");
+    heap_free(source);
+
+    /* The order in which the driver reports attached shaders is undefined. */
+    qsort(hashes, count, sizeof(*hashes), glsl_program_cache_hash_compare);
+    *key = glsl_program_cache_hash(cache->driver_hash, hashes, count * sizeof(*hashes));
+    return TRUE;
+}
+
+static void shader_glsl_get_program_cache_file(const struct glsl_program_cache *cache,
+        UINT64 key, char *filename)
+{
+    sprintf(filename, "%s\\%08x%08x.bin", cache->path, (unsigned int)(key >> 32), (unsigned int)key);
+}
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_load_cached_program(const struct wined3d_gl_info *gl_info,
+        struct glsl_program_cache *cache, GLuint program_id, UINT64 key)
+{
+    struct glsl_program_cache_header header;
+    char filename[MAX_PATH];
+    DWORD size, file_size;
+    void *binary = NULL;
+    FILETIME now;
+    GLint status;
+    HANDLE file;
+    BOOL ret;
+
+    shader_glsl_get_program_cache_file(cache, key, filename);
+    if ((file = CreateFileA(filename, GENERIC_READ | FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, 0, NULL)) == INVALID_HANDLE_VALUE
+            && (file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, 0, NULL)) == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    file_size = GetFileSize(file, NULL);
+    ret = ReadFile(file, &header, sizeof(header), &size, NULL) && size == sizeof(header)
+            && header.magic == WINED3D_GLSL_CACHE_MAGIC && header.version == WINED3D_GLSL_CACHE_VERSION
+            && header.driver_hash == cache->driver_hash && header.key == key
+            && header.size && header.size <= 0x4000000 && (binary = heap_alloc(header.size))
+            && ReadFile(file, binary, header.size, &size, NULL) && size == header.size;
+    if (ret)
+    {
+        /* The last write time orders entries for eviction. */
+        GetSystemTimeAsFileTime(&now);
+        SetFileTime(file, NULL, NULL, &now);
+    }
+    CloseHandle(file);
+
+    if (ret)
+    {
+        GL_EXTCALL(glProgramBinary(program_id, header.format, binary, header.size));
+        checkGLcall("glProgramBinary");
+        GL_EXTCALL(glGetProgramiv(program_id, GL_LINK_STATUS, &status));
+        ret = !!status;
+    }
+    heap_free(binary);
+
+    if (!ret)
+    {
+        WARN("Discarding stale program cache entry %s.\n", debugstr_a(filename));
+        if (DeleteFileA(filename) && file_size != INVALID_FILE_SIZE)
+            cache->size -= min(cache->size, file_size);
+    }
+    return ret;
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_store_cached_program(const struct wined3d_gl_info *gl_info,
+        struct glsl_program_cache *cache, GLuint program_id, UINT64 key)
+{
+    char filename[MAX_PATH], tmp_filename[MAX_PATH];
+    struct glsl_program_cache_header header;
+    void *binary;
+    GLint length;
+    HANDLE file;
+    DWORD size;
+    BOOL ret;
+
+    GL_EXTCALL(glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0 || !(binary = heap_alloc(length)))
+        return;
+    GL_EXTCALL(glGetProgramBinary(program_id, length, &length, &header.format, binary));
+    checkGLcall("glGetProgramBinary");
+
+    header.magic = WINED3D_GLSL_CACHE_MAGIC;
+    header.version = WINED3D_GLSL_CACHE_VERSION;
+    header.driver_hash = cache->driver_hash;
+    header.key = key;
+    header.size = length;
+
+    /* Write to a temporary file first, so that other processes never see a
+     * partially written entry. */
+    shader_glsl_get_program_cache_file(cache, key, filename);
+    sprintf(tmp_filename, "%s.%x", filename, GetCurrentProcessId());
+    if ((file = CreateFileA(tmp_filename, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to create %s, error %u.\n", debugstr_a(tmp_filename), GetLastError());
+        heap_free(binary);
+        return;
+    }
+    ret = length && WriteFile(file, &header, sizeof(header), &size, NULL) && size == sizeof(header)
+            && WriteFile(file, binary, length, &size, NULL) && size == length;
+    CloseHandle(file);
+    heap_free(binary);
+
+    if (!ret || !MoveFileExA(tmp_filename, filename, MOVEFILE_REPLACE_EXISTING))
+    {
+        WARN("Failed to write program cache entry %s, error %u.\n", debugstr_a(filename), GetLastError());
+        DeleteFileA(tmp_filename);
+        return;
+    }
+
+    cache->size += sizeof(header) + length;
+    if (cache->size > cache->max_size)
+        shader_glsl_trim_program_cache(cache);
+}
+
+static void shader_glsl_dump_program_cache_stats(const struct glsl_program_cache *cache)
+{
+    if (!cache->enabled || !TRACE_ON(d3d_perf))
+        return;
+
+    TRACE_(d3d_perf)("Program cache: %u hits in %.3f ms, %u misses in %.3f ms, %u evictions, %s bytes used.\n",
+            cache->hits, cache->load_time * 1000.0 / cache->frequency,
+            cache->misses, cache->link_time * 1000.0 / cache->frequency,
+            cache->evictions, wine_dbgstr_longlong(cache->size));
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_link_program(const struct wined3d_gl_info *gl_info,
+        struct shader_glsl_priv *priv, GLuint program_id, BOOL cacheable)
+{
+    struct glsl_program_cache *cache = &priv->program_cache;
+    LARGE_INTEGER start, end;
+    GLint status;
+    UINT64 key;
+
+    if (!cache->initialised)
+        shader_glsl_init_program_cache(gl_info, cache);
+
+    if (!cache->enabled || !cacheable || !shader_glsl_get_program_cache_key(gl_info, cache, program_id, &key))
+    {
+        TRACE("Linking GLSL shader program %u.\n", program_id);
+        GL_EXTCALL(glLinkProgram(program_id));
+        shader_glsl_validate_link(gl_info, program_id);
+        return;
+    }
+
+    QueryPerformanceCounter(&start);
+    if (shader_glsl_load_cached_program(gl_info, cache, program_id, key))
+    {
+        QueryPerformanceCounter(&end);
+        ++cache->hits;
+        cache->load_time += end.QuadPart - start.QuadPart;
+        TRACE("Loaded GLSL shader program %u from the program cache.\n", program_id);
+    }
+    else
+    {
+        TRACE("Linking GLSL shader program %u.\n", program_id);
+        GL_EXTCALL(glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+        GL_EXTCALL(glLinkProgram(program_id));
+        shader_glsl_validate_link(gl_info, program_id);
+        GL_EXTCALL(glGetProgramiv(program_id, GL_LINK_STATUS, &status));
+        if (status)
+            shader_glsl_store_cached_program(gl_info, cache, program_id, key);
+        QueryPerformanceCounter(&end);
+
+        ++cache->misses;
+        cache->link_time += end.QuadPart - start.QuadPart;
+        TRACE_(d3d_perf)("Program cache miss, linked program %u in %.3f ms.\n",
+                program_id, (end.QuadPart - start.QuadPart) * 1000.0 / cache->frequency);
+    }
+
+    /* Devices may live for the whole session; report periodically rather
+     * than only on destruction. */
+    if (end.QuadPart - cache->last_stats >= cache->frequency)
+    {
+        cache->last_stats = end.QuadPart;
+        shader_glsl_dump_program_cache_stats(cache);
+    }
+}
+
 static BOOL shader_glsl_use_layout_qualifier(const struct wined3d_gl_info *gl_info)
 {
     /* Layout qualifiers were introduced in GLSL 1.40. The Nvidia Legacy GPU
@@ -10031,9 +10435,7 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
 
     list_add_head(&shader->linked_programs, &entry->cs.shader_entry);
 
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
+    shader_glsl_link_program(gl_info, priv, program_id, TRUE);
 
     GL_EXTCALL(glUseProgram(program_id));
     checkGLcall("glUseProgram");
@@ -10359,10 +10761,9 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
         list_add_head(ps_list, &entry->ps.shader_entry);
     }
 
-    /* Link the program */
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
+    /* Link the program. Transform feedback varyings aren't part of the
+     * shader source, so don't cache programs using stream output. */
+    shader_glsl_link_program(gl_info, priv, program_id, !gshader || !gshader->u.gs.so_desc.element_count);
 
     shader_glsl_init_vs_uniform_locations(gl_info, priv, program_id, &entry->vs,
             vshader ? vshader->limits->constant_float : 0);
@@ -10979,6 +11380,7 @@ static void shader_glsl_free(struct wined3d_device *device, struct wined3d_conte
 {
     struct shader_glsl_priv *priv = device->shader_priv;
 
+    shader_glsl_dump_program_cache_stats(&priv->program_cache);
     wine_rb_destroy(&priv->program_lookup, NULL, NULL);
     constant_heap_free(&priv->pconst_heap);
     constant_heap_free(&priv->vconst_heap);
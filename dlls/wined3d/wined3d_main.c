@@ -91,6 +91,11 @@ struct wined3d_settings wined3d_settings =
     ~0u,            /* No CS shader model limit by default. */
     WINED3D_RENDERER_AUTO,
     WINED3D_SHADER_BACKEND_AUTO,
+    TRUE,           /* Cache linked GLSL programs on disk by default. */
+    NULL,           /* Shader cache in the user's local application data directory. */
+    128,            /* Limit the shader cache to 128 MiB by default. */
+    NULL,           /* No command stream profile by default. */
+    0,              /* Profile until the device is destroyed. */
 };
 
 struct wined3d * CDECL wined3d_create(DWORD flags)
@@ -365,6 +370,31 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
                 wined3d_settings.renderer = WINED3D_RENDERER_NO3D;
             }
         }
+        if (!get_config_key_dword(hkey, appkey, "shader_cache", &wined3d_settings.shader_cache))
+            TRACE("Setting shader cache to %#x.\n", wined3d_settings.shader_cache);
+        if (!get_config_key(hkey, appkey, "shader_cache_path", buffer, size))
+        {
+            size_t len = strlen(buffer) + 1;
+
+            if (!(wined3d_settings.shader_cache_path = heap_alloc(len)))
+                ERR("Failed to allocate shader cache path memory.\n");
+            else
+                memcpy(wined3d_settings.shader_cache_path, buffer, len);
+        }
+        if (!get_config_key_dword(hkey, appkey, "shader_cache_size", &wined3d_settings.shader_cache_size))
+            TRACE("Limiting shader cache size to %u MiB.\n", wined3d_settings.shader_cache_size);
+        if (!get_config_key(hkey, appkey, "profile_file", buffer, size))
+        {
+            size_t len = strlen(buffer) + 1;
+
+            if (!(wined3d_settings.profile_file = heap_alloc(len)))
+                ERR("Failed to allocate profile file name memory.\n");
+            else
+                memcpy(wined3d_settings.profile_file, buffer, len);
+            ERR_(winediag)("Writing command stream profiles to %s.<pid>.<device>.json.\n", debugstr_a(buffer));
+        }
+        if (!get_config_key_dword(hkey, appkey, "profile_frames", &wined3d_settings.profile_frames))
+            TRACE("Profiling %u frames.\n", wined3d_settings.profile_frames);
     }
 
     if (appkey) RegCloseKey( appkey );
@@ -397,6 +427,8 @@ static BOOL wined3d_dll_destroy(HINSTANCE hInstDLL)
     heap_free(wndproc_table.entries);
 
     heap_free(wined3d_settings.logo);
+    heap_free(wined3d_settings.shader_cache_path);
+    heap_free(wined3d_settings.profile_file);
     UnregisterClassA(WINED3D_OPENGL_WINDOW_CLASS_NAME, hInstDLL);
 
     DeleteCriticalSection(&wined3d_wndproc_cs);
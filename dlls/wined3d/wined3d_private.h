@@ -423,6 +423,11 @@ struct wined3d_settings
     unsigned int max_sm_cs;
     enum wined3d_renderer renderer;
     enum wined3d_shader_backend shader_backend;
+    unsigned int shader_cache;
+    char *shader_cache_path;
+    unsigned int shader_cache_size;
+    char *profile_file;
+    unsigned int profile_frames;
 };
 
 extern struct wined3d_settings wined3d_settings DECLSPEC_HIDDEN;
@@ -1734,6 +1739,8 @@ struct wined3d_fence
 HRESULT wined3d_fence_create(struct wined3d_device *device, struct wined3d_fence **fence) DECLSPEC_HIDDEN;
 void wined3d_fence_destroy(struct wined3d_fence *fence) DECLSPEC_HIDDEN;
 void wined3d_fence_issue(struct wined3d_fence *fence, const struct wined3d_device *device) DECLSPEC_HIDDEN;
+enum wined3d_fence_result wined3d_fence_test(const struct wined3d_fence *fence,
+        const struct wined3d_device *device, DWORD flags) DECLSPEC_HIDDEN;
 enum wined3d_fence_result wined3d_fence_wait(const struct wined3d_fence *fence,
         const struct wined3d_device *device) DECLSPEC_HIDDEN;
 
@@ -3223,6 +3230,14 @@ void device_clear_render_targets(struct wined3d_device *device, UINT rt_count, c
         const struct wined3d_color *color, float depth, DWORD stencil) DECLSPEC_HIDDEN;
 BOOL device_context_add(struct wined3d_device *device, struct wined3d_context *context) DECLSPEC_HIDDEN;
 void device_context_remove(struct wined3d_device *device, struct wined3d_context *context) DECLSPEC_HIDDEN;
+void device_copy_resource(struct wined3d_cs *cs, struct wined3d_resource *dst_resource,
+        struct wined3d_resource *src_resource) DECLSPEC_HIDDEN;
+HRESULT device_copy_sub_resource_region(struct wined3d_cs *cs,
+        struct wined3d_resource *dst_resource, unsigned int dst_sub_resource_idx, unsigned int dst_x,
+        unsigned int dst_y, unsigned int dst_z, struct wined3d_resource *src_resource,
+        unsigned int src_sub_resource_idx, const struct wined3d_box *src_box, unsigned int flags) DECLSPEC_HIDDEN;
+BOOL device_get_sub_resource_update_box(struct wined3d_resource *resource, unsigned int sub_resource_idx,
+        const struct wined3d_box *box, struct wined3d_box *update_box) DECLSPEC_HIDDEN;
 void wined3d_device_create_primary_opengl_context_cs(void *object) DECLSPEC_HIDDEN;
 void wined3d_device_delete_opengl_contexts_cs(void *object) DECLSPEC_HIDDEN;
 HRESULT wined3d_device_init(struct wined3d_device *device, struct wined3d *wined3d,
@@ -3238,12 +3253,28 @@ HRESULT wined3d_device_set_implicit_swapchain(struct wined3d_device *device,
         struct wined3d_swapchain *swapchain) DECLSPEC_HIDDEN;
 void wined3d_device_uninit_3d(struct wined3d_device *device) DECLSPEC_HIDDEN;
 
+/* A persistently mapped buffer object given up by a dynamic buffer on a
+ * DISCARD map, waiting for the GPU to finish using it. */
+struct wined3d_streaming_bo
+{
+    struct list entry;
+    GLuint name;
+    GLsizeiptr size;
+    void *ptr;
+    BOOL readable;
+    struct wined3d_fence *fence;
+};
+
 struct wined3d_device_gl
 {
     struct wined3d_device d;
 
     /* Textures for when no other textures are bound. */
     struct wined3d_dummy_textures dummy_textures;
+
+    /* Retired streaming buffer objects, oldest first. */
+    struct list streaming_bos;
+    SIZE_T streaming_bo_size;
 };
 
 static inline struct wined3d_device_gl *wined3d_device_gl(struct wined3d_device *device)
@@ -3801,6 +3832,8 @@ enum wined3d_push_constants
 #define WINED3D_CS_QUERY_POLL_INTERVAL  10u
 #define WINED3D_CS_QUEUE_SIZE           0x100000u
 #define WINED3D_CS_SPIN_COUNT           10000000u
+#define WINED3D_CS_MAX_OPS              64u
+#define WINED3D_CS_MAX_STATE_CHANGES    64u
 
 struct wined3d_cs_queue
 {
@@ -3815,19 +3848,42 @@ struct wined3d_cs_ops
     void (*finish)(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id);
     void (*push_constants)(struct wined3d_cs *cs, enum wined3d_push_constants p,
             unsigned int start_idx, unsigned int count, const void *constants);
+    void (*acquire_resource)(struct wined3d_cs *cs, struct wined3d_resource *resource);
+};
+
+enum wined3d_cs_state_change_type
+{
+    WINED3D_CS_STATE_CHANGE_RENDER,
+    WINED3D_CS_STATE_CHANGE_TEXTURE,
+    WINED3D_CS_STATE_CHANGE_SAMPLER,
+};
+
+struct wined3d_cs_state_change
+{
+    enum wined3d_cs_state_change_type type;
+    unsigned int idx;
+    unsigned int state;
+    DWORD value;
 };
 
 struct wined3d_cs
 {
     const struct wined3d_cs_ops *ops;
     struct wined3d_device *device;
+    /* The application side state the emitters read. This is the device state
+     * for the device command stream, and the recording state for deferred
+     * contexts. */
+    const struct wined3d_state *app_state;
     struct wined3d_fb_state fb;
     struct wined3d_state state;
+    /* The state replaced while a command list executes. */
+    struct wined3d_fb_state saved_fb;
+    struct wined3d_state *saved_state;
     HMODULE wined3d_module;
     HANDLE thread;
     DWORD thread_id;
 
-    struct wined3d_cs_queue queue[WINED3D_CS_QUEUE_COUNT];
+    struct wined3d_cs_queue *queue;
     size_t data_size, start, end;
     void *data;
     struct list query_poll_list;
@@ -3836,6 +3892,19 @@ struct wined3d_cs
     HANDLE event;
     BOOL waiting_for_event;
     LONG pending_presents;
+
+    /* Render, texture stage and sampler state changes are batched into a
+     * single packet, which is emitted before the next packet of any other
+     * kind. Only the application thread touches these. */
+    struct wined3d_cs_state_change state_changes[WINED3D_CS_MAX_STATE_CHANGES];
+    unsigned int state_change_count;
+
+    /* Packets executed since the last present. Only the thread executing
+     * the command stream touches these. */
+    unsigned int packet_counts[WINED3D_CS_MAX_OPS];
+    SIZE_T packet_bytes;
+
+    struct wined3d_cs_profiler *profiler;
 };
 
 struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device) DECLSPEC_HIDDEN;
@@ -3865,6 +3934,8 @@ void wined3d_cs_emit_draw(struct wined3d_cs *cs, GLenum primitive_type, unsigned
         unsigned int start_instance, unsigned int instance_count, BOOL indexed) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_draw_indirect(struct wined3d_cs *cs, GLenum primitive_type, unsigned int patch_vertex_count,
         struct wined3d_buffer *buffer, unsigned int offset, BOOL indexed) DECLSPEC_HIDDEN;
+void wined3d_cs_emit_execute_command_list(struct wined3d_cs *cs,
+        struct wined3d_command_list *list) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_flush(struct wined3d_cs *cs) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_generate_mipmaps(struct wined3d_cs *cs, struct wined3d_shader_resource_view *view) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_preload_resource(struct wined3d_cs *cs, struct wined3d_resource *resource) DECLSPEC_HIDDEN;
@@ -3932,14 +4003,20 @@ HRESULT wined3d_cs_map(struct wined3d_cs *cs, struct wined3d_resource *resource,
 HRESULT wined3d_cs_unmap(struct wined3d_cs *cs, struct wined3d_resource *resource,
         unsigned int sub_resource_idx) DECLSPEC_HIDDEN;
 
+void wined3d_cs_flush_state_changes(struct wined3d_cs *cs) DECLSPEC_HIDDEN;
+
 static inline void wined3d_cs_finish(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id)
 {
+    if (cs->state_change_count)
+        wined3d_cs_flush_state_changes(cs);
     cs->ops->finish(cs, queue_id);
 }
 
 static inline void wined3d_cs_push_constants(struct wined3d_cs *cs, enum wined3d_push_constants p,
         unsigned int start_idx, unsigned int count, const void *constants)
 {
+    if (cs->state_change_count)
+        wined3d_cs_flush_state_changes(cs);
     cs->ops->push_constants(cs, p, start_idx, count, constants);
 }
 
@@ -4015,6 +4092,9 @@ struct wined3d_buffer_gl
     GLuint buffer_object;
     GLenum buffer_object_usage;
     GLenum buffer_type_hint;
+    /* Persistent mapping of "buffer_object", for dynamic buffers backed by
+     * immutable storage. */
+    void *persistent_ptr;
 };
 
 static inline struct wined3d_buffer_gl *wined3d_buffer_gl(struct wined3d_buffer *buffer)
@@ -4022,6 +4102,9 @@ static inline struct wined3d_buffer_gl *wined3d_buffer_gl(struct wined3d_buffer
     return CONTAINING_RECORD(buffer, struct wined3d_buffer_gl, b);
 }
 
+void wined3d_device_gl_destroy_streaming_bos(struct wined3d_device_gl *device_gl,
+        struct wined3d_context *context) DECLSPEC_HIDDEN;
+
 struct wined3d_rendertarget_view
 {
     LONG refcount;
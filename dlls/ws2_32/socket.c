@@ -243,6 +243,7 @@ static struct interface_filter generic_interface_filter = {
 #endif /* LINUX_BOUND_IF */
 
 extern ssize_t CDECL __wine_locked_recvmsg( int fd, struct msghdr *hdr, int flags );
+extern void CDECL __wine_fast_sync_demote( HANDLE handle );
 
 /*
  * The actual definition of WSASendTo, wrapped in a different function name
@@ -573,6 +574,8 @@ static NTSTATUS register_async( int type, HANDLE handle, struct ws2_async_io *as
 {
     NTSTATUS status;
 
+    __wine_fast_sync_demote( event );  /* the server will signal it */
+
     SERVER_START_REQ( register_async )
     {
         req->type              = type;
@@ -7337,6 +7340,8 @@ int WINAPI WSAEnumNetworkEvents(SOCKET s, WSAEVENT hEvent, LPWSANETWORKEVENTS lp
 
     TRACE("%04lx, hEvent %p, lpEvent %p\n", s, hEvent, lpEvent );
 
+    __wine_fast_sync_demote( hEvent );  /* the server will reset it */
+
     SERVER_START_REQ( get_socket_event )
     {
         req->handle  = wine_server_obj_handle( SOCKET2HANDLE(s) );
@@ -7368,6 +7373,8 @@ int WINAPI WSAEventSelect(SOCKET s, WSAEVENT hEvent, LONG lEvent)
 
     TRACE("%04lx, hEvent %p, event %08x\n", s, hEvent, lEvent);
 
+    __wine_fast_sync_demote( hEvent );  /* the server will signal it */
+
     SERVER_START_REQ( set_socket_event )
     {
         req->handle = wine_server_obj_handle( SOCKET2HANDLE(s) );
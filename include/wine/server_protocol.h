@@ -50,6 +50,28 @@ struct request_max_size
     int pad[16];
 };
 
+
+struct request_shm
+{
+    unsigned int            seq;
+    unsigned int            reply_seq;
+    data_size_t             size;
+    unsigned int            __pad;
+    struct request_max_size header;
+    char                    data[1];
+};
+
+
+
+struct batch_header
+{
+    data_size_t  size;
+    unsigned int flags;
+};
+
+#define BATCH_PREV_HANDLE  0x01
+#define BATCH_IGNORE_ERROR 0x02
+
 #define FIRST_USER_HANDLE 0x0020
 #define LAST_USER_HANDLE  0xffef
 
@@ -756,6 +778,15 @@ struct rawinput_device
     user_handle_t  target;
 };
 
+struct completion_msg
+{
+    apc_param_t    ckey;
+    apc_param_t    cvalue;
+    apc_param_t    information;
+    unsigned int   status;
+    int            __pad;
+};
+
 
 
 
@@ -892,6 +923,20 @@ struct init_thread_reply
 
 
 
+struct init_request_shm_request
+{
+    struct request_header __header;
+    int          shm_fd;
+    int          doorbell_fd;
+    data_size_t  size;
+};
+struct init_request_shm_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct terminate_process_request
 {
     struct request_header __header;
@@ -1156,6 +1201,22 @@ struct close_handle_reply
 
 
 
+struct batch_request
+{
+    struct request_header __header;
+    /* VARARG(requests,bytes); */
+    char __pad_12[4];
+};
+struct batch_reply
+{
+    struct reply_header __header;
+    unsigned int done;
+    /* VARARG(replies,bytes); */
+    char __pad_12[4];
+};
+
+
+
 struct set_handle_info_request
 {
     struct request_header __header;
@@ -1259,7 +1320,9 @@ struct create_event_request
     unsigned int access;
     int          manual_reset;
     int          initial_state;
+    int          client_state;
     /* VARARG(objattr,object_attributes); */
+    char __pad_28[4];
 };
 struct create_event_reply
 {
@@ -1297,6 +1360,19 @@ struct query_event_reply
 };
 
 
+struct set_event_state_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+    int          state;
+    char __pad_20[4];
+};
+struct set_event_state_reply
+{
+    struct reply_header __header;
+};
+
+
 struct open_event_request
 {
     struct request_header __header;
@@ -1350,8 +1426,8 @@ struct create_mutex_request
     struct request_header __header;
     unsigned int access;
     int          owned;
+    int          client_state;
     /* VARARG(objattr,object_attributes); */
-    char __pad_20[4];
 };
 struct create_mutex_reply
 {
@@ -1408,6 +1484,21 @@ struct query_mutex_reply
 };
 
 
+struct set_mutex_state_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+    thread_id_t  owner;
+    unsigned int count;
+    int          abandoned;
+    char __pad_28[4];
+};
+struct set_mutex_state_reply
+{
+    struct reply_header __header;
+};
+
+
 
 struct create_semaphore_request
 {
@@ -1415,7 +1506,9 @@ struct create_semaphore_request
     unsigned int access;
     unsigned int initial;
     unsigned int max;
+    int          client_state;
     /* VARARG(objattr,object_attributes); */
+    char __pad_28[4];
 };
 struct create_semaphore_reply
 {
@@ -1453,6 +1546,19 @@ struct query_semaphore_reply
 };
 
 
+struct set_semaphore_state_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+    unsigned int count;
+    char __pad_20[4];
+};
+struct set_semaphore_state_reply
+{
+    struct reply_header __header;
+};
+
+
 struct open_semaphore_request
 {
     struct request_header __header;
@@ -5448,6 +5554,19 @@ struct remove_completion_reply
 
 
 
+struct remove_completions_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+};
+struct remove_completions_reply
+{
+    struct reply_header __header;
+    /* VARARG(msgs,completion_msgs); */
+};
+
+
+
 struct query_completion_request
 {
     struct request_header __header;
@@ -5801,6 +5920,7 @@ enum request
     REQ_get_startup_info,
     REQ_init_process_done,
     REQ_init_thread,
+    REQ_init_request_shm,
     REQ_terminate_process,
     REQ_terminate_thread,
     REQ_get_process_info,
@@ -5817,6 +5937,7 @@ enum request
     REQ_queue_apc,
     REQ_get_apc_result,
     REQ_close_handle,
+    REQ_batch,
     REQ_set_handle_info,
     REQ_dup_handle,
     REQ_open_process,
@@ -5825,6 +5946,7 @@ enum request
     REQ_create_event,
     REQ_event_op,
     REQ_query_event,
+    REQ_set_event_state,
     REQ_open_event,
     REQ_create_keyed_event,
     REQ_open_keyed_event,
@@ -5832,9 +5954,11 @@ enum request
     REQ_release_mutex,
     REQ_open_mutex,
     REQ_query_mutex,
+    REQ_set_mutex_state,
     REQ_create_semaphore,
     REQ_release_semaphore,
     REQ_query_semaphore,
+    REQ_set_semaphore_state,
     REQ_open_semaphore,
     REQ_create_file,
     REQ_open_file_object,
@@ -6069,6 +6193,7 @@ enum request
     REQ_open_completion,
     REQ_add_completion,
     REQ_remove_completion,
+    REQ_remove_completions,
     REQ_query_completion,
     REQ_set_completion_info,
     REQ_add_fd_completion,
@@ -6106,6 +6231,7 @@ union generic_request
     struct get_startup_info_request get_startup_info_request;
     struct init_process_done_request init_process_done_request;
     struct init_thread_request init_thread_request;
+    struct init_request_shm_request init_request_shm_request;
     struct terminate_process_request terminate_process_request;
     struct terminate_thread_request terminate_thread_request;
     struct get_process_info_request get_process_info_request;
@@ -6122,6 +6248,7 @@ union generic_request
     struct queue_apc_request queue_apc_request;
     struct get_apc_result_request get_apc_result_request;
     struct close_handle_request close_handle_request;
+    struct batch_request batch_request;
     struct set_handle_info_request set_handle_info_request;
     struct dup_handle_request dup_handle_request;
     struct open_process_request open_process_request;
@@ -6130,6 +6257,7 @@ union generic_request
     struct create_event_request create_event_request;
     struct event_op_request event_op_request;
     struct query_event_request query_event_request;
+    struct set_event_state_request set_event_state_request;
     struct open_event_request open_event_request;
     struct create_keyed_event_request create_keyed_event_request;
     struct open_keyed_event_request open_keyed_event_request;
@@ -6137,9 +6265,11 @@ union generic_request
     struct release_mutex_request release_mutex_request;
     struct open_mutex_request open_mutex_request;
     struct query_mutex_request query_mutex_request;
+    struct set_mutex_state_request set_mutex_state_request;
     struct create_semaphore_request create_semaphore_request;
     struct release_semaphore_request release_semaphore_request;
     struct query_semaphore_request query_semaphore_request;
+    struct set_semaphore_state_request set_semaphore_state_request;
     struct open_semaphore_request open_semaphore_request;
     struct create_file_request create_file_request;
     struct open_file_object_request open_file_object_request;
@@ -6374,6 +6504,7 @@ union generic_request
     struct open_completion_request open_completion_request;
     struct add_completion_request add_completion_request;
     struct remove_completion_request remove_completion_request;
+    struct remove_completions_request remove_completions_request;
     struct query_completion_request query_completion_request;
     struct set_completion_info_request set_completion_info_request;
     struct add_fd_completion_request add_fd_completion_request;
@@ -6409,6 +6540,7 @@ union generic_reply
     struct get_startup_info_reply get_startup_info_reply;
     struct init_process_done_reply init_process_done_reply;
     struct init_thread_reply init_thread_reply;
+    struct init_request_shm_reply init_request_shm_reply;
     struct terminate_process_reply terminate_process_reply;
     struct terminate_thread_reply terminate_thread_reply;
     struct get_process_info_reply get_process_info_reply;
@@ -6425,6 +6557,7 @@ union generic_reply
     struct queue_apc_reply queue_apc_reply;
     struct get_apc_result_reply get_apc_result_reply;
     struct close_handle_reply close_handle_reply;
+    struct batch_reply batch_reply;
     struct set_handle_info_reply set_handle_info_reply;
     struct dup_handle_reply dup_handle_reply;
     struct open_process_reply open_process_reply;
@@ -6433,6 +6566,7 @@ union generic_reply
     struct create_event_reply create_event_reply;
     struct event_op_reply event_op_reply;
     struct query_event_reply query_event_reply;
+    struct set_event_state_reply set_event_state_reply;
     struct open_event_reply open_event_reply;
     struct create_keyed_event_reply create_keyed_event_reply;
     struct open_keyed_event_reply open_keyed_event_reply;
@@ -6440,9 +6574,11 @@ union generic_reply
     struct release_mutex_reply release_mutex_reply;
     struct open_mutex_reply open_mutex_reply;
     struct query_mutex_reply query_mutex_reply;
+    struct set_mutex_state_reply set_mutex_state_reply;
     struct create_semaphore_reply create_semaphore_reply;
     struct release_semaphore_reply release_semaphore_reply;
     struct query_semaphore_reply query_semaphore_reply;
+    struct set_semaphore_state_reply set_semaphore_state_reply;
     struct open_semaphore_reply open_semaphore_reply;
     struct create_file_reply create_file_reply;
     struct open_file_object_reply open_file_object_reply;
@@ -6677,6 +6813,7 @@ union generic_reply
     struct open_completion_reply open_completion_reply;
     struct add_completion_reply add_completion_reply;
     struct remove_completion_reply remove_completion_reply;
+    struct remove_completions_reply remove_completions_reply;
     struct query_completion_reply query_completion_reply;
     struct set_completion_info_reply set_completion_info_reply;
     struct add_fd_completion_reply add_fd_completion_reply;
@@ -6702,6 +6839,6 @@ union generic_reply
     struct resume_process_reply resume_process_reply;
 };
 
-#define SERVER_PROTOCOL_VERSION 585
+#define SERVER_PROTOCOL_VERSION 590
 
 #endif /* __WINE_WINE_SERVER_PROTOCOL_H */
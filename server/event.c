@@ -301,6 +301,7 @@ DECL_HANDLER(create_event)
         else
             reply->handle = alloc_handle_no_access_check( current->process, event,
                                                           req->access, objattr->attributes );
+        if (reply->handle && req->client_state) set_handle_client_state( current->process, reply->handle );
         release_object( event );
     }
 
@@ -354,6 +355,18 @@ DECL_HANDLER(query_event)
     release_object( event );
 }
 
+/* set the state of an event tracked by the client until now */
+DECL_HANDLER(set_event_state)
+{
+    struct event *event;
+
+    /* the state comes from the process ntdll itself, so no access rights are needed */
+    if (!(event = (struct event *)get_handle_obj( current->process, req->handle, 0, &event_ops ))) return;
+    if (req->state) set_event( event );
+    else reset_event( event );
+    release_object( event );
+}
+
 /* create a keyed event */
 DECL_HANDLER(create_keyed_event)
 {
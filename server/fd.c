@@ -363,13 +363,21 @@ static file_pos_t max_unix_offset = OFF_T_MAX;
 
 struct timeout_user
 {
-    struct list           entry;      /* entry in sorted timeout list */
+    unsigned int          index;      /* index in the timeout heap, or EXPIRED_TIMEOUT */
+    unsigned int          seq;        /* insertion sequence number, to order equal timeouts */
+    struct list           entry;      /* entry in the expired list */
     timeout_t             when;       /* timeout expiry (absolute time) */
     timeout_callback      callback;   /* callback function */
     void                 *private;    /* callback private data */
 };
 
-static struct list timeout_list = LIST_INIT(timeout_list);   /* sorted timeouts list */
+#define EXPIRED_TIMEOUT (~0u)
+
+/* pending timeouts, as a binary min-heap ordered by expiry time */
+static struct timeout_user **timeout_heap;
+static unsigned int timeout_count;
+static unsigned int timeout_size;
+static unsigned int timeout_seq;
 timeout_t current_time;
 
 static inline void set_current_time(void)
@@ -380,32 +388,96 @@ static inline void set_current_time(void)
     current_time = (timeout_t)now.tv_sec * TICKS_PER_SEC + now.tv_usec * 10 + ticks_1601_to_1970;
 }
 
+/* check if a timeout expires before another one; the most recently added comes first on ties */
+static inline int timeout_before( const struct timeout_user *a, const struct timeout_user *b )
+{
+    if (a->when != b->when) return a->when < b->when;
+    return (int)(a->seq - b->seq) > 0;
+}
+
+static inline void set_heap_entry( unsigned int index, struct timeout_user *user )
+{
+    timeout_heap[index] = user;
+    user->index = index;
+}
+
+static void timeout_heap_up( unsigned int index )
+{
+    struct timeout_user *user = timeout_heap[index];
+
+    while (index)
+    {
+        unsigned int parent = (index - 1) / 2;
+        if (!timeout_before( user, timeout_heap[parent] )) break;
+        set_heap_entry( index, timeout_heap[parent] );
+        index = parent;
+    }
+    set_heap_entry( index, user );
+}
+
+static void timeout_heap_down( unsigned int index )
+{
+    struct timeout_user *user = timeout_heap[index];
+
+    for (;;)
+    {
+        unsigned int child = 2 * index + 1;
+        if (child >= timeout_count) break;
+        if (child + 1 < timeout_count && timeout_before( timeout_heap[child + 1], timeout_heap[child] ))
+            child++;
+        if (!timeout_before( timeout_heap[child], user )) break;
+        set_heap_entry( index, timeout_heap[child] );
+        index = child;
+    }
+    set_heap_entry( index, user );
+}
+
+/* remove the timeout at a given heap index */
+static void timeout_heap_remove( unsigned int index )
+{
+    struct timeout_user *last = timeout_heap[--timeout_count];
+
+    if (index == timeout_count) return;
+    set_heap_entry( index, last );
+    if (index && timeout_before( last, timeout_heap[(index - 1) / 2] )) timeout_heap_up( index );
+    else timeout_heap_down( index );
+}
+
 /* add a timeout user */
 struct timeout_user *add_timeout_user( timeout_t when, timeout_callback func, void *private )
 {
     struct timeout_user *user;
-    struct list *ptr;
+
+    if (timeout_count == timeout_size)
+    {
+        unsigned int new_size = max( timeout_size * 2, 64 );
+        struct timeout_user **new_heap = realloc( timeout_heap, new_size * sizeof(*new_heap) );
+
+        if (!new_heap)
+        {
+            set_error( STATUS_NO_MEMORY );
+            return NULL;
+        }
+        timeout_heap = new_heap;
+        timeout_size = new_size;
+    }
 
     if (!(user = mem_alloc( sizeof(*user) ))) return NULL;
     user->when     = (when > 0) ? when : current_time - when;
     user->callback = func;
     user->private  = private;
+    user->seq      = timeout_seq++;
 
-    /* Now insert it in the linked list */
-
-    LIST_FOR_EACH( ptr, &timeout_list )
-    {
-        struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-        if (timeout->when >= user->when) break;
-    }
-    list_add_before( ptr, &user->entry );
+    set_heap_entry( timeout_count++, user );
+    timeout_heap_up( user->index );
     return user;
 }
 
 /* remove a timeout user */
 void remove_timeout_user( struct timeout_user *user )
 {
-    list_remove( &user->entry );
+    if (user->index == EXPIRED_TIMEOUT) list_remove( &user->entry );
+    else timeout_heap_remove( user->index );
     free( user );
 }
 
@@ -851,23 +923,20 @@ static void remove_poll_user( struct fd *fd, int user )
 /* process pending timeouts and return the time until the next timeout, in milliseconds */
 static int get_next_timeout(void)
 {
-    if (!list_empty( &timeout_list ))
+    if (timeout_count)
     {
         struct list expired_list, *ptr;
 
-        /* first remove all expired timers from the list */
+        /* first remove all expired timers from the heap */
 
         list_init( &expired_list );
-        while ((ptr = list_head( &timeout_list )) != NULL)
+        while (timeout_count && timeout_heap[0]->when <= current_time)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
+            struct timeout_user *timeout = timeout_heap[0];
 
-            if (timeout->when <= current_time)
-            {
-                list_remove( &timeout->entry );
-                list_add_tail( &expired_list, &timeout->entry );
-            }
-            else break;
+            timeout_heap_remove( 0 );
+            timeout->index = EXPIRED_TIMEOUT;
+            list_add_tail( &expired_list, &timeout->entry );
         }
 
         /* now call the callback for all the removed timers */
@@ -880,10 +949,9 @@ static int get_next_timeout(void)
             free( timeout );
         }
 
-        if ((ptr = list_head( &timeout_list )) != NULL)
+        if (timeout_count)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-            int diff = (timeout->when - current_time + 9999) / 10000;
+            int diff = (timeout_heap[0]->when - current_time + 9999) / 10000;
             if (diff < 0) diff = 0;
             return diff;
         }
@@ -1577,10 +1645,12 @@ static inline void unmount_fd( struct fd *fd )
 
     if (fd->poll_index != -1) set_fd_events( fd, -1 );
 
+    server_write_lock( FD_LOCK );
     if (fd->unix_fd != -1) close( fd->unix_fd );
 
     fd->unix_fd = -1;
     fd->no_fd_status = STATUS_VOLUME_DISMOUNTED;
+    server_write_unlock( FD_LOCK );
     fd->closed->unix_fd = -1;
     fd->closed->unlink = 0;
 
@@ -1640,7 +1710,7 @@ struct fd *alloc_pseudo_fd( const struct fd_ops *fd_user_ops, struct object *use
     fd->sharing    = 0;
     fd->unix_name  = NULL;
     fd->unix_fd    = -1;
-    fd->cacheable  = 0;
+    fd->cacheable  = 1;  /* never gets a unix fd, so the client can cache no_fd_status */
     fd->signaled   = 0;
     fd->fs_locks   = 0;
     fd->poll_index = -1;
@@ -2413,9 +2483,11 @@ static void set_fd_name( struct fd *fd, struct fd *root, const char *nameptr,
         goto failed;
     }
 
+    server_write_lock( FD_LOCK );
     free( fd->unix_name );
     fd->unix_name = name;
     fd->closed->unix_name = name;
+    server_write_unlock( FD_LOCK );
     return;
 
 failed:
@@ -61,7 +61,9 @@ static struct handle_table *global_table;
 #define RESERVED_SHIFT         26
 #define RESERVED_INHERIT       (HANDLE_FLAG_INHERIT << RESERVED_SHIFT)
 #define RESERVED_CLOSE_PROTECT (HANDLE_FLAG_PROTECT_FROM_CLOSE << RESERVED_SHIFT)
-#define RESERVED_ALL           (RESERVED_INHERIT | RESERVED_CLOSE_PROTECT)
+#define RESERVED_CLIENT_STATE  (4 << RESERVED_SHIFT)  /* the client tracks the object state for the handle */
+#define RESERVED_FLAGS         (RESERVED_INHERIT | RESERVED_CLOSE_PROTECT)
+#define RESERVED_ALL           (RESERVED_FLAGS | RESERVED_CLIENT_STATE)
 
 #define MIN_HANDLE_ENTRIES  32
 #define MAX_HANDLE_ENTRIES  0x00ffffff
@@ -194,7 +196,9 @@ void close_process_handles( struct process *process )
 {
     struct handle_table *table = process->handles;
 
+    server_write_lock( HANDLE_LOCK );
     process->handles = NULL;
+    server_write_unlock( HANDLE_LOCK );
     if (table) release_object( table );
 }
 
@@ -236,12 +240,14 @@ static int grow_handle_table( struct handle_table *table )
 static obj_handle_t alloc_entry( struct handle_table *table, void *obj, unsigned int access )
 {
     struct handle_entry *entry = table->entries + table->free;
+    obj_handle_t handle = 0;
     int i;
 
-    for (i = table->free; i <= table->last; i++, entry++) if (!entry->ptr) goto found;
+    server_write_lock( HANDLE_LOCK );
+    for (i = table->free; i <= table->last; i++, entry++) if (!entry->ptr && !entry->access) goto found;
     if (i >= table->count)
     {
-        if (!grow_handle_table( table )) return 0;
+        if (!grow_handle_table( table )) goto done;
         entry = table->entries + i;  /* the entries may have moved */
     }
     table->last = i;
@@ -249,7 +255,10 @@ static obj_handle_t alloc_entry( struct handle_table *table, void *obj, unsigned
     table->free = i + 1;
     entry->ptr    = grab_object_for_handle( obj );
     entry->access = access;
-    return index_to_handle(i);
+    handle = index_to_handle(i);
+ done:
+    server_write_unlock( HANDLE_LOCK );
+    return handle;
 }
 
 /* allocate a handle for an object, incrementing its refcount */
@@ -295,9 +304,14 @@ static obj_handle_t alloc_global_handle_no_access_check( void *obj, unsigned int
 {
     if (!global_table)
     {
-        if (!(global_table = alloc_handle_table( NULL, 0 )))
+        struct handle_table *table;
+
+        if (!(table = alloc_handle_table( NULL, 0 )))
             return 0;
-        make_object_static( &global_table->obj );
+        make_object_static( &table->obj );
+        server_write_lock( HANDLE_LOCK );
+        global_table = table;
+        server_write_unlock( HANDLE_LOCK );
     }
     return handle_local_to_global( alloc_entry( global_table, obj, access ));
 }
@@ -341,7 +355,7 @@ static void shrink_handle_table( struct handle_table *table )
 
     while (table->last >= 0)
     {
-        if (entry->ptr) break;
+        if (entry->ptr || entry->access) break;
         table->last--;
         entry--;
     }
@@ -373,9 +387,12 @@ struct handle_table *copy_handle_table( struct process *process, struct process
         memcpy( ptr, parent_table->entries, (table->last + 1) * sizeof(struct handle_entry) );
         for (i = 0; i <= table->last; i++, ptr++)
         {
-            if (!ptr->ptr) continue;
-            if (ptr->access & RESERVED_INHERIT) grab_object_for_handle( ptr->ptr );
-            else ptr->ptr = NULL; /* don't inherit this entry */
+            if (ptr->ptr && (ptr->access & RESERVED_INHERIT)) grab_object_for_handle( ptr->ptr );
+            else  /* don't inherit this entry */
+            {
+                ptr->ptr = NULL;
+                ptr->access = 0;
+            }
         }
     }
     /* attempt to shrink the table */
@@ -383,6 +400,38 @@ struct handle_table *copy_handle_table( struct process *process, struct process
     return table;
 }
 
+/* mark a handle whose object state is tracked by the client of its process */
+void set_handle_client_state( struct process *process, obj_handle_t handle )
+{
+    struct handle_entry *entry;
+
+    server_write_lock( HANDLE_LOCK );
+    if ((entry = get_handle( process, handle ))) entry->access |= RESERVED_CLIENT_STATE;
+    server_write_unlock( HANDLE_LOCK );
+}
+
+/* free a handle entry, making it available for new handles */
+static void free_handle_entry( struct handle_table *table, struct handle_entry *entry )
+{
+    entry->ptr = NULL;
+    entry->access = 0;
+    if (entry < table->entries + table->free) table->free = entry - table->entries;
+    if (entry == table->entries + table->last) shrink_handle_table( table );
+}
+
+/* release an entry that was kept reserved when another process closed the handle */
+static void release_reserved_handle( struct process *process, obj_handle_t handle )
+{
+    struct handle_table *table = process->handles;
+    int index = handle_to_index( handle );
+
+    if (!table || handle_is_global( handle ) || index < 0 || index > table->last) return;
+    if (table->entries[index].ptr || table->entries[index].access != RESERVED_CLIENT_STATE) return;
+    server_write_lock( HANDLE_LOCK );
+    free_handle_entry( table, table->entries + index );
+    server_write_unlock( HANDLE_LOCK );
+}
+
 /* close a handle and decrement the refcount of the associated object */
 unsigned int close_handle( struct process *process, obj_handle_t handle )
 {
@@ -390,14 +439,25 @@ unsigned int close_handle( struct process *process, obj_handle_t handle )
     struct handle_entry *entry;
     struct object *obj;
 
-    if (!(entry = get_handle( process, handle ))) return STATUS_INVALID_HANDLE;
+    if (!(entry = get_handle( process, handle )))
+    {
+        if (current && process == current->process) release_reserved_handle( process, handle );
+        return STATUS_INVALID_HANDLE;
+    }
     if (entry->access & RESERVED_CLOSE_PROTECT) return STATUS_HANDLE_NOT_CLOSABLE;
     obj = entry->ptr;
     if (!obj->ops->close_handle( obj, process, handle )) return STATUS_HANDLE_NOT_CLOSABLE;
-    entry->ptr = NULL;
     table = handle_is_global(handle) ? global_table : process->handles;
-    if (entry < table->entries + table->free) table->free = entry - table->entries;
-    if (entry == table->entries + table->last) shrink_handle_table( table );
+    server_write_lock( HANDLE_LOCK );
+    if ((entry->access & RESERVED_CLIENT_STATE) && current && process != current->process)
+    {
+        /* the client still has state attached to the handle value, so it
+         * must not be reused until the process closes the handle itself */
+        entry->ptr = NULL;
+        entry->access = RESERVED_CLIENT_STATE;
+    }
+    else free_handle_entry( table, entry );
+    server_write_unlock( HANDLE_LOCK );
     release_object_from_handle( obj );
     return STATUS_SUCCESS;
 }
@@ -430,41 +490,51 @@ struct object *get_handle_obj( struct process *process, obj_handle_t handle,
     struct handle_entry *entry;
     struct object *obj;
 
+    server_read_lock( HANDLE_LOCK );
     if (!(obj = get_magic_handle( handle )))
     {
         if (!(entry = get_handle( process, handle )))
         {
             set_error( STATUS_INVALID_HANDLE );
-            return NULL;
+            goto done;
         }
         obj = entry->ptr;
         if (ops && (obj->ops != ops))
         {
             set_error( STATUS_OBJECT_TYPE_MISMATCH );  /* not the right type */
-            return NULL;
+            obj = NULL;
+            goto done;
         }
         if ((entry->access & access) != access)
         {
             set_error( STATUS_ACCESS_DENIED );
-            return NULL;
+            obj = NULL;
+            goto done;
         }
     }
     else if (ops && (obj->ops != ops))
     {
         set_error( STATUS_OBJECT_TYPE_MISMATCH );  /* not the right type */
-        return NULL;
+        obj = NULL;
+        goto done;
     }
-    return grab_object( obj );
+    grab_object( obj );
+done:
+    server_read_unlock( HANDLE_LOCK );
+    return obj;
 }
 
 /* retrieve the access rights of a given handle */
 unsigned int get_handle_access( struct process *process, obj_handle_t handle )
 {
     struct handle_entry *entry;
+    unsigned int access = 0;
 
     if (get_magic_handle( handle )) return ~RESERVED_ALL;  /* magic handles have all access rights */
-    if (!(entry = get_handle( process, handle ))) return 0;
-    return entry->access & ~RESERVED_ALL;
+    server_read_lock( HANDLE_LOCK );
+    if ((entry = get_handle( process, handle ))) access = entry->access & ~RESERVED_ALL;
+    server_read_unlock( HANDLE_LOCK );
+    return access;
 }
 
 /* find the first inherited handle of the given type */
@@ -526,10 +596,12 @@ static int set_handle_flags( struct process *process, obj_handle_t handle, int m
         return -1;
     }
     old_access = entry->access;
-    mask  = (mask << RESERVED_SHIFT) & RESERVED_ALL;
+    mask  = (mask << RESERVED_SHIFT) & RESERVED_FLAGS;
     flags = (flags << RESERVED_SHIFT) & mask;
+    server_write_lock( HANDLE_LOCK );
     entry->access = (entry->access & ~mask) | flags;
-    return (old_access & RESERVED_ALL) >> RESERVED_SHIFT;
+    server_write_unlock( HANDLE_LOCK );
+    return (old_access & RESERVED_FLAGS) >> RESERVED_SHIFT;
 }
 
 /* duplicate a handle */
@@ -538,12 +610,16 @@ obj_handle_t duplicate_handle( struct process *src, obj_handle_t src_handle, str
 {
     obj_handle_t res;
     struct handle_entry *entry;
-    unsigned int src_access;
+    unsigned int src_access, client_state = 0;
     struct object *obj = get_handle_obj( src, src_handle, 0, NULL );
 
     if (!obj) return 0;
     if ((entry = get_handle( src, src_handle )))
+    {
         src_access = entry->access;
+        /* the client shares its state between handles of the same process */
+        if (src == dst) client_state = entry->access & RESERVED_CLIENT_STATE;
+    }
     else  /* pseudo-handle, give it full access */
         src_access = obj->ops->map_access( obj, GENERIC_ALL );
     src_access &= ~RESERVED_ALL;
@@ -569,12 +645,16 @@ obj_handle_t duplicate_handle( struct process *src, obj_handle_t src_handle, str
                  entry && !(entry->access & RESERVED_CLOSE_PROTECT))
         {
             if (attr & OBJ_INHERIT) access |= RESERVED_INHERIT;
-            entry->access = access;
+            server_write_lock( HANDLE_LOCK );
+            entry->access = access | client_state;
+            server_write_unlock( HANDLE_LOCK );
             res = src_handle;
+            client_state = 0;
         }
         else
             res = alloc_handle_entry( dst, obj, access, attr );
     }
+    if (res && client_state) set_handle_client_state( dst, res );
 
     release_object( obj );
     return res;
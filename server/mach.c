@@ -32,6 +32,9 @@
 #ifdef HAVE_SYS_SYSCALL_H
 #include <sys/syscall.h>
 #endif
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/wait.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -55,7 +58,10 @@ static mach_port_t server_mach_port;
 
 void sigchld_callback(void)
 {
-    assert(0);  /* should never be called on MacOS */
+    int status;
+
+    /* only the processes saving the registry are our children */
+    while (waitpid( -1, &status, WNOHANG ) > 0);
 }
 
 static void mach_set_error(kern_return_t mach_error)
@@ -220,6 +220,7 @@ DECL_HANDLER(create_mutex)
         else
             reply->handle = alloc_handle_no_access_check( current->process, mutex,
                                                           req->access, objattr->attributes );
+        if (reply->handle && req->client_state) set_handle_client_state( current->process, reply->handle );
         release_object( mutex );
     }
 
@@ -268,3 +269,39 @@ DECL_HANDLER(query_mutex)
         release_object( mutex );
     }
 }
+
+/* set the state of a mutex tracked by the client until now */
+DECL_HANDLER(set_mutex_state)
+{
+    struct mutex *mutex;
+    struct thread *owner = NULL;
+
+    if (req->owner && req->count)
+    {
+        if (!(owner = get_thread_from_id( req->owner ))) return;
+        if (owner->process != current->process)
+        {
+            set_error( STATUS_ACCESS_DENIED );
+            release_object( owner );
+            return;
+        }
+    }
+
+    /* the state comes from the process ntdll itself, so no access rights are needed */
+    if ((mutex = (struct mutex *)get_handle_obj( current->process, req->handle, 0, &mutex_ops )))
+    {
+        if (mutex->count) set_error( STATUS_MUTANT_NOT_OWNED );
+        else
+        {
+            mutex->abandoned = req->abandoned;
+            if (owner)
+            {
+                do_grab( mutex, owner );
+                mutex->count = req->count;
+            }
+            else wake_up( &mutex->obj, 0 );
+        }
+        release_object( mutex );
+    }
+    if (owner) release_object( owner );
+}
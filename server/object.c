@@ -171,16 +171,16 @@ WCHAR *get_object_full_name( struct object *obj, data_size_t *ret_len )
     static const WCHAR backslash = '\\';
     struct object *ptr = obj;
     data_size_t len = 0;
-    char *ret;
+    char *ret = NULL;
 
+    server_read_lock( NAME_LOCK );
     while (ptr && ptr->name)
     {
         struct object_name *name = ptr->name;
         len += name->len + sizeof(WCHAR);
         ptr = name->parent;
     }
-    if (!len) return NULL;
-    if (!(ret = malloc( len ))) return NULL;
+    if (!len || !(ret = malloc( len ))) goto done;
 
     *ret_len = len;
     while (obj && obj->name)
@@ -191,6 +191,8 @@ WCHAR *get_object_full_name( struct object *obj, data_size_t *ret_len )
         memcpy( ret + len, &backslash, sizeof(WCHAR) );
         obj = name->parent;
     }
+done:
+    server_read_unlock( NAME_LOCK );
     return (WCHAR *)ret;
 }
 
@@ -391,7 +393,9 @@ void unlink_named_object( struct object *obj )
     struct object_name *name_ptr = obj->name;
 
     if (!name_ptr) return;
+    server_write_lock( NAME_LOCK );
     obj->name = NULL;
+    server_write_unlock( NAME_LOCK );
     obj->ops->unlink_name( obj, name_ptr );
     if (name_ptr->parent) release_object( name_ptr->parent );
     free( name_ptr );
@@ -411,7 +415,7 @@ struct object *grab_object( void *ptr )
 {
     struct object *obj = (struct object *)ptr;
     assert( obj->refcount < INT_MAX );
-    obj->refcount++;
+    interlocked_xchg_add( (int *)&obj->refcount, 1 );  /* may be called from request worker threads */
     return obj;
 }
 
@@ -419,8 +423,18 @@ struct object *grab_object( void *ptr )
 void release_object( void *ptr )
 {
     struct object *obj = (struct object *)ptr;
+    int refcount;
+
     assert( obj->refcount );
-    if (!--obj->refcount)
+    if (in_request_worker())
+    {
+        /* objects are only destroyed by the main thread, hand it the last reference */
+        while ((refcount = obj->refcount) > 1)
+            if (interlocked_cmpxchg( (int *)&obj->refcount, refcount - 1, refcount ) == refcount) return;
+        defer_release_object( obj );
+        return;
+    }
+    if (interlocked_xchg_add( (int *)&obj->refcount, -1 ) == 1)
     {
         assert( !obj->handle_count );
         /* if the refcount is 0, nobody can be in the wait queue */
@@ -31,6 +31,24 @@
 
 #define DEBUG_OBJECTS
 
+/* variables that are private to each request worker thread */
+#ifdef __GNUC__
+#define SERVER_THREAD_LOCAL __thread
+#else
+#define SERVER_THREAD_LOCAL
+#endif
+
+/* parts of the server state that request worker threads may read while the main thread runs; */
+/* the main thread holds the corresponding lock for writing while it modifies that state */
+enum server_lock
+{
+    HANDLE_LOCK,     /* handle tables, thread tokens and process sockets */
+    NAME_LOCK,       /* object names */
+    FD_LOCK,         /* unix fds and unix names of fd objects */
+    REGISTRY_LOCK,   /* registry keys and values */
+    NB_SERVER_LOCKS
+};
+
 /* kernel objects */
 
 struct namespace;
@@ -148,6 +166,13 @@ extern void free_kernel_objects( struct object *obj );
 /* that the thing pointed to starts with a struct object... */
 extern struct object *grab_object( void *obj );
 extern void release_object( void *obj );
+/* request worker threads, see request.c */
+extern int in_request_worker(void);
+extern void defer_release_object( struct object *obj );
+extern void server_read_lock( enum server_lock lock );
+extern void server_read_unlock( enum server_lock lock );
+extern void server_write_lock( enum server_lock lock );
+extern void server_write_unlock( enum server_lock lock );
 extern struct object *find_object( const struct namespace *namespace, const struct unicode_str *name,
                                    unsigned int attributes );
 extern struct object *find_object_index( const struct namespace *namespace, unsigned int index );
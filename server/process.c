@@ -994,8 +994,13 @@ void kill_process( struct process *process, int violent_death )
 {
     if (!violent_death && process->msg_fd)  /* normal termination on pipe close */
     {
-        release_object( process->msg_fd );
+        struct fd *msg_fd = process->msg_fd;
+
+        /* request workers may be sending fds on it */
+        server_write_lock( HANDLE_LOCK );
         process->msg_fd = NULL;
+        server_write_unlock( HANDLE_LOCK );
+        release_object( msg_fd );
     }
 
     if (process->sigkill_timeout)  /* already waiting for it to die */
@@ -28,6 +28,9 @@
 #include <stdarg.h>
 #include <sys/types.h>
 #include <unistd.h>
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/wait.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -90,7 +93,10 @@ static int open_proc_lwpctl( struct thread *thread )
 /* handle a SIGCHLD signal */
 void sigchld_callback(void)
 {
-    assert( 0 );  /* should only be called when using ptrace */
+    int status;
+
+    /* only the processes saving the registry are our children */
+    while (waitpid( -1, &status, WNOHANG ) > 0);
 }
 
 /* initialize the process tracing mechanism */
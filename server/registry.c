@@ -35,6 +35,9 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -60,6 +63,27 @@ struct notify
     struct process   *process;  /* process in which the hkey is valid */
 };
 
+/* an entry in a tree of names; the tree is ordered case-insensitively and
+ * each node keeps the size of its subtree to allow lookups by index */
+struct name_node
+{
+    struct name_node *left;        /* entries sorting before this one */
+    struct name_node *right;       /* entries sorting after this one */
+    struct list       order;       /* entry in the tree list of entries in name order */
+    const WCHAR      *name;        /* entry name */
+    data_size_t       namelen;     /* length of entry name */
+    unsigned int      priority;    /* random priority, higher ones are closer to the root */
+    unsigned int      count;       /* number of entries in this subtree */
+};
+
+/* a tree of names; the entries are also linked in name order, so that they
+ * can be walked without lookups */
+struct name_tree
+{
+    struct name_node *root;        /* root entry */
+    struct list       order;       /* entries in name order */
+};
+
 /* a registry key */
 struct key
 {
@@ -69,12 +93,9 @@ struct key
     unsigned short    namelen;     /* length of key name */
     unsigned short    classlen;    /* length of class name */
     struct key       *parent;      /* parent key */
-    int               last_subkey; /* last in use subkey */
-    int               nb_subkeys;  /* count of allocated subkeys */
-    struct key      **subkeys;     /* subkeys array */
-    int               last_value;  /* last in use value */
-    int               nb_values;   /* count of allocated values in array */
-    struct key_value *values;      /* values array */
+    struct name_node  entry;       /* entry in parent subkeys tree */
+    struct name_tree  subkeys;     /* subkeys tree */
+    struct name_tree  values;      /* values tree */
     unsigned int      flags;       /* flags */
     timeout_t         modif;       /* last modification time */
     struct list       notify_list; /* list of notifications */
@@ -91,6 +112,7 @@ struct key
 /* a key value */
 struct key_value
 {
+    struct name_node  entry;   /* entry in key values tree */
     WCHAR            *name;    /* value name */
     unsigned short    namelen; /* length of value name */
     unsigned int      type;    /* value type */
@@ -98,9 +120,6 @@ struct key_value
     void             *data;    /* pointer to value data */
 };
 
-#define MIN_SUBKEYS  8   /* min. number of allocated subkeys per key */
-#define MIN_VALUES   8   /* min. number of allocated values per key */
-
 #define MAX_NAME_LEN  256    /* max. length of a key name */
 #define MAX_VALUE_LEN 16383  /* max. length of a value name */
 
@@ -112,24 +131,276 @@ static const timeout_t save_period = 30 * -TICKS_PER_SEC;  /* delay between peri
 static struct timeout_user *save_timeout_user;  /* saving timer */
 static enum prefix_type { PREFIX_UNKNOWN, PREFIX_32BIT, PREFIX_64BIT } prefix_type;
 
+static unsigned int registry_serial;  /* incremented when entries are added or removed, under the write lock */
+
 static const WCHAR root_name[] = { '\\','R','e','g','i','s','t','r','y','\\' };
 static const WCHAR wow6432node[] = {'W','o','w','6','4','3','2','N','o','d','e'};
 static const WCHAR symlink_value[] = {'S','y','m','b','o','l','i','c','L','i','n','k','V','a','l','u','e'};
 static const struct unicode_str symlink_str = { symlink_value, sizeof(symlink_value) };
 
 static void set_periodic_save_timer(void);
-static struct key_value *find_value( const struct key *key, const struct unicode_str *name, int *index );
+static struct key_value *find_value( const struct key *key, const struct unicode_str *name );
+static void free_value( struct key *key, struct key_value *value );
+
+/* compare the name of a tree entry with the specified name */
+static inline int compare_node_name( const struct name_node *node, const WCHAR *name, data_size_t namelen )
+{
+    int res = memicmpW( node->name, name, min( node->namelen, namelen ) / sizeof(WCHAR) );
+    if (!res) res = node->namelen - namelen;
+    return res;
+}
+
+static inline unsigned int name_tree_count( const struct name_node *node )
+{
+    return node ? node->count : 0;
+}
+
+static inline void update_node_count( struct name_node *node )
+{
+    node->count = 1 + name_tree_count( node->left ) + name_tree_count( node->right );
+}
+
+static inline void name_tree_init( struct name_tree *tree )
+{
+    tree->root = NULL;
+    list_init( &tree->order );
+}
+
+static inline int name_tree_empty( const struct name_tree *tree )
+{
+    return !tree->root;
+}
+
+/* find the entry with the specified name */
+static struct name_node *name_tree_find( const struct name_tree *tree, const struct unicode_str *name )
+{
+    struct name_node *node = tree->root;
+
+    while (node)
+    {
+        int res = compare_node_name( node, name->str, name->len );
+        if (!res) return node;
+        node = (res > 0) ? node->left : node->right;
+    }
+    return NULL;
+}
+
+/* return the entry at the specified position in name order */
+static struct name_node *name_tree_get( const struct name_tree *tree, unsigned int index )
+{
+    struct name_node *node = tree->root;
+
+    while (node)
+    {
+        unsigned int left = name_tree_count( node->left );
+        if (index == left) return node;
+        if (index < left) node = node->left;
+        else
+        {
+            index -= left + 1;
+            node = node->right;
+        }
+    }
+    return NULL;
+}
+
+/* split a tree into the entries sorting before and after the specified name */
+static void name_tree_split( struct name_node *node, const WCHAR *name, data_size_t namelen,
+                             struct name_node **before, struct name_node **after )
+{
+    if (!node)
+    {
+        *before = *after = NULL;
+        return;
+    }
+    if (compare_node_name( node, name, namelen ) < 0)
+    {
+        *before = node;
+        name_tree_split( node->right, name, namelen, &node->right, after );
+    }
+    else
+    {
+        *after = node;
+        name_tree_split( node->left, name, namelen, before, &node->left );
+    }
+    update_node_count( node );
+}
+
+/* join two trees, all the entries of the first one sorting before those of the second one */
+static struct name_node *name_tree_merge( struct name_node *before, struct name_node *after )
+{
+    if (!before) return after;
+    if (!after) return before;
+    if (before->priority > after->priority)
+    {
+        before->right = name_tree_merge( before->right, after );
+        update_node_count( before );
+        return before;
+    }
+    after->left = name_tree_merge( before, after->left );
+    update_node_count( after );
+    return after;
+}
+
+/* insert an entry; there must not be an existing entry with the same name */
+static void name_tree_insert( struct name_tree *tree, struct name_node *node,
+                              const WCHAR *name, data_size_t namelen )
+{
+    static unsigned int seed = 0x9e3779b9;
+    struct name_node **root = &tree->root, *prev = NULL;
+
+    /* xorshift, the priorities only need to be evenly distributed */
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    node->name     = name;
+    node->namelen  = namelen;
+    node->priority = seed;
+    node->count    = 1;
+
+    /* walk down to the place where the new entry becomes the subtree root */
+    while (*root && (*root)->priority > node->priority)
+    {
+        (*root)->count++;
+        if (compare_node_name( *root, name, namelen ) > 0) root = &(*root)->left;
+        else
+        {
+            prev = *root;
+            root = &(*root)->right;
+        }
+    }
+    name_tree_split( *root, name, namelen, &node->left, &node->right );
+    update_node_count( node );
+    *root = node;
+
+    /* the previous entry is the last one of the left subtree, if any */
+    if (node->left) for (prev = node->left; prev->right; prev = prev->right);
+    list_add_after( prev ? &prev->order : &tree->order, &node->order );
+    registry_serial++;
+}
+
+/* remove an entry from the tree that contains it */
+static void name_tree_remove( struct name_tree *tree, struct name_node *node )
+{
+    struct name_node **root = &tree->root;
+
+    while (*root != node)
+    {
+        assert( *root );
+        (*root)->count--;
+        if (compare_node_name( *root, node->name, node->namelen ) > 0) root = &(*root)->left;
+        else root = &(*root)->right;
+    }
+    *root = name_tree_merge( node->left, node->right );
+    list_remove( &node->order );
+    registry_serial++;
+}
+
+/* return the entry at the specified position in name order for an enumeration request;
+ * enumerations usually ask for consecutive positions, so the position of the last entry
+ * returned to the thread is remembered to walk the list instead of looking up the tree */
+static struct name_node *name_tree_enum( const struct name_tree *tree, unsigned int index )
+{
+    struct registry_cursor *cursor = &current->reg_cursor;
+    struct name_node *node = NULL;
+    struct list *ptr;
+
+    /* nodes are only removed with the write lock held, so an unchanged serial
+     * means that the remembered node is still in the same position */
+    if (cursor->tree == tree && cursor->serial == registry_serial)
+    {
+        if (index == cursor->index) node = cursor->node;
+        else if (index == cursor->index + 1 && (ptr = list_next( &tree->order, &cursor->node->order )))
+            node = LIST_ENTRY( ptr, struct name_node, order );
+    }
+    if (!node && !(node = name_tree_get( tree, index ))) return NULL;
+
+    cursor->tree   = tree;
+    cursor->node   = node;
+    cursor->index  = index;
+    cursor->serial = registry_serial;
+    return node;
+}
+
+static inline unsigned int get_subkey_count( const struct key *key )
+{
+    return name_tree_count( key->subkeys.root );
+}
+
+static inline unsigned int get_value_count( const struct key *key )
+{
+    return name_tree_count( key->values.root );
+}
+
+/* iterate over the subkeys or the values of a key in name order */
+#define LIST_FOR_EACH_SUBKEY( subkey, key ) \
+    LIST_FOR_EACH_ENTRY( subkey, &(key)->subkeys.order, struct key, entry.order )
+#define LIST_FOR_EACH_VALUE( value, key ) \
+    LIST_FOR_EACH_ENTRY( value, &(key)->values.order, struct key_value, entry.order )
 
 /* information about where to save a registry branch */
 struct save_branch_info
 {
     struct key  *key;
     const char  *path;
+    char        *journal_path; /* journal of the changes since the last full save */
+    FILE        *journal;      /* journal file, opened on the first change */
+    off_t        file_size;    /* size of the branch file at the last full save */
+    int          full_save;    /* some changes were not journaled, save the full branch */
+    int          compact_fd;   /* pipe from the process rewriting the branch file, or -1 */
+    long         compact_pos;  /* journal position covered by the rewritten branch file */
+    int          snapshot_ok;  /* the snapshot matches the branch file */
 };
 
 #define MAX_SAVE_BRANCH_INFO 3
 static int save_branch_count;
 static struct save_branch_info save_branch_info[MAX_SAVE_BRANCH_INFO];
+static int journal_enabled;  /* changes are recorded in the journals */
+
+#define JOURNAL_MIN_COMPACT (1024 * 1024)  /* don't rewrite the branch file for smaller journals */
+
+/* binary snapshot of a branch file, loaded at startup instead of parsing the text file */
+struct snapshot_header
+{
+    unsigned int magic;       /* SNAPSHOT_MAGIC */
+    unsigned int version;     /* SNAPSHOT_VERSION */
+    unsigned int arch;        /* prefix type */
+    unsigned int __pad;
+    file_pos_t   file_size;   /* size of the branch file the snapshot was created from */
+    file_pos_t   file_inode;  /* inode of the branch file */
+    timeout_t    file_mtime;  /* modification time of the branch file, in nanoseconds */
+    timeout_t    file_ctime;  /* status change time of the branch file, in nanoseconds */
+    /* followed by the branch key */
+};
+
+/* a key in a snapshot; names and data are padded to SNAPSHOT_ALIGN */
+struct snapshot_key
+{
+    timeout_t    modif;       /* last modification time */
+    unsigned int namelen;     /* length of key name */
+    unsigned int classlen;    /* length of class name */
+    unsigned int flags;       /* key flags (only KEY_SYMLINK) */
+    unsigned int values;      /* number of values */
+    unsigned int subkeys;     /* number of subkeys */
+    unsigned int __pad;
+    /* followed by the name, the class, the values and the subkeys */
+};
+
+/* a value in a snapshot */
+struct snapshot_value
+{
+    unsigned int namelen;     /* length of value name */
+    unsigned int type;        /* value type */
+    data_size_t  len;         /* value data length in bytes */
+    unsigned int __pad;
+    /* followed by the name and the data */
+};
+
+#define SNAPSHOT_MAGIC   0x736e6772  /* "rgns" */
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_ALIGN(len) (((len) + 7) & ~7)
+#define SNAPSHOT_MAX_DEPTH 512
 
 
 /* information about a file being loaded */
@@ -256,30 +527,137 @@ static void dump_value( const struct key_value *value, FILE *f )
     fputc( '\n', f );
 }
 
+/* dump the name and options of a key to a text file */
+static void dump_key_info( const struct key *key, const struct key *base, FILE *f )
+{
+    fprintf( f, "\n[" );
+    if (key != base) dump_path( key, base, f );
+    fprintf( f, "] %u\n", (unsigned int)((key->modif - ticks_1601_to_1970) / TICKS_PER_SEC) );
+    fprintf( f, "#time=%x%08x\n", (unsigned int)(key->modif >> 32), (unsigned int)key->modif );
+    if (key->class)
+    {
+        fprintf( f, "#class=\"" );
+        dump_strW( key->class, key->classlen / sizeof(WCHAR), f, "\"\"" );
+        fprintf( f, "\"\n" );
+    }
+    if (key->flags & KEY_SYMLINK) fputs( "#link\n", f );
+}
+
 /* save a registry and all its subkeys to a text file */
 static void save_subkeys( const struct key *key, const struct key *base, FILE *f )
 {
-    int i;
+    const struct key_value *value;
+    const struct key *subkey;
 
     if (key->flags & KEY_VOLATILE) return;
     /* save key if it has either some values or no subkeys, or needs special options */
     /* keys with no values but subkeys are saved implicitly by saving the subkeys */
-    if ((key->last_value >= 0) || (key->last_subkey == -1) || key->class || (key->flags & KEY_SYMLINK))
+    if (!name_tree_empty( &key->values ) || name_tree_empty( &key->subkeys ) ||
+        key->class || (key->flags & KEY_SYMLINK))
     {
-        fprintf( f, "\n[" );
-        if (key != base) dump_path( key, base, f );
-        fprintf( f, "] %u\n", (unsigned int)((key->modif - ticks_1601_to_1970) / TICKS_PER_SEC) );
-        fprintf( f, "#time=%x%08x\n", (unsigned int)(key->modif >> 32), (unsigned int)key->modif );
-        if (key->class)
+        dump_key_info( key, base, f );
+        LIST_FOR_EACH_VALUE( value, key ) dump_value( value, f );
+    }
+    LIST_FOR_EACH_SUBKEY( subkey, key ) save_subkeys( subkey, base, f );
+}
+
+/*
+ * Changes to the saved branches are appended to a journal file next to the
+ * branch file, using the same format plus deletion entries, i.e. "#delete [key]"
+ * for a deleted key and "name"=- for a deleted value.  Key names may start
+ * with any character, so deleted keys use a directive instead of a marker
+ * in the key line.  Replaying the journal
+ * over the branch file restores the registry; replaying it over a branch file
+ * that already contains some of its changes is harmless.
+ */
+
+/* find the saved branch containing a key */
+static struct save_branch_info *get_key_branch( const struct key *key )
+{
+    int i;
+
+    for ( ; key; key = key->parent)
+        for (i = 0; i < save_branch_count; i++)
+            if (save_branch_info[i].key == key) return &save_branch_info[i];
+    return NULL;
+}
+
+/* return the journal where a change to a key must be recorded, if any */
+static FILE *get_journal( const struct key *key, const struct key **base )
+{
+    struct save_branch_info *branch;
+
+    if (!journal_enabled || (key->flags & KEY_VOLATILE)) return NULL;
+    if (!(branch = get_key_branch( key ))) return NULL;
+    if (branch->full_save) return NULL;  /* the whole branch will be saved anyway */
+    if (!branch->journal)
+    {
+        if (fchdir( config_dir_fd ) == -1) return NULL;
+        if ((branch->journal = fopen( branch->journal_path, "a" )))
         {
-            fprintf( f, "#class=\"" );
-            dump_strW( key->class, key->classlen / sizeof(WCHAR), f, "\"\"" );
-            fprintf( f, "\"\n" );
+            fseek( branch->journal, 0, SEEK_END );
+            if (!ftell( branch->journal ))
+                fprintf( branch->journal, "WINE REGISTRY Version 2\n;; Changes to %s\n", branch->path );
         }
-        if (key->flags & KEY_SYMLINK) fputs( "#link\n", f );
-        for (i = 0; i <= key->last_value; i++) dump_value( &key->values[i], f );
+        else branch->full_save = 1;
+        if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
     }
-    for (i = 0; i <= key->last_subkey; i++) save_subkeys( key->subkeys[i], base, f );
+    *base = branch->key;
+    return branch->journal;
+}
+
+/* record the creation of a key */
+static void journal_key( const struct key *key )
+{
+    const struct key *base;
+    FILE *f;
+
+    if ((f = get_journal( key, &base ))) dump_key_info( key, base, f );
+}
+
+/* record the deletion of a key */
+static void journal_delete_key( const struct key *key )
+{
+    const struct key *base;
+    FILE *f;
+
+    if (!(f = get_journal( key, &base ))) return;
+    if (key == base)
+    {
+        get_key_branch( key )->full_save = 1;
+        return;
+    }
+    fprintf( f, "\n#delete [" );
+    dump_path( key, base, f );
+    fprintf( f, "]\n" );
+}
+
+/* record the new contents of a value */
+static void journal_value( const struct key *key, const struct key_value *value )
+{
+    const struct key *base;
+    FILE *f;
+
+    if (!(f = get_journal( key, &base ))) return;
+    dump_key_info( key, base, f );
+    dump_value( value, f );
+}
+
+/* record the deletion of a value */
+static void journal_delete_value( const struct key *key, const struct key_value *value )
+{
+    const struct key *base;
+    FILE *f;
+
+    if (!(f = get_journal( key, &base ))) return;
+    dump_key_info( key, base, f );
+    if (value->namelen)
+    {
+        fputc( '\"', f );
+        dump_strW( value->name, value->namelen / sizeof(WCHAR), f, "\"\"" );
+        fprintf( f, "\"=-\n" );
+    }
+    else fprintf( f, "@=-\n" );
 }
 
 static void dump_operation( const struct key *key, const struct key_value *value, const char *op )
@@ -406,25 +784,24 @@ static int key_close_handle( struct object *obj, struct process *process, obj_ha
 
 static void key_destroy( struct object *obj )
 {
-    int i;
     struct list *ptr;
+    struct name_node *node;
     struct key *key = (struct key *)obj;
     assert( obj->ops == &key_ops );
 
+    /* this can happen outside of registry requests, when the last handle to a deleted key is closed */
+    server_write_lock( REGISTRY_LOCK );
     free( key->name );
     free( key->class );
-    for (i = 0; i <= key->last_value; i++)
-    {
-        free( key->values[i].name );
-        free( key->values[i].data );
-    }
-    free( key->values );
-    for (i = 0; i <= key->last_subkey; i++)
+    while ((node = key->values.root)) free_value( key, LIST_ENTRY( node, struct key_value, entry ));
+    while ((node = key->subkeys.root))
     {
-        key->subkeys[i]->parent = NULL;
-        release_object( key->subkeys[i] );
+        struct key *subkey = LIST_ENTRY( node, struct key, entry );
+        name_tree_remove( &key->subkeys, node );
+        subkey->parent = NULL;
+        release_object( subkey );
     }
-    free( key->subkeys );
+    server_write_unlock( REGISTRY_LOCK );
     /* unconditionally notify everything waiting on this key */
     while ((ptr = list_head( &key->notify_list )))
     {
@@ -485,12 +862,8 @@ static struct key *alloc_key( const struct unicode_str *name, timeout_t modif )
         key->namelen     = name->len;
         key->classlen    = 0;
         key->flags       = 0;
-        key->last_subkey = -1;
-        key->nb_subkeys  = 0;
-        key->subkeys     = NULL;
-        key->nb_values   = 0;
-        key->last_value  = -1;
-        key->values      = NULL;
+        name_tree_init( &key->subkeys );
+        name_tree_init( &key->values );
         key->modif       = modif;
         key->parent      = NULL;
         list_init( &key->notify_list );
@@ -517,12 +890,12 @@ static void make_dirty( struct key *key )
 /* mark a key and all its subkeys as clean (not modified) */
 static void make_clean( struct key *key )
 {
-    int i;
+    struct key *subkey;
 
     if (key->flags & KEY_VOLATILE) return;
     if (!(key->flags & KEY_DIRTY)) return;
     key->flags &= ~KEY_DIRTY;
-    for (i = 0; i <= key->last_subkey; i++) make_clean( key->subkeys[i] );
+    LIST_FOR_EACH_SUBKEY( subkey, key ) make_clean( subkey );
 }
 
 /* go through all the notifications and send them if necessary */
@@ -552,54 +925,20 @@ static void touch_key( struct key *key, unsigned int change )
         check_notify( k, change, 0 );
 }
 
-/* try to grow the array of subkeys; return 1 if OK, 0 on error */
-static int grow_subkeys( struct key *key )
-{
-    struct key **new_subkeys;
-    int nb_subkeys;
-
-    if (key->nb_subkeys)
-    {
-        nb_subkeys = key->nb_subkeys + (key->nb_subkeys / 2);  /* grow by 50% */
-        if (!(new_subkeys = realloc( key->subkeys, nb_subkeys * sizeof(*new_subkeys) )))
-        {
-            set_error( STATUS_NO_MEMORY );
-            return 0;
-        }
-    }
-    else
-    {
-        nb_subkeys = MIN_SUBKEYS;
-        if (!(new_subkeys = mem_alloc( nb_subkeys * sizeof(*new_subkeys) ))) return 0;
-    }
-    key->subkeys    = new_subkeys;
-    key->nb_subkeys = nb_subkeys;
-    return 1;
-}
-
-/* allocate a subkey for a given key, and return its index */
-static struct key *alloc_subkey( struct key *parent, const struct unicode_str *name,
-                                 int index, timeout_t modif )
+/* allocate a subkey for a given key */
+static struct key *alloc_subkey( struct key *parent, const struct unicode_str *name, timeout_t modif )
 {
     struct key *key;
-    int i;
 
     if (name->len > MAX_NAME_LEN * sizeof(WCHAR))
     {
         set_error( STATUS_INVALID_PARAMETER );
         return NULL;
     }
-    if (parent->last_subkey + 1 == parent->nb_subkeys)
-    {
-        /* need to grow the array */
-        if (!grow_subkeys( parent )) return NULL;
-    }
     if ((key = alloc_key( name, modif )) != NULL)
     {
         key->parent = parent;
-        for (i = ++parent->last_subkey; i > index; i--)
-            parent->subkeys[i] = parent->subkeys[i-1];
-        parent->subkeys[index] = key;
+        name_tree_insert( &parent->subkeys, &key->entry, key->name, key->namelen );
         if (is_wow6432node( key->name, key->namelen ) && !is_wow6432node( parent->name, parent->namelen ))
             parent->flags |= KEY_WOW64;
     }
@@ -607,71 +946,33 @@ static struct key *alloc_subkey( struct key *parent, const struct unicode_str *n
 }
 
 /* free a subkey of a given key */
-static void free_subkey( struct key *parent, int index )
+static void free_subkey( struct key *parent, struct key *key )
 {
-    struct key *key;
-    int i, nb_subkeys;
-
-    assert( index >= 0 );
-    assert( index <= parent->last_subkey );
+    assert( key->parent == parent );
 
-    key = parent->subkeys[index];
-    for (i = index; i < parent->last_subkey; i++) parent->subkeys[i] = parent->subkeys[i + 1];
-    parent->last_subkey--;
+    name_tree_remove( &parent->subkeys, &key->entry );
     key->flags |= KEY_DELETED;
     key->parent = NULL;
     if (is_wow6432node( key->name, key->namelen )) parent->flags &= ~KEY_WOW64;
     release_object( key );
-
-    /* try to shrink the array */
-    nb_subkeys = parent->nb_subkeys;
-    if (nb_subkeys > MIN_SUBKEYS && parent->last_subkey < nb_subkeys / 2)
-    {
-        struct key **new_subkeys;
-        nb_subkeys -= nb_subkeys / 3;  /* shrink by 33% */
-        if (nb_subkeys < MIN_SUBKEYS) nb_subkeys = MIN_SUBKEYS;
-        if (!(new_subkeys = realloc( parent->subkeys, nb_subkeys * sizeof(*new_subkeys) ))) return;
-        parent->subkeys = new_subkeys;
-        parent->nb_subkeys = nb_subkeys;
-    }
 }
 
-/* find the named child of a given key and return its index */
-static struct key *find_subkey( const struct key *key, const struct unicode_str *name, int *index )
+/* find the named child of a given key */
+static struct key *find_subkey( const struct key *key, const struct unicode_str *name )
 {
-    int i, min, max, res;
-    data_size_t len;
-
-    min = 0;
-    max = key->last_subkey;
-    while (min <= max)
-    {
-        i = (min + max) / 2;
-        len = min( key->subkeys[i]->namelen, name->len );
-        res = memicmpW( key->subkeys[i]->name, name->str, len / sizeof(WCHAR) );
-        if (!res) res = key->subkeys[i]->namelen - name->len;
-        if (!res)
-        {
-            *index = i;
-            return key->subkeys[i];
-        }
-        if (res > 0) max = i - 1;
-        else min = i + 1;
-    }
-    *index = min;  /* this is where we should insert it */
-    return NULL;
+    struct name_node *node = name_tree_find( &key->subkeys, name );
+    return node ? LIST_ENTRY( node, struct key, entry ) : NULL;
 }
 
 /* return the wow64 variant of the key, or the key itself if none */
 static struct key *find_wow64_subkey( struct key *key, const struct unicode_str *name )
 {
     static const struct unicode_str wow6432node_str = { wow6432node, sizeof(wow6432node) };
-    int index;
 
     if (!(key->flags & KEY_WOW64)) return key;
     if (!is_wow6432node( name->str, name->len ))
     {
-        key = find_subkey( key, &wow6432node_str, &index );
+        key = find_subkey( key, &wow6432node_str );
         assert( key );  /* if KEY_WOW64 is set we must find it */
     }
     return key;
@@ -683,11 +984,10 @@ static struct key *follow_symlink( struct key *key, int iteration )
 {
     struct unicode_str path, token;
     struct key_value *value;
-    int index;
 
     if (iteration > 16) return NULL;
     if (!(key->flags & KEY_SYMLINK)) return key;
-    if (!(value = find_value( key, &symlink_str, &index ))) return NULL;
+    if (!(value = find_value( key, &symlink_str ))) return NULL;
 
     path.str = value->data;
     path.len = (value->len / sizeof(WCHAR)) * sizeof(WCHAR);
@@ -701,7 +1001,7 @@ static struct key *follow_symlink( struct key *key, int iteration )
     if (!get_path_token( &path, &token )) return NULL;
     while (token.len)
     {
-        if (!(key = find_subkey( key, &token, &index ))) break;
+        if (!(key = find_subkey( key, &token ))) break;
         if (!(key = follow_symlink( key, iteration + 1 ))) break;
         get_path_token( &path, &token );
     }
@@ -711,7 +1011,7 @@ static struct key *follow_symlink( struct key *key, int iteration )
 /* open a key until we find an element that doesn't exist */
 /* helper for open_key and create_key */
 static struct key *open_key_prefix( struct key *key, const struct unicode_str *name,
-                                    unsigned int access, struct unicode_str *token, int *index )
+                                    unsigned int access, struct unicode_str *token )
 {
     token->str = NULL;
     if (!get_path_token( name, token )) return NULL;
@@ -719,13 +1019,13 @@ static struct key *open_key_prefix( struct key *key, const struct unicode_str *n
     while (token->len)
     {
         struct key *subkey;
-        if (!(subkey = find_subkey( key, token, index )))
+        if (!(subkey = find_subkey( key, token )))
         {
             if ((key->flags & KEY_WOWSHARE) && !(access & KEY_WOW64_64KEY))
             {
                 /* try in the 64-bit parent */
                 key = key->parent;
-                subkey = find_subkey( key, token, index );
+                subkey = find_subkey( key, token );
             }
         }
         if (!subkey) break;
@@ -746,10 +1046,9 @@ static struct key *open_key_prefix( struct key *key, const struct unicode_str *n
 static struct key *open_key( struct key *key, const struct unicode_str *name, unsigned int access,
                              unsigned int attributes )
 {
-    int index;
     struct unicode_str token;
 
-    if (!(key = open_key_prefix( key, name, access, &token, &index ))) return NULL;
+    if (!(key = open_key_prefix( key, name, access, &token ))) return NULL;
 
     if (token.len)
     {
@@ -773,11 +1072,10 @@ static struct key *create_key( struct key *key, const struct unicode_str *name,
                                unsigned int access, unsigned int attributes,
                                const struct security_descriptor *sd, int *created )
 {
-    int index;
     struct unicode_str token, next;
 
     *created = 0;
-    if (!(key = open_key_prefix( key, name, access, &token, &index ))) return NULL;
+    if (!(key = open_key_prefix( key, name, access, &token ))) return NULL;
 
     if (!token.len)  /* the key already exists */
     {
@@ -813,7 +1111,7 @@ static struct key *create_key( struct key *key, const struct unicode_str *name,
     }
     *created = 1;
     make_dirty( key );
-    if (!(key = alloc_subkey( key, &token, index, current_time ))) return NULL;
+    if (!(key = alloc_subkey( key, &token, current_time ))) return NULL;
 
     if (options & REG_OPTION_CREATE_LINK) key->flags |= KEY_SYMLINK;
     if (options & REG_OPTION_VOLATILE) key->flags |= KEY_VOLATILE;
@@ -829,6 +1127,7 @@ static struct key *create_key( struct key *key, const struct unicode_str *name,
         free(key->class);
         if (!(key->class = memdup( class->str, key->classlen ))) key->classlen = 0;
     }
+    journal_key( key );
     touch_key( key->parent, REG_NOTIFY_CHANGE_NAME );
     grab_object( key );
     return key;
@@ -838,7 +1137,6 @@ static struct key *create_key( struct key *key, const struct unicode_str *name,
 static struct key *create_key_recursive( struct key *key, const struct unicode_str *name, timeout_t modif )
 {
     struct key *base;
-    int index;
     struct unicode_str token;
 
     token.str = NULL;
@@ -846,7 +1144,7 @@ static struct key *create_key_recursive( struct key *key, const struct unicode_s
     while (token.len)
     {
         struct key *subkey;
-        if (!(subkey = find_subkey( key, &token, &index ))) break;
+        if (!(subkey = find_subkey( key, &token ))) break;
         key = subkey;
         if (!(key = follow_symlink( key, 0 )))
         {
@@ -858,16 +1156,15 @@ static struct key *create_key_recursive( struct key *key, const struct unicode_s
 
     if (token.len)
     {
-        if (!(key = alloc_subkey( key, &token, index, modif ))) return NULL;
+        if (!(key = alloc_subkey( key, &token, modif ))) return NULL;
         base = key;
         for (;;)
         {
             get_path_token( name, &token );
             if (!token.len) break;
-            /* we know the index is always 0 in a new key */
-            if (!(key = alloc_subkey( key, &token, 0, modif )))
+            if (!(key = alloc_subkey( key, &token, modif )))
             {
-                free_subkey( base, index );
+                free_subkey( base->parent, base );
                 return NULL;
             }
         }
@@ -882,21 +1179,21 @@ static void enum_key( const struct key *key, int index, int info_class,
                       struct enum_key_reply *reply )
 {
     static const WCHAR backslash[] = { '\\' };
-    int i;
     data_size_t len, namelen, classlen;
     data_size_t max_subkey = 0, max_class = 0;
     data_size_t max_value = 0, max_data = 0;
-    const struct key *k;
+    const struct key_value *value;
+    const struct key *k, *subkey;
     char *data;
 
     if (index != -1)  /* -1 means use the specified key directly */
     {
-        if ((index < 0) || (index > key->last_subkey))
+        if ((index < 0) || ((unsigned int)index >= get_subkey_count( key )))
         {
             set_error( STATUS_NO_MORE_ENTRIES );
             return;
         }
-        key = key->subkeys[index];
+        key = LIST_ENTRY( name_tree_enum( &key->subkeys, index ), struct key, entry );
     }
 
     namelen = key->namelen;
@@ -922,15 +1219,15 @@ static void enum_key( const struct key *key, int index, int info_class,
         break;
     case KeyFullInformation:
     case KeyCachedInformation:
-        for (i = 0; i <= key->last_subkey; i++)
+        LIST_FOR_EACH_SUBKEY( subkey, key )
         {
-            if (key->subkeys[i]->namelen > max_subkey) max_subkey = key->subkeys[i]->namelen;
-            if (key->subkeys[i]->classlen > max_class) max_class = key->subkeys[i]->classlen;
+            if (subkey->namelen > max_subkey) max_subkey = subkey->namelen;
+            if (subkey->classlen > max_class) max_class = subkey->classlen;
         }
-        for (i = 0; i <= key->last_value; i++)
+        LIST_FOR_EACH_VALUE( value, key )
         {
-            if (key->values[i].namelen > max_value) max_value = key->values[i].namelen;
-            if (key->values[i].len > max_data) max_data = key->values[i].len;
+            if (value->namelen > max_value) max_value = value->namelen;
+            if (value->len > max_data) max_data = value->len;
         }
         reply->max_subkey = max_subkey;
         reply->max_class  = max_class;
@@ -945,8 +1242,8 @@ static void enum_key( const struct key *key, int index, int info_class,
         set_error( STATUS_INVALID_PARAMETER );
         return;
     }
-    reply->subkeys = key->last_subkey + 1;
-    reply->values  = key->last_value + 1;
+    reply->subkeys = get_subkey_count( key );
+    reply->values  = get_value_count( key );
     reply->modif   = key->modif;
     reply->total   = namelen + classlen;
 
@@ -986,10 +1283,9 @@ static void enum_key( const struct key *key, int index, int info_class,
 /* delete a key and its values */
 static int delete_key( struct key *key, int recurse )
 {
-    int index;
     struct key *parent = key->parent;
 
-    /* must find parent and index */
+    /* must find parent */
     if (key == root_key)
     {
         set_error( STATUS_ACCESS_DENIED );
@@ -997,113 +1293,74 @@ static int delete_key( struct key *key, int recurse )
     }
     assert( parent );
 
-    while (recurse && (key->last_subkey>=0))
-        if (0 > delete_key(key->subkeys[key->last_subkey], 1))
+    while (recurse && !name_tree_empty( &key->subkeys ))
+        if (0 > delete_key(LIST_ENTRY( list_tail( &key->subkeys.order ), struct key, entry.order ), 1))
             return -1;
 
-    for (index = 0; index <= parent->last_subkey; index++)
-        if (parent->subkeys[index] == key) break;
-    assert( index <= parent->last_subkey );
-
     /* we can only delete a key that has no subkeys */
-    if (key->last_subkey >= 0)
+    if (!name_tree_empty( &key->subkeys ))
     {
         set_error( STATUS_ACCESS_DENIED );
         return -1;
     }
 
     if (debug_level > 1) dump_operation( key, NULL, "Delete" );
-    free_subkey( parent, index );
+    journal_delete_key( key );
+    free_subkey( parent, key );
     touch_key( parent, REG_NOTIFY_CHANGE_NAME );
     return 0;
 }
 
-/* try to grow the array of values; return 1 if OK, 0 on error */
-static int grow_values( struct key *key )
+/* find the named value of a given key */
+static struct key_value *find_value( const struct key *key, const struct unicode_str *name )
 {
-    struct key_value *new_val;
-    int nb_values;
-
-    if (key->nb_values)
-    {
-        nb_values = key->nb_values + (key->nb_values / 2);  /* grow by 50% */
-        if (!(new_val = realloc( key->values, nb_values * sizeof(*new_val) )))
-        {
-            set_error( STATUS_NO_MEMORY );
-            return 0;
-        }
-    }
-    else
-    {
-        nb_values = MIN_VALUES;
-        if (!(new_val = mem_alloc( nb_values * sizeof(*new_val) ))) return 0;
-    }
-    key->values = new_val;
-    key->nb_values = nb_values;
-    return 1;
+    struct name_node *node = name_tree_find( &key->values, name );
+    return node ? LIST_ENTRY( node, struct key_value, entry ) : NULL;
 }
 
-/* find the named value of a given key and return its index in the array */
-static struct key_value *find_value( const struct key *key, const struct unicode_str *name, int *index )
-{
-    int i, min, max, res;
-    data_size_t len;
-
-    min = 0;
-    max = key->last_value;
-    while (min <= max)
-    {
-        i = (min + max) / 2;
-        len = min( key->values[i].namelen, name->len );
-        res = memicmpW( key->values[i].name, name->str, len / sizeof(WCHAR) );
-        if (!res) res = key->values[i].namelen - name->len;
-        if (!res)
-        {
-            *index = i;
-            return &key->values[i];
-        }
-        if (res > 0) max = i - 1;
-        else min = i + 1;
-    }
-    *index = min;  /* this is where we should insert it */
-    return NULL;
-}
-
-/* insert a new value; the index must have been returned by find_value */
-static struct key_value *insert_value( struct key *key, const struct unicode_str *name, int index )
+/* insert a new value; it must not already exist */
+static struct key_value *insert_value( struct key *key, const struct unicode_str *name )
 {
     struct key_value *value;
     WCHAR *new_name = NULL;
-    int i;
 
     if (name->len > MAX_VALUE_LEN * sizeof(WCHAR))
     {
         set_error( STATUS_NAME_TOO_LONG );
         return NULL;
     }
-    if (key->last_value + 1 == key->nb_values)
+    if (!(value = mem_alloc( sizeof(*value) ))) return NULL;
+    if (name->len && !(new_name = memdup( name->str, name->len )))
     {
-        if (!grow_values( key )) return NULL;
+        free( value );
+        return NULL;
     }
-    if (name->len && !(new_name = memdup( name->str, name->len ))) return NULL;
-    for (i = ++key->last_value; i > index; i--) key->values[i] = key->values[i - 1];
-    value = &key->values[index];
     value->name    = new_name;
     value->namelen = name->len;
+    value->type    = 0;
     value->len     = 0;
     value->data    = NULL;
+    name_tree_insert( &key->values, &value->entry, value->name, value->namelen );
     return value;
 }
 
+/* remove a value from its key and free it */
+static void free_value( struct key *key, struct key_value *value )
+{
+    name_tree_remove( &key->values, &value->entry );
+    free( value->name );
+    free( value->data );
+    free( value );
+}
+
 /* set a key value */
 static void set_value( struct key *key, const struct unicode_str *name,
                        int type, const void *data, data_size_t len )
 {
     struct key_value *value;
     void *ptr = NULL;
-    int index;
 
-    if ((value = find_value( key, name, &index )))
+    if ((value = find_value( key, name )))
     {
         /* check if the new value is identical to the existing one */
         if (value->type == type && value->len == len &&
@@ -1128,7 +1385,7 @@ static void set_value( struct key *key, const struct unicode_str *name,
 
     if (!value)
     {
-        if (!(value = insert_value( key, name, index )))
+        if (!(value = insert_value( key, name )))
         {
             free( ptr );
             return;
@@ -1139,6 +1396,7 @@ static void set_value( struct key *key, const struct unicode_str *name,
     value->type  = type;
     value->len   = len;
     value->data  = ptr;
+    journal_value( key, value );
     touch_key( key, REG_NOTIFY_CHANGE_LAST_SET );
     if (debug_level > 1) dump_operation( key, value, "Set" );
 }
@@ -1147,9 +1405,8 @@ static void set_value( struct key *key, const struct unicode_str *name,
 static void get_value( struct key *key, const struct unicode_str *name, int *type, data_size_t *len )
 {
     struct key_value *value;
-    int index;
 
-    if ((value = find_value( key, name, &index )))
+    if ((value = find_value( key, name )))
     {
         *type = value->type;
         *len  = value->len;
@@ -1168,13 +1425,13 @@ static void enum_value( struct key *key, int i, int info_class, struct enum_key_
 {
     struct key_value *value;
 
-    if (i < 0 || i > key->last_value) set_error( STATUS_NO_MORE_ENTRIES );
+    if (i < 0 || (unsigned int)i >= get_value_count( key )) set_error( STATUS_NO_MORE_ENTRIES );
     else
     {
         void *data;
         data_size_t namelen, maxlen;
 
-        value = &key->values[i];
+        value = LIST_ENTRY( name_tree_enum( &key->values, i ), struct key_value, entry );
         reply->type = value->type;
         namelen = value->namelen;
 
@@ -1218,31 +1475,16 @@ static void enum_value( struct key *key, int i, int info_class, struct enum_key_
 static void delete_value( struct key *key, const struct unicode_str *name )
 {
     struct key_value *value;
-    int i, index, nb_values;
 
-    if (!(value = find_value( key, name, &index )))
+    if (!(value = find_value( key, name )))
     {
         set_error( STATUS_OBJECT_NAME_NOT_FOUND );
         return;
     }
     if (debug_level > 1) dump_operation( key, value, "Delete" );
-    free( value->name );
-    free( value->data );
-    for (i = index; i < key->last_value; i++) key->values[i] = key->values[i + 1];
-    key->last_value--;
+    journal_delete_value( key, value );
+    free_value( key, value );
     touch_key( key, REG_NOTIFY_CHANGE_LAST_SET );
-
-    /* try to shrink the array */
-    nb_values = key->nb_values;
-    if (nb_values > MIN_VALUES && key->last_value < nb_values / 2)
-    {
-        struct key_value *new_val;
-        nb_values -= nb_values / 3;  /* shrink by 33% */
-        if (nb_values < MIN_VALUES) nb_values = MIN_VALUES;
-        if (!(new_val = realloc( key->values, nb_values * sizeof(*new_val) ))) return;
-        key->values = new_val;
-        key->nb_values = nb_values;
-    }
 }
 
 /* get the registry key corresponding to an hkey handle */
@@ -1356,23 +1598,22 @@ static int get_data_type( const char *buffer, int *type, int *parse_type )
     return 0;
 }
 
-/* load and create a key from the input file */
-static struct key *load_key( struct key *base, const char *buffer, int prefix_len,
-                             struct file_load_info *info, timeout_t *modif )
+/* parse a key name from the input file, skipping prefix_len path elements */
+static int parse_key_name( const char *buffer, int prefix_len, struct file_load_info *info,
+                           struct unicode_str *name, timeout_t *modif )
 {
     WCHAR *p;
-    struct unicode_str name;
     int res;
     unsigned int mod;
     data_size_t len;
 
-    if (!get_file_tmp_space( info, strlen(buffer) * sizeof(WCHAR) )) return NULL;
+    if (!get_file_tmp_space( info, strlen(buffer) * sizeof(WCHAR) )) return 0;
 
     len = info->tmplen;
     if ((res = parse_strW( info->tmp, &len, buffer, ']' )) == -1)
     {
         file_read_error( "Malformed key", info );
-        return NULL;
+        return 0;
     }
     if (sscanf( buffer + res, " %u", &mod ) == 1)
         *modif = (timeout_t)mod * TICKS_PER_SEC + ticks_1601_to_1970;
@@ -1382,21 +1623,47 @@ static struct key *load_key( struct key *base, const char *buffer, int prefix_le
     p = info->tmp;
     while (prefix_len && *p) { if (*p++ == '\\') prefix_len--; }
 
-    if (!*p)
+    if (!*p && prefix_len > 1)
     {
-        if (prefix_len > 1)
-        {
-            file_read_error( "Malformed key", info );
-            return NULL;
-        }
-        /* empty key name, return base key */
-        return (struct key *)grab_object( base );
+        file_read_error( "Malformed key", info );
+        return 0;
     }
-    name.str = p;
-    name.len = len - (p - info->tmp + 1) * sizeof(WCHAR);
+    name->str = p;
+    name->len = *p ? len - (p - info->tmp + 1) * sizeof(WCHAR) : 0;
+    return 1;
+}
+
+/* load and create a key from the input file */
+static struct key *load_key( struct key *base, const char *buffer, int prefix_len,
+                             struct file_load_info *info, timeout_t *modif )
+{
+    struct unicode_str name;
+
+    if (!parse_key_name( buffer, prefix_len, info, &name, modif )) return NULL;
+    /* empty key name, return base key */
+    if (!name.len) return (struct key *)grab_object( base );
     return create_key_recursive( base, &name, 0 );
 }
 
+/* delete a key listed as deleted in the input file */
+static void load_deleted_key( struct key *base, const char *buffer, int prefix_len,
+                              struct file_load_info *info )
+{
+    struct unicode_str name, token;
+    struct key *key = base;
+    timeout_t modif;
+
+    if (!parse_key_name( buffer, prefix_len, info, &name, &modif )) return;
+    token.str = NULL;
+    if (!get_path_token( &name, &token )) return;
+    while (token.len)
+    {
+        if (!(key = find_subkey( key, &token ))) return;
+        get_path_token( &name, &token );
+    }
+    if (key != base) delete_key( key, 1 );
+}
+
 /* update the modification time of a key (and its parents) after it has been loaded from a file */
 static void update_key_time( struct key *key, timeout_t modif )
 {
@@ -1492,39 +1759,34 @@ static int parse_hex( unsigned char *dest, data_size_t *len, const char *buffer
     return p - buffer;
 }
 
-/* parse a value name and create the corresponding value */
-static struct key_value *parse_value_name( struct key *key, const char *buffer, data_size_t *len,
-                                           struct file_load_info *info )
+/* parse a value name */
+static int parse_value_name( const char *buffer, struct unicode_str *name, data_size_t *len,
+                             struct file_load_info *info )
 {
-    struct key_value *value;
-    struct unicode_str name;
-    int index;
-
-    if (!get_file_tmp_space( info, strlen(buffer) * sizeof(WCHAR) )) return NULL;
-    name.str = info->tmp;
-    name.len = info->tmplen;
+    if (!get_file_tmp_space( info, strlen(buffer) * sizeof(WCHAR) )) return 0;
+    name->str = info->tmp;
+    name->len = info->tmplen;
     if (buffer[0] == '@')
     {
-        name.len = 0;
+        name->len = 0;
         *len = 1;
     }
     else
     {
-        int r = parse_strW( info->tmp, &name.len, buffer + 1, '\"' );
+        int r = parse_strW( info->tmp, &name->len, buffer + 1, '\"' );
         if (r == -1) goto error;
         *len = r + 1; /* for initial quote */
-        name.len -= sizeof(WCHAR);  /* terminating null */
+        name->len -= sizeof(WCHAR);  /* terminating null */
     }
     while (isspace(buffer[*len])) (*len)++;
     if (buffer[*len] != '=') goto error;
     (*len)++;
     while (isspace(buffer[*len])) (*len)++;
-    if (!(value = find_value( key, &name, &index ))) value = insert_value( key, &name, index );
-    return value;
+    return 1;
 
  error:
     file_read_error( "Malformed value name", info );
-    return NULL;
+    return 0;
 }
 
 /* load a value from the input file */
@@ -1535,8 +1797,15 @@ static int load_value( struct key *key, const char *buffer, struct file_load_inf
     int res, type, parse_type;
     data_size_t maxlen, len;
     struct key_value *value;
+    struct unicode_str name;
 
-    if (!(value = parse_value_name( key, buffer, &len, info ))) return 0;
+    if (!parse_value_name( buffer, &name, &len, info )) return 0;
+    if (!strcmp( buffer + len, "-" ))  /* deleted value */
+    {
+        if ((value = find_value( key, &name ))) free_value( key, value );
+        return 1;
+    }
+    if (!(value = find_value( key, &name )) && !(value = insert_value( key, &name ))) return 0;
     if (!(res = get_data_type( buffer + len, &type, &parse_type ))) goto error;
     buffer += len + res;
 
@@ -1661,6 +1930,7 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
             {
                 update_key_time( subkey, modif );
                 release_object( subkey );
+                subkey = NULL;
             }
             if (prefix_len == -1) prefix_len = get_prefix_len( key, p + 1, &info );
             if (!(subkey = load_key( key, p + 1, prefix_len, &info, &modif )))
@@ -1672,7 +1942,18 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
             else file_read_error( "Value without key", &info );
             break;
         case '#':   /* option */
-            if (subkey) load_key_option( subkey, p, &info );
+            if (!strncmp( p, "#delete [", 9 ))  /* deleted key */
+            {
+                if (subkey)
+                {
+                    update_key_time( subkey, modif );
+                    release_object( subkey );
+                    subkey = NULL;
+                }
+                if (prefix_len == -1) prefix_len = get_prefix_len( key, p + 9, &info );
+                load_deleted_key( key, p + 9, prefix_len, &info );
+            }
+            else if (subkey) load_key_option( subkey, p, &info );
             else if (!load_global_option( p, &info )) goto done;
             break;
         case ';':   /* comment */
@@ -1708,35 +1989,346 @@ static void load_registry( struct key *key, obj_handle_t handle )
         FILE *f = fdopen( fd, "r" );
         if (f)
         {
+            struct save_branch_info *branch;
+
             load_keys( key, NULL, f, -1 );
             fclose( f );
+            /* the loaded keys are not journaled */
+            if ((branch = get_key_branch( key ))) branch->full_save = 1;
         }
         else file_set_error();
     }
 }
 
+/* drop an entry left incomplete at the end of a journal, so that it can be replayed */
+static void trim_journal( int fd )
+{
+    char buffer[4096], next = 0;
+    struct stat st;
+    off_t pos;
+    int i, len;
+
+    if (fstat( fd, &st ) == -1 || st.st_size < 2) return;
+    if (pread( fd, buffer, 2, st.st_size - 2 ) != 2) return;
+    if (buffer[1] == '\n' && buffer[0] != '\\') return;  /* ends with a complete line */
+
+    /* truncate before the start of the last entry */
+    for (pos = st.st_size; pos > 0; pos -= len)
+    {
+        len = min( pos, sizeof(buffer) );
+        if (pread( fd, buffer, len, pos - len ) != len) return;
+        for (i = len - 1; i >= 0; next = buffer[i--])
+        {
+            if (buffer[i] != '\n' || next != '[') continue;
+            ftruncate( fd, pos - len + i );
+            return;
+        }
+    }
+}
+
+/* return the modification time of a file with the best available resolution; whole seconds
+ * would let a snapshot survive a change of the same size made within the same second */
+static timeout_t get_file_mtime( const struct stat *st )
+{
+    timeout_t ret = (timeout_t)st->st_mtime * 1000000000;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    ret += st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    ret += st->st_mtimespec.tv_nsec;
+#endif
+    return ret;
+}
+
+/* return the status change time of a file, which unlike the modification time can't be set
+ * back by the user */
+static timeout_t get_file_ctime( const struct stat *st )
+{
+    timeout_t ret = (timeout_t)st->st_ctime * 1000000000;
+#ifdef HAVE_STRUCT_STAT_ST_CTIM
+    ret += st->st_ctim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_CTIMESPEC)
+    ret += st->st_ctimespec.tv_nsec;
+#endif
+    return ret;
+}
+
+/* return the name of the snapshot file corresponding to a branch file */
+static char *get_snapshot_path( const char *path )
+{
+    char *ret = malloc( strlen(path) + sizeof(".snapshot") );
+
+    if (ret)
+    {
+        strcpy( ret, path );
+        strcat( ret, ".snapshot" );
+    }
+    return ret;
+}
+
+static void write_snapshot_data( const void *data, data_size_t len, FILE *f )
+{
+    static const char zero[8];
+
+    fwrite( data, len, 1, f );
+    fwrite( zero, SNAPSHOT_ALIGN(len) - len, 1, f );
+}
+
+/* save a key and its non-volatile subkeys to a snapshot */
+static void save_snapshot_key( const struct key *key, FILE *f )
+{
+    struct snapshot_key rec;
+    struct snapshot_value val;
+    const struct key_value *value;
+    const struct key *subkey;
+
+    memset( &rec, 0, sizeof(rec) );
+    rec.modif    = key->modif;
+    rec.namelen  = key->namelen;
+    rec.classlen = key->classlen;
+    rec.flags    = key->flags & KEY_SYMLINK;
+    rec.values   = get_value_count( key );
+    LIST_FOR_EACH_SUBKEY( subkey, key )
+        if (!(subkey->flags & KEY_VOLATILE)) rec.subkeys++;
+
+    fwrite( &rec, sizeof(rec), 1, f );
+    write_snapshot_data( key->name, key->namelen, f );
+    write_snapshot_data( key->class, key->classlen, f );
+
+    memset( &val, 0, sizeof(val) );
+    LIST_FOR_EACH_VALUE( value, key )
+    {
+        val.namelen = value->namelen;
+        val.type    = value->type;
+        val.len     = value->len;
+        fwrite( &val, sizeof(val), 1, f );
+        write_snapshot_data( value->name, value->namelen, f );
+        write_snapshot_data( value->data, value->len, f );
+    }
+    LIST_FOR_EACH_SUBKEY( subkey, key )
+        if (!(subkey->flags & KEY_VOLATILE)) save_snapshot_key( subkey, f );
+}
+
+/* save a snapshot of a branch matching the current contents of the branch file */
+static int save_snapshot( const struct key *key, const char *path )
+{
+    struct snapshot_header header;
+    char *snapshot, *tmp = NULL;
+    struct stat st;
+    int fd, ret = 0;
+    FILE *f;
+
+    if (!(snapshot = get_snapshot_path( path ))) return 0;
+    if (stat( path, &st ) == -1 || !S_ISREG(st.st_mode)) goto done;
+    if (!(tmp = malloc( strlen(snapshot) + sizeof(".tmp") ))) goto done;
+    strcpy( tmp, snapshot );
+    strcat( tmp, ".tmp" );
+    if ((fd = open( tmp, O_CREAT | O_TRUNC | O_WRONLY, 0666 )) == -1) goto done;
+    if (!(f = fdopen( fd, "w" )))
+    {
+        close( fd );
+        goto done;
+    }
+
+    memset( &header, 0, sizeof(header) );
+    header.magic      = SNAPSHOT_MAGIC;
+    header.version    = SNAPSHOT_VERSION;
+    header.arch       = prefix_type;
+    header.file_size  = st.st_size;
+    header.file_inode = st.st_ino;
+    header.file_mtime = get_file_mtime( &st );
+    header.file_ctime = get_file_ctime( &st );
+    fwrite( &header, sizeof(header), 1, f );
+    save_snapshot_key( key, f );
+    ret = !ferror( f );
+    if (fclose( f )) ret = 0;
+    if (ret) ret = !rename( tmp, snapshot );
+
+done:
+    if (!ret)
+    {
+        if (tmp) unlink( tmp );
+        unlink( snapshot );  /* don't leave a snapshot that doesn't match */
+    }
+    free( tmp );
+    free( snapshot );
+    return ret;
+}
+
+/* get a pointer to snapshot data of the given size, advancing the current position */
+static const void *get_snapshot_data( const char **pos, const char *end, data_size_t len )
+{
+    const char *ret = *pos;
+
+    if (len > end - ret || SNAPSHOT_ALIGN( (size_t)len ) > end - ret) return NULL;
+    *pos += SNAPSHOT_ALIGN( (size_t)len );
+    return ret;
+}
+
+/* load a key from a snapshot; the key is created in the parent if not specified */
+static int load_snapshot_key( struct key *parent, struct key *key, const char **pos, const char *end,
+                              int depth )
+{
+    const struct snapshot_key *rec;
+    const struct snapshot_value *val;
+    struct key_value *value;
+    struct unicode_str name, class;
+    const void *data;
+    unsigned int i;
+
+    if (depth > SNAPSHOT_MAX_DEPTH) return 0;
+    if (!(rec = get_snapshot_data( pos, end, sizeof(*rec) ))) return 0;
+    if (!(name.str = get_snapshot_data( pos, end, rec->namelen ))) return 0;
+    if (!(class.str = get_snapshot_data( pos, end, rec->classlen ))) return 0;
+    name.len = rec->namelen;
+    class.len = rec->classlen;
+
+    if (!key)
+    {
+        if (!name.len || (name.len % sizeof(WCHAR))) return 0;
+        if (!(key = find_subkey( parent, &name )) && !(key = alloc_subkey( parent, &name, 0 ))) return 0;
+    }
+    key->modif = rec->modif;
+    key->flags |= rec->flags & KEY_SYMLINK;
+    if (class.len)
+    {
+        free( key->class );
+        if (!(key->class = memdup( class.str, class.len ))) class.len = 0;
+        key->classlen = class.len;
+    }
+
+    for (i = 0; i < rec->values; i++)
+    {
+        if (!(val = get_snapshot_data( pos, end, sizeof(*val) ))) return 0;
+        if (val->namelen % sizeof(WCHAR)) return 0;
+        if (!(name.str = get_snapshot_data( pos, end, val->namelen ))) return 0;
+        if (!(data = get_snapshot_data( pos, end, val->len ))) return 0;
+        name.len = val->namelen;
+        if (!(value = find_value( key, &name )) && !(value = insert_value( key, &name ))) return 0;
+        free( value->data );
+        value->data = val->len ? memdup( data, val->len ) : NULL;
+        value->len  = value->data ? val->len : 0;
+        value->type = val->type;
+    }
+
+    for (i = 0; i < rec->subkeys; i++)
+        if (!load_snapshot_key( key, NULL, pos, end, depth + 1 )) return 0;
+    return 1;
+}
+
+/* remove everything a failed snapshot load left in a branch key */
+static void clear_branch( struct key *key )
+{
+    while (!name_tree_empty( &key->subkeys ))
+        delete_key( LIST_ENTRY( list_tail( &key->subkeys.order ), struct key, entry.order ), 1 );
+    while (!name_tree_empty( &key->values ))
+        free_value( key, LIST_ENTRY( list_head( &key->values.order ), struct key_value, entry.order ));
+    free( key->class );
+    key->class    = NULL;
+    key->classlen = 0;
+    key->flags   &= ~KEY_SYMLINK;
+}
+
+/* load a branch from its snapshot, if it matches the branch file */
+static int load_snapshot( struct key *key, const char *filename )
+{
+    const struct snapshot_header *header;
+    struct stat st, snapshot_st;
+    const char *pos, *end;
+    char *snapshot;
+    void *base;
+    int fd, ret = 0;
+
+    if (stat( filename, &st ) == -1) return 0;
+    if (!(snapshot = get_snapshot_path( filename ))) return 0;
+    fd = open( snapshot, O_RDONLY );
+    free( snapshot );
+    if (fd == -1) return 0;
+    if (fstat( fd, &snapshot_st ) == -1 || snapshot_st.st_size < sizeof(*header))
+    {
+        close( fd );
+        return 0;
+    }
+    base = mmap( NULL, snapshot_st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if (base == MAP_FAILED) return 0;
+
+    header = base;
+    if (header->magic != SNAPSHOT_MAGIC || header->version != SNAPSHOT_VERSION) goto done;
+    if (header->file_size != st.st_size || header->file_inode != st.st_ino ||
+        header->file_mtime != get_file_mtime( &st ) || header->file_ctime != get_file_ctime( &st )) goto done;
+    if (header->arch != PREFIX_32BIT && header->arch != PREFIX_64BIT) goto done;
+    if (prefix_type != PREFIX_UNKNOWN && header->arch != prefix_type) goto done;
+
+    pos = (const char *)(header + 1);
+    end = (const char *)base + snapshot_st.st_size;
+    if (!(ret = load_snapshot_key( NULL, key, &pos, end, 0 )))
+    {
+        fprintf( stderr, "wineserver: corrupted registry snapshot for %s, loading the file instead\n",
+                 filename );
+        clear_branch( key );
+    }
+    else prefix_type = header->arch;
+
+done:
+    munmap( base, snapshot_st.st_size );
+    return ret;
+}
+
 /* load one of the initial registry files */
 static int load_init_registry_from_file( const char *filename, struct key *key )
 {
-    FILE *f;
+    struct save_branch_info *branch;
+    unsigned int start = get_tick_count();
+    struct stat st;
+    char *journal_path;
+    int replayed = 0, snapshot_ok;
+    FILE *f = NULL, *journal;
 
-    if ((f = fopen( filename, "r" )))
+    if (!(journal_path = malloc( strlen(filename) + sizeof(".journal") )))
+        fatal_error( "out of memory\n" );
+    strcpy( journal_path, filename );
+    strcat( journal_path, ".journal" );
+
+    if (!(snapshot_ok = load_snapshot( key, filename )) && (f = fopen( filename, "r" )))
     {
         load_keys( key, filename, f, 0 );
         fclose( f );
         if (get_error() == STATUS_NOT_REGISTRY_FILE)
         {
             fprintf( stderr, "%s is not a valid registry file\n", filename );
+            free( journal_path );
             return 1;
         }
     }
 
+    /* replay the changes made since the file was last saved */
+    if ((journal = fopen( journal_path, "r+" )))
+    {
+        trim_journal( fileno( journal ));
+        load_keys( key, journal_path, journal, 0 );
+        fclose( journal );
+        make_dirty( key );
+        replayed = 1;
+    }
+    if (debug_level)
+        fprintf( stderr, "wineserver: loaded %s from %s%s in %u ms\n", filename,
+                 snapshot_ok ? "snapshot" : "text", replayed ? " and journal" : "",
+                 get_tick_count() - start );
+
     assert( save_branch_count < MAX_SAVE_BRANCH_INFO );
 
-    save_branch_info[save_branch_count].path = filename;
-    save_branch_info[save_branch_count++].key = (struct key *)grab_object( key );
+    branch = &save_branch_info[save_branch_count++];
+    branch->path         = filename;
+    branch->key          = (struct key *)grab_object( key );
+    branch->journal_path = journal_path;
+    branch->journal      = NULL;
+    branch->file_size    = stat( filename, &st ) ? 0 : st.st_size;
+    branch->full_save    = 0;
+    branch->compact_fd   = -1;
+    branch->compact_pos  = 0;
+    branch->snapshot_ok  = snapshot_ok;
     make_object_static( &key->obj );
-    return (f != NULL);
+    return (f != NULL || snapshot_ok);
 }
 
 static WCHAR *format_user_registry_path( const SID *sid, struct unicode_str *path )
@@ -1865,6 +2457,7 @@ void init_registry(void)
     release_object( hkcu );
 
     /* start the periodic save timer */
+    journal_enabled = 1;
     set_periodic_save_timer();
 
     /* create windows directories */
@@ -1992,6 +2585,7 @@ static int save_branch( struct key *key, const char *path )
         if (ret) ret = !rename( tmp, path );
         if (!ret) unlink( tmp );
     }
+    if (ret) save_snapshot( key, path );
 
 done:
     free( tmp );
@@ -1999,6 +2593,132 @@ done:
     return ret;
 }
 
+/* remove the journal of a branch once the branch file contains all of its changes */
+static void reset_journal( struct save_branch_info *branch )
+{
+    struct stat st;
+
+    if (branch->journal) fclose( branch->journal );
+    branch->journal = NULL;
+    unlink( branch->journal_path );
+    branch->full_save = 0;
+    branch->file_size = stat( branch->path, &st ) ? 0 : st.st_size;
+}
+
+/* drop the start of a journal once the branch file contains its changes */
+static void truncate_journal( struct save_branch_info *branch, long pos )
+{
+    char buffer[8192], *tmp;
+    FILE *in = NULL, *out = NULL;
+    size_t len;
+    int ret = 0;
+
+    fflush( branch->journal );
+    if (ftell( branch->journal ) <= pos)
+    {
+        reset_journal( branch );
+        return;
+    }
+
+    if (!(tmp = malloc( strlen( branch->journal_path ) + sizeof(".tmp") ))) return;
+    strcpy( tmp, branch->journal_path );
+    strcat( tmp, ".tmp" );
+    if (!(in = fopen( branch->journal_path, "r" ))) goto done;
+    if (!(out = fopen( tmp, "w" ))) goto done;
+    fprintf( out, "WINE REGISTRY Version 2\n;; Changes to %s\n", branch->path );
+    fseek( in, pos, SEEK_SET );
+    while ((len = fread( buffer, 1, sizeof(buffer), in ))) fwrite( buffer, 1, len, out );
+    ret = !ferror( in );
+    if (fclose( out )) ret = 0;
+    out = NULL;
+    if (ret) ret = !rename( tmp, branch->journal_path );
+
+done:
+    if (in) fclose( in );
+    if (out) fclose( out );
+    if (!ret) unlink( tmp );
+    free( tmp );
+    if (!ret) return;  /* keep the full journal, replaying it is harmless */
+
+    fclose( branch->journal );
+    if (!(branch->journal = fopen( branch->journal_path, "a" ))) branch->full_save = 1;
+}
+
+/* start rewriting a branch file in a child process, to compact its journal */
+static void start_compaction( struct save_branch_info *branch )
+{
+    char status;
+    int fd[2];
+
+    if (pipe( fd ) == -1) return;
+    branch->compact_pos = ftell( branch->journal );
+    switch (fork_server())
+    {
+    case 0:  /* child */
+        close( fd[0] );
+        status = save_branch( branch->key, branch->path );
+        write( fd[1], &status, 1 );
+        _exit( 0 );
+    case -1:
+        close( fd[0] );
+        close( fd[1] );
+        return;
+    default:
+        close( fd[1] );
+        fcntl( fd[0], F_SETFL, O_NONBLOCK );
+        branch->compact_fd = fd[0];
+        break;
+    }
+}
+
+/* check whether the child process rewriting a branch file is done */
+static void finish_compaction( struct save_branch_info *branch, int wait )
+{
+    char status = 0;
+    struct stat st;
+    int ret;
+
+    if (branch->compact_fd == -1) return;
+    if (wait) fcntl( branch->compact_fd, F_SETFL, 0 );
+    do ret = read( branch->compact_fd, &status, 1 );
+    while (ret == -1 && errno == EINTR);
+    if (ret == -1 && errno == EAGAIN) return;  /* still running */
+
+    close( branch->compact_fd );
+    branch->compact_fd = -1;
+    if (ret == 1 && status)
+    {
+        branch->file_size = stat( branch->path, &st ) ? 0 : st.st_size;
+        truncate_journal( branch, branch->compact_pos );
+    }
+    else fprintf( stderr, "wineserver: could not compact the %s registry journal\n", branch->path );
+}
+
+/* save the changes made to a branch since the last save */
+static void save_branch_changes( struct save_branch_info *branch )
+{
+    unsigned int start = get_tick_count();
+    long size;
+
+    finish_compaction( branch, branch->full_save );
+    if (branch->full_save)
+    {
+        if (save_branch( branch->key, branch->path )) reset_journal( branch );
+        if (debug_level)
+            fprintf( stderr, "wineserver: saved %s in %u ms\n", branch->path, get_tick_count() - start );
+        return;
+    }
+    if (!branch->journal) return;
+
+    fflush( branch->journal );
+    size = ftell( branch->journal );
+    if (branch->compact_fd == -1 && size > max( branch->file_size / 2, JOURNAL_MIN_COMPACT ))
+        start_compaction( branch );
+    if (debug_level)
+        fprintf( stderr, "wineserver: saved %s journal (%ld bytes) in %u ms\n",
+                 branch->path, size, get_tick_count() - start );
+}
+
 /* periodic saving of the registry */
 static void periodic_save( void *arg )
 {
@@ -2006,8 +2726,7 @@ static void periodic_save( void *arg )
 
     if (fchdir( config_dir_fd ) == -1) return;
     save_timeout_user = NULL;
-    for (i = 0; i < save_branch_count; i++)
-        save_branch( save_branch_info[i].key, save_branch_info[i].path );
+    for (i = 0; i < save_branch_count; i++) save_branch_changes( &save_branch_info[i] );
     if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
     set_periodic_save_timer();
 }
@@ -2027,12 +2746,27 @@ void flush_registry(void)
     if (fchdir( config_dir_fd ) == -1) return;
     for (i = 0; i < save_branch_count; i++)
     {
+        unsigned int start = get_tick_count();
+        int dirty = save_branch_info[i].key->flags & KEY_DIRTY;
+
+        finish_compaction( &save_branch_info[i], 1 );
+        /* a clean branch matches its file, create the snapshot if it was missing */
+        if (!dirty && !save_branch_info[i].snapshot_ok)
+            save_branch_info[i].snapshot_ok = save_snapshot( save_branch_info[i].key,
+                                                             save_branch_info[i].path );
         if (!save_branch( save_branch_info[i].key, save_branch_info[i].path ))
         {
             fprintf( stderr, "wineserver: could not save registry branch to %s",
                      save_branch_info[i].path );
             perror( " " );
         }
+        else
+        {
+            reset_journal( &save_branch_info[i] );
+            if (debug_level && dirty)
+                fprintf( stderr, "wineserver: saved %s in %u ms\n", save_branch_info[i].path,
+                         get_tick_count() - start );
+        }
     }
     if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
 }
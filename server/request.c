@@ -51,6 +51,12 @@
 #ifdef HAVE_POLL_H
 #include <poll.h>
 #endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
 #ifdef __APPLE__
 # include <mach/mach_time.h>
 #endif
@@ -124,8 +130,8 @@ static const struct fd_ops master_socket_fd_ops =
 };
 
 
-struct thread *current = NULL;  /* thread handling the current request */
-unsigned int global_error = 0;  /* global error code for when no thread is current */
+SERVER_THREAD_LOCAL struct thread *current = NULL;  /* thread handling the current request */
+SERVER_THREAD_LOCAL unsigned int global_error = 0;  /* global error code for when no thread is current */
 timeout_t server_start_time = 0;  /* server startup time */
 int server_dir_fd = -1;    /* file descriptor for the server dir */
 int config_dir_fd = -1;    /* file descriptor for the config dir */
@@ -133,6 +139,31 @@ int config_dir_fd = -1;    /* file descriptor for the config dir */
 static struct master_socket *master_socket;  /* the master socket object */
 static struct timeout_user *master_timeout;
 
+/* outcome of writing a reply to the client */
+enum reply_status
+{
+    REPLY_SENT,      /* the whole reply has been written */
+    REPLY_PENDING,   /* the rest of the reply has to wait for POLLOUT */
+    REPLY_CLOSED,    /* the client closed the reply pipe */
+    REPLY_PARTIAL,   /* only part of the reply header could be written */
+    REPLY_FAILED     /* the write failed */
+};
+
+/* a request handled by a worker thread */
+struct request_work
+{
+    struct list        entry;        /* entry in the work or done queue */
+    struct thread     *thread;       /* thread that sent the request */
+    enum reply_status  status;       /* outcome of the reply */
+    int                error;        /* bytes written or errno, for protocol errors */
+    int                kill_process; /* kill the process once back in the main thread (1 + violent flag) */
+    unsigned int       nb_released;  /* number of objects to release in the main thread */
+    unsigned int       released_size; /* allocated size of the released array */
+    struct object    **released;     /* objects whose last reference was released by the worker */
+};
+
+static SERVER_THREAD_LOCAL struct request_work *current_work;  /* request handled by this worker thread */
+
 /* complain about a protocol error and terminate the client connection */
 void fatal_protocol_error( struct thread *thread, const char *err, ... )
 {
@@ -251,11 +282,33 @@ void write_reply( struct thread *thread )
         fatal_protocol_error( thread, "reply write: %s\n", strerror( errno ));
 }
 
-/* send a reply to the current thread */
-static void send_reply( union generic_reply *reply )
+/* wake the client waiting for a reply in its request shared memory */
+static void wake_shm_client( struct request_shm *shm )
+{
+#if defined(__linux__) && defined(__NR_futex)
+    syscall( __NR_futex, &shm->reply_seq, 1 /* FUTEX_WAKE */, 1, NULL, 0, 0 );
+#endif
+}
+
+/* send a reply to the current thread, without touching any global state */
+static enum reply_status send_reply( union generic_reply *reply, int *error )
 {
     int ret;
 
+    if (current->reply_to_shm)
+    {
+        struct request_shm *shm = current->request_shm;
+
+        memcpy( &shm->header, reply, sizeof(*reply) );
+        memcpy( shm->data, current->reply_data, current->reply_size );
+        free( current->reply_data );
+        current->reply_data = NULL;
+        current->reply_to_shm = 0;
+        interlocked_xchg( (int *)&shm->reply_seq, current->request_shm_seq );
+        wake_shm_client( shm );
+        return REPLY_SENT;
+    }
+
     if (!current->reply_size)
     {
         if ((ret = write( get_unix_fd( current->reply_fd ),
@@ -272,25 +325,95 @@ static void send_reply( union generic_reply *reply )
 
         if ((ret = writev( get_unix_fd( current->reply_fd ), vec, 2 )) < sizeof(*reply)) goto error;
 
-        if ((current->reply_towrite = current->reply_size - (ret - sizeof(*reply))))
-        {
-            /* couldn't write it all, wait for POLLOUT */
-            set_fd_events( current->reply_fd, POLLOUT );
-            set_fd_events( current->request_fd, 0 );
-            return;
-        }
+        /* couldn't write it all, wait for POLLOUT */
+        if ((current->reply_towrite = current->reply_size - (ret - sizeof(*reply)))) return REPLY_PENDING;
     }
     free( current->reply_data );
     current->reply_data = NULL;
-    return;
+    return REPLY_SENT;
 
  error:
     if (ret >= 0)
-        fatal_protocol_error( current, "partial write %d\n", ret );
-    else if (errno == EPIPE)
-        kill_thread( current, 0 );  /* normal death */
+    {
+        *error = ret;
+        return REPLY_PARTIAL;
+    }
+    *error = errno;
+    return (errno == EPIPE) ? REPLY_CLOSED : REPLY_FAILED;
+}
+
+/* update the thread state according to the outcome of send_reply */
+static void finish_reply( struct thread *thread, enum reply_status status, int error )
+{
+    switch (status)
+    {
+    case REPLY_SENT:
+        break;
+    case REPLY_PENDING:
+        if (thread->state == TERMINATED) break;
+        set_fd_events( thread->reply_fd, POLLOUT );
+        set_fd_events( thread->request_fd, 0 );
+        break;
+    case REPLY_CLOSED:
+        kill_thread( thread, 0 );  /* normal death */
+        break;
+    case REPLY_PARTIAL:
+        fatal_protocol_error( thread, "partial write %d\n", error );
+        break;
+    case REPLY_FAILED:
+        fatal_protocol_error( thread, "reply write: %s\n", strerror( error ));
+        break;
+    }
+}
+
+/* get the lock protecting the server state used by a request, or -1 if none is needed */
+static int get_request_lock( enum request req )
+{
+    switch (req)
+    {
+    /* registry keys are modified by the registry requests themselves */
+    case REQ_create_key:
+    case REQ_open_key:
+    case REQ_delete_key:
+    case REQ_flush_key:
+    case REQ_enum_key:
+    case REQ_set_key_value:
+    case REQ_get_key_value:
+    case REQ_enum_key_value:
+    case REQ_delete_key_value:
+    case REQ_load_registry:
+    case REQ_unload_registry:
+    case REQ_save_registry:
+    case REQ_set_registry_notification:
+        return REGISTRY_LOCK;
+    /* fd objects are modified under the lock, these only need it in worker threads */
+    case REQ_get_handle_fd:
+    case REQ_get_handle_unix_name:
+        return in_request_worker() ? FD_LOCK : -1;
+    default:
+        return -1;
+    }
+}
+
+/* call the handler of a request with the necessary lock held */
+static void invoke_req_handler( enum request req, const void *request, void *reply )
+{
+    int lock = get_request_lock( req );
+
+    if (lock == -1)
+        req_handlers[req]( request, reply );
+    else if (in_request_worker())
+    {
+        server_read_lock( lock );
+        req_handlers[req]( request, reply );
+        server_read_unlock( lock );
+    }
     else
-        fatal_protocol_error( current, "reply write: %s\n", strerror( errno ));
+    {
+        server_write_lock( lock );
+        req_handlers[req]( request, reply );
+        server_write_unlock( lock );
+    }
 }
 
 /* call a request handler */
@@ -307,7 +430,7 @@ static void call_req_handler( struct thread *thread )
     if (debug_level) trace_request();
 
     if (req < REQ_NB_REQUESTS)
-        req_handlers[req]( &current->req, &reply );
+        invoke_req_handler( req, &current->req, &reply );
     else
         set_error( STATUS_NOT_IMPLEMENTED );
 
@@ -315,10 +438,19 @@ static void call_req_handler( struct thread *thread )
     {
         if (current->reply_fd)
         {
+            enum reply_status status;
+            int error = 0;
+
             reply.reply_header.error = current->error;
             reply.reply_header.reply_size = current->reply_size;
             if (debug_level) trace_reply( req, &reply );
-            send_reply( &reply );
+            status = send_reply( &reply, &error );
+            if (current_work)  /* the main thread will take care of it */
+            {
+                current_work->status = status;
+                current_work->error  = error;
+            }
+            else finish_reply( current, status, error );
         }
         else
         {
@@ -329,11 +461,542 @@ static void call_req_handler( struct thread *thread )
     current = NULL;
 }
 
+/* check whether a request can be part of a batch */
+/* they must not block, pass file descriptors, or terminate the current thread */
+static int is_batch_request( enum request req )
+{
+    switch (req)
+    {
+    case REQ_close_handle:
+    case REQ_dup_handle:
+    case REQ_add_fd_completion:
+    case REQ_get_object_info:
+    case REQ_get_object_type:
+    case REQ_get_handle_unix_name:
+    case REQ_open_file_object:
+    case REQ_open_directory:
+    case REQ_get_directory_entry:
+    case REQ_open_symlink:
+    case REQ_query_symlink:
+    case REQ_open_key:
+    case REQ_enum_key:
+    case REQ_get_key_value:
+    case REQ_enum_key_value:
+    case REQ_open_event:
+    case REQ_query_event:
+    case REQ_open_mutex:
+    case REQ_query_mutex:
+    case REQ_open_semaphore:
+    case REQ_query_semaphore:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* execute several requests in a row */
+DECL_HANDLER(batch)
+{
+    const union generic_request batch_req = current->req;  /* req points to current->req */
+    void *batch_data = current->req_data;
+    const char *ptr = batch_data, *end = ptr + batch_req.request_header.request_size;
+    data_size_t reply_max = batch_req.request_header.reply_size, reply_pos = 0, alloc_size = 0;
+    obj_handle_t last_handle = 0;
+    unsigned int error = STATUS_SUCCESS, done = 0;
+    char *replies = NULL, *new_replies;
+
+    while (ptr < end)
+    {
+        const struct batch_header *header = (const struct batch_header *)ptr;
+        const union generic_request *sub = (const union generic_request *)(header + 1);
+        union generic_reply sub_reply;
+        struct batch_header *reply_header;
+        data_size_t size, needed;
+        enum request type;
+
+        /* the entry size must cover the headers before subtracting them, an undersized or zero
+         * size would otherwise wrap around or execute the same entry forever */
+        if (end - ptr < sizeof(*header) + sizeof(*sub) || header->size > end - ptr || (header->size & 7) ||
+            header->size < sizeof(*header) + sizeof(*sub) ||
+            header->size - sizeof(*header) - sizeof(*sub) < sub->request_header.request_size)
+        {
+            error = STATUS_INVALID_PARAMETER;
+            break;
+        }
+        type = sub->request_header.req;
+        if (type >= REQ_NB_REQUESTS || !is_batch_request( type ))
+        {
+            error = STATUS_NOT_SUPPORTED;
+            break;
+        }
+        if (sub->request_header.reply_size > reply_max ||
+            reply_max - reply_pos < sizeof(*reply_header) + sizeof(sub_reply) +
+                                    ((sub->request_header.reply_size + 7) & ~7))
+        {
+            error = STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+        if ((header->flags & BATCH_PREV_HANDLE) && (!req_handle_offsets[type] || !last_handle))
+        {
+            error = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        current->req = *sub;
+        current->req_data = (void *)(sub + 1);
+        if (header->flags & BATCH_PREV_HANDLE)
+            memcpy( (char *)&current->req + req_handle_offsets[type], &last_handle, sizeof(last_handle) );
+        current->reply_size = 0;
+        clear_error();
+        memset( &sub_reply, 0, sizeof(sub_reply) );
+
+        if (debug_level) trace_request();
+        invoke_req_handler( type, &current->req, &sub_reply );
+        sub_reply.reply_header.error = current->error;
+        sub_reply.reply_header.reply_size = current->reply_size;
+        if (debug_level) trace_reply( type, &sub_reply );
+
+        size = (current->reply_size + 7) & ~7;
+        needed = reply_pos + sizeof(*reply_header) + sizeof(sub_reply) + size;
+        if (needed > alloc_size)
+        {
+            alloc_size = min( reply_max, max( needed, max( alloc_size * 2, 4096 )));
+            if (!(new_replies = realloc( replies, alloc_size )))
+            {
+                free( current->reply_data );
+                current->reply_data = NULL;
+                error = STATUS_NO_MEMORY;
+                break;
+            }
+            replies = new_replies;
+        }
+        reply_header = (struct batch_header *)(replies + reply_pos);
+        reply_header->size  = sizeof(*reply_header) + sizeof(sub_reply) + size;
+        reply_header->flags = 0;
+        memcpy( reply_header + 1, &sub_reply, sizeof(sub_reply) );
+        memcpy( (char *)(reply_header + 1) + sizeof(sub_reply), current->reply_data, current->reply_size );
+        memset( (char *)(reply_header + 1) + sizeof(sub_reply) + current->reply_size, 0,
+                size - current->reply_size );
+        reply_pos += reply_header->size;
+        free( current->reply_data );
+        current->reply_data = NULL;
+
+        if (!current->error && reply_handle_offsets[type])
+            memcpy( &last_handle, (char *)&sub_reply + reply_handle_offsets[type], sizeof(last_handle) );
+        done++;
+        ptr += header->size;
+        if (current->error && !(header->flags & BATCH_IGNORE_ERROR)) break;
+    }
+
+    current->req = batch_req;
+    current->req_data = batch_data;
+    current->reply_data = replies;
+    current->reply_size = reply_pos;
+    reply->done = done;
+    set_error( error );
+}
+
+/* kill a client process, deferring it to the main thread when called from a worker */
+static void kill_client_process( struct process *process, int violent )
+{
+    if (current_work)
+    {
+        current_work->kill_process = 1 + violent;
+        return;
+    }
+    kill_process( process, violent );
+}
+
+#ifdef HAVE_PTHREAD_H
+
+/* Requests that only look up handles and read object state can be handled by worker threads,
+ * concurrently with each other and with the main thread. The state they read is protected by
+ * a few reader/writer locks (see enum server_lock): workers take them for reading, and the main
+ * thread, which is the only one modifying the server state, takes them for writing around any
+ * change to the protected state. Workers never destroy objects; the last reference is handed
+ * back to the main thread, along with anything else touching global state (replies to complete,
+ * processes to kill).
+ *
+ * Lock ordering: HANDLE_LOCK is innermost. The main thread only holds it around handle table
+ * updates that don't call out to anything else, while workers may take it with one other lock
+ * held for reading. Workers never take the same lock twice, so writer preference can't make a
+ * worker deadlock against itself. */
+
+#define MAX_WORKERS 64
+
+struct worker_wakeup
+{
+    struct object    obj;         /* object header */
+    struct fd       *fd;          /* file descriptor for the pipe read side */
+    int              pipe_write;  /* unix fd for the pipe write side */
+};
+
+static void worker_wakeup_dump( struct object *obj, int verbose );
+static void worker_wakeup_poll_event( struct fd *fd, int event );
+
+static const struct object_ops worker_wakeup_ops =
+{
+    sizeof(struct worker_wakeup), /* size */
+    worker_wakeup_dump,           /* dump */
+    no_get_type,                  /* get_type */
+    no_add_queue,                 /* add_queue */
+    NULL,                         /* remove_queue */
+    NULL,                         /* signaled */
+    NULL,                         /* satisfied */
+    no_signal,                    /* signal */
+    no_get_fd,                    /* get_fd */
+    no_map_access,                /* map_access */
+    default_get_sd,               /* get_sd */
+    default_set_sd,               /* set_sd */
+    no_lookup_name,               /* lookup_name */
+    no_link_name,                 /* link_name */
+    NULL,                         /* unlink_name */
+    no_open_file,                 /* open_file */
+    no_kernel_obj_list,           /* get_kernel_obj_list */
+    no_close_handle,              /* close_handle */
+    no_destroy                    /* destroy */
+};
+
+static const struct fd_ops worker_wakeup_fd_ops =
+{
+    NULL,                         /* get_poll_events */
+    worker_wakeup_poll_event,     /* poll_event */
+    NULL,                         /* flush */
+    NULL,                         /* get_fd_type */
+    NULL,                         /* ioctl */
+    NULL,                         /* queue_async */
+    NULL                          /* reselect_async */
+};
+
+static int nb_workers;                  /* number of running worker threads */
+static pthread_rwlock_t server_locks[NB_SERVER_LOCKS];
+static unsigned int write_lock_count[NB_SERVER_LOCKS];  /* recursion count of the main thread */
+static pthread_mutex_t work_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t idle_cond = PTHREAD_COND_INITIALIZER;
+static unsigned int nb_busy_workers;    /* workers handling a request, protected by work_mutex */
+static int workers_paused;              /* workers must not pick up new requests */
+static struct list work_queue = LIST_INIT( work_queue );  /* requests waiting for a worker */
+static struct list done_queue = LIST_INIT( done_queue );  /* requests waiting for the main thread */
+static struct worker_wakeup *worker_wakeup;
+
+/* check whether a request can be handled outside of the main thread */
+static int is_parallel_request( enum request req )
+{
+    switch (req)
+    {
+    case REQ_get_handle_fd:
+    case REQ_get_handle_unix_name:
+    case REQ_get_object_info:
+    case REQ_enum_key:
+    case REQ_get_key_value:
+    case REQ_enum_key_value:
+    case REQ_query_event:
+    case REQ_query_semaphore:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* hand a fully read request over to the worker threads; return 0 if it must be handled inline */
+static int queue_request( struct thread *thread )
+{
+    struct request_work *work;
+
+    if (!nb_workers || !is_parallel_request( thread->req.request_header.req )) return 0;
+    if (!(work = malloc( sizeof(*work) ))) return 0;
+
+    work->thread       = (struct thread *)grab_object( thread );
+    work->status       = REPLY_SENT;
+    work->error        = 0;
+    work->kill_process = 0;
+    work->nb_released  = 0;
+    work->released_size = 0;
+    work->released     = NULL;
+    thread->in_worker  = 1;
+
+    pthread_mutex_lock( &work_mutex );
+    list_add_tail( &work_queue, &work->entry );
+    pthread_cond_signal( &work_cond );
+    pthread_mutex_unlock( &work_mutex );
+    return 1;
+}
+
+/* stop reading requests from a thread until its current request is completed */
+static int defer_request( struct thread *thread, struct fd *fd )
+{
+    if (!thread->in_worker) return 0;
+    /* the client may send its next request as soon as the worker has replied */
+    set_fd_events( fd, 0 );
+    thread->worker_deferred = 1;
+    return 1;
+}
+
+/* main function of the request worker threads */
+static void *worker_thread( void *arg )
+{
+    struct request_work *work;
+    struct thread *thread;
+    char dummy = 0;
+    int was_empty;
+
+    for (;;)
+    {
+        pthread_mutex_lock( &work_mutex );
+        while (list_empty( &work_queue ) || workers_paused) pthread_cond_wait( &work_cond, &work_mutex );
+        work = LIST_ENTRY( list_head( &work_queue ), struct request_work, entry );
+        list_remove( &work->entry );
+        nb_busy_workers++;
+        pthread_mutex_unlock( &work_mutex );
+
+        thread = work->thread;
+        current_work = work;
+        /* the thread may have been killed while the request was queued, but its request
+         * buffers and reply fd are only released once the work is completed */
+        if (thread->state != TERMINATED) call_req_handler( thread );
+        free( thread->req_data );
+        thread->req_data = NULL;
+        current_work = NULL;
+
+        pthread_mutex_lock( &work_mutex );
+        was_empty = list_empty( &done_queue );
+        list_add_tail( &done_queue, &work->entry );
+        if (!--nb_busy_workers && workers_paused) pthread_cond_signal( &idle_cond );
+        pthread_mutex_unlock( &work_mutex );
+        if (was_empty) write( worker_wakeup->pipe_write, &dummy, 1 );
+    }
+    return NULL;
+}
+
+static void worker_wakeup_dump( struct object *obj, int verbose )
+{
+    fputs( "Request worker wakeup\n", stderr );
+}
+
+/* complete the requests handled by the workers, in the main thread */
+static void worker_wakeup_poll_event( struct fd *fd, int event )
+{
+    struct list done = LIST_INIT( done );
+    struct request_work *work, *next;
+    char buffer[64];
+    unsigned int i;
+
+    if (event & (POLLERR | POLLHUP))
+    {
+        /* this is not supposed to happen */
+        fatal_error( "error on request worker pipe\n" );
+    }
+
+    /* drain the pipe before grabbing the queue, so that no wakeup can get lost */
+    read( get_unix_fd( fd ), buffer, sizeof(buffer) );
+    pthread_mutex_lock( &work_mutex );
+    list_move_tail( &done, &done_queue );
+    pthread_mutex_unlock( &work_mutex );
+
+    LIST_FOR_EACH_ENTRY_SAFE( work, next, &done, struct request_work, entry )
+    {
+        struct thread *thread = work->thread;
+
+        list_remove( &work->entry );
+        thread->in_worker = 0;
+        if (thread->state == TERMINATED) cleanup_thread_request( thread );
+        else
+        {
+            finish_reply( thread, work->status, work->error );
+            if (thread->worker_deferred && thread->state != TERMINATED)
+            {
+                thread->worker_deferred = 0;
+                if (work->status != REPLY_PENDING) set_fd_events( thread->request_fd, POLLIN );
+                if (thread->doorbell_fd) set_fd_events( thread->doorbell_fd, POLLIN );
+            }
+        }
+        if (work->kill_process) kill_process( thread->process, work->kill_process - 1 );
+        for (i = 0; i < work->nb_released; i++) release_object( work->released[i] );
+        release_object( thread );
+        free( work->released );
+        free( work );
+    }
+}
+
+/* start the request worker threads, if enabled */
+void init_workers(void)
+{
+    pthread_rwlockattr_t attr;
+    pthread_attr_t thread_attr;
+    pthread_t id;
+    sigset_t all_signals, old_mask;
+    const char *env;
+    int fd[2], i, count;
+
+    if (debug_level) return;  /* request tracing isn't thread-safe */
+    if (!(env = getenv( "WINESERVER_WORKERS" ))) return;
+    if ((count = atoi( env )) <= 0) return;
+    if (count > MAX_WORKERS) count = MAX_WORKERS;
+
+    if (pipe( fd ) == -1) return;
+    if (!(worker_wakeup = alloc_object( &worker_wakeup_ops )))
+    {
+        close( fd[0] );
+        close( fd[1] );
+        return;
+    }
+    worker_wakeup->pipe_write = fd[1];
+    if (!(worker_wakeup->fd = create_anonymous_fd( &worker_wakeup_fd_ops, fd[0], &worker_wakeup->obj, 0 )))
+    {
+        release_object( worker_wakeup );
+        worker_wakeup = NULL;
+        return;
+    }
+    set_fd_events( worker_wakeup->fd, POLLIN );
+    make_object_static( &worker_wakeup->obj );
+
+    pthread_rwlockattr_init( &attr );
+#ifdef __GLIBC__
+    /* don't let a steady stream of readers starve the main thread */
+    pthread_rwlockattr_setkind_np( &attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP );
+#endif
+    for (i = 0; i < NB_SERVER_LOCKS; i++) pthread_rwlock_init( &server_locks[i], &attr );
+    pthread_rwlockattr_destroy( &attr );
+
+    /* signals are handled by the main thread */
+    sigfillset( &all_signals );
+    pthread_sigmask( SIG_BLOCK, &all_signals, &old_mask );
+    pthread_attr_init( &thread_attr );
+    pthread_attr_setdetachstate( &thread_attr, PTHREAD_CREATE_DETACHED );
+    for (i = 0; i < count; i++)
+        if (pthread_create( &id, &thread_attr, worker_thread, NULL )) break;
+    pthread_attr_destroy( &thread_attr );
+    pthread_sigmask( SIG_SETMASK, &old_mask, NULL );
+
+    nb_workers = i;
+}
+
+/* check whether we are running in a request worker thread */
+int in_request_worker(void)
+{
+    return current_work != NULL;
+}
+
+/* fork the server process; the child only has the main thread, so the workers are first
+ * stopped outside of any request, where they can't hold a malloc or stdio lock */
+pid_t fork_server(void)
+{
+    pid_t pid;
+
+    assert( !current_work );
+    if (!nb_workers) return fork();
+
+    pthread_mutex_lock( &work_mutex );
+    workers_paused = 1;
+    while (nb_busy_workers) pthread_cond_wait( &idle_cond, &work_mutex );
+    pid = fork();
+    if (pid)  /* the mutex stays locked in the child, which must not use the workers */
+    {
+        workers_paused = 0;
+        pthread_cond_broadcast( &work_cond );
+        pthread_mutex_unlock( &work_mutex );
+    }
+    return pid;
+}
+
+/* hand the last reference to an object over to the main thread */
+void defer_release_object( struct object *obj )
+{
+    struct request_work *work = current_work;
+
+    if (work->nb_released == work->released_size)
+    {
+        unsigned int new_size = max( 4, work->released_size * 2 );
+        struct object **new_released;
+
+        /* on failure the object leaks, it must not be destroyed outside the main thread */
+        if (!(new_released = realloc( work->released, new_size * sizeof(*new_released) ))) return;
+        work->released = new_released;
+        work->released_size = new_size;
+    }
+    work->released[work->nb_released++] = obj;
+}
+
+/* lock some server state for reading; only needed in worker threads */
+void server_read_lock( enum server_lock lock )
+{
+    if (current_work) pthread_rwlock_rdlock( &server_locks[lock] );
+}
+
+void server_read_unlock( enum server_lock lock )
+{
+    if (current_work) pthread_rwlock_unlock( &server_locks[lock] );
+}
+
+/* lock some server state for writing; only allowed in the main thread, can be nested */
+void server_write_lock( enum server_lock lock )
+{
+    assert( !current_work );
+    if (nb_workers && !write_lock_count[lock]++) pthread_rwlock_wrlock( &server_locks[lock] );
+}
+
+void server_write_unlock( enum server_lock lock )
+{
+    if (nb_workers && !--write_lock_count[lock]) pthread_rwlock_unlock( &server_locks[lock] );
+}
+
+#else  /* HAVE_PTHREAD_H */
+
+static int queue_request( struct thread *thread )
+{
+    return 0;
+}
+
+static int defer_request( struct thread *thread, struct fd *fd )
+{
+    return 0;
+}
+
+void init_workers(void)
+{
+}
+
+int in_request_worker(void)
+{
+    return 0;
+}
+
+pid_t fork_server(void)
+{
+    return fork();
+}
+
+void defer_release_object( struct object *obj )
+{
+    assert( 0 );
+}
+
+void server_read_lock( enum server_lock lock )
+{
+}
+
+void server_read_unlock( enum server_lock lock )
+{
+}
+
+void server_write_lock( enum server_lock lock )
+{
+}
+
+void server_write_unlock( enum server_lock lock )
+{
+}
+
+#endif  /* HAVE_PTHREAD_H */
+
 /* read a request from a thread */
 void read_request( struct thread *thread )
 {
     int ret;
 
+    if (defer_request( thread, thread->request_fd )) return;
+
     if (!thread->req_toread)  /* no pending request */
     {
         if ((ret = read( get_unix_fd( thread->request_fd ), &thread->req,
@@ -341,7 +1004,7 @@ void read_request( struct thread *thread )
         if (!(thread->req_toread = thread->req.request_header.request_size))
         {
             /* no data, handle request at once */
-            call_req_handler( thread );
+            if (!queue_request( thread )) call_req_handler( thread );
             return;
         }
         if (!(thread->req_data = malloc( thread->req_toread )))
@@ -362,6 +1025,7 @@ void read_request( struct thread *thread )
         if (ret <= 0) break;
         if (!(thread->req_toread -= ret))
         {
+            if (queue_request( thread )) return;
             call_req_handler( thread );
             free( thread->req_data );
             thread->req_data = NULL;
@@ -378,6 +1042,54 @@ error:
         fatal_protocol_error( thread, "read: %s\n", strerror( errno ));
 }
 
+/* read a request from the thread shared memory, once the client rang the doorbell */
+void read_shm_request( struct thread *thread )
+{
+    struct request_shm *shm = thread->request_shm;
+    unsigned __int64 count;
+    unsigned int seq;
+    data_size_t size;
+
+    if (defer_request( thread, thread->doorbell_fd )) return;
+
+    read( get_unix_fd( thread->doorbell_fd ), &count, sizeof(count) );
+    seq = *(volatile unsigned int *)&shm->seq;
+    if (seq == thread->request_shm_seq) return;  /* nothing new */
+    thread->request_shm_seq = seq;
+
+    if (thread->req_toread || thread->reply_towrite || thread->reply_to_shm)
+    {
+        fatal_protocol_error( thread, "shared memory request while another one is in progress\n" );
+        return;
+    }
+
+    /* copy everything, the client could still modify the shared memory */
+    memcpy( &thread->req, &shm->header, sizeof(thread->req) );
+    size = thread->req.request_header.request_size;
+    if (size > thread->request_shm_size || thread->req.request_header.reply_size > thread->request_shm_size)
+    {
+        fatal_protocol_error( thread, "request %d too large for shared memory\n",
+                              thread->req.request_header.req );
+        return;
+    }
+    if (size)
+    {
+        if (!(thread->req_data = malloc( size )))
+        {
+            fatal_protocol_error( thread, "no memory for %u bytes request %d\n",
+                                  size, thread->req.request_header.req );
+            return;
+        }
+        memcpy( thread->req_data, shm->data, size );
+    }
+
+    thread->reply_to_shm = 1;
+    if (queue_request( thread )) return;
+    call_req_handler( thread );
+    free( thread->req_data );
+    thread->req_data = NULL;
+}
+
 /* receive a file descriptor on the process socket */
 int receive_fd( struct process *process )
 {
@@ -500,24 +1212,32 @@ int send_client_fd( struct process *process, int fd, obj_handle_t handle )
     if (debug_level)
         fprintf( stderr, "%04x: *fd* %04x -> %d\n", current ? current->id : process->id, handle, fd );
 
-    ret = sendmsg( get_unix_fd( process->msg_fd ), &msghdr, 0 );
+    /* the process socket is protected by the handle lock */
+    server_read_lock( HANDLE_LOCK );
+    if (process->msg_fd) ret = sendmsg( get_unix_fd( process->msg_fd ), &msghdr, 0 );
+    else
+    {
+        ret = -1;
+        errno = EPIPE;
+    }
+    server_read_unlock( HANDLE_LOCK );
 
     if (ret == sizeof(handle)) return 0;
 
     if (ret >= 0)
     {
         fprintf( stderr, "Protocol error: process %04x: partial sendmsg %d\n", process->id, ret );
-        kill_process( process, 1 );
+        kill_client_process( process, 1 );
     }
     else if (errno == EPIPE)
     {
-        kill_process( process, 0 );
+        kill_client_process( process, 0 );
     }
     else
     {
         fprintf( stderr, "Protocol error: process %04x: ", process->id );
         perror( "sendmsg" );
-        kill_process( process, 1 );
+        kill_client_process( process, 1 );
     }
     return -1;
 }
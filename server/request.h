@@ -53,6 +53,7 @@ extern const void *get_req_data_after_objattr( const struct object_attributes *a
 extern int receive_fd( struct process *process );
 extern int send_client_fd( struct process *process, int fd, obj_handle_t handle );
 extern void read_request( struct thread *thread );
+extern void read_shm_request( struct thread *thread );
 extern void write_reply( struct thread *thread );
 extern unsigned int get_tick_count(void);
 extern void open_master_socket(void);
@@ -60,6 +61,8 @@ extern void close_master_socket( timeout_t timeout );
 extern void shutdown_master_socket(void);
 extern int wait_for_lock(void);
 extern int kill_lock_owner( int sig );
+extern void init_workers(void);
+extern pid_t fork_server(void);
 extern int server_dir_fd, config_dir_fd;
 
 extern void trace_request(void);
@@ -119,6 +122,7 @@ DECL_HANDLER(new_thread);
 DECL_HANDLER(get_startup_info);
 DECL_HANDLER(init_process_done);
 DECL_HANDLER(init_thread);
+DECL_HANDLER(init_request_shm);
 DECL_HANDLER(terminate_process);
 DECL_HANDLER(terminate_thread);
 DECL_HANDLER(get_process_info);
@@ -135,6 +139,7 @@ DECL_HANDLER(unload_dll);
 DECL_HANDLER(queue_apc);
 DECL_HANDLER(get_apc_result);
 DECL_HANDLER(close_handle);
+DECL_HANDLER(batch);
 DECL_HANDLER(set_handle_info);
 DECL_HANDLER(dup_handle);
 DECL_HANDLER(open_process);
@@ -143,6 +148,7 @@ DECL_HANDLER(select);
 DECL_HANDLER(create_event);
 DECL_HANDLER(event_op);
 DECL_HANDLER(query_event);
+DECL_HANDLER(set_event_state);
 DECL_HANDLER(open_event);
 DECL_HANDLER(create_keyed_event);
 DECL_HANDLER(open_keyed_event);
@@ -150,9 +156,11 @@ DECL_HANDLER(create_mutex);
 DECL_HANDLER(release_mutex);
 DECL_HANDLER(open_mutex);
 DECL_HANDLER(query_mutex);
+DECL_HANDLER(set_mutex_state);
 DECL_HANDLER(create_semaphore);
 DECL_HANDLER(release_semaphore);
 DECL_HANDLER(query_semaphore);
+DECL_HANDLER(set_semaphore_state);
 DECL_HANDLER(open_semaphore);
 DECL_HANDLER(create_file);
 DECL_HANDLER(open_file_object);
@@ -387,6 +395,7 @@ DECL_HANDLER(create_completion);
 DECL_HANDLER(open_completion);
 DECL_HANDLER(add_completion);
 DECL_HANDLER(remove_completion);
+DECL_HANDLER(remove_completions);
 DECL_HANDLER(query_completion);
 DECL_HANDLER(set_completion_info);
 DECL_HANDLER(add_fd_completion);
@@ -423,6 +432,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_get_startup_info,
     (req_handler)req_init_process_done,
     (req_handler)req_init_thread,
+    (req_handler)req_init_request_shm,
     (req_handler)req_terminate_process,
     (req_handler)req_terminate_thread,
     (req_handler)req_get_process_info,
@@ -439,6 +449,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_queue_apc,
     (req_handler)req_get_apc_result,
     (req_handler)req_close_handle,
+    (req_handler)req_batch,
     (req_handler)req_set_handle_info,
     (req_handler)req_dup_handle,
     (req_handler)req_open_process,
@@ -447,6 +458,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_create_event,
     (req_handler)req_event_op,
     (req_handler)req_query_event,
+    (req_handler)req_set_event_state,
     (req_handler)req_open_event,
     (req_handler)req_create_keyed_event,
     (req_handler)req_open_keyed_event,
@@ -454,9 +466,11 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_release_mutex,
     (req_handler)req_open_mutex,
     (req_handler)req_query_mutex,
+    (req_handler)req_set_mutex_state,
     (req_handler)req_create_semaphore,
     (req_handler)req_release_semaphore,
     (req_handler)req_query_semaphore,
+    (req_handler)req_set_semaphore_state,
     (req_handler)req_open_semaphore,
     (req_handler)req_create_file,
     (req_handler)req_open_file_object,
@@ -691,6 +705,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_open_completion,
     (req_handler)req_add_completion,
     (req_handler)req_remove_completion,
+    (req_handler)req_remove_completions,
     (req_handler)req_query_completion,
     (req_handler)req_set_completion_info,
     (req_handler)req_add_fd_completion,
@@ -716,6 +731,622 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_resume_process,
 };
 
+static const unsigned char req_handle_offsets[REQ_NB_REQUESTS] =
+{
+    24, /* new_process */
+    16, /* exec_process */
+    12, /* get_new_process_info */
+    12, /* new_thread */
+    0,  /* get_startup_info */
+    0,  /* init_process_done */
+    0,  /* init_thread */
+    0,  /* init_request_shm */
+    12, /* terminate_process */
+    12, /* terminate_thread */
+    12, /* get_process_info */
+    12, /* get_process_vm_counters */
+    12, /* set_process_info */
+    12, /* get_thread_info */
+    12, /* get_thread_times */
+    12, /* set_thread_info */
+    12, /* get_dll_info */
+    12, /* suspend_thread */
+    12, /* resume_thread */
+    0,  /* load_dll */
+    0,  /* unload_dll */
+    12, /* queue_apc */
+    12, /* get_apc_result */
+    12, /* close_handle */
+    0,  /* batch */
+    12, /* set_handle_info */
+    12, /* dup_handle */
+    0,  /* open_process */
+    0,  /* open_thread */
+    32, /* select */
+    0,  /* create_event */
+    12, /* event_op */
+    12, /* query_event */
+    12, /* set_event_state */
+    20, /* open_event */
+    0,  /* create_keyed_event */
+    20, /* open_keyed_event */
+    0,  /* create_mutex */
+    12, /* release_mutex */
+    20, /* open_mutex */
+    12, /* query_mutex */
+    12, /* set_mutex_state */
+    0,  /* create_semaphore */
+    12, /* release_semaphore */
+    12, /* query_semaphore */
+    12, /* set_semaphore_state */
+    20, /* open_semaphore */
+    0,  /* create_file */
+    20, /* open_file_object */
+    0,  /* alloc_file_handle */
+    12, /* get_handle_unix_name */
+    12, /* get_handle_fd */
+    12, /* get_directory_cache_entry */
+    0,  /* flush */
+    12, /* get_file_info */
+    12, /* get_volume_info */
+    12, /* lock_file */
+    12, /* unlock_file */
+    0,  /* create_socket */
+    12, /* accept_socket */
+    12, /* accept_into_socket */
+    12, /* set_socket_event */
+    12, /* get_socket_event */
+    12, /* get_socket_info */
+    12, /* enable_socket_event */
+    12, /* set_socket_deferred */
+    0,  /* alloc_console */
+    0,  /* free_console */
+    12, /* get_console_renderer_events */
+    12, /* open_console */
+    0,  /* attach_console */
+    0,  /* get_console_wait_event */
+    12, /* get_console_mode */
+    12, /* set_console_mode */
+    12, /* set_console_input_info */
+    12, /* get_console_input_info */
+    12, /* append_console_input_history */
+    12, /* get_console_input_history */
+    12, /* create_console_output */
+    12, /* set_console_output_info */
+    12, /* get_console_output_info */
+    12, /* write_console_input */
+    12, /* read_console_input */
+    12, /* write_console_output */
+    12, /* fill_console_output */
+    12, /* read_console_output */
+    12, /* move_console_output */
+    0,  /* send_console_signal */
+    0,  /* read_directory_changes */
+    12, /* read_change */
+    32, /* create_mapping */
+    20, /* open_mapping */
+    12, /* get_mapping_info */
+    12, /* map_view */
+    0,  /* unmap_view */
+    0,  /* get_mapping_committed_range */
+    0,  /* add_mapping_committed_range */
+    0,  /* is_same_mapping */
+    0,  /* create_snapshot */
+    12, /* next_process */
+    12, /* next_thread */
+    0,  /* wait_debug_event */
+    0,  /* queue_exception_event */
+    12, /* get_exception_status */
+    0,  /* continue_debug_event */
+    0,  /* debug_process */
+    12, /* debug_break */
+    0,  /* set_debugger_kill_on_exit */
+    12, /* read_process_memory */
+    12, /* write_process_memory */
+    0,  /* create_key */
+    12, /* open_key */
+    12, /* delete_key */
+    12, /* flush_key */
+    12, /* enum_key */
+    12, /* set_key_value */
+    12, /* get_key_value */
+    12, /* enum_key_value */
+    12, /* delete_key_value */
+    12, /* load_registry */
+    12, /* unload_registry */
+    12, /* save_registry */
+    12, /* set_registry_notification */
+    0,  /* create_timer */
+    20, /* open_timer */
+    12, /* set_timer */
+    12, /* cancel_timer */
+    12, /* get_timer_info */
+    12, /* get_thread_context */
+    12, /* set_thread_context */
+    12, /* get_selector_entry */
+    12, /* add_atom */
+    12, /* delete_atom */
+    12, /* find_atom */
+    12, /* get_atom_information */
+    12, /* set_atom_information */
+    12, /* empty_atom_table */
+    0,  /* init_atom_table */
+    0,  /* get_msg_queue */
+    12, /* set_queue_fd */
+    0,  /* set_queue_mask */
+    0,  /* get_queue_status */
+    12, /* get_process_idle_event */
+    0,  /* send_message */
+    0,  /* post_quit_message */
+    0,  /* send_hardware_message */
+    0,  /* get_message */
+    0,  /* reply_message */
+    0,  /* accept_hardware_message */
+    0,  /* get_message_reply */
+    0,  /* set_win_timer */
+    0,  /* kill_win_timer */
+    0,  /* is_window_hung */
+    12, /* get_serial_info */
+    12, /* set_serial_info */
+    0,  /* register_async */
+    12, /* cancel_async */
+    0,  /* get_async_result */
+    0,  /* read */
+    0,  /* write */
+    0,  /* ioctl */
+    12, /* set_irp_result */
+    0,  /* create_named_pipe */
+    12, /* set_named_pipe_info */
+    0,  /* create_window */
+    0,  /* destroy_window */
+    0,  /* get_desktop_window */
+    0,  /* set_window_owner */
+    0,  /* get_window_info */
+    0,  /* set_window_info */
+    0,  /* set_parent */
+    0,  /* get_window_parents */
+    12, /* get_window_children */
+    0,  /* get_window_children_from_point */
+    0,  /* get_window_tree */
+    0,  /* set_window_pos */
+    0,  /* get_window_rectangles */
+    0,  /* get_window_text */
+    0,  /* set_window_text */
+    0,  /* get_windows_offset */
+    0,  /* get_visible_region */
+    0,  /* get_surface_region */
+    0,  /* get_window_region */
+    0,  /* set_window_region */
+    0,  /* get_update_region */
+    0,  /* update_window_zorder */
+    0,  /* redraw_window */
+    0,  /* set_window_property */
+    0,  /* remove_window_property */
+    0,  /* get_window_property */
+    0,  /* get_window_properties */
+    24, /* create_winstation */
+    20, /* open_winstation */
+    12, /* close_winstation */
+    0,  /* get_process_winstation */
+    12, /* set_process_winstation */
+    0,  /* enum_winstation */
+    0,  /* create_desktop */
+    12, /* open_desktop */
+    0,  /* open_input_desktop */
+    12, /* close_desktop */
+    0,  /* get_thread_desktop */
+    12, /* set_thread_desktop */
+    12, /* enum_desktop */
+    12, /* set_user_object_info */
+    0,  /* register_hotkey */
+    0,  /* unregister_hotkey */
+    0,  /* attach_thread_input */
+    0,  /* get_thread_input */
+    0,  /* get_last_input_time */
+    0,  /* get_key_state */
+    0,  /* set_key_state */
+    0,  /* set_foreground_window */
+    0,  /* set_focus_window */
+    0,  /* set_active_window */
+    0,  /* set_capture_window */
+    0,  /* set_caret_window */
+    0,  /* set_caret_info */
+    0,  /* set_hook */
+    0,  /* remove_hook */
+    0,  /* start_hook_chain */
+    0,  /* finish_hook_chain */
+    0,  /* get_hook_info */
+    0,  /* create_class */
+    0,  /* destroy_class */
+    0,  /* set_class_info */
+    0,  /* open_clipboard */
+    0,  /* close_clipboard */
+    0,  /* empty_clipboard */
+    0,  /* set_clipboard_data */
+    0,  /* get_clipboard_data */
+    0,  /* get_clipboard_formats */
+    0,  /* enum_clipboard_formats */
+    0,  /* release_clipboard */
+    0,  /* get_clipboard_info */
+    0,  /* set_clipboard_viewer */
+    0,  /* add_clipboard_listener */
+    0,  /* remove_clipboard_listener */
+    12, /* open_token */
+    0,  /* set_global_windows */
+    12, /* adjust_token_privileges */
+    12, /* get_token_privileges */
+    12, /* check_token_privileges */
+    12, /* duplicate_token */
+    12, /* access_check */
+    12, /* get_token_sid */
+    12, /* get_token_groups */
+    12, /* get_token_default_dacl */
+    12, /* set_token_default_dacl */
+    12, /* set_security_object */
+    12, /* get_security_object */
+    0,  /* get_system_handles */
+    0,  /* create_mailslot */
+    12, /* set_mailslot_info */
+    0,  /* create_directory */
+    20, /* open_directory */
+    12, /* get_directory_entry */
+    0,  /* create_symlink */
+    20, /* open_symlink */
+    12, /* query_symlink */
+    12, /* get_object_info */
+    12, /* get_object_type */
+    12, /* unlink_object */
+    12, /* get_token_impersonation_level */
+    0,  /* allocate_locally_unique_id */
+    0,  /* create_device_manager */
+    12, /* create_device */
+    12, /* delete_device */
+    12, /* get_next_device_request */
+    12, /* get_kernel_object_ptr */
+    12, /* set_kernel_object_ptr */
+    12, /* grab_kernel_object */
+    12, /* release_kernel_object */
+    12, /* get_kernel_object_handle */
+    0,  /* make_process_system */
+    12, /* get_token_statistics */
+    0,  /* create_completion */
+    20, /* open_completion */
+    12, /* add_completion */
+    12, /* remove_completion */
+    12, /* remove_completions */
+    12, /* query_completion */
+    12, /* set_completion_info */
+    12, /* add_fd_completion */
+    12, /* set_fd_completion_mode */
+    12, /* set_fd_disp_info */
+    12, /* set_fd_name_info */
+    0,  /* get_window_layered_info */
+    0,  /* set_window_layered_info */
+    0,  /* alloc_user_handle */
+    0,  /* free_user_handle */
+    0,  /* set_cursor */
+    0,  /* update_rawinput_devices */
+    0,  /* get_suspend_context */
+    0,  /* set_suspend_context */
+    0,  /* create_job */
+    20, /* open_job */
+    12, /* assign_job */
+    12, /* process_in_job */
+    12, /* set_job_limits */
+    12, /* set_job_completion_port */
+    12, /* terminate_job */
+    12, /* suspend_process */
+    12, /* resume_process */
+};
+
+static const unsigned char reply_handle_offsets[REQ_NB_REQUESTS] =
+{
+    8,  /* new_process */
+    0,  /* exec_process */
+    0,  /* get_new_process_info */
+    12, /* new_thread */
+    0,  /* get_startup_info */
+    0,  /* init_process_done */
+    0,  /* init_thread */
+    0,  /* init_request_shm */
+    0,  /* terminate_process */
+    0,  /* terminate_thread */
+    0,  /* get_process_info */
+    0,  /* get_process_vm_counters */
+    0,  /* set_process_info */
+    0,  /* get_thread_info */
+    0,  /* get_thread_times */
+    0,  /* set_thread_info */
+    0,  /* get_dll_info */
+    0,  /* suspend_thread */
+    0,  /* resume_thread */
+    0,  /* load_dll */
+    0,  /* unload_dll */
+    8,  /* queue_apc */
+    0,  /* get_apc_result */
+    0,  /* close_handle */
+    0,  /* batch */
+    0,  /* set_handle_info */
+    8,  /* dup_handle */
+    8,  /* open_process */
+    8,  /* open_thread */
+    56, /* select */
+    8,  /* create_event */
+    0,  /* event_op */
+    0,  /* query_event */
+    0,  /* set_event_state */
+    8,  /* open_event */
+    8,  /* create_keyed_event */
+    8,  /* open_keyed_event */
+    8,  /* create_mutex */
+    0,  /* release_mutex */
+    8,  /* open_mutex */
+    0,  /* query_mutex */
+    0,  /* set_mutex_state */
+    8,  /* create_semaphore */
+    0,  /* release_semaphore */
+    0,  /* query_semaphore */
+    0,  /* set_semaphore_state */
+    8,  /* open_semaphore */
+    8,  /* create_file */
+    8,  /* open_file_object */
+    8,  /* alloc_file_handle */
+    0,  /* get_handle_unix_name */
+    0,  /* get_handle_fd */
+    0,  /* get_directory_cache_entry */
+    8,  /* flush */
+    0,  /* get_file_info */
+    0,  /* get_volume_info */
+    8,  /* lock_file */
+    0,  /* unlock_file */
+    8,  /* create_socket */
+    8,  /* accept_socket */
+    0,  /* accept_into_socket */
+    0,  /* set_socket_event */
+    0,  /* get_socket_event */
+    0,  /* get_socket_info */
+    0,  /* enable_socket_event */
+    0,  /* set_socket_deferred */
+    8,  /* alloc_console */
+    0,  /* free_console */
+    0,  /* get_console_renderer_events */
+    8,  /* open_console */
+    8,  /* attach_console */
+    8,  /* get_console_wait_event */
+    0,  /* get_console_mode */
+    0,  /* set_console_mode */
+    0,  /* set_console_input_info */
+    0,  /* get_console_input_info */
+    0,  /* append_console_input_history */
+    0,  /* get_console_input_history */
+    8,  /* create_console_output */
+    0,  /* set_console_output_info */
+    0,  /* get_console_output_info */
+    0,  /* write_console_input */
+    0,  /* read_console_input */
+    0,  /* write_console_output */
+    0,  /* fill_console_output */
+    0,  /* read_console_output */
+    0,  /* move_console_output */
+    0,  /* send_console_signal */
+    0,  /* read_directory_changes */
+    0,  /* read_change */
+    8,  /* create_mapping */
+    8,  /* open_mapping */
+    20, /* get_mapping_info */
+    0,  /* map_view */
+    0,  /* unmap_view */
+    0,  /* get_mapping_committed_range */
+    0,  /* add_mapping_committed_range */
+    0,  /* is_same_mapping */
+    8,  /* create_snapshot */
+    0,  /* next_process */
+    0,  /* next_thread */
+    16, /* wait_debug_event */
+    8,  /* queue_exception_event */
+    0,  /* get_exception_status */
+    0,  /* continue_debug_event */
+    0,  /* debug_process */
+    0,  /* debug_break */
+    0,  /* set_debugger_kill_on_exit */
+    0,  /* read_process_memory */
+    0,  /* write_process_memory */
+    8,  /* create_key */
+    8,  /* open_key */
+    0,  /* delete_key */
+    0,  /* flush_key */
+    0,  /* enum_key */
+    0,  /* set_key_value */
+    0,  /* get_key_value */
+    0,  /* enum_key_value */
+    0,  /* delete_key_value */
+    0,  /* load_registry */
+    0,  /* unload_registry */
+    0,  /* save_registry */
+    0,  /* set_registry_notification */
+    8,  /* create_timer */
+    8,  /* open_timer */
+    0,  /* set_timer */
+    0,  /* cancel_timer */
+    0,  /* get_timer_info */
+    0,  /* get_thread_context */
+    0,  /* set_thread_context */
+    0,  /* get_selector_entry */
+    0,  /* add_atom */
+    0,  /* delete_atom */
+    0,  /* find_atom */
+    0,  /* get_atom_information */
+    0,  /* set_atom_information */
+    0,  /* empty_atom_table */
+    8,  /* init_atom_table */
+    8,  /* get_msg_queue */
+    0,  /* set_queue_fd */
+    0,  /* set_queue_mask */
+    0,  /* get_queue_status */
+    8,  /* get_process_idle_event */
+    0,  /* send_message */
+    0,  /* post_quit_message */
+    0,  /* send_hardware_message */
+    0,  /* get_message */
+    0,  /* reply_message */
+    0,  /* accept_hardware_message */
+    0,  /* get_message_reply */
+    0,  /* set_win_timer */
+    0,  /* kill_win_timer */
+    0,  /* is_window_hung */
+    0,  /* get_serial_info */
+    0,  /* set_serial_info */
+    0,  /* register_async */
+    0,  /* cancel_async */
+    0,  /* get_async_result */
+    8,  /* read */
+    8,  /* write */
+    8,  /* ioctl */
+    0,  /* set_irp_result */
+    8,  /* create_named_pipe */
+    0,  /* set_named_pipe_info */
+    0,  /* create_window */
+    0,  /* destroy_window */
+    0,  /* get_desktop_window */
+    0,  /* set_window_owner */
+    0,  /* get_window_info */
+    0,  /* set_window_info */
+    0,  /* set_parent */
+    0,  /* get_window_parents */
+    0,  /* get_window_children */
+    0,  /* get_window_children_from_point */
+    0,  /* get_window_tree */
+    0,  /* set_window_pos */
+    0,  /* get_window_rectangles */
+    0,  /* get_window_text */
+    0,  /* set_window_text */
+    0,  /* get_windows_offset */
+    0,  /* get_visible_region */
+    0,  /* get_surface_region */
+    0,  /* get_window_region */
+    0,  /* set_window_region */
+    0,  /* get_update_region */
+    0,  /* update_window_zorder */
+    0,  /* redraw_window */
+    0,  /* set_window_property */
+    0,  /* remove_window_property */
+    0,  /* get_window_property */
+    0,  /* get_window_properties */
+    8,  /* create_winstation */
+    8,  /* open_winstation */
+    0,  /* close_winstation */
+    8,  /* get_process_winstation */
+    0,  /* set_process_winstation */
+    0,  /* enum_winstation */
+    8,  /* create_desktop */
+    8,  /* open_desktop */
+    8,  /* open_input_desktop */
+    0,  /* close_desktop */
+    8,  /* get_thread_desktop */
+    0,  /* set_thread_desktop */
+    0,  /* enum_desktop */
+    0,  /* set_user_object_info */
+    0,  /* register_hotkey */
+    0,  /* unregister_hotkey */
+    0,  /* attach_thread_input */
+    0,  /* get_thread_input */
+    0,  /* get_last_input_time */
+    0,  /* get_key_state */
+    0,  /* set_key_state */
+    0,  /* set_foreground_window */
+    0,  /* set_focus_window */
+    0,  /* set_active_window */
+    0,  /* set_capture_window */
+    0,  /* set_caret_window */
+    0,  /* set_caret_info */
+    0,  /* set_hook */
+    0,  /* remove_hook */
+    0,  /* start_hook_chain */
+    0,  /* finish_hook_chain */
+    0,  /* get_hook_info */
+    0,  /* create_class */
+    0,  /* destroy_class */
+    0,  /* set_class_info */
+    0,  /* open_clipboard */
+    0,  /* close_clipboard */
+    0,  /* empty_clipboard */
+    0,  /* set_clipboard_data */
+    0,  /* get_clipboard_data */
+    0,  /* get_clipboard_formats */
+    0,  /* enum_clipboard_formats */
+    0,  /* release_clipboard */
+    0,  /* get_clipboard_info */
+    0,  /* set_clipboard_viewer */
+    0,  /* add_clipboard_listener */
+    0,  /* remove_clipboard_listener */
+    8,  /* open_token */
+    0,  /* set_global_windows */
+    0,  /* adjust_token_privileges */
+    0,  /* get_token_privileges */
+    0,  /* check_token_privileges */
+    8,  /* duplicate_token */
+    0,  /* access_check */
+    0,  /* get_token_sid */
+    0,  /* get_token_groups */
+    0,  /* get_token_default_dacl */
+    0,  /* set_token_default_dacl */
+    0,  /* set_security_object */
+    0,  /* get_security_object */
+    0,  /* get_system_handles */
+    8,  /* create_mailslot */
+    0,  /* set_mailslot_info */
+    8,  /* create_directory */
+    8,  /* open_directory */
+    0,  /* get_directory_entry */
+    8,  /* create_symlink */
+    8,  /* open_symlink */
+    0,  /* query_symlink */
+    0,  /* get_object_info */
+    0,  /* get_object_type */
+    0,  /* unlink_object */
+    0,  /* get_token_impersonation_level */
+    0,  /* allocate_locally_unique_id */
+    8,  /* create_device_manager */
+    0,  /* create_device */
+    0,  /* delete_device */
+    40, /* get_next_device_request */
+    0,  /* get_kernel_object_ptr */
+    0,  /* set_kernel_object_ptr */
+    0,  /* grab_kernel_object */
+    0,  /* release_kernel_object */
+    8,  /* get_kernel_object_handle */
+    8,  /* make_process_system */
+    0,  /* get_token_statistics */
+    8,  /* create_completion */
+    8,  /* open_completion */
+    0,  /* add_completion */
+    0,  /* remove_completion */
+    0,  /* remove_completions */
+    0,  /* query_completion */
+    0,  /* set_completion_info */
+    0,  /* add_fd_completion */
+    0,  /* set_fd_completion_mode */
+    0,  /* set_fd_disp_info */
+    0,  /* set_fd_name_info */
+    0,  /* get_window_layered_info */
+    0,  /* set_window_layered_info */
+    0,  /* alloc_user_handle */
+    0,  /* free_user_handle */
+    0,  /* set_cursor */
+    0,  /* update_rawinput_devices */
+    0,  /* get_suspend_context */
+    0,  /* set_suspend_context */
+    8,  /* create_job */
+    8,  /* open_job */
+    0,  /* assign_job */
+    0,  /* process_in_job */
+    0,  /* set_job_limits */
+    0,  /* set_job_completion_port */
+    0,  /* terminate_job */
+    0,  /* suspend_process */
+    0,  /* resume_process */
+};
+
 C_ASSERT( sizeof(affinity_t) == 8 );
 C_ASSERT( sizeof(apc_call_t) == 40 );
 C_ASSERT( sizeof(apc_param_t) == 8 );
@@ -802,6 +1433,10 @@ C_ASSERT( FIELD_OFFSET(struct init_thread_reply, version) == 28 );
 C_ASSERT( FIELD_OFFSET(struct init_thread_reply, all_cpus) == 32 );
 C_ASSERT( FIELD_OFFSET(struct init_thread_reply, suspend) == 36 );
 C_ASSERT( sizeof(struct init_thread_reply) == 40 );
+C_ASSERT( FIELD_OFFSET(struct init_request_shm_request, shm_fd) == 12 );
+C_ASSERT( FIELD_OFFSET(struct init_request_shm_request, doorbell_fd) == 16 );
+C_ASSERT( FIELD_OFFSET(struct init_request_shm_request, size) == 20 );
+C_ASSERT( sizeof(struct init_request_shm_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct terminate_process_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct terminate_process_request, exit_code) == 16 );
 C_ASSERT( sizeof(struct terminate_process_request) == 24 );
@@ -898,6 +1533,9 @@ C_ASSERT( FIELD_OFFSET(struct get_apc_result_reply, result) == 8 );
 C_ASSERT( sizeof(struct get_apc_result_reply) == 48 );
 C_ASSERT( FIELD_OFFSET(struct close_handle_request, handle) == 12 );
 C_ASSERT( sizeof(struct close_handle_request) == 16 );
+C_ASSERT( sizeof(struct batch_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct batch_reply, done) == 8 );
+C_ASSERT( sizeof(struct batch_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_handle_info_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct set_handle_info_request, flags) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_handle_info_request, mask) == 20 );
@@ -939,7 +1577,8 @@ C_ASSERT( sizeof(struct select_reply) == 64 );
 C_ASSERT( FIELD_OFFSET(struct create_event_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct create_event_request, manual_reset) == 16 );
 C_ASSERT( FIELD_OFFSET(struct create_event_request, initial_state) == 20 );
-C_ASSERT( sizeof(struct create_event_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct create_event_request, client_state) == 24 );
+C_ASSERT( sizeof(struct create_event_request) == 32 );
 C_ASSERT( FIELD_OFFSET(struct create_event_reply, handle) == 8 );
 C_ASSERT( sizeof(struct create_event_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct event_op_request, handle) == 12 );
@@ -952,6 +1591,9 @@ C_ASSERT( sizeof(struct query_event_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct query_event_reply, manual_reset) == 8 );
 C_ASSERT( FIELD_OFFSET(struct query_event_reply, state) == 12 );
 C_ASSERT( sizeof(struct query_event_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct set_event_state_request, handle) == 12 );
+C_ASSERT( FIELD_OFFSET(struct set_event_state_request, state) == 16 );
+C_ASSERT( sizeof(struct set_event_state_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct open_event_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct open_event_request, attributes) == 16 );
 C_ASSERT( FIELD_OFFSET(struct open_event_request, rootdir) == 20 );
@@ -970,6 +1612,7 @@ C_ASSERT( FIELD_OFFSET(struct open_keyed_event_reply, handle) == 8 );
 C_ASSERT( sizeof(struct open_keyed_event_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct create_mutex_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct create_mutex_request, owned) == 16 );
+C_ASSERT( FIELD_OFFSET(struct create_mutex_request, client_state) == 20 );
 C_ASSERT( sizeof(struct create_mutex_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct create_mutex_reply, handle) == 8 );
 C_ASSERT( sizeof(struct create_mutex_reply) == 16 );
@@ -989,10 +1632,16 @@ C_ASSERT( FIELD_OFFSET(struct query_mutex_reply, count) == 8 );
 C_ASSERT( FIELD_OFFSET(struct query_mutex_reply, owned) == 12 );
 C_ASSERT( FIELD_OFFSET(struct query_mutex_reply, abandoned) == 16 );
 C_ASSERT( sizeof(struct query_mutex_reply) == 24 );
+C_ASSERT( FIELD_OFFSET(struct set_mutex_state_request, handle) == 12 );
+C_ASSERT( FIELD_OFFSET(struct set_mutex_state_request, owner) == 16 );
+C_ASSERT( FIELD_OFFSET(struct set_mutex_state_request, count) == 20 );
+C_ASSERT( FIELD_OFFSET(struct set_mutex_state_request, abandoned) == 24 );
+C_ASSERT( sizeof(struct set_mutex_state_request) == 32 );
 C_ASSERT( FIELD_OFFSET(struct create_semaphore_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct create_semaphore_request, initial) == 16 );
 C_ASSERT( FIELD_OFFSET(struct create_semaphore_request, max) == 20 );
-C_ASSERT( sizeof(struct create_semaphore_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct create_semaphore_request, client_state) == 24 );
+C_ASSERT( sizeof(struct create_semaphore_request) == 32 );
 C_ASSERT( FIELD_OFFSET(struct create_semaphore_reply, handle) == 8 );
 C_ASSERT( sizeof(struct create_semaphore_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct release_semaphore_request, handle) == 12 );
@@ -1005,6 +1654,9 @@ C_ASSERT( sizeof(struct query_semaphore_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct query_semaphore_reply, current) == 8 );
 C_ASSERT( FIELD_OFFSET(struct query_semaphore_reply, max) == 12 );
 C_ASSERT( sizeof(struct query_semaphore_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct set_semaphore_state_request, handle) == 12 );
+C_ASSERT( FIELD_OFFSET(struct set_semaphore_state_request, count) == 16 );
+C_ASSERT( sizeof(struct set_semaphore_state_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct open_semaphore_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct open_semaphore_request, attributes) == 16 );
 C_ASSERT( FIELD_OFFSET(struct open_semaphore_request, rootdir) == 20 );
@@ -2352,6 +3004,9 @@ C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, cvalue) == 16 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, information) == 24 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, status) == 32 );
 C_ASSERT( sizeof(struct remove_completion_reply) == 40 );
+C_ASSERT( FIELD_OFFSET(struct remove_completions_request, handle) == 12 );
+C_ASSERT( sizeof(struct remove_completions_request) == 16 );
+C_ASSERT( sizeof(struct remove_completions_reply) == 8 );
 C_ASSERT( FIELD_OFFSET(struct query_completion_request, handle) == 12 );
 C_ASSERT( sizeof(struct query_completion_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct query_completion_reply, depth) == 8 );
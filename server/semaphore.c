@@ -188,6 +188,7 @@ DECL_HANDLER(create_semaphore)
         else
             reply->handle = alloc_handle_no_access_check( current->process, sem,
                                                           req->access, objattr->attributes );
+        if (reply->handle && req->client_state) set_handle_client_state( current->process, reply->handle );
         release_object( sem );
     }
 
@@ -229,3 +230,18 @@ DECL_HANDLER(query_semaphore)
         release_object( sem );
     }
 }
+
+/* set the count of a semaphore tracked by the client until now */
+DECL_HANDLER(set_semaphore_state)
+{
+    struct semaphore *sem;
+
+    /* the state comes from the process ntdll itself, so no access rights are needed */
+    if ((sem = (struct semaphore *)get_handle_obj( current->process, req->handle, 0, &semaphore_ops )))
+    {
+        if (req->count > sem->max) set_error( STATUS_SEMAPHORE_LIMIT_EXCEEDED );
+        else if (sem->count) set_error( STATUS_INVALID_PARAMETER );
+        else if (req->count) release_semaphore( sem, req->count, NULL );
+        release_object( sem );
+    }
+}
@@ -772,7 +772,7 @@ static struct sock *accept_socket( obj_handle_t handle )
 static int accept_into_socket( struct sock *sock, struct sock *acceptsock )
 {
     int acceptfd;
-    struct fd *newfd;
+    struct fd *newfd, *oldfd;
     if ( sock->deferred )
     {
         newfd = dup_fd_object( sock->deferred->fd, 0, 0,
@@ -806,8 +806,11 @@ static int accept_into_socket( struct sock *sock, struct sock *acceptsock )
     acceptsock->deferred = NULL;
     acceptsock->connect_time = current_time;
     fd_copy_completion( acceptsock->fd, newfd );
-    release_object( acceptsock->fd );
+    oldfd = acceptsock->fd;
+    server_write_lock( FD_LOCK );
     acceptsock->fd = newfd;
+    server_write_unlock( FD_LOCK );
+    release_object( oldfd );
 
     clear_error();
     sock->pmask &= ~FD_ACCEPT;
@@ -30,6 +30,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
 #include <unistd.h>
 #include <time.h>
 #ifdef HAVE_POLL_H
@@ -197,12 +201,20 @@ static inline void init_thread_structure( struct thread *thread )
     thread->request_fd      = NULL;
     thread->reply_fd        = NULL;
     thread->wait_fd         = NULL;
+    thread->doorbell_fd     = NULL;
+    thread->request_shm     = NULL;
+    thread->request_shm_size = 0;
+    thread->request_shm_seq = 0;
+    thread->reply_to_shm    = 0;
+    thread->in_worker       = 0;
+    thread->worker_deferred = 0;
     thread->state           = RUNNING;
     thread->exit_code       = 0;
     thread->priority        = 0;
     thread->suspend         = 0;
     thread->desktop_users   = 0;
     thread->token           = NULL;
+    thread->reg_cursor.tree = NULL;
 
     thread->creation_time = current_time;
     thread->exit_time     = 0;
@@ -301,6 +313,7 @@ static void thread_poll_event( struct fd *fd, int event )
 
     grab_object( thread );
     if (event & (POLLERR | POLLHUP)) kill_thread( thread, 0 );
+    else if (fd == thread->doorbell_fd) read_shm_request( thread );
     else if (event & POLLIN) read_request( thread );
     else if (event & POLLOUT) write_reply( thread );
     release_object( thread );
@@ -314,17 +327,31 @@ static struct list *thread_get_kernel_obj_list( struct object *obj )
 
 /* cleanup everything that is no longer needed by a dead thread */
 /* used by destroy_thread and kill_thread */
+/* free the buffers used to receive a request and send its reply */
+void cleanup_thread_request( struct thread *thread )
+{
+    free( thread->req_data );
+    free( thread->reply_data );
+    if (thread->reply_fd) release_object( thread->reply_fd );
+    if (thread->request_shm)
+        munmap( thread->request_shm, thread->request_shm_size + offsetof( struct request_shm, data ));
+    thread->req_data = NULL;
+    thread->reply_data = NULL;
+    thread->reply_fd = NULL;
+    thread->request_shm = NULL;
+}
+
 static void cleanup_thread( struct thread *thread )
 {
     int i;
 
     clear_apc_queue( &thread->system_apc );
     clear_apc_queue( &thread->user_apc );
-    free( thread->req_data );
-    free( thread->reply_data );
+    /* a request worker may still be replying, it will be cleaned up once it's done */
+    if (!thread->in_worker) cleanup_thread_request( thread );
     if (thread->request_fd) release_object( thread->request_fd );
-    if (thread->reply_fd) release_object( thread->reply_fd );
     if (thread->wait_fd) release_object( thread->wait_fd );
+    if (thread->doorbell_fd) release_object( thread->doorbell_fd );
     free( thread->suspend_context );
     cleanup_clipboard_thread(thread);
     destroy_thread_windows( thread );
@@ -338,11 +365,9 @@ static void cleanup_thread( struct thread *thread )
             thread->inflight[i].client = thread->inflight[i].server = -1;
         }
     }
-    thread->req_data = NULL;
-    thread->reply_data = NULL;
     thread->request_fd = NULL;
-    thread->reply_fd = NULL;
     thread->wait_fd = NULL;
+    thread->doorbell_fd = NULL;
     thread->context = NULL;
     thread->suspend_context = NULL;
     thread->desktop = 0;
@@ -1419,6 +1444,92 @@ DECL_HANDLER(init_thread)
     if (wait_fd != -1) close( wait_fd );
 }
 
+#ifdef HAVE_SYS_MMAN_H
+
+#if defined(__linux__) && !defined(F_GET_SEALS)
+#define F_GET_SEALS   1034
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW   0x0004
+#endif
+
+/* check that the client can't resize the request shared memory once we have mapped it */
+static int check_request_shm_fd( int fd, data_size_t size )
+{
+#ifdef F_GET_SEALS
+    struct stat st;
+    int seals;
+
+    if ((seals = fcntl( fd, F_GET_SEALS )) == -1 ||
+        (seals & (F_SEAL_SHRINK | F_SEAL_GROW)) != (F_SEAL_SHRINK | F_SEAL_GROW) ||
+        fstat( fd, &st ) == -1 || st.st_size != size)
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        return 0;
+    }
+    return 1;
+#else
+    set_error( STATUS_NOT_SUPPORTED );
+    return 0;
+#endif
+}
+
+#endif  /* HAVE_SYS_MMAN_H */
+
+/* set up a shared memory area to pass the thread requests */
+DECL_HANDLER(init_request_shm)
+{
+#ifdef HAVE_SYS_MMAN_H
+    struct request_shm *shm;
+    int shm_fd, doorbell_fd;
+
+    if ((shm_fd = thread_get_inflight_fd( current, req->shm_fd )) == -1)
+    {
+        set_error( STATUS_TOO_MANY_OPENED_FILES );
+        return;
+    }
+    if ((doorbell_fd = thread_get_inflight_fd( current, req->doorbell_fd )) == -1)
+    {
+        set_error( STATUS_TOO_MANY_OPENED_FILES );
+        close( shm_fd );
+        return;
+    }
+    if (current->request_shm || req->size <= offsetof( struct request_shm, data ) || req->size > 0x100000)
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        goto error;
+    }
+    if (!check_request_shm_fd( shm_fd, req->size )) goto error;
+    if (fcntl( doorbell_fd, F_SETFL, O_NONBLOCK ) == -1)
+    {
+        file_set_error();
+        goto error;
+    }
+    if ((shm = mmap( NULL, req->size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0 )) == MAP_FAILED)
+    {
+        file_set_error();
+        goto error;
+    }
+    close( shm_fd );
+
+    if (!(current->doorbell_fd = create_anonymous_fd( &thread_fd_ops, doorbell_fd, &current->obj, 0 )))
+    {
+        munmap( shm, req->size );
+        return;
+    }
+    current->request_shm      = shm;
+    current->request_shm_size = req->size - offsetof( struct request_shm, data );
+    current->request_shm_seq  = shm->seq;
+    set_fd_events( current->doorbell_fd, POLLIN );
+    return;
+
+ error:
+    close( shm_fd );
+    close( doorbell_fd );
+#else
+    set_error( STATUS_NOT_SUPPORTED );
+#endif
+}
+
 /* terminate a thread */
 DECL_HANDLER(terminate_thread)
 {
@@ -46,6 +46,15 @@ struct inflight_fd
 };
 #define MAX_INFLIGHT_FDS 16  /* max number of fds in flight per thread */
 
+/* position of the last registry enumeration of a thread */
+struct registry_cursor
+{
+    const void            *tree;          /* subkeys or values tree that was enumerated */
+    struct name_node      *node;          /* entry returned by the enumeration */
+    unsigned int           index;         /* position of that entry */
+    unsigned int           serial;        /* registry serial when it was returned */
+};
+
 struct thread
 {
     struct object          obj;           /* object header */
@@ -73,6 +82,13 @@ struct thread
     struct fd             *request_fd;    /* fd for receiving client requests */
     struct fd             *reply_fd;      /* fd to send a reply to a client */
     struct fd             *wait_fd;       /* fd to use to wake a sleeping client */
+    struct fd             *doorbell_fd;   /* fd signaled when a request is ready in request_shm */
+    struct request_shm    *request_shm;   /* shared memory for requests, if any */
+    data_size_t            request_shm_size; /* size of request_shm data area */
+    unsigned int           request_shm_seq;  /* sequence number of the last request read from request_shm */
+    int                    reply_to_shm;  /* is the current request from request_shm? */
+    int                    in_worker;     /* is the current request handled by a worker thread? */
+    int                    worker_deferred; /* did the next request arrive while in_worker was set? */
     enum run_state         state;         /* running state */
     int                    exit_code;     /* thread exit code */
     int                    unix_pid;      /* Unix pid of client */
@@ -90,6 +106,7 @@ struct thread
     timeout_t              exit_time;     /* Thread exit time */
     struct token          *token;         /* security token associated with this thread */
     struct list            kernel_object; /* list of kernel object pointers */
+    struct registry_cursor reg_cursor;    /* position of the last registry enumeration */
 };
 
 struct thread_snapshot
@@ -99,7 +116,7 @@ struct thread_snapshot
     int             priority;  /* priority class */
 };
 
-extern struct thread *current;
+extern SERVER_THREAD_LOCAL struct thread *current;
 
 /* thread functions */
 
@@ -120,6 +137,7 @@ extern int wake_thread_queue_entry( struct wait_queue_entry *entry );
 extern int add_queue( struct object *obj, struct wait_queue_entry *entry );
 extern void remove_queue( struct object *obj, struct wait_queue_entry *entry );
 extern void kill_thread( struct thread *thread, int violent_death );
+extern void cleanup_thread_request( struct thread *thread );
 extern void break_thread( struct thread *thread );
 extern void wake_up( struct object *obj, int max );
 extern int thread_queue_apc( struct process *process, struct thread *thread, struct object *owner, const apc_call_t *call_data );
@@ -144,7 +162,7 @@ extern int send_thread_signal( struct thread *thread, int sig );
 extern void get_selector_entry( struct thread *thread, int entry, unsigned int *base,
                                 unsigned int *limit, unsigned char *flags );
 
-extern unsigned int global_error;  /* global error code for when no thread is current */
+extern SERVER_THREAD_LOCAL unsigned int global_error;  /* global error code for when no thread is current */
 
 static inline unsigned int get_error(void)       { return current ? current->error : global_error; }
 static inline void set_error( unsigned int err ) { global_error = err; if (current) current->error = err; }
@@ -202,25 +202,18 @@ static SID *security_sid_alloc( const SID_IDENTIFIER_AUTHORITY *idauthority, int
 
 void security_set_thread_token( struct thread *thread, obj_handle_t handle )
 {
-    if (!handle)
-    {
-        if (thread->token)
-            release_object( thread->token );
-        thread->token = NULL;
-    }
-    else
-    {
-        struct token *token = (struct token *)get_handle_obj( current->process,
-                                                              handle,
-                                                              TOKEN_IMPERSONATE,
-                                                              &token_ops );
-        if (token)
-        {
-            if (thread->token)
-                release_object( thread->token );
-            thread->token = token;
-        }
-    }
+    struct token *token = NULL, *old_token;
+
+    if (handle && !(token = (struct token *)get_handle_obj( current->process, handle,
+                                                            TOKEN_IMPERSONATE, &token_ops )))
+        return;
+
+    /* the token is looked up by the impersonation token pseudo-handle */
+    server_write_lock( HANDLE_LOCK );
+    old_token = thread->token;
+    thread->token = token;
+    server_write_unlock( HANDLE_LOCK );
+    if (old_token) release_object( old_token );
 }
 
 const SID *security_unix_uid_to_sid( uid_t uid )